@@ -0,0 +1,141 @@
+#include "benchmark.hpp"
+#include "throughput_benchmark.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace spe;
+
+namespace
+{
+    void print_usage(const char *program)
+    {
+        std::printf("Usage: %s [options]\n"
+                    "  --filter=TEXT        only micro-benchmarks whose name contains TEXT\n"
+                    "  --min-time=SECONDS   minimum run time per micro-benchmark (default 0.5)\n"
+                    "  --micro-only         skip the throughput benchmark\n"
+                    "  --macro-only         skip the micro-benchmarks\n"
+                    "  --universe=N         throughput universe size in instruments (default 64)\n"
+                    "  --pairs=N            stat-arb pairs (default: the universe size)\n"
+                    "  --quotes-per-tick=N  instruments requoted per tick (default 4)\n"
+                    "  --tick-rate=HZ       ticks per second, 0 for unthrottled (default 0)\n"
+                    "  --duration=SECONDS   throughput run length (default 5)\n"
+                    "  --threads=N          pool threads for the composite detector (default 0)\n"
+                    "  --seed=N             feed seed (default 42)\n"
+                    "  --event-driven       feed quotes through on_quote instead of snapshots\n"
+                    "  --topology=SPEC      stage placement, e.g. \"detector cpus=2 wait=busy; detector.shards node=0\"\n",
+                    program);
+    }
+
+    // Matches "--name=value" and points value at the text after '='
+    bool option(const std::string &arg, const char *name, std::string &value)
+    {
+        std::string prefix = std::string("--") + name + "=";
+        if (arg.compare(0, prefix.size(), prefix) != 0)
+        {
+            return false;
+        }
+        value = arg.substr(prefix.size());
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string filter;
+    double min_time = 0.5;
+    bool run_micro = true;
+    bool run_macro = true;
+    bool pairs_given = false;
+    bench::ThroughputConfig config;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        std::string value;
+        if (arg == "--help" || arg == "-h")
+        {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (arg == "--micro-only")
+        {
+            run_macro = false;
+        }
+        else if (arg == "--macro-only")
+        {
+            run_micro = false;
+        }
+        else if (arg == "--event-driven")
+        {
+            config.event_driven = true;
+        }
+        else if (option(arg, "filter", value))
+        {
+            filter = value;
+        }
+        else if (option(arg, "min-time", value))
+        {
+            min_time = std::strtod(value.c_str(), nullptr);
+        }
+        else if (option(arg, "universe", value))
+        {
+            config.universe_size = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (option(arg, "pairs", value))
+        {
+            config.stat_arb_pairs = std::strtoull(value.c_str(), nullptr, 10);
+            pairs_given = true;
+        }
+        else if (option(arg, "quotes-per-tick", value))
+        {
+            config.quotes_per_tick = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (option(arg, "tick-rate", value))
+        {
+            config.tick_rate = std::strtod(value.c_str(), nullptr);
+        }
+        else if (option(arg, "duration", value))
+        {
+            config.duration_seconds = std::strtod(value.c_str(), nullptr);
+        }
+        else if (option(arg, "threads", value))
+        {
+            config.threads = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (option(arg, "seed", value))
+        {
+            config.seed = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (option(arg, "topology", value))
+        {
+            std::string error;
+            if (!concurrency::ThreadTopology::parse(value, config.topology, error) ||
+                !config.topology.validate(concurrency::CpuTopology::system(), error))
+            {
+                std::fprintf(stderr, "Bad --topology: %s\n", error.c_str());
+                return 1;
+            }
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!pairs_given)
+    {
+        config.stat_arb_pairs = config.universe_size;
+    }
+
+    if (run_micro)
+    {
+        bench::run_benchmarks(filter, std::chrono::duration<double>(min_time));
+    }
+    if (run_macro)
+    {
+        bench::run_throughput_benchmark(config);
+    }
+    return 0;
+}
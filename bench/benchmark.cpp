@@ -0,0 +1,82 @@
+#include "benchmark.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace spe
+{
+    namespace bench
+    {
+
+        namespace
+        {
+            constexpr uint64_t MAX_ITERATIONS = 1000000000;
+
+            BenchmarkResult run_one(const std::string &name, BenchmarkFunction function, int64_t arg,
+                                    std::chrono::duration<double> min_time)
+            {
+                // Grow the count from a single iteration until a run is long enough; the last run
+                // is the measurement, as its setup cost is amortized over the most iterations
+                uint64_t iterations = 1;
+                while (true)
+                {
+                    State state(iterations, arg);
+                    function(state);
+                    double seconds = std::chrono::duration<double>(state.elapsed()).count();
+
+                    if (seconds >= min_time.count() || iterations >= MAX_ITERATIONS)
+                    {
+                        return BenchmarkResult{name, iterations, seconds * 1e9 / static_cast<double>(iterations)};
+                    }
+
+                    // Aim 40% past the target so the next run usually is the last one
+                    double scale = seconds > 0.0 ? min_time.count() * 1.4 / seconds : 10.0;
+                    scale = std::min(std::max(scale, 2.0), 10.0);
+                    iterations = std::min(static_cast<uint64_t>(static_cast<double>(iterations) * scale), MAX_ITERATIONS);
+                }
+            }
+        }
+
+        std::vector<BenchmarkDefinition> &benchmark_registry()
+        {
+            static std::vector<BenchmarkDefinition> registry;
+            return registry;
+        }
+
+        std::vector<BenchmarkResult> run_benchmarks(const std::string &filter, std::chrono::duration<double> min_time)
+        {
+            std::vector<BenchmarkResult> results;
+            std::printf("%-48s %14s %14s\n", "Benchmark", "Iterations", "ns/iter");
+            std::printf("%s\n", std::string(78, '-').c_str());
+
+            for (const auto &definition : benchmark_registry())
+            {
+                std::vector<int64_t> args = definition.args;
+                if (args.empty())
+                {
+                    args.push_back(0);
+                }
+
+                for (int64_t arg : args)
+                {
+                    std::string name = definition.name;
+                    if (!definition.args.empty())
+                    {
+                        name += "/" + std::to_string(arg);
+                    }
+                    if (!filter.empty() && name.find(filter) == std::string::npos)
+                    {
+                        continue;
+                    }
+
+                    BenchmarkResult result = run_one(name, definition.function, arg, min_time);
+                    std::printf("%-48s %14llu %14.1f\n", result.name.c_str(),
+                                static_cast<unsigned long long>(result.iterations), result.nanoseconds_per_iteration);
+                    std::fflush(stdout);
+                    results.push_back(result);
+                }
+            }
+            return results;
+        }
+
+    } // namespace bench
+} // namespace spe
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace spe
+{
+    namespace bench
+    {
+
+        using BenchClock = std::chrono::steady_clock;
+
+        // Timing state handed to a benchmark body. The body does its setup, then runs the
+        // measured operation once per keep_running() == true; the runner picks the iteration
+        // count so that a run takes at least the configured minimum time.
+        class State
+        {
+        private:
+            uint64_t iterations_;
+            uint64_t remaining_;
+            int64_t arg_;
+            bool started_;
+            BenchClock::time_point start_;
+            BenchClock::time_point pause_start_;
+            BenchClock::duration paused_;
+            BenchClock::duration elapsed_;
+
+        public:
+            State(uint64_t iterations, int64_t arg)
+                : iterations_(iterations), remaining_(iterations), arg_(arg), started_(false),
+                  paused_(BenchClock::duration::zero()), elapsed_(BenchClock::duration::zero()) {}
+
+            bool keep_running()
+            {
+                if (!started_)
+                {
+                    started_ = true;
+                    start_ = BenchClock::now();
+                }
+                if (remaining_ == 0)
+                {
+                    elapsed_ = BenchClock::now() - start_ - paused_;
+                    return false;
+                }
+                --remaining_;
+                return true;
+            }
+
+            // Excludes housekeeping inside the loop (e.g. draining a store) from the timing
+            void pause_timing() { pause_start_ = BenchClock::now(); }
+            void resume_timing() { paused_ += BenchClock::now() - pause_start_; }
+
+            uint64_t iterations() const { return iterations_; }
+            int64_t arg() const { return arg_; }
+            BenchClock::duration elapsed() const { return elapsed_; }
+        };
+
+        using BenchmarkFunction = void (*)(State &);
+
+        struct BenchmarkDefinition
+        {
+            std::string name;
+            BenchmarkFunction function;
+            std::vector<int64_t> args; // one run per argument; empty runs once with arg 0
+        };
+
+        struct BenchmarkResult
+        {
+            std::string name; // "function/arg" for parameterized runs
+            uint64_t iterations;
+            double nanoseconds_per_iteration;
+        };
+
+        // Static registrations, in definition order
+        std::vector<BenchmarkDefinition> &benchmark_registry();
+
+        struct BenchmarkRegistration
+        {
+            BenchmarkRegistration(const char *name, BenchmarkFunction function, std::initializer_list<int64_t> args = {})
+            {
+                benchmark_registry().push_back(BenchmarkDefinition{name, function, args});
+            }
+        };
+
+        // Runs every registered benchmark whose name contains filter (all when empty), growing
+        // the iteration count until a run lasts min_time, and prints one line per run
+        std::vector<BenchmarkResult> run_benchmarks(const std::string &filter, std::chrono::duration<double> min_time);
+
+        // Keeps value (and whatever it points to) alive as far as the optimizer is concerned
+        template <typename T>
+        inline void do_not_optimize(const T &value)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            asm volatile("" : : "r,m"(value) : "memory");
+#else
+            static volatile const void *sink;
+            sink = &value;
+#endif
+        }
+
+    } // namespace bench
+} // namespace spe
+
+#define SPE_BENCHMARK_CONCAT_INNER(a, b) a##b
+#define SPE_BENCHMARK_CONCAT(a, b) SPE_BENCHMARK_CONCAT_INNER(a, b)
+
+// SPE_BENCHMARK(function) or SPE_BENCHMARK(function, arg1, arg2, ...) at namespace scope
+#define SPE_BENCHMARK(function, ...)                                                                  \
+    static ::spe::bench::BenchmarkRegistration SPE_BENCHMARK_CONCAT(function##_registration_, __LINE__)( \
+        #function, function, {__VA_ARGS__})
@@ -0,0 +1,424 @@
+#include "benchmark.hpp"
+#include "arbitrage_engine.hpp"
+#include "currency_graph.hpp"
+#include "exposure_management.hpp"
+#include "instrument_registry.hpp"
+#include "market_data.hpp"
+#include "mispricing_detector.hpp"
+#include "pricing_models.hpp"
+#include "rolling_window.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace spe;
+using spe::bench::State;
+using spe::bench::do_not_optimize;
+
+namespace
+{
+    // Inputs are drawn up front so the loops time the code under test, not the generator
+    constexpr size_t SERIES_LENGTH = 4096; // power of two; indexed with a mask
+    constexpr size_t SERIES_MASK = SERIES_LENGTH - 1;
+    constexpr size_t OPPORTUNITY_DRAIN_INTERVAL = 1024;
+
+    std::vector<double> random_walk(double start, double volatility, unsigned seed)
+    {
+        std::mt19937_64 rng(seed);
+        std::normal_distribution<double> shock(0.0, volatility);
+        std::vector<double> prices(SERIES_LENGTH);
+        double price = start;
+        for (auto &value : prices)
+        {
+            price *= std::exp(shock(rng));
+            value = price;
+        }
+        return prices;
+    }
+
+    // Quotes a small fixed universe into a store: a spot, its perpetual and future, and a call
+    struct PricingFixture
+    {
+        market_data::SnapshotStore store;
+        market_data::InstrumentHandle spot;
+        market_data::InstrumentHandle perpetual;
+        market_data::InstrumentHandle future;
+        market_data::InstrumentHandle option;
+
+        PricingFixture()
+            : spot(market_data::intern_instrument("BENCH-USD")),
+              perpetual(market_data::intern_instrument("BENCH-USD-SWAP")),
+              future(market_data::intern_instrument("BENCH-USD-FUT")),
+              option(market_data::intern_instrument("BENCH-USD-C-100"))
+        {
+            store.reserve(market_data::InstrumentRegistry::instance().size());
+            store.apply_quote(market_data::Quote(spot, 99.95, 100.05, 10.0, 10.0));
+            store.apply_quote(market_data::Quote(perpetual, 100.00, 100.10, 10.0, 10.0));
+            store.apply_quote(market_data::Quote(future, 100.80, 100.95, 10.0, 10.0));
+            store.apply_quote(market_data::Quote(option, 4.90, 5.10, 10.0, 10.0));
+            store.publish();
+        }
+    };
+}
+
+// StatisticalMispricingDetector::calculate_z_score is a private wrapper over this
+static void rolling_z_score(State &state)
+{
+    std::vector<double> series = random_walk(100.0, 0.001, 1);
+    stats::RollingStatistics history(static_cast<size_t>(state.arg()));
+    for (size_t i = 0; i < history.capacity(); ++i)
+    {
+        history.push(series[i & SERIES_MASK]);
+    }
+
+    size_t i = 0;
+    while (state.keep_running())
+    {
+        double value = series[i++ & SERIES_MASK];
+        history.push(value);
+        do_not_optimize(history.z_score(value));
+    }
+}
+SPE_BENCHMARK(rolling_z_score, 50, 500, 5000);
+
+// VolatilityArbitrageDetector::calculate_realized_volatility: annualized stdev of the log returns
+static void realized_volatility(State &state)
+{
+    std::vector<double> series = random_walk(100.0, 0.01, 2);
+    stats::RollingLogReturns prices(static_cast<size_t>(state.arg()));
+    for (size_t i = 0; i < static_cast<size_t>(state.arg()); ++i)
+    {
+        prices.push(series[i & SERIES_MASK]);
+    }
+
+    size_t i = 0;
+    while (state.keep_running())
+    {
+        prices.push(series[i++ & SERIES_MASK]);
+        do_not_optimize(std::sqrt(prices.returns().variance() * 252));
+    }
+}
+SPE_BENCHMARK(realized_volatility, 50, 500, 5000);
+
+// Triangular profit scoring: one pair quote, then re-scoring every cycle through it. The graph
+// is a full mesh over arg currencies, so a quote touches 2 * (arg - 2) triangles.
+static void triangular_cycle_update(State &state)
+{
+    size_t currencies = static_cast<size_t>(state.arg());
+    graph::CurrencyGraph currency_graph;
+    std::vector<market_data::InstrumentHandle> pairs;
+    std::vector<double> fair_prices;
+    std::mt19937_64 rng(3);
+    std::uniform_real_distribution<double> value(0.5, 2.0);
+    std::vector<double> currency_values(currencies);
+    for (auto &v : currency_values)
+    {
+        v = value(rng);
+    }
+    for (size_t base = 0; base < currencies; ++base)
+    {
+        for (size_t quote = base + 1; quote < currencies; ++quote)
+        {
+            std::string base_name = "BC" + std::to_string(base);
+            std::string quote_name = "BC" + std::to_string(quote);
+            auto instrument = market_data::intern_instrument(base_name + "-" + quote_name);
+            currency_graph.add_pair(instrument, base_name, quote_name);
+            pairs.push_back(instrument);
+            fair_prices.push_back(currency_values[base] / currency_values[quote]);
+        }
+    }
+    currency_graph.build();
+    for (size_t p = 0; p < pairs.size(); ++p)
+    {
+        currency_graph.update_quote(pairs[p], fair_prices[p] * 0.9999, fair_prices[p] * 1.0001);
+    }
+    currency_graph.evaluate_touched([](uint32_t, double, bool) {});
+
+    // Mid noise of ~2 spreads, so some cycles cross the threshold
+    std::vector<size_t> pair_sequence(SERIES_LENGTH);
+    std::vector<double> noise(SERIES_LENGTH);
+    std::uniform_int_distribution<size_t> pick(0, pairs.size() - 1);
+    std::normal_distribution<double> shock(0.0, 0.0004);
+    for (size_t i = 0; i < SERIES_LENGTH; ++i)
+    {
+        pair_sequence[i] = pick(rng);
+        noise[i] = std::exp(shock(rng));
+    }
+
+    size_t i = 0;
+    size_t profitable = 0;
+    while (state.keep_running())
+    {
+        size_t p = pair_sequence[i & SERIES_MASK];
+        double mid = fair_prices[p] * noise[i & SERIES_MASK];
+        ++i;
+        currency_graph.update_quote(pairs[p], mid * 0.9999, mid * 1.0001);
+        currency_graph.evaluate_touched([&](uint32_t, double, bool) { ++profitable; });
+    }
+    do_not_optimize(profitable);
+}
+SPE_BENCHMARK(triangular_cycle_update, 8, 32, 64);
+
+static void perpetual_synthetic_price(State &state)
+{
+    PricingFixture fixture;
+    pricing::PerpetualSwapPricingModel model;
+    auto snapshot = fixture.store.view();
+    std::vector<market_data::InstrumentHandle> components{fixture.spot};
+    while (state.keep_running())
+    {
+        do_not_optimize(model.calculate_synthetic_price(fixture.perpetual, components, snapshot));
+    }
+}
+SPE_BENCHMARK(perpetual_synthetic_price);
+
+static void futures_synthetic_price(State &state)
+{
+    PricingFixture fixture;
+    pricing::FuturesPricingModel model;
+    model.set_interest_rate(fixture.future, 0.05);
+    auto snapshot = fixture.store.view();
+    std::vector<market_data::InstrumentHandle> components{fixture.spot};
+    while (state.keep_running())
+    {
+        do_not_optimize(model.calculate_synthetic_price(fixture.future, components, snapshot));
+    }
+}
+SPE_BENCHMARK(futures_synthetic_price);
+
+static void options_synthetic_price(State &state)
+{
+    PricingFixture fixture;
+    pricing::OptionsPricingModel model;
+    model.register_option(fixture.option, pricing::OptionContract(fixture.spot, 100.0, 0.25, true));
+    pricing::VolatilitySurface surface;
+    for (double strike : {80.0, 90.0, 100.0, 110.0, 120.0})
+    {
+        for (double expiry : {0.1, 0.25, 0.5, 1.0})
+        {
+            surface.update_point(strike, expiry, 0.5 + 0.002 * std::abs(strike - 100.0));
+        }
+    }
+    model.update_volatility_surface(fixture.spot, surface);
+    auto snapshot = fixture.store.view();
+    std::vector<market_data::InstrumentHandle> components{fixture.spot};
+    while (state.keep_running())
+    {
+        do_not_optimize(model.calculate_synthetic_price(fixture.option, components, snapshot));
+    }
+}
+SPE_BENCHMARK(options_synthetic_price);
+
+// Build, validate and (when it passes) pool one arbitrage per mispricing; the pool is drained
+// off the clock so it stays at steady-state size
+static void process_mispricing(State &state)
+{
+    PricingFixture fixture;
+    arbitrage::ArbitrageEngine engine;
+    engine.update_market_data(fixture.store.view());
+
+    mispricing::MispricingOpportunity mispricing;
+    mispricing.target_instrument = fixture.perpetual;
+    mispricing.component_instruments = {fixture.spot};
+    mispricing.weights = {1.0};
+    mispricing.type = mispricing::MispricingType::SPOT_VS_SYNTHETIC_DERIVATIVE;
+    mispricing.market_price = 100.05;
+    mispricing.theoretical_price = 100.60;
+    mispricing.deviation_percentage = 0.55;
+    mispricing.expected_profit = 55.0;
+    mispricing.max_loss = 20.0;
+    mispricing.expiry_time = mispricing.detection_time + std::chrono::minutes(5);
+
+    size_t processed = 0;
+    while (state.keep_running())
+    {
+        engine.process_mispricing(mispricing);
+        if (++processed % OPPORTUNITY_DRAIN_INTERVAL == 0)
+        {
+            state.pause_timing();
+            engine.clear_opportunities();
+            state.resume_timing();
+        }
+    }
+}
+SPE_BENCHMARK(process_mispricing);
+
+// One tick's 64 candidates through the tiered validator against a liquid book: 60 are too close
+// to expiry and stop at the screen, 4 walk the book and are pooled
+static void process_mispricing_batch(State &state)
+{
+    PricingFixture fixture;
+    fixture.store.apply_quote(market_data::Quote(fixture.spot, 99.95, 100.05, 1000.0, 1000.0));
+    fixture.store.apply_quote(market_data::Quote(fixture.perpetual, 100.00, 100.10, 1000.0, 1000.0));
+    arbitrage::ArbitrageEngine engine;
+    engine.update_market_data(fixture.store.publish());
+
+    std::vector<mispricing::MispricingOpportunity> batch(64);
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        auto &mispricing = batch[i];
+        mispricing.target_instrument = fixture.perpetual;
+        mispricing.component_instruments = {fixture.spot};
+        mispricing.weights = {1.0};
+        mispricing.type = mispricing::MispricingType::SPOT_VS_SYNTHETIC_DERIVATIVE;
+        mispricing.market_price = 100.05;
+        mispricing.theoretical_price = 100.60;
+        mispricing.expected_profit = 55.0;
+        mispricing.expiry_time = mispricing.detection_time + std::chrono::minutes(i % 16 == 0 ? 30 : 1);
+    }
+
+    size_t processed = 0;
+    while (state.keep_running())
+    {
+        engine.process_mispricing_batch(batch);
+        if (++processed % (OPPORTUNITY_DRAIN_INTERVAL / 4) == 0)
+        {
+            state.pause_timing();
+            engine.clear_opportunities();
+            state.resume_timing();
+        }
+    }
+    do_not_optimize(engine.validation_stats().accepted);
+}
+SPE_BENCHMARK(process_mispricing_batch);
+
+// Pre-trade VaR/ES for a 300-position book spread over state.arg() instruments, with a
+// correlated history behind the matrix. The first run builds the factors; the timed runs
+// only simulate, as a pre-trade check against an unchanged book does. With pool_threads the
+// path batches run on a work-stealing pool of that many workers plus the caller.
+static void time_pre_trade_var(State &state, size_t pool_threads)
+{
+    constexpr size_t POSITIONS = 300;
+    size_t instruments = state.arg();
+
+    auto correlations = std::make_shared<stats::StreamingCorrelationMatrix>(instruments);
+    std::mt19937_64 rng(11);
+    std::normal_distribution<double> shock(0.0, 0.01);
+    std::vector<std::pair<market_data::InstrumentHandle, double>> returns(instruments);
+    for (int day = 0; day < 250; ++day)
+    {
+        double market = shock(rng);
+        for (size_t i = 0; i < instruments; ++i)
+        {
+            returns[i] = {static_cast<market_data::InstrumentHandle>(i), 0.6 * market + 0.8 * shock(rng)};
+        }
+        correlations->add_observation(returns);
+    }
+
+    exposure::AdvancedRiskCalculator calculator;
+    calculator.set_correlation_matrix(correlations);
+    if (pool_threads > 0)
+    {
+        calculator.set_execution_mode(concurrency::ExecutionMode::PARALLEL,
+                                      std::make_shared<concurrency::WorkStealingPool>(pool_threads));
+    }
+    exposure::Portfolio portfolio;
+    for (size_t p = 0; p < POSITIONS; ++p)
+    {
+        exposure::Position position;
+        position.instrument = static_cast<market_data::InstrumentHandle>(p % instruments);
+        position.side = p % 3 == 0 ? exposure::PositionSide::SHORT : exposure::PositionSide::LONG;
+        position.size = 10.0 * (1 + p % 7);
+        position.current_price = 100.0;
+        portfolio.positions.push_back(position);
+    }
+    exposure::Position candidate = portfolio.positions[1];
+    calculator.calculate_pre_trade_risk(portfolio, candidate, 0.99);
+
+    while (state.keep_running())
+    {
+        do_not_optimize(calculator.calculate_pre_trade_risk(portfolio, candidate, 0.99).value_at_risk);
+    }
+}
+
+static void pre_trade_monte_carlo_var(State &state)
+{
+    time_pre_trade_var(state, 0);
+}
+SPE_BENCHMARK(pre_trade_monte_carlo_var, 10, 50, 100);
+
+// The same on every core
+static void pre_trade_monte_carlo_var_parallel(State &state)
+{
+    time_pre_trade_var(state, std::max(std::thread::hardware_concurrency(), 2u) - 1);
+}
+SPE_BENCHMARK(pre_trade_monte_carlo_var_parallel, 100);
+
+// Per-tick basis check over arg spot/perpetual pairs whose funding curves are cached: one gather
+// and one SIMD pass, with no pair trading through the threshold
+static void spot_funding_basis_scan(State &state)
+{
+    size_t pairs = static_cast<size_t>(state.arg());
+    std::vector<market_data::InstrumentHandle> spots(pairs);
+    std::vector<market_data::InstrumentHandle> perpetuals(pairs);
+    for (size_t i = 0; i < pairs; ++i)
+    {
+        spots[i] = market_data::intern_instrument("BFS" + std::to_string(i) + "-USDT");
+        perpetuals[i] = market_data::intern_instrument("BFS" + std::to_string(i) + "-USDT-SWAP");
+    }
+    market_data::SnapshotStore store;
+    store.reserve(market_data::InstrumentRegistry::instance().size());
+    arbitrage::SpotFundingSyntheticPerpetualEngine engine(std::make_unique<pricing::PerpetualSwapPricingModel>());
+    pricing::FundingRate rate;
+    rate.rate = 0.0001;
+    rate.timestamp = std::chrono::high_resolution_clock::now() + std::chrono::hours(3);
+    for (size_t i = 0; i < pairs; ++i)
+    {
+        engine.add_spot_perpetual_pair(spots[i], perpetuals[i]);
+        engine.update_funding_rate(perpetuals[i], rate);
+        store.apply_quote(market_data::Quote(spots[i], 99.99, 100.01, 10.0, 10.0));
+        store.apply_quote(market_data::Quote(perpetuals[i], 100.00, 100.02, 10.0, 10.0));
+    }
+    store.publish();
+    auto snapshot = store.view();
+    engine.update_market_data(snapshot);
+
+    while (state.keep_running())
+    {
+        engine.update_market_data(snapshot);
+    }
+    do_not_optimize(engine.pair_count());
+}
+SPE_BENCHMARK(spot_funding_basis_scan, 30, 300);
+
+// Basis update for BTC/ETH/SOL with arg listed expiries each: every pair's rolling window and
+// every curve refreshed, then the view published
+static void basis_term_structure_update(State &state)
+{
+    size_t expiries = static_cast<size_t>(state.arg());
+    auto model = std::make_shared<pricing::FuturesPricingModel>();
+    mispricing::RealTimeBasisCalculator calculator(mispricing::DetectionParameters{}, model);
+    market_data::SnapshotStore store;
+    auto now = std::chrono::high_resolution_clock::now();
+    std::vector<std::pair<market_data::InstrumentHandle, market_data::InstrumentHandle>> legs;
+    for (const char *underlying : {"BTS", "ETS", "SOS"})
+    {
+        auto spot = market_data::intern_instrument(std::string(underlying) + "-USDT");
+        model->set_interest_rate(spot, 0.05);
+        for (size_t i = 0; i < expiries; ++i)
+        {
+            auto future = market_data::intern_instrument(std::string(underlying) + "-FUT" + std::to_string(i));
+            model->register_futures_contract(future, pricing::FuturesContract(spot, now + std::chrono::hours(24 * 7 * (i + 1))));
+            legs.emplace_back(spot, future);
+        }
+        calculator.add_underlying(spot);
+    }
+    store.reserve(market_data::InstrumentRegistry::instance().size());
+    for (const auto &leg : legs)
+    {
+        store.apply_quote(market_data::Quote(leg.first, 99.99, 100.01, 10.0, 10.0));
+        store.apply_quote(market_data::Quote(leg.second, 100.40, 100.42, 10.0, 10.0));
+    }
+    store.publish();
+    auto snapshot = store.view();
+
+    while (state.keep_running())
+    {
+        calculator.update_market_data(snapshot);
+    }
+    do_not_optimize(calculator.get_current_basis(legs[0].first, legs[0].second));
+}
+SPE_BENCHMARK(basis_term_structure_update, 8, 32);
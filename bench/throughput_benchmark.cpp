@@ -0,0 +1,267 @@
+#include "throughput_benchmark.hpp"
+#include "benchmark.hpp"
+#include "arbitrage_engine.hpp"
+#include "instrument_registry.hpp"
+#include "latency_histogram.hpp"
+#include "market_data.hpp"
+#include "mispricing_detector.hpp"
+#include "work_stealing_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace spe
+{
+    namespace bench
+    {
+
+        namespace
+        {
+            constexpr double HALF_SPREAD = 0.0001;     // 1 bp either side of mid
+            constexpr double VALUE_VOLATILITY = 0.0001; // per requote of a currency
+            constexpr double QUOTE_NOISE = 0.0002;      // mid dislocation from fair value
+            constexpr uint64_t DRAIN_INTERVAL = 1024;   // ticks between off-the-clock store drains
+
+            struct SyntheticPair
+            {
+                market_data::InstrumentHandle instrument;
+                size_t base;  // currency index
+                size_t quote; // currency index, or the USD index for the USD legs
+            };
+
+            // Currencies TC0..TCn-1 against USD, then their crosses, until the universe is full
+            std::vector<SyntheticPair> build_universe(size_t universe_size, size_t &currency_count)
+            {
+                currency_count = 3;
+                while (currency_count + currency_count * (currency_count - 1) / 2 < universe_size)
+                {
+                    ++currency_count;
+                }
+
+                std::vector<SyntheticPair> pairs;
+                auto name = [](size_t currency) { return "TC" + std::to_string(currency); };
+                for (size_t c = 0; c < currency_count && pairs.size() < universe_size; ++c)
+                {
+                    pairs.push_back({market_data::intern_instrument(name(c) + "-USD"), c, currency_count});
+                }
+                for (size_t base = 0; base < currency_count && pairs.size() < universe_size; ++base)
+                {
+                    for (size_t quote = base + 1; quote < currency_count && pairs.size() < universe_size; ++quote)
+                    {
+                        pairs.push_back({market_data::intern_instrument(name(base) + "-" + name(quote)), base, quote});
+                    }
+                }
+                return pairs;
+            }
+        }
+
+        ThroughputResult run_throughput_benchmark(const ThroughputConfig &config)
+        {
+            // Before anything is built, so the detector state is allocated on the thread's node
+            if (!concurrency::apply_placement(config.topology.placement(concurrency::ThreadTopology::DETECTOR)))
+            {
+                std::fprintf(stderr, "warning: detector placement not fully applied\n");
+            }
+
+            size_t currency_count = 0;
+            std::vector<SyntheticPair> universe = build_universe(std::max<size_t>(config.universe_size, 3), currency_count);
+            std::vector<market_data::InstrumentHandle> instruments;
+            for (const auto &pair : universe)
+            {
+                instruments.push_back(pair.instrument);
+            }
+
+            std::mt19937_64 rng(config.seed);
+            std::uniform_real_distribution<double> initial_value(0.5, 2.0);
+            std::normal_distribution<double> value_shock(0.0, VALUE_VOLATILITY);
+            std::normal_distribution<double> quote_noise(0.0, QUOTE_NOISE);
+            std::uniform_int_distribution<size_t> pick(0, universe.size() - 1);
+            std::uniform_real_distribution<double> size(1.0, 100.0);
+
+            std::vector<double> currency_values(currency_count + 1, 1.0); // last entry is USD
+            for (size_t c = 0; c < currency_count; ++c)
+            {
+                currency_values[c] = initial_value(rng);
+            }
+
+            // Detector stack: cycles over the whole universe, stat-arb pairs, volatility
+            mispricing::DetectionParameters detection_params;
+            auto triangular = std::make_unique<mispricing::TriangularArbitrageDetector>(detection_params);
+            triangular->add_currency_triangle("throughput-universe", instruments);
+            auto stat_arb = std::make_unique<mispricing::StatisticalArbitrageSignalGenerator>(detection_params);
+            for (size_t i = 0; i < config.stat_arb_pairs; ++i)
+            {
+                stat_arb->add_instrument_pair(instruments[pick(rng)], instruments[pick(rng)]);
+            }
+
+            mispricing::CompositeMispricingDetector detector(detection_params);
+            detector.add_detector(std::move(triangular));
+            detector.add_detector(std::move(stat_arb));
+            detector.add_detector(std::make_unique<mispricing::VolatilityArbitrageDetector>(detection_params));
+            if (config.threads > 0)
+            {
+                detector.set_execution_mode(concurrency::ExecutionMode::PARALLEL,
+                                            std::make_shared<concurrency::WorkStealingPool>(
+                                                config.topology.worker_placements(concurrency::ThreadTopology::DETECTOR_SHARDS,
+                                                                                  config.threads)));
+            }
+
+            arbitrage::ArbitrageEngine engine;
+            arbitrage::TriangularArbitrageEngine triangular_engine;
+            triangular_engine.add_currency_triangle("throughput-universe", instruments);
+
+            ThroughputResult result;
+            detector.set_detection_callback([&](const mispricing::MispricingOpportunity &mispricing)
+                                            {
+                                                ++result.detections;
+                                                engine.process_mispricing(mispricing); });
+            detector.set_expiry_callback([](const mispricing::MispricingOpportunity &) {});
+            auto count_opportunity = [&](const arbitrage::ArbitrageOpportunity &) { ++result.opportunities; };
+            engine.set_opportunity_callback(count_opportunity);
+            triangular_engine.set_opportunity_callback(count_opportunity);
+
+            // Seed every instrument with a fair quote before the clock starts
+            market_data::SnapshotStore store;
+            store.reserve(market_data::InstrumentRegistry::instance().size());
+            auto make_quote = [&](const SyntheticPair &pair, double noise)
+            {
+                double mid = currency_values[pair.base] / currency_values[pair.quote] * noise;
+                return market_data::Quote(pair.instrument, mid * (1.0 - HALF_SPREAD), mid * (1.0 + HALF_SPREAD),
+                                          size(rng), size(rng));
+            };
+            for (const auto &pair : universe)
+            {
+                store.apply_quote(make_quote(pair, 1.0));
+            }
+            auto seeded = store.publish();
+            detector.update_market_data(seeded);
+            engine.update_market_data(seeded);
+            triangular_engine.update_market_data(seeded);
+            result.detections = 0;
+            result.opportunities = 0;
+            engine.clear_opportunities();
+            triangular_engine.clear_opportunities();
+
+            telemetry::LatencyHistogram latencies;
+            std::vector<market_data::Quote> tick_quotes(std::max<size_t>(config.quotes_per_tick, 1));
+            bool paced = config.tick_rate > 0.0;
+            auto period = paced ? std::chrono::duration_cast<BenchClock::duration>(
+                                      std::chrono::duration<double>(1.0 / config.tick_rate))
+                                : BenchClock::duration::zero();
+            auto duration = std::chrono::duration_cast<BenchClock::duration>(
+                std::chrono::duration<double>(config.duration_seconds));
+
+            auto run_start = BenchClock::now();
+            auto run_end = run_start + duration;
+            auto scheduled = run_start;
+            while (true)
+            {
+                // Draw the tick's quotes first so generation stays out of the measurement
+                for (auto &quote : tick_quotes)
+                {
+                    const SyntheticPair &pair = universe[pick(rng)];
+                    currency_values[pair.base] *= std::exp(value_shock(rng));
+                    quote = make_quote(pair, std::exp(quote_noise(rng)));
+                }
+
+                BenchClock::time_point tick_start;
+                if (paced)
+                {
+                    scheduled += period;
+                    while (BenchClock::now() < scheduled)
+                    {
+                        std::this_thread::yield();
+                    }
+                    tick_start = scheduled;
+                }
+                else
+                {
+                    tick_start = BenchClock::now();
+                }
+                if (tick_start >= run_end)
+                {
+                    break;
+                }
+
+                auto now = std::chrono::high_resolution_clock::now();
+                if (config.event_driven)
+                {
+                    for (auto &quote : tick_quotes)
+                    {
+                        quote.timestamp = now;
+                        detector.on_quote(quote.instrument, quote);
+                        engine.on_quote(quote.instrument, quote);
+                        triangular_engine.on_quote(quote.instrument, quote);
+                    }
+                }
+                else
+                {
+                    for (auto &quote : tick_quotes)
+                    {
+                        quote.timestamp = now;
+                        store.apply_quote(quote);
+                    }
+                    auto snapshot = store.publish();
+                    detector.update_market_data(snapshot);
+                    engine.update_market_data(snapshot);
+                    triangular_engine.update_market_data(snapshot);
+                }
+
+                auto tick_end = BenchClock::now();
+                latencies.record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(tick_end - tick_start).count()));
+                ++result.ticks;
+
+                if (result.ticks % DRAIN_INTERVAL == 0)
+                {
+                    engine.clear_opportunities();
+                    triangular_engine.clear_opportunities();
+                }
+            }
+
+            result.elapsed_seconds = std::chrono::duration<double>(BenchClock::now() - run_start).count();
+            result.ticks_per_second = result.elapsed_seconds > 0.0 ? result.ticks / result.elapsed_seconds : 0.0;
+            result.mean_ns = latencies.mean();
+            result.p50_ns = latencies.percentile(0.50);
+            result.p90_ns = latencies.percentile(0.90);
+            result.p99_ns = latencies.percentile(0.99);
+            result.p999_ns = latencies.percentile(0.999);
+            result.max_ns = latencies.max();
+
+            std::printf("\nThroughput: %zu instruments over %zu currencies, %zu stat-arb pairs, %zu quotes/tick, ",
+                        universe.size(), currency_count + 1, config.stat_arb_pairs, tick_quotes.size());
+            if (paced)
+            {
+                std::printf("%.0f ticks/s target, ", config.tick_rate);
+            }
+            else
+            {
+                std::printf("unthrottled, ");
+            }
+            std::printf("%zu pool threads, %s\n", config.threads, config.event_driven ? "event-driven" : "snapshots");
+            if (!config.topology.stages().empty())
+            {
+                std::printf("topology: %s\n", config.topology.describe().c_str());
+            }
+            std::printf("%s\n", std::string(78, '-').c_str());
+            std::printf("ticks %llu in %.2f s: %.0f ticks/s, %.0f quotes/s\n",
+                        static_cast<unsigned long long>(result.ticks), result.elapsed_seconds, result.ticks_per_second,
+                        result.ticks_per_second * static_cast<double>(tick_quotes.size()));
+            std::printf("detections %llu, validated opportunities %llu\n",
+                        static_cast<unsigned long long>(result.detections),
+                        static_cast<unsigned long long>(result.opportunities));
+            std::printf("tick latency ns: mean %.0f  p50 %llu  p90 %llu  p99 %llu  p99.9 %llu  max %llu\n",
+                        result.mean_ns, static_cast<unsigned long long>(result.p50_ns),
+                        static_cast<unsigned long long>(result.p90_ns), static_cast<unsigned long long>(result.p99_ns),
+                        static_cast<unsigned long long>(result.p999_ns), static_cast<unsigned long long>(result.max_ns));
+            return result;
+        }
+
+    } // namespace bench
+} // namespace spe
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "thread_topology.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace spe
+{
+    namespace bench
+    {
+
+        struct ThroughputConfig
+        {
+            size_t universe_size = 64;   // spot instruments: CUR-USD legs plus CURi-CURj crosses
+            size_t stat_arb_pairs = 64;  // random instrument pairs for the stat-arb generator
+            size_t quotes_per_tick = 4;  // instruments requoted per published snapshot
+            double tick_rate = 0.0;      // ticks per second; 0 runs unthrottled
+            double duration_seconds = 5.0;
+            size_t threads = 0;          // pool threads for the composite detector; 0 runs inline
+            uint64_t seed = 42;
+            bool event_driven = false;   // hand each quote to on_quote instead of publishing a snapshot
+            concurrency::ThreadTopology topology; // "detector" places the driving thread, "detector.shards" the pool
+        };
+
+        struct ThroughputResult
+        {
+            uint64_t ticks = 0;
+            uint64_t detections = 0;    // mispricings the detectors reported
+            uint64_t opportunities = 0; // arbitrages the engines validated
+            double elapsed_seconds = 0.0;
+            double ticks_per_second = 0.0;
+            double mean_ns = 0.0;
+            uint64_t p50_ns = 0;
+            uint64_t p90_ns = 0;
+            uint64_t p99_ns = 0;
+            uint64_t p999_ns = 0;
+            uint64_t max_ns = 0;
+        };
+
+        // Drives the detector and engine stack tick by tick from a synthetic random-walk feed and
+        // prints the result. A tick is: apply the quotes, publish, run the detectors (whose
+        // callbacks feed the arbitrage engine) and the triangular engine. When paced, a tick's
+        // latency runs from its scheduled time, so falling behind shows up in the tail. Event-driven
+        // runs skip the publish and pass each quote to the on_quote hooks instead.
+        ThroughputResult run_throughput_benchmark(const ThroughputConfig &config);
+
+    } // namespace bench
+} // namespace spe
@@ -3,11 +3,27 @@
 #include "market_data.hpp"
 #include "pricing_models.hpp"
 #include "mispricing_detector.hpp"
+#include "rolling_window.hpp"
+#include "correlation_matrix.hpp"
+#include "small_vector.hpp"
+#include "object_pool.hpp"
+#include "epoch_domain.hpp"
+#include "timing_wheel.hpp"
+#include "venue_price_matrix.hpp"
+#include "linear_algebra.hpp"
+#include "work_stealing_pool.hpp"
+#include "seqlock.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <map>
 #include <memory>
 #include <functional>
-#include <queue>
 #include <set>
 
 namespace spe
@@ -18,6 +34,7 @@ namespace spe
         using namespace market_data;
         using namespace pricing;
         using namespace mispricing;
+        using stats::StreamingCorrelationMatrix;
 
         enum class ArbitrageType
         {
@@ -43,7 +60,7 @@ namespace spe
 
         struct ArbitrageLeg // Represents one leg of an arbitrage opportunity
         {
-            InstrumentId instrument_id;
+            InstrumentHandle instrument;
             Side side; // BID or ASK
             Volume size;
             Price entry_price;
@@ -52,18 +69,25 @@ namespace spe
             Timestamp entry_time;
             Timestamp exit_time;
 
-            ArbitrageLeg() : size(0.0), entry_price(0.0), exit_price(0.0), weight(0.0) {}
-            ArbitrageLeg(const InstrumentId &id, Side s, Volume sz, Price price, double w)
-                : instrument_id(id), side(s), size(sz), entry_price(price), exit_price(0.0), weight(w) {}
+            ArbitrageLeg() : instrument(INVALID_INSTRUMENT), size(0.0), entry_price(0.0), exit_price(0.0), weight(0.0) {}
+            ArbitrageLeg(InstrumentHandle handle, Side s, Volume sz, Price price, double w)
+                : instrument(handle), side(s), size(sz), entry_price(price), exit_price(0.0), weight(w) {}
         };
 
+        // Most structures have two to four legs; those stay inline
+        using LegVector = memory::SmallVector<ArbitrageLeg, 4>;
+
+        // Process-wide, monotonically increasing; 0 is never issued
+        using OpportunityId = uint64_t;
+        constexpr OpportunityId INVALID_OPPORTUNITY_ID = 0;
+
         struct ArbitrageOpportunity // detailed structure for an arbitrage opportunity including legs, mispricing source, and financial metrics
         {
-            std::string opportunity_id;
+            OpportunityId opportunity_id;
             ArbitrageType type;
             ArbitrageStatus status;
 
-            std::vector<ArbitrageLeg> legs;
+            LegVector legs;
             MispricingOpportunity mispricing_source;
 
             // Financial metrics
@@ -93,7 +117,7 @@ namespace spe
             Volume total_volume;
             double market_impact;
 
-            ArbitrageOpportunity() : expected_profit(0.0), max_loss(0.0), profit_probability(0.0),
+            ArbitrageOpportunity() : opportunity_id(INVALID_OPPORTUNITY_ID), expected_profit(0.0), max_loss(0.0), profit_probability(0.0),
                                      break_even_price(0.0), total_cost(0.0), net_exposure(0.0),
                                      value_at_risk(0.0), expected_shortfall(0.0), sharpe_ratio(0.0),
                                      max_drawdown(0.0), correlation_risk(0.0), slippage_estimate(0.0),
@@ -101,6 +125,132 @@ namespace spe
                                      identification_time(std::chrono::high_resolution_clock::now()) {}
         };
 
+        OpportunityId next_opportunity_id();
+
+        // Display form ("ARB_42", "TRIANG_42"), built only when someone asks for it
+        std::string format_opportunity_id(const ArbitrageOpportunity &opportunity);
+
+        using OpportunityHandle = memory::PoolHandle;
+
+        // An engine's live opportunities. The engine thread is the only writer: it builds an
+        // opportunity in place in a pooled slot, commits it (indexing it by id and scheduling
+        // its expiry on a timing wheel) and publishes. Expiry is at the earlier of expiry_time
+        // and identification_time + max_holding_period, and costs O(expired).
+        //
+        // Any thread may take a View: an epoch-pinned list of the opportunities as of the last
+        // publish(). Published opportunities are never written again; modify() copies one into
+        // a new slot, and slots of removed or superseded versions are only recycled once no
+        // view can still see them.
+        class OpportunityBook
+        {
+        private:
+            struct Published
+            {
+                std::vector<const ArbitrageOpportunity *> opportunities;
+                uint64_t version = 0;
+            };
+
+            struct Entry
+            {
+                OpportunityHandle handle;
+                timing::TimerId timer;
+                uint32_t position; // in live_
+            };
+
+            memory::ObjectPool<ArbitrageOpportunity> pool_;
+            std::unordered_map<OpportunityId, Entry> index_;
+            std::vector<const ArbitrageOpportunity *> live_; // committed, in no particular order
+            std::vector<OpportunityId> live_ids_;           // parallel to live_
+            timing::TimingWheel<OpportunityId> expiry_wheel_;
+            std::chrono::milliseconds max_holding_period_;
+
+            concurrency::EpochDomain epochs_;
+            std::atomic<Published *> published_;
+            std::vector<OpportunityHandle> unlinked_; // removed or superseded since the last publish
+            std::vector<OpportunityId> modified_;     // to reschedule at the next publish
+            std::vector<std::pair<uint64_t, OpportunityHandle>> retired_; // by retire epoch, ascending
+            std::vector<std::pair<uint64_t, Published *>> retired_views_;
+            std::vector<Published *> spare_views_;
+            bool dirty_;
+
+            uint64_t deadline_tick(const ArbitrageOpportunity &opportunity) const;
+            void unlink(OpportunityId id, bool cancel_timer);
+            void reclaim();
+
+        public:
+            class View
+            {
+            private:
+                concurrency::EpochDomain::Guard guard_;
+                const Published *published_;
+
+            public:
+                View(concurrency::EpochDomain::Guard guard, const Published *published)
+                    : guard_(std::move(guard)), published_(published) {}
+
+                using const_iterator = const ArbitrageOpportunity *const *;
+                const_iterator begin() const { return published_->opportunities.data(); }
+                const_iterator end() const { return begin() + published_->opportunities.size(); }
+                size_t size() const { return published_->opportunities.size(); }
+                bool empty() const { return published_->opportunities.empty(); }
+                const ArbitrageOpportunity &operator[](size_t i) const { return *published_->opportunities[i]; }
+                uint64_t version() const { return published_->version; }
+            };
+
+            explicit OpportunityBook(std::chrono::minutes max_holding_period = std::chrono::minutes(60));
+            ~OpportunityBook();
+
+            OpportunityBook(const OpportunityBook &) = delete;
+            OpportunityBook &operator=(const OpportunityBook &) = delete;
+
+            // Writer. A reset opportunity with a fresh id, in a recycled slot; private until commit()
+            ArbitrageOpportunity &create(OpportunityHandle &handle);
+            void commit(OpportunityHandle handle);
+            OpportunityHandle insert(const ArbitrageOpportunity &opportunity); // create, copy and commit
+            void release(OpportunityHandle handle); // uncommitted or live
+            bool remove(OpportunityId id);
+
+            ArbitrageOpportunity *get(OpportunityHandle handle) { return pool_.get(handle); }
+            const ArbitrageOpportunity *get(OpportunityHandle handle) const { return pool_.get(handle); }
+            OpportunityHandle find(OpportunityId id) const;
+
+            // A writable copy of a live opportunity, replacing it at the next publish(), which
+            // also reschedules its expiry; views keep the version they hold.
+            ArbitrageOpportunity *modify(OpportunityId id);
+
+            // Removes everything due at now; returns how many
+            size_t expire(Timestamp now);
+            void set_max_holding_period(std::chrono::minutes period) { max_holding_period_ = period; } // for later commits
+
+            // Makes committed changes visible to views, and recycles what no view can reach
+            void publish();
+            void clear();
+
+            // Any thread
+            View view() const;
+            uint64_t version() const { return published_.load()->version; }
+
+            template <typename Visitor>
+            void for_each(Visitor &&visitor) const
+            {
+                View current = view();
+                for (const ArbitrageOpportunity *opportunity : current)
+                {
+                    visitor(*opportunity);
+                }
+            }
+
+            // Copies for the by-value IArbitrageEngine API
+            std::vector<ArbitrageOpportunity> copy_all() const;
+
+            // Writer. Restored opportunities get fresh ids and are committed and published;
+            // those already due at now are dropped
+            void save_state(checkpoint::CheckpointWriter &out) const;
+            bool restore_state(checkpoint::SectionReader &in, Timestamp now);
+
+            size_t size() const { return live_.size(); } // writer: committed, published or not
+        };
+
         struct ArbitrageParameters // configurable parameters for arbitrage engine
         {
             double min_profit_threshold = 0.001; // 0.1%
@@ -114,16 +264,64 @@ namespace spe
             double confidence_threshold = 0.8;
         };
 
+        // Portfolio room a risk manager publishes for the engines' pre-trade screen, e.g. the
+        // SyntheticExposureManager after every book change. Engines load it once per batch;
+        // until the first store the screen applies no portfolio limits.
+        struct RiskHeadroom
+        {
+            double var_headroom = std::numeric_limits<double>::infinity();        // VaR the book can still add
+            double position_size_limit = std::numeric_limits<double>::infinity(); // notional per leg
+            double var_per_notional = 0.0;                                        // incremental VaR per unit of leg notional
+            bool halted = false;                                                  // limits breached; nothing new until they clear
+        };
+
+        using RiskHeadroomFeed = concurrency::Seqlock<RiskHeadroom>;
+
+        struct ValidationStats
+        {
+            size_t screened = 0;
+            size_t screen_rejected = 0; // by the cached checks alone
+            size_t full_rejected = 0;   // passed the screen, failed the book walk or the batch's headroom
+            size_t accepted = 0;
+        };
+
         using ArbitrageCallback = std::function<void(const ArbitrageOpportunity &)>;
         using ArbitrageUpdateCallback = std::function<void(const ArbitrageOpportunity &)>;
+        using OpportunityVisitor = std::function<void(const ArbitrageOpportunity &)>;
 
+        // Engines take market data as published snapshots or as single events. The event
+        // defaults fold the event into a private SnapshotStore and hand update_market_data a
+        // snapshot whose dirty list is that one instrument; engines with incremental state
+        // override them.
         class IArbitrageEngine // base interface for all arbitrage engines, defining common methods
         {
+        private:
+            std::unique_ptr<SnapshotStore> event_store_; // created by the first adapted event
+
+            void adapt_event();
+
+        protected:
+            SnapshotStore &event_store();
+
         public:
             virtual ~IArbitrageEngine() = default;
 
             virtual void update_market_data(const MarketSnapshot &snapshot) = 0;
+
+            // Incremental API; events for one engine come from one thread
+            virtual void on_quote(InstrumentHandle instrument, const Quote &quote);
+            virtual void on_trade(InstrumentHandle instrument, const Trade &trade);
+            virtual void on_book_update(InstrumentHandle instrument, const MarketDepth &depth);
+
             virtual void process_mispricing(const MispricingOpportunity &mispricing) = 0;
+            // Candidates found on the same tick; engines that validate in batches override this
+            virtual void process_mispricing_batch(const std::vector<MispricingOpportunity> &mispricings)
+            {
+                for (const auto &mispricing : mispricings)
+                {
+                    process_mispricing(mispricing);
+                }
+            }
             virtual std::vector<ArbitrageOpportunity> identify_opportunities() = 0;
             virtual bool validate_opportunity(ArbitrageOpportunity &opportunity) = 0;
 
@@ -133,42 +331,76 @@ namespace spe
 
             virtual std::vector<ArbitrageOpportunity> get_active_opportunities() const = 0;
             virtual void clear_opportunities() = 0;
+
+            // Visits live opportunities in place; engines backed by an OpportunityBook
+            // override this to avoid the copy
+            virtual void visit_active_opportunities(const OpportunityVisitor &visitor) const
+            {
+                for (const auto &opportunity : get_active_opportunities())
+                {
+                    visitor(opportunity);
+                }
+            }
         };
 
+        // Validation is tiered. A screen does arithmetic on the candidate against the
+        // parameters, the published RiskHeadroom and a cached upper bound on each instrument's
+        // visible liquidity; every test is a necessary condition of the full validation, so it
+        // rejects nothing that would have passed. Survivors of a batch then walk the book and
+        // draw down the batch's VaR headroom in arrival order. The liquidity bounds are
+        // refreshed from each snapshot's dirty instruments, so the engine must see every
+        // publish of the store it validates against.
         class ArbitrageEngine : public IArbitrageEngine
         {
         private:
+            static constexpr std::chrono::minutes MIN_TIME_TO_EXECUTE{5};
+
+            struct ValidationContext
+            {
+                Timestamp now; // one clock read per batch
+                RiskHeadroom headroom;
+            };
+
             ArbitrageParameters params_;
-            std::vector<ArbitrageOpportunity> active_opportunities_;
-            std::queue<MispricingOpportunity> pending_mispricings_;
+            OpportunityBook active_opportunities_;
 
-            // Market data
+            // Market data (non-owning view of the producer's SnapshotStore)
             MarketSnapshot latest_snapshot_;
 
+            // Per handle: most a BID leg (at the asks) and an ASK leg (at the bids) could fill
+            std::vector<std::array<Volume, 2>> visible_liquidity_;
+            std::shared_ptr<const RiskHeadroomFeed> headroom_feed_;
+            std::vector<OpportunityHandle> survivors_;
+            ValidationStats validation_stats_;
+
             // Callbacks
             ArbitrageCallback opportunity_callback_;
             ArbitrageUpdateCallback update_callback_;
 
             // Internal methods
-            ArbitrageOpportunity create_arbitrage_from_mispricing(const MispricingOpportunity &mispricing);
-            std::vector<ArbitrageLeg> optimize_legs(const MispricingOpportunity &mispricing);
+            void build_arbitrage_from_mispricing(const MispricingOpportunity &mispricing, ArbitrageOpportunity &opportunity,
+                                                 Timestamp now);
+            void optimize_legs(const MispricingOpportunity &mispricing, LegVector &legs, Timestamp now);
 
             // Risk calculations
             double calculate_value_at_risk(const ArbitrageOpportunity &opportunity);
             double calculate_expected_shortfall(const ArbitrageOpportunity &opportunity);
-            double calculate_correlation_risk(const std::vector<ArbitrageLeg> &legs);
+            double calculate_correlation_risk(const LegVector &legs);
             double calculate_market_impact(const ArbitrageOpportunity &opportunity);
 
             // Validation methods
+            ValidationContext validation_context() const;
+            void refresh_visible_liquidity(InstrumentHandle instrument);
+            bool screen_opportunity(const ArbitrageOpportunity &opportunity, const ValidationContext &context) const;
             bool validate_liquidity(const ArbitrageOpportunity &opportunity);
-            bool validate_risk_limits(const ArbitrageOpportunity &opportunity);
-            bool validate_timing(const ArbitrageOpportunity &opportunity);
-            bool validate_execution_feasibility(const ArbitrageOpportunity &opportunity);
+            double incremental_value_at_risk(const ArbitrageOpportunity &opportunity, const RiskHeadroom &headroom) const;
+            bool validate_survivor(ArbitrageOpportunity &opportunity, ValidationContext &context);
 
             // Opportunity management
             void cleanup_expired_opportunities();
             void update_opportunity_status(ArbitrageOpportunity &opportunity);
-            std::string generate_opportunity_id();
+
+            friend struct ArbitrageEngineTestAccess; // drives the validation tiers separately
 
         public:
             ArbitrageEngine(const ArbitrageParameters &params = ArbitrageParameters{});
@@ -176,6 +408,7 @@ namespace spe
 
             void update_market_data(const MarketSnapshot &snapshot) override;
             void process_mispricing(const MispricingOpportunity &mispricing) override;
+            void process_mispricing_batch(const std::vector<MispricingOpportunity> &mispricings) override;
             std::vector<ArbitrageOpportunity> identify_opportunities() override;
             bool validate_opportunity(ArbitrageOpportunity &opportunity) override;
 
@@ -185,31 +418,50 @@ namespace spe
 
             std::vector<ArbitrageOpportunity> get_active_opportunities() const override;
             void clear_opportunities() override;
+            void visit_active_opportunities(const OpportunityVisitor &visitor) const override;
 
             // Additional methods
-            void update_opportunity_status(const std::string &opportunity_id, ArbitrageStatus status);
-            ArbitrageOpportunity get_opportunity_by_id(const std::string &opportunity_id) const;
+            void update_opportunity_status(OpportunityId opportunity_id, ArbitrageStatus status);
+            const ArbitrageOpportunity *find_opportunity(OpportunityId opportunity_id) const; // null if gone
+            OpportunityBook::View opportunity_view() const { return active_opportunities_.view(); } // any thread
+
+            void set_risk_headroom_feed(std::shared_ptr<const RiskHeadroomFeed> feed) { headroom_feed_ = std::move(feed); }
+            const ValidationStats &validation_stats() const { return validation_stats_; }
+
+            // Live opportunities, on the engine thread; liquidity bounds come back with the
+            // first snapshot
+            static constexpr uint32_t CHECKPOINT_TAG = checkpoint::make_tag('A', 'R', 'B', 'E');
+            static constexpr uint32_t CHECKPOINT_VERSION = 1;
+            void save_state(checkpoint::CheckpointWriter &out) const { active_opportunities_.save_state(out); }
+            bool restore_state(checkpoint::SectionReader &in);
         };
 
         class TriangularArbitrageEngine : public IArbitrageEngine // specialized for triangular arbitrage in currency markets
         {
         private:
             ArbitrageParameters params_;
-            std::map<std::string, std::vector<InstrumentId>> currency_triangles_;
-            std::vector<ArbitrageOpportunity> active_opportunities_;
+            std::map<std::string, std::vector<InstrumentHandle>> currency_triangles_;
+            graph::CurrencyGraph currency_graph_; // cycles over the triangles' pairs (and discovered ones)
+            bool discover_pairs_;
+            bool graph_stale_;
+            OpportunityBook active_opportunities_;
 
             ArbitrageCallback opportunity_callback_;
             ArbitrageUpdateCallback update_callback_;
 
-            std::vector<ArbitrageOpportunity> identify_triangular_opportunities(const MarketSnapshot &snapshot);
-            ArbitrageOpportunity create_triangular_opportunity(const std::vector<InstrumentId> &triangle,
-                                                               const MarketSnapshot &snapshot);
-            double calculate_triangular_profit(const std::vector<Quote> &quotes);
+            void rebuild_graph();
+            void evaluate_cycles(); // validates cycles through the pairs quoted since the last call
+            void create_triangular_opportunity(uint32_t cycle, double log_return, ArbitrageOpportunity &opp) const;
 
         public:
             TriangularArbitrageEngine(const ArbitrageParameters &params = ArbitrageParameters{});
 
             void update_market_data(const MarketSnapshot &snapshot) override;
+
+            // A quote re-scores the cycles through its pair only
+            void on_quote(InstrumentHandle instrument, const Quote &quote) override;
+            void on_trade(InstrumentHandle, const Trade &) override {}
+            void on_book_update(InstrumentHandle, const MarketDepth &) override {}
             void process_mispricing(const MispricingOpportunity &mispricing) override;
             std::vector<ArbitrageOpportunity> identify_opportunities() override;
             bool validate_opportunity(ArbitrageOpportunity &opportunity) override;
@@ -220,9 +472,13 @@ namespace spe
 
             std::vector<ArbitrageOpportunity> get_active_opportunities() const override;
             void clear_opportunities() override;
+            void visit_active_opportunities(const OpportunityVisitor &visitor) const override;
 
-            void add_currency_triangle(const std::string &name, const std::vector<InstrumentId> &instruments);
+            void add_currency_triangle(const std::string &name, const std::vector<InstrumentHandle> &instruments);
             void remove_currency_triangle(const std::string &name);
+            void discover_currency_pairs(bool include_four_cycles = false);
+            const graph::CurrencyGraph &currency_graph() const { return currency_graph_; }
+            OpportunityBook::View opportunity_view() const { return active_opportunities_.view(); } // any thread
         };
 
         class StatisticalArbitrageEngine : public IArbitrageEngine // focuses on stat arbitrage opportunities
@@ -233,17 +489,17 @@ namespace spe
             std::vector<ArbitrageOpportunity> active_opportunities_;
 
             // Historical data for mean reversion
-            std::map<InstrumentId, std::queue<Price>> price_history_;
-            std::map<std::pair<InstrumentId, InstrumentId>, double> correlation_matrix_;
+            std::map<InstrumentHandle, RollingStatistics> price_history_;
+            std::shared_ptr<const StreamingCorrelationMatrix> correlation_matrix_; // shared, read lock-free
 
             ArbitrageCallback opportunity_callback_;
             ArbitrageUpdateCallback update_callback_;
 
             std::vector<ArbitrageOpportunity> identify_statistical_opportunities(const MarketSnapshot &snapshot);
-            ArbitrageOpportunity create_pairs_trade(const InstrumentId &instrument1,
-                                                    const InstrumentId &instrument2,
+            ArbitrageOpportunity create_pairs_trade(InstrumentHandle instrument1,
+                                                    InstrumentHandle instrument2,
                                                     const MarketSnapshot &snapshot);
-            double calculate_hedge_ratio(const InstrumentId &instrument1, const InstrumentId &instrument2);
+            double calculate_hedge_ratio(InstrumentHandle instrument1, InstrumentHandle instrument2);
 
         public:
             StatisticalArbitrageEngine(std::unique_ptr<IPricingModel> model,
@@ -261,45 +517,92 @@ namespace spe
             std::vector<ArbitrageOpportunity> get_active_opportunities() const override;
             void clear_opportunities() override;
 
-            void update_correlation_matrix(const MarketSnapshot &snapshot);
+            void set_correlation_matrix(std::shared_ptr<const StreamingCorrelationMatrix> matrix)
+            {
+                correlation_matrix_ = std::move(matrix);
+            }
         };
 
         // Spot + Funding Rate Synthetic Perpetual Arbitrage Engine
+        // Spot + Funding Synthetic Perpetual Engine
+        //
+        // Long spot plus a short perpetual collects the basis and the funding the short side
+        // receives; the reverse pays both. Funding only moves on settlements and mark-price
+        // events, so each pair's funding curve (the announced next rate, a predicted rate for
+        // the settlements after it, and how much of either falls within the funding horizon)
+        // is cached and refreshed only by update_funding_rate, update_mark_price, or time
+        // crossing a settlement. Per update, the pairs' quotes are gathered into contiguous
+        // columns and both directions' edges are computed in one SIMD pass.
         class SpotFundingSyntheticPerpetualEngine : public IArbitrageEngine // handles arbitrage between spot and perpetual future markets
         {
+        public:
+            static constexpr double DEFAULT_ROUND_TRIP_COST = 0.0008; // both legs in and out, as a fraction
+            static constexpr double DEFAULT_INTEREST_RATE = 0.0001;   // per 8h settlement, as Binance and OKX quote it
+            static constexpr double PREMIUM_CLAMP = 0.0005;           // bound on interest - premium per settlement
+
+            // A pair's cached funding view
+            struct FundingCurve
+            {
+                double announced_rate = 0.0; // applies at next_settlement
+                double predicted_rate = 0.0; // per settlement after it, from the premium when known
+                double premium = 0.0;        // (mark - index) / index from the last mark-price event
+                bool has_premium = false;
+                Timestamp next_settlement;
+                std::chrono::hours period{8};
+
+                // Fractions of notional collected by the short perpetual over the horizon
+                double announced_carry = 0.0;
+                double predicted_carry = 0.0;
+                Timestamp valid_until; // when the settlements within the horizon next change
+            };
+
         private:
             ArbitrageParameters params_;
             std::unique_ptr<PerpetualSwapPricingModel> perpetual_pricing_model_;
-            std::vector<ArbitrageOpportunity> active_opportunities_;
+            OpportunityBook active_opportunities_;
+            MarketSnapshot latest_snapshot_;
 
-            // Funding rate tracking
-            std::map<InstrumentId, FundingRate> current_funding_rates_;
-            std::map<InstrumentId, std::queue<FundingRate>> funding_rate_history_;
+            // Pairs, by position; curves are cold, the columns below are what a pass reads
+            std::vector<InstrumentHandle> pair_spots_;
+            std::vector<InstrumentHandle> pair_perpetuals_;
+            std::vector<FundingCurve> funding_curves_;
+            std::vector<uint32_t> pair_index_; // dense by perpetual handle
+            std::chrono::hours funding_horizon_;
+            double round_trip_cost_;
+            Timestamp next_curve_refresh_; // earliest valid_until
+
+            // Basis pass columns, padded to a whole register
+            std::vector<double> spot_bids_;
+            std::vector<double> spot_asks_;
+            std::vector<double> perpetual_bids_;
+            std::vector<double> perpetual_asks_;
+            std::vector<double> carries_;
+            std::vector<double> cash_and_carry_edges_; // long spot, short perpetual
+            std::vector<double> reverse_edges_;        // short spot, long perpetual
+
+            // Reported once while live: by pair, [0] long spot, [1] short spot
+            std::vector<std::array<OpportunityId, 2>> reported_;
 
             ArbitrageCallback opportunity_callback_;
             ArbitrageUpdateCallback update_callback_;
 
             // Spot + funding synthetic methods
+            void refresh_funding_curve(size_t pair, Timestamp now);
+            void refresh_due_curves(Timestamp now);
+            void scan_basis(const MarketSnapshot &snapshot);
             std::vector<ArbitrageOpportunity> identify_spot_funding_opportunities(const MarketSnapshot &snapshot);
-            ArbitrageOpportunity create_synthetic_perpetual_opportunity(
-                const InstrumentId &spot_instrument,
-                const InstrumentId &perpetual_instrument,
-                const MarketSnapshot &snapshot);
-            double calculate_synthetic_perpetual_fair_value(
-                const Quote &spot_quote,
-                const FundingRate &funding_rate);
-            double calculate_funding_arbitrage_profit(
-                const Quote &spot_quote,
-                const Quote &perpetual_quote,
-                const FundingRate &funding_rate);
-            bool is_profitable_funding_arbitrage(
-                double profit_percentage,
-                double funding_cost,
-                double transaction_cost);
-            std::vector<ArbitrageLeg> construct_spot_funding_legs(
-                const InstrumentId &spot_instrument,
-                const InstrumentId &perpetual_instrument,
-                const MarketSnapshot &snapshot);
+            bool create_synthetic_perpetual_opportunity(
+                size_t pair,
+                bool cash_and_carry,
+                double edge,
+                const MarketSnapshot &snapshot,
+                ArbitrageOpportunity &opportunity);
+            double calculate_synthetic_perpetual_fair_value(size_t pair, const MarketSnapshot &snapshot) const;
+            LegVector construct_spot_funding_legs(
+                size_t pair,
+                bool cash_and_carry,
+                const MarketSnapshot &snapshot,
+                Volume size) const;
 
         public:
             SpotFundingSyntheticPerpetualEngine(
@@ -316,72 +619,91 @@ namespace spe
             void update_parameters(const ArbitrageParameters &params) override;
 
             std::vector<ArbitrageOpportunity> get_active_opportunities() const override;
+            void visit_active_opportunities(const OpportunityVisitor &visitor) const override;
             void clear_opportunities() override;
 
-            // Specific methods for spot+funding arbitrage
-            void update_funding_rate(const InstrumentId &instrument, const FundingRate &rate);
-            FundingRate get_current_funding_rate(const InstrumentId &instrument) const;
+            // Specific methods for spot+funding arbitrage; rate.timestamp is the settlement the
+            // rate applies to
+            void update_funding_rate(InstrumentHandle instrument, const FundingRate &rate);
+            void update_mark_price(InstrumentHandle perpetual, Price mark_price, Price index_price);
+            FundingRate get_current_funding_rate(InstrumentHandle instrument) const;
+            const FundingCurve *get_funding_curve(InstrumentHandle perpetual) const;
+            // Funding received over holding_period by a position_size (quote notional) short in
+            // the perpetual; negative when the short pays
             double calculate_expected_funding_pnl(
-                const InstrumentId &instrument,
+                InstrumentHandle instrument,
                 Volume position_size,
                 std::chrono::hours holding_period) const;
-            void add_spot_perpetual_pair(const InstrumentId &spot, const InstrumentId &perpetual);
+            void add_spot_perpetual_pair(InstrumentHandle spot, InstrumentHandle perpetual);
+
+            void set_funding_horizon(std::chrono::hours horizon);
+            void set_round_trip_cost(double cost) { round_trip_cost_ = cost; }
+            size_t pair_count() const { return pair_spots_.size(); }
+
+            // Pairs with their funding curves, then live opportunities, on the engine thread.
+            // Pairs in the checkpoint are added if missing; restored opportunities count as
+            // reported, so they are not raised a second time.
+            static constexpr uint32_t CHECKPOINT_TAG = checkpoint::make_tag('S', 'F', 'S', 'P');
+            static constexpr uint32_t CHECKPOINT_VERSION = 1;
+            void save_state(checkpoint::CheckpointWriter &out) const;
+            bool restore_state(checkpoint::SectionReader &in);
         };
 
-        // Cross-Exchange Synthetic Replication Engine
+        // Cross-Exchange Synthetic Replication Engine. Venue quotes and each venue's synthetic
+        // replications live in a VenuePriceMatrix, which the cross-exchange price comparator
+        // can share; a detection pass reprices only the synthetics whose component quotes moved
+        // and finds the best venues for every instrument in one batch scan.
         class CrossExchangeSyntheticReplicationEngine : public IArbitrageEngine
         {
         private:
             ArbitrageParameters params_;
             std::unique_ptr<IPricingModel> pricing_model_;
-            std::vector<ArbitrageOpportunity> active_opportunities_;
+            OpportunityBook active_opportunities_;
 
-            // Multi-exchange data
-            std::map<std::string, MarketSnapshot> exchange_snapshots_;
-            std::map<std::string, double> exchange_transaction_costs_;
-            std::map<std::string, double> exchange_latencies_;
+            std::shared_ptr<VenuePriceMatrix> price_matrix_;
+            std::map<InstrumentHandle, std::vector<std::string>> instrument_exchange_mapping_;
 
-            // Synthetic replication tracking
-            std::map<InstrumentId, std::vector<std::string>> instrument_exchange_mapping_;
-            std::map<std::pair<InstrumentId, std::string>, SyntheticPrice> synthetic_price_cache_;
+            // Reported opportunity per instrument and direction (0: sell direct, buy replica),
+            // so one that stays open is not reported again while it is live
+            std::vector<std::array<OpportunityId, 2>> reported_;
 
             ArbitrageCallback opportunity_callback_;
             ArbitrageUpdateCallback update_callback_;
 
             // Cross-exchange synthetic methods
             std::vector<ArbitrageOpportunity> identify_cross_exchange_synthetic_opportunities();
-            ArbitrageOpportunity create_cross_exchange_replication_opportunity(
-                const InstrumentId &target_instrument,
-                const std::string &target_exchange,
-                const std::string &replication_exchange,
-                const MarketSnapshot &target_snapshot,
-                const MarketSnapshot &replication_snapshot);
-            SyntheticPrice calculate_cross_exchange_synthetic_price(
-                const InstrumentId &instrument,
-                const std::string &exchange_id,
-                const MarketSnapshot &snapshot);
+            void refresh_synthetic_prices() const; // the matrix is shared, not owned state
+            bool create_cross_exchange_replication_opportunity(
+                InstrumentHandle target_instrument,
+                VenueIndex target_exchange,
+                VenueIndex replication_exchange,
+                bool sell_target,
+                ArbitrageOpportunity &opportunity) const;
             double calculate_cross_exchange_arbitrage_profit(
                 const SyntheticPrice &target_price,
                 const SyntheticPrice &synthetic_price,
-                const std::string &target_exchange,
-                const std::string &synthetic_exchange);
-            std::vector<ArbitrageLeg> construct_cross_exchange_legs(
-                const InstrumentId &target_instrument,
-                const std::string &target_exchange,
-                const std::vector<InstrumentId> &synthetic_components,
-                const std::string &synthetic_exchange,
-                const std::vector<double> &weights);
+                VenueIndex target_exchange,
+                VenueIndex synthetic_exchange) const;
+            LegVector construct_cross_exchange_legs(
+                InstrumentHandle target_instrument,
+                VenueIndex target_exchange,
+                const std::vector<InstrumentHandle> &synthetic_components,
+                VenueIndex synthetic_exchange,
+                const std::vector<double> &weights,
+                bool sell_target,
+                Volume size) const;
             bool validate_cross_exchange_execution(
-                const ArbitrageOpportunity &opportunity);
+                const ArbitrageOpportunity &opportunity) const;
             double estimate_cross_exchange_latency_risk(
-                const std::string &exchange1,
-                const std::string &exchange2);
+                VenueIndex exchange1,
+                VenueIndex exchange2) const;
 
         public:
             CrossExchangeSyntheticReplicationEngine( //manages cross-exchange synthetic replication opportunities
                 std::unique_ptr<IPricingModel> model,
                 const ArbitrageParameters &params = ArbitrageParameters{});
 
+            // Venue data arrives through update_exchange_snapshot(); this runs a detection pass
             void update_market_data(const MarketSnapshot &snapshot) override;
             void process_mispricing(const MispricingOpportunity &mispricing) override;
             std::vector<ArbitrageOpportunity> identify_opportunities() override;
@@ -393,76 +715,151 @@ namespace spe
 
             std::vector<ArbitrageOpportunity> get_active_opportunities() const override;
             void clear_opportunities() override;
+            void visit_active_opportunities(const OpportunityVisitor &visitor) const override;
 
             // Specific methods for cross-exchange replication
             void register_exchange(const std::string &exchange_id, double transaction_cost, double latency_ms);
             void update_exchange_snapshot(const std::string &exchange_id, const MarketSnapshot &snapshot);
-            void add_instrument_to_exchange(const InstrumentId &instrument, const std::string &exchange_id);
-            std::vector<std::string> get_available_exchanges_for_instrument(const InstrumentId &instrument) const;
+            void add_instrument_to_exchange(InstrumentHandle instrument, const std::string &exchange_id);
+            std::vector<std::string> get_available_exchanges_for_instrument(InstrumentHandle instrument) const;
+            // Components replicate the target on each venue through the pricing model
+            void set_synthetic_components(InstrumentHandle target, const std::vector<InstrumentHandle> &components);
             SyntheticPrice get_best_synthetic_replication(
-                const InstrumentId &instrument,
+                InstrumentHandle instrument,
                 const std::string &exclude_exchange = "") const;
+
+            // Shared with other cross-venue consumers on the engine thread
+            const std::shared_ptr<VenuePriceMatrix> &price_matrix() const { return price_matrix_; }
+            void set_price_matrix(std::shared_ptr<VenuePriceMatrix> matrix);
+            OpportunityBook::View opportunity_view() const { return active_opportunities_.view(); } // any thread
         };
 
         // Multi-Instrument Synthetic Combinations Engine
+        //
+        // Predefined combinations price a target as a fixed weighted basket. Dynamic targets are
+        // refit on every update: the target's correlation cluster is gathered from the shared
+        // matrix into one dense covariance block, a ridge regression of the target's price moves
+        // on the cluster's (warm-started from the previous fit) ranks the cluster, a pruned
+        // subset is refit, and the target's residual against that basket is tracked for a
+        // z-score. Targets are independent, so refits fan out over a pool in PARALLEL mode.
         class MultiInstrumentSyntheticCombinationsEngine : public IArbitrageEngine
         { // deals with comples multi-instrument synthetic combinations 
+        public:
+            static constexpr size_t DEFAULT_MAX_CLUSTER_SIZE = 50;
+            static constexpr double DEFAULT_MIN_CLUSTER_CORRELATION = 0.5;
+            static constexpr size_t CLUSTER_REFRESH_INTERVAL = 64; // updates between cluster rebuilds
+
+            // A dynamic target's current replication
+            struct CombinationFit
+            {
+                std::vector<InstrumentHandle> instruments;
+                std::vector<double> weights; // units per unit of target
+                double tracking_error = 0.0; // residual standard deviation per observation, price units
+                size_t solver_iterations = 0; // conjugate-gradient steps of the last refit
+                bool valid = false;
+            };
+
         private:
+            // Everything a dynamic target's refit reuses from one update to the next
+            struct DynamicCombination
+            {
+                InstrumentHandle target = INVALID_INSTRUMENT;
+                size_t max_instruments = 5;
+                CombinationFit fit;
+                stats::RollingStatistics residuals;
+
+                // Cluster regression, by position in correlation_clusters_[target]
+                std::vector<double> cluster_weights;
+                std::vector<double> cluster_volatilities; // price units
+                linalg::DenseMatrix covariance;           // price units
+                std::vector<double> cross;
+                double target_variance = 0.0;
+                double ridge_penalty = 0.0;
+
+                std::vector<size_t> ranking;
+                std::vector<size_t> subset;
+                linalg::DenseMatrix subset_covariance;
+                std::vector<double> subset_cross;
+                std::vector<double> subset_weights;
+                linalg::RidgeSolver solver;
+            };
+
             ArbitrageParameters params_;
             std::unique_ptr<BasketPricingModel> basket_pricing_model_;
-            std::vector<ArbitrageOpportunity> active_opportunities_;
+            OpportunityBook active_opportunities_;
+            MarketSnapshot latest_snapshot_;
 
             // Multi-instrument combinations
-            std::map<std::string, std::vector<InstrumentId>> predefined_combinations_;
+            std::map<std::string, std::vector<InstrumentHandle>> predefined_combinations_;
             std::map<std::string, std::vector<double>> combination_weights_;
-            std::map<InstrumentId, std::vector<std::string>> instrument_combination_mapping_;
+            std::map<std::string, InstrumentHandle> combination_targets_;
+            std::map<InstrumentHandle, std::vector<std::string>> instrument_combination_mapping_;
 
-            // Dynamic combination generation
-            std::map<InstrumentId, std::vector<InstrumentId>> correlation_clusters_;
-            std::map<std::pair<InstrumentId, InstrumentId>, double> correlation_matrix_;
+            // Dynamic combination generation; keys are fixed when a target is added, so refits
+            // on pool threads only write their own target's cluster
+            std::map<InstrumentHandle, std::vector<InstrumentHandle>> correlation_clusters_;
+            std::shared_ptr<const StreamingCorrelationMatrix> correlation_matrix_; // shared, read lock-free
+            std::vector<std::unique_ptr<DynamicCombination>> dynamic_combinations_;
+            std::vector<uint32_t> dynamic_index_; // dense by target handle
+            size_t max_cluster_size_;
+            double min_cluster_correlation_;
+            uint64_t update_count_;
+
+            concurrency::ExecutionMode execution_mode_;
+            std::shared_ptr<concurrency::WorkStealingPool> pool_;
+
+            // Reported once while live: by target, [0] selling the target, [1] buying it
+            std::vector<std::array<OpportunityId, 2>> reported_;
 
             ArbitrageCallback opportunity_callback_;
             ArbitrageUpdateCallback update_callback_;
 
             // Multi-instrument synthetic methods
             std::vector<ArbitrageOpportunity> identify_multi_instrument_opportunities(const MarketSnapshot &snapshot);
-            ArbitrageOpportunity create_multi_instrument_synthetic_opportunity(
+            bool create_multi_instrument_synthetic_opportunity(
                 const std::string &combination_name,
-                const InstrumentId &target_instrument,
-                const MarketSnapshot &snapshot);
-            std::vector<ArbitrageOpportunity> generate_dynamic_combinations(
-                const InstrumentId &target_instrument,
-                const MarketSnapshot &snapshot);
+                InstrumentHandle target_instrument,
+                const MarketSnapshot &snapshot,
+                ArbitrageOpportunity &opportunity);
+            bool generate_dynamic_combinations(
+                const DynamicCombination &combination,
+                const MarketSnapshot &snapshot,
+                ArbitrageOpportunity &opportunity);
+            bool build_combination_opportunity(
+                const std::vector<InstrumentHandle> &instruments,
+                const std::vector<double> &weights,
+                InstrumentHandle target_instrument,
+                Price synthetic_price,
+                double confidence,
+                const MarketSnapshot &snapshot,
+                ArbitrageOpportunity &opportunity);
             double calculate_multi_instrument_synthetic_price(
-                const std::vector<InstrumentId> &instruments,
+                const std::vector<InstrumentHandle> &instruments,
                 const std::vector<double> &weights,
-                const MarketSnapshot &snapshot);
-            std::vector<double> optimize_combination_weights(
-                const std::vector<InstrumentId> &instruments,
-                const InstrumentId &target_instrument,
-                const MarketSnapshot &snapshot);
-            std::vector<ArbitrageLeg> construct_multi_instrument_legs(
-                const std::vector<InstrumentId> &instruments,
+                const MarketSnapshot &snapshot) const;
+            void rebalance_dynamic_combination(DynamicCombination &combination, const MarketSnapshot &snapshot);
+            bool optimize_combination_weights(DynamicCombination &combination);
+            LegVector construct_multi_instrument_legs(
+                const std::vector<InstrumentHandle> &instruments,
                 const std::vector<double> &weights,
-                const InstrumentId &target_instrument,
-                const MarketSnapshot &snapshot);
+                InstrumentHandle target_instrument,
+                const MarketSnapshot &snapshot,
+                bool sell_target,
+                Volume size) const;
             bool validate_combination_quality(
-                const std::vector<InstrumentId> &instruments,
+                const std::vector<InstrumentHandle> &instruments,
                 const std::vector<double> &weights,
-                const InstrumentId &target_instrument);
-            double calculate_combination_tracking_error(
-                const std::vector<InstrumentId> &instruments,
-                const std::vector<double> &weights,
-                const InstrumentId &target_instrument);
-            std::vector<InstrumentId> find_optimal_instrument_set(
-                const InstrumentId &target_instrument,
-                size_t max_instruments = 5);
+                InstrumentHandle target_instrument) const;
+            double calculate_combination_tracking_error(const DynamicCombination &combination) const;
+            void find_optimal_instrument_set(DynamicCombination &combination) const;
+            void refresh_correlation_cluster(DynamicCombination &combination);
 
         public:
             MultiInstrumentSyntheticCombinationsEngine(
                 std::unique_ptr<BasketPricingModel> model,
                 const ArbitrageParameters &params = ArbitrageParameters{});
 
+            // Refits the dynamic targets and reports new combination opportunities
             void update_market_data(const MarketSnapshot &snapshot) override;
             void process_mispricing(const MispricingOpportunity &mispricing) override;
             std::vector<ArbitrageOpportunity> identify_opportunities() override;
@@ -474,22 +871,42 @@ namespace spe
 
             std::vector<ArbitrageOpportunity> get_active_opportunities() const override;
             void clear_opportunities() override;
+            void visit_active_opportunities(const OpportunityVisitor &visitor) const override;
 
             // Specific methods for multi-instrument combinations
+            // With a target, the combination is priced against it on every update
             void add_predefined_combination(
                 const std::string &name,
-                const std::vector<InstrumentId> &instruments,
-                const std::vector<double> &weights);
+                const std::vector<InstrumentHandle> &instruments,
+                const std::vector<double> &weights,
+                InstrumentHandle target_instrument = INVALID_INSTRUMENT);
             void remove_predefined_combination(const std::string &name);
-            std::vector<std::string> get_available_combinations_for_instrument(const InstrumentId &instrument) const;
-            void update_correlation_matrix(const MarketSnapshot &snapshot);
-            std::vector<InstrumentId> get_highly_correlated_instruments(
-                const InstrumentId &target_instrument,
+            std::vector<std::string> get_available_combinations_for_instrument(InstrumentHandle instrument) const;
+            void set_correlation_matrix(std::shared_ptr<const StreamingCorrelationMatrix> matrix)
+            {
+                correlation_matrix_ = std::move(matrix);
+                if (basket_pricing_model_)
+                {
+                    basket_pricing_model_->set_correlation_matrix(correlation_matrix_);
+                }
+            }
+            std::vector<InstrumentHandle> get_highly_correlated_instruments(
+                InstrumentHandle target_instrument,
                 double min_correlation = 0.7) const;
             double calculate_combination_efficiency(
-                const std::vector<InstrumentId> &instruments,
+                const std::vector<InstrumentHandle> &instruments,
                 const std::vector<double> &weights,
-                const InstrumentId &target_instrument) const;
+                InstrumentHandle target_instrument) const;
+
+            // Replicate the target from at most max_instruments of its correlation cluster
+            void add_dynamic_target(InstrumentHandle target_instrument, size_t max_instruments = 5);
+            void remove_dynamic_target(InstrumentHandle target_instrument);
+            const CombinationFit *get_dynamic_combination(InstrumentHandle target_instrument) const;
+            // Clusters hold up to max_size instruments with |correlation| >= min_correlation
+            void set_cluster_limits(size_t max_size, double min_correlation);
+            void set_execution_mode(concurrency::ExecutionMode mode,
+                                    std::shared_ptr<concurrency::WorkStealingPool> pool = nullptr);
+            OpportunityBook::View opportunity_view() const { return active_opportunities_.view(); } // any thread
         };
 
         // Comprehensive Enhanced Arbitrage Engine
@@ -503,6 +920,9 @@ namespace spe
             std::unique_ptr<CrossExchangeSyntheticReplicationEngine> cross_exchange_engine_;
             std::unique_ptr<MultiInstrumentSyntheticCombinationsEngine> multi_instrument_engine_;
 
+            // Single writer: updated once per snapshot here and shared read-only with the sub-engines
+            std::shared_ptr<StreamingCorrelationMatrix> correlation_matrix_;
+
             ArbitrageParameters params_;
             ArbitrageCallback opportunity_callback_;
             ArbitrageUpdateCallback update_callback_;
@@ -538,13 +958,14 @@ namespace spe
             double get_total_expected_profit() const;
             double get_total_capital_required() const;
             std::vector<ArbitrageOpportunity> get_top_opportunities(size_t count = 10) const;
+            std::shared_ptr<const StreamingCorrelationMatrix> get_correlation_matrix() const { return correlation_matrix_; }
 
             // Configuration
             void enable_engine_type(ArbitrageType type, bool enabled);
-            void configure_spot_funding_pairs(const std::vector<std::pair<InstrumentId, InstrumentId>> &pairs);
-            void configure_cross_exchange_instruments(const std::map<InstrumentId, std::vector<std::string>> &mapping);
+            void configure_spot_funding_pairs(const std::vector<std::pair<InstrumentHandle, InstrumentHandle>> &pairs);
+            void configure_cross_exchange_instruments(const std::map<InstrumentHandle, std::vector<std::string>> &mapping);
             void configure_multi_instrument_combinations(
-                const std::map<std::string, std::vector<InstrumentId>> &combinations);
+                const std::map<std::string, std::vector<InstrumentHandle>> &combinations);
         };
 
     } // namespace arbitrage
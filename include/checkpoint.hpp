@@ -0,0 +1,341 @@
+#pragma once
+
+#include "market_data.hpp"
+#include "rolling_window.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace spe
+{
+    namespace checkpoint
+    {
+
+        using market_data::InstrumentHandle;
+        using market_data::INVALID_INSTRUMENT;
+        using market_data::Timestamp;
+
+        // Warm state of the detectors and engines (rolling windows, correlation sums, funding
+        // curves, live opportunities), so a restart resumes with full windows instead of waiting
+        // out min_observation_window samples. A checkpoint file is a 64-byte header followed by
+        // sections, each a SectionHeader and its payload. The first section is the symbol table:
+        // as in the journal, instruments are numbered per file and mapped back to this process's
+        // handles on restore. A checksum over everything after the header rejects a torn or
+        // corrupted file as a whole.
+        //
+        // Sections are tagged per component and versioned separately, so a component can change
+        // its layout without invalidating the others; a section nobody restores, or one at a
+        // version its component no longer reads, is skipped and that component starts cold.
+        constexpr uint32_t make_tag(char a, char b, char c, char d)
+        {
+            return static_cast<uint32_t>(static_cast<unsigned char>(a)) |
+                   (static_cast<uint32_t>(static_cast<unsigned char>(b)) << 8) |
+                   (static_cast<uint32_t>(static_cast<unsigned char>(c)) << 16) |
+                   (static_cast<uint32_t>(static_cast<unsigned char>(d)) << 24);
+        }
+
+        constexpr uint32_t SYMBOL_TABLE_TAG = make_tag('S', 'Y', 'M', 'S');
+
+        struct CheckpointFileHeader
+        {
+            static constexpr char MAGIC[8] = {'S', 'P', 'E', 'C', 'K', 'P', 'T', '\0'};
+            static constexpr uint32_t VERSION = 1;
+
+            char magic[8];
+            uint32_t version;
+            uint32_t section_count; // the symbol table included
+            uint64_t created_ns;    // Timestamp since its clock's epoch
+            uint64_t payload_bytes; // everything after the header
+            uint64_t checksum;      // FNV-1a over the payload
+            uint64_t reserved[3];
+        };
+        static_assert(sizeof(CheckpointFileHeader) == 64, "checkpoint header is fixed at 64 bytes");
+
+        struct SectionHeader
+        {
+            uint32_t tag;
+            uint32_t version;
+            uint64_t length; // payload bytes after this header
+        };
+        static_assert(sizeof(SectionHeader) == 16, "section headers are fixed at 16 bytes");
+
+        uint64_t checksum(const unsigned char *data, size_t size);
+
+        // Builds a checkpoint image in memory; values are stored in host byte order. Sections
+        // are written between begin_section and end_section, and finish() puts the symbol table
+        // in front, so save hooks never look symbols up.
+        class CheckpointWriter
+        {
+        private:
+            std::vector<unsigned char> body_;           // sections after the symbol table
+            std::vector<uint32_t> local_ids_;           // dense by handle
+            std::vector<InstrumentHandle> instruments_; // local id -> handle
+            size_t section_start_;
+            uint32_t section_count_;
+            Timestamp created_;
+
+            void append(const void *data, size_t size)
+            {
+                const unsigned char *bytes = static_cast<const unsigned char *>(data);
+                body_.insert(body_.end(), bytes, bytes + size);
+            }
+
+        public:
+            CheckpointWriter();
+
+            void clear(); // keeps the buffers
+            void set_created(Timestamp created) { created_ = created; }
+            Timestamp created() const { return created_; }
+
+            void begin_section(uint32_t tag, uint32_t version);
+            void end_section();
+
+            template <typename T>
+            void put(const T &value)
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "only plain values are written directly");
+                append(&value, sizeof(T));
+            }
+
+            void put_count(size_t count) { put(static_cast<uint64_t>(count)); }
+            void put_doubles(const double *values, size_t count) { append(values, count * sizeof(double)); }
+            void put_instrument(InstrumentHandle instrument);
+            void put_time(Timestamp time);
+            // Window oldest first, then the EWMA; restored into the reader's window capacity
+            void put_rolling(const stats::RollingStatistics &statistics);
+
+            // The whole file: header, symbol table and sections. Any thread; symbols are read
+            // from the registry here.
+            std::vector<unsigned char> finish() const;
+
+            size_t size() const { return body_.size(); }
+            uint32_t section_count() const { return section_count_; }
+        };
+
+        // One section of a loaded checkpoint. Reads past the end, or counts the remaining bytes
+        // cannot hold, fail and stay failed, so a restore hook may read a whole record and
+        // check ok() once before applying it.
+        class SectionReader
+        {
+        private:
+            const unsigned char *data_;
+            size_t size_;
+            size_t offset_;
+            uint32_t version_;
+            const std::vector<InstrumentHandle> *instruments_;
+            std::vector<double> scratch_;
+            bool ok_;
+
+            bool take(void *out, size_t size)
+            {
+                if (!ok_ || size > size_ - offset_)
+                {
+                    ok_ = false;
+                    std::memset(out, 0, size);
+                    return false;
+                }
+                std::memcpy(out, data_ + offset_, size);
+                offset_ += size;
+                return true;
+            }
+
+        public:
+            SectionReader() : data_(nullptr), size_(0), offset_(0), version_(0), instruments_(nullptr), ok_(false) {}
+            SectionReader(const unsigned char *data, size_t size, uint32_t version,
+                          const std::vector<InstrumentHandle> *instruments)
+                : data_(data), size_(size), offset_(0), version_(version), instruments_(instruments), ok_(true) {}
+
+            template <typename T>
+            bool get(T &value)
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "only plain values are read directly");
+                return take(&value, sizeof(T));
+            }
+
+            // A record count, checked against the bytes left at min_record_bytes each
+            bool get_count(size_t &count, size_t min_record_bytes);
+            bool get_bytes(void *out, size_t size) { return take(out, size); }
+            bool get_doubles(double *values, size_t count) { return take(values, count * sizeof(double)); }
+            bool get_instrument(InstrumentHandle &instrument);
+            bool get_time(Timestamp &time);
+            bool get_rolling(stats::RollingStatistics &statistics);
+
+            uint32_t version() const { return version_; }
+            size_t remaining() const { return size_ - offset_; }
+            bool ok() const { return ok_; }
+        };
+
+        // Read-only view of one checkpoint file, memory-mapped where the platform allows. The
+        // symbol table is interned on open, so sections map instruments with a lookup.
+        class CheckpointReader
+        {
+        private:
+            struct Section
+            {
+                uint32_t tag;
+                uint32_t version;
+                size_t offset;
+                size_t length;
+            };
+
+            const unsigned char *data_;
+            size_t size_;
+            bool mapped_;
+            std::vector<unsigned char> fallback_; // whole-file copy where mmap is unavailable
+            std::vector<Section> sections_;
+            std::vector<InstrumentHandle> instruments_; // file-local id -> handle
+            std::string error_;
+
+            bool parse(const std::string &name);
+
+        public:
+            CheckpointReader();
+            ~CheckpointReader();
+
+            CheckpointReader(const CheckpointReader &) = delete;
+            CheckpointReader &operator=(const CheckpointReader &) = delete;
+
+            bool open(const std::string &path); // false with error() set on failure
+            bool open_image(std::vector<unsigned char> image);
+            void close();
+            bool is_open() const { return data_ != nullptr; }
+
+            // False when the file has no section under tag
+            bool find(uint32_t tag, SectionReader &section) const;
+
+            const CheckpointFileHeader &header() const { return *reinterpret_cast<const CheckpointFileHeader *>(data_); }
+            Timestamp created() const;
+            size_t section_count() const { return sections_.size(); }
+            size_t instrument_count() const { return instruments_.size(); }
+            const std::string &error() const { return error_; }
+        };
+
+        struct RestoreResult
+        {
+            bool loaded = false;  // the file was read and verified
+            size_t restored = 0;  // components restored from their sections
+            size_t missing = 0;   // components without a section, or at another version; cold
+            size_t failed = 0;    // sections their component rejected as malformed
+            Timestamp created{};  // when the checkpoint was taken: replay the journal from here
+            std::string error;
+        };
+
+        struct CheckpointStats
+        {
+            uint64_t captures = 0;
+            uint64_t writes = 0;
+            uint64_t failures = 0;
+            uint64_t superseded = 0; // captures replaced before the writer got to them
+            size_t last_bytes = 0;
+            std::chrono::nanoseconds last_capture_time{0}; // spent on the capturing thread
+        };
+
+        // Periodic checkpoints of components that share one updating thread. capture() runs
+        // the save hooks on that thread, between updates; a background thread assembles the
+        // file and replaces the previous one atomically (temporary file, fsync, rename), so a
+        // crash mid-write leaves the last good checkpoint. A capture made while the writer is
+        // busy replaces the one still waiting. Components on different threads (the pipeline's
+        // detector and arbitrage stages) take one Checkpointer each, with its own file.
+        //
+        // restore() belongs to the same thread, before updates start. Afterwards, replay the
+        // journal from RestoreResult::created (ReplayConfig::start_ns, restamp off) to cover
+        // the gap between the checkpoint and the restart.
+        class Checkpointer
+        {
+        public:
+            using SaveHook = std::function<void(CheckpointWriter &)>;
+            using RestoreHook = std::function<bool(SectionReader &)>;
+
+        private:
+            struct Component
+            {
+                uint32_t tag;
+                uint32_t version;
+                SaveHook save;
+                RestoreHook restore;
+            };
+
+            std::string path_;
+            std::chrono::milliseconds interval_;
+            std::vector<Component> components_;
+            Timestamp next_capture_;
+            CheckpointWriter scratch_; // capturing thread
+
+            std::mutex mutex_;
+            std::mutex file_mutex_; // the writer thread and write_now share the temporary file
+            std::condition_variable ready_;
+            CheckpointWriter pending_;
+            bool has_pending_;
+            bool stopping_;
+            std::thread writer_thread_;
+            std::string last_error_;
+
+            std::atomic<uint64_t> captures_{0};
+            std::atomic<uint64_t> writes_{0};
+            std::atomic<uint64_t> failures_{0};
+            std::atomic<uint64_t> superseded_{0};
+            std::atomic<size_t> last_bytes_{0};
+            std::atomic<int64_t> last_capture_ns_{0};
+
+            void fill(CheckpointWriter &writer, Timestamp now);
+            bool write(const CheckpointWriter &writer);
+            void write_loop();
+
+        public:
+            explicit Checkpointer(std::string path, std::chrono::milliseconds interval = std::chrono::seconds(30));
+            ~Checkpointer();
+
+            Checkpointer(const Checkpointer &) = delete;
+            Checkpointer &operator=(const Checkpointer &) = delete;
+
+            // Before start(); tags are unique within a checkpointer
+            void add(uint32_t tag, uint32_t version, SaveHook save, RestoreHook restore);
+
+            // A component with save_state/restore_state and CHECKPOINT_TAG/CHECKPOINT_VERSION;
+            // pass another tag to checkpoint two of the same kind
+            template <typename Component>
+            void add(Component &component, uint32_t tag = Component::CHECKPOINT_TAG)
+            {
+                add(tag, Component::CHECKPOINT_VERSION,
+                    [&component](CheckpointWriter &out) { component.save_state(out); },
+                    [&component](SectionReader &in) { return component.restore_state(in); });
+            }
+
+            void start();
+            void stop(); // writes a capture still waiting
+
+            // Captures when interval has passed since the last one; cheap otherwise
+            bool maybe_capture(Timestamp now)
+            {
+                if (now < next_capture_)
+                {
+                    return false;
+                }
+                capture(now);
+                return true;
+            }
+            void capture(Timestamp now);
+            // Captures and writes on the calling thread, e.g. at shutdown
+            bool write_now(Timestamp now);
+
+            RestoreResult restore();
+
+            const std::string &path() const { return path_; }
+            CheckpointStats stats() const;
+            std::string last_error();
+
+            // Replaces path with image via a temporary file; false with error set on failure
+            static bool write_file(const std::string &path, const std::vector<unsigned char> &image, std::string &error);
+        };
+
+    } // namespace checkpoint
+} // namespace spe
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "market_data.hpp"
+#include "checkpoint.hpp"
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace spe
+{
+    namespace stats
+    {
+
+        using market_data::InstrumentHandle;
+        using market_data::MarketSnapshot;
+
+        // Exponentially weighted covariance/correlation over instrument handles, shared by
+        // every engine that needs pairwise correlations. Storage is a packed upper-triangular
+        // dense matrix. Each return observation is a rank-1 update; instruments that did not
+        // move contribute a zero return, so with a global decay scale only the k x k block of
+        // moved instruments is touched per tick.
+        //
+        // One writer thread calls update()/add_observation(); any number of readers call the
+        // const accessors concurrently without locking (seqlock, readers retry on overlap).
+        class StreamingCorrelationMatrix
+        {
+        private:
+            size_t dimension_;
+            double decay_;
+
+            // Decayed sums stored divided by scale_, so decaying is a single multiply
+            std::unique_ptr<std::atomic<double>[]> cross_sums_; // packed sum of r_i * r_j
+            std::unique_ptr<std::atomic<double>[]> sums_;       // sum of r_i
+            std::atomic<double> weight_;                        // sum of decay weights
+            std::atomic<double> scale_;
+            std::atomic<uint64_t> observations_;
+            std::atomic<uint64_t> sequence_;
+
+            // Writer-only state
+            std::vector<double> last_prices_;
+            std::vector<std::pair<InstrumentHandle, double>> scratch_returns_;
+
+            size_t packed_index(InstrumentHandle a, InstrumentHandle b) const
+            {
+                if (a > b)
+                {
+                    std::swap(a, b);
+                }
+                return static_cast<size_t>(a) * dimension_ - static_cast<size_t>(a) * (a - 1) / 2 + (b - a);
+            }
+
+            // Everything needed for one pair, read as a consistent set
+            struct PairMoments
+            {
+                double cross_ab;
+                double cross_aa;
+                double cross_bb;
+                double sum_a;
+                double sum_b;
+                double weight;
+            };
+
+            void rescale();
+            PairMoments read_pair(InstrumentHandle a, InstrumentHandle b) const;
+
+        public:
+            explicit StreamingCorrelationMatrix(size_t max_instruments, double decay = 0.97);
+
+            // Writer: derives log returns for the snapshot's dirty instruments and applies them
+            void update(const MarketSnapshot &snapshot);
+
+            // Writer: one observation of a sparse return vector (absent instruments returned 0)
+            void add_observation(const std::vector<std::pair<InstrumentHandle, double>> &returns);
+
+            // Readers
+            double covariance(InstrumentHandle a, InstrumentHandle b) const;
+            double variance(InstrumentHandle instrument) const { return covariance(instrument, instrument); }
+            double correlation(InstrumentHandle a, InstrumentHandle b) const;
+
+            // Writer: the decayed sums of instruments with a price, remapped by symbol on
+            // restore. Their last prices come along, so the first return after a restart spans
+            // the gap; instruments beyond this matrix's dimension are dropped.
+            static constexpr uint32_t CHECKPOINT_TAG = checkpoint::make_tag('C', 'O', 'R', 'R');
+            static constexpr uint32_t CHECKPOINT_VERSION = 1;
+            void save_state(checkpoint::CheckpointWriter &out) const;
+            bool restore_state(checkpoint::SectionReader &in);
+
+            size_t dimension() const { return dimension_; }
+            uint64_t observation_count() const { return observations_.load(std::memory_order_acquire); }
+            bool contains(InstrumentHandle instrument) const { return instrument < dimension_; }
+        };
+
+    } // namespace stats
+} // namespace spe
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "market_data.hpp"
+#include "instrument_registry.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace spe
+{
+    namespace graph
+    {
+
+        using namespace market_data;
+
+        // Directed conversion graph over currencies. Every spot pair BASE-QUOTE contributes two
+        // edges: BASE->QUOTE (sell base at the bid, weight log(bid)) and QUOTE->BASE (buy base
+        // at the ask, weight -log(ask)). A cycle is profitable when its summed log rate, net of
+        // fees, is above the threshold.
+        //
+        // build() enumerates every 3-cycle (and, optionally, 4-cycle) once and indexes cycles by
+        // edge. A quote then only touches the two edges of its pair, and evaluate_touched()
+        // re-scores just the cycles through edges updated since the last call.
+        class CurrencyGraph
+        {
+        public:
+            static constexpr size_t MAX_CYCLE_LENGTH = 4;
+
+            struct Edge
+            {
+                InstrumentHandle instrument;
+                uint32_t from;
+                uint32_t to;
+                Side side; // leg on the pair: BID buys base (QUOTE->BASE), ASK sells it (BASE->QUOTE)
+            };
+
+            struct Cycle
+            {
+                uint32_t edges[MAX_CYCLE_LENGTH];
+                uint32_t length;
+            };
+
+        private:
+            bool include_four_cycles_;
+            double fee_log_; // log(1 - fee) per conversion
+            double min_log_return_;
+
+            std::unordered_map<std::string, uint32_t> currency_ids_;
+            std::vector<std::string> currency_names_;
+
+            // Pairs, indexed by pair id; edge 2p is BASE->QUOTE and 2p+1 is QUOTE->BASE
+            std::vector<InstrumentHandle> pair_instruments_;
+            std::vector<uint32_t> pair_by_instrument_; // dense by handle; NO_PAIR if not a pair
+            std::vector<Edge> edges_;
+            std::vector<double> edge_log_rates_;
+            std::vector<Price> edge_prices_;
+            std::vector<std::vector<uint32_t>> out_edges_; // by currency
+
+            // Cycles and the edge -> cycle index (CSR)
+            std::vector<Cycle> cycles_;
+            std::vector<uint32_t> edge_cycle_offsets_;
+            std::vector<uint32_t> edge_cycle_ids_;
+
+            // Incremental evaluation
+            std::vector<double> cycle_log_returns_;
+            std::vector<uint32_t> cycle_epochs_;
+            std::vector<uint32_t> touched_pairs_;
+            std::vector<uint8_t> pair_touched_;
+            uint32_t epoch_;
+
+            // Profitable set, kept dense for iteration
+            std::vector<uint32_t> profitable_;
+            std::vector<uint32_t> profitable_position_;
+
+            static constexpr uint32_t NO_PAIR = UINT32_MAX;
+            static constexpr uint32_t NOT_PROFITABLE = UINT32_MAX;
+
+            uint32_t intern_currency(const std::string &currency);
+            double score_cycle(const Cycle &cycle) const;
+            void set_profitable(uint32_t cycle, bool profitable);
+
+        public:
+            explicit CurrencyGraph(bool include_four_cycles = false, double fee_rate = 0.0,
+                                   double min_return = 0.0);
+
+            // Configuration; call build() after changing the pairs
+            bool add_pair(InstrumentHandle instrument, const std::string &base, const std::string &quote);
+            bool add_pair(InstrumentHandle instrument); // parses "BASE-QUOTE" or "BASE/QUOTE"
+            size_t discover_pairs(const InstrumentRegistry &registry);
+            void build();
+            void clear();
+
+            void set_include_four_cycles(bool include) { include_four_cycles_ = include; }
+            void set_fee_rate(double fee_rate);
+            void set_min_return(double min_return); // fractional, e.g. 0.001 for 10 bp
+
+            // Updates both edges of a pair; false if the instrument is not part of the graph
+            bool update_quote(InstrumentHandle instrument, Price bid, Price ask);
+            // update_quote for every dirty (or, with full, every quoted) instrument
+            void apply_snapshot(const MarketSnapshot &snapshot, bool full = false);
+
+            // Re-scores cycles through pairs updated since the last call and calls
+            // visitor(cycle_id, log_return, newly_profitable) for each that is now profitable
+            template <typename Visitor>
+            void evaluate_touched(Visitor &&visitor)
+            {
+                if (++epoch_ == 0)
+                {
+                    std::fill(cycle_epochs_.begin(), cycle_epochs_.end(), 0);
+                    epoch_ = 1;
+                }
+                for (uint32_t pair : touched_pairs_)
+                {
+                    pair_touched_[pair] = 0;
+                    for (uint32_t edge = 2 * pair; edge < 2 * pair + 2; ++edge)
+                    {
+                        if (edge + 1 >= edge_cycle_offsets_.size())
+                        {
+                            continue; // added since the last build(); in no cycle yet
+                        }
+                        for (uint32_t i = edge_cycle_offsets_[edge]; i < edge_cycle_offsets_[edge + 1]; ++i)
+                        {
+                            uint32_t cycle = edge_cycle_ids_[i];
+                            if (cycle_epochs_[cycle] == epoch_)
+                            {
+                                continue;
+                            }
+                            cycle_epochs_[cycle] = epoch_;
+
+                            double log_return = score_cycle(cycles_[cycle]);
+                            cycle_log_returns_[cycle] = log_return;
+                            bool was_profitable = profitable_position_[cycle] != NOT_PROFITABLE;
+                            bool profitable = log_return > min_log_return_;
+                            set_profitable(cycle, profitable);
+                            if (profitable)
+                            {
+                                visitor(cycle, log_return, !was_profitable);
+                            }
+                        }
+                    }
+                }
+                touched_pairs_.clear();
+            }
+
+            const std::vector<uint32_t> &profitable_cycles() const { return profitable_; }
+            double cycle_log_return(uint32_t cycle) const { return cycle_log_returns_[cycle]; }
+
+            const Cycle &cycle(uint32_t id) const { return cycles_[id]; }
+            const Edge &edge(uint32_t id) const { return edges_[id]; }
+            Price edge_price(uint32_t id) const { return edge_prices_[id]; }
+            const std::string &currency_name(uint32_t id) const { return currency_names_[id]; }
+
+            size_t currency_count() const { return currency_names_.size(); }
+            size_t pair_count() const { return pair_instruments_.size(); }
+            size_t cycle_count() const { return cycles_.size(); }
+            bool has_pair(InstrumentHandle instrument) const
+            {
+                return instrument < pair_by_instrument_.size() && pair_by_instrument_[instrument] != NO_PAIR;
+            }
+
+            static bool split_pair_symbol(const std::string &symbol, std::string &base, std::string &quote);
+        };
+
+    } // namespace graph
+} // namespace spe
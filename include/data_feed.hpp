@@ -7,6 +7,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <queue>
+#include <set>
 
 namespace spe {
 namespace data_feed {
@@ -35,11 +36,11 @@ public:
     virtual void disconnect() = 0;
     virtual FeedStatus get_status() const = 0;
     
-    // Subscription management
+    // Subscription management (symbols are interned into handles here)
     virtual bool subscribe_quotes(const std::vector<InstrumentId>& instruments) = 0;
     virtual bool subscribe_trades(const std::vector<InstrumentId>& instruments) = 0;
     virtual bool subscribe_depth(const std::vector<InstrumentId>& instruments) = 0;
-    virtual bool unsubscribe(const InstrumentId& instrument) = 0;
+    virtual bool unsubscribe(InstrumentHandle instrument) = 0;
     
     // Callback registration
     virtual void set_quote_callback(QuoteCallback callback) = 0;
@@ -48,9 +49,9 @@ public:
     virtual void set_error_callback(ErrorCallback callback) = 0;
     
     // Data retrieval
-    virtual Quote get_latest_quote(const InstrumentId& instrument) const = 0;
-    virtual std::vector<Trade> get_recent_trades(const InstrumentId& instrument, size_t count = 100) const = 0;
-    virtual MarketDepth get_market_depth(const InstrumentId& instrument) const = 0;
+    virtual Quote get_latest_quote(InstrumentHandle instrument) const = 0;
+    virtual std::vector<Trade> get_recent_trades(InstrumentHandle instrument, size_t count = 100) const = 0;
+    virtual MarketDepth get_market_depth(InstrumentHandle instrument) const = 0;
 };
 
 class SimulatedDataFeed : public IDataFeed {
@@ -67,17 +68,17 @@ private:
     
     // Data storage
     mutable std::mutex data_mutex_;
-    std::map<InstrumentId, Quote> latest_quotes_;
-    std::map<InstrumentId, std::queue<Trade>> trade_history_;
-    std::map<InstrumentId, MarketDepth> market_depths_;
+    std::map<InstrumentHandle, Quote> latest_quotes_;
+    std::map<InstrumentHandle, std::queue<Trade>> trade_history_;
+    std::map<InstrumentHandle, MarketDepth> market_depths_;
     
     // Subscriptions
-    std::set<InstrumentId> subscribed_instruments_;
+    std::set<InstrumentHandle> subscribed_instruments_;
     
     void feed_loop();
     void generate_sample_data();
-    Quote generate_quote(const InstrumentId& instrument_id);
-    Trade generate_trade(const InstrumentId& instrument_id);
+    Quote generate_quote(InstrumentHandle instrument);
+    Trade generate_trade(InstrumentHandle instrument);
     
 public:
     SimulatedDataFeed();
@@ -91,16 +92,16 @@ public:
     bool subscribe_quotes(const std::vector<InstrumentId>& instruments) override;
     bool subscribe_trades(const std::vector<InstrumentId>& instruments) override;
     bool subscribe_depth(const std::vector<InstrumentId>& instruments) override;
-    bool unsubscribe(const InstrumentId& instrument) override;
+    bool unsubscribe(InstrumentHandle instrument) override;
     
     void set_quote_callback(QuoteCallback callback) override;
     void set_trade_callback(TradeCallback callback) override;
     void set_depth_callback(DepthCallback callback) override;
     void set_error_callback(ErrorCallback callback) override;
     
-    Quote get_latest_quote(const InstrumentId& instrument) const override;
-    std::vector<Trade> get_recent_trades(const InstrumentId& instrument, size_t count = 100) const override;
-    MarketDepth get_market_depth(const InstrumentId& instrument) const override;
+    Quote get_latest_quote(InstrumentHandle instrument) const override;
+    std::vector<Trade> get_recent_trades(InstrumentHandle instrument, size_t count = 100) const override;
+    MarketDepth get_market_depth(InstrumentHandle instrument) const override;
 };
 
 } // namespace data_feed
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace spe
+{
+    namespace concurrency
+    {
+
+        // Two copies of T; readers always see a complete one without taking a lock. A writer
+        // rebuilds the inactive copy (starting from the active one) and flips the index. Each
+        // copy counts its readers so a rebuild never overwrites a copy that is still being read;
+        // readers that race a flip retry on the new copy.
+        //
+        // Reads should be short (copy out what is needed); writers are serialized and wait for
+        // stragglers on the copy they are about to reuse.
+        template <typename T>
+        class DoubleBuffered
+        {
+        private:
+            T buffers_[2];
+            std::atomic<int> active_;
+            mutable std::atomic<int> readers_[2];
+            std::atomic<uint64_t> version_;
+            std::mutex writer_mutex_;
+
+        public:
+            DoubleBuffered() : active_(0), version_(0)
+            {
+                readers_[0].store(0);
+                readers_[1].store(0);
+            }
+
+            DoubleBuffered(const DoubleBuffered &) = delete;
+            DoubleBuffered &operator=(const DoubleBuffered &) = delete;
+
+            // Calls reader(const T&) against the current copy and returns its result
+            template <typename Reader>
+            auto read(Reader &&reader) const -> decltype(reader(std::declval<const T &>()))
+            {
+                for (;;)
+                {
+                    int index = active_.load();
+                    readers_[index].fetch_add(1);
+                    if (active_.load() == index)
+                    {
+                        struct Release
+                        {
+                            std::atomic<int> &count;
+                            ~Release() { count.fetch_sub(1, std::memory_order_release); }
+                        } release{readers_[index]};
+                        return reader(buffers_[index]);
+                    }
+                    readers_[index].fetch_sub(1, std::memory_order_release);
+                }
+            }
+
+            // Copies the active value into the spare slot, applies writer(T&) and publishes it
+            template <typename Writer>
+            void update(Writer &&writer)
+            {
+                std::lock_guard<std::mutex> lock(writer_mutex_);
+                int current = active_.load();
+                int spare = 1 - current;
+                while (readers_[spare].load() != 0)
+                {
+                    std::this_thread::yield();
+                }
+
+                buffers_[spare] = buffers_[current];
+                writer(buffers_[spare]);
+                active_.store(spare);
+                version_.fetch_add(1, std::memory_order_release);
+            }
+
+            // Bumped on every publish; lets readers cache derived data per version
+            uint64_t version() const { return version_.load(std::memory_order_acquire); }
+        };
+
+    } // namespace concurrency
+} // namespace spe
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "lockfree_queue.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <thread>
+
+namespace spe
+{
+    namespace concurrency
+    {
+
+        // Epoch-based reclamation for one writer and any number of readers. A reader pins the
+        // current epoch for as long as it dereferences shared nodes; the writer unlinks a node,
+        // tags it with retire_epoch() and advances the epoch, and may free it once
+        // oldest_pinned() is past the tag. Pinning is a CAS on the reader's own cache line, so
+        // readers never wait for each other or for the writer.
+        class EpochDomain
+        {
+        public:
+            static constexpr size_t MAX_READERS = 64; // concurrently pinned; further readers spin
+            static constexpr uint64_t IDLE = 0;
+
+        private:
+            struct alignas(CACHE_LINE_SIZE) ReaderSlot
+            {
+                std::atomic<uint64_t> epoch{IDLE};
+            };
+
+            mutable std::array<ReaderSlot, MAX_READERS> readers_;
+            std::atomic<uint64_t> epoch_;
+
+        public:
+            // Keeps its epoch pinned until destroyed
+            class Guard
+            {
+            private:
+                std::atomic<uint64_t> *slot_;
+
+            public:
+                explicit Guard(std::atomic<uint64_t> *slot) : slot_(slot) {}
+                Guard(Guard &&other) noexcept : slot_(other.slot_) { other.slot_ = nullptr; }
+                Guard(const Guard &) = delete;
+                Guard &operator=(const Guard &) = delete;
+                Guard &operator=(Guard &&) = delete;
+                ~Guard()
+                {
+                    if (slot_)
+                    {
+                        slot_->store(IDLE, std::memory_order_release);
+                    }
+                }
+            };
+
+            EpochDomain() : epoch_(1) {}
+            EpochDomain(const EpochDomain &) = delete;
+            EpochDomain &operator=(const EpochDomain &) = delete;
+
+            // Load shared pointers only after pinning
+            Guard pin() const
+            {
+                size_t start = std::hash<std::thread::id>()(std::this_thread::get_id()) % MAX_READERS;
+                for (;;)
+                {
+                    for (size_t i = 0; i < MAX_READERS; ++i)
+                    {
+                        auto &slot = readers_[(start + i) % MAX_READERS].epoch;
+                        uint64_t idle = IDLE;
+                        if (slot.load(std::memory_order_relaxed) == IDLE &&
+                            slot.compare_exchange_strong(idle, epoch_.load()))
+                        {
+                            return Guard(&slot);
+                        }
+                    }
+                    std::this_thread::yield();
+                }
+            }
+
+            // Writer: tag for nodes unlinked since the last advance()
+            uint64_t retire_epoch() const { return epoch_.load(); }
+            void advance() { epoch_.fetch_add(1); }
+
+            // Nodes tagged below this are unreachable by every reader
+            uint64_t oldest_pinned() const
+            {
+                uint64_t oldest = std::numeric_limits<uint64_t>::max();
+                for (const auto &reader : readers_)
+                {
+                    uint64_t epoch = reader.epoch.load();
+                    if (epoch != IDLE && epoch < oldest)
+                    {
+                        oldest = epoch;
+                    }
+                }
+                return oldest;
+            }
+        };
+
+    } // namespace concurrency
+} // namespace spe
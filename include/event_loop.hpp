@@ -0,0 +1,125 @@
+#pragma once
+
+#include "thread_topology.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace spe
+{
+    namespace gateway
+    {
+
+        using Clock = std::chrono::steady_clock;
+
+        // Readiness bits passed to IoHandler and taken by watch()/modify()
+        constexpr uint32_t IO_READ = 1;
+        constexpr uint32_t IO_WRITE = 2;
+        constexpr uint32_t IO_ERROR = 4; // error or hang-up; always reported
+
+        using IoHandler = std::function<void(uint32_t events)>;
+        using LoopTask = std::function<void()>;
+
+        // Slot and generation, so a handle outliving its timer cancels nothing
+        using TimerHandle = uint64_t;
+        constexpr TimerHandle INVALID_TIMER_HANDLE = 0;
+
+        // One thread multiplexing every socket of every gateway: epoll for readiness, a
+        // deadline heap for timers and an eventfd through which other threads post work.
+        // Everything but post() and stop() runs on the loop thread (inside handlers, or
+        // before run() starts). Watches and timers live in recycled slots, and handlers
+        // removed while the loop is dispatching are destroyed only after the round, so a
+        // handler may unwatch or cancel itself. On platforms without epoll, valid() is false.
+        class EventLoop
+        {
+        private:
+            struct Watch
+            {
+                int fd = -1;
+                uint32_t generation = 0;
+                IoHandler handler;
+            };
+
+            struct Timer
+            {
+                uint32_t generation = 0;
+                bool active = false;
+                LoopTask handler;
+            };
+
+            struct Deadline
+            {
+                Clock::time_point when;
+                uint32_t slot;
+                uint32_t generation;
+
+                bool operator>(const Deadline &other) const { return when > other.when; }
+            };
+
+            int poll_fd_;
+            int wake_fd_;
+
+            std::deque<Watch> watches_; // a deque, so a handler survives watch() growing the slots
+            std::vector<uint32_t> free_watches_;
+            std::vector<uint32_t> retired_watches_; // unwatched while dispatching; freed after the round
+            std::vector<uint32_t> slot_by_fd_;
+            bool dispatching_;
+
+            std::vector<Timer> timers_;
+            std::vector<uint32_t> free_timers_;
+            std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines_;
+
+            std::mutex post_mutex_;
+            std::vector<LoopTask> posted_;
+            std::vector<LoopTask> running_; // loop thread only; swapped with posted_
+
+            std::atomic<bool> stopping_;
+
+            uint32_t find_watch(int fd) const;
+            void free_watch(uint32_t slot);
+            size_t run_posted();
+            size_t run_timers();
+
+        public:
+            EventLoop();
+            ~EventLoop();
+
+            EventLoop(const EventLoop &) = delete;
+            EventLoop &operator=(const EventLoop &) = delete;
+
+            bool valid() const { return poll_fd_ >= 0; }
+
+            // One handler per fd; false if the fd is already watched or epoll refuses it
+            bool watch(int fd, uint32_t events, IoHandler handler);
+            bool modify(int fd, uint32_t events);
+            void unwatch(int fd);
+
+            TimerHandle schedule_after(std::chrono::milliseconds delay, LoopTask handler);
+            bool cancel(TimerHandle timer); // false if it already fired or was cancelled
+
+            // Any thread; runs on the loop thread in posting order
+            void post(LoopTask task);
+
+            // Waits at most max_wait (less if a timer falls due) and runs what is ready;
+            // returns how many handlers, timers and posted tasks ran
+            size_t run_once(std::chrono::milliseconds max_wait);
+            // run_once until stop() is called; returns at once if stop() came first
+            void run();
+            // run() on the "io" stage's placement. BUSY_POLL polls epoll without blocking;
+            // SPIN_THEN_SLEEP polls for spin_iterations empty rounds before blocking; SLEEP
+            // blocks in epoll_wait, woken by readiness, timers and post()
+            void run(const concurrency::StagePlacement &placement);
+            void stop(); // any thread; holds until reset()
+            void reset(); // clears a stop() so the loop can run again
+
+            size_t watch_count() const { return watches_.size() - free_watches_.size(); }
+        };
+
+    } // namespace gateway
+} // namespace spe
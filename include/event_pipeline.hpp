@@ -0,0 +1,233 @@
+#pragma once
+
+#include "market_data.hpp"
+#include "mispricing_detector.hpp"
+#include "arbitrage_engine.hpp"
+#include "lockfree_queue.hpp"
+#include "instrument_registry.hpp"
+#include "latency_monitor.hpp"
+#include "checkpoint.hpp"
+#include "thread_topology.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+namespace spe
+{
+    namespace pipeline
+    {
+
+        using namespace market_data;
+        using mispricing::IMispricingDetector;
+        using mispricing::MispricingOpportunity;
+        using arbitrage::ArbitrageOpportunity;
+        using arbitrage::IArbitrageEngine;
+
+        // Normalized market event as published by a feed thread
+        struct MarketEvent
+        {
+            std::variant<Quote, Trade, MarketDepth> payload;
+            Timestamp receive_time;
+
+            MarketEvent() : receive_time(std::chrono::high_resolution_clock::now()) {}
+            explicit MarketEvent(const Quote &quote) : payload(quote), receive_time(std::chrono::high_resolution_clock::now()) {}
+            explicit MarketEvent(const Trade &trade) : payload(trade), receive_time(std::chrono::high_resolution_clock::now()) {}
+            explicit MarketEvent(MarketDepth depth)
+                : payload(std::move(depth)), receive_time(std::chrono::high_resolution_clock::now()) {}
+        };
+
+        // Detector output handed to the arbitrage stage, with the quotes (and books, where the
+        // detector had them) it was derived from so the arbitrage thread never reads the
+        // detector thread's market state
+        struct DetectionEvent
+        {
+            MispricingOpportunity opportunity;
+            std::vector<Quote> quotes;
+            std::vector<MarketDepth> depths;
+            Timestamp source_time; // earliest receive time in the batch it was detected on
+        };
+
+        enum class OverflowPolicy
+        {
+            DROP_NEWEST, // count and discard; the producer never waits
+            BLOCK        // producer yields until there is room (counted as backpressure)
+        };
+
+        struct PipelineConfig
+        {
+            size_t ingress_capacity = 65536; // per producer
+            size_t shared_ingress_capacity = 65536;
+            size_t detection_capacity = 4096;
+            size_t detector_batch_size = 512;
+            size_t arbitrage_batch_size = 64;
+            OverflowPolicy ingress_policy = OverflowPolicy::BLOCK;
+            OverflowPolicy detection_policy = OverflowPolicy::DROP_NEWEST; // stale opportunities are worthless
+            concurrency::StagePlacement detector_stage; // CPUs, memory node and idle wait of each stage thread
+            concurrency::StagePlacement arbitrage_stage;
+            std::string latency_source = "pipeline"; // series name for this pipeline's stage latencies
+
+            // Takes the detector and arbitrage placements from topology
+            void place(const concurrency::ThreadTopology &topology)
+            {
+                detector_stage = topology.placement(concurrency::ThreadTopology::DETECTOR);
+                arbitrage_stage = topology.placement(concurrency::ThreadTopology::ARBITRAGE);
+            }
+        };
+
+        struct StageStatistics
+        {
+            std::string stage;
+            uint64_t enqueued = 0;
+            uint64_t dequeued = 0;
+            uint64_t dropped = 0;
+            uint64_t backpressure_waits = 0;
+            uint64_t batches = 0;
+            size_t depth = 0;
+            size_t high_watermark = 0;
+            size_t capacity = 0;
+        };
+
+        using ProducerId = size_t;
+        constexpr ProducerId INVALID_PRODUCER = std::numeric_limits<ProducerId>::max();
+
+        using ArbitrageOutputCallback = std::function<void(const std::vector<ArbitrageOpportunity> &)>;
+
+        // Staged market data pipeline:
+        //
+        //   feed threads --(SPSC per producer, or shared MPSC)--> detector thread
+        //   detector thread --(SPSC)--> arbitrage thread --> output callback
+        //
+        // Feed threads only parse and publish. The detector thread drains events in batches into
+        // its own SnapshotStore, publishes one snapshot per batch to the detector and forwards
+        // the opportunities that were not active after the previous batch. The arbitrage thread
+        // keeps its own store, fed from the quotes carried with each detection. Each stage owns
+        // its state, so nothing is shared behind a mutex.
+        class MarketEventPipeline
+        {
+        private:
+            struct alignas(concurrency::CACHE_LINE_SIZE) StageCounters
+            {
+                std::atomic<uint64_t> enqueued{0};
+                std::atomic<uint64_t> dropped{0};
+                std::atomic<uint64_t> backpressure_waits{0};
+                alignas(concurrency::CACHE_LINE_SIZE) std::atomic<uint64_t> dequeued{0}; // consumer side
+                std::atomic<uint64_t> batches{0};
+                std::atomic<size_t> high_watermark{0};
+            };
+
+            struct Producer
+            {
+                std::string name;
+                concurrency::SpscRing<MarketEvent> ring;
+                StageCounters counters;
+
+                Producer(const std::string &producer_name, size_t capacity) : name(producer_name), ring(capacity) {}
+            };
+
+            PipelineConfig config_;
+            std::unique_ptr<IMispricingDetector> detector_;
+            std::unique_ptr<IArbitrageEngine> arbitrage_engine_;
+            ArbitrageOutputCallback output_callback_;
+
+            std::vector<std::unique_ptr<Producer>> producers_; // fixed once started
+            concurrency::MpscRing<MarketEvent> shared_ingress_;
+            StageCounters shared_counters_;
+            concurrency::SpscRing<DetectionEvent> detections_;
+            StageCounters detection_counters_;
+
+            // Stage-local market state
+            SnapshotStore detector_store_;
+            SnapshotStore arbitrage_store_;
+
+            std::thread detector_thread_;
+            std::thread arbitrage_thread_;
+
+            // Captured by each stage between batches
+            std::shared_ptr<checkpoint::Checkpointer> detector_checkpointer_;
+            std::shared_ptr<checkpoint::Checkpointer> arbitrage_checkpointer_;
+            std::function<void()> detector_init_;
+            std::function<void()> arbitrage_init_;
+            std::atomic<bool> running_;
+
+            // Latency series, and the detector thread's earliest receive time in the current batch
+            telemetry::SeriesId queue_series_;
+            telemetry::SeriesId detection_series_;
+            telemetry::SeriesId validation_series_;
+            telemetry::SeriesId callback_series_;
+            telemetry::SeriesId end_to_end_series_;
+            Timestamp batch_receive_time_;
+            bool batch_started_;
+
+            // Detector thread: keys of the opportunities active after the last batch that reached
+            // the arbitrage stage, and scratch
+            std::unordered_set<uint64_t> open_detections_;
+            std::unordered_set<uint64_t> batch_detections_;
+            std::unordered_set<uint64_t> forwarded_detections_;
+
+            template <typename Ring, typename Event>
+            bool push(Ring &ring, Event &&event, OverflowPolicy policy, StageCounters &counters);
+
+            template <typename Ring>
+            size_t drain(Ring &ring, StageCounters &counters, size_t max_items);
+
+            void apply_event(MarketEvent &event);
+            void forward_detections(std::vector<MispricingOpportunity> &opportunities, const MarketSnapshot &snapshot);
+            void detector_loop();
+            void arbitrage_loop();
+
+        public:
+            MarketEventPipeline(std::unique_ptr<IMispricingDetector> detector,
+                                std::unique_ptr<IArbitrageEngine> arbitrage_engine,
+                                const PipelineConfig &config = PipelineConfig{});
+            ~MarketEventPipeline();
+
+            MarketEventPipeline(const MarketEventPipeline &) = delete;
+            MarketEventPipeline &operator=(const MarketEventPipeline &) = delete;
+
+            // Gives a feed thread its own SPSC ring; only valid before start()
+            ProducerId register_producer(const std::string &name);
+
+            // From the thread that owns `producer` only
+            bool publish(ProducerId producer, MarketEvent &&event);
+
+            // From any thread, through the shared MPSC ring
+            bool publish(MarketEvent &&event);
+
+            // Runs on the arbitrage thread; set before start()
+            void set_output_callback(ArbitrageOutputCallback callback) { output_callback_ = callback; }
+
+            // Checkpoints of the components each stage owns (either may be null), captured on
+            // the stage's thread between batches. Restore them before start(); set before start()
+            void set_checkpointers(std::shared_ptr<checkpoint::Checkpointer> detector_stage,
+                                   std::shared_ptr<checkpoint::Checkpointer> arbitrage_stage)
+            {
+                detector_checkpointer_ = std::move(detector_stage);
+                arbitrage_checkpointer_ = std::move(arbitrage_stage);
+            }
+
+            // Run on each stage's thread once its placement is applied, before its first batch
+            // (either may be empty). Work done here allocates on the stage's memory node, so
+            // this is the place to restore the stage's checkpoint or warm its state; set before
+            // start()
+            void set_stage_initializers(std::function<void()> detector_stage, std::function<void()> arbitrage_stage)
+            {
+                detector_init_ = std::move(detector_stage);
+                arbitrage_init_ = std::move(arbitrage_stage);
+            }
+
+            bool start();
+            void stop();
+            bool is_running() const { return running_.load(std::memory_order_acquire); }
+
+            std::vector<StageStatistics> get_stage_statistics() const;
+        };
+
+    } // namespace pipeline
+} // namespace spe
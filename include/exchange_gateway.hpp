@@ -0,0 +1,280 @@
+#pragma once
+
+#include "event_loop.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace spe
+{
+    namespace gateway
+    {
+
+        // Refills at rate per second up to burst; rate 0 means unlimited
+        struct TokenBucket
+        {
+            double rate;
+            double burst;
+            double tokens;
+            Clock::time_point last;
+
+            explicit TokenBucket(double rate = 0.0, double burst = 1.0)
+                : rate(rate), burst(std::max(burst, 1.0)), tokens(std::max(burst, 1.0)), last(Clock::now()) {}
+
+            void refill(Clock::time_point now)
+            {
+                double elapsed = std::chrono::duration<double>(now - last).count();
+                tokens = std::min(burst, tokens + rate * elapsed);
+                last = now;
+            }
+
+            bool try_take(Clock::time_point now)
+            {
+                if (rate <= 0.0)
+                {
+                    return true;
+                }
+                refill(now);
+                if (tokens < 1.0)
+                {
+                    return false;
+                }
+                tokens -= 1.0;
+                return true;
+            }
+
+            // Until the next token; zero when one is available
+            std::chrono::milliseconds wait_time(Clock::time_point now)
+            {
+                if (rate <= 0.0)
+                {
+                    return std::chrono::milliseconds(0);
+                }
+                refill(now);
+                if (tokens >= 1.0)
+                {
+                    return std::chrono::milliseconds(0);
+                }
+                return std::chrono::ceil<std::chrono::milliseconds>(std::chrono::duration<double>((1.0 - tokens) / rate));
+            }
+        };
+
+        // Per-venue limits. Buckets are sized so that burst plus one window of refill stays
+        // under the published cap, since a bucket lets a full burst through at any time.
+        struct GatewayLimits
+        {
+            size_t connections = 4;
+            size_t max_subscriptions_per_connection = 0; // 0 = unbounded
+
+            // Subscribe/unsubscribe requests, per connection
+            double subscribes_per_second = 0.0;
+            double subscribe_burst = 1.0;
+
+            // Connection attempts, shared by every shard of the venue, so a venue-wide drop
+            // reconnects at the allowed pace instead of as a storm
+            double connects_per_second = 0.0;
+            double connect_burst = 1.0;
+
+            std::chrono::milliseconds reconnect_initial_delay{250};
+            std::chrono::milliseconds reconnect_max_delay{30000};
+            std::chrono::milliseconds ping_interval{20000};
+            std::chrono::milliseconds stale_timeout{30000}; // reconnect when no frame arrives for this long
+            std::string ping_payload = "ping";              // empty: the venue pings and we only watch for staleness
+
+            // 480 subscribe requests per hour per connection, 3 connection requests per second
+            static GatewayLimits okx()
+            {
+                GatewayLimits limits;
+                limits.subscribes_per_second = 240.0 / 3600.0;
+                limits.subscribe_burst = 240.0;
+                limits.connects_per_second = 2.0;
+                limits.connect_burst = 1.0;
+                return limits;
+            }
+
+            // 5 incoming messages per second per connection (pongs included), 1024 streams per
+            // connection, 300 connections per 5 minutes
+            static GatewayLimits binance()
+            {
+                GatewayLimits limits;
+                limits.max_subscriptions_per_connection = 1024;
+                limits.subscribes_per_second = 3.0;
+                limits.subscribe_burst = 1.0;
+                limits.connects_per_second = 270.0 / 300.0;
+                limits.connect_burst = 30.0;
+                limits.ping_payload.clear();
+                limits.stale_timeout = std::chrono::milliseconds(60000);
+                return limits;
+            }
+        };
+
+        struct GatewaySubscription
+        {
+            std::string key; // unique per venue, e.g. get_subscription_key()
+            std::string subscribe_message;
+            std::string unsubscribe_message;
+        };
+
+        enum class TransportState
+        {
+            CONNECTING,
+            OPEN,
+            CLOSED
+        };
+
+        using FrameHandler = std::function<void(const std::string &frame)>;
+
+        // One non-blocking connection (TLS and websocket framing included) driven by the
+        // gateway's event loop. All calls come from the loop thread.
+        class IGatewayTransport
+        {
+        public:
+            virtual ~IGatewayTransport() = default;
+
+            // Starts a non-blocking connect; false on immediate failure
+            virtual bool open(const std::string &url) = 0;
+            virtual void close() = 0;
+
+            virtual int native_handle() const = 0; // fd to watch, valid after open()
+            virtual bool wants_write() const = 0;  // connect or handshake in progress, or output queued
+
+            // Services readiness, calling on_frame for each complete message received
+            virtual TransportState on_ready(uint32_t events, const FrameHandler &on_frame) = 0;
+            virtual bool send(const std::string &message) = 0;
+        };
+
+        using TransportFactory = std::function<std::unique_ptr<IGatewayTransport>(size_t shard)>;
+
+        struct GatewayStats
+        {
+            size_t connects = 0;
+            size_t reconnects = 0;
+            size_t subscribes_sent = 0;
+            size_t messages_received = 0;
+            size_t throttled = 0; // sends or connects held back by a bucket
+        };
+
+        // Spreads one venue's subscriptions over several connections, all serviced by one
+        // shared EventLoop. A subscription goes to the least-loaded shard under the cap and
+        // stays there; each shard drains its own request queue through its own bucket, and
+        // reconnects on its own with jittered exponential backoff, replaying only its own
+        // subscriptions, so one drop stalls only the symbols on that socket.
+        //
+        // subscribe, unsubscribe, send and stop may be called from any thread: they post to
+        // the loop. Handlers run on the loop thread, one frame at a time across all shards,
+        // so a gateway is a single producer however many shards it has. Set handlers before
+        // start(), own the gateway through a shared_ptr, and stop() it before letting go.
+        class ExchangeGateway : public std::enable_shared_from_this<ExchangeGateway>
+        {
+        public:
+            using MessageHandler = std::function<void(size_t shard, const std::string &frame)>;
+            using StateHandler = std::function<void(size_t shard, TransportState state)>;
+            using ErrorHandler = std::function<void(size_t shard, const std::string &error)>;
+
+        private:
+            struct Subscription
+            {
+                size_t shard;
+                std::string subscribe_message;
+                std::string unsubscribe_message;
+            };
+
+            struct Shard
+            {
+                std::unique_ptr<IGatewayTransport> transport;
+                int fd = -1;
+                TransportState state = TransportState::CLOSED;
+                std::set<std::string> keys;
+                std::deque<std::string> pending; // waiting for a token, in order
+                TokenBucket bucket;
+                std::chrono::milliseconds backoff{0};
+                Clock::time_point last_frame;
+                TimerHandle drain_timer = INVALID_TIMER_HANDLE;
+                TimerHandle reconnect_timer = INVALID_TIMER_HANDLE;
+                TimerHandle ping_timer = INVALID_TIMER_HANDLE;
+
+                // Read from other threads by the queries
+                std::atomic<TransportState> published_state{TransportState::CLOSED};
+                std::atomic<size_t> subscription_count{0};
+            };
+
+            std::shared_ptr<EventLoop> loop_;
+            std::string venue_;
+            std::string url_;
+            GatewayLimits limits_;
+            TransportFactory factory_;
+
+            // Loop thread only
+            std::vector<std::unique_ptr<Shard>> shards_;
+            std::unordered_map<std::string, Subscription> subscriptions_;
+            TokenBucket connect_bucket_;
+            std::minstd_rand jitter_;
+            bool running_;
+
+            MessageHandler message_handler_;
+            StateHandler state_handler_;
+            ErrorHandler error_handler_;
+
+            std::atomic<size_t> connects_{0};
+            std::atomic<size_t> reconnects_{0};
+            std::atomic<size_t> subscribes_sent_{0};
+            std::atomic<size_t> messages_received_{0};
+            std::atomic<size_t> throttled_{0};
+
+            // Loop thread
+            void connect_shard(size_t shard);
+            void on_shard_ready(size_t shard, uint32_t events);
+            void on_shard_open(size_t shard);
+            void drop_shard(size_t shard, const std::string &reason);
+            void schedule_reconnect(size_t shard, std::chrono::milliseconds delay);
+            void enqueue(size_t shard, std::string message);
+            void drain(size_t shard);
+            void arm_ping(size_t shard);
+            void ping(size_t shard); // stale check, then keep-alive
+            void set_state(size_t shard, TransportState state);
+            void report(size_t shard, const std::string &error);
+            size_t pick_shard() const;
+            void do_subscribe(GatewaySubscription subscription);
+            void do_unsubscribe(const std::string &key);
+
+        public:
+            ExchangeGateway(std::shared_ptr<EventLoop> loop, std::string venue, std::string url, const GatewayLimits &limits,
+                            TransportFactory factory);
+            ~ExchangeGateway();
+
+            ExchangeGateway(const ExchangeGateway &) = delete;
+            ExchangeGateway &operator=(const ExchangeGateway &) = delete;
+
+            // Opens every shard, paced by the connect bucket; false if the loop is unusable
+            bool start();
+            void stop();
+
+            void subscribe(GatewaySubscription subscription);
+            void unsubscribe(const std::string &key);
+            // Sends on the shard holding key, through its bucket (e.g. a book resync request)
+            void send_on_subscription_shard(const std::string &key, std::string message);
+
+            void set_message_handler(MessageHandler handler) { message_handler_ = std::move(handler); }
+            void set_state_handler(StateHandler handler) { state_handler_ = std::move(handler); }
+            void set_error_handler(ErrorHandler handler) { error_handler_ = std::move(handler); }
+
+            const std::string &venue() const { return venue_; }
+            const GatewayLimits &limits() const { return limits_; }
+            size_t shard_count() const { return shards_.size(); }
+            TransportState shard_state(size_t shard) const;
+            size_t shard_subscription_count(size_t shard) const;
+            size_t open_shard_count() const;
+            GatewayStats stats() const;
+        };
+
+    } // namespace gateway
+} // namespace spe
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "exchange_types.hpp"
+#include "order_book.hpp"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace spe
+{
+    namespace exchange_ws
+    {
+
+        enum class WireMessageKind
+        {
+            UNKNOWN, // not a schema the fast path knows; parse it with the DOM instead
+            ORDERBOOK,
+            TRADE,
+            TICKER
+        };
+
+        struct WireTrade
+        {
+            std::string_view trade_id;
+            double price = 0.0;
+            double size = 0.0;
+            Side side = Side::BID; // aggressor: BID for a taker buy, ASK for a taker sell
+            uint64_t exchange_time_ms = 0;
+        };
+
+        // A book level's price and size as sent, unquoted, for checksums over the wire text
+        struct WireLevelText
+        {
+            std::string_view price;
+            std::string_view size;
+        };
+
+        // One decoded frame. String views point into the receive buffer, so they are only valid
+        // while that buffer is. The vectors keep their capacity from frame to frame; reuse one
+        // WireMessage per connection and steady-state parsing does not allocate.
+        struct WireMessage
+        {
+            WireMessageKind kind = WireMessageKind::UNKNOWN;
+            std::string_view channel; // OKX channel or Binance stream name, when present
+            std::string_view symbol;  // wire symbol (lower case for Binance partial-depth streams)
+            uint64_t exchange_time_ms = 0;
+            Timestamp receive_time;
+
+            // ORDERBOOK
+            bool is_snapshot = false;
+            std::vector<OrderBookLevel> bids;
+            std::vector<OrderBookLevel> asks;
+            std::vector<WireLevelText> bid_text; // index for index with bids
+            std::vector<WireLevelText> ask_text;
+            uint64_t first_update_id = 0;    // Binance U
+            uint64_t last_update_id = 0;     // Binance u / lastUpdateId, OKX seqId
+            uint64_t previous_update_id = 0; // Binance pu (futures), OKX prevSeqId
+            int64_t checksum = 0;            // OKX CRC32 of the top 25 levels
+            bool has_checksum = false;
+
+            // TRADE
+            std::vector<WireTrade> trades;
+
+            // TICKER; instrument and exchange are left for the caller
+            TickerData ticker;
+            bool ticker_is_top_of_book = false; // Binance bookTicker: only bid/ask fields are set
+
+            void reset();
+        };
+
+        // Schema-specific parsers for the hot channels: OKX books*/bbo-tbt/trades/tickers and
+        // Binance depth/trade/aggTrade/24hrTicker/bookTicker, raw or wrapped in a combined
+        // stream. They scan the frame once, read numbers straight from the buffer and never
+        // build a DOM. Anything else (subscription acks, errors, other channels, escaped
+        // strings) returns false with kind UNKNOWN.
+        bool parse_okx_message(std::string_view frame, WireMessage &out);
+        bool parse_binance_message(std::string_view frame, WireMessage &out);
+
+        // Applies an ORDERBOOK message in place, with the book's own sequencing and checksum
+        // checks; any other kind is ignored as STALE
+        BookUpdateResult apply_to_order_book(const WireMessage &message, OrderBook &book);
+
+        // Decimal number, quoted or bare, as exchanges send prices and sizes
+        bool parse_wire_decimal(std::string_view text, double &out);
+
+    } // namespace exchange_ws
+} // namespace spe
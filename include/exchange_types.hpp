@@ -0,0 +1,99 @@
+#pragma once
+
+#include "market_data.hpp"
+#include "instrument_registry.hpp"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace spe
+{
+    namespace exchange_ws
+    {
+
+        using namespace market_data;
+
+        // Normalized exchange payloads. Kept free of the WebSocket and JSON dependencies so the
+        // wire parsers can fill them directly.
+        struct OrderBookLevel 
+        {
+            double price;
+            double quantity;
+            Timestamp timestamp;
+
+            OrderBookLevel(double p = 0.0, double q = 0.0)
+                : price(p), quantity(q), timestamp(std::chrono::high_resolution_clock::now()) {}
+            OrderBookLevel(double p, double q, Timestamp ts) : price(p), quantity(q), timestamp(ts) {}
+        };
+
+        struct OrderBookSnapshot // This is used for both spot and futures subscriptions
+        {
+            InstrumentHandle instrument;
+            std::string exchange;
+            std::vector<OrderBookLevel> bids;
+            std::vector<OrderBookLevel> asks;
+            Timestamp timestamp;
+            uint64_t sequence_number;
+
+            OrderBookSnapshot() : instrument(INVALID_INSTRUMENT), timestamp(std::chrono::high_resolution_clock::now()), sequence_number(0) {}
+        };
+
+        struct FundingRateData 
+        {
+            InstrumentHandle instrument;
+            std::string exchange;
+            double funding_rate;
+            double predicted_funding_rate;
+            Timestamp funding_time;
+            Timestamp next_funding_time;
+            Timestamp timestamp;
+
+            FundingRateData() : instrument(INVALID_INSTRUMENT), funding_rate(0.0), predicted_funding_rate(0.0),
+                                timestamp(std::chrono::high_resolution_clock::now()) {}
+        };
+
+        struct MarkPriceData 
+        {
+            InstrumentHandle instrument;
+            std::string exchange;
+            double mark_price;
+            double index_price;
+            double funding_rate;
+            Timestamp timestamp;
+
+            MarkPriceData() : instrument(INVALID_INSTRUMENT), mark_price(0.0), index_price(0.0), funding_rate(0.0),
+                              timestamp(std::chrono::high_resolution_clock::now()) {}
+        };
+
+        struct TickerData
+        {
+            InstrumentHandle instrument;
+            std::string exchange;
+            double last_price;
+            double bid_price;
+            double ask_price;
+            double bid_size;
+            double ask_size;
+            double volume_24h;
+            double price_change_24h;
+            double price_change_percent_24h;
+            double high_24h;
+            double low_24h;
+            Timestamp timestamp;
+
+            TickerData() : instrument(INVALID_INSTRUMENT), last_price(0.0), bid_price(0.0), ask_price(0.0), bid_size(0.0),
+                           ask_size(0.0), volume_24h(0.0), price_change_24h(0.0),
+                           price_change_percent_24h(0.0), high_24h(0.0), low_24h(0.0),
+                           timestamp(std::chrono::high_resolution_clock::now()) {}
+        };
+
+        // Callback types for different data types
+        using OrderBookCallback = std::function<void(const OrderBookSnapshot &)>;
+        using FundingRateCallback = std::function<void(const FundingRateData &)>;
+        using MarkPriceCallback = std::function<void(const MarkPriceData &)>;
+        using TickerCallback = std::function<void(const TickerData &)>;
+
+    } // namespace exchange_ws
+} // namespace spe
@@ -2,12 +2,19 @@
 
 #include "market_data.hpp"
 #include "data_feed.hpp"
+#include "instrument_registry.hpp"
+#include "event_pipeline.hpp"
+#include "exchange_types.hpp"
+#include "exchange_message_parser.hpp"
+#include "market_journal.hpp"
+#include "exchange_gateway.hpp"
 #include <websocketpp/config/asio_client.hpp>
 #include <websocketpp/client.hpp>
 #include <nlohmann/json.hpp>
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <set>
 #include <queue>
 #include <memory>
@@ -79,82 +86,7 @@ namespace spe
             std::map<std::string, std::string> params;
         };
 
-        struct OrderBookLevel 
-        {
-            double price;
-            double quantity;
-            Timestamp timestamp;
-
-            OrderBookLevel(double p = 0.0, double q = 0.0)
-                : price(p), quantity(q), timestamp(std::chrono::high_resolution_clock::now()) {}
-        };
-
-        struct OrderBookSnapshot // This is used for both spot and futures subscriptions
-        {
-            InstrumentId instrument_id;
-            std::string exchange;
-            std::vector<OrderBookLevel> bids;
-            std::vector<OrderBookLevel> asks;
-            Timestamp timestamp;
-            uint64_t sequence_number;
-
-            OrderBookSnapshot() : sequence_number(0), timestamp(std::chrono::high_resolution_clock::now()) {}
-        };
-
-        struct FundingRateData 
-        {
-            InstrumentId instrument_id;
-            std::string exchange;
-            double funding_rate;
-            double predicted_funding_rate;
-            Timestamp funding_time;
-            Timestamp next_funding_time;
-            Timestamp timestamp;
-
-            FundingRateData() : funding_rate(0.0), predicted_funding_rate(0.0),
-                                timestamp(std::chrono::high_resolution_clock::now()) {}
-        };
-
-        struct MarkPriceData 
-        {
-            InstrumentId instrument_id;
-            std::string exchange;
-            double mark_price;
-            double index_price;
-            double funding_rate;
-            Timestamp timestamp;
-
-            MarkPriceData() : mark_price(0.0), index_price(0.0), funding_rate(0.0),
-                              timestamp(std::chrono::high_resolution_clock::now()) {}
-        };
-
-        struct TickerData
-        {
-            InstrumentId instrument_id;
-            std::string exchange;
-            double last_price;
-            double bid_price;
-            double ask_price;
-            double bid_size;
-            double ask_size;
-            double volume_24h;
-            double price_change_24h;
-            double price_change_percent_24h;
-            double high_24h;
-            double low_24h;
-            Timestamp timestamp;
-
-            TickerData() : last_price(0.0), bid_price(0.0), ask_price(0.0), bid_size(0.0),
-                           ask_size(0.0), volume_24h(0.0), price_change_24h(0.0),
-                           price_change_percent_24h(0.0), high_24h(0.0), low_24h(0.0),
-                           timestamp(std::chrono::high_resolution_clock::now()) {}
-        };
-
-        // Callback types for different data types
-        using OrderBookCallback = std::function<void(const OrderBookSnapshot &)>;
-        using FundingRateCallback = std::function<void(const FundingRateData &)>;
-        using MarkPriceCallback = std::function<void(const MarkPriceData &)>;
-        using TickerCallback = std::function<void(const TickerData &)>;
+        std::string exchange_type_to_string(ExchangeType type);
 
         class IExchangeWebSocket  // base interface for exchange-specific WebSocket client
         {
@@ -208,17 +140,22 @@ namespace spe
             std::thread ws_thread_;
             std::atomic<bool> running_;
 
-            // Data storage
+            // Data storage, keyed by the handle of the exchange-normalized symbol
             mutable std::mutex data_mutex_;
-            std::map<std::string, OrderBookSnapshot> orderbook_snapshots_;
-            std::map<std::string, FundingRateData> funding_rates_;
-            std::map<std::string, MarkPriceData> mark_prices_;
-            std::map<std::string, TickerData> tickers_;
-            std::map<std::string, std::queue<Trade>> trade_history_;
+            std::unordered_map<InstrumentHandle, OrderBookSnapshot> orderbook_snapshots_;
+            std::unordered_map<InstrumentHandle, FundingRateData> funding_rates_;
+            std::unordered_map<InstrumentHandle, MarkPriceData> mark_prices_;
+            std::unordered_map<InstrumentHandle, TickerData> tickers_;
+            std::unordered_map<InstrumentHandle, std::queue<Trade>> trade_history_;
+
+            // Incremental books, created on subscribe and updated in place on the socket thread;
+            // data_mutex_ only guards finding a book, readers then go through its seqlock view
+            std::unordered_map<InstrumentHandle, std::unique_ptr<OrderBook>> order_books_;
 
             // Subscriptions tracking
             std::set<std::string> active_subscriptions_;
             std::map<std::string, SubscriptionRequest> subscription_requests_;
+            std::map<std::string, InstrumentHandle> subscription_handles_; // wire symbol -> handle, filled on subscribe
 
             // Callbacks
             OrderBookCallback orderbook_callback_;
@@ -238,7 +175,75 @@ namespace spe
             // Reconnection
             std::atomic<int> reconnect_attempts_;
 
+            // Staged pipeline; when attached, handlers publish normalized events to this
+            // connection's SPSC ring and leave detection to the pipeline threads
+            std::shared_ptr<pipeline::MarketEventPipeline> pipeline_;
+            pipeline::ProducerId pipeline_producer_ = pipeline::INVALID_PRODUCER;
+
+            // Capture journal, written on the socket thread; one writer per connection
+            std::shared_ptr<data_feed::JournalWriter> journal_;
+
+            // Sharded connections on a shared event loop; when attached, client_, ws_thread_ and
+            // ping_thread_ stay idle and process_message runs on the loop thread
+            std::shared_ptr<gateway::ExchangeGateway> gateway_;
+
+            // Routes a subscription through the gateway; false when none is attached and the
+            // caller sends on client_ as before
+            bool gateway_subscribe(const SubscriptionRequest &request)
+            {
+                if (!gateway_)
+                {
+                    return false;
+                }
+                gateway_->subscribe(gateway::GatewaySubscription{
+                    get_subscription_key(request.symbol, request.data_type, request.instrument_type),
+                    create_subscription_message(request).dump(),
+                    create_unsubscription_message(request.symbol, request.data_type, request.instrument_type).dump()});
+                return true;
+            }
+
+            // Called from process_message handlers on the socket thread; tickers and trades are
+            // journaled here
+            void publish_orderbook(const OrderBookSnapshot &snapshot); // depth + top-of-book quote
+            void publish_ticker(const TickerData &ticker);
+            void publish_trade(const Trade &trade);
+
+            // Applies a parsed book frame; GAP or CHECKSUM_MISMATCH calls request_book_resync.
+            // Frames the book accepted are journaled as deltas via journal_book_message.
+            void apply_book_message(InstrumentHandle instrument, const WireMessage &message);
+
+            // Records an applied book frame, so replay rebuilds exactly the book that was live
+            void journal_book_message(InstrumentHandle instrument, const WireMessage &message)
+            {
+                if (!journal_)
+                {
+                    return;
+                }
+                size_t remaining = message.bids.size() + message.asks.size();
+                if (remaining == 0)
+                {
+                    journal_->append_empty_book(instrument, message.is_snapshot, message.last_update_id, message.receive_time);
+                    return;
+                }
+                uint16_t flags = message.is_snapshot ? data_feed::BOOK_SNAPSHOT : 0;
+                for (const auto *levels : {&message.bids, &message.asks})
+                {
+                    Side side = levels == &message.bids ? Side::BID : Side::ASK;
+                    for (const auto &level : *levels)
+                    {
+                        if (--remaining == 0)
+                        {
+                            flags |= data_feed::BOOK_END;
+                        }
+                        journal_->append_book_level(instrument, side, level.price, level.quantity,
+                                                    message.last_update_id, message.receive_time, flags);
+                        flags = 0;
+                    }
+                }
+            }
+
             // Virtual methods for exchange-specific implementation
+            virtual void request_book_resync(InstrumentHandle instrument) = 0; // resubscribe or fetch a REST snapshot
             virtual std::string get_websocket_url(InstrumentType type) const = 0;
             virtual json create_subscription_message(const SubscriptionRequest &request) const = 0;
             virtual json create_unsubscription_message(const std::string &symbol, DataType data_type, InstrumentType type) const = 0;
@@ -257,6 +262,10 @@ namespace spe
             bool attempt_reconnect();
             void handle_error(const std::string &error_msg);
 
+            // Interns the wire symbol once on subscribe; message handlers then resolve by lookup only
+            InstrumentHandle register_subscription_symbol(const std::string &exchange_symbol);
+            InstrumentHandle resolve_symbol(const std::string &exchange_symbol) const;
+
         public:
             BaseExchangeWebSocket(ExchangeType type, const ExchangeConfig &config);
             virtual ~BaseExchangeWebSocket();
@@ -279,20 +288,62 @@ namespace spe
             MarkPriceData get_latest_mark_price(const std::string &symbol) const override;
             TickerData get_latest_ticker(const std::string &symbol, InstrumentType type = InstrumentType::SPOT) const override;
 
+            // Top MarketDepth::MAX_LEVELS of the incremental book, read without copying the ladder
+            bool get_book_top(const std::string &symbol, MarketDepth &out) const;
+
             ExchangeType get_exchange_type() const override { return exchange_type_; }
             void set_config(const ExchangeConfig &config) override { config_ = config; }
+
+            // Registers this connection as a pipeline producer; call before the pipeline starts.
+            // Callbacks keep firing on the socket thread, so they should stay cheap.
+            bool attach_pipeline(std::shared_ptr<pipeline::MarketEventPipeline> pipeline)
+            {
+                pipeline_producer_ = pipeline->register_producer(exchange_type_to_string(exchange_type_));
+                if (pipeline_producer_ == pipeline::INVALID_PRODUCER)
+                {
+                    return false;
+                }
+                pipeline_ = std::move(pipeline);
+                return true;
+            }
+
+            // Hands the sockets to a gateway; call before connect(). The gateway is the pipeline
+            // producer and journal writer's single thread however many shards it runs.
+            void attach_gateway(std::shared_ptr<gateway::ExchangeGateway> gateway)
+            {
+                gateway->set_message_handler([this](size_t, const std::string &frame) { process_message(frame); });
+                gateway->set_error_handler([this](size_t, const std::string &error) { handle_error(error); });
+                gateway_ = std::move(gateway);
+            }
+
+            // Journals everything this connection receives; call before connect()
+            bool attach_journal(std::shared_ptr<data_feed::JournalWriter> journal)
+            {
+                if (!journal || !journal->open())
+                {
+                    return false;
+                }
+                journal_ = std::move(journal);
+                return true;
+            }
         };
       // exchnage specific implementation
         class OKXWebSocket : public BaseExchangeWebSocket
         {
         private:
             std::map<std::string, std::string> symbol_mapping_;
+            WireMessage wire_message_; // reused by the fast path; holds views into the current frame
+
+            // process_message tries parse_okx_message first and only builds a json DOM for
+            // frames it reports as UNKNOWN (acks, errors, funding/mark-price channels)
+            void apply_wire_message(const WireMessage &message);
 
             std::string get_websocket_url(InstrumentType type) const override;
             json create_subscription_message(const SubscriptionRequest &request) const override;
             json create_unsubscription_message(const std::string &symbol, DataType data_type, InstrumentType type) const override;
             void process_message(const std::string &message) override;
             std::string get_subscription_key(const std::string &symbol, DataType data_type, InstrumentType type) const override;
+            void request_book_resync(InstrumentHandle instrument) override;
 
             // OKX-specific message processors
             void process_orderbook_message(const json &data);
@@ -321,12 +372,17 @@ namespace spe
         {
         private:
             std::map<std::string, uint64_t> orderbook_sequence_numbers_;
+            WireMessage wire_message_;
+
+            // Same split as OKX: parse_binance_message first, json DOM for everything else
+            void apply_wire_message(const WireMessage &message);
 
             std::string get_websocket_url(InstrumentType type) const override;
             json create_subscription_message(const SubscriptionRequest &request) const override;
             json create_unsubscription_message(const std::string &symbol, DataType data_type, InstrumentType type) const override;
             void process_message(const std::string &message) override;
             std::string get_subscription_key(const std::string &symbol, DataType data_type, InstrumentType type) const override;
+            void request_book_resync(InstrumentHandle instrument) override;
 
             // Binance-specific message processors
             void process_orderbook_message(const json &data);
@@ -362,6 +418,7 @@ namespace spe
             json create_unsubscription_message(const std::string &symbol, DataType data_type, InstrumentType type) const override;
             void process_message(const std::string &message) override;
             std::string get_subscription_key(const std::string &symbol, DataType data_type, InstrumentType type) const override;
+            void request_book_resync(InstrumentHandle instrument) override;
 
             // Bybit-specific message processors
             void process_orderbook_message(const json &data);
@@ -392,7 +449,7 @@ namespace spe
         {
         private:
             std::map<ExchangeType, std::unique_ptr<IExchangeWebSocket>> exchanges_;
-            std::map<std::string, std::set<ExchangeType>> symbol_subscriptions_;
+            std::map<InstrumentHandle, std::set<ExchangeType>> symbol_subscriptions_;
 
             // Unified callbacks
             OrderBookCallback unified_orderbook_callback_;
@@ -404,9 +461,9 @@ namespace spe
 
             // Data synchronization
             mutable std::mutex sync_mutex_;
-            std::map<std::string, std::map<ExchangeType, OrderBookSnapshot>> unified_orderbooks_;
-            std::map<std::string, std::map<ExchangeType, TickerData>> unified_tickers_;
-            std::map<std::string, std::map<ExchangeType, FundingRateData>> unified_funding_rates_;
+            std::unordered_map<InstrumentHandle, std::map<ExchangeType, OrderBookSnapshot>> unified_orderbooks_;
+            std::unordered_map<InstrumentHandle, std::map<ExchangeType, TickerData>> unified_tickers_;
+            std::unordered_map<InstrumentHandle, std::map<ExchangeType, FundingRateData>> unified_funding_rates_;
 
             void setup_exchange_callbacks(ExchangeType exchange);
 
@@ -3,6 +3,10 @@
 #include "market_data.hpp"
 #include "pricing_models.hpp"
 #include "arbitrage_engine.hpp"
+#include "monte_carlo_var.hpp"
+#include "double_buffer.hpp"
+#include "small_vector.hpp"
+#include "thread_topology.hpp"
 #include <vector>
 #include <map>
 #include <memory>
@@ -10,6 +14,11 @@
 #include <mutex>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 
 namespace spe
 {
@@ -51,8 +60,8 @@ namespace spe
         {
             std::string derivative_id;
             DerivativeType type;
-            InstrumentId underlying_instrument;
-            std::vector<InstrumentId> component_instruments;
+            InstrumentHandle underlying_instrument;
+            std::vector<InstrumentHandle> component_instruments;
             std::vector<double> component_weights;
             std::vector<Volume> component_sizes;
 
@@ -86,7 +95,7 @@ namespace spe
         struct Position // trading position with associated risk metrics
         {
             std::string position_id;
-            InstrumentId instrument_id;
+            InstrumentHandle instrument;
             PositionSide side;
             Volume size;
             Price entry_price;
@@ -153,6 +162,7 @@ namespace spe
             double take_profit_percentage = 0.15;       // 15% take profit
             double max_drawdown_threshold = 0.1;        // 10% max drawdown
             double liquidity_requirement = 0.8;         // 80% liquidity requirement
+            double risk_free_rate = 0.05;               // 5% annual, for option Greeks
         };
 
         class ISyntheticDerivativeConstructor // constructs synthetic derivative instruments based on market data
@@ -161,21 +171,21 @@ namespace spe
             virtual ~ISyntheticDerivativeConstructor() = default;
 
             virtual SyntheticDerivative construct_synthetic_forward(
-                const InstrumentId &underlying,
+                InstrumentHandle underlying,
                 Price strike,
                 Timestamp expiry,
                 const MarketSnapshot &market_data) = 0;
 
             virtual SyntheticDerivative construct_synthetic_option(
-                const InstrumentId &underlying,
+                InstrumentHandle underlying,
                 DerivativeType option_type,
                 Price strike,
                 Timestamp expiry,
                 const MarketSnapshot &market_data) = 0;
 
             virtual SyntheticDerivative construct_synthetic_swap(
-                const InstrumentId &pay_leg,
-                const InstrumentId &receive_leg,
+                InstrumentHandle pay_leg,
+                InstrumentHandle receive_leg,
                 Timestamp expiry,
                 const MarketSnapshot &market_data) = 0;
 
@@ -239,12 +249,12 @@ namespace spe
                 const Position &position,
                 const RiskParameters &params) = 0;
             double calculate_funding_rate_impact(
-                const Portfolio\&portfolio,
-                const MarketSnapshot\&market_data,
-                const std::map<InstrumentId, double> &funding_rates);
+                const Portfolio &portfolio,
+                const MarketSnapshot &market_data,
+                const std::map<InstrumentHandle, double> &funding_rates);
 
             double evaluate_liquidity_across_legs(
-                const std::vector<ArbitrageLeg> &legs,
+                const LegVector &legs,
                 const MarketSnapshot &market_data,
                 double liquidity_threshold);
 
@@ -257,16 +267,19 @@ namespace spe
         {
         private:
             std::unique_ptr<IPricingModel> pricing_model_;
+            const OptionsPricingModel *options_model_; // pricing_model_ when it carries vol surfaces
             RiskParameters risk_params_;
 
             // Helper methods
+            double surface_volatility(InstrumentHandle underlying, Price strike, double time_to_expiry) const;
+
             std::vector<double> optimize_component_weights(
-                const std::vector<InstrumentId> &components,
+                const std::vector<InstrumentHandle> &components,
                 const MarketSnapshot &market_data,
                 DerivativeType target_type);
 
             double calculate_implied_volatility_from_components(
-                const std::vector<InstrumentId> &components,
+                const std::vector<InstrumentHandle> &components,
                 const std::vector<double> &weights,
                 const MarketSnapshot &market_data);
 
@@ -274,32 +287,42 @@ namespace spe
                 SyntheticDerivative &derivative,
                 const MarketSnapshot &market_data);
 
+            void price_greek_chains(const MarketSnapshot &market_data);
+
+            // Scratch for batch Greeks, reused across calls
+            std::map<InstrumentHandle, OptionChain> greek_chains_;
+            std::map<InstrumentHandle, std::vector<SyntheticDerivative *>> greek_chain_members_;
+            OptionChainGreeks greek_results_;
+
         public:
             SyntheticDerivativeConstructor(std::unique_ptr<IPricingModel> model,
                                            const RiskParameters &params = RiskParameters{});
 
             SyntheticDerivative construct_synthetic_forward(
-                const InstrumentId &underlying,
+                InstrumentHandle underlying,
                 Price strike,
                 Timestamp expiry,
                 const MarketSnapshot &market_data) override;
 
             SyntheticDerivative construct_synthetic_option(
-                const InstrumentId &underlying,
+                InstrumentHandle underlying,
                 DerivativeType option_type,
                 Price strike,
                 Timestamp expiry,
                 const MarketSnapshot &market_data) override;
 
             SyntheticDerivative construct_synthetic_swap(
-                const InstrumentId &pay_leg,
-                const InstrumentId &receive_leg,
+                InstrumentHandle pay_leg,
+                InstrumentHandle receive_leg,
                 Timestamp expiry,
                 const MarketSnapshot &market_data) override;
 
             double calculate_construction_cost(const SyntheticDerivative &derivative) override;
             void update_greeks(SyntheticDerivative &derivative, const MarketSnapshot &market_data) override;
 
+            // Reprices all option-type derivatives with one batch pass per underlying
+            void update_greeks(std::vector<SyntheticDerivative> &derivatives, const MarketSnapshot &market_data);
+
             // Additional methods
             std::vector<SyntheticDerivative> construct_hedge_portfolio(
                 const Position &position,
@@ -307,7 +330,7 @@ namespace spe
 
             SyntheticDerivative optimize_synthetic_construction(
                 DerivativeType type,
-                const InstrumentId &underlying,
+                InstrumentHandle underlying,
                 const MarketSnapshot &market_data);
         };
 
@@ -366,17 +389,40 @@ namespace spe
                 double max_correlation);
         };
 
+        // Portfolio VaR and ES come from one MonteCarloVarEngine run over the positions'
+        // instruments, with daily volatilities from the recorded price history and correlations
+        // from the shared matrix. The factorization is kept until the instrument set changes, or
+        // the data has moved and the factors are older than max_factor_age; pre-trade checks
+        // against an unchanged book therefore only simulate paths.
         class AdvancedRiskCalculator : public IRiskCalculator // implements advanced risk calculations
         {
         private:
-            std::map<InstrumentId, std::vector<Price>> price_history_;
-            std::map<std::pair<InstrumentId, InstrumentId>, double> correlation_matrix_;
+            static constexpr size_t HISTORY_LIMIT = 500;            // prices kept per instrument
+            static constexpr double DEFAULT_DAILY_VOLATILITY = 0.02; // until an instrument has history
+
+            std::map<InstrumentHandle, std::vector<Price>> price_history_;
+            std::shared_ptr<const stats::StreamingCorrelationMatrix> correlation_matrix_; // shared, read lock-free
+
+            MonteCarloVarEngine portfolio_engine_;
+            MonteCarloVarEngine position_engine_; // single-position runs, so they leave the portfolio factors alone
+            uint64_t history_version_;            // bumped by update_price_history
+            uint64_t factors_version_;            // history version the portfolio factors were built from
+            uint64_t factors_observations_;       // correlation observations at that build
+            std::chrono::steady_clock::time_point factors_built_;
+            std::chrono::milliseconds max_factor_age_;
+            std::vector<RiskExposure> exposures_;
 
             // Monte Carlo simulation methods
             std::vector<double> monte_carlo_simulation(
                 const Position &position,
                 size_t num_simulations = 10000);
 
+            MonteCarloRiskResult simulate_position(const Position &position, double confidence_level,
+                                                   size_t time_horizon_days, std::vector<double> *losses = nullptr);
+            MonteCarloRiskResult simulate_exposures(double confidence_level);
+            double daily_volatility(InstrumentHandle instrument) const;
+            static double position_notional(const Position &position);
+
             double calculate_parametric_var(
                 const Position &position,
                 double confidence_level);
@@ -385,7 +431,6 @@ namespace spe
                 const Position &position,
                 double confidence_level);
 
-            void update_correlation_matrix(const MarketSnapshot &market_data);
 
         public:
             AdvancedRiskCalculator();
@@ -420,10 +465,28 @@ namespace spe
                 double confidence_level = 0.95);
 
             double calculate_tail_ratio(const Position &position);
-            double calculate_beta(const InstrumentId &instrument, const InstrumentId &benchmark);
-            double calculate_tracking_error(const Portfolio &portfolio, const InstrumentId &benchmark);
+            double calculate_beta(InstrumentHandle instrument, InstrumentHandle benchmark);
+            double calculate_tracking_error(const Portfolio &portfolio, InstrumentHandle benchmark);
 
             void update_price_history(const MarketSnapshot &market_data);
+            void record_price(InstrumentHandle instrument, Price price);
+            void set_correlation_matrix(std::shared_ptr<const stats::StreamingCorrelationMatrix> matrix)
+            {
+                correlation_matrix_ = std::move(matrix);
+                ++history_version_;
+            }
+
+            // VaR, ES and per-position contributions (in portfolio.positions order) from one run
+            MonteCarloRiskResult calculate_portfolio_risk(const Portfolio &portfolio, double confidence_level = 0.95);
+
+            // The same for the book plus a candidate position, whose contribution comes last
+            MonteCarloRiskResult calculate_pre_trade_risk(const Portfolio &portfolio, const Position &candidate,
+                                                          double confidence_level = 0.95);
+
+            void set_monte_carlo_config(const MonteCarloConfig &config);
+            void set_execution_mode(concurrency::ExecutionMode mode,
+                                    std::shared_ptr<concurrency::WorkStealingPool> pool = nullptr);
+            void set_max_factor_age(std::chrono::milliseconds age) { max_factor_age_ = age; }
         };
 
         class ArbitrageLegOptimizer // optimizes arbitrage legs for various objectives
@@ -434,20 +497,20 @@ namespace spe
             RiskParameters risk_params_;
 
             // Optimization methods
-            std::vector<ArbitrageLeg> optimize_leg_weights(
-                const std::vector<ArbitrageLeg> &initial_legs,
+            LegVector optimize_leg_weights(
+                const LegVector &initial_legs,
                 const MarketSnapshot &market_data);
 
-            std::vector<ArbitrageLeg> optimize_execution_timing(
-                const std::vector<ArbitrageLeg> &legs,
+            LegVector optimize_execution_timing(
+                const LegVector &legs,
                 const MarketSnapshot &market_data);
 
             double calculate_leg_efficiency(
                 const ArbitrageLeg &leg,
                 const MarketSnapshot &market_data);
 
-            std::vector<ArbitrageLeg> balance_risk_across_legs(
-                const std::vector<ArbitrageLeg> &legs,
+            LegVector balance_risk_across_legs(
+                const LegVector &legs,
                 const Portfolio &portfolio);
 
         public:
@@ -455,122 +518,262 @@ namespace spe
                                   std::unique_ptr<IRiskCalculator> calculator,
                                   const RiskParameters &params = RiskParameters{});
 
-            std::vector<ArbitrageLeg> optimize_arbitrage_legs(
+            LegVector optimize_arbitrage_legs(
                 const ArbitrageOpportunity &opportunity,
                 const Portfolio &portfolio,
                 const MarketSnapshot &market_data);
 
             double calculate_optimal_hedge_ratio(
-                const InstrumentId &instrument1,
-                const InstrumentId &instrument2,
+                InstrumentHandle instrument1,
+                InstrumentHandle instrument2,
                 const MarketSnapshot &market_data);
 
-            std::vector<ArbitrageLeg> create_delta_neutral_legs(
+            LegVector create_delta_neutral_legs(
                 const ArbitrageOpportunity &opportunity,
                 const MarketSnapshot &market_data);
 
-            std::vector<ArbitrageLeg> minimize_transaction_costs(
-                const std::vector<ArbitrageLeg> &legs,
+            LegVector minimize_transaction_costs(
+                const LegVector &legs,
                 const MarketSnapshot &market_data);
 
             double calculate_legs_correlation_risk(
-                const std::vector<ArbitrageLeg> &legs,
+                const LegVector &legs,
                 const MarketSnapshot &market_data);
 
             // Enhanced optimization methods
-            std::vector<ArbitrageLeg> construct_multi_leg_position(
+            LegVector construct_multi_leg_position(
                 const ArbitrageOpportunity &opportunity,
-                const std::vector<InstrumentId> &instruments,
+                const std::vector<InstrumentHandle> &instruments,
                 const MarketSnapshot &market_data);
 
-            std::vector<ArbitrageLeg> optimize_capital_efficiency(
-                const std::vector<ArbitrageLeg> &initial_legs,
+            LegVector optimize_capital_efficiency(
+                const LegVector &initial_legs,
                 const MarketSnapshot &market_data);
 
-            std::vector<ArbitrageLeg> maximize_risk_adjusted_return(
-                const std::vector<ArbitrageLeg> &legs,
+            LegVector maximize_risk_adjusted_return(
+                const LegVector &legs,
                 const MarketSnapshot &market_data);
 
             double calculate_portfolio_sharpe_ratio(
-                const std::vector<ArbitrageLeg> &legs,
+                const LegVector &legs,
                 const MarketSnapshot &market_data);
 
             double calculate_capital_efficiency_ratio(
-                const std::vector<ArbitrageLeg> &legs,
+                const LegVector &legs,
                 const MarketSnapshot &market_data);
 
-            std::vector<ArbitrageLeg> optimize_risk_return_profile(
-                const std::vector<ArbitrageLeg> &legs,
+            LegVector optimize_risk_return_profile(
+                const LegVector &legs,
                 double target_return,
                 double max_risk,
                 const MarketSnapshot &market_data);
 
             double calculate_information_ratio(
-                const std::vector<ArbitrageLeg> &legs,
+                const LegVector &legs,
                 const MarketSnapshot &market_data);
 
-            std::vector<ArbitrageLeg> apply_black_litterman_optimization(
-                const std::vector<ArbitrageLeg> &legs,
+            LegVector apply_black_litterman_optimization(
+                const LegVector &legs,
                 const std::vector<double> &expected_returns,
                 const MarketSnapshot &market_data);
 
         public:
             // Enhanced public methods
-            std::vector<ArbitrageLeg> construct_optimal_multi_leg_strategy(
+            LegVector construct_optimal_multi_leg_strategy(
                 const ArbitrageOpportunity &opportunity,
                 const Portfolio &portfolio,
                 const MarketSnapshot &market_data,
                 const std::string &optimization_objective = "risk_adjusted_return");
 
-            std::vector<ArbitrageLeg> optimize_for_capital_efficiency(
+            LegVector optimize_for_capital_efficiency(
                 const ArbitrageOpportunity &opportunity,
                 double available_capital,
                 const MarketSnapshot &market_data);
 
-            std::vector<ArbitrageLeg> maximize_sharpe_ratio(
+            LegVector maximize_sharpe_ratio(
                 const ArbitrageOpportunity &opportunity,
                 const Portfolio &portfolio,
                 const MarketSnapshot &market_data);
 
             double calculate_strategy_efficiency_metrics(
-                const std::vector<ArbitrageLeg> &legs,
+                const LegVector &legs,
                 const MarketSnapshot &market_data);
 
             std::map<std::string, double> get_optimization_metrics(
-                const std::vector<ArbitrageLeg> &legs,
+                const LegVector &legs,
                 const MarketSnapshot &market_data);
 
-            std::vector<ArbitrageLeg> rebalance_for_optimal_allocation(
-                const std::vector<ArbitrageLeg> &current_legs,
+            LegVector rebalance_for_optimal_allocation(
+                const LegVector &current_legs,
                 const MarketSnapshot &market_data,
                 double rebalancing_threshold = 0.05);
 
-            std::vector<ArbitrageLeg> apply_kelly_criterion_sizing(
-                const std::vector<ArbitrageLeg> &legs,
+            LegVector apply_kelly_criterion_sizing(
+                const LegVector &legs,
                 const std::vector<double> &win_probabilities,
                 const std::vector<double> &expected_returns,
                 const MarketSnapshot &market_data);
         };
 
-        class SyntheticExposureManager // Main class that manages synthetic exposures integrating all other components
+        // A run of consecutive positions in a RiskSnapshot. Chunks are immutable and shared
+        // between versions; a version only rebuilds the chunks whose positions changed.
+        struct RiskPositionChunk
+        {
+            static constexpr size_t CAPACITY = 64;
+
+            std::vector<std::shared_ptr<const Position>> positions;
+            std::vector<RiskLevel> risk_levels; // parallel to positions
+        };
+
+        // Immutable view of the book's risk, published after every change. Readers hold it by
+        // shared_ptr for as long as they like; unchanged positions are shared between versions.
+        struct RiskSnapshot
+        {
+            uint64_t version = 0;
+            Timestamp published;
+
+            double total_exposure = 0.0; // gross position notional plus absolute derivative dollar delta
+            double net_exposure = 0.0;
+            double gross_exposure = 0.0;
+            double total_pnl = 0.0;      // realized plus unrealized
+            double total_var = 0.0;      // as of the last VaR refresh, rescaled to current exposures
+
+            // Derivative Greeks, summed over the book
+            double net_delta = 0.0;
+            double net_gamma = 0.0;
+            double net_vega = 0.0;
+            double net_theta = 0.0;
+
+            // Room left under the limits; negative when breached
+            double var_headroom = 0.0;
+            double position_size_limit = 0.0; // notional allowed per position
+
+            // Position i is in chunk i / RiskPositionChunk::CAPACITY
+            std::vector<std::shared_ptr<const RiskPositionChunk>> position_chunks;
+            size_t position_count = 0;
+            std::vector<std::string> violations;
+
+            const Position &position(size_t index) const
+            {
+                return *position_chunks[index / RiskPositionChunk::CAPACITY]->positions[index % RiskPositionChunk::CAPACITY];
+            }
+            RiskLevel risk_level(size_t index) const
+            {
+                return position_chunks[index / RiskPositionChunk::CAPACITY]->risk_levels[index % RiskPositionChunk::CAPACITY];
+            }
+        };
+
+        // A position rebalance_if_needed cut back to the size limit after price moves grew it
+        struct PositionTrim
+        {
+            std::string position_id;
+            InstrumentHandle instrument = INVALID_INSTRUMENT;
+            Volume previous_size = 0.0;
+            Volume size = 0.0;
+            Price price = 0.0;
+        };
+
+        using PositionTrimCallback = std::function<void(const PositionTrim &)>;
+
+        // Main class that manages synthetic exposures integrating all other components.
+        //
+        // Aggregates are maintained incrementally: a tick only touches the positions and
+        // derivatives of the instruments whose mid moved, applying each one's change in
+        // exposure, P&L and Greeks to the running totals, and limits are checked against
+        // precomputed headroom. Portfolio VaR is the one full calculation; it never runs on the
+        // tick path but on the risk stage (start_risk_stage(), or the caller's own refresh_risk()
+        // calls), at most every var_refresh_interval, on a copy of the book outside
+        // portfolio_mutex_. Per-position VaR is rescaled by exposure between refreshes. Writers
+        // serialize on portfolio_mutex_; readers see the latest RiskSnapshot and never take it.
+        class SyntheticExposureManager
         {
         private:
+            static constexpr double ESTIMATED_DAILY_VOLATILITY = 0.02; // positions the VaR refresh has not seen
+            static constexpr int DERIVATIVE_TENOR_DAYS = 30;
+
             std::unique_ptr<ISyntheticDerivativeConstructor> derivative_constructor_;
             std::unique_ptr<IPositionSizer> position_sizer_;
             std::unique_ptr<IRiskCalculator> risk_calculator_;
             std::unique_ptr<ArbitrageLegOptimizer> leg_optimizer_;
+            AdvancedRiskCalculator *advanced_calculator_; // risk_calculator_ when it reports contributions
 
+            // Writer state, under portfolio_mutex_
             Portfolio portfolio_;
             RiskParameters risk_params_;
             mutable std::mutex portfolio_mutex_;
 
+            using IndexList = memory::SmallVector<uint32_t, 4>;
+            std::unordered_map<InstrumentHandle, IndexList> positions_by_instrument_;
+            std::unordered_map<InstrumentHandle, IndexList> derivatives_by_underlying_;
+            std::unordered_map<std::string, uint32_t> position_index_;
+            std::vector<std::shared_ptr<const Position>> position_nodes_; // parallel to portfolio_.positions
+            std::vector<std::shared_ptr<const RiskPositionChunk>> position_chunks_; // as last published
+            std::vector<uint8_t> stale_chunks_; // per chunk: a position in it changed since
+            std::vector<double> var_basis_;          // per position: VaR contribution at the last refresh
+            std::vector<double> var_basis_exposure_; // and the exposure it was computed at
+            std::vector<uint8_t> size_breaches_;     // per position: over max_position_size
+            std::vector<double> derivative_dollar_deltas_; // parallel to portfolio_.synthetic_derivatives
+            size_t size_breach_count_;
+            double realized_pnl_; // from closed and trimmed positions
+            double current_var_;  // sum of position_var()
+            double derivative_dollar_delta_;
+            double net_delta_;
+            double net_gamma_;
+            double net_vega_;
+            double net_theta_;
+            std::vector<std::string> violations_;
+            bool var_stale_;
+
+            // VaR refresh; holds var_mutex_ but not portfolio_mutex_ while simulating
+            std::mutex var_mutex_;
+            std::mutex history_mutex_; // taken after var_mutex_
+            std::vector<std::pair<InstrumentHandle, Price>> pending_prices_; // for the calculator, while a refresh holds it
+            std::chrono::steady_clock::time_point last_var_refresh_;
+            std::chrono::milliseconds var_refresh_interval_;
+
+            // Risk stage thread; risk_stage_mutex_ guards risk_stage_running_ and its wake-ups
+            std::thread risk_stage_thread_;
+            std::mutex risk_stage_mutex_;
+            std::condition_variable risk_stage_wakeup_;
+            bool risk_stage_running_;
+
+            PositionTrimCallback trim_callback_; // under portfolio_mutex_, called outside it
+
+            concurrency::DoubleBuffered<std::shared_ptr<const RiskSnapshot>> snapshot_;
+            std::shared_ptr<RiskHeadroomFeed> headroom_feed_; // stored with every snapshot
+            std::atomic<uint64_t> next_position_id_;
+            std::atomic<uint64_t> next_derivative_id_;
+
             // Internal methods
-            void update_portfolio_metrics();
+            void update_portfolio_metrics(); // full recomputation of the aggregates
             void check_risk_limits();
-            void rebalance_if_needed(const MarketSnapshot &market_data);
+            void rebalance_if_needed(const MarketSnapshot &market_data, std::vector<PositionTrim> &trims);
             std::string generate_position_id();
             std::string generate_derivative_id();
 
+            // Incremental bookkeeping, under portfolio_mutex_
+            void add_position(Position position);
+            void remove_position(uint32_t index);
+            bool apply_price(uint32_t index, Price price, Timestamp time);
+            void resize_position(uint32_t index, Volume size);
+            void apply_derivative(uint32_t index, Price underlying_price, double sign);
+            void add_derivative(SyntheticDerivative derivative, Price underlying_price);
+            std::vector<uint32_t> find_positions(const std::string &position_id) const; // it and its legs/hedges
+            void update_size_breach(uint32_t index);
+            void mark_position(uint32_t index); // its chunk is rebuilt by the next publish_snapshot()
+            void mark_all_positions();
+            double position_var(uint32_t index) const;
+            RiskLevel position_risk_level(uint32_t index) const;
+            void publish_snapshot();
+
+            void refresh_value_at_risk();
+            bool value_at_risk_due() const; // under portfolio_mutex_
+            void apply_pending_prices();    // under var_mutex_ and history_mutex_
+            void risk_stage_loop(concurrency::StagePlacement placement);
+            std::shared_ptr<const RiskSnapshot> current_snapshot() const;
+
+            friend struct SyntheticExposureManagerTestAccess; // drives the incremental bookkeeping directly
+
         public:
             SyntheticExposureManager(
                 std::unique_ptr<ISyntheticDerivativeConstructor> constructor,
@@ -578,11 +781,15 @@ namespace spe
                 std::unique_ptr<IRiskCalculator> calculator,
                 std::unique_ptr<ArbitrageLegOptimizer> optimizer,
                 const RiskParameters &params = RiskParameters{});
+            ~SyntheticExposureManager();
+
+            SyntheticExposureManager(const SyntheticExposureManager &) = delete;
+            SyntheticExposureManager &operator=(const SyntheticExposureManager &) = delete;
 
             // Core functionality
             std::string add_synthetic_derivative(
                 DerivativeType type,
-                const InstrumentId &underlying,
+                InstrumentHandle underlying,
                 const MarketSnapshot &market_data);
 
             std::string execute_arbitrage_opportunity(
@@ -611,6 +818,25 @@ namespace spe
             double get_portfolio_var() const;
             double get_portfolio_exposure() const;
             std::map<std::string, double> get_risk_metrics() const;
+
+            // Lock-free; the snapshot stays valid while held
+            std::shared_ptr<const RiskSnapshot> get_risk_snapshot() const { return current_snapshot(); }
+
+            // Portfolio VaR is recomputed at most this often, and only after the book changed
+            void set_var_refresh_interval(std::chrono::milliseconds interval);
+            void refresh_risk() { refresh_value_at_risk(); } // immediately, on the calling thread
+
+            // Runs the VaR refresh on its own thread, placed per ThreadTopology::RISK: woken when
+            // a tick finds a refresh due, and every var_refresh_interval otherwise. Without it
+            // the caller's risk stage calls refresh_risk() itself. False if already running.
+            bool start_risk_stage(const concurrency::StagePlacement &placement = concurrency::StagePlacement{});
+            void stop_risk_stage();
+
+            // Called for each trim, on the thread that applied the tick, outside the book's lock
+            void set_trim_callback(PositionTrimCallback callback);
+
+            // Publishes the pre-trade headroom to engines' screens from now on, starting with the current book
+            void set_headroom_feed(std::shared_ptr<RiskHeadroomFeed> feed);
         };
 
     } // namespace exposure
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "data_feed.hpp"
+#include "exchange_types.hpp"
+#include "latency_histogram.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace spe
+{
+    namespace exchange_ws
+    {
+
+        using LineId = uint8_t;
+
+        // Per-line arbitration counters. lag holds, for each message this line delivered second,
+        // how long after the winning line it arrived.
+        struct LineStats
+        {
+            std::atomic<uint64_t> wins{0};       // first arrival, delivered
+            std::atomic<uint64_t> duplicates{0}; // already delivered by another line, dropped
+            std::atomic<uint64_t> gap_fills{0};  // trade the faster line skipped, delivered from this one
+            std::atomic<uint64_t> stale{0};      // book older than one already delivered, dropped
+            telemetry::LatencyHistogram lag;
+
+            // Share of the messages this line saw that it delivered first
+            double win_rate() const
+            {
+                uint64_t won = wins.load(std::memory_order_relaxed);
+                uint64_t seen = won + duplicates.load(std::memory_order_relaxed);
+                return seen == 0 ? 0.0 : static_cast<double>(won) / static_cast<double>(seen);
+            }
+        };
+
+        // Merges redundant connections to the same channels (A/B lines, possibly in different
+        // regions) into one stream per instrument: the first arrival of each exchange sequence
+        // number is delivered, later copies are dropped and timed against it. Install one
+        // handler per line with set_orderbook_callback/set_trade_callback.
+        //
+        // Each stream keeps a WINDOW-wide bitmap of delivered sequence numbers below the
+        // highest seen, as in IPsec replay protection. A trade below the highest that no line
+        // has delivered yet is a gap the winning line skipped, and is delivered from whichever
+        // line fills it. A book snapshot supersedes everything before it, so an older one is
+        // only dropped. Messages without a sequence number (trades fall back to a numeric
+        // trade_id) and instruments past the capacity pass through unarbitrated.
+        //
+        // Lines may call in from different threads; a stream is locked while it is classified
+        // and delivered, so downstream sees each instrument in order but callbacks run on
+        // whichever line's thread won.
+        class FeedArbiter
+        {
+        public:
+            static constexpr size_t MAX_LINES = 4;
+            static constexpr uint64_t WINDOW = 64;
+
+        private:
+            enum class Arrival
+            {
+                NEW,
+                GAP_FILL,
+                DUPLICATE,
+                STALE
+            };
+
+            struct SequenceWindow
+            {
+                uint64_t highest = 0;
+                uint64_t delivered = 0;                    // bit i: highest - i was delivered
+                std::array<int64_t, WINDOW> first_arrival; // ns, indexed by sequence % WINDOW
+
+                // lag: behind the first copy, for DUPLICATE; skipped: numbers jumped over, for NEW
+                Arrival classify(uint64_t sequence, int64_t now, int64_t &lag, uint64_t &skipped);
+            };
+
+            struct Stream
+            {
+                std::mutex mutex;
+                SequenceWindow books;
+                SequenceWindow trades;
+            };
+
+            size_t capacity_;
+            std::unique_ptr<Stream[]> streams_;
+            std::array<LineStats, MAX_LINES> lines_;
+            std::atomic<uint64_t> gaps_opened_{0}; // sequence numbers skipped by a new high
+            std::atomic<uint64_t> unarbitrated_{0};
+
+            OrderBookCallback orderbook_callback_;
+            data_feed::TradeCallback trade_callback_;
+
+            static int64_t now_ns();
+            static uint64_t trade_sequence(const Trade &trade);
+
+        public:
+            // Instruments are arbitrated for handles below capacity
+            explicit FeedArbiter(size_t capacity);
+
+            FeedArbiter(const FeedArbiter &) = delete;
+            FeedArbiter &operator=(const FeedArbiter &) = delete;
+
+            // Downstream, e.g. the detectors; set before any line connects
+            void set_orderbook_callback(OrderBookCallback callback) { orderbook_callback_ = std::move(callback); }
+            void set_trade_callback(data_feed::TradeCallback callback) { trade_callback_ = std::move(callback); }
+
+            void on_orderbook(LineId line, const OrderBookSnapshot &snapshot);
+            void on_trade(LineId line, const Trade &trade);
+
+            // Handlers to install on line's connection
+            OrderBookCallback orderbook_handler(LineId line)
+            {
+                return [this, line](const OrderBookSnapshot &snapshot) { on_orderbook(line, snapshot); };
+            }
+            data_feed::TradeCallback trade_handler(LineId line)
+            {
+                return [this, line](const Trade &trade) { on_trade(line, trade); };
+            }
+
+            // Forgets an instrument's sequence history, e.g. after the venue resets its sequence
+            void reset(InstrumentHandle instrument);
+
+            const LineStats &line_stats(LineId line) const { return lines_[line]; }
+            uint64_t gaps_opened() const { return gaps_opened_.load(std::memory_order_relaxed); }
+            uint64_t gaps_filled() const;
+            uint64_t unarbitrated() const { return unarbitrated_.load(std::memory_order_relaxed); }
+        };
+
+    } // namespace exchange_ws
+} // namespace spe
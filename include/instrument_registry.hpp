@@ -0,0 +1,54 @@
+#pragma once
+
+#include "market_data.hpp"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace spe
+{
+    namespace market_data
+    {
+
+        // Maps exchange symbols to dense 32-bit handles. Symbols are interned once at
+        // subscription/configuration time; the hot path only ever sees handles, and the
+        // string form is looked up again only for logging and opportunity ids.
+        class InstrumentRegistry
+        {
+        private:
+            mutable std::mutex mutex_;
+            std::unordered_map<InstrumentId, InstrumentHandle> handles_;
+            std::deque<InstrumentId> symbols_; // deque keeps references stable on growth
+            std::atomic<size_t> size_;
+
+        public:
+            InstrumentRegistry();
+
+            InstrumentRegistry(const InstrumentRegistry &) = delete;
+            InstrumentRegistry &operator=(const InstrumentRegistry &) = delete;
+
+            // Process-wide registry shared by feeds, detectors and engines
+            static InstrumentRegistry &instance();
+
+            InstrumentHandle intern(const InstrumentId &symbol);
+            InstrumentHandle find(const InstrumentId &symbol) const; // INVALID_INSTRUMENT if unknown
+            const InstrumentId &symbol(InstrumentHandle handle) const;
+
+            // Number of handles issued; handles are always < size()
+            size_t size() const { return size_.load(std::memory_order_acquire); }
+        };
+
+        // Shorthands for the global registry
+        inline InstrumentHandle intern_instrument(const InstrumentId &symbol)
+        {
+            return InstrumentRegistry::instance().intern(symbol);
+        }
+
+        inline const InstrumentId &instrument_symbol(InstrumentHandle handle)
+        {
+            return InstrumentRegistry::instance().symbol(handle);
+        }
+
+    } // namespace market_data
+} // namespace spe
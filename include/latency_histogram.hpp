@@ -0,0 +1,145 @@
+#pragma once
+
+#include "bit_ops.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace spe
+{
+    namespace telemetry
+    {
+
+        // HDR-style log-linear histogram of nanosecond latencies. Values below 64 ns get exact
+        // buckets; above that every power of two is split into 32 buckets, so a bucket is never
+        // wider than ~3% of its value. Values past ~18 minutes land in the last bucket.
+        //
+        // record() is meant for a single writing thread: it bumps relaxed atomics without a
+        // read-modify-write, so another thread can merge() a consistent-enough copy at any time
+        // without stalling the writer.
+        class LatencyHistogram
+        {
+        public:
+            static constexpr unsigned SUB_BUCKET_BITS = 6;
+            static constexpr uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BUCKET_BITS;
+            static constexpr uint64_t HALF_SUB_BUCKETS = SUB_BUCKETS / 2;
+            static constexpr unsigned MAX_VALUE_BITS = 40;
+            static constexpr size_t BUCKET_COUNT =
+                (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+
+        private:
+            std::atomic<uint64_t> counts_[BUCKET_COUNT];
+            std::atomic<uint64_t> total_count_;
+            std::atomic<uint64_t> total_nanoseconds_;
+
+            static void bump(std::atomic<uint64_t> &counter, uint64_t amount)
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+            }
+
+        public:
+            LatencyHistogram() { clear(); }
+
+            LatencyHistogram(const LatencyHistogram &) = delete;
+            LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+            static size_t bucket_index(uint64_t nanoseconds)
+            {
+                if (nanoseconds < SUB_BUCKETS)
+                {
+                    return static_cast<size_t>(nanoseconds);
+                }
+                unsigned msb = bits::highest_bit(nanoseconds);
+                if (msb >= MAX_VALUE_BITS)
+                {
+                    return BUCKET_COUNT - 1;
+                }
+                unsigned shift = msb - (SUB_BUCKET_BITS - 1);
+                return static_cast<size_t>(shift * HALF_SUB_BUCKETS + (nanoseconds >> shift));
+            }
+
+            // Largest value that maps to the bucket
+            static uint64_t bucket_upper_bound(size_t index)
+            {
+                if (index < SUB_BUCKETS)
+                {
+                    return index;
+                }
+                uint64_t shift = index / HALF_SUB_BUCKETS - 1;
+                uint64_t mantissa = index - shift * HALF_SUB_BUCKETS;
+                return ((mantissa + 1) << shift) - 1;
+            }
+
+            void record(uint64_t nanoseconds)
+            {
+                bump(counts_[bucket_index(nanoseconds)], 1);
+                bump(total_count_, 1);
+                bump(total_nanoseconds_, nanoseconds);
+            }
+
+            // Adds other's counts (sign = -1 subtracts an earlier copy of the same series)
+            void merge(const LatencyHistogram &other, int sign = 1)
+            {
+                for (size_t i = 0; i < BUCKET_COUNT; ++i)
+                {
+                    uint64_t count = other.counts_[i].load(std::memory_order_relaxed);
+                    bump(counts_[i], sign > 0 ? count : uint64_t(0) - count);
+                }
+                uint64_t count = other.total_count_.load(std::memory_order_relaxed);
+                uint64_t total = other.total_nanoseconds_.load(std::memory_order_relaxed);
+                bump(total_count_, sign > 0 ? count : uint64_t(0) - count);
+                bump(total_nanoseconds_, sign > 0 ? total : uint64_t(0) - total);
+            }
+
+            // Not safe against a concurrent record()
+            void clear()
+            {
+                for (auto &count : counts_)
+                {
+                    count.store(0, std::memory_order_relaxed);
+                }
+                total_count_.store(0, std::memory_order_relaxed);
+                total_nanoseconds_.store(0, std::memory_order_relaxed);
+            }
+
+            uint64_t count() const { return total_count_.load(std::memory_order_relaxed); }
+
+            double mean() const
+            {
+                uint64_t n = count();
+                return n ? static_cast<double>(total_nanoseconds_.load(std::memory_order_relaxed)) / static_cast<double>(n) : 0.0;
+            }
+
+            // Upper bound of the bucket holding the q-quantile (q in [0, 1]); 0 when empty
+            uint64_t percentile(double q) const
+            {
+                uint64_t n = 0;
+                for (const auto &bucket : counts_)
+                {
+                    n += bucket.load(std::memory_order_relaxed);
+                }
+                if (n == 0)
+                {
+                    return 0;
+                }
+                uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(n) + 0.5);
+                rank = rank < 1 ? 1 : (rank > n ? n : rank);
+
+                uint64_t seen = 0;
+                for (size_t i = 0; i < BUCKET_COUNT; ++i)
+                {
+                    seen += counts_[i].load(std::memory_order_relaxed);
+                    if (seen >= rank)
+                    {
+                        return bucket_upper_bound(i);
+                    }
+                }
+                return bucket_upper_bound(BUCKET_COUNT - 1);
+            }
+
+            uint64_t min() const { return percentile(0.0); }
+            uint64_t max() const { return percentile(1.0); }
+        };
+
+    } // namespace telemetry
+} // namespace spe
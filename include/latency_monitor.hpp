@@ -0,0 +1,195 @@
+#pragma once
+
+#include "latency_histogram.hpp"
+#include "market_data.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(SPE_LATENCY_USE_TSC) && (defined(__x86_64__) || defined(_M_X64))
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace spe
+{
+    namespace telemetry
+    {
+
+        // Hot-path stages, in the order a tick goes through them
+        enum class LatencyStage
+        {
+            PARSE,        // wire frame -> decoded message
+            BOOK_UPDATE,  // decoded message applied to the order book
+            QUEUE,        // feed publish -> picked up by the detector thread
+            DETECTION,    // detector update + detect for one batch
+            VALIDATION,   // arbitrage engine update, mispricing processing and identification
+            CALLBACK,     // output callback
+            END_TO_END,   // feed receive time -> output callback
+            COUNT
+        };
+
+        const char *stage_name(LatencyStage stage);
+
+        using SeriesId = uint32_t;
+        constexpr SeriesId INVALID_SERIES = UINT32_MAX;
+
+        // Cheap monotonic ticks: the TSC when built with SPE_LATENCY_USE_TSC on x86-64 (assumes
+        // an invariant TSC), steady_clock otherwise
+        class LatencyClock
+        {
+        public:
+            static uint64_t now()
+            {
+#if defined(SPE_LATENCY_USE_TSC) && (defined(__x86_64__) || defined(_M_X64))
+                return __rdtsc();
+#else
+                return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                 std::chrono::steady_clock::now().time_since_epoch())
+                                                 .count());
+#endif
+            }
+
+            static uint64_t to_nanoseconds(uint64_t ticks);
+        };
+
+        struct LatencySummary
+        {
+            std::string source; // exchange or engine the series belongs to
+            LatencyStage stage;
+            uint64_t count = 0;
+            double mean_ns = 0.0;
+            uint64_t min_ns = 0;
+            uint64_t p50_ns = 0;
+            uint64_t p90_ns = 0;
+            uint64_t p99_ns = 0;
+            uint64_t p999_ns = 0;
+            uint64_t max_ns = 0;
+        };
+
+        using LatencyReportSink = std::function<void(const std::vector<LatencySummary> &)>;
+
+        // Process-wide latency registry. A series is a (source, stage) pair, interned once and
+        // then recorded by id. Each thread records into its own histograms, so record() is a
+        // thread-local lookup plus a few relaxed stores; collect() merges the threads' copies on
+        // the caller's thread.
+        class LatencyMonitor
+        {
+        public:
+            static constexpr size_t MAX_SERIES = 256;
+
+        private:
+            struct ThreadHistograms
+            {
+                std::atomic<LatencyHistogram *> series[MAX_SERIES];
+                std::vector<std::unique_ptr<LatencyHistogram>> owned; // guarded by the monitor mutex
+                std::atomic<bool> in_use;
+
+                ThreadHistograms() : in_use(true)
+                {
+                    for (auto &entry : series)
+                    {
+                        entry.store(nullptr, std::memory_order_relaxed);
+                    }
+                }
+            };
+
+            struct ThreadSlot; // thread_local owner that hands the block back on thread exit
+
+            mutable std::mutex mutex_;
+            std::vector<std::pair<std::string, LatencyStage>> series_;
+            std::vector<std::unique_ptr<ThreadHistograms>> threads_; // never freed; reused after thread exit
+            std::vector<std::unique_ptr<LatencyHistogram>> previous_; // totals at the last interval collect
+
+            std::mutex dump_mutex_;
+            std::condition_variable dump_wake_;
+            std::thread dump_thread_;
+            bool dump_running_;
+
+            ThreadHistograms &local();
+            LatencyHistogram &local_histogram(SeriesId series);
+
+            LatencyMonitor(); // one per process, through instance(); thread-local blocks assume as much
+
+        public:
+            ~LatencyMonitor();
+
+            LatencyMonitor(const LatencyMonitor &) = delete;
+            LatencyMonitor &operator=(const LatencyMonitor &) = delete;
+
+            static LatencyMonitor &instance();
+
+            // Interns (source, stage); cache the id, this takes a lock. INVALID_SERIES past MAX_SERIES.
+            SeriesId series(const std::string &source, LatencyStage stage);
+
+            void record(SeriesId series, uint64_t nanoseconds)
+            {
+                if (series < MAX_SERIES)
+                {
+                    local_histogram(series).record(nanoseconds);
+                }
+            }
+
+            void record_ticks(SeriesId series, uint64_t start_ticks)
+            {
+                record(series, LatencyClock::to_nanoseconds(LatencyClock::now() - start_ticks));
+            }
+
+            // Latency from a wall-clock stamp such as Quote::timestamp or MarketEvent::receive_time
+            void record_since(SeriesId series, market_data::Timestamp start)
+            {
+                auto elapsed = std::chrono::high_resolution_clock::now() - start;
+                record(series, elapsed.count() > 0 ? static_cast<uint64_t>(
+                                                         std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+                                                   : 0);
+            }
+
+            // Every series with samples; interval = true reports only what arrived since the last
+            // interval collect
+            std::vector<LatencySummary> collect(bool interval = false);
+
+            // Calls sink (default: print to stdout) with an interval collect every period
+            void start_periodic_dump(std::chrono::milliseconds period, LatencyReportSink sink = nullptr);
+            void stop_periodic_dump();
+
+            static std::string format(const std::vector<LatencySummary> &summaries);
+        };
+
+        // Records the lifetime of the scope into a series
+        class ScopedLatency
+        {
+        private:
+            SeriesId series_;
+            uint64_t start_;
+
+        public:
+            explicit ScopedLatency(SeriesId series) : series_(series), start_(LatencyClock::now()) {}
+            ~ScopedLatency() { LatencyMonitor::instance().record_ticks(series_, start_); }
+
+            ScopedLatency(const ScopedLatency &) = delete;
+            ScopedLatency &operator=(const ScopedLatency &) = delete;
+        };
+
+    } // namespace telemetry
+} // namespace spe
+
+// Instrumentation points compile away unless the build defines SPE_LATENCY_TRACING
+#if defined(SPE_LATENCY_TRACING)
+#define SPE_LATENCY_CONCAT_INNER(a, b) a##b
+#define SPE_LATENCY_CONCAT(a, b) SPE_LATENCY_CONCAT_INNER(a, b)
+#define SPE_LATENCY_SCOPE(series) ::spe::telemetry::ScopedLatency SPE_LATENCY_CONCAT(spe_latency_scope_, __LINE__)(series)
+#define SPE_LATENCY_RECORD_SINCE(series, start) ::spe::telemetry::LatencyMonitor::instance().record_since(series, start)
+#else
+#define SPE_LATENCY_SCOPE(series) ((void)0)
+#define SPE_LATENCY_RECORD_SINCE(series, start) ((void)0)
+#endif
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "correlation_matrix.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace spe
+{
+    namespace linalg
+    {
+
+        using market_data::InstrumentHandle;
+
+        // Row-major matrix in one contiguous block. Rows are padded to a multiple of
+        // ROW_ALIGNMENT doubles, with the padding kept at zero; the kernels below still loop
+        // over cols() only, as the vectors they take are not padded.
+        class DenseMatrix
+        {
+        public:
+            static constexpr size_t ROW_ALIGNMENT = 8;
+
+        private:
+            size_t rows_;
+            size_t cols_;
+            size_t stride_;
+            std::vector<double> data_;
+
+        public:
+            explicit DenseMatrix(size_t rows = 0, size_t cols = 0) { resize(rows, cols); }
+
+            // Zeroes the contents; keeps the allocation when it is large enough
+            void resize(size_t rows, size_t cols);
+            void fill(double value);
+            void set_identity(size_t dimension);
+
+            size_t rows() const { return rows_; }
+            size_t cols() const { return cols_; }
+            size_t stride() const { return stride_; }
+
+            double &operator()(size_t row, size_t col) { return data_[row * stride_ + col]; }
+            double operator()(size_t row, size_t col) const { return data_[row * stride_ + col]; }
+            double *row(size_t row) { return data_.data() + row * stride_; }
+            const double *row(size_t row) const { return data_.data() + row * stride_; }
+        };
+
+        double dot(const double *a, const double *b, size_t n);
+
+        // y = A x; y must not alias x
+        void multiply(const DenseMatrix &a, const double *x, double *y);
+
+        // x' A x
+        double quadratic_form(const DenseMatrix &a, const double *x);
+
+        // out = A restricted to the given rows and columns
+        void gather_principal(const DenseMatrix &a, const std::vector<size_t> &indices, DenseMatrix &out);
+
+        // Covariance of the instruments from the shared streaming matrix (n x n); each pair is
+        // read once and mirrored
+        void gather_covariance(const stats::StreamingCorrelationMatrix &matrix,
+                               const std::vector<InstrumentHandle> &instruments, DenseMatrix &out);
+        // Covariance of each instrument with the target (n)
+        void gather_cross_covariance(const stats::StreamingCorrelationMatrix &matrix,
+                                     const std::vector<InstrumentHandle> &instruments, InstrumentHandle target,
+                                     std::vector<double> &cross);
+
+        struct RidgeSolution
+        {
+            size_t iterations = 0;
+            double residual = 0.0; // |b - (A + lambda I) x| / |b|
+            bool converged = false;
+        };
+
+        // Solves (A + lambda I) x = b for symmetric positive semi-definite A by conjugate
+        // gradients, starting from the x passed in. A warm start from the previous bar's
+        // solution, when A and b have only drifted, converges in a handful of iterations
+        // instead of the n an exact solve needs. Scratch vectors are kept between solves.
+        class RidgeSolver
+        {
+        private:
+            std::vector<double> residual_;
+            std::vector<double> direction_;
+            std::vector<double> product_;
+
+        public:
+            static constexpr double DEFAULT_TOLERANCE = 1e-10;
+
+            // max_iterations 0 means the dimension, which is exact in exact arithmetic
+            RidgeSolution solve(const DenseMatrix &a, const double *b, double lambda, double *x,
+                                double tolerance = DEFAULT_TOLERANCE, size_t max_iterations = 0);
+        };
+
+    } // namespace linalg
+} // namespace spe
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace spe
+{
+    namespace concurrency
+    {
+
+        constexpr size_t CACHE_LINE_SIZE = 64;
+
+        inline size_t round_up_to_power_of_two(size_t value)
+        {
+            size_t result = 1;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        // Bounded single-producer/single-consumer ring. Capacity is rounded up to a power of
+        // two. Each side keeps a cached copy of the other side's index, so the shared cache
+        // lines are only touched when the ring looks full (producer) or empty (consumer).
+        template <typename T>
+        class SpscRing
+        {
+        private:
+            std::vector<T> slots_;
+            size_t mask_;
+
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_; // written by the producer
+            size_t cached_head_;
+
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_; // written by the consumer
+            size_t cached_tail_;
+
+        public:
+            explicit SpscRing(size_t capacity)
+                : slots_(round_up_to_power_of_two(capacity < 2 ? 2 : capacity)), mask_(slots_.size() - 1),
+                  tail_(0), cached_head_(0), head_(0), cached_tail_(0) {}
+
+            SpscRing(const SpscRing &) = delete;
+            SpscRing &operator=(const SpscRing &) = delete;
+
+            // Producer only
+            bool try_push(T &&value)
+            {
+                size_t tail = tail_.load(std::memory_order_relaxed);
+                if (tail - cached_head_ == slots_.size())
+                {
+                    cached_head_ = head_.load(std::memory_order_acquire);
+                    if (tail - cached_head_ == slots_.size())
+                    {
+                        return false;
+                    }
+                }
+
+                slots_[tail & mask_] = std::move(value);
+                tail_.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            bool try_push(const T &value)
+            {
+                T copy(value);
+                return try_push(std::move(copy));
+            }
+
+            // Consumer only
+            bool try_pop(T &out)
+            {
+                size_t head = head_.load(std::memory_order_relaxed);
+                if (head == cached_tail_)
+                {
+                    cached_tail_ = tail_.load(std::memory_order_acquire);
+                    if (head == cached_tail_)
+                    {
+                        return false;
+                    }
+                }
+
+                out = std::move(slots_[head & mask_]);
+                head_.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+            // Consumer only: hands up to max_items to sink(T&) and releases them with one store
+            template <typename Sink>
+            size_t pop_batch(Sink &&sink, size_t max_items)
+            {
+                size_t head = head_.load(std::memory_order_relaxed);
+                if (head == cached_tail_)
+                {
+                    cached_tail_ = tail_.load(std::memory_order_acquire);
+                }
+
+                size_t available = cached_tail_ - head;
+                size_t count = available < max_items ? available : max_items;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    sink(slots_[(head + i) & mask_]);
+                }
+                if (count > 0)
+                {
+                    head_.store(head + count, std::memory_order_release);
+                }
+                return count;
+            }
+
+            size_t size_approx() const
+            {
+                size_t tail = tail_.load(std::memory_order_acquire);
+                size_t head = head_.load(std::memory_order_acquire);
+                return tail >= head ? tail - head : 0;
+            }
+
+            size_t capacity() const { return slots_.size(); }
+        };
+
+        // Bounded multi-producer/single-consumer ring (Vyukov's sequenced-cell queue). Producers
+        // claim a cell with one CAS on the tail; the per-cell sequence number tells the consumer
+        // when a claimed cell has actually been written.
+        template <typename T>
+        class MpscRing
+        {
+        private:
+            struct Cell
+            {
+                std::atomic<size_t> sequence;
+                T value;
+            };
+
+            std::unique_ptr<Cell[]> cells_;
+            size_t capacity_;
+            size_t mask_;
+
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_;
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_;
+
+        public:
+            explicit MpscRing(size_t capacity)
+                : capacity_(round_up_to_power_of_two(capacity < 2 ? 2 : capacity)), mask_(capacity_ - 1),
+                  tail_(0), head_(0)
+            {
+                cells_.reset(new Cell[capacity_]);
+                for (size_t i = 0; i < capacity_; ++i)
+                {
+                    cells_[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            MpscRing(const MpscRing &) = delete;
+            MpscRing &operator=(const MpscRing &) = delete;
+
+            // Any thread
+            bool try_push(T &&value)
+            {
+                size_t position = tail_.load(std::memory_order_relaxed);
+                Cell *cell;
+                for (;;)
+                {
+                    cell = &cells_[position & mask_];
+                    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                    intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                    if (difference == 0)
+                    {
+                        if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        {
+                            break;
+                        }
+                    }
+                    else if (difference < 0)
+                    {
+                        return false; // full
+                    }
+                    else
+                    {
+                        position = tail_.load(std::memory_order_relaxed);
+                    }
+                }
+
+                cell->value = std::move(value);
+                cell->sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+
+            bool try_push(const T &value)
+            {
+                T copy(value);
+                return try_push(std::move(copy));
+            }
+
+            // Consumer only
+            bool try_pop(T &out)
+            {
+                size_t position = head_.load(std::memory_order_relaxed);
+                Cell &cell = cells_[position & mask_];
+                if (cell.sequence.load(std::memory_order_acquire) != position + 1)
+                {
+                    return false; // empty, or the producer has not finished writing
+                }
+
+                out = std::move(cell.value);
+                cell.sequence.store(position + capacity_, std::memory_order_release);
+                head_.store(position + 1, std::memory_order_relaxed);
+                return true;
+            }
+
+            template <typename Sink>
+            size_t pop_batch(Sink &&sink, size_t max_items)
+            {
+                size_t position = head_.load(std::memory_order_relaxed);
+                size_t count = 0;
+                while (count < max_items)
+                {
+                    Cell &cell = cells_[position & mask_];
+                    if (cell.sequence.load(std::memory_order_acquire) != position + 1)
+                    {
+                        break;
+                    }
+                    sink(cell.value);
+                    cell.sequence.store(position + capacity_, std::memory_order_release);
+                    ++position;
+                    ++count;
+                }
+                head_.store(position, std::memory_order_relaxed);
+                return count;
+            }
+
+            size_t size_approx() const
+            {
+                size_t tail = tail_.load(std::memory_order_acquire);
+                size_t head = head_.load(std::memory_order_acquire);
+                return tail >= head ? tail - head : 0;
+            }
+
+            size_t capacity() const { return capacity_; }
+        };
+
+    } // namespace concurrency
+} // namespace spe
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <chrono>
+#include <cstdint>
 #include <vector>
 #include <map>
 #include <memory>
@@ -16,6 +17,10 @@ namespace spe
         using Volume = double;
         using InstrumentId = std::string;
 
+        // Dense handle issued by InstrumentRegistry; used as the key everywhere on the hot path
+        using InstrumentHandle = uint32_t;
+        constexpr InstrumentHandle INVALID_INSTRUMENT = UINT32_MAX;
+
         enum class InstrumentType
         {
             SPOT,
@@ -33,7 +38,7 @@ namespace spe
 
         struct Quote
         {
-            InstrumentId instrument_id;
+            InstrumentHandle instrument;
             Price bid_price;
             Price ask_price;
             Volume bid_size;
@@ -42,8 +47,8 @@ namespace spe
             uint64_t sequence_number;
 
             Quote() = default;
-            Quote(const InstrumentId &id, Price bid, Price ask, Volume bid_vol, Volume ask_vol)
-                : instrument_id(id), bid_price(bid), ask_price(ask),
+            Quote(InstrumentHandle handle, Price bid, Price ask, Volume bid_vol, Volume ask_vol)
+                : instrument(handle), bid_price(bid), ask_price(ask),
                   bid_size(bid_vol), ask_size(ask_vol),
                   timestamp(std::chrono::high_resolution_clock::now()),
                   sequence_number(0) {}
@@ -51,7 +56,7 @@ namespace spe
 
         struct Trade
         {
-            InstrumentId instrument_id;
+            InstrumentHandle instrument;
             Price price;
             Volume size;
             Side side;
@@ -60,8 +65,8 @@ namespace spe
             std::string trade_id;
 
             Trade() = default;
-            Trade(const InstrumentId &id, Price p, Volume s, Side sd)
-                : instrument_id(id), price(p), size(s), side(sd),
+            Trade(InstrumentHandle handle, Price p, Volume s, Side sd)
+                : instrument(handle), price(p), size(s), side(sd),
                   timestamp(std::chrono::high_resolution_clock::now()),
                   sequence_number(0) {}
         };
@@ -69,6 +74,7 @@ namespace spe
         struct Instrument
         {
             InstrumentId id;
+            InstrumentHandle handle;
             std::string symbol;
             InstrumentType type;
             std::string base_currency;
@@ -78,30 +84,166 @@ namespace spe
             Timestamp expiry; // For derivatives
             Price strike;     // For options
 
-            Instrument() = default;
-            Instrument(const InstrumentId &instrument_id, const std::string &sym, InstrumentType t)
-                : id(instrument_id), symbol(sym), type(t), tick_size(0.0001), min_size(1.0) {}
+            Instrument() : handle(INVALID_INSTRUMENT) {}
+            Instrument(const InstrumentId &instrument_id, InstrumentHandle h, const std::string &sym, InstrumentType t)
+                : id(instrument_id), handle(h), symbol(sym), type(t), tick_size(0.0001), min_size(1.0) {}
+        };
+
+        struct PriceLevel
+        {
+            Price price;
+            Volume size;
         };
 
+        // Top of an order book, each side best level first. Fixed capacity so it copies through
+        // queues, snapshot columns and OrderBook's seqlock view without allocating.
         struct MarketDepth
         {
-            InstrumentId instrument_id;
-            std::vector<std::pair<Price, Volume>> bids;
-            std::vector<std::pair<Price, Volume>> asks;
+            static constexpr size_t MAX_LEVELS = 10;
+
+            InstrumentHandle instrument;
+            uint32_t bid_count;
+            uint32_t ask_count;
+            PriceLevel bids[MAX_LEVELS] = {};
+            PriceLevel asks[MAX_LEVELS] = {};
+            uint64_t update_id; // exchange sequence of the book state it was taken from
             Timestamp timestamp;
 
-            MarketDepth() = default;
-            MarketDepth(const InstrumentId &id) : instrument_id(id) {}
+            MarketDepth() : MarketDepth(INVALID_INSTRUMENT) {}
+            MarketDepth(InstrumentHandle handle)
+                : instrument(handle), bid_count(0), ask_count(0), update_id(0),
+                  timestamp(std::chrono::high_resolution_clock::now()) {}
+
+            // Appends below the current worst level; false once the side is full
+            bool add_bid(Price price, Volume size)
+            {
+                if (bid_count == MAX_LEVELS)
+                {
+                    return false;
+                }
+                bids[bid_count++] = PriceLevel{price, size};
+                return true;
+            }
+            bool add_ask(Price price, Volume size)
+            {
+                if (ask_count == MAX_LEVELS)
+                {
+                    return false;
+                }
+                asks[ask_count++] = PriceLevel{price, size};
+                return true;
+            }
+
+            // Visible size a BID (buying) leg could take from the asks at or below limit_price,
+            // or an ASK (selling) leg from the bids at or above it
+            Volume available_volume(Side side, Price limit_price) const;
+        };
+
+        class MarketSnapshot;
+
+        // Structure-of-arrays market state indexed by instrument handle. Producers apply
+        // quotes, trades and depth in place; publish() hands consumers a MarketSnapshot view
+        // together with the instruments touched since the previous publish, so per-tick
+        // work scales with what changed rather than with universe size.
+        class SnapshotStore
+        {
+        private:
+            // Quote columns
+            std::vector<Price> bid_prices_;
+            std::vector<Price> ask_prices_;
+            std::vector<Volume> bid_sizes_;
+            std::vector<Volume> ask_sizes_;
+            std::vector<Timestamp> quote_times_;
+            std::vector<uint64_t> sequence_numbers_;
+            std::vector<uint8_t> has_quote_;
+
+            // Trades since the last publish, cleared lazily on the first trade of a new interval
+            std::vector<std::vector<Trade>> recent_trades_;
+            std::vector<uint64_t> trade_epochs_;
+
+            std::vector<MarketDepth> depth_;
+            std::vector<uint8_t> has_depth_;
+
+            // Delta tracking
+            std::vector<uint8_t> dirty_flags_;
+            std::vector<InstrumentHandle> pending_dirty_;
+            std::vector<InstrumentHandle> published_dirty_;
+            std::vector<InstrumentHandle> quoted_instruments_;
+
+            uint64_t publish_epoch_;
+            Timestamp publish_time_;
+
+            void ensure_capacity(InstrumentHandle instrument);
+            void mark_dirty(InstrumentHandle instrument);
+
+        public:
+            SnapshotStore();
+
+            // Pre-size the columns, typically to InstrumentRegistry::size() after subscribing
+            void reserve(size_t instrument_count);
+
+            void apply_quote(const Quote &quote);
+            void apply_trade(const Trade &trade);
+            void apply_depth(const MarketDepth &depth);
+
+            // Closes the current update interval and returns a view of it
+            MarketSnapshot publish();
+            MarketSnapshot view() const;
+
+            bool has_quote(InstrumentHandle instrument) const
+            {
+                return instrument < has_quote_.size() && has_quote_[instrument];
+            }
+            Price bid_price(InstrumentHandle instrument) const { return bid_prices_[instrument]; }
+            Price ask_price(InstrumentHandle instrument) const { return ask_prices_[instrument]; }
+            Volume bid_size(InstrumentHandle instrument) const { return bid_sizes_[instrument]; }
+            Volume ask_size(InstrumentHandle instrument) const { return ask_sizes_[instrument]; }
+            Quote quote(InstrumentHandle instrument) const;
+
+            const std::vector<Trade> &recent_trades(InstrumentHandle instrument) const;
+            const MarketDepth *depth(InstrumentHandle instrument) const;
+
+            const std::vector<InstrumentHandle> &quoted_instruments() const { return quoted_instruments_; }
+            const std::vector<InstrumentHandle> &dirty_instruments() const { return published_dirty_; }
+            size_t capacity() const { return has_quote_.size(); }
         };
 
-        struct MarketSnapshot
+        // Non-owning, trivially copyable view of a SnapshotStore. Accessors read the store's
+        // columns directly; the dirty list stays valid until the store publishes again.
+        class MarketSnapshot
         {
-            std::map<InstrumentId, Quote> quotes;
-            std::map<InstrumentId, std::vector<Trade>> recent_trades;
-            std::map<InstrumentId, MarketDepth> depth;
+        private:
+            const SnapshotStore *store_;
+
+        public:
             Timestamp snapshot_time;
 
-            MarketSnapshot() : snapshot_time(std::chrono::high_resolution_clock::now()) {}
+            MarketSnapshot() : store_(nullptr), snapshot_time(std::chrono::high_resolution_clock::now()) {}
+            MarketSnapshot(const SnapshotStore *store, Timestamp time) : store_(store), snapshot_time(time) {}
+
+            bool empty() const { return store_ == nullptr || store_->quoted_instruments().empty(); }
+            size_t quote_count() const { return store_ ? store_->quoted_instruments().size() : 0; }
+
+            bool has_quote(InstrumentHandle instrument) const { return store_ && store_->has_quote(instrument); }
+            Quote quote(InstrumentHandle instrument) const;
+            Price bid_price(InstrumentHandle instrument) const { return store_->bid_price(instrument); }
+            Price ask_price(InstrumentHandle instrument) const { return store_->ask_price(instrument); }
+            Volume bid_size(InstrumentHandle instrument) const { return store_->bid_size(instrument); }
+            Volume ask_size(InstrumentHandle instrument) const { return store_->ask_size(instrument); }
+            Price mid_price(InstrumentHandle instrument) const
+            {
+                return (store_->bid_price(instrument) + store_->ask_price(instrument)) / 2.0;
+            }
+
+            // Every instrument that has a quote, in first-quoted order
+            const std::vector<InstrumentHandle> &instruments() const;
+            // Instruments whose quote, trades or depth changed in this interval
+            const std::vector<InstrumentHandle> &dirty_instruments() const;
+
+            const std::vector<Trade> &recent_trades(InstrumentHandle instrument) const;
+            const MarketDepth *depth(InstrumentHandle instrument) const;
+
+            const SnapshotStore *store() const { return store_; }
         };
 
     } // namespace market_data
@@ -0,0 +1,274 @@
+#pragma once
+
+#include "data_feed.hpp"
+#include "order_book.hpp"
+#include "thread_topology.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace spe
+{
+    namespace data_feed
+    {
+
+        // Append-only binary capture of normalized market data. A journal file is a 64-byte
+        // header followed by fixed 64-byte records. Instruments are numbered per file: the first
+        // record for an instrument is an INSTRUMENT record carrying its symbol, so every file
+        // (and every prefix of one, should the writer die mid-file) is self-describing.
+        //
+        // Book updates are stored one level per record. The first level of a message carries
+        // BOOK_SNAPSHOT when the message replaces the book, and the last carries BOOK_END.
+        enum class JournalRecordType : uint8_t
+        {
+            INSTRUMENT = 1, // local id -> symbol
+            QUOTE = 2,      // values: bid, ask, bid size, ask size
+            TRADE = 3,      // values: price, size; aux: numeric trade id, or 0
+            BOOK_LEVEL = 4  // values: price, size (0 removes the level); sequence: update id
+        };
+
+        constexpr uint16_t BOOK_SNAPSHOT = 1; // first level of a message that replaces the book
+        constexpr uint16_t BOOK_END = 2;      // last level of a message
+        constexpr uint16_t BOOK_EMPTY = 4;    // message without levels; the record carries none
+
+        struct JournalRecord
+        {
+            uint64_t timestamp_ns; // Timestamp since its clock's epoch
+            uint32_t instrument;   // file-local id
+            JournalRecordType type;
+            uint8_t side;   // Side of a trade aggressor or book level
+            uint16_t flags; // BOOK_* flags; symbol length for INSTRUMENT
+            double values[4];
+            uint64_t sequence;
+            uint64_t aux;
+        };
+        static_assert(sizeof(JournalRecord) == 64, "journal records are fixed at 64 bytes");
+
+        struct JournalFileHeader
+        {
+            static constexpr char MAGIC[8] = {'S', 'P', 'E', 'J', 'R', 'N', 'L', '\0'};
+            static constexpr uint32_t VERSION = 1;
+
+            char magic[8];
+            uint32_t version;
+            uint32_t record_size;
+            uint64_t created_ns;
+            uint64_t reserved[5];
+        };
+        static_assert(sizeof(JournalFileHeader) == 64, "journal header is one record long");
+
+        // Writes journal files <prefix>.000000.spej, <prefix>.000001.spej, ... rolling over once
+        // a file reaches max_file_bytes. Records go through a large stdio buffer; flush() pushes
+        // them to the OS. Not thread-safe: use one writer per connection.
+        class JournalWriter
+        {
+        public:
+            static constexpr size_t MAX_SYMBOL_LENGTH = 48; // an INSTRUMENT record's payload
+            static constexpr size_t DEFAULT_MAX_FILE_BYTES = size_t(256) << 20;
+
+        private:
+            static constexpr uint32_t NO_LOCAL_ID = UINT32_MAX;
+
+            std::string prefix_;
+            size_t max_file_bytes_;
+            std::FILE *file_;
+            std::vector<char> buffer_;
+            size_t file_bytes_;
+            uint32_t file_index_;
+            std::vector<std::string> files_;
+
+            std::vector<uint32_t> local_ids_; // dense by handle, for the current file
+            uint32_t next_local_id_;
+
+            uint64_t records_written_;
+            uint64_t records_dropped_;
+
+            bool open_next_file();
+            uint32_t local_id(InstrumentHandle instrument, uint64_t timestamp_ns);
+            bool write(const JournalRecord &record);
+
+        public:
+            explicit JournalWriter(const std::string &prefix, size_t max_file_bytes = DEFAULT_MAX_FILE_BYTES);
+            ~JournalWriter();
+
+            JournalWriter(const JournalWriter &) = delete;
+            JournalWriter &operator=(const JournalWriter &) = delete;
+
+            bool open();
+            void flush();
+            void close();
+            bool is_open() const { return file_ != nullptr; }
+
+            // False when the record could not be written (closed, I/O error, or a symbol longer
+            // than MAX_SYMBOL_LENGTH); such records are counted as dropped
+            bool append_quote(const Quote &quote);
+            bool append_trade(const Trade &trade);
+            bool append_book_level(InstrumentHandle instrument, Side side, Price price, Volume size,
+                                   uint64_t update_id, Timestamp timestamp, uint16_t flags);
+            bool append_empty_book(InstrumentHandle instrument, bool is_snapshot, uint64_t update_id, Timestamp timestamp);
+
+            const std::vector<std::string> &files() const { return files_; }
+            uint64_t records_written() const { return records_written_; }
+            uint64_t records_dropped() const { return records_dropped_; }
+
+            static std::string file_name(const std::string &prefix, uint32_t index);
+        };
+
+        // Read-only view of one journal file, memory-mapped where the platform allows. A torn
+        // final record (writer killed mid-write) is ignored.
+        class JournalReader
+        {
+        private:
+            const unsigned char *data_;
+            size_t size_;
+            bool mapped_;
+            std::vector<unsigned char> fallback_; // whole-file copy where mmap is unavailable
+            std::string error_;
+
+        public:
+            JournalReader();
+            ~JournalReader();
+
+            JournalReader(const JournalReader &) = delete;
+            JournalReader &operator=(const JournalReader &) = delete;
+
+            bool open(const std::string &path); // false with error() set on failure
+            void close();
+            bool is_open() const { return data_ != nullptr; }
+
+            size_t record_count() const { return size_ < sizeof(JournalFileHeader) ? 0 : (size_ - sizeof(JournalFileHeader)) / sizeof(JournalRecord); }
+            const JournalRecord *records() const { return reinterpret_cast<const JournalRecord *>(data_ + sizeof(JournalFileHeader)); }
+            const JournalFileHeader &header() const { return *reinterpret_cast<const JournalFileHeader *>(data_); }
+            const std::string &error() const { return error_; }
+
+            // Symbol of an INSTRUMENT record
+            static std::string symbol(const JournalRecord &record);
+        };
+
+        enum class ReplaySpeed
+        {
+            WALL_CLOCK,         // recorded inter-event gaps
+            ACCELERATED,        // recorded gaps divided by ReplayConfig::acceleration
+            AS_FAST_AS_POSSIBLE // no pacing
+        };
+
+        struct ReplayConfig
+        {
+            ReplaySpeed speed = ReplaySpeed::AS_FAST_AS_POSSIBLE;
+            double acceleration = 10.0;
+            bool restamp = true;           // stamp events with replay time rather than capture time
+            bool quotes_from_books = true; // top-of-book quote after each book message, as live feeds publish
+            // Records before this capture time only rebuild books, unpaced and undelivered, e.g.
+            // from a checkpoint's creation time to top restored state up (restamp off)
+            uint64_t start_ns = 0;
+            concurrency::StagePlacement placement; // of the feed thread connect() starts; replay() leaves the caller's alone
+        };
+
+        struct ReplayStatistics
+        {
+            uint64_t records = 0;
+            uint64_t quotes = 0;
+            uint64_t trades = 0;
+            uint64_t book_updates = 0;  // whole messages
+            uint64_t skipped = 0;       // unknown record types or undeclared instruments
+            uint64_t fast_forwarded = 0; // before start_ns, not delivered
+            uint32_t files = 0;
+        };
+
+        // IDataFeed over journal files, replayed in the order given. replay() runs on the calling
+        // thread and is deterministic, for backtests and repros; connect() runs the same loop on
+        // a feed thread. Only subscribed instruments are delivered (subscribe_all() for every
+        // one); books are rebuilt from the recorded levels and handed out as MarketDepth.
+        class JournalReplayFeed : public IDataFeed
+        {
+        private:
+            std::vector<std::string> files_;
+            ReplayConfig config_;
+
+            std::atomic<FeedStatus> status_;
+            std::thread feed_thread_;
+            std::atomic<bool> running_;
+            std::atomic<bool> finished_;
+
+            QuoteCallback quote_callback_;
+            TradeCallback trade_callback_;
+            DepthCallback depth_callback_;
+            ErrorCallback error_callback_;
+
+            // Subscriptions, dense by handle; set them up before connect()
+            bool subscribe_all_;
+            std::vector<uint8_t> quote_subscriptions_;
+            std::vector<uint8_t> trade_subscriptions_;
+            std::vector<uint8_t> depth_subscriptions_;
+
+            // Latest state for the IDataFeed getters
+            mutable std::mutex data_mutex_;
+            std::unordered_map<InstrumentHandle, Quote> latest_quotes_;
+            std::unordered_map<InstrumentHandle, std::deque<Trade>> recent_trades_;
+            std::unordered_map<InstrumentHandle, MarketDepth> market_depths_;
+
+            // Replay thread only
+            std::unordered_map<InstrumentHandle, std::unique_ptr<OrderBook>> books_;
+            OrderBook *current_book_; // book of the message being read, until its BOOK_END
+            BookSequence current_sequence_;
+            uint64_t first_recorded_ns_;
+            std::chrono::steady_clock::time_point replay_start_;
+            ReplayStatistics statistics_;
+
+            static constexpr size_t RECENT_TRADE_LIMIT = 1000;
+
+            void feed_loop();
+            bool run_replay();
+            bool replay_file(const std::string &path);
+            void apply_book_level(InstrumentHandle instrument, const JournalRecord &record, Timestamp timestamp, bool deliver);
+            void pace(uint64_t recorded_ns);
+            Timestamp event_time(uint64_t recorded_ns) const;
+            void deliver_quote(const Quote &quote);
+            void deliver_trade(const Trade &trade);
+            void deliver_book(OrderBook &book, Timestamp timestamp);
+            void report_error(const std::string &error);
+
+            static bool subscribed(const std::vector<uint8_t> &subscriptions, InstrumentHandle instrument);
+            static bool subscribe(std::vector<uint8_t> &subscriptions, const std::vector<InstrumentId> &instruments);
+
+        public:
+            JournalReplayFeed(std::vector<std::string> files, const ReplayConfig &config = ReplayConfig{});
+            ~JournalReplayFeed();
+
+            // Starts replay on the feed thread; it ends by itself after the last file
+            bool connect() override;
+            void disconnect() override;
+            FeedStatus get_status() const override;
+
+            // Replays every file on the calling thread; false if a file could not be read
+            bool replay();
+            bool finished() const { return finished_.load(std::memory_order_acquire); }
+            void wait();
+            const ReplayStatistics &statistics() const { return statistics_; } // once finished
+
+            bool subscribe_quotes(const std::vector<InstrumentId> &instruments) override;
+            bool subscribe_trades(const std::vector<InstrumentId> &instruments) override;
+            bool subscribe_depth(const std::vector<InstrumentId> &instruments) override;
+            bool unsubscribe(InstrumentHandle instrument) override;
+            void subscribe_all() { subscribe_all_ = true; }
+
+            void set_quote_callback(QuoteCallback callback) override { quote_callback_ = callback; }
+            void set_trade_callback(TradeCallback callback) override { trade_callback_ = callback; }
+            void set_depth_callback(DepthCallback callback) override { depth_callback_ = callback; }
+            void set_error_callback(ErrorCallback callback) override { error_callback_ = callback; }
+
+            Quote get_latest_quote(InstrumentHandle instrument) const override;
+            std::vector<Trade> get_recent_trades(InstrumentHandle instrument, size_t count = 100) const override;
+            MarketDepth get_market_depth(InstrumentHandle instrument) const override;
+        };
+
+    } // namespace data_feed
+} // namespace spe
@@ -2,20 +2,33 @@
 
 #include "market_data.hpp"
 #include "pricing_models.hpp"
+#include "rolling_window.hpp"
+#include "correlation_matrix.hpp"
+#include "small_vector.hpp"
+#include "currency_graph.hpp"
+#include "work_stealing_pool.hpp"
+#include "double_buffer.hpp"
+#include "venue_price_matrix.hpp"
+#include "synthetic_pipeline.hpp"
+#include "checkpoint.hpp"
 #include <vector>
-#include <queue>
 #include <memory>
 #include <functional>
 #include <mutex>
 #include <atomic>
 #include <chrono>
 #include <set>
+#include <unordered_map>
 
 namespace spe {
 namespace mispricing {
 
 using namespace market_data;
 using namespace pricing;
+using stats::RingBuffer;
+using stats::RollingStatistics;
+using stats::RollingLogReturns;
+using stats::StreamingCorrelationMatrix;
 
 enum class MispricingType {
     STATISTICAL_ARBITRAGE,
@@ -35,9 +48,14 @@ enum class MispricingSeverity {
     CRITICAL
 };
 
+// Inline capacity covers triangles and small baskets, so building or copying an opportunity
+// does not allocate
+using ComponentInstruments = memory::SmallVector<InstrumentHandle, 4>;
+using ComponentWeights = memory::SmallVector<double, 4>;
+
 struct MispricingOpportunity {
-    InstrumentId target_instrument;
-    std::vector<InstrumentId> component_instruments;
+    InstrumentHandle target_instrument;
+    ComponentInstruments component_instruments;
     MispricingType type;
     MispricingSeverity severity;
     
@@ -49,7 +67,7 @@ struct MispricingOpportunity {
     double expected_profit;
     double max_loss;
     
-    std::vector<double> weights;
+    ComponentWeights weights;
     Timestamp detection_time;
     Timestamp expiry_time;
     
@@ -58,7 +76,7 @@ struct MispricingOpportunity {
     double expected_shortfall;
     double sharpe_ratio;
     
-    MispricingOpportunity() : market_price(0.0), theoretical_price(0.0), 
+    MispricingOpportunity() : target_instrument(INVALID_INSTRUMENT), market_price(0.0), theoretical_price(0.0), 
                              deviation_percentage(0.0), z_score(0.0), confidence_level(0.0),
                              expected_profit(0.0), max_loss(0.0), value_at_risk(0.0),
                              expected_shortfall(0.0), sharpe_ratio(0.0),
@@ -79,7 +97,20 @@ struct DetectionParameters {
 using MispricingCallback = std::function<void(const MispricingOpportunity&)>;
 using MispricingExpiredCallback = std::function<void(const MispricingOpportunity&)>;
 
+// Detectors take market data either as whole snapshots or one event at a time. The event
+// methods re-evaluate only the signals that depend on the instrument and report through the
+// callbacks. Their defaults adapt to update_market_data() with a private store that holds the
+// latest state and publishes one-instrument snapshots, which is O(dependents) for any detector
+// that walks only the dirty instruments.
 class IMispricingDetector {
+private:
+    std::unique_ptr<SnapshotStore> event_store_;  // created by the first adapted event
+    
+    void adapt_event();
+    
+protected:
+    SnapshotStore& event_store();
+    
 public:
     virtual ~IMispricingDetector() = default;
     
@@ -88,6 +119,11 @@ public:
     virtual void set_detection_callback(MispricingCallback callback) = 0;
     virtual void set_expiry_callback(MispricingExpiredCallback callback) = 0;
     virtual void update_parameters(const DetectionParameters& params) = 0;
+    
+    // Incremental API; events for one detector come from one thread
+    virtual void on_quote(InstrumentHandle instrument, const Quote& quote);
+    virtual void on_trade(InstrumentHandle instrument, const Trade& trade);
+    virtual void on_book_update(InstrumentHandle instrument, const MarketDepth& depth);
 };
 
 class StatisticalMispricingDetector : public IMispricingDetector {
@@ -96,11 +132,12 @@ private:
     std::unique_ptr<IPricingModel> pricing_model_;
     
     // Historical data storage
-    std::map<InstrumentId, std::queue<Quote>> price_history_;
-    std::map<InstrumentId, std::queue<double>> deviation_history_;
+    std::unordered_map<InstrumentHandle, RingBuffer<Quote>> price_history_;
+    std::map<InstrumentHandle, RollingStatistics> deviation_history_;
     
-    // Active opportunities tracking
+    // Active opportunities tracking; an instrument is flagged again once its opportunity expires
     std::vector<MispricingOpportunity> active_opportunities_;
+    std::set<InstrumentHandle> flagged_instruments_;
     mutable std::mutex opportunities_mutex_;
     
     // Callbacks
@@ -109,12 +146,13 @@ private:
     
     // Detection methods
     bool is_significant_deviation(double deviation, double z_score, double confidence);
-    double calculate_z_score(const std::queue<double>& history, double current_value);
-    double calculate_confidence_level(const std::queue<Quote>& history, double theoretical_price);
+    double calculate_z_score(const RollingStatistics& history, double current_value);
+    double calculate_confidence_level(const RingBuffer<Quote>& history, double theoretical_price);
     MispricingSeverity assess_severity(const PriceDeviation& deviation);
     
     void cleanup_expired_opportunities();
-    void update_price_history(const InstrumentId& instrument, const Quote& quote);
+    const RingBuffer<Quote>& update_price_history(InstrumentHandle instrument, const Quote& quote);
+    void evaluate_instrument(InstrumentHandle instrument, const RingBuffer<Quote>& history);
     
 public:
     StatisticalMispricingDetector(std::unique_ptr<IPricingModel> model, 
@@ -127,22 +165,39 @@ public:
     void set_expiry_callback(MispricingExpiredCallback callback) override;
     void update_parameters(const DetectionParameters& params) override;
     
+    // Quote-driven; trades and books carry nothing it uses
+    void on_quote(InstrumentHandle instrument, const Quote& quote) override;
+    void on_trade(InstrumentHandle, const Trade&) override {}
+    void on_book_update(InstrumentHandle, const MarketDepth&) override {}
+    
     // Additional methods
     std::vector<MispricingOpportunity> get_active_opportunities() const;
     void clear_opportunities();
+    
+    // Quote and deviation histories, on the updating thread. Open opportunities are not kept:
+    // the restored windows detect them again on the next quote.
+    static constexpr uint32_t CHECKPOINT_TAG = checkpoint::make_tag('S', 'M', 'D', 'T');
+    static constexpr uint32_t CHECKPOINT_VERSION = 1;
+    void save_state(checkpoint::CheckpointWriter& out) const;
+    bool restore_state(checkpoint::SectionReader& in);
 };
 
+// Cycles come from a currency graph over the configured triangles' pairs, plus every spot
+// pair in the registry once discovery is on; a quote re-scores only the cycles through it
 class TriangularArbitrageDetector : public IMispricingDetector {
 private:
     DetectionParameters params_;
-    std::map<std::string, std::vector<InstrumentId>> currency_triangles_;
+    std::map<std::string, std::vector<InstrumentHandle>> currency_triangles_;
+    graph::CurrencyGraph currency_graph_;
+    bool discover_pairs_;
+    bool graph_stale_;  // pairs changed; rebuild before the next update
     
     MispricingCallback detection_callback_;
     MispricingExpiredCallback expiry_callback_;
     
-    std::vector<MispricingOpportunity> detect_triangular_opportunities(const MarketSnapshot& snapshot);
-    double calculate_triangular_profit(const Quote& pair1, const Quote& pair2, const Quote& pair3);
-    bool is_profitable_triangle(double profit_percentage);
+    void rebuild_graph();
+    void evaluate_cycles();  // reports cycles through the pairs quoted since the last call
+    MispricingOpportunity create_cycle_opportunity(uint32_t cycle, double log_return) const;
     
 public:
     TriangularArbitrageDetector(const DetectionParameters& params = DetectionParameters{});
@@ -153,21 +208,35 @@ public:
     void set_expiry_callback(MispricingExpiredCallback callback) override;
     void update_parameters(const DetectionParameters& params) override;
     
-    void add_currency_triangle(const std::string& name, const std::vector<InstrumentId>& instruments);
+    // A quote re-scores the cycles through its pair only
+    void on_quote(InstrumentHandle instrument, const Quote& quote) override;
+    void on_trade(InstrumentHandle, const Trade&) override {}
+    void on_book_update(InstrumentHandle, const MarketDepth&) override {}
+    
+    void add_currency_triangle(const std::string& name, const std::vector<InstrumentHandle>& instruments);
     void remove_currency_triangle(const std::string& name);
+    // Also search every BASE-QUOTE pair in the instrument registry, as of the next update
+    void discover_currency_pairs(bool include_four_cycles = false);
+    const graph::CurrencyGraph& currency_graph() const { return currency_graph_; }
 };
 
 class VolatilityArbitrageDetector : public IMispricingDetector {
 private:
+    static constexpr size_t MIN_PRICES = 20;  // before realized volatility is meaningful
+    static constexpr size_t VOLATILITY_WINDOW = 100;
+    
     DetectionParameters params_;
-    std::map<InstrumentId, std::queue<Price>> volatility_history_;
+    std::unordered_map<InstrumentHandle, RollingLogReturns> volatility_history_;
+    std::vector<MispricingOpportunity> active_opportunities_;  // one per instrument, in detection order
     
     MispricingCallback detection_callback_;
     MispricingExpiredCallback expiry_callback_;
     
-    double calculate_realized_volatility(const std::queue<Price>& prices);
+    double calculate_realized_volatility(const RollingLogReturns& prices);
     double calculate_implied_volatility_proxy(const Quote& quote);
     std::vector<MispricingOpportunity> detect_volatility_opportunities(const MarketSnapshot& snapshot);
+    void record_price(InstrumentHandle instrument, Price mid_price);
+    const MispricingOpportunity& flag_instrument(InstrumentHandle instrument);
     
 public:
     VolatilityArbitrageDetector(const DetectionParameters& params = DetectionParameters{});
@@ -177,16 +246,46 @@ public:
     void set_detection_callback(MispricingCallback callback) override;
     void set_expiry_callback(MispricingExpiredCallback callback) override;
     void update_parameters(const DetectionParameters& params) override;
+    
+    void on_quote(InstrumentHandle instrument, const Quote& quote) override;
+    void on_trade(InstrumentHandle, const Trade&) override {}
+    void on_book_update(InstrumentHandle, const MarketDepth&) override {}
+    
+    // Return windows and last prices, on the updating thread. An instrument flagged before the
+    // checkpoint is flagged again on restore, without a callback, as it is never re-detected.
+    static constexpr uint32_t CHECKPOINT_TAG = checkpoint::make_tag('V', 'A', 'D', 'T');
+    static constexpr uint32_t CHECKPOINT_VERSION = 1;
+    void save_state(checkpoint::CheckpointWriter& out) const;
+    bool restore_state(checkpoint::SectionReader& in);
 };
 
+// Sub-detectors are independent per tick and can run sequentially or fanned out over a shared
+// work-stealing pool. Either way, results and callbacks come out in detector order, and the
+// callbacks run on the calling thread only.
 class CompositeMispricingDetector : public IMispricingDetector {
 private:
+    struct PendingCallbacks {
+        std::vector<MispricingOpportunity> detected;
+        std::vector<MispricingOpportunity> expired;
+    };
+    
     std::vector<std::unique_ptr<IMispricingDetector>> detectors_;
     DetectionParameters params_;
     
     MispricingCallback detection_callback_;
     MispricingExpiredCallback expiry_callback_;
     
+    // Per detector: callbacks buffered during a run, and detect_opportunities() results
+    std::vector<PendingCallbacks> pending_;
+    std::vector<std::vector<MispricingOpportunity>> results_;
+    
+    concurrency::ExecutionMode execution_mode_;
+    std::shared_ptr<concurrency::WorkStealingPool> pool_;
+    std::chrono::nanoseconds detector_deadline_;
+    std::vector<concurrency::TaskRunStatus> run_status_;
+    
+    void wire_detector(size_t index);
+    void flush_pending_callbacks();
     void consolidate_opportunities(std::vector<MispricingOpportunity>& opportunities);
     
 public:
@@ -195,16 +294,30 @@ public:
     void add_detector(std::unique_ptr<IMispricingDetector> detector);
     void remove_detector(size_t index);
     
+    // PARALLEL needs a pool; without one the detectors run sequentially. A detector that
+    // finishes more than `deadline` after the start of a run is flagged late.
+    void set_execution_mode(concurrency::ExecutionMode mode,
+                            std::shared_ptr<concurrency::WorkStealingPool> pool = nullptr,
+                            std::chrono::nanoseconds deadline = std::chrono::nanoseconds::max());
+    // One entry per detector for the last update_market_data() or detect_opportunities()
+    const std::vector<concurrency::TaskRunStatus>& last_run_status() const { return run_status_; }
+    
     void update_market_data(const MarketSnapshot& snapshot) override;
     std::vector<MispricingOpportunity> detect_opportunities() override;
     void set_detection_callback(MispricingCallback callback) override;
     void set_expiry_callback(MispricingExpiredCallback callback) override;
     void update_parameters(const DetectionParameters& params) override;
+    
+    // Forwarded to every detector in order on the calling thread; one event is too little
+    // work to fan out
+    void on_quote(InstrumentHandle instrument, const Quote& quote) override;
+    void on_trade(InstrumentHandle instrument, const Trade& trade) override;
+    void on_book_update(InstrumentHandle instrument, const MarketDepth& depth) override;
 };
 
 // Enhanced structures for real-time detection and profit calculation
 struct PriceDiscrepancy {
-    InstrumentId instrument_id;
+    InstrumentHandle instrument;
     std::string exchange_id;
     Price spot_price;
     Price synthetic_price;
@@ -224,7 +337,7 @@ struct PriceDiscrepancy {
 };
 
 struct CrossExchangeOpportunity {
-    InstrumentId instrument_id;
+    InstrumentHandle instrument;
     std::string exchange_1;
     std::string exchange_2;
     Price price_1;
@@ -246,8 +359,8 @@ struct CrossExchangeOpportunity {
 };
 
 struct DerivativePricingDiscrepancy {
-    InstrumentId spot_instrument;
-    InstrumentId derivative_instrument;
+    InstrumentHandle spot_instrument;
+    InstrumentHandle derivative_instrument;
     Price spot_price;
     Price derivative_market_price;
     Price derivative_theoretical_price;
@@ -306,17 +419,25 @@ class SpotVsSyntheticDerivativeDetector : public IMispricingDetector {
 private:
     DetectionParameters params_;
     std::unique_ptr<IPricingModel> derivative_pricing_model_;
+    std::unique_ptr<OptionsPricingModel> default_options_model_;
+    OptionsPricingModel* options_model_;  // derivative_pricing_model_ when it prices options
+    std::map<InstrumentHandle, std::vector<InstrumentHandle>> derivatives_by_underlying_;
+    std::unordered_map<InstrumentHandle, memory::SmallVector<InstrumentHandle, 2>> underlyings_by_derivative_;
+    std::set<InstrumentHandle> repriced_underlyings_;  // filled by detect_derivative_mispricings
+    // Derivatives bound to a compiled pricing kernel; the virtual model prices the rest
+    SyntheticPipelineSet<PerpetualSwapKernel, FuturesKernel> compiled_derivatives_;
     std::vector<DerivativePricingDiscrepancy> active_discrepancies_;
     mutable std::mutex discrepancies_mutex_;
     
     MispricingCallback detection_callback_;
     MispricingExpiredCallback expiry_callback_;
     
-    // Derivative pricing methods
+    // Derivative pricing methods; option chains are repriced in one batch per underlying
     std::vector<DerivativePricingDiscrepancy> detect_derivative_mispricings(const MarketSnapshot& snapshot);
-    double calculate_theoretical_derivative_price(const InstrumentId& derivative, const Quote& spot_quote);
-    double calculate_implied_volatility(const Quote& derivative_quote, const Quote& spot_quote);
-    double calculate_greeks(const InstrumentId& derivative, const Quote& spot_quote);
+    void detect_option_mispricings(InstrumentHandle underlying, const MarketSnapshot& snapshot,
+                                   std::vector<DerivativePricingDiscrepancy>& discrepancies);
+    double calculate_theoretical_derivative_price(InstrumentHandle derivative, InstrumentHandle underlying,
+                                                  const MarketSnapshot& snapshot);
     double calculate_margin_requirement(const DerivativePricingDiscrepancy& discrepancy);
     
 public:
@@ -331,7 +452,18 @@ public:
     
     // Enhanced methods
     std::vector<DerivativePricingDiscrepancy> get_active_derivative_discrepancies() const;
-    void add_derivative_instrument(const InstrumentId& derivative_id, const InstrumentId& underlying_id);
+    void add_derivative_instrument(InstrumentHandle derivative_id, InstrumentHandle underlying_id);
+    // Prices the pipeline's target from its leg with the pipeline instead of the model
+    template <typename Kernel>
+    void add_compiled_derivative(const SyntheticPipeline<Kernel>& pipeline) {
+        compiled_derivatives_.add(pipeline);
+        add_derivative_instrument(pipeline.target(), pipeline.legs()[0]);
+    }
+    // Retune a kernel's config (funding, carry) in place
+    template <typename Kernel>
+    std::vector<SyntheticPipeline<Kernel>>& compiled_derivatives() { return compiled_derivatives_.pipelines<Kernel>(); }
+    void add_option_instrument(InstrumentHandle option, const OptionContract& contract);
+    void update_volatility_surface(InstrumentHandle underlying, const VolatilitySurface& surface);
 };
 
 // Cross-Exchange Arbitrage Detector
@@ -410,8 +542,8 @@ public:
 
 // Real-time Basis Calculation Structure
 struct BasisCalculation {
-    InstrumentId spot_instrument;
-    InstrumentId derivative_instrument;
+    InstrumentHandle spot_instrument;
+    InstrumentHandle derivative_instrument;
     Price spot_price;
     Price derivative_price;
     double basis_value;
@@ -427,10 +559,36 @@ struct BasisCalculation {
                         z_score(0.0), calculation_time(std::chrono::high_resolution_clock::now()) {}
 };
 
+// One dated leg of an underlying's basis curve
+struct TermStructurePoint {
+    InstrumentHandle derivative_instrument;
+    Timestamp expiry;
+    double time_to_expiry;          // years
+    double basis_percentage;        // (derivative - spot) / spot
+    double annualized_basis;        // ln(derivative / spot) / time_to_expiry
+    double theoretical_annualized;  // carry rate
+    double z_score;                 // of the annualized basis against its window
+    
+    TermStructurePoint() : derivative_instrument(INVALID_INSTRUMENT), time_to_expiry(0.0), basis_percentage(0.0),
+                          annualized_basis(0.0), theoretical_annualized(0.0), z_score(0.0) {}
+};
+
+// Basis term structure of one underlying: its quoted, unexpired dated legs
+struct BasisTermStructure {
+    InstrumentHandle underlying;
+    std::vector<TermStructurePoint> points;  // nearest expiry first
+    Timestamp update_time;
+    
+    BasisTermStructure() : underlying(INVALID_INSTRUMENT) {}
+    
+    // Annualized basis at a tenor, linear between expiries and flat beyond them; 0 when empty
+    double interpolate_annualized(double time_to_expiry) const;
+};
+
 // Statistical Arbitrage Signal Structure
 struct StatArbitrageSignal {
-    InstrumentId instrument_1;
-    InstrumentId instrument_2;
+    InstrumentHandle instrument_1;
+    InstrumentHandle instrument_2;
     double price_ratio;
     double mean_ratio;
     double ratio_std_dev;
@@ -451,27 +609,101 @@ struct StatArbitrageSignal {
 };
 
 // Real-time Basis Calculator
+//
+// Streams the basis of each spot/derivative pair and, per underlying, a term structure across its
+// dated legs. A pair keeps a window of compact records with rolling accumulators for the basis and
+// the annualized basis, so an update costs O(1) per pair with a dirty leg however long the
+// window. Dated legs take their expiry and carry from a FuturesPricingModel, and add_underlying()
+// tracks every expiry the model lists on a spot; legs the model does not know are undated (e.g.
+// perpetuals), scored on the raw basis and left off the curves. The current basis, flagged
+// deviations and curves are published through a double buffer for readers on any thread; history
+// and pair statistics queries belong on the updating thread. The model's contracts and rates are
+// read on every update, so change them on that thread too.
 class RealTimeBasisCalculator : public IMispricingDetector {
 private:
+    static constexpr uint32_t NOT_ACTIVE = UINT32_MAX;
+    
+    // One history entry; a BasisCalculation is rebuilt from it only when history is queried
+    struct BasisRecord {
+        Timestamp time;
+        Price spot_price;
+        Price derivative_price;
+        double theoretical_basis;  // percentage
+    };
+    
+    struct PairState {
+        BasisCalculation current;           // latest evaluation
+        RingBuffer<BasisRecord> history;
+        RollingStatistics basis_stats;      // basis percentage
+        RollingStatistics annualized_stats; // scored series: annualized basis, or the raw basis when undated
+        Timestamp expiry;
+        bool dated;
+        bool evaluated;
+        uint32_t active_position;           // in active_, or NOT_ACTIVE
+        uint32_t curve;                     // in curves_, or NOT_ACTIVE when undated
+        uint64_t epoch;                     // last update that evaluated the pair
+        
+        PairState(InstrumentHandle spot, InstrumentHandle derivative, size_t window)
+            : history(window), basis_stats(window), annualized_stats(window), dated(false), evaluated(false),
+              active_position(NOT_ACTIVE), curve(NOT_ACTIVE), epoch(0) {
+            current.spot_instrument = spot;
+            current.derivative_instrument = derivative;
+        }
+    };
+    
+    struct Curve {
+        InstrumentHandle underlying;
+        std::vector<uint32_t> pairs;  // nearest expiry first
+        bool dirty;
+    };
+    
+    // What readers see
+    struct BasisView {
+        std::vector<std::pair<uint64_t, uint32_t>> index;  // pair key -> current, sorted
+        std::vector<BasisCalculation> current;             // indexed like pairs_
+        std::vector<BasisCalculation> active;
+        std::vector<BasisTermStructure> curves;            // indexed like curves_
+    };
+    
     DetectionParameters params_;
-    std::map<std::pair<InstrumentId, InstrumentId>, std::queue<BasisCalculation>> basis_history_;
-    std::vector<BasisCalculation> active_basis_opportunities_;
-    mutable std::mutex basis_mutex_;
+    std::shared_ptr<const FuturesPricingModel> futures_model_;
+    
+    std::vector<PairState> pairs_;
+    std::unordered_map<uint64_t, uint32_t> pair_index_;                          // pair key -> pairs_
+    std::vector<memory::SmallVector<uint32_t, 4>> pairs_by_instrument_;           // dense by handle
+    std::vector<Curve> curves_;
+    std::unordered_map<InstrumentHandle, uint32_t> curve_index_;                 // underlying -> curves_
+    std::vector<uint32_t> active_;                                               // pairs with an open deviation
+    std::vector<uint32_t> touched_;                                              // evaluated this update
+    std::vector<MispricingOpportunity> detected_;
+    std::vector<MispricingOpportunity> expired_;
+    uint64_t epoch_;
+    bool active_changed_;
+    bool pairs_changed_;
+    concurrency::DoubleBuffered<BasisView> view_;
     
     MispricingCallback detection_callback_;
     MispricingExpiredCallback expiry_callback_;
     
+    static uint64_t pair_key(InstrumentHandle spot, InstrumentHandle derivative);
+    const PairState* find_pair(InstrumentHandle spot, InstrumentHandle derivative) const;
+    void insert_pair(InstrumentHandle spot, InstrumentHandle derivative);
+    void evaluate_pair(uint32_t index, const MarketSnapshot& snapshot);
+    void publish_view();
+    void build_curve(const Curve& curve, BasisTermStructure& out) const;
+    MispricingOpportunity create_opportunity(const BasisCalculation& basis) const;
+    
     // Basis calculation methods
-    std::vector<BasisCalculation> calculate_real_time_basis(const MarketSnapshot& snapshot);
-    double calculate_theoretical_basis(const InstrumentId& spot, const InstrumentId& derivative,
-                                     const MarketSnapshot& snapshot);
-    double calculate_basis_z_score(const BasisCalculation& current_basis,
-                                  const std::queue<BasisCalculation>& history);
-    bool is_significant_basis_deviation(const BasisCalculation& basis);
-    void update_basis_history(const BasisCalculation& basis);
+    double calculate_theoretical_basis(InstrumentHandle derivative, double time_to_expiry) const;
+    double calculate_basis_z_score(double scored_value, const RollingStatistics& history) const;
+    bool is_significant_basis_deviation(const BasisCalculation& basis) const;
     
 public:
-    RealTimeBasisCalculator(const DetectionParameters& params = DetectionParameters{});
+    static constexpr double EXIT_Z_SCORE = 0.5;          // an open deviation closes once |z| falls to this
+    static constexpr double MIN_TIME_TO_EXPIRY = 1.0 / 365.0;  // years; annualization floor near expiry
+    
+    RealTimeBasisCalculator(const DetectionParameters& params = DetectionParameters{},
+                            std::shared_ptr<const FuturesPricingModel> futures_model = nullptr);
     
     void update_market_data(const MarketSnapshot& snapshot) override;
     std::vector<MispricingOpportunity> detect_opportunities() override;
@@ -479,40 +711,104 @@ public:
     void set_expiry_callback(MispricingExpiredCallback callback) override;
     void update_parameters(const DetectionParameters& params) override;
     
+    // Pairs added before the model is set stay undated
+    void set_futures_model(std::shared_ptr<const FuturesPricingModel> model) { futures_model_ = std::move(model); }
+    
     // Specific basis calculation methods
+    void add_instrument_pair(InstrumentHandle spot, InstrumentHandle derivative);
+    // Every future the model lists on spot, now and when called again after new listings
+    void add_underlying(InstrumentHandle spot);
+    size_t pair_count() const { return pairs_.size(); }
+    
+    // Any thread
     std::vector<BasisCalculation> get_active_basis_opportunities() const;
-    void add_instrument_pair(const InstrumentId& spot, const InstrumentId& derivative);
-    double get_current_basis(const InstrumentId& spot, const InstrumentId& derivative) const;
-    std::vector<BasisCalculation> get_basis_history(const InstrumentId& spot, 
-                                                   const InstrumentId& derivative) const;
+    double get_current_basis(InstrumentHandle spot, InstrumentHandle derivative) const;
+    BasisTermStructure get_term_structure(InstrumentHandle underlying) const;
+    std::vector<BasisTermStructure> get_term_structures() const;
+    
+    // Updating thread
+    std::vector<BasisCalculation> get_basis_history(InstrumentHandle spot, 
+                                                   InstrumentHandle derivative) const;
+    std::map<std::string, double> get_pair_statistics(InstrumentHandle spot, InstrumentHandle derivative) const;
+    
+    // Basis histories and statistics, on the updating thread; pairs in the checkpoint are added
+    // if missing. A pair's scored series is only restored while it is still dated (or undated)
+    // as it was when saved, since the two are on different scales.
+    static constexpr uint32_t CHECKPOINT_TAG = checkpoint::make_tag('B', 'A', 'S', 'S');
+    static constexpr uint32_t CHECKPOINT_VERSION = 1;
+    void save_state(checkpoint::CheckpointWriter& out) const;
+    bool restore_state(checkpoint::SectionReader& in);
 };
 
 // Statistical Arbitrage Signal Generator
+//
+// The pair universe is split into shards by pair hash. A shard's ratio histories and signals are
+// touched by one task at a time, so shards run in parallel without locks: each update routes the
+// tick's dirty instruments to the shards with pairs on them, runs the shards (over the pool, when
+// one is set) and merges their signals in shard order. Readers get the merged signals through a
+// double buffer. Pair statistics queries belong on the updating thread.
 class StatisticalArbitrageSignalGenerator : public IMispricingDetector {
 private:
+    static constexpr uint32_t NOT_ACTIVE = UINT32_MAX;
+    
+    struct PairState {
+        RollingStatistics ratio_history;
+        StatArbitrageSignal signal;  // latest evaluation
+        uint32_t active_position;    // in the shard's active list, or NOT_ACTIVE
+        uint64_t epoch;              // last update that evaluated the pair
+        
+        PairState(InstrumentHandle instrument1, InstrumentHandle instrument2, size_t window)
+            : ratio_history(window), active_position(NOT_ACTIVE), epoch(0) {
+            signal.instrument_1 = instrument1;
+            signal.instrument_2 = instrument2;
+        }
+    };
+    
+    struct alignas(concurrency::CACHE_LINE_SIZE) PairShard {
+        std::vector<PairState> pairs;
+        std::unordered_map<uint64_t, uint32_t> pair_index;  // pair key -> pairs
+        std::unordered_map<InstrumentHandle, memory::SmallVector<uint32_t, 4>> pairs_by_instrument;
+        std::vector<uint32_t> active;          // pairs with an open signal
+        std::vector<InstrumentHandle> inbox;   // routed by the caller before each run
+        std::vector<MispricingOpportunity> detected;
+        std::vector<MispricingOpportunity> expired;
+        uint64_t epoch = 0;
+        bool changed = false;  // active set or an active signal changed this run
+    };
+    
     DetectionParameters params_;
-    std::map<std::pair<InstrumentId, InstrumentId>, std::queue<double>> price_ratio_history_;
-    std::map<std::pair<InstrumentId, InstrumentId>, double> correlation_cache_;
-    std::vector<StatArbitrageSignal> active_signals_;
-    mutable std::mutex signals_mutex_;
+    double entry_threshold_;
+    double exit_threshold_;
+    std::vector<std::unique_ptr<PairShard>> shards_;
+    std::vector<memory::SmallVector<uint16_t, 4>> shards_by_instrument_;  // dense by handle
+    std::shared_ptr<const StreamingCorrelationMatrix> correlation_matrix_;  // shared, read lock-free
+    concurrency::DoubleBuffered<std::vector<StatArbitrageSignal>> active_signals_;
+    
+    concurrency::ExecutionMode execution_mode_;
+    std::shared_ptr<concurrency::WorkStealingPool> pool_;
     
     MispricingCallback detection_callback_;
     MispricingExpiredCallback expiry_callback_;
     
-    // Statistical arbitrage methods
-    std::vector<StatArbitrageSignal> generate_stat_arb_signals(const MarketSnapshot& snapshot);
-    double calculate_price_ratio(const Quote& quote1, const Quote& quote2);
-    double calculate_mean_ratio(const std::queue<double>& ratio_history);
-    double calculate_ratio_volatility(const std::queue<double>& ratio_history, double mean);
-    double calculate_z_score(double current_ratio, double mean_ratio, double std_dev);
-    double calculate_correlation(const InstrumentId& instrument1, const InstrumentId& instrument2,
-                               const MarketSnapshot& snapshot);
-    double calculate_half_life(const std::queue<double>& ratio_history);
-    std::string determine_signal_type(double z_score, double entry_threshold);
-    double calculate_signal_strength(double z_score, double correlation, double half_life);
-    bool is_valid_signal(const StatArbitrageSignal& signal);
-    void update_ratio_history(const InstrumentId& instrument1, const InstrumentId& instrument2,
-                             double ratio);
+    static uint64_t pair_key(InstrumentHandle instrument1, InstrumentHandle instrument2);
+    size_t shard_of(uint64_t key) const;
+    void insert_pair(PairState&& state);
+    const PairState* find_pair(InstrumentHandle instrument1, InstrumentHandle instrument2) const;
+    void evaluate_shard(PairShard& shard, const MarketSnapshot& snapshot);
+    void evaluate_pair(PairShard& shard, uint32_t index, const MarketSnapshot& snapshot);
+    void publish_signals();
+    MispricingOpportunity create_opportunity(const StatArbitrageSignal& signal) const;
+    
+    // Statistical arbitrage methods; const so shards can share them
+    double calculate_price_ratio(Price price1, Price price2) const;
+    double calculate_mean_ratio(const RollingStatistics& ratio_history) const;
+    double calculate_ratio_volatility(const RollingStatistics& ratio_history, double mean) const;
+    double calculate_z_score(double current_ratio, double mean_ratio, double std_dev) const;
+    double calculate_correlation(InstrumentHandle instrument1, InstrumentHandle instrument2) const;
+    double calculate_half_life(const RollingStatistics& ratio_history) const;
+    std::string determine_signal_type(double z_score, double entry_threshold) const;
+    double calculate_signal_strength(double z_score, double correlation, double half_life) const;
+    bool is_valid_signal(const StatArbitrageSignal& signal) const;
     
 public:
     StatisticalArbitrageSignalGenerator(const DetectionParameters& params = DetectionParameters{});
@@ -524,20 +820,38 @@ public:
     void update_parameters(const DetectionParameters& params) override;
     
     // Specific statistical arbitrage methods
-    std::vector<StatArbitrageSignal> get_active_signals() const;
-    void add_instrument_pair(const InstrumentId& instrument1, const InstrumentId& instrument2);
+    std::vector<StatArbitrageSignal> get_active_signals() const;  // any thread
+    void add_instrument_pair(InstrumentHandle instrument1, InstrumentHandle instrument2);
     void set_signal_thresholds(double entry_threshold, double exit_threshold);
-    double get_current_z_score(const InstrumentId& instrument1, const InstrumentId& instrument2) const;
-    std::map<std::string, double> get_pair_statistics(const InstrumentId& instrument1,
-                                                     const InstrumentId& instrument2) const;
+    void set_correlation_matrix(std::shared_ptr<const StreamingCorrelationMatrix> matrix) {
+        correlation_matrix_ = std::move(matrix);
+    }
+    // Repartitions the pairs into shard_count shards (pool thread count + 1 keeps every thread
+    // busy); PARALLEL runs them on the pool
+    void set_sharding(size_t shard_count, concurrency::ExecutionMode mode = concurrency::ExecutionMode::SEQUENTIAL,
+                      std::shared_ptr<concurrency::WorkStealingPool> pool = nullptr);
+    size_t shard_count() const { return shards_.size(); }
+    size_t pair_count() const;
+    double get_current_z_score(InstrumentHandle instrument1, InstrumentHandle instrument2) const;
+    std::map<std::string, double> get_pair_statistics(InstrumentHandle instrument1,
+                                                     InstrumentHandle instrument2) const;
+    
+    // Ratio histories, on the updating thread; pairs in the checkpoint are added if missing.
+    // Open signals are not kept: the restored windows raise them again on the next update.
+    static constexpr uint32_t CHECKPOINT_TAG = checkpoint::make_tag('S', 'A', 'S', 'G');
+    static constexpr uint32_t CHECKPOINT_VERSION = 1;
+    void save_state(checkpoint::CheckpointWriter& out) const;
+    bool restore_state(checkpoint::SectionReader& in);
 };
 
-// Enhanced Cross-Exchange Synthetic Price Comparator
+// Enhanced Cross-Exchange Synthetic Price Comparator. Prices come from a VenuePriceMatrix,
+// which can be shared with the cross-exchange replication engine so both read the same cells
+// and reprice each stale synthetic once.
 class CrossExchangeSyntheticPriceComparator : public IMispricingDetector {
 private:
     DetectionParameters params_;
     std::unique_ptr<IPricingModel> pricing_model_;
-    std::map<std::string, MarketSnapshot> exchange_snapshots_;
+    std::shared_ptr<VenuePriceMatrix> price_matrix_;
     std::vector<CrossExchangeOpportunity> active_opportunities_;
     mutable std::mutex opportunities_mutex_;
     
@@ -546,17 +860,19 @@ private:
     
     // Enhanced comparison methods
     std::vector<CrossExchangeOpportunity> compare_synthetic_prices_across_exchanges();
-    SyntheticPrice calculate_synthetic_price_for_exchange(const InstrumentId& instrument,
-                                                         const std::string& exchange_id);
-    double calculate_cross_exchange_spread(const SyntheticPrice& price1, const SyntheticPrice& price2);
-    bool validate_synthetic_construction_quality(const SyntheticPrice& synthetic_price);
-    double estimate_cross_exchange_execution_cost(const CrossExchangeOpportunity& opportunity);
-    double calculate_synthetic_price_confidence(const SyntheticPrice& synthetic_price);
+    void refresh_synthetic_prices() const;
+    SyntheticPrice calculate_synthetic_price_for_exchange(InstrumentHandle instrument,
+                                                         VenueIndex exchange) const;
+    double calculate_cross_exchange_spread(const SyntheticPrice& price1, const SyntheticPrice& price2) const;
+    bool validate_synthetic_construction_quality(const SyntheticPrice& synthetic_price) const;
+    double estimate_cross_exchange_execution_cost(const CrossExchangeOpportunity& opportunity) const;
+    double calculate_synthetic_price_confidence(const SyntheticPrice& synthetic_price) const;
     
 public:
     CrossExchangeSyntheticPriceComparator(std::unique_ptr<IPricingModel> model,
                                          const DetectionParameters& params = DetectionParameters{});
     
+    // Venue data arrives through update_exchange_snapshot(); this runs a comparison pass
     void update_market_data(const MarketSnapshot& snapshot) override;
     std::vector<MispricingOpportunity> detect_opportunities() override;
     void set_detection_callback(MispricingCallback callback) override;
@@ -566,9 +882,13 @@ public:
     // Enhanced cross-exchange methods
     void register_exchange_feed(const std::string& exchange_id);
     void update_exchange_snapshot(const std::string& exchange_id, const MarketSnapshot& snapshot);
+    void set_synthetic_components(InstrumentHandle target, const std::vector<InstrumentHandle>& components);
     std::vector<CrossExchangeOpportunity> get_synthetic_price_opportunities() const;
-    SyntheticPrice get_best_synthetic_price(const InstrumentId& instrument) const;
-    std::map<std::string, SyntheticPrice> get_all_exchange_synthetic_prices(const InstrumentId& instrument) const;
+    SyntheticPrice get_best_synthetic_price(InstrumentHandle instrument) const;
+    std::map<std::string, SyntheticPrice> get_all_exchange_synthetic_prices(InstrumentHandle instrument) const;
+    
+    const std::shared_ptr<VenuePriceMatrix>& price_matrix() const { return price_matrix_; }
+    void set_price_matrix(std::shared_ptr<VenuePriceMatrix> matrix) { price_matrix_ = std::move(matrix); }
 };
 
 // Comprehensive Enhanced Mispricing Detector
@@ -605,9 +925,12 @@ public:
     std::vector<CrossExchangeOpportunity> get_all_cross_exchange_opportunities() const;
     
     // Configuration methods
-    void add_instrument_pair_for_stat_arb(const InstrumentId& instrument1, const InstrumentId& instrument2);
-    void add_derivative_pair_for_basis(const InstrumentId& spot, const InstrumentId& derivative);
+    void add_instrument_pair_for_stat_arb(InstrumentHandle instrument1, InstrumentHandle instrument2);
+    void add_derivative_pair_for_basis(InstrumentHandle spot, InstrumentHandle derivative);
     void register_exchange_for_comparison(const std::string& exchange_id);
+    void set_correlation_matrix(std::shared_ptr<const StreamingCorrelationMatrix> matrix) {
+        stat_arb_generator_->set_correlation_matrix(std::move(matrix));
+    }
 };
 
 } // namespace mispricing
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "market_data.hpp"
+#include "correlation_matrix.hpp"
+#include "work_stealing_pool.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace spe
+{
+    namespace exposure
+    {
+
+        using market_data::InstrumentHandle;
+
+        // Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"). Output
+        // is a pure function of (counter, key), so any path's shocks can be regenerated from
+        // its index without carrying generator state between threads or runs.
+        struct Philox4x32
+        {
+            using Counter = std::array<uint32_t, 4>;
+
+            static Counter generate(Counter counter, uint32_t key0, uint32_t key1)
+            {
+                for (int round = 0; round < 10; ++round)
+                {
+                    uint64_t product0 = uint64_t(0xD2511F53u) * counter[0];
+                    uint64_t product1 = uint64_t(0xCD9E8D57u) * counter[2];
+                    counter = {uint32_t(product1 >> 32) ^ counter[1] ^ key0, uint32_t(product1),
+                               uint32_t(product0 >> 32) ^ counter[3] ^ key1, uint32_t(product0)};
+                    key0 += 0x9E3779B9u;
+                    key1 += 0xBB67AE85u;
+                }
+                return counter;
+            }
+        };
+
+        // Inverse standard normal CDF; relative error below 1.2e-9
+        double normal_quantile(double p);
+
+        struct MonteCarloConfig
+        {
+            size_t paths = 20000;        // rounded up to whole batches
+            size_t horizon_days = 1;
+            bool antithetic = true;      // every shock vector is also used negated
+            bool control_variate = true; // corrected against the linearized book, whose VaR/ES are exact
+            size_t max_components = 16;  // past this many instruments, a factor model of this rank; takes
+                                         // effect at the next set_factors()
+            uint64_t seed = 0x5eed5eedULL;
+        };
+
+        // Signed market value held in one instrument; several exposures may share an instrument
+        struct RiskExposure
+        {
+            InstrumentHandle instrument;
+            double notional;
+        };
+
+        struct MonteCarloRiskResult
+        {
+            double value_at_risk = 0.0;      // loss at the confidence level, positive
+            double expected_shortfall = 0.0; // mean loss beyond it
+            std::vector<double> var_contributions; // per exposure, in input order; sum to value_at_risk
+            std::vector<double> es_contributions;  // per exposure, in input order; sum to expected_shortfall
+            double control_beta = 0.0;       // 0 when the control variate is off
+            size_t paths = 0;
+            size_t tail_paths = 0;
+        };
+
+        // Portfolio VaR/ES by simulation over a factor model of the instruments' returns, with
+        // per-horizon volatilities and correlations read once from the shared correlation matrix.
+        // Up to max_components instruments, the correlations are Cholesky-factored and every
+        // instrument has its own shock. Past that, they are reduced to a statistical factor model:
+        // the leading max_components principal components, found by subspace iteration, plus an
+        // independent residual per instrument that restores its own variance. Factor returns are
+        // lognormal, so the book's P&L is not normal; its linearization is, and serves as the
+        // control variate.
+        //
+        // Paths are generated in batches of BATCH_SHOCKS shock vectors laid out row-major, one row
+        // per component and per exposed residual, and a batch's uniforms, normals, loadings multiply
+        // and P&L run through the same per-ISA SIMD kernels as the option pricer. Batch b uses
+        // Philox counters (b, row, lane % (BATCH_SHOCKS / 4)), so results are identical for any
+        // thread count and contributions are computed by regenerating only the tail paths.
+        //
+        // A shock vector costs instruments x components FMAs and components + instruments normals,
+        // where the full Cholesky would take instruments^2 / 2 FMAs. For a 300-position book at
+        // the default 20000 paths, one AVX-512 core measured about 0.8 ms over 10 instruments,
+        // 3.5 ms over 50 and 5.6 ms over 100 (pre_trade_monte_carlo_var); the VaR came within 0.5%
+        // of the full Cholesky's. The residuals keep the cost linear in instruments, about 16 ms
+        // over 300; PARALLEL mode splits the batches over the pool.
+        //
+        // set_factors() is the expensive step; run() reuses the factorization, so a pre-trade
+        // check that only changes exposures pays for the paths alone. Not thread-safe: run()
+        // reuses scratch buffers.
+        class MonteCarloVarEngine
+        {
+        public:
+            static constexpr size_t BATCH_SHOCKS = 32;
+
+        private:
+            MonteCarloConfig config_;
+            concurrency::ExecutionMode execution_mode_;
+            std::shared_ptr<concurrency::WorkStealingPool> pool_;
+
+            // Factor model
+            std::vector<InstrumentHandle> factors_;
+            std::vector<uint32_t> factor_by_instrument_; // dense by handle
+            size_t components_;                          // common factors
+            std::vector<double> loadings_;               // instruments x components_, row-major
+            std::vector<double> residual_volatilities_;  // per instrument; empty under the full Cholesky
+            std::vector<double> drifts_;                 // -variance / 2, keeping E[price relative] = 1
+            double correlation_shrinkage_;
+
+            // Scratch, reused across runs
+            std::vector<double> factor_notionals_;
+            std::vector<double> losses_;
+            std::vector<double> linear_losses_;
+            std::vector<double> batch_moments_; // per batch: sum L, sum Llin, sum L*Llin, sum Llin^2
+            std::vector<uint32_t> ranked_paths_;
+            std::vector<std::vector<double>> task_scratch_;
+
+            size_t paths_per_batch() const { return config_.antithetic ? 2 * BATCH_SHOCKS : BATCH_SHOCKS; }
+            void simulate_batch(size_t batch, std::vector<double> &scratch);
+            void path_returns(size_t path, std::vector<double> &shocks, std::vector<double> &returns) const;
+            bool factorize(const std::vector<double> &correlations, const std::vector<double> &volatilities);
+            void principal_components(const std::vector<double> &correlations, const std::vector<double> &volatilities);
+
+        public:
+            explicit MonteCarloVarEngine(const MonteCarloConfig &config = MonteCarloConfig{});
+
+            // horizon_days takes effect at the next set_factors()
+            void set_config(const MonteCarloConfig &config) { config_ = config; }
+            const MonteCarloConfig &config() const { return config_; }
+            void set_execution_mode(concurrency::ExecutionMode mode,
+                                    std::shared_ptr<concurrency::WorkStealingPool> pool = nullptr);
+
+            // Daily volatilities, one per instrument; correlations from the matrix where it
+            // covers both instruments, else 0. For the Cholesky, a matrix that is not positive
+            // definite (pairwise estimates read while the writer runs) is shrunk toward the
+            // identity until it is; the factor model drops negative eigenvalues instead.
+            void set_factors(const std::vector<InstrumentHandle> &instruments,
+                             const std::vector<double> &daily_volatilities,
+                             const stats::StreamingCorrelationMatrix *correlations);
+
+            const std::vector<InstrumentHandle> &factors() const { return factors_; }
+            bool has_factor(InstrumentHandle instrument) const
+            {
+                return instrument < factor_by_instrument_.size() && factor_by_instrument_[instrument] != UINT32_MAX;
+            }
+            double correlation_shrinkage() const { return correlation_shrinkage_; } // 0 when none was needed
+            size_t components() const { return components_; } // instruments when Cholesky-factored
+
+            // Exposures in instruments without a factor carry no risk and get zero contributions.
+            // With losses, it receives every simulated loss (positive = loss), in path order.
+            MonteCarloRiskResult run(const std::vector<RiskExposure> &exposures, double confidence_level,
+                                     std::vector<double> *losses = nullptr);
+        };
+
+    } // namespace exposure
+} // namespace spe
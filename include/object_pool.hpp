@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace spe
+{
+    namespace memory
+    {
+
+        // Generation-checked reference to a pooled object; goes stale once the slot is released
+        struct PoolHandle
+        {
+            uint32_t index = std::numeric_limits<uint32_t>::max();
+            uint32_t generation = 0;
+
+            bool valid() const { return index != std::numeric_limits<uint32_t>::max(); }
+            bool operator==(const PoolHandle &other) const { return index == other.index && generation == other.generation; }
+            bool operator!=(const PoolHandle &other) const { return !(*this == other); }
+        };
+
+        // Slab pool of T. Slots live in fixed-size chunks, so objects never move and references
+        // stay valid while the pool grows. Released slots go on a free list and are handed out
+        // again with their previous contents (and any buffers those own) intact; callers
+        // overwrite what they use. Live slots are also kept in a dense list for iteration.
+        template <typename T, size_t ChunkSize = 64>
+        class ObjectPool
+        {
+        private:
+            struct Slot
+            {
+                T value;
+                uint32_t generation = 0;
+                uint32_t live_position = 0; // index into live_ while live
+                bool live = false;
+            };
+
+            std::vector<std::unique_ptr<Slot[]>> chunks_;
+            std::vector<uint32_t> free_;
+            std::vector<uint32_t> live_;
+
+            Slot &slot(uint32_t index) { return chunks_[index / ChunkSize][index % ChunkSize]; }
+            const Slot &slot(uint32_t index) const { return chunks_[index / ChunkSize][index % ChunkSize]; }
+
+            const Slot *find(PoolHandle handle) const
+            {
+                if (handle.index >= chunks_.size() * ChunkSize)
+                {
+                    return nullptr;
+                }
+                const Slot &candidate = slot(handle.index);
+                return (candidate.live && candidate.generation == handle.generation) ? &candidate : nullptr;
+            }
+
+        public:
+            ObjectPool() = default;
+            ObjectPool(const ObjectPool &) = delete;
+            ObjectPool &operator=(const ObjectPool &) = delete;
+
+            PoolHandle acquire()
+            {
+                if (free_.empty())
+                {
+                    uint32_t base = static_cast<uint32_t>(chunks_.size() * ChunkSize);
+                    chunks_.emplace_back(new Slot[ChunkSize]);
+                    for (uint32_t i = ChunkSize; i > 0; --i)
+                    {
+                        free_.push_back(base + i - 1); // lowest index first out
+                    }
+                }
+
+                uint32_t index = free_.back();
+                free_.pop_back();
+                Slot &acquired = slot(index);
+                acquired.live = true;
+                acquired.live_position = static_cast<uint32_t>(live_.size());
+                live_.push_back(index);
+                return PoolHandle{index, acquired.generation};
+            }
+
+            void release(PoolHandle handle)
+            {
+                if (!find(handle))
+                {
+                    return;
+                }
+                Slot &released = slot(handle.index);
+                released.live = false;
+                ++released.generation;
+
+                // Swap-remove from the dense live list
+                uint32_t moved = live_.back();
+                live_[released.live_position] = moved;
+                slot(moved).live_position = released.live_position;
+                live_.pop_back();
+                free_.push_back(handle.index);
+            }
+
+            T *get(PoolHandle handle) { return const_cast<T *>(static_cast<const ObjectPool *>(this)->get(handle)); }
+            const T *get(PoolHandle handle) const
+            {
+                const Slot *found = find(handle);
+                return found ? &found->value : nullptr;
+            }
+
+            // Live objects in no particular order; visitor(PoolHandle, T&) must not release
+            template <typename Visitor>
+            void for_each(Visitor &&visitor)
+            {
+                for (uint32_t index : live_)
+                {
+                    Slot &live = slot(index);
+                    visitor(PoolHandle{index, live.generation}, live.value);
+                }
+            }
+
+            template <typename Visitor>
+            void for_each(Visitor &&visitor) const
+            {
+                for (uint32_t index : live_)
+                {
+                    const Slot &live = slot(index);
+                    visitor(PoolHandle{index, live.generation}, live.value);
+                }
+            }
+
+            // Releases every live object for which predicate(const T&) holds
+            template <typename Predicate>
+            size_t release_if(Predicate &&predicate)
+            {
+                size_t released = 0;
+                for (size_t i = live_.size(); i > 0; --i)
+                {
+                    uint32_t index = live_[i - 1];
+                    Slot &candidate = slot(index);
+                    if (predicate(static_cast<const T &>(candidate.value)))
+                    {
+                        release(PoolHandle{index, candidate.generation});
+                        ++released;
+                    }
+                }
+                return released;
+            }
+
+            void clear()
+            {
+                while (!live_.empty())
+                {
+                    uint32_t index = live_.back();
+                    release(PoolHandle{index, slot(index).generation});
+                }
+            }
+
+            size_t size() const { return live_.size(); }
+            bool empty() const { return live_.empty(); }
+            size_t capacity() const { return chunks_.size() * ChunkSize; }
+        };
+
+    } // namespace memory
+} // namespace spe
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace spe
+{
+    namespace pricing
+    {
+
+        // One underlying's option chain in structure-of-arrays form, so a whole strike/expiry
+        // surface is priced in a single vectorized pass.
+        struct OptionChain
+        {
+            std::vector<double> strikes;
+            std::vector<double> expiries;     // time to expiry in years
+            std::vector<double> volatilities;
+            std::vector<double> option_signs; // +1 call, -1 put
+
+            size_t add(double strike, double time_to_expiry, double volatility, bool is_call)
+            {
+                strikes.push_back(strike);
+                expiries.push_back(time_to_expiry);
+                volatilities.push_back(volatility);
+                option_signs.push_back(is_call ? 1.0 : -1.0);
+                return strikes.size() - 1;
+            }
+
+            void reserve(size_t count)
+            {
+                strikes.reserve(count);
+                expiries.reserve(count);
+                volatilities.reserve(count);
+                option_signs.reserve(count);
+            }
+
+            void clear()
+            {
+                strikes.clear();
+                expiries.clear();
+                volatilities.clear();
+                option_signs.clear();
+            }
+
+            size_t size() const { return strikes.size(); }
+            bool empty() const { return strikes.empty(); }
+        };
+
+        // Price and Greeks per chain entry. Theta is per year, vega and rho per unit (not %)
+        // change in volatility and rate.
+        struct OptionChainGreeks
+        {
+            std::vector<double> prices;
+            std::vector<double> deltas;
+            std::vector<double> gammas;
+            std::vector<double> thetas;
+            std::vector<double> vegas;
+            std::vector<double> rhos;
+
+            void resize(size_t count)
+            {
+                prices.resize(count);
+                deltas.resize(count);
+                gammas.resize(count);
+                thetas.resize(count);
+                vegas.resize(count);
+                rhos.resize(count);
+            }
+
+            size_t size() const { return prices.size(); }
+        };
+
+        enum class SimdLevel
+        {
+            SCALAR,
+            AVX2,
+            AVX512
+        };
+
+        // Widest kernel supported by both the build and the running CPU (detected once)
+        SimdLevel active_simd_level();
+        const char *simd_level_name(SimdLevel level);
+
+        // Black-Scholes price plus delta/gamma/theta/vega/rho for every entry of the chain, with
+        // d1/d2, the discount factor and N(.) shared across outputs. Resizes `greeks` as needed.
+        void price_option_chain(double spot, double risk_free_rate,
+                                const OptionChain &chain, OptionChainGreeks &greeks);
+
+        // Same, forcing a kernel; falls back to scalar if `level` is unavailable
+        void price_option_chain(double spot, double risk_free_rate,
+                                const OptionChain &chain, OptionChainGreeks &greeks, SimdLevel level);
+
+    } // namespace pricing
+} // namespace spe
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "market_data.hpp"
+#include "seqlock.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace spe
+{
+    namespace market_data
+    {
+
+        // How an exchange orders its book deltas
+        enum class BookSequencing
+        {
+            NONE,            // apply everything as it arrives
+            OKX,             // prevSeqId must equal the last seqId; CRC32 over the top 25 levels
+            BINANCE_SPOT,    // first update brackets the snapshot's lastUpdateId, then U == last u + 1
+            BINANCE_FUTURES  // first update brackets the snapshot's lastUpdateId, then pu == last u
+        };
+
+        enum class BookUpdateResult
+        {
+            APPLIED,
+            STALE,             // already covered by the current book; dropped
+            GAP,               // sequence break; the book is out of sync until the next snapshot
+            CHECKSUM_MISMATCH, // applied but failed validation; out of sync until the next snapshot
+            AWAITING_SNAPSHOT  // out of sync; deltas are dropped until a snapshot arrives
+        };
+
+        // Sequencing fields of one snapshot or delta frame
+        struct BookSequence
+        {
+            bool is_snapshot = false;
+            uint64_t first_update_id = 0;    // Binance U
+            uint64_t last_update_id = 0;     // Binance u / lastUpdateId, OKX seqId
+            uint64_t previous_update_id = 0; // Binance pu, OKX prevSeqId
+            bool has_checksum = false;
+            int32_t checksum = 0;
+            Timestamp timestamp;
+        };
+
+        // A price or size as the exchange wrote it, copied inline so a book level holds it
+        // without allocating. Text longer than CAPACITY is not kept.
+        struct WireDecimal
+        {
+            static constexpr size_t CAPACITY = 23;
+
+            char text[CAPACITY];
+            uint8_t length = 0;
+
+            bool assign(std::string_view value)
+            {
+                if (value.size() > CAPACITY)
+                {
+                    length = 0;
+                    return false;
+                }
+                value.copy(text, value.size());
+                length = static_cast<uint8_t>(value.size());
+                return true;
+            }
+
+            bool empty() const { return length == 0; }
+            std::string_view view() const { return std::string_view(text, length); }
+        };
+
+        struct OrderBookStatistics
+        {
+            uint64_t updates_applied = 0;
+            uint64_t snapshots_applied = 0;
+            uint64_t stale_updates = 0;
+            uint64_t gaps = 0;
+            uint64_t checksum_failures = 0;
+        };
+
+        // Incremental L2 book for one instrument. Each side is a flat price-sorted vector with
+        // the best level at the back, so the common case of a change near the touch moves
+        // almost nothing. Deltas are applied in place by the feed thread:
+        //
+        //   if (book.begin_update(sequence) == BookUpdateResult::APPLIED)
+        //   {
+        //       book.set_level(Side::BID, price, size); // size 0 removes the level
+        //       ...
+        //       result = book.commit_update(sequence);
+        //   }
+        //
+        // Every commit publishes the top MarketDepth::MAX_LEVELS through a seqlock, so any
+        // thread can read the current top of book without locking or copying the ladder.
+        // GAP and CHECKSUM_MISMATCH mean the caller should fetch a snapshot; until it lands
+        // the last good view stays published and last_update_id() keeps the last good id.
+        //
+        // OKX checksums the strings it sent, so an OKX book keeps each level's wire text
+        // (set_level with text) and hashes that; levels set without text are formatted from
+        // their values instead.
+        class OrderBook
+        {
+        private:
+            InstrumentHandle instrument_;
+            BookSequencing sequencing_;
+            size_t max_levels_; // per side; 0 keeps everything the exchange sends
+
+            struct LevelText
+            {
+                WireDecimal price;
+                WireDecimal size;
+            };
+
+            std::vector<PriceLevel> bids_; // ascending price, best last
+            std::vector<PriceLevel> asks_; // descending price, best last
+            std::vector<LevelText> bid_text_; // OKX only: wire text, index for index with bids_
+            std::vector<LevelText> ask_text_;
+            bool keeps_text_;
+
+            bool synced_;
+            bool awaiting_first_update_; // Binance: next delta must bracket the snapshot id
+            uint64_t last_update_id_;
+            OrderBookStatistics statistics_;
+
+            std::string checksum_buffer_;
+            concurrency::Seqlock<MarketDepth> view_;
+
+            void trim();
+            void publish(const BookSequence &sequence);
+            int32_t okx_checksum();
+            BookUpdateResult lose_sync(BookUpdateResult reason);
+
+        public:
+            explicit OrderBook(InstrumentHandle instrument, BookSequencing sequencing = BookSequencing::NONE,
+                               size_t max_levels = 0);
+
+            OrderBook(const OrderBook &) = delete;
+            OrderBook &operator=(const OrderBook &) = delete;
+
+            // Writer side (feed thread)
+            BookUpdateResult begin_update(const BookSequence &sequence);
+            void set_level(Side side, Price price, Volume size);
+            // Same, with the level as the exchange wrote it (unquoted), for checksums over wire text
+            void set_level(Side side, Price price, Volume size, std::string_view price_text, std::string_view size_text);
+            BookUpdateResult commit_update(const BookSequence &sequence);
+
+            // Drops the ladder and waits for a snapshot, e.g. after a reconnect
+            void reset();
+
+            bool is_synced() const { return synced_; }
+            uint64_t last_update_id() const { return last_update_id_; }
+            const OrderBookStatistics &statistics() const { return statistics_; }
+            size_t bid_levels() const { return bids_.size(); }
+            size_t ask_levels() const { return asks_.size(); }
+
+            // Reader side (any thread)
+            void top(MarketDepth &out) const { view_.load(out); }
+            uint64_t view_version() const { return view_.version(); }
+
+            InstrumentHandle instrument() const { return instrument_; }
+            BookSequencing sequencing() const { return sequencing_; }
+        };
+
+    } // namespace market_data
+} // namespace spe
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "market_data.hpp"
+#include "option_batch_pricing.hpp"
+#include "double_buffer.hpp"
+#include "linear_algebra.hpp"
 #include <vector>
 #include <map>
 #include <memory>
@@ -26,7 +29,7 @@ struct SyntheticPrice {
     Price bid_price;
     Price ask_price;
     double confidence_score;
-    std::vector<InstrumentId> component_instruments;
+    std::vector<InstrumentHandle> component_instruments;
     std::vector<double> weights;
     Timestamp calculation_time;
     
@@ -35,7 +38,7 @@ struct SyntheticPrice {
 };
 
 struct PriceDeviation {
-    InstrumentId instrument_id;
+    InstrumentHandle instrument;
     Price market_price;
     Price theoretical_price;
     double deviation_percentage;
@@ -53,17 +56,17 @@ public:
     virtual ~IPricingModel() = default;
     
     virtual SyntheticPrice calculate_synthetic_price(
-        const InstrumentId& target_instrument,
-        const std::vector<InstrumentId>& component_instruments,
+        InstrumentHandle target_instrument,
+        const std::vector<InstrumentHandle>& component_instruments,
         const MarketSnapshot& market_data) = 0;
         
     virtual std::vector<double> calculate_weights(
-        const std::vector<InstrumentId>& instruments,
+        const std::vector<InstrumentHandle>& instruments,
         const MarketSnapshot& market_data) = 0;
         
     virtual double calculate_correlation(
-        const InstrumentId& instrument1,
-        const InstrumentId& instrument2,
+        InstrumentHandle instrument1,
+        InstrumentHandle instrument2,
         const std::vector<Quote>& historical_data) = 0;
         
     virtual void update_parameters(const PricingParameters& params) = 0;
@@ -78,9 +81,54 @@ struct VolatilitySurface {
     double get_atm_volatility(double spot_price, double time_to_expiry) const;
 };
 
+// Read-optimised form of a VolatilitySurface: sorted strike/tenor axes and a dense tenor-major
+// grid, so a lookup is two bracket searches plus a bilinear blend. Grid cells with no quote are
+// filled by linear interpolation along strike, then along tenor; queries outside the axes are
+// clamped to the edge (flat extrapolation).
+class CompiledVolatilitySurface {
+private:
+    std::vector<double> strikes_;
+    std::vector<double> tenors_;
+    std::vector<double> vols_;  // vols_[tenor_index * strikes_.size() + strike_index]
+    
+public:
+    CompiledVolatilitySurface() = default;
+    explicit CompiledVolatilitySurface(const VolatilitySurface& surface);
+    
+    double interpolate(double strike, double time_to_expiry) const;
+    
+    // Batch lookup for a chain; consecutive entries with the same expiry share the tenor bracket
+    void interpolate(const double* strikes, const double* expiries, double* volatilities, size_t count) const;
+    
+    bool empty() const { return vols_.empty(); }
+    size_t strike_count() const { return strikes_.size(); }
+    size_t tenor_count() const { return tenors_.size(); }
+};
+
+// Static terms of a listed option
+struct OptionContract {
+    InstrumentHandle underlying;
+    double strike;
+    double time_to_expiry;  // years
+    bool is_call;
+    
+    OptionContract() : underlying(INVALID_INSTRUMENT), strike(0.0), time_to_expiry(0.0), is_call(true) {}
+    OptionContract(InstrumentHandle underlying, double strike, double time_to_expiry, bool is_call)
+        : underlying(underlying), strike(strike), time_to_expiry(time_to_expiry), is_call(is_call) {}
+};
+
+// Static terms of a listed future
+struct FuturesContract {
+    InstrumentHandle underlying;  // the spot leg
+    Timestamp expiry;
+    
+    FuturesContract() : underlying(INVALID_INSTRUMENT) {}
+    FuturesContract(InstrumentHandle underlying, Timestamp expiry) : underlying(underlying), expiry(expiry) {}
+};
+
 // Funding Rate Structure
 struct FundingRate {
-    InstrumentId instrument_id;
+    InstrumentHandle instrument;
     double rate;
     Timestamp timestamp;
     std::chrono::hours frequency;  // funding frequency
@@ -93,9 +141,9 @@ struct FundingRate {
 class PerpetualSwapPricingModel : public IPricingModel {
 private:
     PricingParameters params_;
-    std::map<InstrumentId, FundingRate> funding_rates_;
+    std::map<InstrumentHandle, FundingRate> funding_rates_;
     
-    double calculate_funding_component(const InstrumentId& instrument,
+    double calculate_funding_component(InstrumentHandle instrument,
                                        const MarketSnapshot& market_data,
                                        const FundingRate& funding_rate);
     
@@ -110,35 +158,37 @@ public:
     PerpetualSwapPricingModel(const PricingParameters& params = PricingParameters{});
     
     SyntheticPrice calculate_synthetic_price(
-        const InstrumentId& target_instrument,
-        const std::vector<InstrumentId>& component_instruments,
+        InstrumentHandle target_instrument,
+        const std::vector<InstrumentHandle>& component_instruments,
         const MarketSnapshot& market_data) override;
         
     std::vector<double> calculate_weights(
-        const std::vector<InstrumentId>& instruments,
+        const std::vector<InstrumentHandle>& instruments,
         const MarketSnapshot& market_data) override;
         
     double calculate_correlation(
-        const InstrumentId& instrument1,
-        const InstrumentId& instrument2,
+        InstrumentHandle instrument1,
+        InstrumentHandle instrument2,
         const std::vector<Quote>& historical_data) override;
         
     void update_parameters(const PricingParameters& params) override;
     
     // Specific methods for perpetual swaps
-    void update_funding_rate(const InstrumentId& instrument, const FundingRate& rate);
-    double get_current_funding_rate(const InstrumentId& instrument) const;
-    double calculate_funding_payment(const InstrumentId& instrument, Volume position_size) const;
+    void update_funding_rate(InstrumentHandle instrument, const FundingRate& rate);
+    double get_current_funding_rate(InstrumentHandle instrument) const;
+    double calculate_funding_payment(InstrumentHandle instrument, Volume position_size) const;
 };
 
 // Futures Pricing Model with Cost of Carry
 class FuturesPricingModel : public IPricingModel {
 private:
     PricingParameters params_;
-    std::map<InstrumentId, double> interest_rates_;
-    std::map<InstrumentId, double> dividend_yields_;
+    std::map<InstrumentHandle, double> interest_rates_;
+    std::map<InstrumentHandle, double> dividend_yields_;
+    std::map<InstrumentHandle, FuturesContract> futures_contracts_;
+    std::map<InstrumentHandle, std::vector<InstrumentHandle>> listed_futures_;  // by underlying, nearest expiry first
     
-    double calculate_cost_of_carry(const InstrumentId& instrument,
+    double calculate_cost_of_carry(InstrumentHandle instrument,
                                    const MarketSnapshot& market_data,
                                    double interest_rate,
                                    double dividend_yield);
@@ -147,95 +197,113 @@ private:
                                    double cost_of_carry,
                                    double time_to_maturity);
     
-    double get_time_to_maturity(const InstrumentId& instrument) const;
+    double get_time_to_maturity(InstrumentHandle instrument) const;
     
 public:
     FuturesPricingModel(const PricingParameters& params = PricingParameters{});
     
     SyntheticPrice calculate_synthetic_price(
-        const InstrumentId& target_instrument,
-        const std::vector<InstrumentId>& component_instruments,
+        InstrumentHandle target_instrument,
+        const std::vector<InstrumentHandle>& component_instruments,
         const MarketSnapshot& market_data) override;
         
     std::vector<double> calculate_weights(
-        const std::vector<InstrumentId>& instruments,
+        const std::vector<InstrumentHandle>& instruments,
         const MarketSnapshot& market_data) override;
         
     double calculate_correlation(
-        const InstrumentId& instrument1,
-        const InstrumentId& instrument2,
+        InstrumentHandle instrument1,
+        InstrumentHandle instrument2,
         const std::vector<Quote>& historical_data) override;
         
     void update_parameters(const PricingParameters& params) override;
     
     // Specific methods for futures
-    void set_interest_rate(const InstrumentId& instrument, double rate);
-    void set_dividend_yield(const InstrumentId& instrument, double yield);
-    double calculate_basis(const InstrumentId& futures_instrument, const Quote& spot_quote) const;
+    void set_interest_rate(InstrumentHandle instrument, double rate);
+    void set_dividend_yield(InstrumentHandle instrument, double yield);
+    double calculate_basis(InstrumentHandle futures_instrument, const Quote& spot_quote) const;
+    
+    // Listed contracts; the term structure of an underlying is its futures in expiry order
+    void register_futures_contract(InstrumentHandle futures, const FuturesContract& contract);
+    const FuturesContract* get_futures_contract(InstrumentHandle futures) const;
+    const std::vector<InstrumentHandle>& get_listed_futures(InstrumentHandle underlying) const;
+    
+    // Annual carry (interest less yield), set on the contract or else on its underlying
+    double get_carry_rate(InstrumentHandle futures) const;
+    // Years from now to expiry, 0 once expired; contracts not registered get the demo 3 months
+    double get_time_to_maturity(InstrumentHandle futures, Timestamp now) const;
 };
 
 // Options Pricing Model with Volatility Surface
 class OptionsPricingModel : public IPricingModel {
 private:
     PricingParameters params_;
-    std::map<InstrumentId, VolatilitySurface> volatility_surfaces_;
-    std::map<InstrumentId, double> risk_free_rates_;
-    
-    double interpolate_volatility(const InstrumentId& instrument,
-                                  const MarketSnapshot& market_data,
-                                  double strike,
-                                  double time_to_maturity);
+    std::map<InstrumentHandle, VolatilitySurface> volatility_surfaces_;
+    std::map<InstrumentHandle, double> risk_free_rates_;
     
-    double calculate_black_scholes_price(const Quote& spot_quote,
-                                         double strike,
-                                         double volatility,
-                                         double time_to_maturity,
-                                         double risk_free_rate,
-                                         bool is_call);
+    // Compiled surfaces indexed by underlying handle; rebuilt and flipped by update_volatility_surface
+    using CompiledSurfaceTable = std::vector<std::shared_ptr<const CompiledVolatilitySurface>>;
+    concurrency::DoubleBuffered<CompiledSurfaceTable> compiled_surfaces_;
     
-    double calculate_delta(const Quote& spot_quote, double strike, double volatility,
-                          double time_to_maturity, double risk_free_rate, bool is_call);
+    std::map<InstrumentHandle, OptionContract> option_contracts_;
     
-    double calculate_gamma(const Quote& spot_quote, double strike, double volatility,
-                          double time_to_maturity, double risk_free_rate);
+    // Every registered option on one underlying, kept in SoA form for batch repricing
+    struct UnderlyingChain {
+        std::vector<InstrumentHandle> options;
+        OptionChain chain;
+        OptionChainGreeks greeks;
+    };
+    std::map<InstrumentHandle, UnderlyingChain> chains_;
     
-    double calculate_theta(const Quote& spot_quote, double strike, double volatility,
-                          double time_to_maturity, double risk_free_rate, bool is_call);
-    
-    double calculate_vega(const Quote& spot_quote, double strike, double volatility,
-                         double time_to_maturity, double risk_free_rate);
+    double get_risk_free_rate(InstrumentHandle underlying) const;
     
 public:
     OptionsPricingModel(const PricingParameters& params = PricingParameters{});
     
     SyntheticPrice calculate_synthetic_price(
-        const InstrumentId& target_instrument,
-        const std::vector<InstrumentId>& component_instruments,
+        InstrumentHandle target_instrument,
+        const std::vector<InstrumentHandle>& component_instruments,
         const MarketSnapshot& market_data) override;
         
     std::vector<double> calculate_weights(
-        const std::vector<InstrumentId>& instruments,
+        const std::vector<InstrumentHandle>& instruments,
         const MarketSnapshot& market_data) override;
         
     double calculate_correlation(
-        const InstrumentId& instrument1,
-        const InstrumentId& instrument2,
+        InstrumentHandle instrument1,
+        InstrumentHandle instrument2,
         const std::vector<Quote>& historical_data) override;
         
     void update_parameters(const PricingParameters& params) override;
     
     // Specific methods for options
-    void update_volatility_surface(const InstrumentId& instrument, const VolatilitySurface& surface);
-    void set_risk_free_rate(const InstrumentId& instrument, double rate);
-    double get_implied_volatility(const InstrumentId& option, const Quote& market_quote, const Quote& spot_quote) const;
-    std::map<std::string, double> calculate_greeks(const InstrumentId& option, const Quote& spot_quote) const;
+    void update_volatility_surface(InstrumentHandle instrument, const VolatilitySurface& surface);
+    void set_risk_free_rate(InstrumentHandle instrument, double rate);
+    double get_implied_volatility(InstrumentHandle option, const Quote& market_quote, const Quote& spot_quote) const;
+    std::map<std::string, double> calculate_greeks(InstrumentHandle option, const Quote& spot_quote) const;
+    
+    // Batch API: one vectorized pass prices the chain and all Greeks
+    void register_option(InstrumentHandle option, const OptionContract& contract);
+    const OptionContract* get_option_contract(InstrumentHandle option) const;
+    const std::vector<InstrumentHandle>& get_chain_options(InstrumentHandle underlying) const;
+    
+    // Reprices every registered option on the underlying; result is indexed like get_chain_options()
+    const OptionChainGreeks& price_underlying_chain(InstrumentHandle underlying, const Quote& spot_quote);
+    
+    // Lock-free surface reads; safe to call while update_volatility_surface runs on another thread
+    double get_volatility(InstrumentHandle underlying, double strike, double time_to_expiry) const;
+    void fill_chain_volatilities(InstrumentHandle underlying, OptionChain& chain) const;
+    
+    // Prices an arbitrary chain; entries with volatility <= 0 are filled in from the underlying's surface
+    void price_chain(InstrumentHandle underlying, const Quote& spot_quote,
+                     OptionChain& chain, OptionChainGreeks& greeks) const;
 };
 
 // Cross-Currency Synthetic Pricing (e.g., EUR/JPY from EUR/USD and USD/JPY)
 class CrossCurrencyPricingModel : public IPricingModel {
 private:
     PricingParameters params_;
-    std::map<std::pair<InstrumentId, InstrumentId>, double> correlation_cache_;
+    std::map<std::pair<InstrumentHandle, InstrumentHandle>, double> correlation_cache_;
     
     double calculate_cross_rate(const Quote& base_quote, const Quote& quote_quote, bool invert_quote = false);
     double calculate_spread_adjustment(const Quote& base_quote, const Quote& quote_quote);
@@ -244,17 +312,17 @@ public:
     CrossCurrencyPricingModel(const PricingParameters& params = PricingParameters{});
     
     SyntheticPrice calculate_synthetic_price(
-        const InstrumentId& target_instrument,
-        const std::vector<InstrumentId>& component_instruments,
+        InstrumentHandle target_instrument,
+        const std::vector<InstrumentHandle>& component_instruments,
         const MarketSnapshot& market_data) override;
         
     std::vector<double> calculate_weights(
-        const std::vector<InstrumentId>& instruments,
+        const std::vector<InstrumentHandle>& instruments,
         const MarketSnapshot& market_data) override;
         
     double calculate_correlation(
-        const InstrumentId& instrument1,
-        const InstrumentId& instrument2,
+        InstrumentHandle instrument1,
+        InstrumentHandle instrument2,
         const std::vector<Quote>& historical_data) override;
         
     void update_parameters(const PricingParameters& params) override;
@@ -264,9 +332,9 @@ public:
 class StatisticalArbitragePricingModel : public IPricingModel {
 private:
     PricingParameters params_;
-    std::map<InstrumentId, std::vector<Price>> price_history_;
+    std::map<InstrumentHandle, std::vector<Price>> price_history_;
     
-    double calculate_mean_reversion_price(const InstrumentId& instrument, const std::vector<Price>& prices);
+    double calculate_mean_reversion_price(InstrumentHandle instrument, const std::vector<Price>& prices);
     double calculate_volatility(const std::vector<Price>& prices);
     std::pair<double, double> calculate_bollinger_bands(const std::vector<Price>& prices, double std_dev = 2.0);
     
@@ -274,34 +342,43 @@ public:
     StatisticalArbitragePricingModel(const PricingParameters& params = PricingParameters{});
     
     SyntheticPrice calculate_synthetic_price(
-        const InstrumentId& target_instrument,
-        const std::vector<InstrumentId>& component_instruments,
+        InstrumentHandle target_instrument,
+        const std::vector<InstrumentHandle>& component_instruments,
         const MarketSnapshot& market_data) override;
         
     std::vector<double> calculate_weights(
-        const std::vector<InstrumentId>& instruments,
+        const std::vector<InstrumentHandle>& instruments,
         const MarketSnapshot& market_data) override;
         
     double calculate_correlation(
-        const InstrumentId& instrument1,
-        const InstrumentId& instrument2,
+        InstrumentHandle instrument1,
+        InstrumentHandle instrument2,
         const std::vector<Quote>& historical_data) override;
         
     void update_parameters(const PricingParameters& params) override;
     
-    void update_price_history(const InstrumentId& instrument, const Quote& quote);
+    void update_price_history(InstrumentHandle instrument, const Quote& quote);
 };
 
 // Basket Pricing Model (for multi-instrument synthetics)
+// Weights are dense by handle. Covariances come from the shared streaming matrix, gathered
+// into one contiguous block per basket, so a 50-name basket prices in a few flat passes.
 class BasketPricingModel : public IPricingModel {
 private:
     PricingParameters params_;
-    std::map<InstrumentId, double> instrument_weights_;
+    std::vector<double> instrument_weights_;  // dense by handle
+    std::vector<uint8_t> has_weight_;
+    std::shared_ptr<const stats::StreamingCorrelationMatrix> correlation_matrix_;
+    
+    // Scratch for calculate_portfolio_volatility
+    linalg::DenseMatrix covariance_;
+    std::vector<double> exposures_;
     
-    double calculate_basket_price(const std::vector<InstrumentId>& instruments,
+    double calculate_basket_price(const std::vector<InstrumentHandle>& instruments,
                                  const std::vector<double>& weights,
                                  const MarketSnapshot& market_data);
-    double calculate_portfolio_volatility(const std::vector<InstrumentId>& instruments,
+    // Standard deviation of the basket's value per observation of the correlation matrix
+    double calculate_portfolio_volatility(const std::vector<InstrumentHandle>& instruments,
                                         const std::vector<double>& weights,
                                         const MarketSnapshot& market_data);
     
@@ -309,22 +386,28 @@ public:
     BasketPricingModel(const PricingParameters& params = PricingParameters{});
     
     SyntheticPrice calculate_synthetic_price(
-        const InstrumentId& target_instrument,
-        const std::vector<InstrumentId>& component_instruments,
+        InstrumentHandle target_instrument,
+        const std::vector<InstrumentHandle>& component_instruments,
         const MarketSnapshot& market_data) override;
         
+    // Registered weights; instruments without one share 1/n
     std::vector<double> calculate_weights(
-        const std::vector<InstrumentId>& instruments,
+        const std::vector<InstrumentHandle>& instruments,
         const MarketSnapshot& market_data) override;
         
+    // From the correlation matrix when it tracks both, else from the quotes' mid returns
     double calculate_correlation(
-        const InstrumentId& instrument1,
-        const InstrumentId& instrument2,
+        InstrumentHandle instrument1,
+        InstrumentHandle instrument2,
         const std::vector<Quote>& historical_data) override;
         
     void update_parameters(const PricingParameters& params) override;
     
-    void set_instrument_weights(const std::map<InstrumentId, double>& weights);
+    void set_instrument_weights(const std::map<InstrumentHandle, double>& weights);
+    void set_instrument_weight(InstrumentHandle instrument, double weight);
+    void set_correlation_matrix(std::shared_ptr<const stats::StreamingCorrelationMatrix> matrix) {
+        correlation_matrix_ = std::move(matrix);
+    }
 };
 
 } // namespace pricing
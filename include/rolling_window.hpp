@@ -0,0 +1,292 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+namespace spe
+{
+    namespace stats
+    {
+
+        // Fixed-capacity FIFO window. Pushing into a full buffer overwrites the oldest element,
+        // so steady-state updates never allocate. Index 0 is the oldest element.
+        template <typename T>
+        class RingBuffer
+        {
+        private:
+            std::vector<T> data_;
+            size_t head_; // index of the oldest element
+            size_t size_;
+
+        public:
+            explicit RingBuffer(size_t capacity = 0) : data_(capacity), head_(0), size_(0) {}
+
+            // Returns true if the push evicted the oldest element (copied into *evicted when given)
+            bool push(const T &value, T *evicted = nullptr)
+            {
+                if (data_.empty())
+                {
+                    return false;
+                }
+
+                if (size_ < data_.size())
+                {
+                    data_[(head_ + size_) % data_.size()] = value;
+                    ++size_;
+                    return false;
+                }
+
+                if (evicted)
+                {
+                    *evicted = data_[head_];
+                }
+                data_[head_] = value;
+                head_ = (head_ + 1) % data_.size();
+                return true;
+            }
+
+            const T &operator[](size_t index) const { return data_[(head_ + index) % data_.size()]; }
+            const T &front() const { return data_[head_]; }
+            const T &back() const { return (*this)[size_ - 1]; }
+
+            size_t size() const { return size_; }
+            size_t capacity() const { return data_.size(); }
+            bool empty() const { return size_ == 0; }
+            bool full() const { return size_ == data_.size(); }
+
+            void clear()
+            {
+                head_ = 0;
+                size_ = 0;
+            }
+
+            // Drops contents and resizes the window
+            void reset(size_t capacity)
+            {
+                data_.assign(capacity, T{});
+                clear();
+            }
+
+            // Copies the window out oldest-first; off the hot path only
+            std::vector<T> to_vector() const
+            {
+                std::vector<T> values;
+                values.reserve(size_);
+                for (size_t i = 0; i < size_; ++i)
+                {
+                    values.push_back((*this)[i]);
+                }
+                return values;
+            }
+        };
+
+        // Rolling-window statistics with O(1) updates: sliding-window Welford mean/variance,
+        // an EWMA, and the lag-1 autocovariance used for AR(1) half-life estimates. The
+        // accumulators are rebuilt exactly from the window once per `capacity` evictions to
+        // stop floating-point drift, which keeps the amortized cost constant.
+        class RollingStatistics
+        {
+        private:
+            RingBuffer<double> window_;
+            double mean_;
+            double m2_;      // sum of squared deviations from mean_
+            double lag_sum_; // sum of x[i-1] * x[i] over adjacent pairs in the window
+            double ewma_;
+            double ewma_alpha_;
+            size_t evictions_since_rebuild_;
+
+            void rebuild()
+            {
+                size_t n = window_.size();
+                mean_ = 0.0;
+                m2_ = 0.0;
+                lag_sum_ = 0.0;
+                for (size_t i = 0; i < n; ++i)
+                {
+                    double x = window_[i];
+                    double delta = x - mean_;
+                    mean_ += delta / static_cast<double>(i + 1);
+                    m2_ += delta * (x - mean_);
+                    if (i > 0)
+                    {
+                        lag_sum_ += window_[i - 1] * x;
+                    }
+                }
+                evictions_since_rebuild_ = 0;
+            }
+
+        public:
+            explicit RollingStatistics(size_t capacity = 100, double ewma_alpha = 0.06)
+                : window_(capacity), mean_(0.0), m2_(0.0), lag_sum_(0.0), ewma_(0.0),
+                  ewma_alpha_(ewma_alpha), evictions_since_rebuild_(0) {}
+
+            void push(double x)
+            {
+                if (window_.capacity() == 0)
+                {
+                    return;
+                }
+
+                ewma_ = window_.empty() ? x : ewma_ + ewma_alpha_ * (x - ewma_);
+
+                if (!window_.full())
+                {
+                    if (!window_.empty())
+                    {
+                        lag_sum_ += window_.back() * x;
+                    }
+                    window_.push(x);
+                    double delta = x - mean_;
+                    mean_ += delta / static_cast<double>(window_.size());
+                    m2_ += delta * (x - mean_);
+                    return;
+                }
+
+                double n = static_cast<double>(window_.size());
+                double oldest = window_.front();
+                if (window_.size() > 1)
+                {
+                    lag_sum_ -= oldest * window_[1];
+                    lag_sum_ += window_.back() * x;
+                }
+                window_.push(x);
+
+                double old_mean = mean_;
+                mean_ += (x - oldest) / n;
+                m2_ += (x - oldest) * (x - mean_ + oldest - old_mean);
+                m2_ = std::max(m2_, 0.0);
+
+                if (++evictions_since_rebuild_ >= window_.capacity())
+                {
+                    rebuild();
+                }
+            }
+
+            void clear()
+            {
+                window_.clear();
+                mean_ = 0.0;
+                m2_ = 0.0;
+                lag_sum_ = 0.0;
+                ewma_ = 0.0;
+                evictions_since_rebuild_ = 0;
+            }
+
+            void reset(size_t capacity)
+            {
+                window_.reset(capacity);
+                clear();
+            }
+
+            // Reloads a saved window, oldest first, keeping the newest `capacity` values
+            void restore(const double *values, size_t count, double ewma)
+            {
+                clear();
+                size_t first = count > window_.capacity() ? count - window_.capacity() : 0;
+                for (size_t i = first; i < count; ++i)
+                {
+                    window_.push(values[i]);
+                }
+                rebuild();
+                ewma_ = window_.empty() ? 0.0 : ewma;
+            }
+
+            size_t size() const { return window_.size(); }
+            size_t capacity() const { return window_.capacity(); }
+            bool empty() const { return window_.empty(); }
+            bool full() const { return window_.full(); }
+            double last() const { return window_.empty() ? 0.0 : window_.back(); }
+            double oldest() const { return window_.empty() ? 0.0 : window_.front(); }
+
+            double mean() const { return mean_; }
+            double sum() const { return mean_ * static_cast<double>(window_.size()); }
+            double ewma() const { return ewma_; }
+
+            // Population variance (divides by n)
+            double variance() const
+            {
+                return window_.empty() ? 0.0 : m2_ / static_cast<double>(window_.size());
+            }
+
+            double sample_variance() const
+            {
+                return window_.size() < 2 ? 0.0 : m2_ / static_cast<double>(window_.size() - 1);
+            }
+
+            double std_dev() const { return std::sqrt(variance()); }
+
+            double z_score(double value) const
+            {
+                double sd = std_dev();
+                return sd > 0 ? (value - mean_) / sd : 0.0;
+            }
+
+            // Covariance between x[i] and x[i-1] around the window mean
+            double lag1_autocovariance() const
+            {
+                size_t n = window_.size();
+                if (n < 2)
+                {
+                    return 0.0;
+                }
+
+                double pairs = static_cast<double>(n - 1);
+                double total = sum();
+                double lead_sum = total - window_.front(); // x[1..n-1]
+                double lag_sum = total - window_.back();   // x[0..n-2]
+                return (lag_sum_ - mean_ * (lead_sum + lag_sum) + pairs * mean_ * mean_) / pairs;
+            }
+
+            double lag1_autocorrelation() const
+            {
+                double var = variance();
+                return var > 0 ? lag1_autocovariance() / var : 0.0;
+            }
+
+            const RingBuffer<double> &values() const { return window_; }
+        };
+
+        // Log-return series over a rolling window of prices, e.g. for realized volatility.
+        // Holds `capacity` prices, i.e. `capacity - 1` returns.
+        class RollingLogReturns
+        {
+        private:
+            RollingStatistics returns_;
+            double last_price_;
+            size_t price_count_;
+            size_t capacity_;
+
+        public:
+            explicit RollingLogReturns(size_t capacity = 100)
+                : returns_(capacity > 1 ? capacity - 1 : 1), last_price_(0.0), price_count_(0),
+                  capacity_(capacity) {}
+
+            void push(double price)
+            {
+                if (price_count_ > 0 && last_price_ > 0 && price > 0)
+                {
+                    returns_.push(std::log(price / last_price_));
+                }
+                last_price_ = price;
+                price_count_ = std::min(price_count_ + 1, capacity_);
+            }
+
+            // Reloads saved returns, e.g. read with the capacity of returns(), and the price state
+            void restore(RollingStatistics returns, double last_price, size_t price_count)
+            {
+                returns_ = std::move(returns);
+                last_price_ = last_price;
+                price_count_ = std::min(price_count, capacity_);
+            }
+
+            // Number of prices currently represented by the window
+            size_t price_count() const { return price_count_; }
+            double last_price() const { return last_price_; }
+            const RollingStatistics &returns() const { return returns_; }
+        };
+
+    } // namespace stats
+} // namespace spe
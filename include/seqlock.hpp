@@ -0,0 +1,95 @@
+#pragma once
+
+#include "lockfree_queue.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace spe
+{
+    namespace concurrency
+    {
+
+        // Single-writer sequence lock over a trivially copyable value. The writer makes the
+        // sequence odd, stores the payload and makes it even again; readers copy the payload
+        // and retry if the sequence moved underneath them. Readers never block the writer and
+        // never take a lock. The payload is held as relaxed atomic words, so a racing read is
+        // well defined (and discarded) rather than a data race.
+        template <typename T>
+        class Seqlock
+        {
+        private:
+            static_assert(std::is_trivially_copyable<T>::value, "Seqlock payload must be trivially copyable");
+            static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+            alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> sequence_;
+            std::atomic<uint64_t> words_[WORDS];
+
+        public:
+            Seqlock() : sequence_(0)
+            {
+                for (auto &word : words_)
+                {
+                    word.store(0, std::memory_order_relaxed);
+                }
+            }
+
+            Seqlock(const Seqlock &) = delete;
+            Seqlock &operator=(const Seqlock &) = delete;
+
+            // Writer only
+            void store(const T &value)
+            {
+                uint64_t buffer[WORDS] = {};
+                std::memcpy(buffer, &value, sizeof(T));
+
+                uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+                sequence_.store(sequence + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                for (size_t i = 0; i < WORDS; ++i)
+                {
+                    words_[i].store(buffer[i], std::memory_order_relaxed);
+                }
+                sequence_.store(sequence + 2, std::memory_order_release);
+            }
+
+            // False if a store was in progress or completed during the copy
+            bool try_load(T &out) const
+            {
+                uint64_t before = sequence_.load(std::memory_order_acquire);
+                if (before & 1)
+                {
+                    return false;
+                }
+
+                uint64_t buffer[WORDS];
+                for (size_t i = 0; i < WORDS; ++i)
+                {
+                    buffer[i] = words_[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence_.load(std::memory_order_relaxed) != before)
+                {
+                    return false;
+                }
+
+                std::memcpy(&out, buffer, sizeof(T));
+                return true;
+            }
+
+            void load(T &out) const
+            {
+                while (!try_load(out))
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            // Number of completed stores; zero until the first one
+            uint64_t version() const { return sequence_.load(std::memory_order_acquire) >> 1; }
+        };
+
+    } // namespace concurrency
+} // namespace spe
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace spe
+{
+    namespace memory
+    {
+
+        // Vector with the first N elements stored inline. Copying or building one with at
+        // most N elements never touches the heap; beyond N it spills to a heap buffer like
+        // std::vector. Meant for the short, hot lists (legs, components, weights) that are
+        // created per opportunity.
+        template <typename T, size_t N>
+        class SmallVector
+        {
+        private:
+            alignas(T) unsigned char inline_storage_[N * sizeof(T)];
+            T *data_;
+            size_t size_;
+            size_t capacity_;
+
+            T *inline_data() { return reinterpret_cast<T *>(inline_storage_); }
+            bool is_inline() const { return data_ == reinterpret_cast<const T *>(inline_storage_); }
+
+            void grow(size_t minimum)
+            {
+                size_t capacity = capacity_ * 2 > minimum ? capacity_ * 2 : minimum;
+                T *buffer = static_cast<T *>(::operator new(capacity * sizeof(T)));
+                for (size_t i = 0; i < size_; ++i)
+                {
+                    new (buffer + i) T(std::move(data_[i]));
+                    data_[i].~T();
+                }
+                release_heap();
+                data_ = buffer;
+                capacity_ = capacity;
+            }
+
+            void release_heap()
+            {
+                if (!is_inline())
+                {
+                    ::operator delete(data_);
+                }
+            }
+
+            void destroy_elements()
+            {
+                for (size_t i = 0; i < size_; ++i)
+                {
+                    data_[i].~T();
+                }
+                size_ = 0;
+            }
+
+        public:
+            using value_type = T;
+            using iterator = T *;
+            using const_iterator = const T *;
+
+            SmallVector() : data_(inline_data()), size_(0), capacity_(N) {}
+
+            SmallVector(std::initializer_list<T> values) : SmallVector() { assign(values.begin(), values.end()); }
+
+            template <typename InputIt>
+            SmallVector(InputIt first, InputIt last) : SmallVector() { assign(first, last); }
+
+            SmallVector(const SmallVector &other) : SmallVector() { assign(other.begin(), other.end()); }
+
+            SmallVector(SmallVector &&other) noexcept : SmallVector() { *this = std::move(other); }
+
+            ~SmallVector()
+            {
+                destroy_elements();
+                release_heap();
+            }
+
+            SmallVector &operator=(const SmallVector &other)
+            {
+                if (this != &other)
+                {
+                    assign(other.begin(), other.end());
+                }
+                return *this;
+            }
+
+            SmallVector &operator=(SmallVector &&other) noexcept
+            {
+                if (this == &other)
+                {
+                    return *this;
+                }
+                destroy_elements();
+                if (!other.is_inline())
+                {
+                    // Steal the heap buffer
+                    release_heap();
+                    data_ = other.data_;
+                    size_ = other.size_;
+                    capacity_ = other.capacity_;
+                    other.data_ = other.inline_data();
+                    other.size_ = 0;
+                    other.capacity_ = N;
+                    return *this;
+                }
+                for (size_t i = 0; i < other.size_; ++i)
+                {
+                    new (data_ + i) T(std::move(other.data_[i]));
+                }
+                size_ = other.size_;
+                other.destroy_elements();
+                return *this;
+            }
+
+            SmallVector &operator=(std::initializer_list<T> values)
+            {
+                assign(values.begin(), values.end());
+                return *this;
+            }
+
+            // Keeps the current buffer when it is large enough
+            template <typename InputIt>
+            void assign(InputIt first, InputIt last)
+            {
+                destroy_elements();
+                size_t count = static_cast<size_t>(std::distance(first, last));
+                reserve(count);
+                for (; first != last; ++first)
+                {
+                    new (data_ + size_) T(*first);
+                    ++size_;
+                }
+            }
+
+            void reserve(size_t capacity)
+            {
+                if (capacity > capacity_)
+                {
+                    grow(capacity);
+                }
+            }
+
+            void push_back(const T &value) { emplace_back(value); }
+            void push_back(T &&value) { emplace_back(std::move(value)); }
+
+            template <typename... Args>
+            T &emplace_back(Args &&...args)
+            {
+                if (size_ == capacity_)
+                {
+                    grow(size_ + 1);
+                }
+                T *element = new (data_ + size_) T(std::forward<Args>(args)...);
+                ++size_;
+                return *element;
+            }
+
+            void pop_back()
+            {
+                data_[--size_].~T();
+            }
+
+            void resize(size_t count)
+            {
+                while (size_ > count)
+                {
+                    pop_back();
+                }
+                reserve(count);
+                while (size_ < count)
+                {
+                    emplace_back();
+                }
+            }
+
+            void resize(size_t count, const T &value)
+            {
+                while (size_ > count)
+                {
+                    pop_back();
+                }
+                reserve(count);
+                while (size_ < count)
+                {
+                    emplace_back(value);
+                }
+            }
+
+            void clear() { destroy_elements(); }
+
+            size_t size() const { return size_; }
+            bool empty() const { return size_ == 0; }
+            size_t capacity() const { return capacity_; }
+            static constexpr size_t inline_capacity() { return N; }
+
+            T *data() { return data_; }
+            const T *data() const { return data_; }
+            T &operator[](size_t index) { return data_[index]; }
+            const T &operator[](size_t index) const { return data_[index]; }
+            T &front() { return data_[0]; }
+            const T &front() const { return data_[0]; }
+            T &back() { return data_[size_ - 1]; }
+            const T &back() const { return data_[size_ - 1]; }
+
+            iterator begin() { return data_; }
+            iterator end() { return data_ + size_; }
+            const_iterator begin() const { return data_; }
+            const_iterator end() const { return data_ + size_; }
+        };
+
+    } // namespace memory
+} // namespace spe
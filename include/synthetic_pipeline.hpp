@@ -0,0 +1,399 @@
+#pragma once
+
+#include "market_data.hpp"
+#include "small_vector.hpp"
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace spe
+{
+    namespace pricing
+    {
+
+        using namespace market_data;
+
+        // Top of book of a pipeline's legs, read straight from the snapshot columns
+        template <size_t N>
+        struct LegQuotes
+        {
+            std::array<Price, N> bids;
+            std::array<Price, N> asks;
+        };
+
+        struct SyntheticQuote
+        {
+            Price bid = 0.0;
+            Price ask = 0.0;
+            Price theoretical = 0.0;
+        };
+
+        // Kernels carry one model's pricing math for a fixed leg count. price() is a static,
+        // allocation-free function of the legs' quotes and a per-pipeline config, so a pipeline
+        // inlines it; anything expensive (exp, lookups) is folded into the config when it is built.
+
+        // Cross rate from two legs (EUR/JPY from EUR/USD and USD/JPY). An inverted leg is quoted
+        // the other way round (USD/EUR), so its reciprocal enters with bid and ask swapped.
+        struct CrossCurrencyKernel
+        {
+            static constexpr size_t LEGS = 2;
+
+            struct Config
+            {
+                std::array<bool, LEGS> inverted{{false, false}};
+                double spread_adjustment = 0.0; // widens both sides, as a fraction of price
+            };
+
+            static bool price(const LegQuotes<LEGS> &legs, const Config &config, SyntheticQuote &out)
+            {
+                double bid = 1.0;
+                double ask = 1.0;
+                for (size_t k = 0; k < LEGS; ++k)
+                {
+                    if (legs.bids[k] <= 0.0 || legs.asks[k] <= 0.0)
+                    {
+                        return false;
+                    }
+                    bid *= config.inverted[k] ? 1.0 / legs.asks[k] : legs.bids[k];
+                    ask *= config.inverted[k] ? 1.0 / legs.bids[k] : legs.asks[k];
+                }
+                out.theoretical = (bid + ask) / 2.0;
+                out.bid = bid * (1.0 - config.spread_adjustment);
+                out.ask = ask * (1.0 + config.spread_adjustment);
+                return true;
+            }
+        };
+
+        // Weighted sum of N legs; a short leg (negative weight) sells at the bid when the basket
+        // is bought
+        template <size_t N>
+        struct BasketKernel
+        {
+            static constexpr size_t LEGS = N;
+
+            struct Config
+            {
+                std::array<double, N> weights{};
+            };
+
+            static bool price(const LegQuotes<LEGS> &legs, const Config &config, SyntheticQuote &out)
+            {
+                double bid = 0.0;
+                double ask = 0.0;
+                for (size_t k = 0; k < LEGS; ++k)
+                {
+                    if (legs.bids[k] <= 0.0)
+                    {
+                        return false;
+                    }
+                    double weight = config.weights[k];
+                    bid += weight * (weight >= 0.0 ? legs.bids[k] : legs.asks[k]);
+                    ask += weight * (weight >= 0.0 ? legs.asks[k] : legs.bids[k]);
+                }
+                out.bid = bid;
+                out.ask = ask;
+                out.theoretical = (bid + ask) / 2.0; // spreads may price at or below zero
+                return true;
+            }
+        };
+
+        // Perpetual fair value from spot: mid * (1 + funding rate), as PerpetualSwapPricingModel
+        struct PerpetualSwapKernel
+        {
+            static constexpr size_t LEGS = 1;
+
+            struct Config
+            {
+                double funding_rate = 0.0;
+            };
+
+            static bool price(const LegQuotes<LEGS> &legs, const Config &config, SyntheticQuote &out)
+            {
+                double factor = 1.0 + config.funding_rate;
+                out.bid = legs.bids[0] * factor;
+                out.ask = legs.asks[0] * factor;
+                out.theoretical = (out.bid + out.ask) / 2.0;
+                return legs.bids[0] > 0.0;
+            }
+        };
+
+        // Futures fair value from spot under cost of carry: mid * exp(carry * T). The growth
+        // factor is computed once, when the pipeline is built.
+        struct FuturesKernel
+        {
+            static constexpr size_t LEGS = 1;
+
+            struct Config
+            {
+                double growth = 1.0; // exp(cost_of_carry * time_to_maturity)
+            };
+
+            static Config carry(double cost_of_carry, double time_to_maturity)
+            {
+                return Config{std::exp(cost_of_carry * time_to_maturity)};
+            }
+
+            static bool price(const LegQuotes<LEGS> &legs, const Config &config, SyntheticQuote &out)
+            {
+                out.bid = legs.bids[0] * config.growth;
+                out.ask = legs.asks[0] * config.growth;
+                out.theoretical = (out.bid + out.ask) / 2.0;
+                return legs.bids[0] > 0.0;
+            }
+        };
+
+        // One synthetic, with its model and leg count fixed at compile time and its leg handles
+        // resolved when it is built. evaluate() neither allocates nor dispatches virtually.
+        template <typename Kernel>
+        class SyntheticPipeline
+        {
+        public:
+            static constexpr size_t LEGS = Kernel::LEGS;
+            using Config = typename Kernel::Config;
+
+        private:
+            InstrumentHandle target_;
+            std::array<InstrumentHandle, LEGS> legs_;
+            Config config_;
+
+        public:
+            SyntheticPipeline(InstrumentHandle target, const std::array<InstrumentHandle, LEGS> &legs, const Config &config)
+                : target_(target), legs_(legs), config_(config) {}
+
+            InstrumentHandle target() const { return target_; }
+            const std::array<InstrumentHandle, LEGS> &legs() const { return legs_; }
+            const Config &config() const { return config_; }
+            void set_config(const Config &config) { config_ = config; }
+
+            // False while a leg is unquoted or the legs do not price
+            bool evaluate(const MarketSnapshot &snapshot, SyntheticQuote &out) const
+            {
+                LegQuotes<LEGS> quotes;
+                for (size_t k = 0; k < LEGS; ++k)
+                {
+                    if (!snapshot.has_quote(legs_[k]))
+                    {
+                        return false;
+                    }
+                    quotes.bids[k] = snapshot.bid_price(legs_[k]);
+                    quotes.asks[k] = snapshot.ask_price(legs_[k]);
+                }
+                return Kernel::price(quotes, config_, out);
+            }
+        };
+
+        // Builders for the production strategy shapes
+        inline SyntheticPipeline<CrossCurrencyKernel> make_cross_currency_pipeline(
+            InstrumentHandle target, InstrumentHandle base_leg, InstrumentHandle quote_leg,
+            bool invert_base = false, bool invert_quote = false, double spread_adjustment = 0.0)
+        {
+            return SyntheticPipeline<CrossCurrencyKernel>(
+                target, {{base_leg, quote_leg}}, CrossCurrencyKernel::Config{{{invert_base, invert_quote}}, spread_adjustment});
+        }
+
+        template <size_t N>
+        SyntheticPipeline<BasketKernel<N>> make_basket_pipeline(InstrumentHandle target,
+                                                                const std::array<InstrumentHandle, N> &legs,
+                                                                const std::array<double, N> &weights)
+        {
+            return SyntheticPipeline<BasketKernel<N>>(target, legs, typename BasketKernel<N>::Config{weights});
+        }
+
+        inline SyntheticPipeline<PerpetualSwapKernel> make_perpetual_pipeline(InstrumentHandle perpetual, InstrumentHandle spot,
+                                                                              double funding_rate)
+        {
+            return SyntheticPipeline<PerpetualSwapKernel>(perpetual, {{spot}}, PerpetualSwapKernel::Config{funding_rate});
+        }
+
+        inline SyntheticPipeline<FuturesKernel> make_futures_pipeline(InstrumentHandle future, InstrumentHandle spot,
+                                                                      double cost_of_carry, double time_to_maturity)
+        {
+            return SyntheticPipeline<FuturesKernel>(future, {{spot}}, FuturesKernel::carry(cost_of_carry, time_to_maturity));
+        }
+
+        // A pipeline in a set: its kernel's position in the set's parameter list, and its index
+        // among that kernel's pipelines
+        struct PipelineRef
+        {
+            uint32_t kind = std::numeric_limits<uint32_t>::max();
+            uint32_t index = 0;
+
+            bool valid() const { return kind != std::numeric_limits<uint32_t>::max(); }
+        };
+
+        // A fixed set of strategy shapes. Each kernel's pipelines sit in their own vector, so a
+        // full pass is one monomorphic, inlined loop per kernel, and a dirty pass reaches only
+        // the pipelines with a leg that moved. Visitors are generic: visitor(pipeline, quote)
+        // sees the concrete SyntheticPipeline type.
+        template <typename... Kernels>
+        class SyntheticPipelineSet
+        {
+        public:
+            static constexpr size_t KINDS = sizeof...(Kernels);
+
+        private:
+            std::tuple<std::vector<SyntheticPipeline<Kernels>>...> pipelines_;
+            std::vector<PipelineRef> by_target_;                         // dense by handle
+            std::vector<memory::SmallVector<PipelineRef, 2>> dependents_; // by leg handle
+            std::array<std::vector<uint64_t>, KINDS> marks_;             // last dirty pass per pipeline
+            uint64_t pass_ = 0;
+
+            template <typename Kernel, size_t K = 0>
+            static constexpr size_t kind_of()
+            {
+                static_assert(K < KINDS, "kernel is not part of this set");
+                if constexpr (std::is_same_v<Kernel, std::tuple_element_t<K, std::tuple<Kernels...>>>)
+                {
+                    return K;
+                }
+                else
+                {
+                    return kind_of<Kernel, K + 1>();
+                }
+            }
+
+            template <size_t K = 0, typename Function>
+            void with_kind(uint32_t kind, Function &&function) const
+            {
+                if constexpr (K < KINDS)
+                {
+                    if (kind == K)
+                    {
+                        function(std::get<K>(pipelines_));
+                    }
+                    else
+                    {
+                        with_kind<K + 1>(kind, function);
+                    }
+                }
+            }
+
+        public:
+            template <typename Kernel>
+            PipelineRef add(const SyntheticPipeline<Kernel> &pipeline)
+            {
+                constexpr size_t kind = kind_of<Kernel>();
+                auto &pipelines = std::get<kind>(pipelines_);
+                PipelineRef ref{static_cast<uint32_t>(kind), static_cast<uint32_t>(pipelines.size())};
+                pipelines.push_back(pipeline);
+                marks_[kind].push_back(0);
+
+                if (by_target_.size() <= pipeline.target())
+                {
+                    by_target_.resize(pipeline.target() + 1);
+                }
+                by_target_[pipeline.target()] = ref;
+                for (InstrumentHandle leg : pipeline.legs())
+                {
+                    if (dependents_.size() <= leg)
+                    {
+                        dependents_.resize(leg + 1);
+                    }
+                    dependents_[leg].push_back(ref);
+                }
+                return ref;
+            }
+
+            // The last pipeline added for the target
+            PipelineRef find(InstrumentHandle target) const
+            {
+                return target < by_target_.size() ? by_target_[target] : PipelineRef{};
+            }
+
+            template <typename Kernel>
+            std::vector<SyntheticPipeline<Kernel>> &pipelines() { return std::get<kind_of<Kernel>()>(pipelines_); }
+            template <typename Kernel>
+            const std::vector<SyntheticPipeline<Kernel>> &pipelines() const { return std::get<kind_of<Kernel>()>(pipelines_); }
+
+            size_t size() const
+            {
+                return std::apply([](const auto &...pipelines) { return (size_t(0) + ... + pipelines.size()); }, pipelines_);
+            }
+
+            // True (and visitor called) if the pipeline priced
+            template <typename Visitor>
+            bool evaluate(PipelineRef ref, const MarketSnapshot &snapshot, Visitor &&visitor) const
+            {
+                bool priced = false;
+                with_kind(ref.kind, [&](const auto &pipelines)
+                          {
+                              SyntheticQuote quote;
+                              if (pipelines[ref.index].evaluate(snapshot, quote))
+                              {
+                                  visitor(pipelines[ref.index], quote);
+                                  priced = true;
+                              } });
+                return priced;
+            }
+
+            // Every pipeline; returns how many priced
+            template <typename Visitor>
+            size_t evaluate_all(const MarketSnapshot &snapshot, Visitor &&visitor) const
+            {
+                size_t priced = 0;
+                auto run = [&](const auto &pipelines)
+                {
+                    SyntheticQuote quote;
+                    for (const auto &pipeline : pipelines)
+                    {
+                        if (pipeline.evaluate(snapshot, quote))
+                        {
+                            visitor(pipeline, quote);
+                            ++priced;
+                        }
+                    }
+                };
+                std::apply([&](const auto &...pipelines) { (run(pipelines), ...); }, pipelines_);
+                return priced;
+            }
+
+            // Each pipeline with a leg in the snapshot's dirty list, once; returns how many priced
+            template <typename Visitor>
+            size_t evaluate_dirty(const MarketSnapshot &snapshot, Visitor &&visitor)
+            {
+                size_t priced = 0;
+                ++pass_;
+                for (InstrumentHandle instrument : snapshot.dirty_instruments())
+                {
+                    if (instrument >= dependents_.size())
+                    {
+                        continue;
+                    }
+                    for (PipelineRef ref : dependents_[instrument])
+                    {
+                        uint64_t &mark = marks_[ref.kind][ref.index];
+                        if (mark != pass_)
+                        {
+                            mark = pass_;
+                            priced += evaluate(ref, snapshot, visitor) ? 1 : 0;
+                        }
+                    }
+                }
+                return priced;
+            }
+
+            void clear()
+            {
+                std::apply([](auto &...pipelines) { (pipelines.clear(), ...); }, pipelines_);
+                by_target_.clear();
+                dependents_.clear();
+                for (auto &marks : marks_)
+                {
+                    marks.clear();
+                }
+            }
+        };
+
+        // Strategy shapes the production detectors run
+        using CrossCurrencyPipeline = SyntheticPipeline<CrossCurrencyKernel>;
+        template <size_t N>
+        using BasketPipeline = SyntheticPipeline<BasketKernel<N>>;
+        using PerpetualSwapPipeline = SyntheticPipeline<PerpetualSwapKernel>;
+        using FuturesPipeline = SyntheticPipeline<FuturesKernel>;
+
+    } // namespace pricing
+} // namespace spe
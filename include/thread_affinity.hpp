@@ -0,0 +1,56 @@
+#pragma once
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <vector>
+
+namespace spe
+{
+    namespace concurrency
+    {
+
+        // Pins the calling thread to one CPU; false when cpu < 0 or the platform has no affinity API
+        inline bool pin_current_thread(int cpu)
+        {
+            if (cpu < 0)
+            {
+                return false;
+            }
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+            return false;
+#endif
+        }
+
+        // Pins the calling thread to a set of CPUs, letting the scheduler move it only among
+        // them; negative entries are ignored, and an empty set leaves the thread as it was
+        inline bool pin_current_thread(const std::vector<int> &cpus)
+        {
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            bool any = false;
+            for (int cpu : cpus)
+            {
+                if (cpu >= 0 && cpu < CPU_SETSIZE)
+                {
+                    CPU_SET(cpu, &set);
+                    any = true;
+                }
+            }
+            return any && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+            (void)cpus;
+            return false;
+#endif
+        }
+
+    } // namespace concurrency
+} // namespace spe
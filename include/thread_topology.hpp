@@ -0,0 +1,172 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace spe
+{
+    namespace concurrency
+    {
+
+        struct NumaNode
+        {
+            int id = 0;
+            std::vector<int> cpus;
+        };
+
+        // The machine's CPUs grouped by NUMA node, read once from sysfs. Without NUMA
+        // information (another platform, or a kernel without it) every online CPU is on node 0.
+        class CpuTopology
+        {
+        private:
+            std::vector<NumaNode> nodes_;
+            std::vector<int> cpu_nodes_; // node id by CPU, -1 for CPUs that are not online
+
+        public:
+            CpuTopology() = default;
+            explicit CpuTopology(std::vector<NumaNode> nodes);
+
+            static CpuTopology detect();
+            static const CpuTopology &system(); // detect(), cached
+
+            const std::vector<NumaNode> &nodes() const { return nodes_; }
+            const NumaNode *node(int id) const;
+            int node_of(int cpu) const
+            {
+                return cpu >= 0 && static_cast<size_t>(cpu) < cpu_nodes_.size() ? cpu_nodes_[cpu] : -1;
+            }
+            bool has_cpu(int cpu) const { return node_of(cpu) >= 0; }
+            size_t cpu_count() const;
+        };
+
+        // Parses the kernel's CPU list syntax ("0-3,8,10-11"); false on anything else
+        bool parse_cpu_list(const std::string &text, std::vector<int> &cpus);
+
+        enum class WaitPolicy
+        {
+            BUSY_POLL,       // spin on the input; lowest wake-up latency, burns the core
+            SPIN_THEN_SLEEP, // spin for spin_iterations, then sleep idle_sleep at a time
+            SLEEP            // sleep idle_sleep whenever there is nothing to do
+        };
+
+        const char *wait_policy_name(WaitPolicy policy);
+
+        // Where one stage's thread runs and how it waits when idle. cpus empty and numa_node
+        // set spreads the stage over that node's CPUs; both unset leaves it floating.
+        struct StagePlacement
+        {
+            std::vector<int> cpus;
+            int numa_node = -1;
+            WaitPolicy wait = WaitPolicy::SLEEP;
+            std::chrono::microseconds idle_sleep = std::chrono::microseconds(50);
+            uint32_t spin_iterations = 2000;
+
+            bool floating() const { return cpus.empty() && numa_node < 0; }
+        };
+
+        // Applies placement to the calling thread: pins it to the stage's CPUs and makes the
+        // stage's node the preferred node for memory it allocates from then on. The kernel
+        // places a page on first touch, so state the stage builds (or first writes) after this
+        // call lands on its local node. The node is numa_node, or the node all of cpus are on.
+        // False when any part could not be applied; the thread keeps running unpinned or with
+        // the default memory policy.
+        bool apply_placement(const StagePlacement &placement, const CpuTopology &topology = CpuTopology::system());
+
+        // The calling thread's preferred memory node; -1 returns it to the default policy
+        bool prefer_memory_node(int node);
+
+        inline void cpu_relax()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#elif defined(__aarch64__)
+            asm volatile("yield");
+#endif
+        }
+
+        // A stage's idle branch under its WaitPolicy. Call idle() for each empty poll and
+        // reset() after doing work.
+        class IdleStrategy
+        {
+        private:
+            WaitPolicy policy_;
+            std::chrono::microseconds sleep_;
+            uint32_t spin_limit_;
+            uint32_t spins_;
+
+        public:
+            explicit IdleStrategy(const StagePlacement &placement)
+                : policy_(placement.wait), sleep_(placement.idle_sleep), spin_limit_(placement.spin_iterations), spins_(0) {}
+
+            void idle()
+            {
+                if (policy_ == WaitPolicy::BUSY_POLL ||
+                    (policy_ == WaitPolicy::SPIN_THEN_SLEEP && spins_ < spin_limit_))
+                {
+                    ++spins_;
+                    cpu_relax();
+                    return;
+                }
+                std::this_thread::sleep_for(sleep_);
+            }
+
+            void reset() { spins_ = 0; }
+        };
+
+        // Placement of every engine stage, by name:
+        //
+        //   io               socket I/O (EventLoop::run) and journal replay
+        //   parse            feed-side parsing and publishing, on the caller's feed threads
+        //   detector         the pipeline's detector stage
+        //   detector.shards  pool workers a composite detector fans its shards out over
+        //   arbitrage        the pipeline's arbitrage stage
+        //   risk             exposure VaR refresh (SyntheticExposureManager::start_risk_stage)
+        //
+        // Stages without an entry float. From text, entries are separated by ';', each a
+        // stage name and space-separated key=value settings:
+        //
+        //   "io cpus=0 wait=busy; detector cpus=2 wait=busy; detector.shards node=1;
+        //    arbitrage cpus=3 wait=spin spin=5000; risk node=1 wait=sleep sleep_us=200"
+        //
+        // cpus takes the kernel's list syntax; wait is busy, spin or sleep.
+        class ThreadTopology
+        {
+        private:
+            std::map<std::string, StagePlacement> stages_;
+
+        public:
+            static constexpr const char *IO = "io";
+            static constexpr const char *PARSE = "parse";
+            static constexpr const char *DETECTOR = "detector";
+            static constexpr const char *DETECTOR_SHARDS = "detector.shards";
+            static constexpr const char *ARBITRAGE = "arbitrage";
+            static constexpr const char *RISK = "risk";
+
+            static bool is_stage(const std::string &stage);
+
+            void set(const std::string &stage, StagePlacement placement) { stages_[stage] = std::move(placement); }
+            bool has(const std::string &stage) const { return stages_.count(stage) != 0; }
+            StagePlacement placement(const std::string &stage) const; // floating when unset
+            const std::map<std::string, StagePlacement> &stages() const { return stages_; }
+
+            // False with error set on malformed text or unknown stages; out is untouched then
+            static bool parse(const std::string &text, ThreadTopology &out, std::string &error);
+
+            // Checks every CPU and node exists on topology, and that no two busy-polling stages
+            // are pinned to the same CPU, where they would starve each other
+            bool validate(const CpuTopology &topology, std::string &error) const;
+
+            // One placement per worker for a pool of count threads on stage: worker i gets the
+            // i-th of the stage's CPUs (or its node's), wrapping, and the stage's wait settings
+            std::vector<StagePlacement> worker_placements(const std::string &stage, size_t count,
+                                                          const CpuTopology &topology = CpuTopology::system()) const;
+
+            std::string describe() const;
+        };
+
+    } // namespace concurrency
+} // namespace spe
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "bit_ops.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace spe
+{
+    namespace timing
+    {
+
+        using TimerId = uint32_t;
+        constexpr TimerId INVALID_TIMER = std::numeric_limits<uint32_t>::max();
+
+        // Hierarchical timing wheel over integer ticks (Varghese & Lauck). Level L has 64 slots
+        // of 64^L ticks; a timer sits at the lowest level whose slot span covers the distance
+        // from now to its deadline and moves down as that slot comes due, so scheduling and
+        // cancelling are O(1) and advance() costs O(expired + cascaded) plus one step per 64
+        // ticks travelled. Timers beyond the top level wait in an overflow list that is
+        // re-examined each time the top level wraps. Timer nodes are pooled and slots are
+        // intrusive lists, so a warmed-up wheel does not allocate.
+        template <typename T, size_t Levels = 4>
+        class TimingWheel
+        {
+        public:
+            static constexpr unsigned SLOT_BITS = 6;
+            static constexpr size_t SLOTS = size_t(1) << SLOT_BITS;
+
+        private:
+            static_assert(Levels >= 1 && Levels * SLOT_BITS < 64, "wheel span must fit in a tick");
+            static constexpr uint32_t NIL = INVALID_TIMER;
+            static constexpr uint32_t OVERDUE = Levels * SLOTS; // list of timers already due
+            static constexpr uint32_t OVERFLOW_LIST = OVERDUE + 1;
+            static constexpr uint32_t FREE = OVERFLOW_LIST + 1;
+
+            struct Node
+            {
+                uint64_t deadline;
+                T value;
+                uint32_t prev;
+                uint32_t next;
+                uint32_t list; // slot, OVERDUE, OVERFLOW_LIST or FREE
+            };
+
+            std::vector<Node> nodes_;
+            std::vector<uint32_t> free_;
+            std::array<uint32_t, Levels * SLOTS + 2> heads_;
+            std::array<uint64_t, Levels> occupied_; // per level, one bit per non-empty slot
+            uint64_t now_;
+            size_t size_;
+
+            void link(uint32_t id, uint32_t list)
+            {
+                Node &node = nodes_[id];
+                node.list = list;
+                node.prev = NIL;
+                node.next = heads_[list];
+                if (node.next != NIL)
+                {
+                    nodes_[node.next].prev = id;
+                }
+                heads_[list] = id;
+                if (list < OVERDUE)
+                {
+                    occupied_[list / SLOTS] |= uint64_t(1) << (list % SLOTS);
+                }
+            }
+
+            void unlink(uint32_t id)
+            {
+                Node &node = nodes_[id];
+                if (node.prev != NIL)
+                {
+                    nodes_[node.prev].next = node.next;
+                }
+                else
+                {
+                    heads_[node.list] = node.next;
+                    if (node.next == NIL && node.list < OVERDUE)
+                    {
+                        occupied_[node.list / SLOTS] &= ~(uint64_t(1) << (node.list % SLOTS));
+                    }
+                }
+                if (node.next != NIL)
+                {
+                    nodes_[node.next].prev = node.prev;
+                }
+            }
+
+            // Slot for a deadline relative to now_: the level is set by the highest bit in
+            // which the two differ
+            void place(uint32_t id)
+            {
+                uint64_t deadline = nodes_[id].deadline;
+                if (deadline <= now_)
+                {
+                    link(id, OVERDUE);
+                    return;
+                }
+                uint64_t diff = deadline ^ now_;
+                unsigned level = 0;
+                while (level + 1 < Levels && (diff >> ((level + 1) * SLOT_BITS)) != 0)
+                {
+                    ++level;
+                }
+                if ((diff >> (Levels * SLOT_BITS)) != 0)
+                {
+                    link(id, OVERFLOW_LIST);
+                    return;
+                }
+                link(id, uint32_t(level * SLOTS + ((deadline >> (level * SLOT_BITS)) & (SLOTS - 1))));
+            }
+
+            // Re-places every timer of a list against the current tick
+            void cascade(uint32_t list)
+            {
+                uint32_t id = heads_[list];
+                heads_[list] = NIL;
+                if (list < OVERDUE)
+                {
+                    occupied_[list / SLOTS] &= ~(uint64_t(1) << (list % SLOTS));
+                }
+                while (id != NIL)
+                {
+                    uint32_t next = nodes_[id].next;
+                    place(id);
+                    id = next;
+                }
+            }
+
+            template <typename Callback>
+            size_t fire(uint32_t list, Callback &callback)
+            {
+                size_t fired = 0;
+                while (heads_[list] != NIL)
+                {
+                    uint32_t id = heads_[list];
+                    unlink(id);
+                    nodes_[id].list = FREE;
+                    free_.push_back(id);
+                    --size_;
+                    ++fired;
+                    T value = nodes_[id].value; // the callback may schedule, growing nodes_
+                    callback(value);
+                }
+                return fired;
+            }
+
+        public:
+            explicit TimingWheel(uint64_t start_tick = 0) : now_(start_tick), size_(0)
+            {
+                heads_.fill(NIL);
+                occupied_.fill(0);
+            }
+
+            // A deadline at or before now() fires on the next advance()
+            TimerId schedule(uint64_t deadline, const T &value)
+            {
+                uint32_t id;
+                if (free_.empty())
+                {
+                    id = static_cast<uint32_t>(nodes_.size());
+                    nodes_.push_back(Node{});
+                }
+                else
+                {
+                    id = free_.back();
+                    free_.pop_back();
+                }
+                nodes_[id].deadline = deadline;
+                nodes_[id].value = value;
+                place(id);
+                ++size_;
+                return id;
+            }
+
+            // False if the timer already fired or was cancelled
+            bool cancel(TimerId timer)
+            {
+                if (timer >= nodes_.size() || nodes_[timer].list == FREE)
+                {
+                    return false;
+                }
+                unlink(timer);
+                nodes_[timer].list = FREE;
+                free_.push_back(timer);
+                --size_;
+                return true;
+            }
+
+            // Fires callback(T&) for every timer due at or before tick, in tick order
+            // (unordered within a tick); returns how many fired
+            template <typename Callback>
+            size_t advance(uint64_t tick, Callback &&callback)
+            {
+                size_t fired = fire(OVERDUE, callback);
+                while (now_ < tick)
+                {
+                    if (size_ == 0)
+                    {
+                        now_ = tick;
+                        break;
+                    }
+
+                    uint64_t next = now_ + 1;
+                    if ((next & (SLOTS - 1)) != 0)
+                    {
+                        // Jump to the next occupied slot of this block, or to its end
+                        uint64_t pending = occupied_[0] & (~uint64_t(0) << (next & (SLOTS - 1)));
+                        uint64_t block_end = next | (SLOTS - 1);
+                        if (pending == 0)
+                        {
+                            now_ = block_end < tick ? block_end : tick;
+                            continue;
+                        }
+                        uint64_t due = (next & ~uint64_t(SLOTS - 1)) + bits::lowest_bit(pending);
+                        if (due > tick)
+                        {
+                            now_ = tick;
+                            break;
+                        }
+                        now_ = due;
+                    }
+                    else
+                    {
+                        // Block boundary: bring down the higher-level slots that start here
+                        now_ = next;
+                        size_t level = 1;
+                        while (level < Levels && (now_ & ((uint64_t(1) << (level * SLOT_BITS)) - 1)) == 0)
+                        {
+                            ++level;
+                        }
+                        if ((now_ & ((uint64_t(1) << (Levels * SLOT_BITS)) - 1)) == 0)
+                        {
+                            cascade(OVERFLOW_LIST); // the top level wrapped
+                        }
+                        for (size_t l = level - 1; l >= 1; --l)
+                        {
+                            cascade(uint32_t(l * SLOTS + ((now_ >> (l * SLOT_BITS)) & (SLOTS - 1))));
+                        }
+                    }
+                    fired += fire(uint32_t(now_ & (SLOTS - 1)), callback);
+                    fired += fire(OVERDUE, callback); // scheduled by callbacks for this tick
+                }
+                return fired;
+            }
+
+            void clear()
+            {
+                nodes_.clear();
+                free_.clear();
+                heads_.fill(NIL);
+                occupied_.fill(0);
+                size_ = 0;
+            }
+
+            uint64_t now() const { return now_; }
+            size_t size() const { return size_; }
+        };
+
+    } // namespace timing
+} // namespace spe
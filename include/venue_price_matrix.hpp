@@ -0,0 +1,192 @@
+#pragma once
+
+#include "market_data.hpp"
+#include "pricing_models.hpp"
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace spe
+{
+    namespace pricing
+    {
+
+        using VenueIndex = uint32_t;
+        constexpr VenueIndex INVALID_VENUE = std::numeric_limits<uint32_t>::max();
+
+        enum class VenuePriceSource
+        {
+            QUOTES,   // each venue's own quote for the instrument
+            SYNTHETIC // each venue's replication of the instrument from its components
+        };
+
+        // Best prices for one instrument across venues, after each venue's fee and latency cost
+        struct VenueBest
+        {
+            VenueIndex bid_venue = INVALID_VENUE;
+            VenueIndex ask_venue = INVALID_VENUE;
+            Price bid = 0.0; // what selling nets per unit
+            Price ask = 0.0; // what buying costs per unit
+        };
+
+        // Result of a batch scan, by instrument handle; venues are doubles with -1 for none
+        struct VenueScan
+        {
+            std::vector<double> best_bids;
+            std::vector<double> best_bid_venues;
+            std::vector<double> best_asks; // +inf when none
+            std::vector<double> best_ask_venues;
+
+            size_t size() const { return best_bids.size(); }
+            VenueBest at(InstrumentHandle instrument) const;
+        };
+
+        // Venue x instrument quotes in venue-major columns, updated in place from each venue's
+        // snapshots, with a per-cell change stamp that only moves when a price does. Synthetic
+        // targets are registered with their components; a venue's synthetic price for a target
+        // is cached and marked stale only when one of its component quotes on that venue moves,
+        // so refresh_synthetics() reprices what changed and nothing else.
+        //
+        // Best-venue selection folds each venue's transaction cost and latency (latency_ms x
+        // latency_cost_per_ms, as a fraction of price) into per-venue factors, and scan() runs
+        // it for every instrument at once through the per-ISA SIMD kernels. Not thread-safe;
+        // engines that share a matrix must run on the same thread.
+        class VenuePriceMatrix
+        {
+        public:
+            static constexpr size_t LANE_BLOCK = 8; // instrument stride granularity, the widest register
+            static constexpr double DEFAULT_LATENCY_COST_PER_MS = 1e-6;
+
+            // price(venue, target, components) for a stale synthetic cell
+            using SyntheticPriceFunction = std::function<SyntheticPrice(
+                VenueIndex, InstrumentHandle, const std::vector<InstrumentHandle> &)>;
+
+        private:
+            struct Venue
+            {
+                std::string id;
+                double transaction_cost;
+                double latency_ms;
+                MarketSnapshot snapshot;
+            };
+
+            std::vector<Venue> venues_;
+            std::unordered_map<std::string, VenueIndex> venue_by_id_;
+            double latency_cost_per_ms_;
+            std::vector<double> bid_factors_; // per venue
+            std::vector<double> ask_factors_; // per venue
+
+            // Cells, venues x stride_, venue-major
+            size_t stride_;
+            std::vector<Price> bids_;
+            std::vector<Price> asks_;
+            std::vector<Volume> bid_sizes_;
+            std::vector<Volume> ask_sizes_;
+            std::vector<uint64_t> quote_versions_;
+
+            // Synthetic targets, dense by handle
+            std::vector<std::vector<InstrumentHandle>> components_; // empty: not a target
+            std::vector<std::vector<InstrumentHandle>> dependents_; // targets that use the instrument
+            std::vector<InstrumentHandle> targets_;
+
+            // Synthetic cells, same layout as the quotes
+            std::vector<Price> synthetic_bids_;
+            std::vector<Price> synthetic_asks_;
+            std::vector<SyntheticPrice> synthetic_prices_;
+            std::vector<uint64_t> synthetic_versions_;
+            std::vector<uint8_t> stale_;
+            std::vector<std::pair<VenueIndex, InstrumentHandle>> stale_cells_;
+
+            VenueScan quote_scan_;
+            VenueScan synthetic_scan_;
+
+            size_t cell(VenueIndex venue, InstrumentHandle instrument) const { return venue * stride_ + instrument; }
+            void ensure_capacity(InstrumentHandle instrument);
+            void update_factors(VenueIndex venue);
+            void mark_stale(VenueIndex venue, InstrumentHandle target);
+
+        public:
+            explicit VenuePriceMatrix(double latency_cost_per_ms = DEFAULT_LATENCY_COST_PER_MS);
+
+            // Registers a venue, or updates its costs if it is known
+            VenueIndex add_venue(const std::string &venue_id, double transaction_cost, double latency_ms);
+            VenueIndex venue_index(const std::string &venue_id) const;
+            const std::string &venue_id(VenueIndex venue) const { return venues_[venue].id; }
+            size_t venue_count() const { return venues_.size(); }
+            double transaction_cost(VenueIndex venue) const { return venues_[venue].transaction_cost; }
+            double latency_ms(VenueIndex venue) const { return venues_[venue].latency_ms; }
+            const MarketSnapshot &snapshot(VenueIndex venue) const { return venues_[venue].snapshot; }
+            void set_latency_cost_per_ms(double cost);
+            double latency_cost_per_ms() const { return latency_cost_per_ms_; }
+
+            // Fraction of price lost to trading on the venue: fee plus latency cost
+            double venue_cost(VenueIndex venue) const { return ask_factors_[venue] - 1.0; }
+            Price effective_bid(VenueIndex venue, Price bid) const { return bid * bid_factors_[venue]; }
+            Price effective_ask(VenueIndex venue, Price ask) const { return ask * ask_factors_[venue]; }
+
+            // Components on the same venue replicate the target there; empty removes it
+            void set_components(InstrumentHandle target, const std::vector<InstrumentHandle> &components);
+            const std::vector<InstrumentHandle> &components(InstrumentHandle target) const;
+            bool is_target(InstrumentHandle target) const
+            {
+                return target < components_.size() && !components_[target].empty();
+            }
+            const std::vector<InstrumentHandle> &targets() const { return targets_; }
+
+            // True if the quoted prices changed. Sizes are refreshed either way.
+            bool apply_quote(VenueIndex venue, const Quote &quote);
+            // Applies the snapshot's dirty instruments, or every quoted one when full (or when
+            // the venue's snapshots now come from a different store); returns how many moved
+            size_t apply_snapshot(VenueIndex venue, const MarketSnapshot &snapshot, bool full = false);
+
+            // Reprices the stale synthetic cells; returns how many
+            size_t refresh_synthetics(const SyntheticPriceFunction &price);
+            size_t stale_count() const { return stale_cells_.size(); }
+
+            bool has_quote(VenueIndex venue, InstrumentHandle instrument) const
+            {
+                return instrument < stride_ && bids_[cell(venue, instrument)] > 0.0 && asks_[cell(venue, instrument)] > 0.0;
+            }
+            Price bid(VenueIndex venue, InstrumentHandle instrument) const { return bids_[cell(venue, instrument)]; }
+            Price ask(VenueIndex venue, InstrumentHandle instrument) const { return asks_[cell(venue, instrument)]; }
+            Volume bid_size(VenueIndex venue, InstrumentHandle instrument) const { return bid_sizes_[cell(venue, instrument)]; }
+            Volume ask_size(VenueIndex venue, InstrumentHandle instrument) const { return ask_sizes_[cell(venue, instrument)]; }
+            uint64_t quote_version(VenueIndex venue, InstrumentHandle instrument) const
+            {
+                return instrument < stride_ ? quote_versions_[cell(venue, instrument)] : 0;
+            }
+
+            // As of the last refresh; zero prices when the venue cannot replicate the target
+            const SyntheticPrice &synthetic(VenueIndex venue, InstrumentHandle target) const;
+            bool has_synthetic(VenueIndex venue, InstrumentHandle target) const
+            {
+                return target < stride_ && synthetic_bids_[cell(venue, target)] > 0.0 && synthetic_asks_[cell(venue, target)] > 0.0;
+            }
+            uint64_t synthetic_version(VenueIndex venue, InstrumentHandle target) const
+            {
+                return target < stride_ ? synthetic_versions_[cell(venue, target)] : 0;
+            }
+
+            // SYNTHETIC: the target's cached synthetic on the venue. QUOTES, or any instrument
+            // that is not a target: the venue's own quote as a one-leg replication.
+            SyntheticPrice replication(VenuePriceSource source, VenueIndex venue, InstrumentHandle instrument) const;
+            // Units of that replication that can be bought (or sold) at top-of-book prices
+            Volume available_size(VenuePriceSource source, VenueIndex venue, InstrumentHandle instrument,
+                                  bool buying) const;
+
+            // One instrument, scalar; exclude drops a venue from the search
+            VenueBest best(VenuePriceSource source, InstrumentHandle instrument,
+                           VenueIndex exclude = INVALID_VENUE) const;
+
+            // Every instrument at once; valid until the next scan of the same source
+            const VenueScan &scan(VenuePriceSource source);
+
+            size_t instrument_capacity() const { return stride_; }
+        };
+
+    } // namespace pricing
+} // namespace spe
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "lockfree_queue.hpp"
+#include "thread_topology.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace spe
+{
+    namespace concurrency
+    {
+
+        enum class ExecutionMode
+        {
+            SEQUENTIAL, // run sub-tasks one after another on the calling thread
+            PARALLEL    // fan out over a WorkStealingPool
+        };
+
+        // How one task of a batch finished, measured from the start of the batch
+        struct TaskRunStatus
+        {
+            std::chrono::nanoseconds elapsed{0};
+            bool late = false;   // finished after the batch deadline; tasks are never cut short
+            bool failed = false; // threw; run_batch rethrows the first such exception
+        };
+
+        using BatchTask = std::function<void(size_t)>;
+
+        // Fixed set of worker threads, optionally pinned one per CPU, for fanning a small batch of
+        // independent tasks out per tick. Tasks are indices into the caller's work, dealt round
+        // robin onto per-worker deques; a worker pops its own deque from the back and, once that is
+        // empty, steals from the front of the others. The calling thread takes a share too and
+        // run_batch() returns when every task has run, so a batch costs its slowest task rather
+        // than the sum. No allocation per batch once the deques have grown.
+        class WorkStealingPool
+        {
+        private:
+            struct alignas(CACHE_LINE_SIZE) WorkerQueue
+            {
+                std::mutex mutex;
+                std::vector<uint32_t> tasks;
+                size_t head = 0; // thieves take from here, the owner from the back
+            };
+
+            std::vector<std::unique_ptr<WorkerQueue>> queues_; // one per worker, the last for the caller
+            std::vector<std::thread> workers_;
+
+            std::mutex batch_mutex_; // one batch at a time
+            std::atomic<const BatchTask *> task_;
+            std::atomic<size_t> remaining_;
+            std::chrono::steady_clock::time_point batch_start_;
+            std::chrono::nanoseconds deadline_;
+            std::vector<TaskRunStatus> *status_;
+            std::mutex failure_mutex_;
+            std::exception_ptr failure_; // first exception of the current batch
+
+            std::mutex wake_mutex_;
+            std::condition_variable wake_;
+            uint64_t generation_;
+            bool stopping_;
+
+            bool try_take(size_t self, uint32_t &index);
+            void execute(uint32_t index);
+            void worker_loop(size_t self, StagePlacement placement);
+            void start_workers(const std::vector<StagePlacement> &placements);
+
+        public:
+            // cpus[i], when given and >= 0, is the CPU worker i is pinned to
+            explicit WorkStealingPool(size_t thread_count, const std::vector<int> &cpus = {});
+            // One worker per placement, e.g. ThreadTopology::worker_placements("detector.shards", n).
+            // Each worker sizes its deque storage on its own node. Workers block between batches
+            // whatever the wait policy.
+            explicit WorkStealingPool(const std::vector<StagePlacement> &placements);
+            ~WorkStealingPool();
+
+            WorkStealingPool(const WorkStealingPool &) = delete;
+            WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+            size_t thread_count() const { return workers_.size(); }
+
+            // Runs task(0) .. task(count - 1) and waits for all of them. With status, entry i gets
+            // task i's completion time and whether that was past the deadline. A task that throws
+            // still counts as finished, so the batch completes; the first exception is then
+            // rethrown here, on the calling thread.
+            void run_batch(size_t count, const BatchTask &task,
+                           std::chrono::nanoseconds deadline = std::chrono::nanoseconds::max(),
+                           std::vector<TaskRunStatus> *status = nullptr);
+        };
+
+        // run_batch() on the pool in PARALLEL mode with a pool, otherwise inline in index order
+        void run_tasks(ExecutionMode mode, WorkStealingPool *pool, size_t count, const BatchTask &task,
+                       std::chrono::nanoseconds deadline = std::chrono::nanoseconds::max(),
+                       std::vector<TaskRunStatus> *status = nullptr);
+
+    } // namespace concurrency
+} // namespace spe
@@ -1,60 +1,568 @@
 #include "arbitrage_engine.hpp"
+#include "instrument_registry.hpp"
+#include "basis_scan_kernel.hpp"
 #include <algorithm>
-#include <random>
-#include <sstream>
+#include <atomic>
+#include <cmath>
 
 namespace spe {
 namespace arbitrage {
 
+namespace {
+// Starting amount for sizing triangular legs, in the cycle's first currency (demo scale)
+constexpr double TRIANGULAR_NOTIONAL = 1000.0;
+
+// Dynamic combinations: ridge penalty as a fraction of the mean price-move variance, the
+// solver's relative residual (ample for a fit redone every update), the correlation above
+// which two cluster members are treated as one, and the residual history and z-score before
+// a combination trades
+constexpr double RIDGE_PENALTY = 1e-3;
+constexpr double RIDGE_TOLERANCE = 1e-6;
+constexpr double REDUNDANT_CORRELATION = 0.98;
+constexpr size_t MIN_RESIDUAL_OBSERVATIONS = 20;
+constexpr double COMBINATION_ENTRY_Z = 2.0;
+
+// Spot + funding pairs: the column padding (the widest register) and the default horizon
+// over which funding is counted
+constexpr size_t BASIS_LANE_BLOCK = 8;
+constexpr std::chrono::hours DEFAULT_FUNDING_HORIZON{24};
+
+void scan_basis_simd(const pricing::detail::BasisScanKernelArgs& args) {
+    SimdLevel level = active_simd_level();
+    if (level == SimdLevel::AVX512 && pricing::detail::scan_basis_avx512(args)) {
+        return;
+    }
+    if (level >= SimdLevel::AVX2 && pricing::detail::scan_basis_avx2(args)) {
+        return;
+    }
+    pricing::detail::scan_basis_scalar(args);
+}
+
+// Moves next forward past now by whole periods; returns whether it moved
+bool roll_settlement(Timestamp& next, std::chrono::hours period, Timestamp now) {
+    if (next > now) {
+        return false;
+    }
+    next += (std::chrono::duration_cast<std::chrono::hours>(now - next) / period + 1) * period;
+    return true;
+}
+
+// Settlements at next, next + period, ... within (now, now + horizon]; next is after now
+size_t settlements_within(Timestamp next, std::chrono::hours period, Timestamp now, std::chrono::hours horizon) {
+    Timestamp end = now + horizon;
+    return next > end ? 0 : 1 + static_cast<size_t>((end - next) / period);
+}
+}
+
+OpportunityId next_opportunity_id() {
+    static std::atomic<OpportunityId> next_id{1};
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::string format_opportunity_id(const ArbitrageOpportunity& opportunity) {
+    const char* prefix = (opportunity.type == ArbitrageType::TRIANGULAR_ARBITRAGE) ? "TRIANG_" : "ARB_";
+    return prefix + std::to_string(opportunity.opportunity_id);
+}
+
+// IArbitrageEngine event adapter
+SnapshotStore& IArbitrageEngine::event_store() {
+    if (!event_store_) {
+        event_store_ = std::make_unique<SnapshotStore>();
+    }
+    return *event_store_;
+}
+
+void IArbitrageEngine::adapt_event() {
+    // The store keeps every instrument's latest state; the snapshot's dirty list is just this event
+    update_market_data(event_store_->publish());
+}
+
+void IArbitrageEngine::on_quote(InstrumentHandle instrument, const Quote& quote) {
+    Quote routed = quote;
+    routed.instrument = instrument;
+    event_store().apply_quote(routed);
+    adapt_event();
+}
+
+void IArbitrageEngine::on_trade(InstrumentHandle instrument, const Trade& trade) {
+    Trade routed = trade;
+    routed.instrument = instrument;
+    event_store().apply_trade(routed);
+    adapt_event();
+}
+
+void IArbitrageEngine::on_book_update(InstrumentHandle instrument, const MarketDepth& depth) {
+    MarketDepth routed = depth;
+    routed.instrument = instrument;
+    event_store().apply_depth(routed);
+    adapt_event();
+}
+
+// OpportunityBook implementation
+namespace {
+uint64_t floor_tick(Timestamp time) {
+    auto ms = std::chrono::floor<std::chrono::milliseconds>(time.time_since_epoch()).count();
+    return ms > 0 ? static_cast<uint64_t>(ms) : 0;
+}
+}
+
+OpportunityBook::OpportunityBook(std::chrono::minutes max_holding_period)
+    : expiry_wheel_(floor_tick(std::chrono::high_resolution_clock::now())),
+      max_holding_period_(max_holding_period), published_(new Published()), dirty_(false) {}
+
+OpportunityBook::~OpportunityBook() {
+    // No views outlive the book
+    delete published_.load();
+    for (auto& retired : retired_views_) {
+        delete retired.second;
+    }
+    for (Published* spare : spare_views_) {
+        delete spare;
+    }
+}
+
+uint64_t OpportunityBook::deadline_tick(const ArbitrageOpportunity& opportunity) const {
+    // An unset expiry_time is the clock's epoch
+    Timestamp deadline = opportunity.identification_time + max_holding_period_;
+    if (opportunity.expiry_time.time_since_epoch().count() != 0 && opportunity.expiry_time < deadline) {
+        deadline = opportunity.expiry_time;
+    }
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(deadline.time_since_epoch()).count();
+    return ms > 0 ? static_cast<uint64_t>(ms) : 0;
+}
+
+ArbitrageOpportunity& OpportunityBook::create(OpportunityHandle& handle) {
+    handle = pool_.acquire();
+    ArbitrageOpportunity& opportunity = *pool_.get(handle);
+    opportunity = ArbitrageOpportunity{};
+    opportunity.opportunity_id = next_opportunity_id();
+    return opportunity;
+}
+
+void OpportunityBook::commit(OpportunityHandle handle) {
+    ArbitrageOpportunity* opportunity = pool_.get(handle);
+    if (!opportunity || index_.count(opportunity->opportunity_id)) {
+        return;
+    }
+    OpportunityId id = opportunity->opportunity_id;
+    Entry entry{handle, expiry_wheel_.schedule(deadline_tick(*opportunity), id), static_cast<uint32_t>(live_.size())};
+    index_.emplace(id, entry);
+    live_.push_back(opportunity);
+    live_ids_.push_back(id);
+    dirty_ = true;
+}
+
+OpportunityHandle OpportunityBook::insert(const ArbitrageOpportunity& opportunity) {
+    OpportunityHandle handle = pool_.acquire();
+    *pool_.get(handle) = opportunity;
+    commit(handle);
+    return handle;
+}
+
+void OpportunityBook::unlink(OpportunityId id, bool cancel_timer) {
+    auto it = index_.find(id);
+    Entry entry = it->second;
+    if (cancel_timer) {
+        expiry_wheel_.cancel(entry.timer);
+    }
+
+    // Swap-remove from the live list
+    uint32_t last = static_cast<uint32_t>(live_.size() - 1);
+    if (entry.position != last) {
+        live_[entry.position] = live_[last];
+        live_ids_[entry.position] = live_ids_[last];
+        index_[live_ids_[entry.position]].position = entry.position;
+    }
+    live_.pop_back();
+    live_ids_.pop_back();
+    index_.erase(it);
+
+    // Views may still hold it; the slot is recycled once they are gone
+    unlinked_.push_back(entry.handle);
+    dirty_ = true;
+}
+
+void OpportunityBook::release(OpportunityHandle handle) {
+    const ArbitrageOpportunity* opportunity = pool_.get(handle);
+    if (!opportunity) {
+        return;
+    }
+    auto it = index_.find(opportunity->opportunity_id);
+    if (it != index_.end() && it->second.handle == handle) {
+        unlink(opportunity->opportunity_id, true);
+    } else {
+        pool_.release(handle); // never committed, so never visible
+    }
+}
+
+bool OpportunityBook::remove(OpportunityId id) {
+    if (!index_.count(id)) {
+        return false;
+    }
+    unlink(id, true);
+    return true;
+}
+
+OpportunityHandle OpportunityBook::find(OpportunityId id) const {
+    auto it = index_.find(id);
+    return it != index_.end() ? it->second.handle : OpportunityHandle{};
+}
+
+ArbitrageOpportunity* OpportunityBook::modify(OpportunityId id) {
+    auto it = index_.find(id);
+    if (it == index_.end()) {
+        return nullptr;
+    }
+    Entry& entry = it->second;
+    OpportunityHandle copy = pool_.acquire();
+    ArbitrageOpportunity* writable = pool_.get(copy);
+    *writable = *pool_.get(entry.handle);
+
+    unlinked_.push_back(entry.handle);
+    entry.handle = copy;
+    live_[entry.position] = writable;
+    modified_.push_back(id);
+    dirty_ = true;
+    return writable;
+}
+
+size_t OpportunityBook::expire(Timestamp now) {
+    size_t expired = 0;
+    expiry_wheel_.advance(floor_tick(now), [&](OpportunityId id) {
+        // Removal cancels the timer, so the opportunity is still live
+        unlink(id, false);
+        ++expired;
+    });
+    return expired;
+}
+
+void OpportunityBook::publish() {
+    for (OpportunityId id : modified_) {
+        auto it = index_.find(id);
+        if (it != index_.end()) {
+            expiry_wheel_.cancel(it->second.timer);
+            it->second.timer = expiry_wheel_.schedule(deadline_tick(*pool_.get(it->second.handle)), id);
+        }
+    }
+    modified_.clear();
+
+    if (dirty_) {
+        Published* next;
+        if (spare_views_.empty()) {
+            next = new Published();
+        } else {
+            next = spare_views_.back();
+            spare_views_.pop_back();
+        }
+        next->opportunities.assign(live_.begin(), live_.end());
+
+        Published* previous = published_.load();
+        next->version = previous->version + 1;
+        published_.store(next);
+
+        // Everything unlinked so far was reachable only through previous
+        uint64_t tag = epochs_.retire_epoch();
+        retired_views_.emplace_back(tag, previous);
+        for (OpportunityHandle handle : unlinked_) {
+            retired_.emplace_back(tag, handle);
+        }
+        unlinked_.clear();
+        epochs_.advance();
+        dirty_ = false;
+    }
+    reclaim();
+}
+
+void OpportunityBook::reclaim() {
+    if (retired_.empty() && retired_views_.empty()) {
+        return;
+    }
+    uint64_t oldest = epochs_.oldest_pinned();
+
+    size_t handles = 0;
+    while (handles < retired_.size() && retired_[handles].first < oldest) {
+        pool_.release(retired_[handles].second);
+        ++handles;
+    }
+    retired_.erase(retired_.begin(), retired_.begin() + handles);
+
+    size_t views = 0;
+    while (views < retired_views_.size() && retired_views_[views].first < oldest) {
+        spare_views_.push_back(retired_views_[views].second);
+        ++views;
+    }
+    retired_views_.erase(retired_views_.begin(), retired_views_.begin() + views);
+}
+
+void OpportunityBook::clear() {
+    while (!live_ids_.empty()) {
+        unlink(live_ids_.back(), true);
+    }
+    publish();
+}
+
+OpportunityBook::View OpportunityBook::view() const {
+    concurrency::EpochDomain::Guard guard = epochs_.pin();
+    return View(std::move(guard), published_.load());
+}
+
+std::vector<ArbitrageOpportunity> OpportunityBook::copy_all() const {
+    View current = view();
+    std::vector<ArbitrageOpportunity> opportunities;
+    opportunities.reserve(current.size());
+    for (const ArbitrageOpportunity* opportunity : current) {
+        opportunities.push_back(*opportunity);
+    }
+    return opportunities;
+}
+
+namespace {
+// Every field but the id, which is issued again on restore
+void put_opportunity(checkpoint::CheckpointWriter& out, const ArbitrageOpportunity& opportunity) {
+    out.put(static_cast<uint8_t>(opportunity.type));
+    out.put(static_cast<uint8_t>(opportunity.status));
+    out.put_count(opportunity.legs.size());
+    for (const auto& leg : opportunity.legs) {
+        out.put_instrument(leg.instrument);
+        out.put(static_cast<uint8_t>(leg.side));
+        out.put(leg.size);
+        out.put(leg.entry_price);
+        out.put(leg.exit_price);
+        out.put(leg.weight);
+        out.put_time(leg.entry_time);
+        out.put_time(leg.exit_time);
+    }
+
+    const MispricingOpportunity& source = opportunity.mispricing_source;
+    out.put_instrument(source.target_instrument);
+    out.put_count(source.component_instruments.size());
+    for (InstrumentHandle instrument : source.component_instruments) {
+        out.put_instrument(instrument);
+    }
+    out.put_count(source.weights.size());
+    out.put_doubles(source.weights.data(), source.weights.size());
+    out.put(static_cast<uint8_t>(source.type));
+    out.put(static_cast<uint8_t>(source.severity));
+    for (double value : {source.market_price, source.theoretical_price, source.deviation_percentage, source.z_score,
+                         source.confidence_level, source.expected_profit, source.max_loss, source.value_at_risk,
+                         source.expected_shortfall, source.sharpe_ratio}) {
+        out.put(value);
+    }
+    out.put_time(source.detection_time);
+    out.put_time(source.expiry_time);
+
+    for (double value : {opportunity.expected_profit, opportunity.max_loss, opportunity.profit_probability,
+                         opportunity.break_even_price, opportunity.total_cost, opportunity.net_exposure,
+                         opportunity.value_at_risk, opportunity.expected_shortfall, opportunity.sharpe_ratio,
+                         opportunity.max_drawdown, opportunity.correlation_risk, opportunity.slippage_estimate,
+                         opportunity.transaction_costs, opportunity.total_volume, opportunity.market_impact}) {
+        out.put(value);
+    }
+    out.put_time(opportunity.identification_time);
+    out.put_time(opportunity.validation_time);
+    out.put_time(opportunity.expiry_time);
+    out.put(static_cast<int64_t>(opportunity.estimated_duration.count()));
+}
+
+bool get_opportunity(checkpoint::SectionReader& in, ArbitrageOpportunity& opportunity) {
+    constexpr size_t LEG_BYTES = sizeof(uint32_t) + 1 + 4 * sizeof(double) + 2 * sizeof(int64_t);
+    uint8_t type = 0;
+    uint8_t status = 0;
+    size_t legs = 0;
+    in.get(type);
+    in.get(status);
+    opportunity.type = static_cast<ArbitrageType>(type);
+    opportunity.status = static_cast<ArbitrageStatus>(status);
+    in.get_count(legs, LEG_BYTES);
+    opportunity.legs.clear();
+    for (size_t i = 0; i < legs && in.ok(); ++i) {
+        ArbitrageLeg leg;
+        uint8_t side = 0;
+        in.get_instrument(leg.instrument);
+        in.get(side);
+        leg.side = static_cast<market_data::Side>(side);
+        in.get(leg.size);
+        in.get(leg.entry_price);
+        in.get(leg.exit_price);
+        in.get(leg.weight);
+        in.get_time(leg.entry_time);
+        in.get_time(leg.exit_time);
+        opportunity.legs.push_back(leg);
+    }
+
+    MispricingOpportunity& source = opportunity.mispricing_source;
+    size_t components = 0;
+    size_t weights = 0;
+    in.get_instrument(source.target_instrument);
+    in.get_count(components, sizeof(uint32_t));
+    source.component_instruments.clear();
+    for (size_t i = 0; i < components && in.ok(); ++i) {
+        InstrumentHandle instrument = INVALID_INSTRUMENT;
+        in.get_instrument(instrument);
+        source.component_instruments.push_back(instrument);
+    }
+    in.get_count(weights, sizeof(double));
+    source.weights.clear();
+    for (size_t i = 0; i < weights && in.ok(); ++i) {
+        double weight = 0.0;
+        in.get(weight);
+        source.weights.push_back(weight);
+    }
+    uint8_t source_type = 0;
+    uint8_t severity = 0;
+    in.get(source_type);
+    in.get(severity);
+    source.type = static_cast<MispricingType>(source_type);
+    source.severity = static_cast<MispricingSeverity>(severity);
+    for (double* value : {&source.market_price, &source.theoretical_price, &source.deviation_percentage,
+                          &source.z_score, &source.confidence_level, &source.expected_profit, &source.max_loss,
+                          &source.value_at_risk, &source.expected_shortfall, &source.sharpe_ratio}) {
+        in.get(*value);
+    }
+    in.get_time(source.detection_time);
+    in.get_time(source.expiry_time);
+
+    for (double* value : {&opportunity.expected_profit, &opportunity.max_loss, &opportunity.profit_probability,
+                          &opportunity.break_even_price, &opportunity.total_cost, &opportunity.net_exposure,
+                          &opportunity.value_at_risk, &opportunity.expected_shortfall, &opportunity.sharpe_ratio,
+                          &opportunity.max_drawdown, &opportunity.correlation_risk, &opportunity.slippage_estimate,
+                          &opportunity.transaction_costs, &opportunity.total_volume, &opportunity.market_impact}) {
+        in.get(*value);
+    }
+    int64_t duration = 0;
+    in.get_time(opportunity.identification_time);
+    in.get_time(opportunity.validation_time);
+    in.get_time(opportunity.expiry_time);
+    in.get(duration);
+    opportunity.estimated_duration = std::chrono::milliseconds(duration);
+    return in.ok();
+}
+}
+
+void OpportunityBook::save_state(checkpoint::CheckpointWriter& out) const {
+    out.put_count(live_.size());
+    for (const ArbitrageOpportunity* opportunity : live_) {
+        put_opportunity(out, *opportunity);
+    }
+}
+
+bool OpportunityBook::restore_state(checkpoint::SectionReader& in, Timestamp now) {
+    uint64_t now_tick = floor_tick(now);
+    size_t count = 0;
+    in.get_count(count, 64);
+    ArbitrageOpportunity opportunity;
+    for (size_t i = 0; i < count && in.ok(); ++i) {
+        if (get_opportunity(in, opportunity) && deadline_tick(opportunity) > now_tick) {
+            opportunity.opportunity_id = next_opportunity_id(); // ids are only unique within a process
+            insert(opportunity);
+        }
+    }
+    publish();
+    return in.ok();
+}
+
 // ArbitrageEngine implementation
 ArbitrageEngine::ArbitrageEngine(const ArbitrageParameters& params)
-    : params_(params) {}
+    : params_(params), active_opportunities_(params.max_holding_period) {}
 
 ArbitrageEngine::~ArbitrageEngine() = default;
 
 void ArbitrageEngine::update_market_data(const MarketSnapshot& snapshot) {
-    latest_snapshot_ = snapshot;
+    latest_snapshot_ = snapshot; // view copy, no market data is cloned
+    if (snapshot.store()) {
+        for (InstrumentHandle instrument : snapshot.dirty_instruments()) {
+            refresh_visible_liquidity(instrument);
+        }
+    }
     cleanup_expired_opportunities();
 }
 
 void ArbitrageEngine::process_mispricing(const MispricingOpportunity& mispricing) {
-    pending_mispricings_.push(mispricing);
+    // Built in place in a pooled slot; released again if it does not validate
+    ValidationContext context = validation_context();
+    OpportunityHandle handle;
+    ArbitrageOpportunity& arbitrage_opp = active_opportunities_.create(handle);
+    build_arbitrage_from_mispricing(mispricing, arbitrage_opp, context.now);
     
-    // Process pending mispricings
-    while (!pending_mispricings_.empty()) {
-        auto mispricing_opp = pending_mispricings_.front();
-        pending_mispricings_.pop();
-        
-        auto arbitrage_opp = create_arbitrage_from_mispricing(mispricing_opp);
+    ++validation_stats_.screened;
+    if (!screen_opportunity(arbitrage_opp, context)) {
+        ++validation_stats_.screen_rejected;
+        active_opportunities_.release(handle);
+        return;
+    }
+    if (!validate_survivor(arbitrage_opp, context)) {
+        ++validation_stats_.full_rejected;
+        active_opportunities_.release(handle);
+        return;
+    }
+    ++validation_stats_.accepted;
+    active_opportunities_.commit(handle);
+    
+    if (opportunity_callback_) {
+        opportunity_callback_(arbitrage_opp);
+    }
+    active_opportunities_.publish();
+}
+
+void ArbitrageEngine::process_mispricing_batch(const std::vector<MispricingOpportunity>& mispricings) {
+    // One clock read and one headroom load for the tick; the screen drops most candidates
+    // before any book is walked
+    ValidationContext context = validation_context();
+    survivors_.clear();
+    for (const auto& mispricing : mispricings) {
+        OpportunityHandle handle;
+        ArbitrageOpportunity& arbitrage_opp = active_opportunities_.create(handle);
+        build_arbitrage_from_mispricing(mispricing, arbitrage_opp, context.now);
+        if (screen_opportunity(arbitrage_opp, context)) {
+            survivors_.push_back(handle);
+        } else {
+            active_opportunities_.release(handle);
+        }
+    }
+    validation_stats_.screened += mispricings.size();
+    validation_stats_.screen_rejected += mispricings.size() - survivors_.size();
+    
+    // Survivors in arrival order, each drawing down what the earlier ones left
+    bool committed = false;
+    for (OpportunityHandle handle : survivors_) {
+        ArbitrageOpportunity& arbitrage_opp = *active_opportunities_.get(handle);
+        if (!validate_survivor(arbitrage_opp, context)) {
+            ++validation_stats_.full_rejected;
+            active_opportunities_.release(handle);
+            continue;
+        }
+        ++validation_stats_.accepted;
+        active_opportunities_.commit(handle);
+        committed = true;
         
-        if (validate_opportunity(arbitrage_opp)) {
-            active_opportunities_.push_back(arbitrage_opp);
-            
-            if (opportunity_callback_) {
-                opportunity_callback_(arbitrage_opp);
-            }
+        if (opportunity_callback_) {
+            opportunity_callback_(arbitrage_opp);
         }
     }
+    survivors_.clear();
+    if (committed) {
+        active_opportunities_.publish();
+    }
 }
 
 std::vector<ArbitrageOpportunity> ArbitrageEngine::identify_opportunities() {
     std::vector<ArbitrageOpportunity> opportunities;
     
     // Simplified opportunity identification for demo
-    if (latest_snapshot_.quotes.size() >= 2) {
+    if (latest_snapshot_.quote_count() >= 2) {
         ArbitrageOpportunity opp;
-        opp.opportunity_id = generate_opportunity_id();
+        opp.opportunity_id = next_opportunity_id();
         opp.type = ArbitrageType::CROSS_EXCHANGE_SYNTHETIC_REPLICATION;
         opp.status = ArbitrageStatus::IDENTIFIED;
         
         // Create synthetic arbitrage legs
-        auto it = latest_snapshot_.quotes.begin();
-        for (int i = 0; i < 2 && it != latest_snapshot_.quotes.end(); ++i, ++it) {
+        const auto& instruments = latest_snapshot_.instruments();
+        for (size_t i = 0; i < 2 && i < instruments.size(); ++i) {
             ArbitrageLeg leg;
-            leg.instrument_id = it->first;
+            leg.instrument = instruments[i];
             leg.side = (i == 0) ? market_data::Side::BID : market_data::Side::ASK;
             leg.size = 100.0;
-            leg.entry_price = (it->second.bid_price + it->second.ask_price) / 2.0;
+            leg.entry_price = latest_snapshot_.mid_price(instruments[i]);
             leg.weight = (i == 0) ? 1.0 : -1.0;
             leg.entry_time = std::chrono::high_resolution_clock::now();
             
@@ -80,20 +588,8 @@ std::vector<ArbitrageOpportunity> ArbitrageEngine::identify_opportunities() {
 }
 
 bool ArbitrageEngine::validate_opportunity(ArbitrageOpportunity& opportunity) {
-    // Comprehensive validation
-    bool is_valid = true;
-    
-    is_valid &= validate_liquidity(opportunity);
-    is_valid &= validate_risk_limits(opportunity);
-    is_valid &= validate_timing(opportunity);
-    is_valid &= validate_execution_feasibility(opportunity);
-    
-    if (is_valid) {
-        opportunity.status = ArbitrageStatus::VALIDATED;
-        opportunity.validation_time = std::chrono::high_resolution_clock::now();
-    }
-    
-    return is_valid;
+    ValidationContext context = validation_context();
+    return screen_opportunity(opportunity, context) && validate_survivor(opportunity, context);
 }
 
 void ArbitrageEngine::set_opportunity_callback(ArbitrageCallback callback) {
@@ -106,56 +602,53 @@ void ArbitrageEngine::set_update_callback(ArbitrageUpdateCallback callback) {
 
 void ArbitrageEngine::update_parameters(const ArbitrageParameters& params) {
     params_ = params;
+    active_opportunities_.set_max_holding_period(params_.max_holding_period);
 }
 
 std::vector<ArbitrageOpportunity> ArbitrageEngine::get_active_opportunities() const {
-    return active_opportunities_;
+    return active_opportunities_.copy_all();
+}
+
+void ArbitrageEngine::visit_active_opportunities(const OpportunityVisitor& visitor) const {
+    active_opportunities_.for_each(visitor);
 }
 
 void ArbitrageEngine::clear_opportunities() {
     active_opportunities_.clear();
 }
 
-void ArbitrageEngine::update_opportunity_status(const std::string& opportunity_id, ArbitrageStatus status) {
-    auto it = std::find_if(active_opportunities_.begin(), active_opportunities_.end(),
-        [&opportunity_id](const ArbitrageOpportunity& opp) {
-            return opp.opportunity_id == opportunity_id;
-        });
+void ArbitrageEngine::update_opportunity_status(OpportunityId opportunity_id, ArbitrageStatus status) {
+    // Copy-on-write, so views taken earlier keep the previous status
+    ArbitrageOpportunity* opportunity = active_opportunities_.modify(opportunity_id);
     
-    if (it != active_opportunities_.end()) {
-        it->status = status;
-        update_opportunity_status(*it);
+    if (opportunity) {
+        opportunity->status = status;
+        update_opportunity_status(*opportunity);
         
         if (update_callback_) {
-            update_callback_(*it);
+            update_callback_(*opportunity);
         }
+        active_opportunities_.publish();
     }
 }
 
-ArbitrageOpportunity ArbitrageEngine::get_opportunity_by_id(const std::string& opportunity_id) const {
-    auto it = std::find_if(active_opportunities_.begin(), active_opportunities_.end(),
-        [&opportunity_id](const ArbitrageOpportunity& opp) {
-            return opp.opportunity_id == opportunity_id;
-        });
-    
-    if (it != active_opportunities_.end()) {
-        return *it;
-    }
-    
-    return ArbitrageOpportunity{}; // Return empty opportunity if not found
+const ArbitrageOpportunity* ArbitrageEngine::find_opportunity(OpportunityId opportunity_id) const {
+    return active_opportunities_.get(active_opportunities_.find(opportunity_id));
+}
+
+bool ArbitrageEngine::restore_state(checkpoint::SectionReader& in) {
+    return active_opportunities_.restore_state(in, std::chrono::high_resolution_clock::now());
 }
 
 // Private methods
-ArbitrageOpportunity ArbitrageEngine::create_arbitrage_from_mispricing(const MispricingOpportunity& mispricing) {
-    ArbitrageOpportunity arbitrage_opp;
-    
-    arbitrage_opp.opportunity_id = generate_opportunity_id();
+void ArbitrageEngine::build_arbitrage_from_mispricing(const MispricingOpportunity& mispricing,
+                                                      ArbitrageOpportunity& arbitrage_opp, Timestamp now) {
     arbitrage_opp.type = ArbitrageType::STATISTICAL_ARBITRAGE;
     arbitrage_opp.status = ArbitrageStatus::IDENTIFIED;
     arbitrage_opp.mispricing_source = mispricing;
     
     // Convert mispricing to arbitrage legs
-    arbitrage_opp.legs = optimize_legs(mispricing);
+    optimize_legs(mispricing, arbitrage_opp.legs, now);
     
     // Copy financial metrics from mispricing
     arbitrage_opp.expected_profit = mispricing.expected_profit;
@@ -164,41 +657,37 @@ ArbitrageOpportunity ArbitrageEngine::create_arbitrage_from_mispricing(const Mis
     arbitrage_opp.expected_shortfall = mispricing.expected_shortfall;
     arbitrage_opp.sharpe_ratio = mispricing.sharpe_ratio;
     
-    arbitrage_opp.identification_time = std::chrono::high_resolution_clock::now();
+    arbitrage_opp.identification_time = now;
     arbitrage_opp.expiry_time = mispricing.expiry_time;
-    
-    return arbitrage_opp;
 }
 
-std::vector<ArbitrageLeg> ArbitrageEngine::optimize_legs(const MispricingOpportunity& mispricing) {
-    std::vector<ArbitrageLeg> legs;
+void ArbitrageEngine::optimize_legs(const MispricingOpportunity& mispricing, LegVector& legs, Timestamp now) {
+    legs.clear();
     
     // Create primary leg for target instrument
     ArbitrageLeg primary_leg;
-    primary_leg.instrument_id = mispricing.target_instrument;
+    primary_leg.instrument = mispricing.target_instrument;
     primary_leg.side = (mispricing.market_price < mispricing.theoretical_price) ? 
                        market_data::Side::BID : market_data::Side::ASK;
     primary_leg.size = 100.0; // Simplified size
     primary_leg.entry_price = mispricing.market_price;
     primary_leg.weight = 1.0;
-    primary_leg.entry_time = std::chrono::high_resolution_clock::now();
+    primary_leg.entry_time = now;
     
     legs.push_back(primary_leg);
     
     // Create hedging legs for component instruments
     for (size_t i = 0; i < mispricing.component_instruments.size() && i < mispricing.weights.size(); ++i) {
         ArbitrageLeg hedge_leg;
-        hedge_leg.instrument_id = mispricing.component_instruments[i];
+        hedge_leg.instrument = mispricing.component_instruments[i];
         hedge_leg.side = (mispricing.weights[i] > 0) ? market_data::Side::ASK : market_data::Side::BID;
         hedge_leg.size = std::abs(mispricing.weights[i]) * 100.0;
         hedge_leg.entry_price = 100.0; // Simplified price
         hedge_leg.weight = -mispricing.weights[i];
-        hedge_leg.entry_time = std::chrono::high_resolution_clock::now();
+        hedge_leg.entry_time = now;
         
         legs.push_back(hedge_leg);
     }
-    
-    return legs;
 }
 
 double ArbitrageEngine::calculate_value_at_risk(const ArbitrageOpportunity& opportunity) {
@@ -216,7 +705,7 @@ double ArbitrageEngine::calculate_expected_shortfall(const ArbitrageOpportunity&
     return calculate_value_at_risk(opportunity) * 1.3;
 }
 
-double ArbitrageEngine::calculate_correlation_risk(const std::vector<ArbitrageLeg>& legs) {
+double ArbitrageEngine::calculate_correlation_risk(const LegVector& legs) {
     // Simplified correlation risk calculation
     if (legs.size() < 2) return 0.0;
     
@@ -243,93 +732,127 @@ double ArbitrageEngine::calculate_market_impact(const ArbitrageOpportunity& oppo
     return (total_volume / 1000.0) * 0.001;
 }
 
-bool ArbitrageEngine::validate_liquidity(const ArbitrageOpportunity& opportunity) {
-    for (const auto& leg : opportunity.legs) {
-        auto quote_it = latest_snapshot_.quotes.find(leg.instrument_id);
-        if (quote_it != latest_snapshot_.quotes.end()) {
-            double available_liquidity = (leg.side == market_data::Side::BID) ?
-                                       quote_it->second.ask_size : quote_it->second.bid_size;
-            
-            if (available_liquidity < leg.size) {
-                return false; // Insufficient liquidity
-            }
-        }
+ArbitrageEngine::ValidationContext ArbitrageEngine::validation_context() const {
+    ValidationContext context;
+    context.now = std::chrono::high_resolution_clock::now();
+    if (headroom_feed_ && headroom_feed_->version() > 0) {
+        headroom_feed_->load(context.headroom);
     }
-    
-    return true;
+    return context;
 }
 
-bool ArbitrageEngine::validate_risk_limits(const ArbitrageOpportunity& opportunity) {
-    // Check profit threshold
-    if (opportunity.expected_profit < params_.min_profit_threshold * opportunity.total_cost) {
-        return false;
+void ArbitrageEngine::refresh_visible_liquidity(InstrumentHandle instrument) {
+    if (instrument >= visible_liquidity_.size()) {
+        visible_liquidity_.resize(instrument + 1, {{std::numeric_limits<Volume>::infinity(),
+                                                    std::numeric_limits<Volume>::infinity()}});
     }
-    
-    // Check VaR limit
-    if (opportunity.value_at_risk > params_.max_risk_per_trade * opportunity.total_cost) {
-        return false;
+    // Whole sides of the book, and the quote sizes: at least what validate_liquidity can find
+    Volume asks = 0.0;
+    Volume bids = 0.0;
+    bool known = false;
+    if (const MarketDepth* depth = latest_snapshot_.depth(instrument)) {
+        for (uint32_t i = 0; i < depth->ask_count; ++i) {
+            asks += depth->asks[i].size;
+        }
+        for (uint32_t i = 0; i < depth->bid_count; ++i) {
+            bids += depth->bids[i].size;
+        }
+        known = true;
     }
-    
-    // Check correlation risk
-    if (opportunity.correlation_risk > params_.max_correlation_risk) {
-        return false;
+    if (latest_snapshot_.has_quote(instrument)) {
+        asks = std::max(asks, latest_snapshot_.ask_size(instrument));
+        bids = std::max(bids, latest_snapshot_.bid_size(instrument));
+        known = true;
     }
-    
-    // Check market impact
-    if (opportunity.market_impact > params_.max_market_impact) {
-        return false;
+    if (known) {
+        visible_liquidity_[instrument] = {{asks, bids}};
     }
-    
-    return true;
 }
 
-bool ArbitrageEngine::validate_timing(const ArbitrageOpportunity& opportunity) {
-    auto now = std::chrono::high_resolution_clock::now();
-    
-    // Check if opportunity hasn't expired
-    if (now >= opportunity.expiry_time) {
-        return false;
-    }
+bool ArbitrageEngine::screen_opportunity(const ArbitrageOpportunity& opportunity, const ValidationContext& context) const {
+    // Timing: there must be time left to execute
+    bool pass = opportunity.expiry_time - context.now >= MIN_TIME_TO_EXECUTE;
     
-    // Check if we have enough time to execute
-    auto time_remaining = std::chrono::duration_cast<std::chrono::minutes>(
-        opportunity.expiry_time - now);
+    // Risk limits on the candidate's own metrics
+    pass &= !(opportunity.expected_profit < params_.min_profit_threshold * opportunity.total_cost);
+    pass &= !(opportunity.value_at_risk > params_.max_risk_per_trade * opportunity.total_cost);
+    pass &= !(opportunity.correlation_risk > params_.max_correlation_risk);
+    pass &= !(opportunity.market_impact > params_.max_market_impact);
+    pass &= !(opportunity.slippage_estimate > params_.max_slippage);
+    pass &= !context.headroom.halted;
     
-    if (time_remaining < std::chrono::minutes(5)) { // Need at least 5 minutes
-        return false;
+    // Size, per-leg headroom and the liquidity bounds, in one pass over the legs
+    double position_value = 0.0;
+    for (const auto& leg : opportunity.legs) {
+        double notional = leg.size * leg.entry_price;
+        position_value += notional;
+        pass &= !(std::abs(notional) > context.headroom.position_size_limit);
+        if (leg.entry_price > 0.0 && leg.instrument < visible_liquidity_.size()) {
+            pass &= !(leg.size > visible_liquidity_[leg.instrument][leg.side == market_data::Side::BID ? 0 : 1]);
+        }
+    }
+    pass &= !(position_value > params_.max_position_size);
+    pass &= !(incremental_value_at_risk(opportunity, context.headroom) > context.headroom.var_headroom);
+    return pass;
+}
+
+bool ArbitrageEngine::validate_liquidity(const ArbitrageOpportunity& opportunity) {
+    for (const auto& leg : opportunity.legs) {
+        // Prefer the book: count only the levels reachable within the slippage budget
+        const MarketDepth* depth = latest_snapshot_.depth(leg.instrument);
+        if (depth && leg.entry_price > 0.0) {
+            Price limit = (leg.side == market_data::Side::BID) ?
+                          leg.entry_price * (1.0 + params_.max_slippage) :
+                          leg.entry_price * (1.0 - params_.max_slippage);
+            if (depth->available_volume(leg.side, limit) < leg.size) {
+                return false;
+            }
+        } else if (latest_snapshot_.has_quote(leg.instrument)) {
+            double available_liquidity = (leg.side == market_data::Side::BID) ?
+                                       latest_snapshot_.ask_size(leg.instrument) :
+                                       latest_snapshot_.bid_size(leg.instrument);
+            
+            if (available_liquidity < leg.size) {
+                return false; // Insufficient liquidity
+            }
+        }
     }
     
     return true;
 }
 
-bool ArbitrageEngine::validate_execution_feasibility(const ArbitrageOpportunity& opportunity) {
-    // Check if total position size is within limits
-    double total_position_value = 0.0;
+double ArbitrageEngine::incremental_value_at_risk(const ArbitrageOpportunity& opportunity,
+                                                  const RiskHeadroom& headroom) const {
+    // Legs taken as uncorrelated, as SyntheticExposureManager::validate_new_position does
+    double variance = 0.0;
     for (const auto& leg : opportunity.legs) {
-        total_position_value += leg.size * leg.entry_price;
+        double notional = leg.size * leg.entry_price;
+        variance += notional * notional;
     }
-    
-    if (total_position_value > params_.max_position_size) {
+    return std::sqrt(variance) * headroom.var_per_notional;
+}
+
+bool ArbitrageEngine::validate_survivor(ArbitrageOpportunity& opportunity, ValidationContext& context) {
+    // The book walk, then the headroom left by the batch's earlier acceptances
+    if (!validate_liquidity(opportunity)) {
         return false;
     }
-    
-    // Check estimated slippage
-    if (opportunity.slippage_estimate > params_.max_slippage) {
+    double incremental_var = incremental_value_at_risk(opportunity, context.headroom);
+    if (incremental_var > context.headroom.var_headroom) {
         return false;
     }
+    context.headroom.var_headroom -= incremental_var;
     
+    opportunity.status = ArbitrageStatus::VALIDATED;
+    opportunity.validation_time = context.now;
     return true;
 }
 
 void ArbitrageEngine::cleanup_expired_opportunities() {
-    auto now = std::chrono::high_resolution_clock::now();
-    
-    active_opportunities_.erase(
-        std::remove_if(active_opportunities_.begin(), active_opportunities_.end(),
-            [now](const ArbitrageOpportunity& opp) {
-                return now >= opp.expiry_time;
-            }),
-        active_opportunities_.end());
+    // The book's expiry wheel only visits what is due
+    if (active_opportunities_.expire(std::chrono::high_resolution_clock::now()) > 0) {
+        active_opportunities_.publish();
+    }
 }
 
 void ArbitrageEngine::update_opportunity_status(ArbitrageOpportunity& opportunity) {
@@ -341,61 +864,83 @@ void ArbitrageEngine::update_opportunity_status(ArbitrageOpportunity& opportunit
     }
 }
 
-std::string ArbitrageEngine::generate_opportunity_id() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(1000, 9999);
-    
-    auto now = std::chrono::high_resolution_clock::now();
-    auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()).count();
-    
-    std::stringstream ss;
-    ss << "ARB_" << timestamp << "_" << dis(gen);
-    return ss.str();
-}
-
 // TriangularArbitrageEngine implementation
 TriangularArbitrageEngine::TriangularArbitrageEngine(const ArbitrageParameters& params)
-    : params_(params) {
+    : params_(params), currency_graph_(false, 0.0, params.min_profit_threshold),
+      discover_pairs_(false), graph_stale_(true), active_opportunities_(params.max_holding_period) {
     // Initialize some default currency triangles
-    currency_triangles_["BTC-ETH-USD"] = {"BTC-USD", "ETH-USD", "BTC-ETH"};
-    currency_triangles_["BTC-USDT-USD"] = {"BTC-USD", "USDT-USD", "BTC-USDT"};
+    currency_triangles_["BTC-ETH-USD"] = {intern_instrument("BTC-USD"), intern_instrument("ETH-USD"),
+                                          intern_instrument("BTC-ETH")};
+    currency_triangles_["BTC-USDT-USD"] = {intern_instrument("BTC-USD"), intern_instrument("USDT-USD"),
+                                           intern_instrument("BTC-USDT")};
 }
 
 void TriangularArbitrageEngine::update_market_data(const MarketSnapshot& snapshot) {
-    // Store latest snapshot and detect opportunities
-    auto opportunities = identify_triangular_opportunities(snapshot);
+    bool full = graph_stale_;
+    if (graph_stale_) {
+        rebuild_graph();
+    }
     
-    for (auto& opp : opportunities) {
-        if (validate_opportunity(opp)) {
-            active_opportunities_.push_back(opp);
-            
-            if (opportunity_callback_) {
-                opportunity_callback_(opp);
-            }
-        }
+    // Only cycles through the pairs quoted in this interval are re-scored; a cycle that stays
+    // profitable is reported once, when it crosses the threshold
+    currency_graph_.apply_snapshot(snapshot, full);
+    evaluate_cycles();
+}
+
+void TriangularArbitrageEngine::on_quote(InstrumentHandle instrument, const Quote& quote) {
+    // After a rebuild a cycle scores again once each of its pairs has been requoted
+    if (graph_stale_) {
+        rebuild_graph();
+    }
+    if (currency_graph_.update_quote(instrument, quote.bid_price, quote.ask_price)) {
+        evaluate_cycles();
     }
 }
 
+void TriangularArbitrageEngine::evaluate_cycles() {
+    currency_graph_.evaluate_touched([this](uint32_t cycle, double log_return, bool newly_profitable) {
+        if (!newly_profitable) {
+            return;
+        }
+        OpportunityHandle handle;
+        ArbitrageOpportunity& opp = active_opportunities_.create(handle);
+        create_triangular_opportunity(cycle, log_return, opp);
+        if (!validate_opportunity(opp)) {
+            active_opportunities_.release(handle);
+            return;
+        }
+        active_opportunities_.commit(handle);
+        if (opportunity_callback_) {
+            opportunity_callback_(opp);
+        }
+    });
+
+    // Cycles are reported once, so the book also retires them past their expiry
+    active_opportunities_.expire(std::chrono::high_resolution_clock::now());
+    active_opportunities_.publish();
+}
+
 void TriangularArbitrageEngine::process_mispricing(const MispricingOpportunity& mispricing) {
     // Convert mispricing to triangular arbitrage if applicable
     if (mispricing.type == mispricing::MispricingType::CROSS_CURRENCY_TRIANGULAR) {
-        ArbitrageOpportunity triangular_opp;
-        triangular_opp.opportunity_id = "TRIANG_" + std::to_string(
-            std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::high_resolution_clock::now().time_since_epoch()).count());
+        OpportunityHandle handle;
+        ArbitrageOpportunity& triangular_opp = active_opportunities_.create(handle);
         triangular_opp.type = ArbitrageType::TRIANGULAR_ARBITRAGE;
         triangular_opp.status = ArbitrageStatus::IDENTIFIED;
         triangular_opp.expected_profit = mispricing.expected_profit;
         triangular_opp.identification_time = std::chrono::high_resolution_clock::now();
-        
-        active_opportunities_.push_back(triangular_opp);
+        active_opportunities_.commit(handle);
+        active_opportunities_.publish();
     }
 }
 
 std::vector<ArbitrageOpportunity> TriangularArbitrageEngine::identify_opportunities() {
-    return identify_triangular_opportunities(MarketSnapshot{});
+    std::vector<ArbitrageOpportunity> opportunities(currency_graph_.profitable_cycles().size());
+    for (size_t i = 0; i < opportunities.size(); ++i) {
+        uint32_t cycle = currency_graph_.profitable_cycles()[i];
+        create_triangular_opportunity(cycle, currency_graph_.cycle_log_return(cycle), opportunities[i]);
+    }
+    return opportunities;
 }
 
 bool TriangularArbitrageEngine::validate_opportunity(ArbitrageOpportunity& opportunity) {
@@ -415,65 +960,1476 @@ void TriangularArbitrageEngine::set_update_callback(ArbitrageUpdateCallback call
 
 void TriangularArbitrageEngine::update_parameters(const ArbitrageParameters& params) {
     params_ = params;
+    active_opportunities_.set_max_holding_period(params_.max_holding_period);
+    currency_graph_.set_min_return(params_.min_profit_threshold);
+    graph_stale_ = true;
 }
 
 std::vector<ArbitrageOpportunity> TriangularArbitrageEngine::get_active_opportunities() const {
-    return active_opportunities_;
+    return active_opportunities_.copy_all();
+}
+
+void TriangularArbitrageEngine::visit_active_opportunities(const OpportunityVisitor& visitor) const {
+    active_opportunities_.for_each(visitor);
 }
 
 void TriangularArbitrageEngine::clear_opportunities() {
     active_opportunities_.clear();
 }
 
-std::vector<ArbitrageOpportunity> TriangularArbitrageEngine::identify_triangular_opportunities(const MarketSnapshot& snapshot) {
-    std::vector<ArbitrageOpportunity> opportunities;
-    
+void TriangularArbitrageEngine::add_currency_triangle(const std::string& name,
+                                                      const std::vector<InstrumentHandle>& instruments) {
+    currency_triangles_[name] = instruments;
+    graph_stale_ = true;
+}
+
+void TriangularArbitrageEngine::remove_currency_triangle(const std::string& name) {
+    graph_stale_ |= currency_triangles_.erase(name) > 0;
+}
+
+void TriangularArbitrageEngine::discover_currency_pairs(bool include_four_cycles) {
+    discover_pairs_ = true;
+    currency_graph_.set_include_four_cycles(include_four_cycles);
+    graph_stale_ = true;
+}
+
+void TriangularArbitrageEngine::rebuild_graph() {
+    currency_graph_.clear();
     for (const auto& [name, triangle] : currency_triangles_) {
-        if (triangle.size() >= 3) {
-            ArbitrageOpportunity opp = create_triangular_opportunity(triangle, snapshot);
-            
-            double profit = calculate_triangular_profit(std::vector<market_data::Quote>{}); // Simplified
-            if (profit > params_.min_profit_threshold) {
-                opp.expected_profit = profit * 1000; // Scale for demo
-                opportunities.push_back(opp);
-            }
+        for (InstrumentHandle instrument : triangle) {
+            currency_graph_.add_pair(instrument);
         }
     }
-    
-    return opportunities;
+    if (discover_pairs_) {
+        currency_graph_.discover_pairs(InstrumentRegistry::instance());
+    }
+    currency_graph_.build();
+    graph_stale_ = false;
 }
 
-ArbitrageOpportunity TriangularArbitrageEngine::create_triangular_opportunity(
-    const std::vector<InstrumentId>& triangle, const MarketSnapshot& snapshot) {
-    
-    ArbitrageOpportunity opp;
-    opp.opportunity_id = "TRIANG_" + std::to_string(
-        std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::high_resolution_clock::now().time_since_epoch()).count());
+void TriangularArbitrageEngine::create_triangular_opportunity(uint32_t cycle, double log_return,
+                                                              ArbitrageOpportunity& opp) const {
+    if (opp.opportunity_id == INVALID_OPPORTUNITY_ID) {
+        opp.opportunity_id = next_opportunity_id();
+    }
     opp.type = ArbitrageType::TRIANGULAR_ARBITRAGE;
     opp.status = ArbitrageStatus::IDENTIFIED;
     opp.identification_time = std::chrono::high_resolution_clock::now();
     opp.expiry_time = opp.identification_time + std::chrono::minutes(15);
+    opp.legs.clear();
     
-    // Create legs for the triangle
-    for (size_t i = 0; i < triangle.size(); ++i) {
-        ArbitrageLeg leg;
-        leg.instrument_id = triangle[i];
-        leg.side = (i % 2 == 0) ? market_data::Side::BID : market_data::Side::ASK;
-        leg.size = 100.0;
-        leg.entry_price = 100.0 + i; // Simplified pricing
-        leg.weight = (i % 2 == 0) ? 1.0 : -1.0;
-        leg.entry_time = std::chrono::high_resolution_clock::now();
+    // Walk the cycle with TRIANGULAR_NOTIONAL of its first currency; leg sizes are in base units
+    const auto& path = currency_graph_.cycle(cycle);
+    double amount = TRIANGULAR_NOTIONAL;
+    Volume total_volume = 0.0;
+    for (uint32_t i = 0; i < path.length; ++i) {
+        const auto& edge = currency_graph_.edge(path.edges[i]);
+        Price price = currency_graph_.edge_price(path.edges[i]);
+        bool buy = edge.side == market_data::Side::BID;
+        Volume size = buy ? amount / price : amount;
+        amount = buy ? size : amount * price;
         
+        ArbitrageLeg leg(edge.instrument, edge.side, size, price, buy ? 1.0 : -1.0);
+        leg.entry_time = opp.identification_time;
         opp.legs.push_back(leg);
+        total_volume += size;
+    }
+    
+    opp.expected_profit = TRIANGULAR_NOTIONAL * std::expm1(log_return);
+    opp.total_cost = TRIANGULAR_NOTIONAL;
+    opp.total_volume = total_volume;
+}
+
+// SpotFundingSyntheticPerpetualEngine implementation
+SpotFundingSyntheticPerpetualEngine::SpotFundingSyntheticPerpetualEngine(
+    std::unique_ptr<PerpetualSwapPricingModel> model, const ArbitrageParameters& params)
+    : params_(params), perpetual_pricing_model_(std::move(model)), active_opportunities_(params.max_holding_period),
+      funding_horizon_(DEFAULT_FUNDING_HORIZON), round_trip_cost_(DEFAULT_ROUND_TRIP_COST),
+      next_curve_refresh_(Timestamp::max()) {}
+
+void SpotFundingSyntheticPerpetualEngine::update_market_data(const MarketSnapshot& snapshot) {
+    latest_snapshot_ = snapshot; // view copy, no market data is cloned
+    
+    // An opportunity that stays open is reported once, while its first report is live
+    for (const ArbitrageOpportunity& candidate : identify_spot_funding_opportunities(snapshot)) {
+        size_t pair = pair_index_[candidate.legs[1].instrument];
+        size_t direction = candidate.legs[0].side == market_data::Side::BID ? 0 : 1;
+        if (active_opportunities_.find(reported_[pair][direction]).valid()) {
+            continue;
+        }
+        
+        OpportunityHandle handle = active_opportunities_.insert(candidate);
+        reported_[pair][direction] = candidate.opportunity_id;
+        if (opportunity_callback_) {
+            opportunity_callback_(*active_opportunities_.get(handle));
+        }
     }
     
-    return opp;
+    active_opportunities_.expire(std::chrono::high_resolution_clock::now());
+    active_opportunities_.publish();
+}
+
+void SpotFundingSyntheticPerpetualEngine::process_mispricing(const MispricingOpportunity&) {
+    // Pairs are priced from the snapshot and their funding curves
 }
 
-double TriangularArbitrageEngine::calculate_triangular_profit(const std::vector<market_data::Quote>& quotes) {
-    // Simplified triangular arbitrage profit calculation
-    return 0.015; // 1.5% profit for demo
+std::vector<ArbitrageOpportunity> SpotFundingSyntheticPerpetualEngine::identify_opportunities() {
+    return identify_spot_funding_opportunities(latest_snapshot_);
+}
+
+bool SpotFundingSyntheticPerpetualEngine::validate_opportunity(ArbitrageOpportunity& opportunity) {
+    if (opportunity.legs.size() != 2 || opportunity.expected_profit <= 0.0) {
+        return false;
+    }
+    for (const auto& leg : opportunity.legs) {
+        if (leg.entry_price <= 0.0 || leg.size <= 0.0) {
+            return false;
+        }
+    }
+    // The edge is quoted per unit of spot notional
+    const ArbitrageLeg& spot = opportunity.legs[0];
+    if (opportunity.expected_profit < params_.min_profit_threshold * spot.entry_price * spot.size ||
+        opportunity.profit_probability < params_.confidence_threshold) {
+        return false;
+    }
+    opportunity.status = ArbitrageStatus::VALIDATED;
+    opportunity.validation_time = std::chrono::high_resolution_clock::now();
+    return true;
+}
+
+void SpotFundingSyntheticPerpetualEngine::set_opportunity_callback(ArbitrageCallback callback) {
+    opportunity_callback_ = callback;
+}
+
+void SpotFundingSyntheticPerpetualEngine::set_update_callback(ArbitrageUpdateCallback callback) {
+    update_callback_ = callback;
+}
+
+void SpotFundingSyntheticPerpetualEngine::update_parameters(const ArbitrageParameters& params) {
+    params_ = params;
+    active_opportunities_.set_max_holding_period(params_.max_holding_period);
+}
+
+std::vector<ArbitrageOpportunity> SpotFundingSyntheticPerpetualEngine::get_active_opportunities() const {
+    return active_opportunities_.copy_all();
+}
+
+void SpotFundingSyntheticPerpetualEngine::visit_active_opportunities(const OpportunityVisitor& visitor) const {
+    active_opportunities_.for_each(visitor);
+}
+
+void SpotFundingSyntheticPerpetualEngine::clear_opportunities() {
+    active_opportunities_.clear();
+    std::fill(reported_.begin(), reported_.end(),
+              std::array<OpportunityId, 2>{INVALID_OPPORTUNITY_ID, INVALID_OPPORTUNITY_ID});
+}
+
+void SpotFundingSyntheticPerpetualEngine::update_funding_rate(InstrumentHandle instrument, const FundingRate& rate) {
+    if (perpetual_pricing_model_) {
+        perpetual_pricing_model_->update_funding_rate(instrument, rate);
+    }
+    if (instrument >= pair_index_.size() || pair_index_[instrument] == UINT32_MAX) {
+        return;
+    }
+    size_t pair = pair_index_[instrument];
+    FundingCurve& curve = funding_curves_[pair];
+    curve.announced_rate = rate.rate;
+    curve.period = std::max(rate.frequency, std::chrono::hours(1));
+    curve.next_settlement = rate.timestamp;
+    refresh_funding_curve(pair, std::chrono::high_resolution_clock::now());
+}
+
+void SpotFundingSyntheticPerpetualEngine::update_mark_price(InstrumentHandle perpetual, Price mark_price,
+                                                            Price index_price) {
+    if (perpetual >= pair_index_.size() || pair_index_[perpetual] == UINT32_MAX || index_price <= 0.0) {
+        return;
+    }
+    size_t pair = pair_index_[perpetual];
+    FundingCurve& curve = funding_curves_[pair];
+    curve.premium = (mark_price - index_price) / index_price;
+    curve.has_premium = true;
+    refresh_funding_curve(pair, std::chrono::high_resolution_clock::now());
+}
+
+FundingRate SpotFundingSyntheticPerpetualEngine::get_current_funding_rate(InstrumentHandle instrument) const {
+    FundingRate rate;
+    rate.instrument = instrument;
+    const FundingCurve* curve = get_funding_curve(instrument);
+    if (curve) {
+        rate.rate = curve->announced_rate;
+        rate.timestamp = curve->next_settlement;
+        rate.frequency = curve->period;
+    }
+    return rate;
+}
+
+const SpotFundingSyntheticPerpetualEngine::FundingCurve* SpotFundingSyntheticPerpetualEngine::get_funding_curve(
+    InstrumentHandle perpetual) const {
+    if (perpetual >= pair_index_.size() || pair_index_[perpetual] == UINT32_MAX) {
+        return nullptr;
+    }
+    return &funding_curves_[pair_index_[perpetual]];
+}
+
+double SpotFundingSyntheticPerpetualEngine::calculate_expected_funding_pnl(
+    InstrumentHandle instrument, Volume position_size, std::chrono::hours holding_period) const {
+    const FundingCurve* curve = get_funding_curve(instrument);
+    if (!curve) {
+        return 0.0;
+    }
+    // A settlement that has passed since the curve was refreshed was the announced one
+    auto now = std::chrono::high_resolution_clock::now();
+    Timestamp next = curve->next_settlement;
+    bool rolled = roll_settlement(next, curve->period, now);
+    size_t count = settlements_within(next, curve->period, now, holding_period);
+    if (count == 0) {
+        return 0.0;
+    }
+    double first = rolled ? curve->predicted_rate : curve->announced_rate;
+    return position_size * (first + static_cast<double>(count - 1) * curve->predicted_rate);
+}
+
+void SpotFundingSyntheticPerpetualEngine::add_spot_perpetual_pair(InstrumentHandle spot, InstrumentHandle perpetual) {
+    if (spot == INVALID_INSTRUMENT || perpetual == INVALID_INSTRUMENT || spot == perpetual) {
+        return;
+    }
+    if (pair_index_.size() <= perpetual) {
+        pair_index_.resize(perpetual + 1, UINT32_MAX);
+    }
+    if (pair_index_[perpetual] != UINT32_MAX) {
+        pair_spots_[pair_index_[perpetual]] = spot; // one spot per perpetual
+        return;
+    }
+    
+    size_t pair = pair_spots_.size();
+    pair_index_[perpetual] = static_cast<uint32_t>(pair);
+    pair_spots_.push_back(spot);
+    pair_perpetuals_.push_back(perpetual);
+    funding_curves_.emplace_back();
+    reported_.push_back({INVALID_OPPORTUNITY_ID, INVALID_OPPORTUNITY_ID});
+    
+    // Columns grow a register at a time; padding lanes stay unquoted
+    size_t lanes = (pair / BASIS_LANE_BLOCK + 1) * BASIS_LANE_BLOCK;
+    if (lanes > carries_.size()) {
+        for (auto* column : {&spot_bids_, &spot_asks_, &perpetual_bids_, &perpetual_asks_, &carries_,
+                             &cash_and_carry_edges_, &reverse_edges_}) {
+            column->resize(lanes, 0.0);
+        }
+    }
+    refresh_funding_curve(pair, std::chrono::high_resolution_clock::now());
+}
+
+void SpotFundingSyntheticPerpetualEngine::set_funding_horizon(std::chrono::hours horizon) {
+    funding_horizon_ = horizon;
+    auto now = std::chrono::high_resolution_clock::now();
+    next_curve_refresh_ = Timestamp::max();
+    for (size_t pair = 0; pair < funding_curves_.size(); ++pair) {
+        refresh_funding_curve(pair, now);
+    }
+}
+
+void SpotFundingSyntheticPerpetualEngine::save_state(checkpoint::CheckpointWriter& out) const {
+    out.put_count(pair_spots_.size());
+    for (size_t pair = 0; pair < pair_spots_.size(); ++pair) {
+        const FundingCurve& curve = funding_curves_[pair];
+        out.put_instrument(pair_spots_[pair]);
+        out.put_instrument(pair_perpetuals_[pair]);
+        out.put(curve.announced_rate);
+        out.put(curve.predicted_rate);
+        out.put(curve.premium);
+        out.put(static_cast<uint8_t>(curve.has_premium));
+        out.put_time(curve.next_settlement);
+        out.put(static_cast<int64_t>(curve.period.count()));
+    }
+    active_opportunities_.save_state(out);
+}
+
+bool SpotFundingSyntheticPerpetualEngine::restore_state(checkpoint::SectionReader& in) {
+    // Carries are derived again, rolling past settlements paid while we were down
+    auto now = std::chrono::high_resolution_clock::now();
+    size_t count = 0;
+    in.get_count(count, 2 * sizeof(uint32_t) + 3 * sizeof(double) + 1 + 2 * sizeof(int64_t));
+    for (size_t i = 0; i < count && in.ok(); ++i) {
+        InstrumentHandle spot = INVALID_INSTRUMENT;
+        InstrumentHandle perpetual = INVALID_INSTRUMENT;
+        FundingCurve saved;
+        uint8_t has_premium = 0;
+        int64_t period = 0;
+        in.get_instrument(spot);
+        in.get_instrument(perpetual);
+        in.get(saved.announced_rate);
+        in.get(saved.predicted_rate);
+        in.get(saved.premium);
+        in.get(has_premium);
+        in.get_time(saved.next_settlement);
+        in.get(period);
+        if (!in.ok()) {
+            break;
+        }
+
+        add_spot_perpetual_pair(spot, perpetual);
+        if (perpetual >= pair_index_.size() || pair_index_[perpetual] == UINT32_MAX) {
+            continue;
+        }
+        size_t pair = pair_index_[perpetual];
+        FundingCurve& curve = funding_curves_[pair];
+        curve.announced_rate = saved.announced_rate;
+        curve.predicted_rate = saved.predicted_rate;
+        curve.premium = saved.premium;
+        curve.has_premium = has_premium != 0;
+        curve.next_settlement = saved.next_settlement;
+        curve.period = std::max(std::chrono::hours(period), std::chrono::hours(1));
+        if (perpetual_pricing_model_ && curve.next_settlement.time_since_epoch().count() != 0) {
+            FundingRate rate;
+            rate.instrument = perpetual;
+            rate.rate = curve.announced_rate;
+            rate.timestamp = curve.next_settlement;
+            rate.frequency = curve.period;
+            perpetual_pricing_model_->update_funding_rate(perpetual, rate);
+        }
+        refresh_funding_curve(pair, now);
+    }
+    if (!in.ok() || !active_opportunities_.restore_state(in, now)) {
+        return false;
+    }
+    
+    active_opportunities_.for_each([this](const ArbitrageOpportunity& opportunity) {
+        if (opportunity.type != ArbitrageType::SPOT_FUNDING_SYNTHETIC_PERPETUAL || opportunity.legs.size() != 2) {
+            return;
+        }
+        InstrumentHandle perpetual = opportunity.legs[1].instrument;
+        if (perpetual < pair_index_.size() && pair_index_[perpetual] != UINT32_MAX) {
+            size_t direction = opportunity.legs[0].side == market_data::Side::BID ? 0 : 1;
+            reported_[pair_index_[perpetual]][direction] = opportunity.opportunity_id;
+        }
+    });
+    return true;
+}
+
+// Private methods
+void SpotFundingSyntheticPerpetualEngine::refresh_funding_curve(size_t pair, Timestamp now) {
+    // Until a rate arrives, settlements fall on whole periods from the clock's epoch
+    FundingCurve& curve = funding_curves_[pair];
+    if (roll_settlement(curve.next_settlement, curve.period, now)) {
+        curve.announced_rate = curve.predicted_rate; // paid; the next rate is only predicted until announced
+    }
+    
+    // Under Binance and OKX rules the rate is the premium plus the clamped interest-premium gap
+    if (curve.has_premium) {
+        double scale = static_cast<double>(curve.period.count()) / 8.0;
+        double interest = DEFAULT_INTEREST_RATE * scale;
+        double clamp = PREMIUM_CLAMP * scale;
+        curve.predicted_rate = curve.premium + std::max(-clamp, std::min(clamp, interest - curve.premium));
+    } else {
+        curve.predicted_rate = curve.announced_rate;
+    }
+    
+    size_t count = settlements_within(curve.next_settlement, curve.period, now, funding_horizon_);
+    curve.announced_carry = count > 0 ? curve.announced_rate : 0.0;
+    curve.predicted_carry = count > 1 ? static_cast<double>(count - 1) * curve.predicted_rate : 0.0;
+    carries_[pair] = curve.announced_carry + curve.predicted_carry;
+    
+    // The count changes when the next settlement passes or the horizon reaches the one beyond it
+    Timestamp beyond = curve.next_settlement + static_cast<int>(count) * curve.period;
+    curve.valid_until = std::min(curve.next_settlement, beyond - funding_horizon_);
+    next_curve_refresh_ = std::min(next_curve_refresh_, curve.valid_until);
+}
+
+void SpotFundingSyntheticPerpetualEngine::refresh_due_curves(Timestamp now) {
+    if (now < next_curve_refresh_) {
+        return;
+    }
+    next_curve_refresh_ = Timestamp::max();
+    for (size_t pair = 0; pair < funding_curves_.size(); ++pair) {
+        if (funding_curves_[pair].valid_until <= now) {
+            refresh_funding_curve(pair, now);
+        } else {
+            next_curve_refresh_ = std::min(next_curve_refresh_, funding_curves_[pair].valid_until);
+        }
+    }
+}
+
+void SpotFundingSyntheticPerpetualEngine::scan_basis(const MarketSnapshot& snapshot) {
+    // Gather the pairs' touch into the columns, then both directions for every pair at once
+    size_t pairs = pair_spots_.size();
+    for (size_t i = 0; i < pairs; ++i) {
+        InstrumentHandle spot = pair_spots_[i];
+        InstrumentHandle perpetual = pair_perpetuals_[i];
+        bool quoted = snapshot.has_quote(spot) && snapshot.has_quote(perpetual);
+        spot_bids_[i] = quoted ? snapshot.bid_price(spot) : 0.0;
+        spot_asks_[i] = quoted ? snapshot.ask_price(spot) : 0.0;
+        perpetual_bids_[i] = quoted ? snapshot.bid_price(perpetual) : 0.0;
+        perpetual_asks_[i] = quoted ? snapshot.ask_price(perpetual) : 0.0;
+    }
+    
+    pricing::detail::BasisScanKernelArgs args;
+    args.lanes = carries_.size();
+    args.spot_bids = spot_bids_.data();
+    args.spot_asks = spot_asks_.data();
+    args.perpetual_bids = perpetual_bids_.data();
+    args.perpetual_asks = perpetual_asks_.data();
+    args.carries = carries_.data();
+    args.cost = round_trip_cost_;
+    args.cash_and_carry_edges = cash_and_carry_edges_.data();
+    args.reverse_edges = reverse_edges_.data();
+    scan_basis_simd(args);
+}
+
+std::vector<ArbitrageOpportunity> SpotFundingSyntheticPerpetualEngine::identify_spot_funding_opportunities(
+    const MarketSnapshot& snapshot) {
+    std::vector<ArbitrageOpportunity> opportunities;
+    if (pair_spots_.empty()) {
+        return opportunities;
+    }
+    refresh_due_curves(std::chrono::high_resolution_clock::now());
+    scan_basis(snapshot);
+    
+    // Only the few pairs past the threshold are built out
+    for (size_t pair = 0; pair < pair_spots_.size(); ++pair) {
+        for (bool cash_and_carry : {true, false}) {
+            double edge = cash_and_carry ? cash_and_carry_edges_[pair] : reverse_edges_[pair];
+            if (edge <= params_.min_profit_threshold) {
+                continue;
+            }
+            ArbitrageOpportunity opportunity;
+            if (create_synthetic_perpetual_opportunity(pair, cash_and_carry, edge, snapshot, opportunity)) {
+                opportunities.push_back(std::move(opportunity));
+            }
+        }
+    }
+    return opportunities;
+}
+
+bool SpotFundingSyntheticPerpetualEngine::create_synthetic_perpetual_opportunity(
+    size_t pair, bool cash_and_carry, double edge, const MarketSnapshot& snapshot,
+    ArbitrageOpportunity& opportunity) {
+    InstrumentHandle spot = pair_spots_[pair];
+    InstrumentHandle perpetual = pair_perpetuals_[pair];
+    const FundingCurve& curve = funding_curves_[pair];
+    Price spot_price = cash_and_carry ? snapshot.ask_price(spot) : snapshot.bid_price(spot);
+    Price perpetual_price = cash_and_carry ? snapshot.bid_price(perpetual) : snapshot.ask_price(perpetual);
+    Volume size = std::min(cash_and_carry ? snapshot.ask_size(spot) : snapshot.bid_size(spot),
+                           cash_and_carry ? snapshot.bid_size(perpetual) : snapshot.ask_size(perpetual));
+    size = std::min(size, params_.max_position_size / spot_price);
+    if (size <= 0.0) {
+        return false;
+    }
+    
+    // The basis and the announced rate are known; the settlements after it are a prediction,
+    // so confidence falls from 1 towards 0.5 as they make up more of the edge
+    double basis = cash_and_carry ? (perpetual_price - spot_price) / spot_price
+                                  : (spot_price - perpetual_price) / perpetual_price;
+    double known = basis + (cash_and_carry ? curve.announced_carry : -curve.announced_carry) - round_trip_cost_;
+    double confidence = 0.5 + 0.5 * std::max(0.0, std::min(1.0, known / edge));
+    
+    Price fair_value = calculate_synthetic_perpetual_fair_value(pair, snapshot);
+    Price perpetual_mid = snapshot.mid_price(perpetual);
+    double notional = spot_price * size;
+    
+    opportunity.opportunity_id = next_opportunity_id();
+    opportunity.type = ArbitrageType::SPOT_FUNDING_SYNTHETIC_PERPETUAL;
+    opportunity.status = ArbitrageStatus::IDENTIFIED;
+    opportunity.identification_time = std::chrono::high_resolution_clock::now();
+    opportunity.expiry_time = opportunity.identification_time + params_.max_holding_period;
+    opportunity.legs = construct_spot_funding_legs(pair, cash_and_carry, snapshot, size);
+    opportunity.expected_profit = edge * notional;
+    opportunity.total_cost = notional + perpetual_price * size;
+    opportunity.total_volume = 2.0 * size;
+    opportunity.profit_probability = confidence;
+    opportunity.break_even_price = fair_value;
+    opportunity.net_exposure = (cash_and_carry ? 1.0 : -1.0) * (spot_price - perpetual_price) * size;
+    
+    MispricingOpportunity& source = opportunity.mispricing_source;
+    source = MispricingOpportunity();
+    source.target_instrument = perpetual;
+    source.component_instruments.push_back(spot);
+    source.weights.push_back(1.0);
+    source.type = mispricing::MispricingType::SPOT_VS_SYNTHETIC_DERIVATIVE;
+    source.market_price = perpetual_mid;
+    source.theoretical_price = fair_value;
+    source.deviation_percentage = fair_value > 0.0 ? (perpetual_mid - fair_value) / fair_value : 0.0;
+    source.confidence_level = confidence;
+    source.expected_profit = opportunity.expected_profit;
+    source.expiry_time = opportunity.expiry_time;
+    return validate_opportunity(opportunity);
+}
+
+double SpotFundingSyntheticPerpetualEngine::calculate_synthetic_perpetual_fair_value(
+    size_t pair, const MarketSnapshot& snapshot) const {
+    // Where a short perpetual against spot earns nothing over the horizon: the basis it gives
+    // up matches the funding it collects
+    const FundingCurve& curve = funding_curves_[pair];
+    return snapshot.mid_price(pair_spots_[pair]) * (1.0 - curve.announced_carry - curve.predicted_carry);
+}
+
+LegVector SpotFundingSyntheticPerpetualEngine::construct_spot_funding_legs(
+    size_t pair, bool cash_and_carry, const MarketSnapshot& snapshot, Volume size) const {
+    // BID legs buy at the ask, ASK legs sell at the bid; spot first, the perpetual against it
+    auto now = std::chrono::high_resolution_clock::now();
+    InstrumentHandle spot = pair_spots_[pair];
+    InstrumentHandle perpetual = pair_perpetuals_[pair];
+    LegVector legs;
+    
+    ArbitrageLeg spot_leg(spot, cash_and_carry ? market_data::Side::BID : market_data::Side::ASK, size,
+                          cash_and_carry ? snapshot.ask_price(spot) : snapshot.bid_price(spot),
+                          cash_and_carry ? 1.0 : -1.0);
+    spot_leg.entry_time = now;
+    legs.push_back(spot_leg);
+    
+    ArbitrageLeg perpetual_leg(perpetual, cash_and_carry ? market_data::Side::ASK : market_data::Side::BID, size,
+                               cash_and_carry ? snapshot.bid_price(perpetual) : snapshot.ask_price(perpetual),
+                               cash_and_carry ? -1.0 : 1.0);
+    perpetual_leg.entry_time = now;
+    legs.push_back(perpetual_leg);
+    return legs;
+}
+
+// CrossExchangeSyntheticReplicationEngine implementation
+CrossExchangeSyntheticReplicationEngine::CrossExchangeSyntheticReplicationEngine(
+    std::unique_ptr<IPricingModel> model, const ArbitrageParameters& params)
+    : params_(params), pricing_model_(std::move(model)), active_opportunities_(params.max_holding_period),
+      price_matrix_(std::make_shared<VenuePriceMatrix>()) {}
+
+void CrossExchangeSyntheticReplicationEngine::update_market_data(const MarketSnapshot&) {
+    // An opportunity that stays open is reported once, while its first report is live
+    for (const ArbitrageOpportunity& candidate : identify_cross_exchange_synthetic_opportunities()) {
+        InstrumentHandle target = candidate.legs[0].instrument;
+        size_t direction = candidate.legs[0].side == market_data::Side::ASK ? 0 : 1;
+        if (reported_.size() <= target) {
+            reported_.resize(target + 1, {INVALID_OPPORTUNITY_ID, INVALID_OPPORTUNITY_ID});
+        }
+        if (active_opportunities_.find(reported_[target][direction]).valid()) {
+            continue;
+        }
+        
+        OpportunityHandle handle = active_opportunities_.insert(candidate);
+        reported_[target][direction] = candidate.opportunity_id;
+        if (opportunity_callback_) {
+            opportunity_callback_(*active_opportunities_.get(handle));
+        }
+    }
+    
+    active_opportunities_.expire(std::chrono::high_resolution_clock::now());
+    active_opportunities_.publish();
+}
+
+void CrossExchangeSyntheticReplicationEngine::process_mispricing(const MispricingOpportunity&) {
+    // Single-venue mispricings carry no venue; this engine works from the venue matrix
+}
+
+std::vector<ArbitrageOpportunity> CrossExchangeSyntheticReplicationEngine::identify_opportunities() {
+    return identify_cross_exchange_synthetic_opportunities();
+}
+
+bool CrossExchangeSyntheticReplicationEngine::validate_opportunity(ArbitrageOpportunity& opportunity) {
+    if (!validate_cross_exchange_execution(opportunity)) {
+        return false;
+    }
+    opportunity.status = ArbitrageStatus::VALIDATED;
+    opportunity.validation_time = std::chrono::high_resolution_clock::now();
+    return true;
+}
+
+void CrossExchangeSyntheticReplicationEngine::set_opportunity_callback(ArbitrageCallback callback) {
+    opportunity_callback_ = callback;
+}
+
+void CrossExchangeSyntheticReplicationEngine::set_update_callback(ArbitrageUpdateCallback callback) {
+    update_callback_ = callback;
+}
+
+void CrossExchangeSyntheticReplicationEngine::update_parameters(const ArbitrageParameters& params) {
+    params_ = params;
+    active_opportunities_.set_max_holding_period(params_.max_holding_period);
+}
+
+std::vector<ArbitrageOpportunity> CrossExchangeSyntheticReplicationEngine::get_active_opportunities() const {
+    return active_opportunities_.copy_all();
+}
+
+void CrossExchangeSyntheticReplicationEngine::visit_active_opportunities(const OpportunityVisitor& visitor) const {
+    active_opportunities_.for_each(visitor);
+}
+
+void CrossExchangeSyntheticReplicationEngine::clear_opportunities() {
+    active_opportunities_.clear();
+    reported_.clear();
+}
+
+void CrossExchangeSyntheticReplicationEngine::register_exchange(const std::string& exchange_id,
+                                                                double transaction_cost, double latency_ms) {
+    price_matrix_->add_venue(exchange_id, transaction_cost, latency_ms);
+}
+
+void CrossExchangeSyntheticReplicationEngine::update_exchange_snapshot(const std::string& exchange_id,
+                                                                       const MarketSnapshot& snapshot) {
+    // Unregistered venues join with no costs until register_exchange() sets them
+    VenueIndex venue = price_matrix_->venue_index(exchange_id);
+    if (venue == INVALID_VENUE) {
+        venue = price_matrix_->add_venue(exchange_id, 0.0, 0.0);
+    }
+    price_matrix_->apply_snapshot(venue, snapshot);
+}
+
+void CrossExchangeSyntheticReplicationEngine::add_instrument_to_exchange(InstrumentHandle instrument,
+                                                                         const std::string& exchange_id) {
+    auto& exchanges = instrument_exchange_mapping_[instrument];
+    if (std::find(exchanges.begin(), exchanges.end(), exchange_id) == exchanges.end()) {
+        exchanges.push_back(exchange_id);
+    }
+}
+
+std::vector<std::string> CrossExchangeSyntheticReplicationEngine::get_available_exchanges_for_instrument(
+    InstrumentHandle instrument) const {
+    // Listed venues, plus any venue currently quoting the instrument
+    std::vector<std::string> exchanges;
+    auto it = instrument_exchange_mapping_.find(instrument);
+    if (it != instrument_exchange_mapping_.end()) {
+        exchanges = it->second;
+    }
+    for (VenueIndex venue = 0; venue < price_matrix_->venue_count(); ++venue) {
+        const std::string& id = price_matrix_->venue_id(venue);
+        if (price_matrix_->has_quote(venue, instrument) &&
+            std::find(exchanges.begin(), exchanges.end(), id) == exchanges.end()) {
+            exchanges.push_back(id);
+        }
+    }
+    return exchanges;
+}
+
+void CrossExchangeSyntheticReplicationEngine::set_synthetic_components(InstrumentHandle target,
+                                                                       const std::vector<InstrumentHandle>& components) {
+    price_matrix_->set_components(target, components);
+}
+
+SyntheticPrice CrossExchangeSyntheticReplicationEngine::get_best_synthetic_replication(
+    InstrumentHandle instrument, const std::string& exclude_exchange) const {
+    refresh_synthetic_prices();
+    VenueIndex exclude = exclude_exchange.empty() ? INVALID_VENUE : price_matrix_->venue_index(exclude_exchange);
+    VenueBest best = price_matrix_->best(VenuePriceSource::SYNTHETIC, instrument, exclude);
+    if (!price_matrix_->is_target(instrument)) {
+        best = price_matrix_->best(VenuePriceSource::QUOTES, instrument, exclude);
+    }
+    if (best.ask_venue == INVALID_VENUE) {
+        return SyntheticPrice();
+    }
+    return price_matrix_->replication(VenuePriceSource::SYNTHETIC, best.ask_venue, instrument);
+}
+
+void CrossExchangeSyntheticReplicationEngine::set_price_matrix(std::shared_ptr<VenuePriceMatrix> matrix) {
+    price_matrix_ = std::move(matrix);
+    reported_.clear();
+}
+
+// Private methods
+void CrossExchangeSyntheticReplicationEngine::refresh_synthetic_prices() const {
+    // Only targets whose component quotes moved on a venue are repriced there
+    VenuePriceMatrix& matrix = *price_matrix_;
+    matrix.refresh_synthetics([this, &matrix](VenueIndex venue, InstrumentHandle target,
+                                              const std::vector<InstrumentHandle>& components) {
+        return pricing_model_->calculate_synthetic_price(target, components, matrix.snapshot(venue));
+    });
+}
+
+std::vector<ArbitrageOpportunity> CrossExchangeSyntheticReplicationEngine::identify_cross_exchange_synthetic_opportunities() {
+    std::vector<ArbitrageOpportunity> opportunities;
+    VenuePriceMatrix& matrix = *price_matrix_;
+    if (matrix.venue_count() < 2) {
+        return opportunities;
+    }
+    refresh_synthetic_prices();
+    
+    // Best effective venues for every instrument in one pass per source
+    const VenueScan& quotes = matrix.scan(VenuePriceSource::QUOTES);
+    const VenueScan& synthetics = matrix.scan(VenuePriceSource::SYNTHETIC);
+    double hurdle = 1.0 + params_.min_profit_threshold;
+    
+    // Buy on one venue and sell on another; when the best venues coincide, the best other one
+    auto consider = [&](InstrumentHandle instrument, VenueIndex buy_venue, Price buy, VenuePriceSource sell_source, VenueIndex sell_venue, Price sell, bool sell_target) {
+        if (buy_venue == INVALID_VENUE || sell_venue == INVALID_VENUE) {
+            return;
+        }
+        if (buy_venue == sell_venue) {
+            VenueBest other = matrix.best(sell_source, instrument, buy_venue);
+            sell_venue = other.bid_venue;
+            sell = other.bid;
+            if (sell_venue == INVALID_VENUE) {
+                return;
+            }
+        }
+        if (sell <= buy * hurdle) {
+            return;
+        }
+        
+        VenueIndex target_venue = sell_target ? sell_venue : buy_venue;
+        VenueIndex replication_venue = sell_target ? buy_venue : sell_venue;
+        ArbitrageOpportunity opportunity;
+        if (create_cross_exchange_replication_opportunity(instrument, target_venue, replication_venue,
+                                                          sell_target, opportunity) &&
+            validate_opportunity(opportunity)) {
+            opportunities.push_back(std::move(opportunity));
+        }
+    };
+    
+    for (InstrumentHandle instrument = 0; instrument < quotes.size(); ++instrument) {
+        VenueBest direct = quotes.at(instrument);
+        if (!matrix.is_target(instrument)) {
+            // Without components the replica is the instrument itself on another venue
+            consider(instrument, direct.ask_venue, direct.ask, VenuePriceSource::QUOTES,
+                     direct.bid_venue, direct.bid, true);
+            continue;
+        }
+        VenueBest replica = synthetics.at(instrument);
+        consider(instrument, replica.ask_venue, replica.ask, VenuePriceSource::QUOTES,
+                 direct.bid_venue, direct.bid, true);
+        consider(instrument, direct.ask_venue, direct.ask, VenuePriceSource::SYNTHETIC,
+                 replica.bid_venue, replica.bid, false);
+    }
+    return opportunities;
+}
+
+bool CrossExchangeSyntheticReplicationEngine::create_cross_exchange_replication_opportunity(
+    InstrumentHandle target_instrument, VenueIndex target_exchange, VenueIndex replication_exchange,
+    bool sell_target, ArbitrageOpportunity& opportunity) const {
+    const VenuePriceMatrix& matrix = *price_matrix_;
+    SyntheticPrice target_price = matrix.replication(VenuePriceSource::QUOTES, target_exchange, target_instrument);
+    SyntheticPrice replica = matrix.replication(VenuePriceSource::SYNTHETIC, replication_exchange, target_instrument);
+    if (target_price.theoretical_price <= 0.0 || replica.theoretical_price <= 0.0) {
+        return false;
+    }
+    
+    // Size is the depth at the top of both books, capped by the position limit
+    Volume size = std::min(
+        matrix.available_size(VenuePriceSource::QUOTES, target_exchange, target_instrument, !sell_target),
+        matrix.available_size(VenuePriceSource::SYNTHETIC, replication_exchange, target_instrument, sell_target));
+    size = std::min(size, params_.max_position_size / target_price.theoretical_price);
+    double profit_per_unit = calculate_cross_exchange_arbitrage_profit(target_price, replica,
+                                                                       target_exchange, replication_exchange);
+    if (size <= 0.0 || profit_per_unit <= 0.0) {
+        return false;
+    }
+    
+    if (opportunity.opportunity_id == INVALID_OPPORTUNITY_ID) {
+        opportunity.opportunity_id = next_opportunity_id();
+    }
+    opportunity.type = ArbitrageType::CROSS_EXCHANGE_SYNTHETIC_REPLICATION;
+    opportunity.status = ArbitrageStatus::IDENTIFIED;
+    opportunity.identification_time = std::chrono::high_resolution_clock::now();
+    opportunity.expiry_time = opportunity.identification_time + params_.max_holding_period;
+    opportunity.legs = construct_cross_exchange_legs(target_instrument, target_exchange, replica.component_instruments,
+                                                     replication_exchange, replica.weights, sell_target, size);
+    
+    Price buy_price = sell_target ? replica.ask_price : target_price.ask_price;
+    Price sell_price = sell_target ? target_price.bid_price : replica.bid_price;
+    opportunity.expected_profit = profit_per_unit * size;
+    opportunity.total_cost = buy_price * size;
+    opportunity.transaction_costs = (matrix.transaction_cost(target_exchange) * target_price.theoretical_price +
+                                     matrix.transaction_cost(replication_exchange) * replica.theoretical_price) * size;
+    opportunity.profit_probability = replica.confidence_score;
+    opportunity.break_even_price = sell_target ? matrix.effective_ask(replication_exchange, replica.ask_price)
+                                               : matrix.effective_bid(replication_exchange, replica.bid_price);
+    opportunity.slippage_estimate = estimate_cross_exchange_latency_risk(target_exchange, replication_exchange);
+    opportunity.estimated_duration = std::chrono::milliseconds(static_cast<int64_t>(
+        std::ceil(matrix.latency_ms(target_exchange) + matrix.latency_ms(replication_exchange))));
+    opportunity.net_exposure = 0.0; // the replica offsets the target
+    
+    Volume total_volume = 0.0;
+    for (const auto& leg : opportunity.legs) {
+        total_volume += leg.size;
+    }
+    opportunity.total_volume = total_volume;
+    
+    MispricingOpportunity& source = opportunity.mispricing_source;
+    source = MispricingOpportunity();
+    source.target_instrument = target_instrument;
+    for (size_t k = 0; k < replica.component_instruments.size(); ++k) {
+        source.component_instruments.push_back(replica.component_instruments[k]);
+        source.weights.push_back(k < replica.weights.size() ? replica.weights[k] : 1.0);
+    }
+    source.type = mispricing::MispricingType::CROSS_EXCHANGE_ARBITRAGE;
+    source.market_price = target_price.theoretical_price;
+    source.theoretical_price = replica.theoretical_price;
+    source.deviation_percentage = (sell_price - buy_price) / replica.theoretical_price;
+    source.confidence_level = replica.confidence_score;
+    source.expected_profit = opportunity.expected_profit;
+    source.expiry_time = opportunity.expiry_time;
+    return true;
+}
+
+double CrossExchangeSyntheticReplicationEngine::calculate_cross_exchange_arbitrage_profit(
+    const SyntheticPrice& target_price, const SyntheticPrice& synthetic_price,
+    VenueIndex target_exchange, VenueIndex synthetic_exchange) const {
+    // Per unit, in the better direction, after each venue's fee and latency cost
+    const VenuePriceMatrix& matrix = *price_matrix_;
+    double sell_target = matrix.effective_bid(target_exchange, target_price.bid_price) -
+                         matrix.effective_ask(synthetic_exchange, synthetic_price.ask_price);
+    double buy_target = matrix.effective_bid(synthetic_exchange, synthetic_price.bid_price) -
+                        matrix.effective_ask(target_exchange, target_price.ask_price);
+    return std::max(sell_target, buy_target);
+}
+
+LegVector CrossExchangeSyntheticReplicationEngine::construct_cross_exchange_legs(
+    InstrumentHandle target_instrument, VenueIndex target_exchange,
+    const std::vector<InstrumentHandle>& synthetic_components, VenueIndex synthetic_exchange,
+    const std::vector<double>& weights, bool sell_target, Volume size) const {
+    // BID legs buy at the ask, ASK legs sell at the bid; the replica trades against the target
+    const VenuePriceMatrix& matrix = *price_matrix_;
+    auto now = std::chrono::high_resolution_clock::now();
+    LegVector legs;
+    
+    ArbitrageLeg target_leg(target_instrument, sell_target ? market_data::Side::ASK : market_data::Side::BID, size,
+                            sell_target ? matrix.bid(target_exchange, target_instrument)
+                                        : matrix.ask(target_exchange, target_instrument),
+                            sell_target ? -1.0 : 1.0);
+    target_leg.entry_time = now;
+    legs.push_back(target_leg);
+    
+    for (size_t k = 0; k < synthetic_components.size(); ++k) {
+        InstrumentHandle component = synthetic_components[k];
+        double weight = k < weights.size() ? weights[k] : 1.0;
+        if (weight == 0.0) {
+            continue;
+        }
+        bool buy = (weight > 0.0) == sell_target;
+        ArbitrageLeg leg(component, buy ? market_data::Side::BID : market_data::Side::ASK, size * std::abs(weight),
+                         buy ? matrix.ask(synthetic_exchange, component) : matrix.bid(synthetic_exchange, component),
+                         buy ? std::abs(weight) : -std::abs(weight));
+        leg.entry_time = now;
+        legs.push_back(leg);
+    }
+    return legs;
+}
+
+bool CrossExchangeSyntheticReplicationEngine::validate_cross_exchange_execution(
+    const ArbitrageOpportunity& opportunity) const {
+    if (opportunity.legs.size() < 2 || opportunity.expected_profit <= 0.0 || opportunity.total_cost <= 0.0) {
+        return false;
+    }
+    for (const auto& leg : opportunity.legs) {
+        if (leg.entry_price <= 0.0 || leg.size <= 0.0) {
+            return false;
+        }
+    }
+    
+    // The edge must clear the threshold, and the price risk of the venues' latency must fit
+    // the slippage budget
+    if (opportunity.expected_profit < params_.min_profit_threshold * opportunity.total_cost) {
+        return false;
+    }
+    return opportunity.slippage_estimate <= params_.max_slippage;
+}
+
+double CrossExchangeSyntheticReplicationEngine::estimate_cross_exchange_latency_risk(
+    VenueIndex exchange1, VenueIndex exchange2) const {
+    // Fraction of price the quotes can move while both legs are in flight
+    const VenuePriceMatrix& matrix = *price_matrix_;
+    return (matrix.latency_ms(exchange1) + matrix.latency_ms(exchange2)) * matrix.latency_cost_per_ms();
+}
+
+// MultiInstrumentSyntheticCombinationsEngine implementation
+MultiInstrumentSyntheticCombinationsEngine::MultiInstrumentSyntheticCombinationsEngine(
+    std::unique_ptr<BasketPricingModel> model, const ArbitrageParameters& params)
+    : params_(params), basket_pricing_model_(std::move(model)), active_opportunities_(params.max_holding_period),
+      max_cluster_size_(DEFAULT_MAX_CLUSTER_SIZE), min_cluster_correlation_(DEFAULT_MIN_CLUSTER_CORRELATION),
+      update_count_(0), execution_mode_(concurrency::ExecutionMode::SEQUENTIAL) {}
+
+void MultiInstrumentSyntheticCombinationsEngine::update_market_data(const MarketSnapshot& snapshot) {
+    latest_snapshot_ = snapshot; // view copy, no market data is cloned
+    
+    // Each refit touches only its own combination and cluster
+    concurrency::run_tasks(execution_mode_, pool_.get(), dynamic_combinations_.size(), [&](size_t i) {
+        rebalance_dynamic_combination(*dynamic_combinations_[i], snapshot);
+    });
+    ++update_count_;
+    
+    // An opportunity that stays open is reported once, while its first report is live
+    for (const ArbitrageOpportunity& candidate : identify_multi_instrument_opportunities(snapshot)) {
+        InstrumentHandle target = candidate.legs[0].instrument;
+        size_t direction = candidate.legs[0].side == market_data::Side::ASK ? 0 : 1;
+        if (reported_.size() <= target) {
+            reported_.resize(target + 1, {INVALID_OPPORTUNITY_ID, INVALID_OPPORTUNITY_ID});
+        }
+        if (active_opportunities_.find(reported_[target][direction]).valid()) {
+            continue;
+        }
+        
+        OpportunityHandle handle = active_opportunities_.insert(candidate);
+        reported_[target][direction] = candidate.opportunity_id;
+        if (opportunity_callback_) {
+            opportunity_callback_(*active_opportunities_.get(handle));
+        }
+    }
+    
+    active_opportunities_.expire(std::chrono::high_resolution_clock::now());
+    active_opportunities_.publish();
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::process_mispricing(const MispricingOpportunity&) {
+    // Combinations are priced from the snapshot; a single-target mispricing adds nothing here
+}
+
+std::vector<ArbitrageOpportunity> MultiInstrumentSyntheticCombinationsEngine::identify_opportunities() {
+    return identify_multi_instrument_opportunities(latest_snapshot_);
+}
+
+bool MultiInstrumentSyntheticCombinationsEngine::validate_opportunity(ArbitrageOpportunity& opportunity) {
+    if (opportunity.legs.size() < 2 || opportunity.expected_profit <= 0.0 || opportunity.total_cost <= 0.0) {
+        return false;
+    }
+    for (const auto& leg : opportunity.legs) {
+        if (leg.entry_price <= 0.0 || leg.size <= 0.0) {
+            return false;
+        }
+    }
+    if (opportunity.expected_profit < params_.min_profit_threshold * opportunity.total_cost ||
+        opportunity.profit_probability < params_.confidence_threshold) {
+        return false;
+    }
+    opportunity.status = ArbitrageStatus::VALIDATED;
+    opportunity.validation_time = std::chrono::high_resolution_clock::now();
+    return true;
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::set_opportunity_callback(ArbitrageCallback callback) {
+    opportunity_callback_ = callback;
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::set_update_callback(ArbitrageUpdateCallback callback) {
+    update_callback_ = callback;
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::update_parameters(const ArbitrageParameters& params) {
+    params_ = params;
+    active_opportunities_.set_max_holding_period(params_.max_holding_period);
+}
+
+std::vector<ArbitrageOpportunity> MultiInstrumentSyntheticCombinationsEngine::get_active_opportunities() const {
+    return active_opportunities_.copy_all();
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::clear_opportunities() {
+    active_opportunities_.clear();
+    reported_.clear();
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::visit_active_opportunities(const OpportunityVisitor& visitor) const {
+    active_opportunities_.for_each(visitor);
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::add_predefined_combination(
+    const std::string& name, const std::vector<InstrumentHandle>& instruments, const std::vector<double>& weights,
+    InstrumentHandle target_instrument) {
+    if (instruments.empty() || instruments.size() != weights.size()) {
+        return;
+    }
+    remove_predefined_combination(name);
+    predefined_combinations_[name] = instruments;
+    combination_weights_[name] = weights;
+    if (target_instrument != INVALID_INSTRUMENT) {
+        combination_targets_[name] = target_instrument;
+        instrument_combination_mapping_[target_instrument].push_back(name);
+    }
+    for (auto instrument : instruments) {
+        auto& names = instrument_combination_mapping_[instrument];
+        if (std::find(names.begin(), names.end(), name) == names.end()) {
+            names.push_back(name);
+        }
+    }
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::remove_predefined_combination(const std::string& name) {
+    auto it = predefined_combinations_.find(name);
+    if (it == predefined_combinations_.end()) {
+        return;
+    }
+    std::vector<InstrumentHandle> members = it->second;
+    auto target = combination_targets_.find(name);
+    if (target != combination_targets_.end()) {
+        members.push_back(target->second);
+        combination_targets_.erase(target);
+    }
+    for (auto instrument : members) {
+        auto mapping = instrument_combination_mapping_.find(instrument);
+        if (mapping == instrument_combination_mapping_.end()) {
+            continue;
+        }
+        auto& names = mapping->second;
+        names.erase(std::remove(names.begin(), names.end(), name), names.end());
+        if (names.empty()) {
+            instrument_combination_mapping_.erase(mapping);
+        }
+    }
+    predefined_combinations_.erase(it);
+    combination_weights_.erase(name);
+}
+
+std::vector<std::string> MultiInstrumentSyntheticCombinationsEngine::get_available_combinations_for_instrument(
+    InstrumentHandle instrument) const {
+    auto it = instrument_combination_mapping_.find(instrument);
+    return it != instrument_combination_mapping_.end() ? it->second : std::vector<std::string>();
+}
+
+std::vector<InstrumentHandle> MultiInstrumentSyntheticCombinationsEngine::get_highly_correlated_instruments(
+    InstrumentHandle target_instrument, double min_correlation) const {
+    // Most correlated first, by magnitude: a short hedge replicates as well as a long one
+    std::vector<std::pair<double, InstrumentHandle>> ranked;
+    const auto& matrix = correlation_matrix_;
+    if (!matrix || !matrix->contains(target_instrument)) {
+        return {};
+    }
+    for (InstrumentHandle instrument = 0; instrument < matrix->dimension(); ++instrument) {
+        if (instrument == target_instrument) {
+            continue;
+        }
+        double correlation = std::abs(matrix->correlation(target_instrument, instrument));
+        if (correlation >= min_correlation) {
+            ranked.emplace_back(correlation, instrument);
+        }
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    
+    std::vector<InstrumentHandle> instruments;
+    instruments.reserve(ranked.size());
+    for (const auto& entry : ranked) {
+        instruments.push_back(entry.second);
+    }
+    return instruments;
+}
+
+double MultiInstrumentSyntheticCombinationsEngine::calculate_combination_efficiency(
+    const std::vector<InstrumentHandle>& instruments, const std::vector<double>& weights,
+    InstrumentHandle target_instrument) const {
+    // Share of the target's price variance the combination replicates (R squared)
+    const auto& matrix = correlation_matrix_;
+    const MarketSnapshot& snapshot = latest_snapshot_;
+    if (!matrix || !matrix->contains(target_instrument) || !snapshot.has_quote(target_instrument) ||
+        instruments.size() != weights.size()) {
+        return 0.0;
+    }
+    std::vector<double> exposures(instruments.size());
+    for (size_t i = 0; i < instruments.size(); ++i) {
+        if (!matrix->contains(instruments[i]) || !snapshot.has_quote(instruments[i])) {
+            return 0.0;
+        }
+        exposures[i] = weights[i] * snapshot.mid_price(instruments[i]);
+    }
+    
+    Price target_price = snapshot.mid_price(target_instrument);
+    double target_variance = target_price * target_price * matrix->variance(target_instrument);
+    if (target_variance <= 0.0) {
+        return 0.0;
+    }
+    linalg::DenseMatrix covariance;
+    std::vector<double> cross;
+    linalg::gather_covariance(*matrix, instruments, covariance);
+    linalg::gather_cross_covariance(*matrix, instruments, target_instrument, cross);
+    double residual = target_variance - 2.0 * target_price * linalg::dot(exposures.data(), cross.data(), cross.size()) +
+                      linalg::quadratic_form(covariance, exposures.data());
+    return std::max(0.0, 1.0 - std::max(0.0, residual) / target_variance);
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::add_dynamic_target(InstrumentHandle target_instrument,
+                                                                    size_t max_instruments) {
+    if (dynamic_index_.size() <= target_instrument) {
+        dynamic_index_.resize(target_instrument + 1, UINT32_MAX);
+    }
+    if (dynamic_index_[target_instrument] == UINT32_MAX) {
+        dynamic_index_[target_instrument] = static_cast<uint32_t>(dynamic_combinations_.size());
+        dynamic_combinations_.push_back(std::make_unique<DynamicCombination>());
+        dynamic_combinations_.back()->target = target_instrument;
+        correlation_clusters_[target_instrument].clear();
+    }
+    dynamic_combinations_[dynamic_index_[target_instrument]]->max_instruments = std::max<size_t>(1, max_instruments);
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::remove_dynamic_target(InstrumentHandle target_instrument) {
+    if (target_instrument >= dynamic_index_.size() || dynamic_index_[target_instrument] == UINT32_MAX) {
+        return;
+    }
+    uint32_t index = dynamic_index_[target_instrument];
+    dynamic_index_[target_instrument] = UINT32_MAX;
+    if (index + 1 != dynamic_combinations_.size()) {
+        dynamic_combinations_[index] = std::move(dynamic_combinations_.back());
+        dynamic_index_[dynamic_combinations_[index]->target] = index;
+    }
+    dynamic_combinations_.pop_back();
+    correlation_clusters_.erase(target_instrument);
+}
+
+const MultiInstrumentSyntheticCombinationsEngine::CombinationFit*
+MultiInstrumentSyntheticCombinationsEngine::get_dynamic_combination(InstrumentHandle target_instrument) const {
+    if (target_instrument >= dynamic_index_.size() || dynamic_index_[target_instrument] == UINT32_MAX) {
+        return nullptr;
+    }
+    return &dynamic_combinations_[dynamic_index_[target_instrument]]->fit;
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::set_cluster_limits(size_t max_size, double min_correlation) {
+    max_cluster_size_ = std::max<size_t>(1, max_size);
+    min_cluster_correlation_ = min_correlation;
+    for (auto& entry : correlation_clusters_) {
+        entry.second.clear(); // rebuilt on the next update
+    }
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::set_execution_mode(
+    concurrency::ExecutionMode mode, std::shared_ptr<concurrency::WorkStealingPool> pool) {
+    execution_mode_ = mode;
+    pool_ = std::move(pool);
+}
+
+// Private methods
+std::vector<ArbitrageOpportunity> MultiInstrumentSyntheticCombinationsEngine::identify_multi_instrument_opportunities(
+    const MarketSnapshot& snapshot) {
+    std::vector<ArbitrageOpportunity> opportunities;
+    for (const auto& [name, target] : combination_targets_) {
+        ArbitrageOpportunity opportunity;
+        if (create_multi_instrument_synthetic_opportunity(name, target, snapshot, opportunity)) {
+            opportunities.push_back(std::move(opportunity));
+        }
+    }
+    for (const auto& combination : dynamic_combinations_) {
+        ArbitrageOpportunity opportunity;
+        if (generate_dynamic_combinations(*combination, snapshot, opportunity)) {
+            opportunities.push_back(std::move(opportunity));
+        }
+    }
+    return opportunities;
+}
+
+bool MultiInstrumentSyntheticCombinationsEngine::create_multi_instrument_synthetic_opportunity(
+    const std::string& combination_name, InstrumentHandle target_instrument, const MarketSnapshot& snapshot,
+    ArbitrageOpportunity& opportunity) {
+    auto instruments = predefined_combinations_.find(combination_name);
+    auto weights = combination_weights_.find(combination_name);
+    if (instruments == predefined_combinations_.end() || weights == combination_weights_.end() ||
+        !validate_combination_quality(instruments->second, weights->second, target_instrument)) {
+        return false;
+    }
+    for (auto instrument : instruments->second) {
+        if (!snapshot.has_quote(instrument)) {
+            return false;
+        }
+    }
+    
+    // Fixed weights carry no fit of their own; with a correlation matrix, confidence is how
+    // much of the target's variance they replicate
+    Price synthetic = calculate_multi_instrument_synthetic_price(instruments->second, weights->second, snapshot);
+    double confidence = correlation_matrix_
+                            ? calculate_combination_efficiency(instruments->second, weights->second, target_instrument)
+                            : 1.0;
+    return build_combination_opportunity(instruments->second, weights->second, target_instrument, synthetic,
+                                         confidence, snapshot, opportunity);
+}
+
+bool MultiInstrumentSyntheticCombinationsEngine::generate_dynamic_combinations(
+    const DynamicCombination& combination, const MarketSnapshot& snapshot, ArbitrageOpportunity& opportunity) {
+    // Trade the residual once it is MIN_RESIDUAL_OBSERVATIONS deep and COMBINATION_ENTRY_Z wide
+    const CombinationFit& fit = combination.fit;
+    if (!fit.valid || combination.residuals.size() < MIN_RESIDUAL_OBSERVATIONS ||
+        !snapshot.has_quote(combination.target)) {
+        return false;
+    }
+    Price basket = calculate_multi_instrument_synthetic_price(fit.instruments, fit.weights, snapshot);
+    double z = combination.residuals.z_score(snapshot.mid_price(combination.target) - basket);
+    if (std::abs(z) < COMBINATION_ENTRY_Z) {
+        return false;
+    }
+    
+    // The basket's fair level carries the residual's mean; confidence is Chebyshev's bound
+    Price synthetic = basket + combination.residuals.mean();
+    double confidence = 1.0 - 1.0 / (z * z);
+    return build_combination_opportunity(fit.instruments, fit.weights, combination.target, synthetic, confidence,
+                                         snapshot, opportunity);
+}
+
+bool MultiInstrumentSyntheticCombinationsEngine::build_combination_opportunity(
+    const std::vector<InstrumentHandle>& instruments, const std::vector<double>& weights,
+    InstrumentHandle target_instrument, Price synthetic_price, double confidence, const MarketSnapshot& snapshot,
+    ArbitrageOpportunity& opportunity) {
+    if (!snapshot.has_quote(target_instrument) || synthetic_price <= 0.0) {
+        return false;
+    }
+    
+    // Executable basket prices and the depth at the top of every book
+    Price market = snapshot.mid_price(target_instrument);
+    bool sell_target = market > synthetic_price;
+    Price basket_mid = 0.0;
+    Price basket_bid = 0.0;
+    Price basket_ask = 0.0;
+    Volume size = sell_target ? snapshot.bid_size(target_instrument) : snapshot.ask_size(target_instrument);
+    double gross = market;
+    for (size_t i = 0; i < instruments.size(); ++i) {
+        InstrumentHandle instrument = instruments[i];
+        double weight = weights[i];
+        Price bid = snapshot.bid_price(instrument);
+        Price ask = snapshot.ask_price(instrument);
+        basket_mid += weight * (bid + ask) / 2.0;
+        basket_bid += weight * (weight >= 0.0 ? bid : ask);
+        basket_ask += weight * (weight >= 0.0 ? ask : bid);
+        gross += std::abs(weight) * (bid + ask) / 2.0;
+        if (weight != 0.0) {
+            bool buy = (weight > 0.0) == sell_target;
+            size = std::min(size, (buy ? snapshot.ask_size(instrument) : snapshot.bid_size(instrument)) / std::abs(weight));
+        }
+    }
+    size = std::min(size, params_.max_position_size / market);
+    
+    // The synthetic's level is the basket plus its offset from the target
+    Price offset = synthetic_price - basket_mid;
+    double edge = sell_target ? snapshot.bid_price(target_instrument) - (basket_ask + offset)
+                              : (basket_bid + offset) - snapshot.ask_price(target_instrument);
+    if (size <= 0.0 || edge <= 0.0) {
+        return false;
+    }
+    
+    opportunity.opportunity_id = next_opportunity_id();
+    opportunity.type = ArbitrageType::MULTI_INSTRUMENT_SYNTHETIC_COMBINATION;
+    opportunity.status = ArbitrageStatus::IDENTIFIED;
+    opportunity.identification_time = std::chrono::high_resolution_clock::now();
+    opportunity.expiry_time = opportunity.identification_time + params_.max_holding_period;
+    opportunity.legs = construct_multi_instrument_legs(instruments, weights, target_instrument, snapshot,
+                                                       sell_target, size);
+    opportunity.expected_profit = edge * size;
+    opportunity.total_cost = gross * size;
+    opportunity.profit_probability = confidence;
+    opportunity.break_even_price = synthetic_price;
+    opportunity.net_exposure = (sell_target ? 1.0 : -1.0) * offset * size; // the basket leaves the offset unhedged
+    
+    Volume total_volume = 0.0;
+    for (const auto& leg : opportunity.legs) {
+        total_volume += leg.size;
+    }
+    opportunity.total_volume = total_volume;
+    
+    MispricingOpportunity& source = opportunity.mispricing_source;
+    source = MispricingOpportunity();
+    source.target_instrument = target_instrument;
+    for (size_t i = 0; i < instruments.size(); ++i) {
+        source.component_instruments.push_back(instruments[i]);
+        source.weights.push_back(weights[i]);
+    }
+    source.type = mispricing::MispricingType::STATISTICAL_ARBITRAGE;
+    source.market_price = market;
+    source.theoretical_price = synthetic_price;
+    source.deviation_percentage = (market - synthetic_price) / synthetic_price;
+    source.confidence_level = confidence;
+    source.expected_profit = opportunity.expected_profit;
+    source.expiry_time = opportunity.expiry_time;
+    return validate_opportunity(opportunity);
+}
+
+double MultiInstrumentSyntheticCombinationsEngine::calculate_multi_instrument_synthetic_price(
+    const std::vector<InstrumentHandle>& instruments, const std::vector<double>& weights,
+    const MarketSnapshot& snapshot) const {
+    Price price = 0.0;
+    for (size_t i = 0; i < instruments.size(); ++i) {
+        price += weights[i] * snapshot.mid_price(instruments[i]);
+    }
+    return price;
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::rebalance_dynamic_combination(DynamicCombination& combination,
+                                                                               const MarketSnapshot& snapshot) {
+    const auto& matrix = correlation_matrix_;
+    InstrumentHandle target = combination.target;
+    if (!matrix || !matrix->contains(target) || !snapshot.has_quote(target)) {
+        return;
+    }
+    const std::vector<InstrumentHandle>& cluster = correlation_clusters_.find(target)->second;
+    if (cluster.empty() || update_count_ % CLUSTER_REFRESH_INTERVAL == 0) {
+        refresh_correlation_cluster(combination);
+    }
+    if (cluster.empty()) {
+        combination.fit.valid = false;
+        return;
+    }
+    for (auto instrument : cluster) {
+        if (!snapshot.has_quote(instrument)) {
+            return; // keep the previous fit until the whole cluster is quoted
+        }
+    }
+    
+    // Price-move covariances: cov(dP_i, dP_j) ~ P_i P_j cov(r_i, r_j)
+    size_t n = cluster.size();
+    Price target_price = snapshot.mid_price(target);
+    linalg::gather_covariance(*matrix, cluster, combination.covariance);
+    linalg::gather_cross_covariance(*matrix, cluster, target, combination.cross);
+    combination.cluster_volatilities.resize(n);
+    double trace = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        Price price_i = snapshot.mid_price(cluster[i]);
+        double* row = combination.covariance.row(i);
+        for (size_t j = 0; j < n; ++j) {
+            row[j] *= price_i * snapshot.mid_price(cluster[j]);
+        }
+        combination.cross[i] *= price_i * target_price;
+        combination.cluster_volatilities[i] = std::sqrt(std::max(0.0, row[i]));
+        trace += row[i];
+    }
+    combination.target_variance = target_price * target_price * matrix->variance(target);
+    combination.ridge_penalty = RIDGE_PENALTY * trace / static_cast<double>(n);
+    if (!optimize_combination_weights(combination)) {
+        return;
+    }
+    combination.residuals.push(target_price -
+                               calculate_multi_instrument_synthetic_price(combination.fit.instruments,
+                                                                          combination.fit.weights, snapshot));
+}
+
+bool MultiInstrumentSyntheticCombinationsEngine::optimize_combination_weights(DynamicCombination& combination) {
+    // Full cluster first, from the previous solution, so the ranking sees every candidate
+    CombinationFit& fit = combination.fit;
+    const std::vector<InstrumentHandle>& cluster = correlation_clusters_.find(combination.target)->second;
+    combination.cluster_weights.resize(cluster.size(), 0.0);
+    linalg::RidgeSolution full = combination.solver.solve(combination.covariance, combination.cross.data(),
+                                                          combination.ridge_penalty,
+                                                          combination.cluster_weights.data(), RIDGE_TOLERANCE);
+    find_optimal_instrument_set(combination);
+    if (combination.subset.empty()) {
+        fit.valid = false;
+        return false;
+    }
+    
+    // Then the chosen subset, from its previous weights where it kept an instrument
+    size_t k = combination.subset.size();
+    linalg::gather_principal(combination.covariance, combination.subset, combination.subset_covariance);
+    combination.subset_cross.resize(k);
+    combination.subset_weights.resize(k);
+    for (size_t i = 0; i < k; ++i) {
+        size_t index = combination.subset[i];
+        combination.subset_cross[i] = combination.cross[index];
+        combination.subset_weights[i] = combination.cluster_weights[index];
+        auto kept = std::find(fit.instruments.begin(), fit.instruments.end(), cluster[index]);
+        if (kept != fit.instruments.end()) {
+            combination.subset_weights[i] = fit.weights[kept - fit.instruments.begin()];
+        }
+    }
+    linalg::RidgeSolution partial = combination.solver.solve(combination.subset_covariance,
+                                                             combination.subset_cross.data(),
+                                                             combination.ridge_penalty,
+                                                             combination.subset_weights.data(), RIDGE_TOLERANCE);
+    
+    fit.instruments.resize(k);
+    for (size_t i = 0; i < k; ++i) {
+        fit.instruments[i] = cluster[combination.subset[i]];
+    }
+    fit.weights.assign(combination.subset_weights.begin(), combination.subset_weights.end());
+    fit.solver_iterations = full.iterations + partial.iterations;
+    fit.tracking_error = calculate_combination_tracking_error(combination);
+    fit.valid = validate_combination_quality(fit.instruments, fit.weights, combination.target);
+    return fit.valid;
+}
+
+LegVector MultiInstrumentSyntheticCombinationsEngine::construct_multi_instrument_legs(
+    const std::vector<InstrumentHandle>& instruments, const std::vector<double>& weights,
+    InstrumentHandle target_instrument, const MarketSnapshot& snapshot, bool sell_target, Volume size) const {
+    // BID legs buy at the ask, ASK legs sell at the bid; the basket trades against the target
+    auto now = std::chrono::high_resolution_clock::now();
+    LegVector legs;
+    
+    ArbitrageLeg target_leg(target_instrument, sell_target ? market_data::Side::ASK : market_data::Side::BID, size,
+                            sell_target ? snapshot.bid_price(target_instrument) : snapshot.ask_price(target_instrument),
+                            sell_target ? -1.0 : 1.0);
+    target_leg.entry_time = now;
+    legs.push_back(target_leg);
+    
+    for (size_t i = 0; i < instruments.size(); ++i) {
+        double weight = weights[i];
+        if (weight == 0.0) {
+            continue;
+        }
+        bool buy = (weight > 0.0) == sell_target;
+        ArbitrageLeg leg(instruments[i], buy ? market_data::Side::BID : market_data::Side::ASK, size * std::abs(weight),
+                         buy ? snapshot.ask_price(instruments[i]) : snapshot.bid_price(instruments[i]),
+                         buy ? std::abs(weight) : -std::abs(weight));
+        leg.entry_time = now;
+        legs.push_back(leg);
+    }
+    return legs;
+}
+
+bool MultiInstrumentSyntheticCombinationsEngine::validate_combination_quality(
+    const std::vector<InstrumentHandle>& instruments, const std::vector<double>& weights,
+    InstrumentHandle target_instrument) const {
+    if (instruments.empty() || instruments.size() != weights.size()) {
+        return false;
+    }
+    bool any_weight = false;
+    for (size_t i = 0; i < instruments.size(); ++i) {
+        if (instruments[i] == target_instrument || !std::isfinite(weights[i])) {
+            return false;
+        }
+        any_weight = any_weight || weights[i] != 0.0;
+    }
+    return any_weight;
+}
+
+double MultiInstrumentSyntheticCombinationsEngine::calculate_combination_tracking_error(
+    const DynamicCombination& combination) const {
+    // var(dP_target - w' dP) = var_target - 2 w' c + w' C w, over the chosen subset
+    const std::vector<double>& weights = combination.subset_weights;
+    double variance = combination.target_variance -
+                      2.0 * linalg::dot(weights.data(), combination.subset_cross.data(), weights.size()) +
+                      linalg::quadratic_form(combination.subset_covariance, weights.data());
+    return std::sqrt(std::max(0.0, variance));
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::find_optimal_instrument_set(DynamicCombination& combination) const {
+    // Rank the cluster by each member's share of the fit, |w_i| sd_i, and take the largest,
+    // pruning any member nearly collinear with one already taken
+    size_t n = combination.cluster_weights.size();
+    auto contribution = [&](size_t i) {
+        return std::abs(combination.cluster_weights[i]) * combination.cluster_volatilities[i];
+    };
+    combination.ranking.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        combination.ranking[i] = i;
+    }
+    std::sort(combination.ranking.begin(), combination.ranking.end(), [&](size_t a, size_t b) {
+        return contribution(a) != contribution(b) ? contribution(a) > contribution(b) : a < b;
+    });
+    
+    combination.subset.clear();
+    for (size_t candidate : combination.ranking) {
+        if (combination.subset.size() >= combination.max_instruments || contribution(candidate) <= 0.0) {
+            break;
+        }
+        bool redundant = false;
+        for (size_t chosen : combination.subset) {
+            double scale = combination.cluster_volatilities[candidate] * combination.cluster_volatilities[chosen];
+            if (scale > 0.0 && std::abs(combination.covariance(candidate, chosen)) / scale > REDUNDANT_CORRELATION) {
+                redundant = true;
+                break;
+            }
+        }
+        if (!redundant) {
+            combination.subset.push_back(candidate);
+        }
+    }
+}
+
+void MultiInstrumentSyntheticCombinationsEngine::refresh_correlation_cluster(DynamicCombination& combination) {
+    // The key exists from add_dynamic_target, so only this target's entry is written
+    std::vector<InstrumentHandle>& cluster = correlation_clusters_.find(combination.target)->second;
+    std::vector<InstrumentHandle> previous;
+    previous.swap(cluster);
+    cluster = get_highly_correlated_instruments(combination.target, min_cluster_correlation_);
+    if (cluster.size() > max_cluster_size_) {
+        cluster.resize(max_cluster_size_);
+    }
+    
+    // Carry the warm start across membership changes
+    std::vector<double> weights(cluster.size(), 0.0);
+    for (size_t i = 0; i < cluster.size(); ++i) {
+        auto kept = std::find(previous.begin(), previous.end(), cluster[i]);
+        if (kept != previous.end() && size_t(kept - previous.begin()) < combination.cluster_weights.size()) {
+            weights[i] = combination.cluster_weights[kept - previous.begin()];
+        }
+    }
+    combination.cluster_weights.swap(weights);
 }
 
 } // namespace arbitrage
@@ -0,0 +1,69 @@
+#pragma once
+
+// Private to SpotFundingSyntheticPerpetualEngine. Like venue_scan_kernel.hpp, it is included by
+// the per-ISA translation units, so it must stay free of standard containers and other inline
+// library code that the linker could merge across ISAs.
+
+#include "option_batch_kernel.hpp"
+#include <cstddef>
+
+namespace spe
+{
+    namespace pricing
+    {
+        namespace detail
+        {
+
+            struct BasisScanKernelArgs
+            {
+                size_t lanes; // pairs scanned, a multiple of the widest register
+                const double *spot_bids;      // 0 where the spot has no quote
+                const double *spot_asks;      // 0 where the spot has no quote
+                const double *perpetual_bids; // 0 where the perpetual has no quote
+                const double *perpetual_asks; // 0 where the perpetual has no quote
+                const double *carries;        // funding the short perpetual collects over the horizon
+                double cost;                  // round trip, as a fraction
+
+                double *cash_and_carry_edges; // lanes: (perp bid - spot ask) / spot ask + carry - cost
+                double *reverse_edges;        // lanes: (spot bid - perp ask) / perp ask - carry - cost
+            };
+
+            void scan_basis_scalar(const BasisScanKernelArgs &args);
+            bool scan_basis_avx2(const BasisScanKernelArgs &args);   // false if not built in
+            bool scan_basis_avx512(const BasisScanKernelArgs &args); // false if not built in
+
+            // Unquoted lanes come out at -1, below any threshold
+            template <typename Ops>
+            void scan_basis_kernel(const BasisScanKernelArgs &args)
+            {
+                using reg = typename Ops::reg;
+                constexpr size_t width = Ops::width;
+                const reg zero = Ops::set1(0.0);
+                const reg one = Ops::set1(1.0);
+                const reg none = Ops::set1(-1.0);
+                const reg cost = Ops::set1(args.cost);
+
+                for (size_t j = 0; j < args.lanes; j += width)
+                {
+                    reg spot_bid = Ops::load(args.spot_bids + j);
+                    reg spot_ask = Ops::load(args.spot_asks + j);
+                    reg perpetual_bid = Ops::load(args.perpetual_bids + j);
+                    reg perpetual_ask = Ops::load(args.perpetual_asks + j);
+                    reg carry = Ops::load(args.carries + j);
+
+                    // An absent bid gives -1 - carry - cost on its own; absent asks must not divide
+                    typename Ops::mask quoted = Ops::gt(Ops::min(spot_ask, perpetual_ask), zero);
+                    reg spot_divisor = Ops::blend(quoted, spot_ask, one);
+                    reg perpetual_divisor = Ops::blend(quoted, perpetual_ask, one);
+
+                    reg long_spot = Ops::add(Ops::div(Ops::sub(perpetual_bid, spot_ask), spot_divisor), Ops::sub(carry, cost));
+                    reg short_spot = Ops::sub(Ops::div(Ops::sub(spot_bid, perpetual_ask), perpetual_divisor), Ops::add(carry, cost));
+
+                    Ops::store(args.cash_and_carry_edges + j, Ops::blend(quoted, long_spot, none));
+                    Ops::store(args.reverse_edges + j, Ops::blend(quoted, short_spot, none));
+                }
+            }
+
+        } // namespace detail
+    } // namespace pricing
+} // namespace spe
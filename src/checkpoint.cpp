@@ -0,0 +1,588 @@
+#include "checkpoint.hpp"
+#include "instrument_registry.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace spe
+{
+    namespace checkpoint
+    {
+
+        namespace
+        {
+            constexpr uint32_t NO_LOCAL_ID = UINT32_MAX;
+            constexpr uint32_t SYMBOL_TABLE_VERSION = 1;
+            constexpr size_t MAX_SYMBOL_LENGTH = 255;
+
+            int64_t to_nanoseconds(Timestamp timestamp)
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+            }
+
+            Timestamp from_nanoseconds(int64_t ns)
+            {
+                return Timestamp(std::chrono::duration_cast<Timestamp::duration>(std::chrono::nanoseconds(ns)));
+            }
+
+            template <typename T>
+            void append_value(std::vector<unsigned char> &out, const T &value)
+            {
+                const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&value);
+                out.insert(out.end(), bytes, bytes + sizeof(T));
+            }
+        }
+
+        uint64_t checksum(const unsigned char *data, size_t size)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ data[i]) * 1099511628211ull;
+            }
+            return hash;
+        }
+
+        // CheckpointWriter implementation
+        CheckpointWriter::CheckpointWriter() : section_start_(0), section_count_(0), created_() {}
+
+        void CheckpointWriter::clear()
+        {
+            body_.clear();
+            for (InstrumentHandle instrument : instruments_)
+            {
+                local_ids_[instrument] = NO_LOCAL_ID;
+            }
+            instruments_.clear();
+            section_start_ = 0;
+            section_count_ = 0;
+        }
+
+        void CheckpointWriter::begin_section(uint32_t tag, uint32_t version)
+        {
+            section_start_ = body_.size();
+            SectionHeader header{tag, version, 0};
+            append(&header, sizeof(header));
+        }
+
+        void CheckpointWriter::end_section()
+        {
+            uint64_t length = body_.size() - section_start_ - sizeof(SectionHeader);
+            std::memcpy(body_.data() + section_start_ + offsetof(SectionHeader, length), &length, sizeof(length));
+            ++section_count_;
+        }
+
+        void CheckpointWriter::put_instrument(InstrumentHandle instrument)
+        {
+            if (instrument == INVALID_INSTRUMENT)
+            {
+                put(NO_LOCAL_ID);
+                return;
+            }
+            if (local_ids_.size() <= instrument)
+            {
+                local_ids_.resize(instrument + 1, NO_LOCAL_ID);
+            }
+            uint32_t &local = local_ids_[instrument];
+            if (local == NO_LOCAL_ID)
+            {
+                local = static_cast<uint32_t>(instruments_.size());
+                instruments_.push_back(instrument);
+            }
+            put(local);
+        }
+
+        void CheckpointWriter::put_time(Timestamp time)
+        {
+            put(to_nanoseconds(time));
+        }
+
+        void CheckpointWriter::put_rolling(const stats::RollingStatistics &statistics)
+        {
+            const auto &window = statistics.values();
+            put(static_cast<uint32_t>(window.size()));
+            put(statistics.ewma());
+            for (size_t i = 0; i < window.size(); ++i)
+            {
+                put(window[i]);
+            }
+        }
+
+        std::vector<unsigned char> CheckpointWriter::finish() const
+        {
+            std::vector<unsigned char> symbols;
+            append_value(symbols, static_cast<uint32_t>(instruments_.size()));
+            for (InstrumentHandle instrument : instruments_)
+            {
+                const auto &symbol = market_data::instrument_symbol(instrument);
+                uint8_t length = static_cast<uint8_t>(std::min(symbol.size(), MAX_SYMBOL_LENGTH));
+                append_value(symbols, length);
+                symbols.insert(symbols.end(), symbol.begin(), symbol.begin() + length);
+            }
+
+            std::vector<unsigned char> image(sizeof(CheckpointFileHeader));
+            image.reserve(sizeof(CheckpointFileHeader) + sizeof(SectionHeader) + symbols.size() + body_.size());
+            append_value(image, SectionHeader{SYMBOL_TABLE_TAG, SYMBOL_TABLE_VERSION, symbols.size()});
+            image.insert(image.end(), symbols.begin(), symbols.end());
+            image.insert(image.end(), body_.begin(), body_.end());
+
+            CheckpointFileHeader header{};
+            std::memcpy(header.magic, CheckpointFileHeader::MAGIC, sizeof(header.magic));
+            header.version = CheckpointFileHeader::VERSION;
+            header.section_count = section_count_ + 1;
+            header.created_ns = static_cast<uint64_t>(to_nanoseconds(created_));
+            header.payload_bytes = image.size() - sizeof(CheckpointFileHeader);
+            header.checksum = checksum(image.data() + sizeof(CheckpointFileHeader), header.payload_bytes);
+            std::memcpy(image.data(), &header, sizeof(header));
+            return image;
+        }
+
+        // SectionReader implementation
+        bool SectionReader::get_count(size_t &count, size_t min_record_bytes)
+        {
+            uint64_t stored = 0;
+            if (!get(stored))
+            {
+                count = 0;
+                return false;
+            }
+            if (min_record_bytes > 0 && stored > remaining() / min_record_bytes)
+            {
+                ok_ = false;
+                count = 0;
+                return false;
+            }
+            count = static_cast<size_t>(stored);
+            return true;
+        }
+
+        bool SectionReader::get_instrument(InstrumentHandle &instrument)
+        {
+            uint32_t local = NO_LOCAL_ID;
+            if (!get(local))
+            {
+                instrument = INVALID_INSTRUMENT;
+                return false;
+            }
+            if (local == NO_LOCAL_ID)
+            {
+                instrument = INVALID_INSTRUMENT;
+                return true;
+            }
+            if (!instruments_ || local >= instruments_->size())
+            {
+                ok_ = false;
+                instrument = INVALID_INSTRUMENT;
+                return false;
+            }
+            instrument = (*instruments_)[local];
+            return true;
+        }
+
+        bool SectionReader::get_time(Timestamp &time)
+        {
+            int64_t ns = 0;
+            bool read = get(ns);
+            time = from_nanoseconds(ns);
+            return read;
+        }
+
+        bool SectionReader::get_rolling(stats::RollingStatistics &statistics)
+        {
+            uint32_t count = 0;
+            double ewma = 0.0;
+            if (!get(count) || !get(ewma) || count > remaining() / sizeof(double))
+            {
+                ok_ = false;
+                return false;
+            }
+            scratch_.resize(count);
+            if (!get_doubles(scratch_.data(), count))
+            {
+                return false;
+            }
+            statistics.restore(scratch_.data(), count, ewma);
+            return true;
+        }
+
+        // CheckpointReader implementation
+        CheckpointReader::CheckpointReader() : data_(nullptr), size_(0), mapped_(false) {}
+
+        CheckpointReader::~CheckpointReader()
+        {
+            close();
+        }
+
+        bool CheckpointReader::open(const std::string &path)
+        {
+            close();
+
+#if !defined(_WIN32)
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                error_ = path + ": " + std::strerror(errno);
+                return false;
+            }
+            struct stat info;
+            if (::fstat(fd, &info) != 0)
+            {
+                error_ = path + ": " + std::strerror(errno);
+                ::close(fd);
+                return false;
+            }
+            size_ = static_cast<size_t>(info.st_size);
+            if (size_ >= sizeof(CheckpointFileHeader))
+            {
+                void *mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    error_ = path + ": " + std::strerror(errno);
+                    ::close(fd);
+                    size_ = 0;
+                    return false;
+                }
+                ::madvise(mapping, size_, MADV_SEQUENTIAL);
+                data_ = static_cast<const unsigned char *>(mapping);
+                mapped_ = true;
+            }
+            ::close(fd); // the mapping keeps the file alive
+#else
+            std::FILE *file = std::fopen(path.c_str(), "rb");
+            if (!file)
+            {
+                error_ = path + ": cannot open";
+                return false;
+            }
+            std::fseek(file, 0, SEEK_END);
+            long length = std::ftell(file);
+            std::fseek(file, 0, SEEK_SET);
+            fallback_.resize(length > 0 ? static_cast<size_t>(length) : 0);
+            size_ = fallback_.size() == 0 ? 0 : std::fread(fallback_.data(), 1, fallback_.size(), file);
+            std::fclose(file);
+            data_ = size_ >= sizeof(CheckpointFileHeader) ? fallback_.data() : nullptr;
+#endif
+            return parse(path);
+        }
+
+        bool CheckpointReader::open_image(std::vector<unsigned char> image)
+        {
+            close();
+            fallback_ = std::move(image);
+            size_ = fallback_.size();
+            data_ = size_ >= sizeof(CheckpointFileHeader) ? fallback_.data() : nullptr;
+            return parse("checkpoint image");
+        }
+
+        bool CheckpointReader::parse(const std::string &name)
+        {
+            if (!data_)
+            {
+                error_ = name + ": too short for a checkpoint header";
+                close();
+                return false;
+            }
+            const CheckpointFileHeader &file_header = header();
+            if (std::memcmp(file_header.magic, CheckpointFileHeader::MAGIC, sizeof(file_header.magic)) != 0 ||
+                file_header.version != CheckpointFileHeader::VERSION)
+            {
+                error_ = name + ": not a version " + std::to_string(CheckpointFileHeader::VERSION) + " checkpoint";
+                close();
+                return false;
+            }
+            size_t payload = size_ - sizeof(CheckpointFileHeader);
+            if (file_header.payload_bytes != payload ||
+                checksum(data_ + sizeof(CheckpointFileHeader), payload) != file_header.checksum)
+            {
+                error_ = name + ": truncated or corrupt";
+                close();
+                return false;
+            }
+
+            size_t offset = sizeof(CheckpointFileHeader);
+            while (size_ - offset >= sizeof(SectionHeader))
+            {
+                SectionHeader section;
+                std::memcpy(&section, data_ + offset, sizeof(section));
+                offset += sizeof(section);
+                if (section.length > size_ - offset)
+                {
+                    break;
+                }
+                sections_.push_back(Section{section.tag, section.version, offset, static_cast<size_t>(section.length)});
+                offset += section.length;
+            }
+            if (offset != size_ || sections_.size() != file_header.section_count || sections_.empty() ||
+                sections_.front().tag != SYMBOL_TABLE_TAG)
+            {
+                error_ = name + ": malformed section table";
+                close();
+                return false;
+            }
+
+            // Interned now, so restore hooks map instruments with one lookup
+            SectionReader symbols(data_ + sections_.front().offset, sections_.front().length, sections_.front().version,
+                                  nullptr);
+            uint32_t count = 0;
+            symbols.get(count);
+            instruments_.reserve(count);
+            for (uint32_t i = 0; i < count && symbols.ok(); ++i)
+            {
+                uint8_t length = 0;
+                symbols.get(length);
+                if (length > symbols.remaining())
+                {
+                    break;
+                }
+                std::string symbol(length, '\0');
+                symbols.get_bytes(&symbol[0], length);
+                instruments_.push_back(market_data::intern_instrument(symbol));
+            }
+            if (instruments_.size() != count)
+            {
+                error_ = name + ": malformed symbol table";
+                close();
+                return false;
+            }
+            error_.clear();
+            return true;
+        }
+
+        void CheckpointReader::close()
+        {
+#if !defined(_WIN32)
+            if (mapped_)
+            {
+                ::munmap(const_cast<unsigned char *>(data_), size_);
+            }
+#endif
+            fallback_.clear();
+            sections_.clear();
+            instruments_.clear();
+            data_ = nullptr;
+            size_ = 0;
+            mapped_ = false;
+        }
+
+        bool CheckpointReader::find(uint32_t tag, SectionReader &section) const
+        {
+            for (const auto &entry : sections_)
+            {
+                if (entry.tag == tag)
+                {
+                    section = SectionReader(data_ + entry.offset, entry.length, entry.version, &instruments_);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        Timestamp CheckpointReader::created() const
+        {
+            return data_ ? from_nanoseconds(static_cast<int64_t>(header().created_ns)) : Timestamp{};
+        }
+
+        // Checkpointer implementation
+        Checkpointer::Checkpointer(std::string path, std::chrono::milliseconds interval)
+            : path_(std::move(path)), interval_(interval), next_capture_(), has_pending_(false), stopping_(false) {}
+
+        Checkpointer::~Checkpointer()
+        {
+            stop();
+        }
+
+        void Checkpointer::add(uint32_t tag, uint32_t version, SaveHook save, RestoreHook restore)
+        {
+            components_.push_back(Component{tag, version, std::move(save), std::move(restore)});
+        }
+
+        void Checkpointer::start()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (writer_thread_.joinable())
+            {
+                return;
+            }
+            stopping_ = false;
+            writer_thread_ = std::thread(&Checkpointer::write_loop, this);
+        }
+
+        void Checkpointer::stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            ready_.notify_all();
+            if (writer_thread_.joinable())
+            {
+                writer_thread_.join();
+            }
+        }
+
+        void Checkpointer::fill(CheckpointWriter &writer, Timestamp now)
+        {
+            auto started = std::chrono::steady_clock::now();
+            writer.clear();
+            writer.set_created(now);
+            for (const auto &component : components_)
+            {
+                writer.begin_section(component.tag, component.version);
+                component.save(writer);
+                writer.end_section();
+            }
+            next_capture_ = now + interval_;
+            captures_.fetch_add(1, std::memory_order_relaxed);
+            last_capture_ns_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                       std::chrono::steady_clock::now() - started)
+                                       .count(),
+                                   std::memory_order_relaxed);
+        }
+
+        void Checkpointer::capture(Timestamp now)
+        {
+            fill(scratch_, now);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (has_pending_)
+                {
+                    superseded_.fetch_add(1, std::memory_order_relaxed);
+                }
+                std::swap(scratch_, pending_); // scratch_ takes back a spent buffer
+                has_pending_ = true;
+            }
+            ready_.notify_one();
+        }
+
+        bool Checkpointer::write_now(Timestamp now)
+        {
+            fill(scratch_, now);
+            return write(scratch_);
+        }
+
+        bool Checkpointer::write(const CheckpointWriter &writer)
+        {
+            std::vector<unsigned char> image = writer.finish();
+            std::string error;
+            std::lock_guard<std::mutex> file_lock(file_mutex_);
+            if (!write_file(path_, image, error))
+            {
+                failures_.fetch_add(1, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> lock(mutex_);
+                last_error_ = error;
+                return false;
+            }
+            writes_.fetch_add(1, std::memory_order_relaxed);
+            last_bytes_.store(image.size(), std::memory_order_relaxed);
+            return true;
+        }
+
+        void Checkpointer::write_loop()
+        {
+            CheckpointWriter writing;
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (;;)
+            {
+                ready_.wait(lock, [this] { return has_pending_ || stopping_; });
+                if (!has_pending_)
+                {
+                    return; // stopping with nothing left to write
+                }
+                std::swap(writing, pending_);
+                has_pending_ = false;
+                lock.unlock();
+                write(writing);
+                lock.lock();
+            }
+        }
+
+        RestoreResult Checkpointer::restore()
+        {
+            RestoreResult result;
+            CheckpointReader reader;
+            if (!reader.open(path_))
+            {
+                result.error = reader.error();
+                return result;
+            }
+            result.loaded = true;
+            result.created = reader.created();
+
+            for (const auto &component : components_)
+            {
+                SectionReader section;
+                if (!reader.find(component.tag, section) || section.version() != component.version)
+                {
+                    ++result.missing;
+                    continue;
+                }
+                if (component.restore(section) && section.ok())
+                {
+                    ++result.restored;
+                }
+                else
+                {
+                    ++result.failed;
+                }
+            }
+            return result;
+        }
+
+        CheckpointStats Checkpointer::stats() const
+        {
+            CheckpointStats stats;
+            stats.captures = captures_.load(std::memory_order_relaxed);
+            stats.writes = writes_.load(std::memory_order_relaxed);
+            stats.failures = failures_.load(std::memory_order_relaxed);
+            stats.superseded = superseded_.load(std::memory_order_relaxed);
+            stats.last_bytes = last_bytes_.load(std::memory_order_relaxed);
+            stats.last_capture_time = std::chrono::nanoseconds(last_capture_ns_.load(std::memory_order_relaxed));
+            return stats;
+        }
+
+        std::string Checkpointer::last_error()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return last_error_;
+        }
+
+        bool Checkpointer::write_file(const std::string &path, const std::vector<unsigned char> &image, std::string &error)
+        {
+            std::string temporary = path + ".tmp";
+            std::FILE *file = std::fopen(temporary.c_str(), "wb");
+            if (!file)
+            {
+                error = temporary + ": " + std::strerror(errno);
+                return false;
+            }
+            bool written = std::fwrite(image.data(), 1, image.size(), file) == image.size() && std::fflush(file) == 0;
+#if !defined(_WIN32)
+            written = written && ::fsync(::fileno(file)) == 0; // durable before it replaces the last one
+#endif
+            if (std::fclose(file) != 0 || !written)
+            {
+                error = temporary + ": " + std::strerror(errno);
+                std::remove(temporary.c_str());
+                return false;
+            }
+#if defined(_WIN32)
+            std::remove(path.c_str()); // rename does not replace there
+#endif
+            if (std::rename(temporary.c_str(), path.c_str()) != 0)
+            {
+                error = path + ": " + std::strerror(errno);
+                std::remove(temporary.c_str());
+                return false;
+            }
+            return true;
+        }
+
+    } // namespace checkpoint
+} // namespace spe
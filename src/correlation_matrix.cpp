@@ -0,0 +1,306 @@
+#include "correlation_matrix.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace spe
+{
+    namespace stats
+    {
+
+        namespace
+        {
+            // Fold the scale back into the sums well before 1/scale can overflow
+            constexpr double MIN_SCALE = 1e-100;
+        }
+
+        StreamingCorrelationMatrix::StreamingCorrelationMatrix(size_t max_instruments, double decay)
+            : dimension_(max_instruments), decay_(decay),
+              cross_sums_(new std::atomic<double>[max_instruments * (max_instruments + 1) / 2]),
+              sums_(new std::atomic<double>[max_instruments]),
+              weight_(0.0), scale_(1.0), observations_(0), sequence_(0),
+              last_prices_(max_instruments, 0.0)
+        {
+            size_t packed = dimension_ * (dimension_ + 1) / 2;
+            for (size_t i = 0; i < packed; ++i)
+            {
+                cross_sums_[i].store(0.0, std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < dimension_; ++i)
+            {
+                sums_[i].store(0.0, std::memory_order_relaxed);
+            }
+        }
+
+        void StreamingCorrelationMatrix::update(const MarketSnapshot &snapshot)
+        {
+            scratch_returns_.clear();
+            for (auto instrument : snapshot.dirty_instruments())
+            {
+                if (instrument >= dimension_ || !snapshot.has_quote(instrument))
+                {
+                    continue;
+                }
+
+                double price = snapshot.mid_price(instrument);
+                double &last = last_prices_[instrument];
+                if (last > 0 && price > 0)
+                {
+                    scratch_returns_.emplace_back(instrument, std::log(price / last));
+                }
+                last = price;
+            }
+
+            if (!scratch_returns_.empty())
+            {
+                add_observation(scratch_returns_);
+            }
+        }
+
+        void StreamingCorrelationMatrix::add_observation(const std::vector<std::pair<InstrumentHandle, double>> &returns)
+        {
+            uint64_t seq = sequence_.load(std::memory_order_relaxed);
+            sequence_.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            double scale = scale_.load(std::memory_order_relaxed) * decay_;
+            scale_.store(scale, std::memory_order_relaxed);
+            double inv_scale = 1.0 / scale;
+
+            weight_.store(weight_.load(std::memory_order_relaxed) + inv_scale, std::memory_order_relaxed);
+
+            for (size_t i = 0; i < returns.size(); ++i)
+            {
+                InstrumentHandle a = returns[i].first;
+                if (a >= dimension_)
+                {
+                    continue;
+                }
+
+                double weighted = returns[i].second * inv_scale;
+                sums_[a].store(sums_[a].load(std::memory_order_relaxed) + weighted, std::memory_order_relaxed);
+
+                for (size_t j = i; j < returns.size(); ++j)
+                {
+                    InstrumentHandle b = returns[j].first;
+                    if (b >= dimension_)
+                    {
+                        continue;
+                    }
+
+                    auto &cell = cross_sums_[packed_index(a, b)];
+                    cell.store(cell.load(std::memory_order_relaxed) + weighted * returns[j].second,
+                               std::memory_order_relaxed);
+                }
+            }
+
+            if (scale < MIN_SCALE)
+            {
+                rescale();
+            }
+
+            observations_.fetch_add(1, std::memory_order_relaxed);
+            sequence_.store(seq + 2, std::memory_order_release);
+        }
+
+        void StreamingCorrelationMatrix::rescale()
+        {
+            // O(N^2), but only once every few thousand observations
+            double scale = scale_.load(std::memory_order_relaxed);
+            size_t packed = dimension_ * (dimension_ + 1) / 2;
+            for (size_t i = 0; i < packed; ++i)
+            {
+                cross_sums_[i].store(cross_sums_[i].load(std::memory_order_relaxed) * scale, std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < dimension_; ++i)
+            {
+                sums_[i].store(sums_[i].load(std::memory_order_relaxed) * scale, std::memory_order_relaxed);
+            }
+            weight_.store(weight_.load(std::memory_order_relaxed) * scale, std::memory_order_relaxed);
+            scale_.store(1.0, std::memory_order_relaxed);
+        }
+
+        void StreamingCorrelationMatrix::save_state(checkpoint::CheckpointWriter &out) const
+        {
+            // Sums with the scale folded in, so the file does not depend on when it last rescaled
+            std::vector<InstrumentHandle> present;
+            for (size_t i = 0; i < dimension_; ++i)
+            {
+                if (last_prices_[i] > 0)
+                {
+                    present.push_back(static_cast<InstrumentHandle>(i));
+                }
+            }
+
+            double scale = scale_.load(std::memory_order_relaxed);
+            out.put(observations_.load(std::memory_order_relaxed));
+            out.put(weight_.load(std::memory_order_relaxed) * scale);
+            out.put_count(present.size());
+            for (InstrumentHandle instrument : present)
+            {
+                out.put_instrument(instrument);
+                out.put(last_prices_[instrument]);
+                out.put(sums_[instrument].load(std::memory_order_relaxed) * scale);
+            }
+            // Upper triangle over the present instruments, row by row
+            for (size_t i = 0; i < present.size(); ++i)
+            {
+                for (size_t j = i; j < present.size(); ++j)
+                {
+                    out.put(cross_sums_[packed_index(present[i], present[j])].load(std::memory_order_relaxed) * scale);
+                }
+            }
+        }
+
+        bool StreamingCorrelationMatrix::restore_state(checkpoint::SectionReader &in)
+        {
+            uint64_t observations = 0;
+            double weight = 0.0;
+            size_t count = 0;
+            in.get(observations);
+            in.get(weight);
+            if (!in.get_count(count, sizeof(uint32_t) + 2 * sizeof(double)))
+            {
+                return false;
+            }
+
+            std::vector<InstrumentHandle> instruments(count);
+            std::vector<double> prices(count);
+            std::vector<double> sums(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                in.get_instrument(instruments[i]);
+                in.get(prices[i]);
+                in.get(sums[i]);
+            }
+            if (count * (count + 1) / 2 > in.remaining() / sizeof(double))
+            {
+                return false;
+            }
+            std::vector<double> cross(count * (count + 1) / 2);
+            in.get_doubles(cross.data(), cross.size());
+            if (!in.ok())
+            {
+                return false;
+            }
+
+            uint64_t seq = sequence_.load(std::memory_order_relaxed);
+            sequence_.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            size_t packed = dimension_ * (dimension_ + 1) / 2;
+            for (size_t i = 0; i < packed; ++i)
+            {
+                cross_sums_[i].store(0.0, std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < dimension_; ++i)
+            {
+                sums_[i].store(0.0, std::memory_order_relaxed);
+                last_prices_[i] = 0.0;
+            }
+
+            size_t cell = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                InstrumentHandle a = instruments[i];
+                bool kept = a < dimension_;
+                if (kept)
+                {
+                    last_prices_[a] = prices[i];
+                    sums_[a].store(sums[i], std::memory_order_relaxed);
+                }
+                for (size_t j = i; j < count; ++j, ++cell)
+                {
+                    if (kept && instruments[j] < dimension_)
+                    {
+                        cross_sums_[packed_index(a, instruments[j])].store(cross[cell], std::memory_order_relaxed);
+                    }
+                }
+            }
+            weight_.store(weight, std::memory_order_relaxed);
+            scale_.store(1.0, std::memory_order_relaxed);
+            observations_.store(observations, std::memory_order_relaxed);
+            sequence_.store(seq + 2, std::memory_order_release);
+            return true;
+        }
+
+        StreamingCorrelationMatrix::PairMoments StreamingCorrelationMatrix::read_pair(InstrumentHandle a,
+                                                                                       InstrumentHandle b) const
+        {
+            size_t index_ab = packed_index(a, b);
+            size_t index_aa = packed_index(a, a);
+            size_t index_bb = packed_index(b, b);
+
+            PairMoments moments;
+            for (;;)
+            {
+                uint64_t before = sequence_.load(std::memory_order_acquire);
+                if (before & 1)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                moments.cross_ab = cross_sums_[index_ab].load(std::memory_order_relaxed);
+                moments.cross_aa = cross_sums_[index_aa].load(std::memory_order_relaxed);
+                moments.cross_bb = cross_sums_[index_bb].load(std::memory_order_relaxed);
+                moments.sum_a = sums_[a].load(std::memory_order_relaxed);
+                moments.sum_b = sums_[b].load(std::memory_order_relaxed);
+                moments.weight = weight_.load(std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence_.load(std::memory_order_relaxed) == before)
+                {
+                    return moments;
+                }
+            }
+        }
+
+        // The common scale factor cancels in every ratio below
+        double StreamingCorrelationMatrix::covariance(InstrumentHandle a, InstrumentHandle b) const
+        {
+            if (a >= dimension_ || b >= dimension_)
+            {
+                return 0.0;
+            }
+
+            auto m = read_pair(a, b);
+            if (m.weight <= 0)
+            {
+                return 0.0;
+            }
+            return m.cross_ab / m.weight - (m.sum_a / m.weight) * (m.sum_b / m.weight);
+        }
+
+        double StreamingCorrelationMatrix::correlation(InstrumentHandle a, InstrumentHandle b) const
+        {
+            if (a >= dimension_ || b >= dimension_)
+            {
+                return 0.0;
+            }
+            if (a == b)
+            {
+                return 1.0;
+            }
+
+            auto m = read_pair(a, b);
+            if (m.weight <= 0)
+            {
+                return 0.0;
+            }
+
+            double mean_a = m.sum_a / m.weight;
+            double mean_b = m.sum_b / m.weight;
+            double var_a = m.cross_aa / m.weight - mean_a * mean_a;
+            double var_b = m.cross_bb / m.weight - mean_b * mean_b;
+            if (var_a <= 0 || var_b <= 0)
+            {
+                return 0.0;
+            }
+
+            double cov = m.cross_ab / m.weight - mean_a * mean_b;
+            return std::max(-1.0, std::min(1.0, cov / std::sqrt(var_a * var_b)));
+        }
+
+    } // namespace stats
+} // namespace spe
@@ -0,0 +1,288 @@
+#include "currency_graph.hpp"
+#include <cmath>
+#include <limits>
+
+namespace spe
+{
+    namespace graph
+    {
+
+        namespace
+        {
+            constexpr double NO_RATE = -std::numeric_limits<double>::infinity();
+        }
+
+        CurrencyGraph::CurrencyGraph(bool include_four_cycles, double fee_rate, double min_return)
+            : include_four_cycles_(include_four_cycles), fee_log_(std::log1p(-fee_rate)),
+              min_log_return_(std::log1p(min_return)), epoch_(0)
+        {
+        }
+
+        uint32_t CurrencyGraph::intern_currency(const std::string &currency)
+        {
+            auto it = currency_ids_.find(currency);
+            if (it != currency_ids_.end())
+            {
+                return it->second;
+            }
+            uint32_t id = static_cast<uint32_t>(currency_names_.size());
+            currency_ids_.emplace(currency, id);
+            currency_names_.push_back(currency);
+            out_edges_.emplace_back();
+            return id;
+        }
+
+        bool CurrencyGraph::split_pair_symbol(const std::string &symbol, std::string &base, std::string &quote)
+        {
+            // Exactly two tokens; dated or option symbols (BTC-USD-240329, BTC-USD-SWAP) are not spot pairs
+            size_t separator = symbol.find_first_of("-/");
+            if (separator == std::string::npos || separator == 0 || separator + 1 >= symbol.size() ||
+                symbol.find_first_of("-/", separator + 1) != std::string::npos)
+            {
+                return false;
+            }
+            base = symbol.substr(0, separator);
+            quote = symbol.substr(separator + 1);
+            return base != quote;
+        }
+
+        bool CurrencyGraph::add_pair(InstrumentHandle instrument, const std::string &base, const std::string &quote)
+        {
+            if (instrument == INVALID_INSTRUMENT || base.empty() || quote.empty() || base == quote ||
+                has_pair(instrument))
+            {
+                return false;
+            }
+
+            uint32_t base_id = intern_currency(base);
+            uint32_t quote_id = intern_currency(quote);
+            uint32_t pair = static_cast<uint32_t>(pair_instruments_.size());
+            pair_instruments_.push_back(instrument);
+            if (instrument >= pair_by_instrument_.size())
+            {
+                pair_by_instrument_.resize(instrument + 1, NO_PAIR);
+            }
+            pair_by_instrument_[instrument] = pair;
+
+            uint32_t sell = static_cast<uint32_t>(edges_.size());
+            edges_.push_back(Edge{instrument, base_id, quote_id, Side::ASK});
+            edges_.push_back(Edge{instrument, quote_id, base_id, Side::BID});
+            edge_log_rates_.resize(edges_.size(), NO_RATE);
+            edge_prices_.resize(edges_.size(), 0.0);
+            out_edges_[base_id].push_back(sell);
+            out_edges_[quote_id].push_back(sell + 1);
+            pair_touched_.push_back(0);
+            return true;
+        }
+
+        bool CurrencyGraph::add_pair(InstrumentHandle instrument)
+        {
+            std::string base, quote;
+            if (!split_pair_symbol(instrument_symbol(instrument), base, quote))
+            {
+                return false;
+            }
+            return add_pair(instrument, base, quote);
+        }
+
+        size_t CurrencyGraph::discover_pairs(const InstrumentRegistry &registry)
+        {
+            size_t added = 0;
+            std::string base, quote;
+            size_t count = registry.size();
+            for (InstrumentHandle instrument = 0; instrument < count; ++instrument)
+            {
+                if (split_pair_symbol(registry.symbol(instrument), base, quote) &&
+                    add_pair(instrument, base, quote))
+                {
+                    ++added;
+                }
+            }
+            return added;
+        }
+
+        void CurrencyGraph::build()
+        {
+            cycles_.clear();
+
+            // Each cycle is emitted once, rooted at its smallest currency id; the two
+            // orientations of the same currencies are different trades and both appear
+            uint32_t currency_count = static_cast<uint32_t>(currency_names_.size());
+            for (uint32_t root = 0; root < currency_count; ++root)
+            {
+                for (uint32_t e1 : out_edges_[root])
+                {
+                    uint32_t a = edges_[e1].to;
+                    if (a <= root)
+                    {
+                        continue;
+                    }
+                    for (uint32_t e2 : out_edges_[a])
+                    {
+                        uint32_t b = edges_[e2].to;
+                        if (b <= root || b == a)
+                        {
+                            continue;
+                        }
+                        for (uint32_t e3 : out_edges_[b])
+                        {
+                            uint32_t c = edges_[e3].to;
+                            if (c == root)
+                            {
+                                cycles_.push_back(Cycle{{e1, e2, e3, 0}, 3});
+                            }
+                            else if (include_four_cycles_ && c > root && c != a && c != b)
+                            {
+                                for (uint32_t e4 : out_edges_[c])
+                                {
+                                    if (edges_[e4].to == root)
+                                    {
+                                        cycles_.push_back(Cycle{{e1, e2, e3, e4}, 4});
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            // Edge -> cycle index as CSR: count, prefix-sum, fill
+            edge_cycle_offsets_.assign(edges_.size() + 1, 0);
+            for (const Cycle &cycle : cycles_)
+            {
+                for (uint32_t i = 0; i < cycle.length; ++i)
+                {
+                    ++edge_cycle_offsets_[cycle.edges[i] + 1];
+                }
+            }
+            for (size_t edge = 0; edge < edges_.size(); ++edge)
+            {
+                edge_cycle_offsets_[edge + 1] += edge_cycle_offsets_[edge];
+            }
+            edge_cycle_ids_.resize(edge_cycle_offsets_.back());
+            std::vector<uint32_t> cursor(edge_cycle_offsets_.begin(), edge_cycle_offsets_.end() - 1);
+            for (uint32_t id = 0; id < cycles_.size(); ++id)
+            {
+                for (uint32_t i = 0; i < cycles_[id].length; ++i)
+                {
+                    edge_cycle_ids_[cursor[cycles_[id].edges[i]]++] = id;
+                }
+            }
+
+            cycle_log_returns_.assign(cycles_.size(), NO_RATE);
+            cycle_epochs_.assign(cycles_.size(), 0);
+            epoch_ = 0;
+            profitable_.clear();
+            profitable_position_.assign(cycles_.size(), NOT_PROFITABLE);
+
+            // Rates that arrived before the build still count: re-score everything quoted
+            touched_pairs_.clear();
+            for (uint32_t pair = 0; pair < pair_instruments_.size(); ++pair)
+            {
+                pair_touched_[pair] = edge_log_rates_[2 * pair] != NO_RATE;
+                if (pair_touched_[pair])
+                {
+                    touched_pairs_.push_back(pair);
+                }
+            }
+        }
+
+        void CurrencyGraph::clear()
+        {
+            currency_ids_.clear();
+            currency_names_.clear();
+            pair_instruments_.clear();
+            pair_by_instrument_.clear();
+            edges_.clear();
+            edge_log_rates_.clear();
+            edge_prices_.clear();
+            out_edges_.clear();
+            cycles_.clear();
+            edge_cycle_offsets_.clear();
+            edge_cycle_ids_.clear();
+            cycle_log_returns_.clear();
+            cycle_epochs_.clear();
+            touched_pairs_.clear();
+            pair_touched_.clear();
+            epoch_ = 0;
+            profitable_.clear();
+            profitable_position_.clear();
+        }
+
+        void CurrencyGraph::set_fee_rate(double fee_rate)
+        {
+            fee_log_ = std::log1p(-fee_rate);
+        }
+
+        void CurrencyGraph::set_min_return(double min_return)
+        {
+            min_log_return_ = std::log1p(min_return);
+        }
+
+        bool CurrencyGraph::update_quote(InstrumentHandle instrument, Price bid, Price ask)
+        {
+            if (!has_pair(instrument))
+            {
+                return false;
+            }
+            uint32_t pair = pair_by_instrument_[instrument];
+            bool valid = bid > 0.0 && ask > 0.0 && ask >= bid;
+            edge_log_rates_[2 * pair] = valid ? std::log(bid) : NO_RATE;
+            edge_log_rates_[2 * pair + 1] = valid ? -std::log(ask) : NO_RATE;
+            edge_prices_[2 * pair] = bid;
+            edge_prices_[2 * pair + 1] = ask;
+
+            if (!pair_touched_[pair])
+            {
+                pair_touched_[pair] = 1;
+                touched_pairs_.push_back(pair);
+            }
+            return true;
+        }
+
+        void CurrencyGraph::apply_snapshot(const MarketSnapshot &snapshot, bool full)
+        {
+            if (!snapshot.store())
+            {
+                return;
+            }
+            const auto &instruments = full ? snapshot.instruments() : snapshot.dirty_instruments();
+            for (InstrumentHandle instrument : instruments)
+            {
+                if (has_pair(instrument) && snapshot.has_quote(instrument))
+                {
+                    update_quote(instrument, snapshot.bid_price(instrument), snapshot.ask_price(instrument));
+                }
+            }
+        }
+
+        double CurrencyGraph::score_cycle(const Cycle &cycle) const
+        {
+            double log_return = cycle.length * fee_log_;
+            for (uint32_t i = 0; i < cycle.length; ++i)
+            {
+                log_return += edge_log_rates_[cycle.edges[i]];
+            }
+            return log_return;
+        }
+
+        void CurrencyGraph::set_profitable(uint32_t cycle, bool profitable)
+        {
+            uint32_t position = profitable_position_[cycle];
+            if (profitable && position == NOT_PROFITABLE)
+            {
+                profitable_position_[cycle] = static_cast<uint32_t>(profitable_.size());
+                profitable_.push_back(cycle);
+            }
+            else if (!profitable && position != NOT_PROFITABLE)
+            {
+                uint32_t moved = profitable_.back();
+                profitable_[position] = moved;
+                profitable_position_[moved] = position;
+                profitable_.pop_back();
+                profitable_position_[cycle] = NOT_PROFITABLE;
+            }
+        }
+
+    } // namespace graph
+} // namespace spe
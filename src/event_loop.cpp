@@ -0,0 +1,375 @@
+#include "event_loop.hpp"
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace spe
+{
+    namespace gateway
+    {
+
+        namespace
+        {
+            constexpr uint32_t NO_SLOT = UINT32_MAX;
+            constexpr size_t MAX_EVENTS = 64; // per epoll_wait
+
+            TimerHandle make_handle(uint32_t slot, uint32_t generation)
+            {
+                return (static_cast<uint64_t>(generation) << 32) | (static_cast<uint64_t>(slot) + 1);
+            }
+
+#if defined(__linux__)
+            uint32_t to_epoll(uint32_t events)
+            {
+                return ((events & IO_READ) ? uint32_t(EPOLLIN) : 0u) | ((events & IO_WRITE) ? uint32_t(EPOLLOUT) : 0u) |
+                       uint32_t(EPOLLRDHUP);
+            }
+
+            uint32_t from_epoll(uint32_t events)
+            {
+                return ((events & EPOLLIN) ? IO_READ : 0) | ((events & EPOLLOUT) ? IO_WRITE : 0) |
+                       ((events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) ? IO_ERROR : 0);
+            }
+#endif
+        }
+
+        EventLoop::EventLoop() : poll_fd_(-1), wake_fd_(-1), dispatching_(false), stopping_(false)
+        {
+#if defined(__linux__)
+            poll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+            wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (poll_fd_ < 0 || wake_fd_ < 0)
+            {
+                if (poll_fd_ >= 0)
+                {
+                    ::close(poll_fd_);
+                }
+                poll_fd_ = -1;
+                return;
+            }
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = UINT64_MAX; // the wake fd has no watch slot
+            epoll_ctl(poll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+#endif
+        }
+
+        EventLoop::~EventLoop()
+        {
+#if defined(__linux__)
+            if (poll_fd_ >= 0)
+            {
+                ::close(poll_fd_);
+            }
+            if (wake_fd_ >= 0)
+            {
+                ::close(wake_fd_);
+            }
+#endif
+        }
+
+        uint32_t EventLoop::find_watch(int fd) const
+        {
+            return fd >= 0 && static_cast<size_t>(fd) < slot_by_fd_.size() ? slot_by_fd_[fd] : NO_SLOT;
+        }
+
+        void EventLoop::free_watch(uint32_t slot)
+        {
+            watches_[slot].handler = nullptr;
+            free_watches_.push_back(slot);
+        }
+
+        bool EventLoop::watch(int fd, uint32_t events, IoHandler handler)
+        {
+#if defined(__linux__)
+            if (!valid() || fd < 0 || find_watch(fd) != NO_SLOT)
+            {
+                return false;
+            }
+            uint32_t slot;
+            if (free_watches_.empty())
+            {
+                slot = static_cast<uint32_t>(watches_.size());
+                watches_.emplace_back();
+            }
+            else
+            {
+                slot = free_watches_.back();
+                free_watches_.pop_back();
+            }
+            Watch &entry = watches_[slot];
+            epoll_event event{};
+            event.events = to_epoll(events);
+            event.data.u64 = (static_cast<uint64_t>(entry.generation) << 32) | slot;
+            if (epoll_ctl(poll_fd_, EPOLL_CTL_ADD, fd, &event) != 0)
+            {
+                free_watches_.push_back(slot);
+                return false;
+            }
+            entry.fd = fd;
+            entry.handler = std::move(handler);
+            if (slot_by_fd_.size() <= static_cast<size_t>(fd))
+            {
+                slot_by_fd_.resize(fd + 1, NO_SLOT);
+            }
+            slot_by_fd_[fd] = slot;
+            return true;
+#else
+            (void)fd;
+            (void)events;
+            (void)handler;
+            return false;
+#endif
+        }
+
+        bool EventLoop::modify(int fd, uint32_t events)
+        {
+#if defined(__linux__)
+            uint32_t slot = find_watch(fd);
+            if (slot == NO_SLOT)
+            {
+                return false;
+            }
+            epoll_event event{};
+            event.events = to_epoll(events);
+            event.data.u64 = (static_cast<uint64_t>(watches_[slot].generation) << 32) | slot;
+            return epoll_ctl(poll_fd_, EPOLL_CTL_MOD, fd, &event) == 0;
+#else
+            (void)fd;
+            (void)events;
+            return false;
+#endif
+        }
+
+        void EventLoop::unwatch(int fd)
+        {
+            uint32_t slot = find_watch(fd);
+            if (slot == NO_SLOT)
+            {
+                return;
+            }
+#if defined(__linux__)
+            epoll_ctl(poll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+            slot_by_fd_[fd] = NO_SLOT;
+            Watch &entry = watches_[slot];
+            entry.fd = -1;
+            ++entry.generation; // events already fetched for it are skipped
+            if (dispatching_)
+            {
+                retired_watches_.push_back(slot); // its handler may be the one running
+            }
+            else
+            {
+                free_watch(slot);
+            }
+        }
+
+        TimerHandle EventLoop::schedule_after(std::chrono::milliseconds delay, LoopTask handler)
+        {
+            uint32_t slot;
+            if (free_timers_.empty())
+            {
+                slot = static_cast<uint32_t>(timers_.size());
+                timers_.emplace_back();
+            }
+            else
+            {
+                slot = free_timers_.back();
+                free_timers_.pop_back();
+            }
+            Timer &timer = timers_[slot];
+            timer.active = true;
+            timer.handler = std::move(handler);
+            deadlines_.push(Deadline{Clock::now() + delay, slot, timer.generation});
+            return make_handle(slot, timer.generation);
+        }
+
+        bool EventLoop::cancel(TimerHandle handle)
+        {
+            if (handle == INVALID_TIMER_HANDLE)
+            {
+                return false;
+            }
+            uint32_t slot = static_cast<uint32_t>(handle & 0xffffffffu) - 1;
+            uint32_t generation = static_cast<uint32_t>(handle >> 32);
+            if (slot >= timers_.size() || !timers_[slot].active || timers_[slot].generation != generation)
+            {
+                return false;
+            }
+            // The heap entry stays until it surfaces and is skipped for its stale generation.
+            // A running timer's slot is already free, so this is never the running handler.
+            Timer &timer = timers_[slot];
+            timer.handler = nullptr;
+            timer.active = false;
+            ++timer.generation;
+            free_timers_.push_back(slot);
+            return true;
+        }
+
+        void EventLoop::post(LoopTask task)
+        {
+            {
+                std::lock_guard<std::mutex> lock(post_mutex_);
+                posted_.push_back(std::move(task));
+            }
+#if defined(__linux__)
+            uint64_t one = 1;
+            if (wake_fd_ >= 0)
+            {
+                ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+                (void)written; // a full counter already wakes the loop
+            }
+#endif
+        }
+
+        size_t EventLoop::run_posted()
+        {
+            {
+                std::lock_guard<std::mutex> lock(post_mutex_);
+                running_.swap(posted_);
+            }
+            size_t ran = running_.size();
+            for (auto &task : running_)
+            {
+                task();
+            }
+            running_.clear();
+            return ran;
+        }
+
+        size_t EventLoop::run_timers()
+        {
+            size_t fired = 0;
+            Clock::time_point now = Clock::now();
+            while (!deadlines_.empty() && deadlines_.top().when <= now)
+            {
+                Deadline due = deadlines_.top();
+                deadlines_.pop();
+                Timer &timer = timers_[due.slot];
+                if (!timer.active || timer.generation != due.generation)
+                {
+                    continue; // cancelled
+                }
+                // Free the slot first: the handler may schedule, and may reuse it
+                LoopTask handler = std::move(timer.handler);
+                timer.handler = nullptr;
+                timer.active = false;
+                ++timer.generation;
+                free_timers_.push_back(due.slot);
+                handler();
+                ++fired;
+            }
+            return fired;
+        }
+
+        size_t EventLoop::run_once(std::chrono::milliseconds max_wait)
+        {
+            size_t ran = run_posted();
+            ran += run_timers();
+            if (!valid())
+            {
+                return ran;
+            }
+
+#if defined(__linux__)
+            // Sleep until the next deadline at most
+            auto wait = max_wait;
+            if (ran > 0)
+            {
+                wait = std::chrono::milliseconds(0);
+            }
+            else if (!deadlines_.empty())
+            {
+                auto until = std::chrono::ceil<std::chrono::milliseconds>(deadlines_.top().when - Clock::now());
+                wait = std::max(std::chrono::milliseconds(0), std::min(wait, until));
+            }
+
+            epoll_event events[MAX_EVENTS];
+            dispatching_ = true;
+            int count = epoll_wait(poll_fd_, events, static_cast<int>(MAX_EVENTS), static_cast<int>(wait.count()));
+            for (int i = 0; i < count; ++i)
+            {
+                uint64_t data = events[i].data.u64;
+                if (data == UINT64_MAX)
+                {
+                    uint64_t drained;
+                    ssize_t got = ::read(wake_fd_, &drained, sizeof(drained));
+                    (void)got;
+                    continue;
+                }
+                uint32_t slot = static_cast<uint32_t>(data & 0xffffffffu);
+                uint32_t generation = static_cast<uint32_t>(data >> 32);
+                if (slot >= watches_.size() || watches_[slot].generation != generation || !watches_[slot].handler)
+                {
+                    continue; // unwatched earlier in this round
+                }
+                watches_[slot].handler(from_epoll(events[i].events));
+                ++ran;
+            }
+            dispatching_ = false;
+            for (uint32_t slot : retired_watches_)
+            {
+                free_watch(slot);
+            }
+            retired_watches_.clear();
+#else
+            (void)max_wait;
+#endif
+
+            ran += run_posted();
+            ran += run_timers();
+            return ran;
+        }
+
+        void EventLoop::run()
+        {
+            while (!stopping_.load(std::memory_order_acquire))
+            {
+                run_once(std::chrono::milliseconds(100));
+            }
+        }
+
+        void EventLoop::run(const concurrency::StagePlacement &placement)
+        {
+            concurrency::apply_placement(placement);
+            if (placement.wait == concurrency::WaitPolicy::SLEEP)
+            {
+                run();
+                return;
+            }
+
+            uint32_t empty_rounds = 0;
+            while (!stopping_.load(std::memory_order_acquire))
+            {
+                bool spinning = placement.wait == concurrency::WaitPolicy::BUSY_POLL ||
+                                empty_rounds < placement.spin_iterations;
+                if (run_once(std::chrono::milliseconds(spinning ? 0 : 100)) > 0)
+                {
+                    empty_rounds = 0;
+                }
+                else if (spinning)
+                {
+                    ++empty_rounds;
+                    concurrency::cpu_relax();
+                }
+            }
+        }
+
+        void EventLoop::stop()
+        {
+            stopping_.store(true, std::memory_order_release);
+            post([] {}); // wake the loop
+        }
+
+        void EventLoop::reset()
+        {
+            stopping_.store(false, std::memory_order_release);
+        }
+
+    } // namespace gateway
+} // namespace spe
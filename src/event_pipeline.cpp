@@ -0,0 +1,366 @@
+#include "event_pipeline.hpp"
+#include <algorithm>
+
+namespace spe
+{
+    namespace pipeline
+    {
+
+        namespace
+        {
+            void record_high_watermark(std::atomic<size_t> &watermark, size_t depth)
+            {
+                size_t current = watermark.load(std::memory_order_relaxed);
+                while (depth > current && !watermark.compare_exchange_weak(current, depth, std::memory_order_relaxed))
+                {
+                }
+            }
+
+            // Identifies an opportunity across batches: detectors re-report every active one
+            uint64_t detection_key(const MispricingOpportunity &opportunity)
+            {
+                uint64_t key = 1469598103934665603ULL;
+                auto mix = [&key](uint64_t value)
+                {
+                    key ^= value;
+                    key *= 1099511628211ULL;
+                };
+                mix(static_cast<uint64_t>(opportunity.type));
+                mix(opportunity.target_instrument);
+                for (auto component : opportunity.component_instruments)
+                {
+                    mix(component);
+                }
+                return key;
+            }
+        }
+
+        MarketEventPipeline::MarketEventPipeline(std::unique_ptr<IMispricingDetector> detector,
+                                                 std::unique_ptr<IArbitrageEngine> arbitrage_engine,
+                                                 const PipelineConfig &config)
+            : config_(config), detector_(std::move(detector)), arbitrage_engine_(std::move(arbitrage_engine)),
+              shared_ingress_(config.shared_ingress_capacity), detections_(config.detection_capacity),
+              running_(false), batch_started_(false)
+        {
+            auto &monitor = telemetry::LatencyMonitor::instance();
+            queue_series_ = monitor.series(config_.latency_source, telemetry::LatencyStage::QUEUE);
+            detection_series_ = monitor.series(config_.latency_source, telemetry::LatencyStage::DETECTION);
+            validation_series_ = monitor.series(config_.latency_source, telemetry::LatencyStage::VALIDATION);
+            callback_series_ = monitor.series(config_.latency_source, telemetry::LatencyStage::CALLBACK);
+            end_to_end_series_ = monitor.series(config_.latency_source, telemetry::LatencyStage::END_TO_END);
+            // The stage stores are sized on their own threads, see detector_loop/arbitrage_loop
+        }
+
+        MarketEventPipeline::~MarketEventPipeline()
+        {
+            stop();
+        }
+
+        ProducerId MarketEventPipeline::register_producer(const std::string &name)
+        {
+            if (running_.load(std::memory_order_acquire))
+            {
+                return INVALID_PRODUCER;
+            }
+
+            producers_.push_back(std::make_unique<Producer>(name, config_.ingress_capacity));
+            return producers_.size() - 1;
+        }
+
+        template <typename Ring, typename Event>
+        bool MarketEventPipeline::push(Ring &ring, Event &&event, OverflowPolicy policy, StageCounters &counters)
+        {
+            // try_push only moves from the event on success, so retrying is safe
+            if (!ring.try_push(std::move(event)))
+            {
+                if (policy == OverflowPolicy::DROP_NEWEST)
+                {
+                    counters.dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                counters.backpressure_waits.fetch_add(1, std::memory_order_relaxed);
+                while (!ring.try_push(std::move(event)))
+                {
+                    // Nobody will drain a stopped pipeline
+                    if (!running_.load(std::memory_order_acquire))
+                    {
+                        counters.dropped.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+                    std::this_thread::yield();
+                }
+            }
+
+            counters.enqueued.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        template <typename Ring>
+        size_t MarketEventPipeline::drain(Ring &ring, StageCounters &counters, size_t max_items)
+        {
+            record_high_watermark(counters.high_watermark, ring.size_approx());
+            size_t count = ring.pop_batch([this](MarketEvent &event)
+                                          { apply_event(event); },
+                                          max_items);
+            if (count > 0)
+            {
+                counters.dequeued.fetch_add(count, std::memory_order_relaxed);
+                counters.batches.fetch_add(1, std::memory_order_relaxed);
+            }
+            return count;
+        }
+
+        bool MarketEventPipeline::publish(ProducerId producer, MarketEvent &&event)
+        {
+            if (producer >= producers_.size())
+            {
+                return false;
+            }
+
+            auto &entry = *producers_[producer];
+            return push(entry.ring, std::move(event), config_.ingress_policy, entry.counters);
+        }
+
+        bool MarketEventPipeline::publish(MarketEvent &&event)
+        {
+            return push(shared_ingress_, std::move(event), config_.ingress_policy, shared_counters_);
+        }
+
+        bool MarketEventPipeline::start()
+        {
+            if (!detector_ || !arbitrage_engine_ || running_.exchange(true))
+            {
+                return false;
+            }
+
+            detector_thread_ = std::thread(&MarketEventPipeline::detector_loop, this);
+            arbitrage_thread_ = std::thread(&MarketEventPipeline::arbitrage_loop, this);
+            return true;
+        }
+
+        void MarketEventPipeline::stop()
+        {
+            running_.store(false, std::memory_order_release);
+            if (detector_thread_.joinable())
+            {
+                detector_thread_.join();
+            }
+            if (arbitrage_thread_.joinable())
+            {
+                arbitrage_thread_.join();
+            }
+        }
+
+        void MarketEventPipeline::apply_event(MarketEvent &event)
+        {
+            SPE_LATENCY_RECORD_SINCE(queue_series_, event.receive_time);
+            if (!batch_started_ || event.receive_time < batch_receive_time_)
+            {
+                batch_receive_time_ = event.receive_time;
+                batch_started_ = true;
+            }
+
+            if (auto quote = std::get_if<Quote>(&event.payload))
+            {
+                detector_store_.apply_quote(*quote);
+            }
+            else if (auto trade = std::get_if<Trade>(&event.payload))
+            {
+                detector_store_.apply_trade(*trade);
+            }
+            else if (auto depth = std::get_if<MarketDepth>(&event.payload))
+            {
+                detector_store_.apply_depth(*depth);
+            }
+        }
+
+        void MarketEventPipeline::forward_detections(std::vector<MispricingOpportunity> &opportunities,
+                                                     const MarketSnapshot &snapshot)
+        {
+            // Only opportunities absent from the previous batch go downstream; one that lapses
+            // and is raised again is forwarded again. One the ring dropped is not open yet, so
+            // the next batch that still reports it retries it.
+            batch_detections_.clear();
+            forwarded_detections_.clear();
+            for (auto &opportunity : opportunities)
+            {
+                uint64_t key = detection_key(opportunity);
+                if (!batch_detections_.insert(key).second)
+                {
+                    continue;
+                }
+                if (open_detections_.count(key) != 0)
+                {
+                    forwarded_detections_.insert(key);
+                    continue;
+                }
+
+                DetectionEvent detection;
+                auto carry = [&](InstrumentHandle instrument)
+                {
+                    if (instrument != INVALID_INSTRUMENT && snapshot.has_quote(instrument))
+                    {
+                        detection.quotes.push_back(snapshot.quote(instrument));
+                    }
+                    if (const MarketDepth *depth = snapshot.depth(instrument))
+                    {
+                        detection.depths.push_back(*depth);
+                    }
+                };
+                carry(opportunity.target_instrument);
+                for (auto component : opportunity.component_instruments)
+                {
+                    carry(component);
+                }
+
+                detection.opportunity = std::move(opportunity);
+                detection.source_time = batch_receive_time_;
+                if (push(detections_, std::move(detection), config_.detection_policy, detection_counters_))
+                {
+                    forwarded_detections_.insert(key);
+                }
+            }
+            open_detections_.swap(forwarded_detections_);
+        }
+
+        void MarketEventPipeline::detector_loop()
+        {
+            concurrency::apply_placement(config_.detector_stage);
+            // First touch from the stage thread, on its node
+            detector_store_.reserve(InstrumentRegistry::instance().size());
+            if (detector_init_)
+            {
+                detector_init_();
+            }
+            concurrency::IdleStrategy idle(config_.detector_stage);
+
+            while (running_.load(std::memory_order_acquire))
+            {
+                size_t drained = 0;
+                for (auto &producer : producers_)
+                {
+                    drained += drain(producer->ring, producer->counters, config_.detector_batch_size);
+                }
+                drained += drain(shared_ingress_, shared_counters_, config_.detector_batch_size);
+
+                if (drained == 0)
+                {
+                    idle.idle();
+                    continue;
+                }
+                idle.reset();
+
+                // One snapshot per drained batch; detectors only see the net state change
+                auto snapshot = detector_store_.publish();
+                std::vector<MispricingOpportunity> opportunities;
+                {
+                    SPE_LATENCY_SCOPE(detection_series_);
+                    detector_->update_market_data(snapshot);
+                    opportunities = detector_->detect_opportunities();
+                }
+                forward_detections(opportunities, snapshot);
+                batch_started_ = false;
+                if (detector_checkpointer_)
+                {
+                    detector_checkpointer_->maybe_capture(std::chrono::high_resolution_clock::now());
+                }
+            }
+        }
+
+        void MarketEventPipeline::arbitrage_loop()
+        {
+            concurrency::apply_placement(config_.arbitrage_stage);
+            arbitrage_store_.reserve(InstrumentRegistry::instance().size());
+            if (arbitrage_init_)
+            {
+                arbitrage_init_();
+            }
+            concurrency::IdleStrategy idle(config_.arbitrage_stage);
+
+            std::vector<MispricingOpportunity> batch;
+            batch.reserve(config_.arbitrage_batch_size);
+            Timestamp batch_source_time;
+
+            while (running_.load(std::memory_order_acquire))
+            {
+                record_high_watermark(detection_counters_.high_watermark, detections_.size_approx());
+                batch.clear();
+                size_t count = detections_.pop_batch([&](DetectionEvent &detection)
+                                                     {
+                                                         for (const auto &quote : detection.quotes)
+                                                         {
+                                                             arbitrage_store_.apply_quote(quote);
+                                                         }
+                                                         for (const auto &depth : detection.depths)
+                                                         {
+                                                             arbitrage_store_.apply_depth(depth);
+                                                         }
+                                                         if (batch.empty() || detection.source_time < batch_source_time)
+                                                         {
+                                                             batch_source_time = detection.source_time;
+                                                         }
+                                                         batch.push_back(std::move(detection.opportunity)); },
+                                                     config_.arbitrage_batch_size);
+                if (count == 0)
+                {
+                    idle.idle();
+                    continue;
+                }
+                idle.reset();
+                detection_counters_.dequeued.fetch_add(count, std::memory_order_relaxed);
+                detection_counters_.batches.fetch_add(1, std::memory_order_relaxed);
+
+                std::vector<ArbitrageOpportunity> found;
+                {
+                    SPE_LATENCY_SCOPE(validation_series_);
+                    arbitrage_engine_->update_market_data(arbitrage_store_.publish());
+                    arbitrage_engine_->process_mispricing_batch(batch);
+                    found = arbitrage_engine_->identify_opportunities();
+                }
+
+                if (output_callback_ && !found.empty())
+                {
+                    {
+                        SPE_LATENCY_SCOPE(callback_series_);
+                        output_callback_(found);
+                    }
+                    SPE_LATENCY_RECORD_SINCE(end_to_end_series_, batch_source_time);
+                }
+                if (arbitrage_checkpointer_)
+                {
+                    arbitrage_checkpointer_->maybe_capture(std::chrono::high_resolution_clock::now());
+                }
+            }
+        }
+
+        std::vector<StageStatistics> MarketEventPipeline::get_stage_statistics() const
+        {
+            std::vector<StageStatistics> stats;
+            auto collect = [&stats](const std::string &stage, const StageCounters &counters,
+                                    size_t depth, size_t capacity)
+            {
+                StageStatistics s;
+                s.stage = stage;
+                s.enqueued = counters.enqueued.load(std::memory_order_relaxed);
+                s.dequeued = counters.dequeued.load(std::memory_order_relaxed);
+                s.dropped = counters.dropped.load(std::memory_order_relaxed);
+                s.backpressure_waits = counters.backpressure_waits.load(std::memory_order_relaxed);
+                s.batches = counters.batches.load(std::memory_order_relaxed);
+                s.high_watermark = counters.high_watermark.load(std::memory_order_relaxed);
+                s.depth = depth;
+                s.capacity = capacity;
+                stats.push_back(s);
+            };
+
+            for (const auto &producer : producers_)
+            {
+                collect("ingress:" + producer->name, producer->counters, producer->ring.size_approx(), producer->ring.capacity());
+            }
+            collect("ingress:shared", shared_counters_, shared_ingress_.size_approx(), shared_ingress_.capacity());
+            collect("detections", detection_counters_, detections_.size_approx(), detections_.capacity());
+            return stats;
+        }
+
+    } // namespace pipeline
+} // namespace spe
@@ -0,0 +1,430 @@
+#include "exchange_gateway.hpp"
+#include <limits>
+
+namespace spe
+{
+    namespace gateway
+    {
+
+        ExchangeGateway::ExchangeGateway(std::shared_ptr<EventLoop> loop, std::string venue, std::string url,
+                                         const GatewayLimits &limits, TransportFactory factory)
+            : loop_(std::move(loop)), venue_(std::move(venue)), url_(std::move(url)), limits_(limits),
+              factory_(std::move(factory)), connect_bucket_(limits.connects_per_second, limits.connect_burst),
+              jitter_(static_cast<unsigned>(std::hash<std::string>()(venue_) ^ std::random_device()())), running_(false)
+        {
+            size_t count = std::max<size_t>(limits_.connections, 1);
+            shards_.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                shards_.push_back(std::make_unique<Shard>());
+                shards_.back()->bucket = TokenBucket(limits_.subscribes_per_second, limits_.subscribe_burst);
+                shards_.back()->backoff = limits_.reconnect_initial_delay;
+            }
+        }
+
+        ExchangeGateway::~ExchangeGateway()
+        {
+            // stop() has unwatched and closed everything by now; this only covers a gateway
+            // that was never started
+            for (auto &shard : shards_)
+            {
+                if (shard->transport)
+                {
+                    shard->transport->close();
+                }
+            }
+        }
+
+        bool ExchangeGateway::start()
+        {
+            if (!loop_ || !loop_->valid() || !factory_)
+            {
+                return false;
+            }
+            auto self = shared_from_this();
+            loop_->post([self]
+                        {
+                            if (self->running_)
+                            {
+                                return;
+                            }
+                            self->running_ = true;
+                            for (size_t i = 0; i < self->shards_.size(); ++i)
+                            {
+                                self->connect_shard(i);
+                            }
+                        });
+            return true;
+        }
+
+        void ExchangeGateway::stop()
+        {
+            // The task holds the gateway until its sockets are closed on the loop thread
+            auto self = shared_from_this();
+            loop_->post([self]
+                        {
+                            self->running_ = false;
+                            for (size_t i = 0; i < self->shards_.size(); ++i)
+                            {
+                                Shard &shard = *self->shards_[i];
+                                self->loop_->cancel(shard.reconnect_timer);
+                                self->loop_->cancel(shard.drain_timer);
+                                self->loop_->cancel(shard.ping_timer);
+                                shard.reconnect_timer = shard.drain_timer = shard.ping_timer = INVALID_TIMER_HANDLE;
+                                if (shard.transport)
+                                {
+                                    self->loop_->unwatch(shard.fd);
+                                    shard.transport->close();
+                                    shard.transport.reset();
+                                    shard.fd = -1;
+                                }
+                                shard.pending.clear();
+                                self->set_state(i, TransportState::CLOSED);
+                            }
+                        });
+        }
+
+        void ExchangeGateway::subscribe(GatewaySubscription subscription)
+        {
+            auto self = shared_from_this();
+            loop_->post([self, subscription = std::move(subscription)]() mutable
+                        { self->do_subscribe(std::move(subscription)); });
+        }
+
+        void ExchangeGateway::unsubscribe(const std::string &key)
+        {
+            auto self = shared_from_this();
+            loop_->post([self, key] { self->do_unsubscribe(key); });
+        }
+
+        void ExchangeGateway::send_on_subscription_shard(const std::string &key, std::string message)
+        {
+            auto self = shared_from_this();
+            loop_->post([self, key, message = std::move(message)]() mutable
+                        {
+                            auto it = self->subscriptions_.find(key);
+                            if (it != self->subscriptions_.end())
+                            {
+                                self->enqueue(it->second.shard, std::move(message));
+                            }
+                        });
+        }
+
+        size_t ExchangeGateway::pick_shard() const
+        {
+            size_t best = shards_.size();
+            size_t best_count = std::numeric_limits<size_t>::max();
+            for (size_t i = 0; i < shards_.size(); ++i)
+            {
+                size_t count = shards_[i]->keys.size();
+                if (limits_.max_subscriptions_per_connection != 0 && count >= limits_.max_subscriptions_per_connection)
+                {
+                    continue;
+                }
+                if (count < best_count)
+                {
+                    best = i;
+                    best_count = count;
+                }
+            }
+            return best;
+        }
+
+        void ExchangeGateway::do_subscribe(GatewaySubscription subscription)
+        {
+            if (subscriptions_.count(subscription.key))
+            {
+                return; // already routed; it stays on its shard
+            }
+            size_t shard = pick_shard();
+            if (shard == shards_.size())
+            {
+                report(shard, "every connection is at its subscription cap; dropped " + subscription.key);
+                return;
+            }
+            Shard &target = *shards_[shard];
+            target.keys.insert(subscription.key);
+            target.subscription_count.store(target.keys.size(), std::memory_order_relaxed);
+            // A closed or connecting shard replays its keys once open
+            if (target.state == TransportState::OPEN)
+            {
+                enqueue(shard, subscription.subscribe_message);
+            }
+            subscriptions_.emplace(subscription.key,
+                                   Subscription{shard, std::move(subscription.subscribe_message),
+                                                std::move(subscription.unsubscribe_message)});
+        }
+
+        void ExchangeGateway::do_unsubscribe(const std::string &key)
+        {
+            auto it = subscriptions_.find(key);
+            if (it == subscriptions_.end())
+            {
+                return;
+            }
+            Shard &shard = *shards_[it->second.shard];
+            shard.keys.erase(key);
+            shard.subscription_count.store(shard.keys.size(), std::memory_order_relaxed);
+            if (shard.state == TransportState::OPEN && !it->second.unsubscribe_message.empty())
+            {
+                enqueue(it->second.shard, std::move(it->second.unsubscribe_message));
+            }
+            subscriptions_.erase(it);
+        }
+
+        void ExchangeGateway::connect_shard(size_t index)
+        {
+            Shard &shard = *shards_[index];
+            shard.reconnect_timer = INVALID_TIMER_HANDLE;
+            if (!running_ || shard.transport)
+            {
+                return;
+            }
+            Clock::time_point now = Clock::now();
+            if (!connect_bucket_.try_take(now))
+            {
+                throttled_.fetch_add(1, std::memory_order_relaxed);
+                schedule_reconnect(index, connect_bucket_.wait_time(now));
+                return;
+            }
+
+            shard.transport = factory_(index);
+            connects_.fetch_add(1, std::memory_order_relaxed);
+            if (!shard.transport || !shard.transport->open(url_))
+            {
+                drop_shard(index, "connect to " + url_ + " failed");
+                return;
+            }
+            shard.fd = shard.transport->native_handle();
+            uint32_t events = IO_READ | (shard.transport->wants_write() ? IO_WRITE : 0);
+            if (!loop_->watch(shard.fd, events, [this, index](uint32_t ready) { on_shard_ready(index, ready); }))
+            {
+                drop_shard(index, "cannot watch connection");
+                return;
+            }
+            shard.last_frame = now;
+            set_state(index, TransportState::CONNECTING);
+            arm_ping(index); // also bounds a connect or handshake that never completes
+        }
+
+        void ExchangeGateway::on_shard_ready(size_t index, uint32_t events)
+        {
+            Shard &shard = *shards_[index];
+            TransportState previous = shard.state;
+            TransportState state = shard.transport->on_ready(events, [this, index, &shard](const std::string &frame)
+                                                             {
+                                                                 shard.last_frame = Clock::now();
+                                                                 messages_received_.fetch_add(1, std::memory_order_relaxed);
+                                                                 if (message_handler_)
+                                                                 {
+                                                                     message_handler_(index, frame);
+                                                                 }
+                                                             });
+            if (state == TransportState::CLOSED)
+            {
+                drop_shard(index, "connection closed");
+                return;
+            }
+            if (state == TransportState::OPEN && previous != TransportState::OPEN)
+            {
+                on_shard_open(index);
+            }
+            if (shard.transport)
+            {
+                loop_->modify(shard.fd, IO_READ | (shard.transport->wants_write() ? IO_WRITE : 0));
+            }
+        }
+
+        void ExchangeGateway::on_shard_open(size_t index)
+        {
+            Shard &shard = *shards_[index];
+            shard.backoff = limits_.reconnect_initial_delay;
+            shard.last_frame = Clock::now();
+            set_state(index, TransportState::OPEN);
+
+            // Replay only this shard's subscriptions, behind its own bucket
+            shard.pending.clear();
+            for (const auto &key : shard.keys)
+            {
+                enqueue(index, subscriptions_[key].subscribe_message);
+            }
+            arm_ping(index);
+        }
+
+        void ExchangeGateway::arm_ping(size_t index)
+        {
+            Shard &shard = *shards_[index];
+            loop_->cancel(shard.ping_timer);
+            shard.ping_timer = INVALID_TIMER_HANDLE;
+            if (limits_.ping_interval.count() > 0)
+            {
+                shard.ping_timer = loop_->schedule_after(limits_.ping_interval, [this, index] { ping(index); });
+            }
+        }
+
+        void ExchangeGateway::drop_shard(size_t index, const std::string &reason)
+        {
+            Shard &shard = *shards_[index];
+            bool was_open = shard.state == TransportState::OPEN;
+            if (shard.transport)
+            {
+                if (shard.fd >= 0)
+                {
+                    loop_->unwatch(shard.fd);
+                }
+                shard.transport->close();
+                shard.transport.reset();
+            }
+            shard.fd = -1;
+            shard.pending.clear(); // the replay on reopen covers what is still subscribed
+            loop_->cancel(shard.drain_timer);
+            loop_->cancel(shard.ping_timer);
+            shard.drain_timer = shard.ping_timer = INVALID_TIMER_HANDLE;
+            set_state(index, TransportState::CLOSED);
+            report(index, reason);
+            if (!running_)
+            {
+                return;
+            }
+
+            // Equal jitter: half the backoff fixed, half random, so shards dropped together
+            // spread out rather than reconnecting in lockstep
+            if (was_open)
+            {
+                reconnects_.fetch_add(1, std::memory_order_relaxed);
+            }
+            auto delay = shard.backoff;
+            std::uniform_int_distribution<int64_t> spread(0, delay.count() / 2);
+            schedule_reconnect(index, delay / 2 + std::chrono::milliseconds(spread(jitter_)));
+            shard.backoff = std::min(limits_.reconnect_max_delay, shard.backoff * 2);
+        }
+
+        void ExchangeGateway::schedule_reconnect(size_t index, std::chrono::milliseconds delay)
+        {
+            Shard &shard = *shards_[index];
+            if (shard.reconnect_timer != INVALID_TIMER_HANDLE)
+            {
+                return;
+            }
+            shard.reconnect_timer = loop_->schedule_after(delay, [this, index] { connect_shard(index); });
+        }
+
+        void ExchangeGateway::enqueue(size_t index, std::string message)
+        {
+            Shard &shard = *shards_[index];
+            shard.pending.push_back(std::move(message));
+            if (shard.drain_timer == INVALID_TIMER_HANDLE)
+            {
+                drain(index); // otherwise the armed drain picks it up
+            }
+        }
+
+        void ExchangeGateway::drain(size_t index)
+        {
+            Shard &shard = *shards_[index];
+            shard.drain_timer = INVALID_TIMER_HANDLE;
+            if (shard.state != TransportState::OPEN)
+            {
+                return;
+            }
+            Clock::time_point now = Clock::now();
+            while (!shard.pending.empty())
+            {
+                if (!shard.bucket.try_take(now))
+                {
+                    throttled_.fetch_add(1, std::memory_order_relaxed);
+                    shard.drain_timer = loop_->schedule_after(shard.bucket.wait_time(now), [this, index] { drain(index); });
+                    return;
+                }
+                if (!shard.transport->send(shard.pending.front()))
+                {
+                    drop_shard(index, "send failed");
+                    return;
+                }
+                shard.pending.pop_front();
+                subscribes_sent_.fetch_add(1, std::memory_order_relaxed);
+            }
+            loop_->modify(shard.fd, IO_READ | (shard.transport->wants_write() ? IO_WRITE : 0));
+        }
+
+        void ExchangeGateway::ping(size_t index)
+        {
+            Shard &shard = *shards_[index];
+            shard.ping_timer = INVALID_TIMER_HANDLE;
+            if (shard.state == TransportState::CLOSED)
+            {
+                return;
+            }
+            if (Clock::now() - shard.last_frame > limits_.stale_timeout)
+            {
+                drop_shard(index, shard.state == TransportState::OPEN ? "no data within the stale timeout"
+                                                                      : "connect timed out");
+                return;
+            }
+            // Keep-alives bypass the subscribe bucket
+            if (shard.state == TransportState::OPEN && !limits_.ping_payload.empty() &&
+                !shard.transport->send(limits_.ping_payload))
+            {
+                drop_shard(index, "ping failed");
+                return;
+            }
+            shard.ping_timer = loop_->schedule_after(limits_.ping_interval, [this, index] { ping(index); });
+        }
+
+        void ExchangeGateway::set_state(size_t index, TransportState state)
+        {
+            Shard &shard = *shards_[index];
+            if (shard.state == state)
+            {
+                return;
+            }
+            shard.state = state;
+            shard.published_state.store(state, std::memory_order_release);
+            if (state_handler_)
+            {
+                state_handler_(index, state);
+            }
+        }
+
+        void ExchangeGateway::report(size_t shard, const std::string &error)
+        {
+            if (error_handler_)
+            {
+                error_handler_(shard, venue_ + ": " + error);
+            }
+        }
+
+        TransportState ExchangeGateway::shard_state(size_t shard) const
+        {
+            return shard < shards_.size() ? shards_[shard]->published_state.load(std::memory_order_acquire)
+                                          : TransportState::CLOSED;
+        }
+
+        size_t ExchangeGateway::shard_subscription_count(size_t shard) const
+        {
+            return shard < shards_.size() ? shards_[shard]->subscription_count.load(std::memory_order_relaxed) : 0;
+        }
+
+        size_t ExchangeGateway::open_shard_count() const
+        {
+            size_t open = 0;
+            for (const auto &shard : shards_)
+            {
+                open += shard->published_state.load(std::memory_order_acquire) == TransportState::OPEN;
+            }
+            return open;
+        }
+
+        GatewayStats ExchangeGateway::stats() const
+        {
+            GatewayStats stats;
+            stats.connects = connects_.load(std::memory_order_relaxed);
+            stats.reconnects = reconnects_.load(std::memory_order_relaxed);
+            stats.subscribes_sent = subscribes_sent_.load(std::memory_order_relaxed);
+            stats.messages_received = messages_received_.load(std::memory_order_relaxed);
+            stats.throttled = throttled_.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+    } // namespace gateway
+} // namespace spe
@@ -0,0 +1,695 @@
+#include "exchange_message_parser.hpp"
+#include "latency_monitor.hpp"
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+namespace spe
+{
+    namespace exchange_ws
+    {
+
+        namespace
+        {
+            // Raw text of one JSON value: strings keep their quotes, containers their brackets
+            using RawValue = std::string_view;
+
+            class JsonCursor
+            {
+            private:
+                const char *p_;
+                const char *end_;
+
+                static bool is_whitespace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+                bool skip_string()
+                {
+                    ++p_; // opening quote
+                    while (p_ < end_)
+                    {
+                        char c = *p_++;
+                        if (c == '\\')
+                        {
+                            ++p_;
+                        }
+                        else if (c == '"')
+                        {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                bool skip_container()
+                {
+                    int depth = 0;
+                    while (p_ < end_)
+                    {
+                        char c = *p_;
+                        if (c == '"')
+                        {
+                            if (!skip_string())
+                            {
+                                return false;
+                            }
+                            continue;
+                        }
+                        ++p_;
+                        if (c == '{' || c == '[')
+                        {
+                            ++depth;
+                        }
+                        else if ((c == '}' || c == ']') && --depth == 0)
+                        {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+            public:
+                explicit JsonCursor(std::string_view text) : p_(text.data()), end_(text.data() + text.size()) {}
+
+                void skip_whitespace()
+                {
+                    while (p_ < end_ && is_whitespace(*p_))
+                    {
+                        ++p_;
+                    }
+                }
+
+                bool consume(char c)
+                {
+                    skip_whitespace();
+                    if (p_ < end_ && *p_ == c)
+                    {
+                        ++p_;
+                        return true;
+                    }
+                    return false;
+                }
+
+                // Unescaped string contents; strings with escapes are left to the DOM
+                bool read_string(std::string_view &out)
+                {
+                    skip_whitespace();
+                    if (p_ >= end_ || *p_ != '"')
+                    {
+                        return false;
+                    }
+                    const char *start = p_ + 1;
+                    const char *close = static_cast<const char *>(std::memchr(start, '"', end_ - start));
+                    if (close == nullptr || std::memchr(start, '\\', close - start) != nullptr)
+                    {
+                        return false;
+                    }
+                    out = std::string_view(start, close - start);
+                    p_ = close + 1;
+                    return true;
+                }
+
+                bool read_value(RawValue &out)
+                {
+                    skip_whitespace();
+                    if (p_ >= end_)
+                    {
+                        return false;
+                    }
+                    const char *start = p_;
+                    if (*p_ == '"')
+                    {
+                        if (!skip_string())
+                        {
+                            return false;
+                        }
+                    }
+                    else if (*p_ == '{' || *p_ == '[')
+                    {
+                        if (!skip_container())
+                        {
+                            return false;
+                        }
+                    }
+                    else
+                    {
+                        while (p_ < end_ && *p_ != ',' && *p_ != '}' && *p_ != ']' && !is_whitespace(*p_))
+                        {
+                            ++p_;
+                        }
+                    }
+                    out = RawValue(start, p_ - start);
+                    return p_ > start;
+                }
+            };
+
+            struct Field
+            {
+                std::string_view key;
+                RawValue value;
+            };
+
+            // Members of one object, in wire order; lookups are a short linear scan
+            template <size_t N>
+            class FieldTable
+            {
+            private:
+                Field fields_[N];
+                size_t count_ = 0;
+
+            public:
+                bool parse(RawValue object)
+                {
+                    count_ = 0;
+                    JsonCursor cursor(object);
+                    if (!cursor.consume('{'))
+                    {
+                        return false;
+                    }
+                    if (cursor.consume('}'))
+                    {
+                        return true;
+                    }
+                    do
+                    {
+                        if (count_ == N)
+                        {
+                            return false;
+                        }
+                        Field &field = fields_[count_++];
+                        if (!cursor.read_string(field.key) || !cursor.consume(':') || !cursor.read_value(field.value))
+                        {
+                            return false;
+                        }
+                    } while (cursor.consume(','));
+                    return cursor.consume('}');
+                }
+
+                // Empty when the member is missing
+                RawValue find(std::string_view key) const
+                {
+                    for (size_t i = 0; i < count_; ++i)
+                    {
+                        if (fields_[i].key == key)
+                        {
+                            return fields_[i].value;
+                        }
+                    }
+                    return RawValue();
+                }
+
+                bool has(std::string_view key) const { return !find(key).empty(); }
+            };
+
+            std::string_view unquote(RawValue value)
+            {
+                if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+                {
+                    return value.substr(1, value.size() - 2);
+                }
+                return value;
+            }
+
+            bool read_text(RawValue value, std::string_view &out)
+            {
+                if (value.size() < 2 || value.front() != '"')
+                {
+                    return false;
+                }
+                out = unquote(value);
+                return out.find('\\') == std::string_view::npos;
+            }
+
+            template <typename Integer>
+            bool read_integer(RawValue value, Integer &out)
+            {
+                std::string_view text = unquote(value);
+                if (text.empty())
+                {
+                    return false;
+                }
+                auto result = std::from_chars(text.data(), text.data() + text.size(), out);
+                return result.ec == std::errc() && result.ptr == text.data() + text.size();
+            }
+
+            // Optional numeric member; OKX sends "" for fields it has no value for
+            double decimal_or(RawValue value, double fallback)
+            {
+                double result;
+                return parse_wire_decimal(value, result) ? result : fallback;
+            }
+
+            // Array of [price, size, ...] rows
+            bool parse_levels(RawValue array, std::vector<OrderBookLevel> &out, std::vector<WireLevelText> &text,
+                              Timestamp received)
+            {
+                out.clear();
+                text.clear();
+                JsonCursor cursor(array);
+                if (!cursor.consume('['))
+                {
+                    return false;
+                }
+                if (cursor.consume(']'))
+                {
+                    return true;
+                }
+                do
+                {
+                    RawValue price_text, size_text, ignored;
+                    if (!cursor.consume('[') || !cursor.read_value(price_text) ||
+                        !cursor.consume(',') || !cursor.read_value(size_text))
+                    {
+                        return false;
+                    }
+                    while (cursor.consume(','))
+                    {
+                        if (!cursor.read_value(ignored))
+                        {
+                            return false;
+                        }
+                    }
+                    double price, size;
+                    if (!cursor.consume(']') || !parse_wire_decimal(price_text, price) || !parse_wire_decimal(size_text, size))
+                    {
+                        return false;
+                    }
+                    out.emplace_back(price, size, received);
+                    text.push_back(WireLevelText{unquote(price_text), unquote(size_text)});
+                } while (cursor.consume(','));
+                return cursor.consume(']');
+            }
+
+            // Calls visit(RawValue) for each element of an array
+            template <typename Visitor>
+            bool for_each_element(RawValue array, Visitor &&visit)
+            {
+                JsonCursor cursor(array);
+                if (!cursor.consume('['))
+                {
+                    return false;
+                }
+                if (cursor.consume(']'))
+                {
+                    return true;
+                }
+                do
+                {
+                    RawValue element;
+                    if (!cursor.read_value(element) || !visit(element))
+                    {
+                        return false;
+                    }
+                } while (cursor.consume(','));
+                return cursor.consume(']');
+            }
+
+            bool finish(bool parsed, WireMessage &out, WireMessageKind kind)
+            {
+                out.kind = parsed ? kind : WireMessageKind::UNKNOWN;
+                return parsed;
+            }
+
+            // ---- OKX ----
+
+            bool is_okx_book_channel(std::string_view channel)
+            {
+                return channel.substr(0, 5) == "books" || channel == "bbo-tbt";
+            }
+
+            bool parse_okx_book(RawValue data, WireMessage &out, Timestamp received)
+            {
+                size_t books = 0;
+                FieldTable<12> book;
+                bool parsed = for_each_element(data, [&](RawValue element)
+                                               { return ++books == 1 && book.parse(element); });
+                if (!parsed || books != 1 ||
+                    !parse_levels(book.find("bids"), out.bids, out.bid_text, received) ||
+                    !parse_levels(book.find("asks"), out.asks, out.ask_text, received))
+                {
+                    return false;
+                }
+
+                read_integer(book.find("ts"), out.exchange_time_ms);
+                out.has_checksum = read_integer(book.find("checksum"), out.checksum);
+                int64_t sequence = 0, previous = 0;
+                if (read_integer(book.find("seqId"), sequence) && sequence > 0)
+                {
+                    out.last_update_id = static_cast<uint64_t>(sequence);
+                }
+                if (read_integer(book.find("prevSeqId"), previous) && previous > 0) // -1 on snapshots
+                {
+                    out.previous_update_id = static_cast<uint64_t>(previous);
+                }
+                return true;
+            }
+
+            bool parse_okx_trades(RawValue data, WireMessage &out)
+            {
+                FieldTable<12> trade;
+                return for_each_element(data, [&](RawValue element)
+                                        {
+                    std::string_view side;
+                    WireTrade parsed;
+                    if (!trade.parse(element) || !read_text(trade.find("tradeId"), parsed.trade_id) ||
+                        !parse_wire_decimal(trade.find("px"), parsed.price) ||
+                        !parse_wire_decimal(trade.find("sz"), parsed.size) || !read_text(trade.find("side"), side))
+                    {
+                        return false;
+                    }
+                    parsed.side = side == "sell" ? Side::ASK : Side::BID;
+                    read_integer(trade.find("ts"), parsed.exchange_time_ms);
+                    out.exchange_time_ms = parsed.exchange_time_ms;
+                    out.trades.push_back(parsed);
+                    return true; });
+            }
+
+            bool parse_okx_ticker(RawValue data, WireMessage &out, Timestamp received)
+            {
+                size_t tickers = 0;
+                FieldTable<24> fields;
+                bool parsed = for_each_element(data, [&](RawValue element)
+                                               { return ++tickers == 1 && fields.parse(element); });
+                TickerData &ticker = out.ticker;
+                if (!parsed || tickers != 1 || !parse_wire_decimal(fields.find("last"), ticker.last_price))
+                {
+                    return false;
+                }
+
+                ticker.bid_price = decimal_or(fields.find("bidPx"), 0.0);
+                ticker.ask_price = decimal_or(fields.find("askPx"), 0.0);
+                ticker.bid_size = decimal_or(fields.find("bidSz"), 0.0);
+                ticker.ask_size = decimal_or(fields.find("askSz"), 0.0);
+                ticker.volume_24h = decimal_or(fields.find("vol24h"), 0.0);
+                ticker.high_24h = decimal_or(fields.find("high24h"), 0.0);
+                ticker.low_24h = decimal_or(fields.find("low24h"), 0.0);
+                double open = decimal_or(fields.find("open24h"), 0.0);
+                if (open > 0.0)
+                {
+                    ticker.price_change_24h = ticker.last_price - open;
+                    ticker.price_change_percent_24h = ticker.price_change_24h / open * 100.0;
+                }
+                ticker.timestamp = received;
+                read_integer(fields.find("ts"), out.exchange_time_ms);
+                return true;
+            }
+
+            // ---- Binance ----
+
+            bool parse_binance_depth(const FieldTable<32> &fields, RawValue bids, RawValue asks,
+                                     WireMessage &out, Timestamp received)
+            {
+                if (!parse_levels(bids, out.bids, out.bid_text, received) ||
+                    !parse_levels(asks, out.asks, out.ask_text, received))
+                {
+                    return false;
+                }
+                read_integer(fields.find("U"), out.first_update_id);
+                read_integer(fields.find("pu"), out.previous_update_id);
+                return true;
+            }
+
+            bool parse_binance_trade(const FieldTable<32> &fields, bool aggregated, WireMessage &out)
+            {
+                WireTrade trade;
+                RawValue id = fields.find(aggregated ? "a" : "t");
+                if (!read_text(fields.find("s"), out.symbol) || id.empty() ||
+                    !parse_wire_decimal(fields.find("p"), trade.price) || !parse_wire_decimal(fields.find("q"), trade.size))
+                {
+                    return false;
+                }
+                trade.trade_id = unquote(id);
+                trade.side = fields.find("m") == "true" ? Side::ASK : Side::BID; // buyer is maker: taker sold
+                if (!read_integer(fields.find("T"), trade.exchange_time_ms))
+                {
+                    trade.exchange_time_ms = out.exchange_time_ms;
+                }
+                out.trades.push_back(trade);
+                return true;
+            }
+
+            bool parse_binance_book_ticker(const FieldTable<32> &fields, WireMessage &out, Timestamp received)
+            {
+                TickerData &ticker = out.ticker;
+                if (!read_text(fields.find("s"), out.symbol) ||
+                    !parse_wire_decimal(fields.find("b"), ticker.bid_price) ||
+                    !parse_wire_decimal(fields.find("a"), ticker.ask_price))
+                {
+                    return false;
+                }
+                ticker.bid_size = decimal_or(fields.find("B"), 0.0);
+                ticker.ask_size = decimal_or(fields.find("A"), 0.0);
+                ticker.timestamp = received;
+                read_integer(fields.find("u"), out.last_update_id);
+                out.ticker_is_top_of_book = true;
+                return true;
+            }
+
+            bool parse_binance_ticker(const FieldTable<32> &fields, WireMessage &out, Timestamp received)
+            {
+                TickerData &ticker = out.ticker;
+                if (!read_text(fields.find("s"), out.symbol) || !parse_wire_decimal(fields.find("c"), ticker.last_price))
+                {
+                    return false;
+                }
+                ticker.bid_price = decimal_or(fields.find("b"), 0.0);
+                ticker.ask_price = decimal_or(fields.find("a"), 0.0);
+                ticker.bid_size = decimal_or(fields.find("B"), 0.0);
+                ticker.ask_size = decimal_or(fields.find("A"), 0.0);
+                ticker.volume_24h = decimal_or(fields.find("v"), 0.0);
+                ticker.high_24h = decimal_or(fields.find("h"), 0.0);
+                ticker.low_24h = decimal_or(fields.find("l"), 0.0);
+                ticker.price_change_24h = decimal_or(fields.find("p"), 0.0);
+                ticker.price_change_percent_24h = decimal_or(fields.find("P"), 0.0);
+                ticker.timestamp = received;
+                return true;
+            }
+        }
+
+#if defined(SPE_LATENCY_TRACING)
+        namespace
+        {
+            using telemetry::LatencyMonitor;
+            using telemetry::LatencyStage;
+            using telemetry::SeriesId;
+
+            SeriesId okx_parse_series()
+            {
+                static const SeriesId series = LatencyMonitor::instance().series("OKX", LatencyStage::PARSE);
+                return series;
+            }
+
+            SeriesId binance_parse_series()
+            {
+                static const SeriesId series = LatencyMonitor::instance().series("BINANCE", LatencyStage::PARSE);
+                return series;
+            }
+
+            SeriesId book_series(BookSequencing sequencing)
+            {
+                static const SeriesId okx = LatencyMonitor::instance().series("OKX", LatencyStage::BOOK_UPDATE);
+                static const SeriesId binance = LatencyMonitor::instance().series("BINANCE", LatencyStage::BOOK_UPDATE);
+                static const SeriesId other = LatencyMonitor::instance().series("OTHER", LatencyStage::BOOK_UPDATE);
+                switch (sequencing)
+                {
+                case BookSequencing::OKX:
+                    return okx;
+                case BookSequencing::BINANCE_SPOT:
+                case BookSequencing::BINANCE_FUTURES:
+                    return binance;
+                default:
+                    return other;
+                }
+            }
+        }
+#endif
+
+        void WireMessage::reset()
+        {
+            kind = WireMessageKind::UNKNOWN;
+            channel = std::string_view();
+            symbol = std::string_view();
+            exchange_time_ms = 0;
+            is_snapshot = false;
+            bids.clear();
+            asks.clear();
+            bid_text.clear();
+            ask_text.clear();
+            first_update_id = 0;
+            last_update_id = 0;
+            previous_update_id = 0;
+            checksum = 0;
+            has_checksum = false;
+            trades.clear();
+
+            // Field by field, so the caller's exchange string keeps its buffer
+            ticker.instrument = INVALID_INSTRUMENT;
+            ticker.last_price = ticker.bid_price = ticker.ask_price = 0.0;
+            ticker.bid_size = ticker.ask_size = 0.0;
+            ticker.volume_24h = ticker.price_change_24h = ticker.price_change_percent_24h = 0.0;
+            ticker.high_24h = ticker.low_24h = 0.0;
+            ticker_is_top_of_book = false;
+        }
+
+        bool parse_wire_decimal(std::string_view text, double &out)
+        {
+            text = unquote(text);
+            if (text.empty())
+            {
+                return false;
+            }
+#if defined(__cpp_lib_to_chars)
+            auto result = std::from_chars(text.data(), text.data() + text.size(), out);
+            return result.ec == std::errc() && result.ptr == text.data() + text.size();
+#else
+            // strtod needs a terminated copy; wire decimals are short
+            char buffer[64];
+            if (text.size() >= sizeof(buffer))
+            {
+                return false;
+            }
+            std::memcpy(buffer, text.data(), text.size());
+            buffer[text.size()] = '\0';
+            char *end = nullptr;
+            out = std::strtod(buffer, &end);
+            return end == buffer + text.size();
+#endif
+        }
+
+        BookUpdateResult apply_to_order_book(const WireMessage &message, OrderBook &book)
+        {
+            if (message.kind != WireMessageKind::ORDERBOOK)
+            {
+                return BookUpdateResult::STALE;
+            }
+            SPE_LATENCY_SCOPE(book_series(book.sequencing()));
+
+            BookSequence sequence;
+            sequence.is_snapshot = message.is_snapshot;
+            sequence.first_update_id = message.first_update_id;
+            sequence.last_update_id = message.last_update_id;
+            sequence.previous_update_id = message.previous_update_id;
+            sequence.has_checksum = message.has_checksum;
+            sequence.checksum = static_cast<int32_t>(message.checksum);
+            sequence.timestamp = message.receive_time;
+
+            BookUpdateResult result = book.begin_update(sequence);
+            if (result != BookUpdateResult::APPLIED)
+            {
+                return result;
+            }
+            // Messages built by hand may carry no text; those levels are checksummed from their values
+            for (size_t i = 0; i < message.bids.size(); ++i)
+            {
+                WireLevelText text = i < message.bid_text.size() ? message.bid_text[i] : WireLevelText{};
+                book.set_level(Side::BID, message.bids[i].price, message.bids[i].quantity, text.price, text.size);
+            }
+            for (size_t i = 0; i < message.asks.size(); ++i)
+            {
+                WireLevelText text = i < message.ask_text.size() ? message.ask_text[i] : WireLevelText{};
+                book.set_level(Side::ASK, message.asks[i].price, message.asks[i].quantity, text.price, text.size);
+            }
+            return book.commit_update(sequence);
+        }
+
+        bool parse_okx_message(std::string_view frame, WireMessage &out)
+        {
+            SPE_LATENCY_SCOPE(okx_parse_series());
+            out.reset();
+
+            FieldTable<8> top;
+            FieldTable<8> arg;
+            if (!top.parse(frame))
+            {
+                return false;
+            }
+            RawValue data = top.find("data");
+            if (data.empty() || !arg.parse(top.find("arg")) || // acks and errors carry "event" instead
+                !read_text(arg.find("channel"), out.channel) || !read_text(arg.find("instId"), out.symbol))
+            {
+                return false;
+            }
+
+            Timestamp received = std::chrono::high_resolution_clock::now();
+            out.receive_time = received;
+            if (is_okx_book_channel(out.channel))
+            {
+                std::string_view action;
+                out.is_snapshot = !read_text(top.find("action"), action) || action == "snapshot"; // books5/bbo-tbt: always full
+                return finish(parse_okx_book(data, out, received), out, WireMessageKind::ORDERBOOK);
+            }
+            if (out.channel == "trades" || out.channel == "trades-all")
+            {
+                return finish(parse_okx_trades(data, out), out, WireMessageKind::TRADE);
+            }
+            if (out.channel == "tickers")
+            {
+                return finish(parse_okx_ticker(data, out, received), out, WireMessageKind::TICKER);
+            }
+            return false;
+        }
+
+        bool parse_binance_message(std::string_view frame, WireMessage &out)
+        {
+            SPE_LATENCY_SCOPE(binance_parse_series());
+            out.reset();
+
+            FieldTable<32> fields; // 24hrTicker is the widest at 23 members
+            if (!fields.parse(frame))
+            {
+                return false;
+            }
+            RawValue data = fields.find("data");
+            if (!data.empty()) // combined stream: {"stream": "...", "data": {...}}
+            {
+                if (!read_text(fields.find("stream"), out.channel) || !fields.parse(data))
+                {
+                    return false;
+                }
+            }
+
+            Timestamp received = std::chrono::high_resolution_clock::now();
+            out.receive_time = received;
+            std::string_view event;
+            if (read_text(fields.find("e"), event))
+            {
+                read_integer(fields.find("E"), out.exchange_time_ms);
+                if (event == "depthUpdate")
+                {
+                    return finish(read_text(fields.find("s"), out.symbol) &&
+                                      read_integer(fields.find("u"), out.last_update_id) &&
+                                      parse_binance_depth(fields, fields.find("b"), fields.find("a"), out, received),
+                                  out, WireMessageKind::ORDERBOOK);
+                }
+                if (event == "trade" || event == "aggTrade")
+                {
+                    return finish(parse_binance_trade(fields, event == "aggTrade", out), out, WireMessageKind::TRADE);
+                }
+                if (event == "24hrTicker")
+                {
+                    return finish(parse_binance_ticker(fields, out, received), out, WireMessageKind::TICKER);
+                }
+                if (event == "bookTicker") // futures variant carries an event type
+                {
+                    return finish(parse_binance_book_ticker(fields, out, received), out, WireMessageKind::TICKER);
+                }
+                return false;
+            }
+
+            if (fields.has("lastUpdateId")) // partial depth: symbol only appears in the stream name
+            {
+                out.is_snapshot = true;
+                out.symbol = out.channel.substr(0, out.channel.find('@'));
+                return finish(read_integer(fields.find("lastUpdateId"), out.last_update_id) &&
+                                  parse_binance_depth(fields, fields.find("bids"), fields.find("asks"), out, received),
+                              out, WireMessageKind::ORDERBOOK);
+            }
+            if (fields.has("u") && fields.has("s")) // spot bookTicker has no event type
+            {
+                return finish(parse_binance_book_ticker(fields, out, received), out, WireMessageKind::TICKER);
+            }
+            return false;
+        }
+
+    } // namespace exchange_ws
+} // namespace spe
@@ -0,0 +1,1478 @@
+#include "exposure_management.hpp"
+#include <cmath>
+#include <algorithm>
+#include <functional>
+
+namespace spe
+{
+    namespace exposure
+    {
+
+        namespace
+        {
+            bool is_option(DerivativeType type)
+            {
+                return type == DerivativeType::OPTION_CALL || type == DerivativeType::OPTION_PUT ||
+                       type == DerivativeType::SYNTHETIC_OPTION;
+            }
+
+            bool is_forward(DerivativeType type)
+            {
+                return type == DerivativeType::FORWARD || type == DerivativeType::FUTURES ||
+                       type == DerivativeType::SYNTHETIC_FORWARD;
+            }
+
+            double years_until(Timestamp expiry)
+            {
+                auto remaining = std::chrono::duration<double>(expiry - std::chrono::high_resolution_clock::now());
+                return std::max(remaining.count() / (365.0 * 24 * 3600), 0.0);
+            }
+
+            double signed_notional(PositionSide side, Volume size, Price price)
+            {
+                if (side == PositionSide::NEUTRAL)
+                {
+                    return 0.0;
+                }
+                return side == PositionSide::SHORT ? -size * price : size * price;
+            }
+
+            double unrealized_pnl(const Position &position)
+            {
+                return signed_notional(position.side, position.size, position.current_price - position.entry_price);
+            }
+
+            // A trade of size units puts |weight| units on each weighted leg; unweighted legs keep their own size
+            Volume leg_size(const ArbitrageLeg &leg, Volume size)
+            {
+                return leg.weight != 0.0 ? size * std::abs(leg.weight) : leg.size;
+            }
+
+            void erase_index(memory::SmallVector<uint32_t, 4> &indices, uint32_t index)
+            {
+                for (size_t i = 0; i < indices.size(); ++i)
+                {
+                    if (indices[i] == index)
+                    {
+                        indices[i] = indices.back();
+                        indices.pop_back();
+                        return;
+                    }
+                }
+            }
+
+            void replace_index(memory::SmallVector<uint32_t, 4> &indices, uint32_t from, uint32_t to)
+            {
+                for (auto &index : indices)
+                {
+                    if (index == from)
+                    {
+                        index = to;
+                        return;
+                    }
+                }
+            }
+        }
+
+        // SyntheticDerivativeConstructor implementation
+        SyntheticDerivativeConstructor::SyntheticDerivativeConstructor(std::unique_ptr<IPricingModel> model,
+                                                                       const RiskParameters &params)
+            : pricing_model_(std::move(model)),
+              options_model_(dynamic_cast<const OptionsPricingModel *>(pricing_model_.get())),
+              risk_params_(params) {}
+
+        double SyntheticDerivativeConstructor::surface_volatility(InstrumentHandle underlying, Price strike,
+                                                                  double time_to_expiry) const
+        {
+            // Lock-free read of the compiled surface
+            return options_model_ ? options_model_->get_volatility(underlying, strike, time_to_expiry) : 0.2;
+        }
+
+        SyntheticDerivative SyntheticDerivativeConstructor::construct_synthetic_forward(
+            InstrumentHandle underlying,
+            Price strike,
+            Timestamp expiry,
+            const MarketSnapshot &market_data)
+        {
+            SyntheticDerivative derivative;
+            derivative.type = DerivativeType::SYNTHETIC_FORWARD;
+            derivative.underlying_instrument = underlying;
+            derivative.component_instruments = {underlying};
+            derivative.component_weights = {1.0};
+            derivative.strike_price = strike;
+            derivative.expiry_time = expiry;
+            derivative.time_to_expiry = years_until(expiry);
+
+            if (market_data.has_quote(underlying))
+            {
+                derivative.market_price = market_data.mid_price(underlying);
+                derivative.theoretical_price = derivative.market_price *
+                                               std::exp(risk_params_.risk_free_rate * derivative.time_to_expiry);
+            }
+            derivative.construction_cost = calculate_construction_cost(derivative);
+            calculate_all_greeks(derivative, market_data);
+            return derivative;
+        }
+
+        SyntheticDerivative SyntheticDerivativeConstructor::construct_synthetic_option(
+            InstrumentHandle underlying,
+            DerivativeType option_type,
+            Price strike,
+            Timestamp expiry,
+            const MarketSnapshot &market_data)
+        {
+            SyntheticDerivative derivative;
+            derivative.type = option_type;
+            derivative.underlying_instrument = underlying;
+            derivative.component_instruments = {underlying};
+            derivative.strike_price = strike;
+            derivative.expiry_time = expiry;
+            derivative.time_to_expiry = years_until(expiry);
+            derivative.implied_volatility = surface_volatility(underlying, strike, derivative.time_to_expiry);
+
+            // Replicated by a delta position in the underlying
+            calculate_all_greeks(derivative, market_data);
+            derivative.component_weights = {derivative.delta};
+            if (market_data.has_quote(underlying))
+            {
+                derivative.market_price = market_data.mid_price(underlying);
+            }
+            derivative.construction_cost = calculate_construction_cost(derivative);
+            return derivative;
+        }
+
+        SyntheticDerivative SyntheticDerivativeConstructor::construct_synthetic_swap(
+            InstrumentHandle pay_leg,
+            InstrumentHandle receive_leg,
+            Timestamp expiry,
+            const MarketSnapshot &market_data)
+        {
+            SyntheticDerivative derivative;
+            derivative.type = DerivativeType::SYNTHETIC_SWAP;
+            derivative.underlying_instrument = receive_leg;
+            derivative.component_instruments = {pay_leg, receive_leg};
+            derivative.component_weights = {-1.0, 1.0};
+            derivative.expiry_time = expiry;
+            derivative.time_to_expiry = years_until(expiry);
+
+            if (market_data.has_quote(pay_leg) && market_data.has_quote(receive_leg))
+            {
+                derivative.theoretical_price = market_data.mid_price(receive_leg) - market_data.mid_price(pay_leg);
+                derivative.market_price = derivative.theoretical_price;
+            }
+            derivative.construction_cost = calculate_construction_cost(derivative);
+            return derivative;
+        }
+
+        double SyntheticDerivativeConstructor::calculate_construction_cost(const SyntheticDerivative &derivative)
+        {
+            // Simplified: 10 bps of the traded notional per component
+            double notional = 0.0;
+            for (double weight : derivative.component_weights)
+            {
+                notional += std::abs(weight) * derivative.market_price;
+            }
+            return notional * 0.001;
+        }
+
+        void SyntheticDerivativeConstructor::update_greeks(SyntheticDerivative &derivative, const MarketSnapshot &market_data)
+        {
+            calculate_all_greeks(derivative, market_data);
+        }
+
+        void SyntheticDerivativeConstructor::update_greeks(std::vector<SyntheticDerivative> &derivatives,
+                                                           const MarketSnapshot &market_data)
+        {
+            for (auto &[underlying, chain] : greek_chains_)
+            {
+                chain.clear();
+            }
+            for (auto &[underlying, members] : greek_chain_members_)
+            {
+                members.clear();
+            }
+
+            for (auto &derivative : derivatives)
+            {
+                if (!is_option(derivative.type))
+                {
+                    calculate_all_greeks(derivative, market_data);
+                    continue;
+                }
+
+                // Synthetic options are priced as calls; puts only when listed as such
+                double vol = derivative.implied_volatility > 0
+                                 ? derivative.implied_volatility
+                                 : surface_volatility(derivative.underlying_instrument, derivative.strike_price,
+                                                      derivative.time_to_expiry);
+                greek_chains_[derivative.underlying_instrument].add(
+                    derivative.strike_price, derivative.time_to_expiry, vol,
+                    derivative.type != DerivativeType::OPTION_PUT);
+                greek_chain_members_[derivative.underlying_instrument].push_back(&derivative);
+            }
+
+            price_greek_chains(market_data);
+        }
+
+        void SyntheticDerivativeConstructor::calculate_all_greeks(SyntheticDerivative &derivative,
+                                                                  const MarketSnapshot &market_data)
+        {
+            if (is_forward(derivative.type))
+            {
+                derivative.delta = 1.0;
+                derivative.gamma = 0.0;
+                derivative.theta = 0.0;
+                derivative.vega = 0.0;
+                derivative.rho = 0.0;
+                return;
+            }
+
+            if (!is_option(derivative.type))
+            {
+                return;
+            }
+
+            // A single option is a one-entry chain through the same kernel
+            OptionChain chain;
+            double vol = derivative.implied_volatility > 0
+                             ? derivative.implied_volatility
+                             : surface_volatility(derivative.underlying_instrument, derivative.strike_price,
+                                                  derivative.time_to_expiry);
+            chain.add(derivative.strike_price, derivative.time_to_expiry, vol,
+                      derivative.type != DerivativeType::OPTION_PUT);
+
+            for (auto &[underlying, pending] : greek_chains_)
+            {
+                pending.clear();
+            }
+            for (auto &[underlying, members] : greek_chain_members_)
+            {
+                members.clear();
+            }
+            greek_chains_[derivative.underlying_instrument] = chain;
+            greek_chain_members_[derivative.underlying_instrument].push_back(&derivative);
+
+            price_greek_chains(market_data);
+        }
+
+        void SyntheticDerivativeConstructor::price_greek_chains(const MarketSnapshot &market_data)
+        {
+            for (auto &[underlying, chain] : greek_chains_)
+            {
+                auto &members = greek_chain_members_[underlying];
+                if (chain.empty() || !market_data.has_quote(underlying))
+                {
+                    continue;
+                }
+
+                price_option_chain(market_data.mid_price(underlying), risk_params_.risk_free_rate, chain, greek_results_);
+
+                for (size_t i = 0; i < members.size(); ++i)
+                {
+                    SyntheticDerivative &derivative = *members[i];
+                    derivative.theoretical_price = greek_results_.prices[i];
+                    derivative.delta = greek_results_.deltas[i];
+                    derivative.gamma = greek_results_.gammas[i];
+                    derivative.theta = greek_results_.thetas[i];
+                    derivative.vega = greek_results_.vegas[i];
+                    derivative.rho = greek_results_.rhos[i];
+                }
+                members.clear();
+            }
+        }
+
+        // AdvancedRiskCalculator implementation
+        AdvancedRiskCalculator::AdvancedRiskCalculator()
+            : history_version_(0), factors_version_(0), factors_observations_(0),
+              max_factor_age_(std::chrono::milliseconds(1000)) {}
+
+        void AdvancedRiskCalculator::set_monte_carlo_config(const MonteCarloConfig &config)
+        {
+            portfolio_engine_.set_config(config);
+            position_engine_.set_config(config);
+            ++history_version_; // a new horizon needs new factors
+            factors_built_ = std::chrono::steady_clock::time_point{};
+        }
+
+        void AdvancedRiskCalculator::set_execution_mode(concurrency::ExecutionMode mode,
+                                                        std::shared_ptr<concurrency::WorkStealingPool> pool)
+        {
+            portfolio_engine_.set_execution_mode(mode, std::move(pool));
+        }
+
+        double AdvancedRiskCalculator::position_notional(const Position &position)
+        {
+            if (position.side == PositionSide::NEUTRAL)
+            {
+                return 0.0;
+            }
+            double price = position.current_price > 0.0 ? position.current_price : position.entry_price;
+            double notional = position.size * price;
+            return position.side == PositionSide::SHORT ? -notional : notional;
+        }
+
+        double AdvancedRiskCalculator::daily_volatility(InstrumentHandle instrument) const
+        {
+            // Returns between recorded prices are taken as daily returns
+            auto it = price_history_.find(instrument);
+            if (it == price_history_.end() || it->second.size() < 3)
+            {
+                return DEFAULT_DAILY_VOLATILITY;
+            }
+            const auto &prices = it->second;
+            double sum = 0.0;
+            double sum_sq = 0.0;
+            size_t count = 0;
+            for (size_t i = 1; i < prices.size(); ++i)
+            {
+                if (prices[i] > 0.0 && prices[i - 1] > 0.0)
+                {
+                    double r = std::log(prices[i] / prices[i - 1]);
+                    sum += r;
+                    sum_sq += r * r;
+                    ++count;
+                }
+            }
+            if (count < 2)
+            {
+                return DEFAULT_DAILY_VOLATILITY;
+            }
+            double mean = sum / count;
+            return std::sqrt(std::max((sum_sq - count * mean * mean) / (count - 1), 0.0));
+        }
+
+        MonteCarloRiskResult AdvancedRiskCalculator::simulate_exposures(double confidence_level)
+        {
+            std::vector<InstrumentHandle> instruments;
+            instruments.reserve(exposures_.size());
+            for (const auto &exposure : exposures_)
+            {
+                instruments.push_back(exposure.instrument);
+            }
+            std::sort(instruments.begin(), instruments.end());
+            instruments.erase(std::unique(instruments.begin(), instruments.end()), instruments.end());
+
+            uint64_t observations = correlation_matrix_ ? correlation_matrix_->observation_count() : 0;
+            auto now = std::chrono::steady_clock::now();
+            bool data_moved = history_version_ != factors_version_ || observations != factors_observations_;
+            if (instruments != portfolio_engine_.factors() || (data_moved && now - factors_built_ >= max_factor_age_))
+            {
+                std::vector<double> volatilities;
+                volatilities.reserve(instruments.size());
+                for (InstrumentHandle instrument : instruments)
+                {
+                    volatilities.push_back(daily_volatility(instrument));
+                }
+                portfolio_engine_.set_factors(instruments, volatilities, correlation_matrix_.get());
+                factors_version_ = history_version_;
+                factors_observations_ = observations;
+                factors_built_ = now;
+            }
+            return portfolio_engine_.run(exposures_, confidence_level);
+        }
+
+        MonteCarloRiskResult AdvancedRiskCalculator::calculate_portfolio_risk(const Portfolio &portfolio,
+                                                                              double confidence_level)
+        {
+            exposures_.clear();
+            for (const auto &position : portfolio.positions)
+            {
+                exposures_.push_back({position.instrument, position_notional(position)});
+            }
+            return simulate_exposures(confidence_level);
+        }
+
+        MonteCarloRiskResult AdvancedRiskCalculator::calculate_pre_trade_risk(const Portfolio &portfolio,
+                                                                              const Position &candidate,
+                                                                              double confidence_level)
+        {
+            exposures_.clear();
+            for (const auto &position : portfolio.positions)
+            {
+                exposures_.push_back({position.instrument, position_notional(position)});
+            }
+            exposures_.push_back({candidate.instrument, position_notional(candidate)});
+            return simulate_exposures(confidence_level);
+        }
+
+        MonteCarloRiskResult AdvancedRiskCalculator::simulate_position(const Position &position, double confidence_level,
+                                                                       size_t time_horizon_days, std::vector<double> *losses)
+        {
+            MonteCarloConfig config = position_engine_.config();
+            config.horizon_days = time_horizon_days;
+            position_engine_.set_config(config);
+            position_engine_.set_factors({position.instrument}, {daily_volatility(position.instrument)}, nullptr);
+            return position_engine_.run({{position.instrument, position_notional(position)}}, confidence_level, losses);
+        }
+
+        std::vector<double> AdvancedRiskCalculator::monte_carlo_simulation(const Position &position, size_t num_simulations)
+        {
+            MonteCarloConfig config = position_engine_.config();
+            size_t paths = config.paths;
+            config.paths = num_simulations;
+            position_engine_.set_config(config);
+
+            std::vector<double> pnl;
+            simulate_position(position, 0.95, config.horizon_days, &pnl);
+            for (double &value : pnl)
+            {
+                value = -value;
+            }
+
+            config.paths = paths;
+            position_engine_.set_config(config);
+            return pnl;
+        }
+
+        double AdvancedRiskCalculator::calculate_parametric_var(const Position &position, double confidence_level)
+        {
+            return std::abs(position_notional(position)) * daily_volatility(position.instrument) *
+                   normal_quantile(confidence_level);
+        }
+
+        double AdvancedRiskCalculator::calculate_historical_var(const Position &position, double confidence_level)
+        {
+            auto it = price_history_.find(position.instrument);
+            if (it == price_history_.end() || it->second.size() < 2)
+            {
+                return calculate_parametric_var(position, confidence_level);
+            }
+
+            double notional = position_notional(position);
+            std::vector<double> losses;
+            const auto &prices = it->second;
+            for (size_t i = 1; i < prices.size(); ++i)
+            {
+                if (prices[i - 1] > 0.0)
+                {
+                    losses.push_back(-notional * (prices[i] / prices[i - 1] - 1.0));
+                }
+            }
+            if (losses.empty())
+            {
+                return calculate_parametric_var(position, confidence_level);
+            }
+            size_t rank = static_cast<size_t>(std::ceil((1.0 - confidence_level) * losses.size()));
+            rank = std::min(std::max<size_t>(rank, 1), losses.size());
+            std::nth_element(losses.begin(), losses.begin() + (rank - 1), losses.end(), std::greater<double>());
+            return std::max(losses[rank - 1], 0.0);
+        }
+
+        double AdvancedRiskCalculator::calculate_value_at_risk(const Position &position, double confidence_level,
+                                                               size_t time_horizon_days)
+        {
+            return simulate_position(position, confidence_level, time_horizon_days).value_at_risk;
+        }
+
+        double AdvancedRiskCalculator::calculate_expected_shortfall(const Position &position, double confidence_level)
+        {
+            return simulate_position(position, confidence_level, 1).expected_shortfall;
+        }
+
+        double AdvancedRiskCalculator::calculate_conditional_var(const Position &position, double confidence_level)
+        {
+            return calculate_expected_shortfall(position, confidence_level);
+        }
+
+        double AdvancedRiskCalculator::calculate_portfolio_var(const Portfolio &portfolio, double confidence_level)
+        {
+            return calculate_portfolio_risk(portfolio, confidence_level).value_at_risk;
+        }
+
+        double AdvancedRiskCalculator::calculate_correlation_risk(const std::vector<Position> &positions,
+                                                                  const MarketSnapshot &market_data)
+        {
+            // Exposure-weighted mean absolute pairwise correlation
+            if (!correlation_matrix_ || positions.size() < 2)
+            {
+                return 0.0;
+            }
+            std::vector<double> exposures;
+            exposures.reserve(positions.size());
+            for (const auto &position : positions)
+            {
+                double exposure = std::abs(position_notional(position));
+                if (market_data.has_quote(position.instrument))
+                {
+                    exposure = std::abs(position.size * market_data.mid_price(position.instrument));
+                }
+                exposures.push_back(exposure);
+            }
+
+            double weighted = 0.0;
+            double weights = 0.0;
+            for (size_t i = 0; i < positions.size(); ++i)
+            {
+                for (size_t j = i + 1; j < positions.size(); ++j)
+                {
+                    double weight = exposures[i] * exposures[j];
+                    double rho = positions[i].instrument == positions[j].instrument
+                                     ? 1.0
+                                     : correlation_matrix_->correlation(positions[i].instrument, positions[j].instrument);
+                    if (std::isfinite(rho))
+                    {
+                        weighted += weight * std::abs(rho);
+                        weights += weight;
+                    }
+                }
+            }
+            return weights > 0.0 ? weighted / weights : 0.0;
+        }
+
+        double AdvancedRiskCalculator::calculate_maximum_drawdown(const std::vector<double> &pnl_history)
+        {
+            // Largest peak-to-trough fall of the cumulative P&L
+            double cumulative = 0.0;
+            double peak = 0.0;
+            double drawdown = 0.0;
+            for (double pnl : pnl_history)
+            {
+                cumulative += pnl;
+                peak = std::max(peak, cumulative);
+                drawdown = std::max(drawdown, peak - cumulative);
+            }
+            return drawdown;
+        }
+
+        RiskLevel AdvancedRiskCalculator::assess_risk_level(const Position &position, const RiskParameters &params)
+        {
+            double notional = std::abs(position_notional(position));
+            if (notional <= 0.0)
+            {
+                return RiskLevel::LOW;
+            }
+            double var_ratio = calculate_value_at_risk(position) / notional;
+            if (var_ratio < 0.5 * params.max_individual_var)
+            {
+                return RiskLevel::LOW;
+            }
+            if (var_ratio < params.max_individual_var)
+            {
+                return RiskLevel::MEDIUM;
+            }
+            return var_ratio < 2.0 * params.max_individual_var ? RiskLevel::HIGH : RiskLevel::EXTREME;
+        }
+
+        void AdvancedRiskCalculator::update_price_history(const MarketSnapshot &market_data)
+        {
+            for (auto instrument : market_data.dirty_instruments())
+            {
+                if (!market_data.has_quote(instrument))
+                {
+                    continue;
+                }
+                record_price(instrument, market_data.mid_price(instrument));
+            }
+        }
+
+        void AdvancedRiskCalculator::record_price(InstrumentHandle instrument, Price price)
+        {
+            auto &prices = price_history_[instrument];
+            if (prices.size() >= HISTORY_LIMIT)
+            {
+                prices.erase(prices.begin());
+            }
+            prices.push_back(price);
+            ++history_version_;
+        }
+
+        // SyntheticExposureManager implementation
+        SyntheticExposureManager::SyntheticExposureManager(std::unique_ptr<ISyntheticDerivativeConstructor> constructor,
+                                                           std::unique_ptr<IPositionSizer> sizer,
+                                                           std::unique_ptr<IRiskCalculator> calculator,
+                                                           std::unique_ptr<ArbitrageLegOptimizer> optimizer,
+                                                           const RiskParameters &params)
+            : derivative_constructor_(std::move(constructor)), position_sizer_(std::move(sizer)),
+              risk_calculator_(std::move(calculator)), leg_optimizer_(std::move(optimizer)),
+              advanced_calculator_(dynamic_cast<AdvancedRiskCalculator *>(risk_calculator_.get())),
+              risk_params_(params), size_breach_count_(0), realized_pnl_(0.0), current_var_(0.0),
+              derivative_dollar_delta_(0.0), net_delta_(0.0), net_gamma_(0.0), net_vega_(0.0), net_theta_(0.0),
+              var_stale_(false), var_refresh_interval_(std::chrono::milliseconds(1000)),
+              risk_stage_running_(false), next_position_id_(1), next_derivative_id_(1)
+        {
+            portfolio_.portfolio_id = "SYNTHETIC";
+            publish_snapshot();
+        }
+
+        SyntheticExposureManager::~SyntheticExposureManager()
+        {
+            stop_risk_stage();
+        }
+
+        std::string SyntheticExposureManager::generate_position_id()
+        {
+            return "POS_" + std::to_string(next_position_id_.fetch_add(1));
+        }
+
+        std::string SyntheticExposureManager::generate_derivative_id()
+        {
+            return "DRV_" + std::to_string(next_derivative_id_.fetch_add(1));
+        }
+
+        double SyntheticExposureManager::position_var(uint32_t index) const
+        {
+            double basis = var_basis_exposure_[index];
+            return basis == 0.0 ? 0.0 : var_basis_[index] * portfolio_.positions[index].exposure_amount / basis;
+        }
+
+        RiskLevel SyntheticExposureManager::position_risk_level(uint32_t index) const
+        {
+            // Same ladder as AdvancedRiskCalculator::assess_risk_level, on the VaR contribution
+            double notional = std::abs(portfolio_.positions[index].exposure_amount);
+            if (notional <= 0.0)
+            {
+                return RiskLevel::LOW;
+            }
+            double var_ratio = std::max(position_var(index), 0.0) / notional;
+            if (var_ratio < 0.5 * risk_params_.max_individual_var)
+            {
+                return RiskLevel::LOW;
+            }
+            if (var_ratio < risk_params_.max_individual_var)
+            {
+                return RiskLevel::MEDIUM;
+            }
+            return var_ratio < 2.0 * risk_params_.max_individual_var ? RiskLevel::HIGH : RiskLevel::EXTREME;
+        }
+
+        void SyntheticExposureManager::update_size_breach(uint32_t index)
+        {
+            uint8_t breached = std::abs(portfolio_.positions[index].exposure_amount) > portfolio_.max_position_size;
+            if (breached != size_breaches_[index])
+            {
+                size_breach_count_ += breached ? 1 : -1;
+                size_breaches_[index] = breached;
+            }
+        }
+
+        void SyntheticExposureManager::mark_position(uint32_t index)
+        {
+            size_t chunk = index / RiskPositionChunk::CAPACITY;
+            if (chunk < stale_chunks_.size())
+            {
+                stale_chunks_[chunk] = 1;
+            }
+        }
+
+        void SyntheticExposureManager::mark_all_positions()
+        {
+            std::fill(stale_chunks_.begin(), stale_chunks_.end(), 1);
+        }
+
+        void SyntheticExposureManager::add_position(Position position)
+        {
+            if (position.current_price <= 0.0)
+            {
+                position.current_price = position.entry_price;
+            }
+            position.exposure_amount = signed_notional(position.side, position.size, position.current_price);
+            position.unrealized_pnl = unrealized_pnl(position);
+
+            auto index = static_cast<uint32_t>(portfolio_.positions.size());
+            // Undiversified estimate until the next refresh prices it with the book
+            var_basis_.push_back(std::abs(position.exposure_amount) * ESTIMATED_DAILY_VOLATILITY * normal_quantile(0.95));
+            var_basis_exposure_.push_back(position.exposure_amount);
+            size_breaches_.push_back(0);
+            positions_by_instrument_[position.instrument].push_back(index);
+            position_index_[position.position_id] = index;
+
+            portfolio_.net_exposure += position.exposure_amount;
+            portfolio_.gross_exposure += std::abs(position.exposure_amount);
+            portfolio_.total_pnl += position.unrealized_pnl;
+            portfolio_.positions.push_back(std::move(position));
+
+            Position &added = portfolio_.positions.back();
+            current_var_ += position_var(index);
+            added.value_at_risk = position_var(index);
+            position_nodes_.push_back(std::make_shared<const Position>(added));
+            mark_position(index);
+            update_size_breach(index);
+            var_stale_ = true;
+        }
+
+        void SyntheticExposureManager::remove_position(uint32_t index)
+        {
+            Position &position = portfolio_.positions[index];
+            current_var_ -= position_var(index);
+            portfolio_.net_exposure -= position.exposure_amount;
+            portfolio_.gross_exposure -= std::abs(position.exposure_amount);
+            realized_pnl_ += position.unrealized_pnl; // total P&L is unchanged
+            size_breach_count_ -= size_breaches_[index];
+
+            auto by_instrument = positions_by_instrument_.find(position.instrument);
+            erase_index(by_instrument->second, index);
+            if (by_instrument->second.empty())
+            {
+                positions_by_instrument_.erase(by_instrument);
+            }
+            position_index_.erase(position.position_id);
+
+            // Swap the last position into the hole
+            auto last = static_cast<uint32_t>(portfolio_.positions.size() - 1);
+            if (index != last)
+            {
+                portfolio_.positions[index] = std::move(portfolio_.positions[last]);
+                position_nodes_[index] = std::move(position_nodes_[last]);
+                var_basis_[index] = var_basis_[last];
+                var_basis_exposure_[index] = var_basis_exposure_[last];
+                size_breaches_[index] = size_breaches_[last];
+                replace_index(positions_by_instrument_[portfolio_.positions[index].instrument], last, index);
+                position_index_[portfolio_.positions[index].position_id] = index;
+                mark_position(index);
+            }
+            mark_position(last);
+            portfolio_.positions.pop_back();
+            position_nodes_.pop_back();
+            var_basis_.pop_back();
+            var_basis_exposure_.pop_back();
+            size_breaches_.pop_back();
+            var_stale_ = true;
+        }
+
+        bool SyntheticExposureManager::apply_price(uint32_t index, Price price, Timestamp time)
+        {
+            Position &position = portfolio_.positions[index];
+            if (price <= 0.0 || price == position.current_price)
+            {
+                return false;
+            }
+            double old_var = position_var(index);
+            double old_exposure = position.exposure_amount;
+            double old_pnl = position.unrealized_pnl;
+
+            position.current_price = price;
+            position.exposure_amount = signed_notional(position.side, position.size, price);
+            position.unrealized_pnl = unrealized_pnl(position);
+            position.value_at_risk = position_var(index);
+            position.last_update = time;
+
+            portfolio_.net_exposure += position.exposure_amount - old_exposure;
+            portfolio_.gross_exposure += std::abs(position.exposure_amount) - std::abs(old_exposure);
+            portfolio_.total_pnl += position.unrealized_pnl - old_pnl;
+            current_var_ += position.value_at_risk - old_var;
+            update_size_breach(index);
+            position_nodes_[index] = std::make_shared<const Position>(position);
+            mark_position(index);
+            return true;
+        }
+
+        void SyntheticExposureManager::resize_position(uint32_t index, Volume size)
+        {
+            Position &position = portfolio_.positions[index];
+            if (position.size <= 0.0 || size >= position.size)
+            {
+                return;
+            }
+            // The trimmed part's P&L is realized
+            double realized = position.unrealized_pnl * (1.0 - size / position.size);
+            position.realized_pnl += realized;
+            realized_pnl_ += realized;
+
+            double old_var = position_var(index);
+            double old_exposure = position.exposure_amount;
+            double old_pnl = position.unrealized_pnl;
+            position.size = size;
+            position.exposure_amount = signed_notional(position.side, size, position.current_price);
+            position.unrealized_pnl = unrealized_pnl(position);
+            position.value_at_risk = position_var(index);
+
+            portfolio_.net_exposure += position.exposure_amount - old_exposure;
+            portfolio_.gross_exposure += std::abs(position.exposure_amount) - std::abs(old_exposure);
+            portfolio_.total_pnl += position.unrealized_pnl + realized - old_pnl;
+            current_var_ += position.value_at_risk - old_var;
+            update_size_breach(index);
+            position_nodes_[index] = std::make_shared<const Position>(position);
+            mark_position(index);
+            var_stale_ = true;
+        }
+
+        void SyntheticExposureManager::apply_derivative(uint32_t index, Price underlying_price, double sign)
+        {
+            const SyntheticDerivative &derivative = portfolio_.synthetic_derivatives[index];
+            if (sign > 0.0)
+            {
+                derivative_dollar_deltas_[index] = derivative.delta * underlying_price;
+            }
+            derivative_dollar_delta_ += sign * derivative_dollar_deltas_[index];
+            net_delta_ += sign * derivative.delta;
+            net_gamma_ += sign * derivative.gamma;
+            net_vega_ += sign * derivative.vega;
+            net_theta_ += sign * derivative.theta;
+        }
+
+        void SyntheticExposureManager::add_derivative(SyntheticDerivative derivative, Price underlying_price)
+        {
+            auto index = static_cast<uint32_t>(portfolio_.synthetic_derivatives.size());
+            derivatives_by_underlying_[derivative.underlying_instrument].push_back(index);
+            portfolio_.synthetic_derivatives.push_back(std::move(derivative));
+            derivative_dollar_deltas_.push_back(0.0);
+            apply_derivative(index, underlying_price, 1.0);
+        }
+
+        std::vector<uint32_t> SyntheticExposureManager::find_positions(const std::string &position_id) const
+        {
+            // Trades are booked as <id>-L<n> legs and hedges as <id>-H
+            std::vector<uint32_t> indices;
+            std::string prefix = position_id + "-";
+            for (size_t i = 0; i < portfolio_.positions.size(); ++i)
+            {
+                const std::string &id = portfolio_.positions[i].position_id;
+                if (id == position_id || id.compare(0, prefix.size(), prefix) == 0)
+                {
+                    indices.push_back(static_cast<uint32_t>(i));
+                }
+            }
+            return indices;
+        }
+
+        void SyntheticExposureManager::update_portfolio_metrics()
+        {
+            // Rebuilds the running totals, which drift by rounding over many incremental updates
+            portfolio_.net_exposure = 0.0;
+            portfolio_.gross_exposure = 0.0;
+            portfolio_.total_pnl = realized_pnl_;
+            current_var_ = 0.0;
+            for (size_t i = 0; i < portfolio_.positions.size(); ++i)
+            {
+                const Position &position = portfolio_.positions[i];
+                portfolio_.net_exposure += position.exposure_amount;
+                portfolio_.gross_exposure += std::abs(position.exposure_amount);
+                portfolio_.total_pnl += position.unrealized_pnl;
+                current_var_ += position_var(static_cast<uint32_t>(i));
+            }
+
+            derivative_dollar_delta_ = 0.0;
+            net_delta_ = net_gamma_ = net_vega_ = net_theta_ = 0.0;
+            for (size_t i = 0; i < portfolio_.synthetic_derivatives.size(); ++i)
+            {
+                const SyntheticDerivative &derivative = portfolio_.synthetic_derivatives[i];
+                derivative_dollar_delta_ += derivative_dollar_deltas_[i];
+                net_delta_ += derivative.delta;
+                net_gamma_ += derivative.gamma;
+                net_vega_ += derivative.vega;
+                net_theta_ += derivative.theta;
+            }
+        }
+
+        void SyntheticExposureManager::check_risk_limits()
+        {
+            // Both limits are a comparison against running totals; positions are only walked
+            // when some are known to be over the size limit
+            violations_.clear();
+            if (current_var_ > portfolio_.max_portfolio_var)
+            {
+                violations_.push_back("Portfolio VaR " + std::to_string(current_var_) + " exceeds limit " +
+                                      std::to_string(portfolio_.max_portfolio_var));
+            }
+            if (size_breach_count_ == 0)
+            {
+                return;
+            }
+            for (size_t i = 0; i < portfolio_.positions.size(); ++i)
+            {
+                if (size_breaches_[i])
+                {
+                    const Position &position = portfolio_.positions[i];
+                    violations_.push_back("Position " + position.position_id + " exposure " +
+                                          std::to_string(std::abs(position.exposure_amount)) + " exceeds limit " +
+                                          std::to_string(portfolio_.max_position_size));
+                }
+            }
+        }
+
+        void SyntheticExposureManager::rebalance_if_needed(const MarketSnapshot &market_data,
+                                                           std::vector<PositionTrim> &trims)
+        {
+            // Positions grown past the size limit by price moves are trimmed back to it
+            (void)market_data;
+            if (size_breach_count_ == 0)
+            {
+                return;
+            }
+            for (size_t i = 0; i < portfolio_.positions.size(); ++i)
+            {
+                const Position &position = portfolio_.positions[i];
+                if (size_breaches_[i] && position.current_price > 0.0)
+                {
+                    PositionTrim trim;
+                    trim.position_id = position.position_id;
+                    trim.instrument = position.instrument;
+                    trim.previous_size = position.size;
+                    trim.price = position.current_price;
+                    resize_position(static_cast<uint32_t>(i), portfolio_.max_position_size / position.current_price);
+                    trim.size = position.size;
+                    if (trim.size < trim.previous_size)
+                    {
+                        trims.push_back(std::move(trim));
+                    }
+                }
+            }
+            check_risk_limits();
+        }
+
+        void SyntheticExposureManager::publish_snapshot()
+        {
+            portfolio_.total_exposure = portfolio_.gross_exposure + std::abs(derivative_dollar_delta_);
+            portfolio_.total_var = std::max(current_var_, 0.0);
+
+            auto snapshot = std::make_shared<RiskSnapshot>();
+            snapshot->version = snapshot_.version() + 1;
+            snapshot->published = std::chrono::high_resolution_clock::now();
+            snapshot->total_exposure = portfolio_.total_exposure;
+            snapshot->net_exposure = portfolio_.net_exposure;
+            snapshot->gross_exposure = portfolio_.gross_exposure;
+            snapshot->total_pnl = portfolio_.total_pnl;
+            snapshot->total_var = portfolio_.total_var;
+            snapshot->net_delta = net_delta_;
+            snapshot->net_gamma = net_gamma_;
+            snapshot->net_vega = net_vega_;
+            snapshot->net_theta = net_theta_;
+            snapshot->var_headroom = portfolio_.max_portfolio_var - portfolio_.total_var;
+            snapshot->position_size_limit = portfolio_.max_position_size;
+
+            // Only chunks holding a changed position are rebuilt; the rest are shared with the
+            // previous version, so a tick costs its touched positions plus a pointer per chunk
+            constexpr size_t capacity = RiskPositionChunk::CAPACITY;
+            size_t count = position_nodes_.size();
+            size_t chunks = (count + capacity - 1) / capacity;
+            position_chunks_.resize(chunks);
+            stale_chunks_.resize(chunks, 1);
+            for (size_t chunk = 0; chunk < chunks; ++chunk)
+            {
+                if (!stale_chunks_[chunk])
+                {
+                    continue;
+                }
+                auto rebuilt = std::make_shared<RiskPositionChunk>();
+                size_t end = std::min(count, (chunk + 1) * capacity);
+                rebuilt->positions.assign(position_nodes_.begin() + chunk * capacity, position_nodes_.begin() + end);
+                rebuilt->risk_levels.reserve(end - chunk * capacity);
+                for (size_t i = chunk * capacity; i < end; ++i)
+                {
+                    rebuilt->risk_levels.push_back(position_risk_level(static_cast<uint32_t>(i)));
+                }
+                position_chunks_[chunk] = std::move(rebuilt);
+                stale_chunks_[chunk] = 0;
+            }
+            snapshot->position_chunks = position_chunks_;
+            snapshot->position_count = count;
+            snapshot->violations = violations_;
+
+            if (headroom_feed_)
+            {
+                RiskHeadroom headroom;
+                headroom.var_headroom = snapshot->var_headroom;
+                headroom.position_size_limit = snapshot->position_size_limit;
+                headroom.var_per_notional = ESTIMATED_DAILY_VOLATILITY * normal_quantile(0.95);
+                headroom.halted = !violations_.empty();
+                headroom_feed_->store(headroom);
+            }
+
+            std::shared_ptr<const RiskSnapshot> published = std::move(snapshot);
+            snapshot_.update([&published](std::shared_ptr<const RiskSnapshot> &current)
+                             { current = std::move(published); });
+        }
+
+        void SyntheticExposureManager::set_headroom_feed(std::shared_ptr<RiskHeadroomFeed> feed)
+        {
+            std::lock_guard<std::mutex> lock(portfolio_mutex_);
+            headroom_feed_ = std::move(feed);
+            publish_snapshot();
+        }
+
+        std::shared_ptr<const RiskSnapshot> SyntheticExposureManager::current_snapshot() const
+        {
+            return snapshot_.read([](const std::shared_ptr<const RiskSnapshot> &snapshot)
+                                  { return snapshot; });
+        }
+
+        void SyntheticExposureManager::refresh_value_at_risk()
+        {
+            std::lock_guard<std::mutex> refresh(var_mutex_);
+            if (advanced_calculator_)
+            {
+                std::lock_guard<std::mutex> pending(history_mutex_);
+                apply_pending_prices();
+            }
+
+            // Simulate a copy of the book so writers are not held up
+            Portfolio book;
+            {
+                std::lock_guard<std::mutex> lock(portfolio_mutex_);
+                book.positions = portfolio_.positions;
+                var_stale_ = false;
+            }
+
+            std::vector<double> contributions(book.positions.size(), 0.0);
+            if (!book.positions.empty())
+            {
+                if (advanced_calculator_)
+                {
+                    contributions = advanced_calculator_->calculate_portfolio_risk(book).var_contributions;
+                }
+                else if (risk_calculator_)
+                {
+                    // Standalone VaRs, scaled down so they sum to the diversified total
+                    double total = risk_calculator_->calculate_portfolio_var(book);
+                    double standalone = 0.0;
+                    for (size_t i = 0; i < book.positions.size(); ++i)
+                    {
+                        contributions[i] = risk_calculator_->calculate_value_at_risk(book.positions[i]);
+                        standalone += contributions[i];
+                    }
+                    if (standalone > 0.0)
+                    {
+                        for (double &contribution : contributions)
+                        {
+                            contribution *= total / standalone;
+                        }
+                    }
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(portfolio_mutex_);
+            for (size_t i = 0; i < book.positions.size(); ++i)
+            {
+                // Positions closed meanwhile are gone; trimmed ones rescale from the copied exposure
+                auto found = position_index_.find(book.positions[i].position_id);
+                if (found != position_index_.end())
+                {
+                    var_basis_[found->second] = contributions[i];
+                    var_basis_exposure_[found->second] = book.positions[i].exposure_amount;
+                }
+            }
+            for (size_t i = 0; i < portfolio_.positions.size(); ++i)
+            {
+                Position &position = portfolio_.positions[i];
+                position.value_at_risk = position_var(static_cast<uint32_t>(i));
+                position_nodes_[i] = std::make_shared<const Position>(position);
+            }
+            mark_all_positions();
+            update_portfolio_metrics();
+            last_var_refresh_ = std::chrono::steady_clock::now();
+            check_risk_limits();
+            publish_snapshot();
+        }
+
+        void SyntheticExposureManager::apply_pending_prices()
+        {
+            for (const auto &[instrument, price] : pending_prices_)
+            {
+                advanced_calculator_->record_price(instrument, price);
+            }
+            pending_prices_.clear();
+        }
+
+        bool SyntheticExposureManager::value_at_risk_due() const
+        {
+            return var_stale_ && std::chrono::steady_clock::now() - last_var_refresh_ >= var_refresh_interval_;
+        }
+
+        void SyntheticExposureManager::set_var_refresh_interval(std::chrono::milliseconds interval)
+        {
+            {
+                std::lock_guard<std::mutex> lock(portfolio_mutex_);
+                var_refresh_interval_ = interval;
+            }
+            std::lock_guard<std::mutex> stage(risk_stage_mutex_);
+            risk_stage_wakeup_.notify_one(); // re-arm the risk stage's wait with the new interval
+        }
+
+        bool SyntheticExposureManager::start_risk_stage(const concurrency::StagePlacement &placement)
+        {
+            std::lock_guard<std::mutex> stage(risk_stage_mutex_);
+            if (risk_stage_running_ || risk_stage_thread_.joinable())
+            {
+                return false;
+            }
+            risk_stage_running_ = true;
+            risk_stage_thread_ = std::thread(&SyntheticExposureManager::risk_stage_loop, this, placement);
+            return true;
+        }
+
+        void SyntheticExposureManager::stop_risk_stage()
+        {
+            {
+                std::lock_guard<std::mutex> stage(risk_stage_mutex_);
+                risk_stage_running_ = false;
+                risk_stage_wakeup_.notify_one();
+            }
+            if (risk_stage_thread_.joinable())
+            {
+                risk_stage_thread_.join();
+            }
+        }
+
+        void SyntheticExposureManager::risk_stage_loop(concurrency::StagePlacement placement)
+        {
+            if (!placement.floating())
+            {
+                concurrency::apply_placement(placement);
+            }
+
+            for (;;)
+            {
+                std::chrono::milliseconds interval;
+                bool due;
+                {
+                    std::lock_guard<std::mutex> lock(portfolio_mutex_);
+                    interval = var_refresh_interval_;
+                    due = value_at_risk_due();
+                }
+                if (due)
+                {
+                    refresh_value_at_risk();
+                }
+
+                // A tick that finds a refresh due wakes the wait early
+                std::unique_lock<std::mutex> stage(risk_stage_mutex_);
+                if (!risk_stage_running_)
+                {
+                    return;
+                }
+                risk_stage_wakeup_.wait_for(stage, std::max(interval, std::chrono::milliseconds(1)));
+                if (!risk_stage_running_)
+                {
+                    return;
+                }
+            }
+        }
+
+        void SyntheticExposureManager::set_trim_callback(PositionTrimCallback callback)
+        {
+            std::lock_guard<std::mutex> lock(portfolio_mutex_);
+            trim_callback_ = std::move(callback);
+        }
+
+        void SyntheticExposureManager::update_market_data(const MarketSnapshot &market_data)
+        {
+            bool refresh_due = false;
+            std::vector<PositionTrim> trims;
+            PositionTrimCallback on_trim;
+            {
+                std::lock_guard<std::mutex> lock(portfolio_mutex_);
+                bool changed = false;
+                for (auto instrument : market_data.dirty_instruments())
+                {
+                    if (!market_data.has_quote(instrument))
+                    {
+                        continue;
+                    }
+                    Price price = market_data.mid_price(instrument);
+
+                    auto positions = positions_by_instrument_.find(instrument);
+                    if (positions != positions_by_instrument_.end())
+                    {
+                        for (auto index : positions->second)
+                        {
+                            changed |= apply_price(index, price, market_data.snapshot_time);
+                        }
+                    }
+
+                    auto derivatives = derivatives_by_underlying_.find(instrument);
+                    if (derivatives != derivatives_by_underlying_.end() && derivative_constructor_)
+                    {
+                        for (auto index : derivatives->second)
+                        {
+                            apply_derivative(index, price, -1.0);
+                            derivative_constructor_->update_greeks(portfolio_.synthetic_derivatives[index], market_data);
+                            apply_derivative(index, price, 1.0);
+                        }
+                        changed = true;
+                    }
+                }
+
+                if (changed)
+                {
+                    var_stale_ = true;
+                    check_risk_limits();
+                    rebalance_if_needed(market_data, trims);
+                    publish_snapshot();
+                }
+                refresh_due = value_at_risk_due();
+                if (!trims.empty())
+                {
+                    on_trim = trim_callback_;
+                }
+            }
+
+            if (advanced_calculator_)
+            {
+                // Recording a price is cheap, but a refresh holds the calculator for the whole
+                // simulation; meanwhile the prices queue for it rather than wait
+                std::unique_lock<std::mutex> refresh(var_mutex_, std::try_to_lock);
+                std::lock_guard<std::mutex> pending(history_mutex_);
+                for (auto instrument : market_data.dirty_instruments())
+                {
+                    if (market_data.has_quote(instrument))
+                    {
+                        pending_prices_.emplace_back(instrument, market_data.mid_price(instrument));
+                    }
+                }
+                if (refresh.owns_lock())
+                {
+                    apply_pending_prices();
+                }
+            }
+            if (refresh_due)
+            {
+                // The simulation itself runs on the risk stage, never on the tick path
+                std::lock_guard<std::mutex> stage(risk_stage_mutex_);
+                risk_stage_wakeup_.notify_one();
+            }
+            if (on_trim)
+            {
+                for (const auto &trim : trims)
+                {
+                    on_trim(trim);
+                }
+            }
+        }
+
+        std::string SyntheticExposureManager::add_synthetic_derivative(DerivativeType type, InstrumentHandle underlying,
+                                                                       const MarketSnapshot &market_data)
+        {
+            // Swaps need a second leg, which this interface does not carry
+            if (!derivative_constructor_ || !market_data.has_quote(underlying) || (!is_forward(type) && !is_option(type)))
+            {
+                return "";
+            }
+            Price spot = market_data.mid_price(underlying);
+            Timestamp expiry = std::chrono::high_resolution_clock::now() + std::chrono::hours(24 * DERIVATIVE_TENOR_DAYS);
+
+            std::lock_guard<std::mutex> lock(portfolio_mutex_);
+            SyntheticDerivative derivative =
+                is_forward(type) ? derivative_constructor_->construct_synthetic_forward(underlying, spot, expiry, market_data)
+                                 : derivative_constructor_->construct_synthetic_option(underlying, type, spot, expiry, market_data);
+            derivative.derivative_id = generate_derivative_id();
+            std::string id = derivative.derivative_id;
+            add_derivative(std::move(derivative), spot);
+            publish_snapshot();
+            return id;
+        }
+
+        std::string SyntheticExposureManager::execute_arbitrage_opportunity(const ArbitrageOpportunity &opportunity,
+                                                                            const MarketSnapshot &market_data)
+        {
+            if (opportunity.legs.empty())
+            {
+                return "";
+            }
+
+            Volume size = 0.0;
+            if (position_sizer_)
+            {
+                // The sizer sees the aggregates, not the positions
+                auto snapshot = current_snapshot();
+                Portfolio summary;
+                RiskParameters params;
+                {
+                    std::lock_guard<std::mutex> lock(portfolio_mutex_);
+                    summary.max_position_size = portfolio_.max_position_size;
+                    summary.max_portfolio_var = portfolio_.max_portfolio_var;
+                    params = risk_params_;
+                }
+                summary.total_exposure = snapshot->total_exposure;
+                summary.net_exposure = snapshot->net_exposure;
+                summary.gross_exposure = snapshot->gross_exposure;
+                summary.total_pnl = snapshot->total_pnl;
+                summary.total_var = snapshot->total_var;
+                size = position_sizer_->calculate_optimal_position_size(opportunity, summary, params);
+            }
+            if (size <= 0.0)
+            {
+                size = opportunity.total_volume > 0.0 ? opportunity.total_volume : opportunity.legs[0].size;
+            }
+            if (!validate_new_position(opportunity, size))
+            {
+                return "";
+            }
+
+            std::string trade_id = generate_position_id();
+            std::lock_guard<std::mutex> lock(portfolio_mutex_);
+            for (size_t k = 0; k < opportunity.legs.size(); ++k)
+            {
+                const ArbitrageLeg &leg = opportunity.legs[k];
+                Position position;
+                position.position_id = trade_id + "-L" + std::to_string(k);
+                position.instrument = leg.instrument;
+                position.side = leg.side == Side::BID ? PositionSide::LONG : PositionSide::SHORT; // BID legs buy
+                position.size = leg_size(leg, size);
+                position.entry_price = leg.entry_price; // validated positive
+                position.current_price = market_data.has_quote(leg.instrument) ? market_data.mid_price(leg.instrument)
+                                                                               : position.entry_price;
+                add_position(std::move(position));
+            }
+            check_risk_limits();
+            publish_snapshot();
+            return trade_id;
+        }
+
+        void SyntheticExposureManager::close_position(const std::string &position_id)
+        {
+            std::lock_guard<std::mutex> lock(portfolio_mutex_);
+            auto indices = find_positions(position_id);
+            if (indices.empty())
+            {
+                return;
+            }
+            // Highest first, so the swap-removal never moves one still to be removed
+            for (auto it = indices.rbegin(); it != indices.rend(); ++it)
+            {
+                remove_position(*it);
+            }
+            check_risk_limits();
+            publish_snapshot();
+        }
+
+        void SyntheticExposureManager::hedge_position(const std::string &position_id, const MarketSnapshot &market_data)
+        {
+            std::lock_guard<std::mutex> lock(portfolio_mutex_);
+            bool hedged = false;
+            for (auto index : find_positions(position_id))
+            {
+                Position original = portfolio_.positions[index];
+                std::string hedge_id = original.position_id + "-H";
+                bool is_hedge = original.position_id.size() >= 2 &&
+                                original.position_id.compare(original.position_id.size() - 2, 2, "-H") == 0;
+                if (original.side == PositionSide::NEUTRAL || is_hedge || position_index_.count(hedge_id))
+                {
+                    continue;
+                }
+                Position hedge;
+                hedge.position_id = hedge_id;
+                hedge.instrument = original.instrument;
+                hedge.side = original.side == PositionSide::LONG ? PositionSide::SHORT : PositionSide::LONG;
+                hedge.size = original.size;
+                hedge.entry_price = market_data.has_quote(original.instrument) ? market_data.mid_price(original.instrument)
+                                                                               : original.current_price;
+                add_position(std::move(hedge));
+                hedged = true;
+            }
+            if (hedged)
+            {
+                check_risk_limits();
+                publish_snapshot();
+            }
+        }
+
+        Portfolio SyntheticExposureManager::get_portfolio() const
+        {
+            std::lock_guard<std::mutex> lock(portfolio_mutex_);
+            return portfolio_;
+        }
+
+        void SyntheticExposureManager::set_risk_parameters(const RiskParameters &params)
+        {
+            std::lock_guard<std::mutex> lock(portfolio_mutex_);
+            risk_params_ = params;
+            mark_all_positions(); // risk levels are rated against max_individual_var
+            check_risk_limits();
+            publish_snapshot();
+        }
+
+        std::vector<Position> SyntheticExposureManager::get_positions_by_risk_level(RiskLevel level) const
+        {
+            auto snapshot = current_snapshot();
+            std::vector<Position> positions;
+            for (size_t i = 0; i < snapshot->position_count; ++i)
+            {
+                if (snapshot->risk_level(i) == level)
+                {
+                    positions.push_back(snapshot->position(i));
+                }
+            }
+            return positions;
+        }
+
+        bool SyntheticExposureManager::validate_new_position(const ArbitrageOpportunity &opportunity,
+                                                             Volume proposed_size) const
+        {
+            if (proposed_size <= 0.0 || opportunity.legs.empty())
+            {
+                return false;
+            }
+            auto snapshot = current_snapshot();
+            if (!snapshot->violations.empty())
+            {
+                return false;
+            }
+
+            // Legs are taken as uncorrelated: between the hedged (net) and undiversified (gross) extremes
+            double variance = 0.0;
+            for (const auto &leg : opportunity.legs)
+            {
+                double notional = leg_size(leg, proposed_size) * leg.entry_price;
+                if (leg.entry_price <= 0.0 || notional > snapshot->position_size_limit)
+                {
+                    return false;
+                }
+                variance += notional * notional;
+            }
+            double incremental_var = std::sqrt(variance) * ESTIMATED_DAILY_VOLATILITY * normal_quantile(0.95);
+            return incremental_var <= snapshot->var_headroom;
+        }
+
+        std::vector<std::string> SyntheticExposureManager::get_risk_violations() const
+        {
+            return current_snapshot()->violations;
+        }
+
+        void SyntheticExposureManager::emergency_risk_reduction()
+        {
+            std::lock_guard<std::mutex> lock(portfolio_mutex_);
+            // Close what is rated HIGH or worse or over the size limit, then halve the rest
+            // while VaR stays over its limit
+            for (size_t i = portfolio_.positions.size(); i-- > 0;)
+            {
+                auto index = static_cast<uint32_t>(i);
+                if (size_breaches_[index] || position_risk_level(index) >= RiskLevel::HIGH)
+                {
+                    remove_position(index);
+                }
+            }
+            for (int round = 0; round < 8 && current_var_ > portfolio_.max_portfolio_var; ++round)
+            {
+                for (size_t i = 0; i < portfolio_.positions.size(); ++i)
+                {
+                    resize_position(static_cast<uint32_t>(i), portfolio_.positions[i].size / 2.0);
+                }
+            }
+            check_risk_limits();
+            publish_snapshot();
+        }
+
+        double SyntheticExposureManager::get_total_pnl() const
+        {
+            return current_snapshot()->total_pnl;
+        }
+
+        double SyntheticExposureManager::get_portfolio_var() const
+        {
+            return current_snapshot()->total_var;
+        }
+
+        double SyntheticExposureManager::get_portfolio_exposure() const
+        {
+            return current_snapshot()->total_exposure;
+        }
+
+        std::map<std::string, double> SyntheticExposureManager::get_risk_metrics() const
+        {
+            auto snapshot = current_snapshot();
+            return {{"total_exposure", snapshot->total_exposure},
+                    {"net_exposure", snapshot->net_exposure},
+                    {"gross_exposure", snapshot->gross_exposure},
+                    {"total_pnl", snapshot->total_pnl},
+                    {"total_var", snapshot->total_var},
+                    {"var_headroom", snapshot->var_headroom},
+                    {"net_delta", snapshot->net_delta},
+                    {"net_gamma", snapshot->net_gamma},
+                    {"net_vega", snapshot->net_vega},
+                    {"net_theta", snapshot->net_theta},
+                    {"positions", static_cast<double>(snapshot->position_count)},
+                    {"violations", static_cast<double>(snapshot->violations.size())}};
+        }
+
+    } // namespace exposure
+} // namespace spe
@@ -0,0 +1,171 @@
+#include "feed_arbiter.hpp"
+#include <cctype>
+
+namespace spe
+{
+    namespace exchange_ws
+    {
+
+        FeedArbiter::Arrival FeedArbiter::SequenceWindow::classify(uint64_t sequence, int64_t now, int64_t &lag,
+                                                                   uint64_t &skipped)
+        {
+            if (highest == 0 || sequence > highest)
+            {
+                uint64_t shift = highest == 0 ? WINDOW : sequence - highest;
+                skipped = highest == 0 ? 0 : shift - 1;
+                delivered = (shift >= WINDOW ? 0 : delivered << shift) | 1;
+                highest = sequence;
+                first_arrival[sequence % WINDOW] = now;
+                return Arrival::NEW;
+            }
+            uint64_t offset = highest - sequence;
+            if (offset >= WINDOW)
+            {
+                return Arrival::STALE; // too old to tell a gap from a duplicate
+            }
+            uint64_t bit = uint64_t(1) << offset;
+            if (delivered & bit)
+            {
+                lag = now - first_arrival[sequence % WINDOW];
+                return Arrival::DUPLICATE;
+            }
+            delivered |= bit;
+            first_arrival[sequence % WINDOW] = now;
+            return Arrival::GAP_FILL;
+        }
+
+        FeedArbiter::FeedArbiter(size_t capacity) : capacity_(capacity), streams_(new Stream[capacity]) {}
+
+        int64_t FeedArbiter::now_ns()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        uint64_t FeedArbiter::trade_sequence(const Trade &trade)
+        {
+            if (trade.sequence_number != 0)
+            {
+                return trade.sequence_number;
+            }
+            // Binance t and OKX tradeId are per-instrument counters sent as decimal strings
+            if (trade.trade_id.empty() || trade.trade_id.size() > 19)
+            {
+                return 0;
+            }
+            uint64_t id = 0;
+            for (char c : trade.trade_id)
+            {
+                if (!std::isdigit(static_cast<unsigned char>(c)))
+                {
+                    return 0;
+                }
+                id = id * 10 + static_cast<uint64_t>(c - '0');
+            }
+            return id;
+        }
+
+        void FeedArbiter::on_orderbook(LineId line, const OrderBookSnapshot &snapshot)
+        {
+            if (snapshot.sequence_number == 0 || snapshot.instrument >= capacity_ || line >= MAX_LINES)
+            {
+                unarbitrated_.fetch_add(1, std::memory_order_relaxed);
+                if (orderbook_callback_)
+                {
+                    orderbook_callback_(snapshot);
+                }
+                return;
+            }
+            LineStats &stats = lines_[line];
+            int64_t lag = 0;
+            uint64_t skipped = 0;
+            Stream &stream = streams_[snapshot.instrument];
+            std::lock_guard<std::mutex> lock(stream.mutex);
+            switch (stream.books.classify(snapshot.sequence_number, now_ns(), lag, skipped))
+            {
+            case Arrival::NEW:
+                stats.wins.fetch_add(1, std::memory_order_relaxed);
+                if (orderbook_callback_)
+                {
+                    orderbook_callback_(snapshot);
+                }
+                break;
+            case Arrival::DUPLICATE:
+                stats.duplicates.fetch_add(1, std::memory_order_relaxed);
+                stats.lag.record(lag > 0 ? static_cast<uint64_t>(lag) : 0);
+                break;
+            case Arrival::GAP_FILL: // book sequence numbers are not contiguous, and a newer book is already out
+            case Arrival::STALE:
+                stats.stale.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        void FeedArbiter::on_trade(LineId line, const Trade &trade)
+        {
+            uint64_t sequence = trade_sequence(trade);
+            if (sequence == 0 || trade.instrument >= capacity_ || line >= MAX_LINES)
+            {
+                unarbitrated_.fetch_add(1, std::memory_order_relaxed);
+                if (trade_callback_)
+                {
+                    trade_callback_(trade);
+                }
+                return;
+            }
+            LineStats &stats = lines_[line];
+            int64_t lag = 0;
+            uint64_t skipped = 0;
+            Stream &stream = streams_[trade.instrument];
+            std::lock_guard<std::mutex> lock(stream.mutex);
+            switch (stream.trades.classify(sequence, now_ns(), lag, skipped))
+            {
+            case Arrival::NEW:
+                stats.wins.fetch_add(1, std::memory_order_relaxed);
+                if (skipped != 0)
+                {
+                    gaps_opened_.fetch_add(skipped, std::memory_order_relaxed);
+                }
+                break;
+            case Arrival::GAP_FILL:
+                stats.gap_fills.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case Arrival::DUPLICATE:
+                stats.duplicates.fetch_add(1, std::memory_order_relaxed);
+                stats.lag.record(lag > 0 ? static_cast<uint64_t>(lag) : 0);
+                return;
+            case Arrival::STALE:
+                stats.stale.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            if (trade_callback_)
+            {
+                trade_callback_(trade);
+            }
+        }
+
+        void FeedArbiter::reset(InstrumentHandle instrument)
+        {
+            if (instrument >= capacity_)
+            {
+                return;
+            }
+            Stream &stream = streams_[instrument];
+            std::lock_guard<std::mutex> lock(stream.mutex);
+            stream.books = SequenceWindow();
+            stream.trades = SequenceWindow();
+        }
+
+        uint64_t FeedArbiter::gaps_filled() const
+        {
+            uint64_t filled = 0;
+            for (const auto &line : lines_)
+            {
+                filled += line.gap_fills.load(std::memory_order_relaxed);
+            }
+            return filled;
+        }
+
+    } // namespace exchange_ws
+} // namespace spe
@@ -0,0 +1,52 @@
+#include "instrument_registry.hpp"
+
+namespace spe
+{
+    namespace market_data
+    {
+
+        InstrumentRegistry::InstrumentRegistry() : size_(0) {}
+
+        InstrumentRegistry &InstrumentRegistry::instance()
+        {
+            static InstrumentRegistry registry;
+            return registry;
+        }
+
+        InstrumentHandle InstrumentRegistry::intern(const InstrumentId &symbol)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = handles_.find(symbol);
+            if (it != handles_.end())
+            {
+                return it->second;
+            }
+
+            auto handle = static_cast<InstrumentHandle>(symbols_.size());
+            symbols_.push_back(symbol);
+            handles_.emplace(symbol, handle);
+            size_.store(symbols_.size(), std::memory_order_release);
+            return handle;
+        }
+
+        InstrumentHandle InstrumentRegistry::find(const InstrumentId &symbol) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = handles_.find(symbol);
+            return (it != handles_.end()) ? it->second : INVALID_INSTRUMENT;
+        }
+
+        const InstrumentId &InstrumentRegistry::symbol(InstrumentHandle handle) const
+        {
+            static const InstrumentId unknown = "UNKNOWN";
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (handle >= symbols_.size())
+            {
+                return unknown;
+            }
+            return symbols_[handle];
+        }
+
+    } // namespace market_data
+} // namespace spe
@@ -0,0 +1,260 @@
+#include "latency_monitor.hpp"
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+
+namespace spe
+{
+    namespace telemetry
+    {
+
+        const char *stage_name(LatencyStage stage)
+        {
+            switch (stage)
+            {
+            case LatencyStage::PARSE:
+                return "parse";
+            case LatencyStage::BOOK_UPDATE:
+                return "book_update";
+            case LatencyStage::QUEUE:
+                return "queue";
+            case LatencyStage::DETECTION:
+                return "detection";
+            case LatencyStage::VALIDATION:
+                return "validation";
+            case LatencyStage::CALLBACK:
+                return "callback";
+            case LatencyStage::END_TO_END:
+                return "end_to_end";
+            default:
+                return "unknown";
+            }
+        }
+
+        uint64_t LatencyClock::to_nanoseconds(uint64_t ticks)
+        {
+#if defined(SPE_LATENCY_USE_TSC) && (defined(__x86_64__) || defined(_M_X64))
+            // Calibrated once against steady_clock over a few milliseconds
+            static const double nanoseconds_per_tick = []
+            {
+                auto wall_start = std::chrono::steady_clock::now();
+                uint64_t tick_start = __rdtsc();
+                while (std::chrono::steady_clock::now() - wall_start < std::chrono::milliseconds(5))
+                {
+                }
+                uint64_t ticks_elapsed = __rdtsc() - tick_start;
+                double wall_elapsed = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                              std::chrono::steady_clock::now() - wall_start)
+                                                              .count());
+                return ticks_elapsed ? wall_elapsed / static_cast<double>(ticks_elapsed) : 1.0;
+            }();
+            return static_cast<uint64_t>(static_cast<double>(ticks) * nanoseconds_per_tick);
+#else
+            return ticks;
+#endif
+        }
+
+        struct LatencyMonitor::ThreadSlot
+        {
+            ThreadHistograms *block = nullptr;
+
+            ~ThreadSlot()
+            {
+                if (block)
+                {
+                    block->in_use.store(false, std::memory_order_release); // counts stay; the next thread continues them
+                }
+            }
+        };
+
+        LatencyMonitor::LatencyMonitor() : dump_running_(false) {}
+
+        LatencyMonitor::~LatencyMonitor()
+        {
+            stop_periodic_dump();
+        }
+
+        LatencyMonitor &LatencyMonitor::instance()
+        {
+            static LatencyMonitor monitor;
+            return monitor;
+        }
+
+        SeriesId LatencyMonitor::series(const std::string &source, LatencyStage stage)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < series_.size(); ++i)
+            {
+                if (series_[i].second == stage && series_[i].first == source)
+                {
+                    return static_cast<SeriesId>(i);
+                }
+            }
+            if (series_.size() >= MAX_SERIES)
+            {
+                return INVALID_SERIES;
+            }
+            series_.emplace_back(source, stage);
+            return static_cast<SeriesId>(series_.size() - 1);
+        }
+
+        LatencyMonitor::ThreadHistograms &LatencyMonitor::local()
+        {
+            thread_local ThreadSlot slot;
+            if (!slot.block)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (auto &block : threads_)
+                {
+                    bool expected = false;
+                    if (block->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                    {
+                        slot.block = block.get();
+                        break;
+                    }
+                }
+                if (!slot.block)
+                {
+                    threads_.push_back(std::make_unique<ThreadHistograms>());
+                    slot.block = threads_.back().get();
+                }
+            }
+            return *slot.block;
+        }
+
+        LatencyHistogram &LatencyMonitor::local_histogram(SeriesId series)
+        {
+            ThreadHistograms &thread = local();
+            LatencyHistogram *histogram = thread.series[series].load(std::memory_order_relaxed);
+            if (!histogram)
+            {
+                // First sample of this series on this thread
+                std::lock_guard<std::mutex> lock(mutex_);
+                thread.owned.push_back(std::make_unique<LatencyHistogram>());
+                histogram = thread.owned.back().get();
+                thread.series[series].store(histogram, std::memory_order_release);
+            }
+            return *histogram;
+        }
+
+        std::vector<LatencySummary> LatencyMonitor::collect(bool interval)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::vector<LatencySummary> summaries;
+            if (interval && previous_.size() < series_.size())
+            {
+                previous_.resize(series_.size());
+            }
+
+            LatencyHistogram total;
+            LatencyHistogram delta;
+            for (size_t s = 0; s < series_.size(); ++s)
+            {
+                total.clear();
+                for (const auto &thread : threads_)
+                {
+                    if (const LatencyHistogram *histogram = thread->series[s].load(std::memory_order_acquire))
+                    {
+                        total.merge(*histogram);
+                    }
+                }
+
+                const LatencyHistogram *report = &total;
+                if (interval)
+                {
+                    if (!previous_[s])
+                    {
+                        previous_[s] = std::make_unique<LatencyHistogram>();
+                    }
+                    delta.clear();
+                    delta.merge(total);
+                    delta.merge(*previous_[s], -1);
+                    previous_[s]->clear();
+                    previous_[s]->merge(total);
+                    report = &delta;
+                }
+
+                if (report->count() == 0)
+                {
+                    continue;
+                }
+                LatencySummary summary;
+                summary.source = series_[s].first;
+                summary.stage = series_[s].second;
+                summary.count = report->count();
+                summary.mean_ns = report->mean();
+                summary.min_ns = report->min();
+                summary.p50_ns = report->percentile(0.50);
+                summary.p90_ns = report->percentile(0.90);
+                summary.p99_ns = report->percentile(0.99);
+                summary.p999_ns = report->percentile(0.999);
+                summary.max_ns = report->max();
+                summaries.push_back(summary);
+            }
+            return summaries;
+        }
+
+        void LatencyMonitor::start_periodic_dump(std::chrono::milliseconds period, LatencyReportSink sink)
+        {
+            stop_periodic_dump();
+            if (!sink)
+            {
+                sink = [](const std::vector<LatencySummary> &summaries)
+                {
+                    std::fputs(format(summaries).c_str(), stdout);
+                    std::fflush(stdout);
+                };
+            }
+
+            dump_running_ = true;
+            dump_thread_ = std::thread([this, period, sink]
+                                       {
+                                           std::unique_lock<std::mutex> lock(dump_mutex_);
+                                           while (dump_running_)
+                                           {
+                                               if (dump_wake_.wait_for(lock, period, [this] { return !dump_running_; }))
+                                               {
+                                                   break;
+                                               }
+                                               lock.unlock();
+                                               auto summaries = collect(true);
+                                               if (!summaries.empty())
+                                               {
+                                                   sink(summaries);
+                                               }
+                                               lock.lock();
+                                           } });
+        }
+
+        void LatencyMonitor::stop_periodic_dump()
+        {
+            {
+                std::lock_guard<std::mutex> lock(dump_mutex_);
+                dump_running_ = false;
+            }
+            dump_wake_.notify_all();
+            if (dump_thread_.joinable())
+            {
+                dump_thread_.join();
+            }
+        }
+
+        std::string LatencyMonitor::format(const std::vector<LatencySummary> &summaries)
+        {
+            std::ostringstream out;
+            out << std::left << std::setw(16) << "source" << std::setw(13) << "stage" << std::right
+                << std::setw(10) << "count" << std::setw(10) << "mean_us" << std::setw(10) << "p50_us"
+                << std::setw(10) << "p99_us" << std::setw(10) << "p99.9_us" << std::setw(10) << "max_us" << "\n";
+            out << std::fixed << std::setprecision(2);
+            for (const auto &summary : summaries)
+            {
+                out << std::left << std::setw(16) << summary.source << std::setw(13) << stage_name(summary.stage)
+                    << std::right << std::setw(10) << summary.count << std::setw(10) << summary.mean_ns / 1000.0
+                    << std::setw(10) << summary.p50_ns / 1000.0 << std::setw(10) << summary.p99_ns / 1000.0
+                    << std::setw(10) << summary.p999_ns / 1000.0 << std::setw(10) << summary.max_ns / 1000.0 << "\n";
+            }
+            return out.str();
+        }
+
+    } // namespace telemetry
+} // namespace spe
@@ -0,0 +1,182 @@
+#include "linear_algebra.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace spe
+{
+    namespace linalg
+    {
+
+        void DenseMatrix::resize(size_t rows, size_t cols)
+        {
+            rows_ = rows;
+            cols_ = cols;
+            stride_ = (cols + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+            data_.assign(rows_ * stride_, 0.0);
+        }
+
+        void DenseMatrix::fill(double value)
+        {
+            for (size_t r = 0; r < rows_; ++r)
+            {
+                std::fill(row(r), row(r) + cols_, value);
+            }
+        }
+
+        void DenseMatrix::set_identity(size_t dimension)
+        {
+            resize(dimension, dimension);
+            for (size_t i = 0; i < dimension; ++i)
+            {
+                (*this)(i, i) = 1.0;
+            }
+        }
+
+        double dot(const double *a, const double *b, size_t n)
+        {
+            // Independent accumulators so the adds pipeline and the loop vectorizes
+            double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                s0 += a[i] * b[i];
+                s1 += a[i + 1] * b[i + 1];
+                s2 += a[i + 2] * b[i + 2];
+                s3 += a[i + 3] * b[i + 3];
+            }
+            for (; i < n; ++i)
+            {
+                s0 += a[i] * b[i];
+            }
+            return (s0 + s1) + (s2 + s3);
+        }
+
+        void multiply(const DenseMatrix &a, const double *x, double *y)
+        {
+            for (size_t r = 0; r < a.rows(); ++r)
+            {
+                y[r] = dot(a.row(r), x, a.cols());
+            }
+        }
+
+        double quadratic_form(const DenseMatrix &a, const double *x)
+        {
+            double total = 0.0;
+            for (size_t r = 0; r < a.rows(); ++r)
+            {
+                total += x[r] * dot(a.row(r), x, a.cols());
+            }
+            return total;
+        }
+
+        void gather_principal(const DenseMatrix &a, const std::vector<size_t> &indices, DenseMatrix &out)
+        {
+            size_t n = indices.size();
+            out.resize(n, n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                const double *source = a.row(indices[i]);
+                double *target = out.row(i);
+                for (size_t j = 0; j < n; ++j)
+                {
+                    target[j] = source[indices[j]];
+                }
+            }
+        }
+
+        void gather_covariance(const stats::StreamingCorrelationMatrix &matrix,
+                               const std::vector<InstrumentHandle> &instruments, DenseMatrix &out)
+        {
+            size_t n = instruments.size();
+            out.resize(n, n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                for (size_t j = i; j < n; ++j)
+                {
+                    double covariance = matrix.covariance(instruments[i], instruments[j]);
+                    out(i, j) = covariance;
+                    out(j, i) = covariance;
+                }
+            }
+        }
+
+        void gather_cross_covariance(const stats::StreamingCorrelationMatrix &matrix,
+                                     const std::vector<InstrumentHandle> &instruments, InstrumentHandle target,
+                                     std::vector<double> &cross)
+        {
+            cross.resize(instruments.size());
+            for (size_t i = 0; i < instruments.size(); ++i)
+            {
+                cross[i] = matrix.covariance(instruments[i], target);
+            }
+        }
+
+        RidgeSolution RidgeSolver::solve(const DenseMatrix &a, const double *b, double lambda, double *x,
+                                         double tolerance, size_t max_iterations)
+        {
+            size_t n = a.rows();
+            RidgeSolution solution;
+            double b_norm = std::sqrt(dot(b, b, n));
+            if (n == 0 || b_norm == 0.0)
+            {
+                std::fill(x, x + n, 0.0);
+                solution.converged = true;
+                return solution;
+            }
+            if (max_iterations == 0)
+            {
+                max_iterations = n;
+            }
+
+            residual_.resize(n);
+            direction_.resize(n);
+            product_.resize(n);
+            double *r = residual_.data();
+            double *p = direction_.data();
+            double *q = product_.data();
+
+            // r = b - (A + lambda I) x from the warm start
+            multiply(a, x, q);
+            for (size_t i = 0; i < n; ++i)
+            {
+                r[i] = b[i] - q[i] - lambda * x[i];
+                p[i] = r[i];
+            }
+            double rr = dot(r, r, n);
+            double limit = tolerance * b_norm;
+
+            while (solution.iterations < max_iterations && std::sqrt(rr) > limit)
+            {
+                multiply(a, p, q);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    q[i] += lambda * p[i];
+                }
+                double curvature = dot(p, q, n);
+                if (curvature <= 0.0)
+                {
+                    break; // singular along p: lambda is too small for this A
+                }
+                double step = rr / curvature;
+                for (size_t i = 0; i < n; ++i)
+                {
+                    x[i] += step * p[i];
+                    r[i] -= step * q[i];
+                }
+                double next_rr = dot(r, r, n);
+                double beta = next_rr / rr;
+                for (size_t i = 0; i < n; ++i)
+                {
+                    p[i] = r[i] + beta * p[i];
+                }
+                rr = next_rr;
+                ++solution.iterations;
+            }
+
+            solution.residual = std::sqrt(rr) / b_norm;
+            solution.converged = std::sqrt(rr) <= limit;
+            return solution;
+        }
+
+    } // namespace linalg
+} // namespace spe
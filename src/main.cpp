@@ -2,6 +2,7 @@
 #include "mispricing_detector.hpp"
 #include "pricing_models.hpp"
 #include "market_data.hpp"
+#include "instrument_registry.hpp"
 #include <iostream>
 #include <iomanip>
 #include <thread>
@@ -19,23 +20,30 @@ private:
     std::mt19937 gen;
     std::uniform_real_distribution<> price_dis;
     std::uniform_real_distribution<> vol_dis;
+    std::vector<market_data::InstrumentHandle> instruments;
+    market_data::SnapshotStore store;
 
 public:
-    DemoDataGenerator() : gen(rd()), price_dis(95.0, 105.0), vol_dis(1000.0, 50000.0) {}
+    DemoDataGenerator() : gen(rd()), price_dis(95.0, 105.0), vol_dis(1000.0, 50000.0)
+    {
+        // Intern the demo universe once, as a feed would at subscription time
+        for (const auto &symbol : {"BTC-USD", "ETH-USD", "BTC-ETH", "USDT-USD"})
+        {
+            instruments.push_back(market_data::intern_instrument(symbol));
+        }
+        store.reserve(market_data::InstrumentRegistry::instance().size());
+    }
 
     market_data::MarketSnapshot generate_snapshot()
     {
-        market_data::MarketSnapshot snapshot;
-        snapshot.snapshot_time = std::chrono::high_resolution_clock::now();
+        auto now = std::chrono::high_resolution_clock::now();
 
         // Generate sample quotes for different instruments
-        std::vector<std::string> symbols = {"BTC-USD", "ETH-USD", "BTC-ETH", "USDT-USD"};
-
-        for (const auto &symbol : symbols)
+        for (auto instrument : instruments)
         {
             market_data::Quote quote;
-            quote.instrument_id = symbol;
-            quote.timestamp = snapshot.snapshot_time;
+            quote.instrument = instrument;
+            quote.timestamp = now;
 
             double base_price = price_dis(gen);
             quote.bid_price = base_price - 0.05;
@@ -43,10 +51,10 @@ public:
             quote.bid_size = vol_dis(gen);
             quote.ask_size = vol_dis(gen);
 
-            snapshot.quotes[symbol] = quote;
+            store.apply_quote(quote);
         }
 
-        return snapshot;
+        return store.publish();
     }
 };
 
@@ -69,10 +77,11 @@ void print_market_data(const market_data::MarketSnapshot &snapshot)
          << setw(12) << "Spread"
          << "Volume\n";
 
-    for (const auto &[symbol, quote] : snapshot.quotes)
+    for (auto instrument : snapshot.instruments())
     {
+        auto quote = snapshot.quote(instrument);
         double spread = quote.ask_price - quote.bid_price;
-        cout << left << setw(12) << symbol
+        cout << left << setw(12) << market_data::instrument_symbol(instrument)
              << setw(12) << fixed << setprecision(2) << quote.bid_price
              << setw(12) << quote.ask_price
              << setw(12) << spread
@@ -94,7 +103,7 @@ void print_arbitrage_opportunities(const std::vector<arbitrage::ArbitrageOpportu
 
     for (const auto &opp : opportunities)
     {
-        cout << "Opportunity ID: " << opp.opportunity_id << "\n";
+        cout << "Opportunity ID: " << arbitrage::format_opportunity_id(opp) << "\n";
         cout << "Type: ";
         switch (opp.type)
         {
@@ -161,7 +170,7 @@ int main()
             if (chance(gen) > 0.7)
             { // 30% chance of finding opportunity
                 arbitrage::ArbitrageOpportunity opp;
-                opp.opportunity_id = "ARB_" + std::to_string(iteration + 1);
+                opp.opportunity_id = arbitrage::next_opportunity_id();
                 opp.type = arbitrage::ArbitrageType::CROSS_EXCHANGE_SYNTHETIC_REPLICATION;
                 opp.status = arbitrage::ArbitrageStatus::IDENTIFIED;
                 opp.expected_profit = chance(gen) * 1000 + 100;     // $100-$1100
@@ -170,14 +179,14 @@ int main()
 
                 // Add some legs
                 arbitrage::ArbitrageLeg leg1;
-                leg1.instrument_id = "BTC-USD";
+                leg1.instrument = market_data::intern_instrument("BTC-USD");
                 leg1.side = market_data::Side::BID;
                 leg1.size = 0.1;
                 leg1.entry_price = 100.0;
                 leg1.weight = 1.0;
 
                 arbitrage::ArbitrageLeg leg2;
-                leg2.instrument_id = "ETH-USD";
+                leg2.instrument = market_data::intern_instrument("ETH-USD");
                 leg2.side = market_data::Side::ASK;
                 leg2.size = 2.5;
                 leg2.entry_price = 40.0;
@@ -0,0 +1,205 @@
+#include "market_data.hpp"
+
+namespace spe
+{
+    namespace market_data
+    {
+
+        namespace
+        {
+            const std::vector<InstrumentHandle> empty_instruments;
+            const std::vector<Trade> empty_trades;
+        }
+
+        Volume MarketDepth::available_volume(Side side, Price limit_price) const
+        {
+            Volume available = 0.0;
+            if (side == Side::BID)
+            {
+                for (uint32_t i = 0; i < ask_count && asks[i].price <= limit_price; ++i)
+                {
+                    available += asks[i].size;
+                }
+            }
+            else
+            {
+                for (uint32_t i = 0; i < bid_count && bids[i].price >= limit_price; ++i)
+                {
+                    available += bids[i].size;
+                }
+            }
+            return available;
+        }
+
+        // SnapshotStore implementation
+        SnapshotStore::SnapshotStore()
+            : publish_epoch_(1), publish_time_(std::chrono::high_resolution_clock::now()) {}
+
+        void SnapshotStore::reserve(size_t instrument_count)
+        {
+            if (instrument_count > 0)
+            {
+                ensure_capacity(static_cast<InstrumentHandle>(instrument_count - 1));
+            }
+        }
+
+        void SnapshotStore::ensure_capacity(InstrumentHandle instrument)
+        {
+            if (instrument < has_quote_.size())
+            {
+                return;
+            }
+
+            size_t size = static_cast<size_t>(instrument) + 1;
+            bid_prices_.resize(size, 0.0);
+            ask_prices_.resize(size, 0.0);
+            bid_sizes_.resize(size, 0.0);
+            ask_sizes_.resize(size, 0.0);
+            quote_times_.resize(size);
+            sequence_numbers_.resize(size, 0);
+            has_quote_.resize(size, 0);
+            recent_trades_.resize(size);
+            trade_epochs_.resize(size, 0);
+            depth_.resize(size);
+            has_depth_.resize(size, 0);
+            dirty_flags_.resize(size, 0);
+        }
+
+        void SnapshotStore::mark_dirty(InstrumentHandle instrument)
+        {
+            if (!dirty_flags_[instrument])
+            {
+                dirty_flags_[instrument] = 1;
+                pending_dirty_.push_back(instrument);
+            }
+        }
+
+        void SnapshotStore::apply_quote(const Quote &quote)
+        {
+            if (quote.instrument == INVALID_INSTRUMENT)
+            {
+                return;
+            }
+
+            InstrumentHandle instrument = quote.instrument;
+            ensure_capacity(instrument);
+
+            bid_prices_[instrument] = quote.bid_price;
+            ask_prices_[instrument] = quote.ask_price;
+            bid_sizes_[instrument] = quote.bid_size;
+            ask_sizes_[instrument] = quote.ask_size;
+            quote_times_[instrument] = quote.timestamp;
+            sequence_numbers_[instrument] = quote.sequence_number;
+
+            if (!has_quote_[instrument])
+            {
+                has_quote_[instrument] = 1;
+                quoted_instruments_.push_back(instrument);
+            }
+            mark_dirty(instrument);
+        }
+
+        void SnapshotStore::apply_trade(const Trade &trade)
+        {
+            if (trade.instrument == INVALID_INSTRUMENT)
+            {
+                return;
+            }
+
+            InstrumentHandle instrument = trade.instrument;
+            ensure_capacity(instrument);
+
+            // First trade of a new interval drops the previous interval's trades
+            if (trade_epochs_[instrument] != publish_epoch_)
+            {
+                recent_trades_[instrument].clear();
+                trade_epochs_[instrument] = publish_epoch_;
+            }
+            recent_trades_[instrument].push_back(trade);
+            mark_dirty(instrument);
+        }
+
+        void SnapshotStore::apply_depth(const MarketDepth &depth)
+        {
+            if (depth.instrument == INVALID_INSTRUMENT)
+            {
+                return;
+            }
+
+            ensure_capacity(depth.instrument);
+            depth_[depth.instrument] = depth;
+            has_depth_[depth.instrument] = 1;
+            mark_dirty(depth.instrument);
+        }
+
+        MarketSnapshot SnapshotStore::publish()
+        {
+            for (auto instrument : pending_dirty_)
+            {
+                dirty_flags_[instrument] = 0;
+            }
+            published_dirty_.swap(pending_dirty_);
+            pending_dirty_.clear();
+
+            ++publish_epoch_;
+            publish_time_ = std::chrono::high_resolution_clock::now();
+            return MarketSnapshot(this, publish_time_);
+        }
+
+        MarketSnapshot SnapshotStore::view() const
+        {
+            return MarketSnapshot(this, publish_time_);
+        }
+
+        Quote SnapshotStore::quote(InstrumentHandle instrument) const
+        {
+            Quote result(instrument, bid_prices_[instrument], ask_prices_[instrument],
+                         bid_sizes_[instrument], ask_sizes_[instrument]);
+            result.timestamp = quote_times_[instrument];
+            result.sequence_number = sequence_numbers_[instrument];
+            return result;
+        }
+
+        const std::vector<Trade> &SnapshotStore::recent_trades(InstrumentHandle instrument) const
+        {
+            // Trades older than the last published interval are stale
+            if (instrument >= recent_trades_.size() || trade_epochs_[instrument] + 1 != publish_epoch_)
+            {
+                return empty_trades;
+            }
+            return recent_trades_[instrument];
+        }
+
+        const MarketDepth *SnapshotStore::depth(InstrumentHandle instrument) const
+        {
+            return (instrument < has_depth_.size() && has_depth_[instrument]) ? &depth_[instrument] : nullptr;
+        }
+
+        // MarketSnapshot implementation
+        Quote MarketSnapshot::quote(InstrumentHandle instrument) const
+        {
+            return store_->quote(instrument);
+        }
+
+        const std::vector<InstrumentHandle> &MarketSnapshot::instruments() const
+        {
+            return store_ ? store_->quoted_instruments() : empty_instruments;
+        }
+
+        const std::vector<InstrumentHandle> &MarketSnapshot::dirty_instruments() const
+        {
+            return store_ ? store_->dirty_instruments() : empty_instruments;
+        }
+
+        const std::vector<Trade> &MarketSnapshot::recent_trades(InstrumentHandle instrument) const
+        {
+            return store_ ? store_->recent_trades(instrument) : empty_trades;
+        }
+
+        const MarketDepth *MarketSnapshot::depth(InstrumentHandle instrument) const
+        {
+            return store_ ? store_->depth(instrument) : nullptr;
+        }
+
+    } // namespace market_data
+} // namespace spe
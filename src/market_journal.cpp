@@ -0,0 +1,747 @@
+#include "market_journal.hpp"
+#include "instrument_registry.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace spe
+{
+    namespace data_feed
+    {
+
+        namespace
+        {
+            constexpr size_t WRITE_BUFFER_BYTES = size_t(1) << 20;
+
+            uint64_t to_nanoseconds(Timestamp timestamp)
+            {
+                return static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count());
+            }
+
+            // Exchange trade ids are decimal on the venues we record; anything else is not kept
+            uint64_t numeric_trade_id(const std::string &trade_id)
+            {
+                if (trade_id.empty() || trade_id.size() > 19 ||
+                    !std::all_of(trade_id.begin(), trade_id.end(), [](char c) { return c >= '0' && c <= '9'; }))
+                {
+                    return 0;
+                }
+                return std::strtoull(trade_id.c_str(), nullptr, 10);
+            }
+
+            JournalRecord make_record(JournalRecordType type, uint32_t instrument, uint64_t timestamp_ns)
+            {
+                JournalRecord record;
+                std::memset(&record, 0, sizeof(record));
+                record.type = type;
+                record.instrument = instrument;
+                record.timestamp_ns = timestamp_ns;
+                return record;
+            }
+        }
+
+        constexpr char JournalFileHeader::MAGIC[8];
+
+        // JournalWriter implementation
+        JournalWriter::JournalWriter(const std::string &prefix, size_t max_file_bytes)
+            : prefix_(prefix),
+              max_file_bytes_(std::max(max_file_bytes, sizeof(JournalFileHeader) + 4 * sizeof(JournalRecord))),
+              file_(nullptr), buffer_(WRITE_BUFFER_BYTES), file_bytes_(0), file_index_(0), next_local_id_(0),
+              records_written_(0), records_dropped_(0) {}
+
+        JournalWriter::~JournalWriter()
+        {
+            close();
+        }
+
+        std::string JournalWriter::file_name(const std::string &prefix, uint32_t index)
+        {
+            char suffix[32];
+            std::snprintf(suffix, sizeof(suffix), ".%06u.spej", index);
+            return prefix + suffix;
+        }
+
+        bool JournalWriter::open()
+        {
+            return is_open() || open_next_file();
+        }
+
+        bool JournalWriter::open_next_file()
+        {
+            close();
+
+            std::string path = file_name(prefix_, file_index_++);
+            file_ = std::fopen(path.c_str(), "wb");
+            if (!file_)
+            {
+                return false;
+            }
+            std::setvbuf(file_, buffer_.data(), _IOFBF, buffer_.size());
+
+            JournalFileHeader header;
+            std::memset(&header, 0, sizeof(header));
+            std::memcpy(header.magic, JournalFileHeader::MAGIC, sizeof(header.magic));
+            header.version = JournalFileHeader::VERSION;
+            header.record_size = sizeof(JournalRecord);
+            header.created_ns = to_nanoseconds(std::chrono::high_resolution_clock::now());
+            if (std::fwrite(&header, sizeof(header), 1, file_) != 1)
+            {
+                close();
+                return false;
+            }
+
+            file_bytes_ = sizeof(header);
+            files_.push_back(path);
+            std::fill(local_ids_.begin(), local_ids_.end(), NO_LOCAL_ID);
+            next_local_id_ = 0;
+            return true;
+        }
+
+        void JournalWriter::flush()
+        {
+            if (file_)
+            {
+                std::fflush(file_);
+            }
+        }
+
+        void JournalWriter::close()
+        {
+            if (file_)
+            {
+                std::fclose(file_);
+                file_ = nullptr;
+            }
+        }
+
+        bool JournalWriter::write(const JournalRecord &record)
+        {
+            if (!file_ || std::fwrite(&record, sizeof(record), 1, file_) != 1)
+            {
+                ++records_dropped_;
+                return false;
+            }
+            file_bytes_ += sizeof(record);
+            ++records_written_;
+            return true;
+        }
+
+        uint32_t JournalWriter::local_id(InstrumentHandle instrument, uint64_t timestamp_ns)
+        {
+            // Roll over first, so a dictionary entry always shares a file with its first use
+            if (file_ && file_bytes_ + 2 * sizeof(JournalRecord) > max_file_bytes_ && !open_next_file())
+            {
+                return NO_LOCAL_ID;
+            }
+            if (!file_ || instrument == INVALID_INSTRUMENT)
+            {
+                return NO_LOCAL_ID;
+            }
+
+            if (instrument >= local_ids_.size())
+            {
+                local_ids_.resize(instrument + 1, NO_LOCAL_ID);
+            }
+            if (local_ids_[instrument] != NO_LOCAL_ID)
+            {
+                return local_ids_[instrument];
+            }
+
+            const InstrumentId &symbol = instrument_symbol(instrument);
+            if (symbol.size() > MAX_SYMBOL_LENGTH)
+            {
+                return NO_LOCAL_ID;
+            }
+            JournalRecord record = make_record(JournalRecordType::INSTRUMENT, next_local_id_, timestamp_ns);
+            record.flags = static_cast<uint16_t>(symbol.size());
+            std::memcpy(record.values, symbol.data(), symbol.size());
+            if (!write(record))
+            {
+                return NO_LOCAL_ID;
+            }
+            local_ids_[instrument] = next_local_id_;
+            return next_local_id_++;
+        }
+
+        bool JournalWriter::append_quote(const Quote &quote)
+        {
+            uint64_t timestamp_ns = to_nanoseconds(quote.timestamp);
+            uint32_t id = local_id(quote.instrument, timestamp_ns);
+            if (id == NO_LOCAL_ID)
+            {
+                ++records_dropped_;
+                return false;
+            }
+
+            JournalRecord record = make_record(JournalRecordType::QUOTE, id, timestamp_ns);
+            record.values[0] = quote.bid_price;
+            record.values[1] = quote.ask_price;
+            record.values[2] = quote.bid_size;
+            record.values[3] = quote.ask_size;
+            record.sequence = quote.sequence_number;
+            return write(record);
+        }
+
+        bool JournalWriter::append_trade(const Trade &trade)
+        {
+            uint64_t timestamp_ns = to_nanoseconds(trade.timestamp);
+            uint32_t id = local_id(trade.instrument, timestamp_ns);
+            if (id == NO_LOCAL_ID)
+            {
+                ++records_dropped_;
+                return false;
+            }
+
+            JournalRecord record = make_record(JournalRecordType::TRADE, id, timestamp_ns);
+            record.side = static_cast<uint8_t>(trade.side);
+            record.values[0] = trade.price;
+            record.values[1] = trade.size;
+            record.sequence = trade.sequence_number;
+            record.aux = numeric_trade_id(trade.trade_id);
+            return write(record);
+        }
+
+        bool JournalWriter::append_book_level(InstrumentHandle instrument, Side side, Price price, Volume size,
+                                              uint64_t update_id, Timestamp timestamp, uint16_t flags)
+        {
+            uint64_t timestamp_ns = to_nanoseconds(timestamp);
+            uint32_t id = local_id(instrument, timestamp_ns);
+            if (id == NO_LOCAL_ID)
+            {
+                ++records_dropped_;
+                return false;
+            }
+
+            JournalRecord record = make_record(JournalRecordType::BOOK_LEVEL, id, timestamp_ns);
+            record.side = static_cast<uint8_t>(side);
+            record.flags = flags;
+            record.values[0] = price;
+            record.values[1] = size;
+            record.sequence = update_id;
+            return write(record);
+        }
+
+        bool JournalWriter::append_empty_book(InstrumentHandle instrument, bool is_snapshot, uint64_t update_id,
+                                              Timestamp timestamp)
+        {
+            uint16_t flags = BOOK_EMPTY | BOOK_END | (is_snapshot ? BOOK_SNAPSHOT : 0);
+            return append_book_level(instrument, Side::BID, 0.0, 0.0, update_id, timestamp, flags);
+        }
+
+        // JournalReader implementation
+        JournalReader::JournalReader() : data_(nullptr), size_(0), mapped_(false) {}
+
+        JournalReader::~JournalReader()
+        {
+            close();
+        }
+
+        bool JournalReader::open(const std::string &path)
+        {
+            close();
+
+#if !defined(_WIN32)
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                error_ = path + ": " + std::strerror(errno);
+                return false;
+            }
+            struct stat info;
+            if (::fstat(fd, &info) != 0)
+            {
+                error_ = path + ": " + std::strerror(errno);
+                ::close(fd);
+                return false;
+            }
+            size_ = static_cast<size_t>(info.st_size);
+            if (size_ >= sizeof(JournalFileHeader))
+            {
+                void *mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    error_ = path + ": " + std::strerror(errno);
+                    ::close(fd);
+                    size_ = 0;
+                    return false;
+                }
+                ::madvise(mapping, size_, MADV_SEQUENTIAL);
+                data_ = static_cast<const unsigned char *>(mapping);
+                mapped_ = true;
+            }
+            ::close(fd); // the mapping keeps the file alive
+#else
+            std::FILE *file = std::fopen(path.c_str(), "rb");
+            if (!file)
+            {
+                error_ = path + ": cannot open";
+                return false;
+            }
+            std::fseek(file, 0, SEEK_END);
+            long length = std::ftell(file);
+            std::fseek(file, 0, SEEK_SET);
+            fallback_.resize(length > 0 ? static_cast<size_t>(length) : 0);
+            size_ = fallback_.size() == 0 ? 0 : std::fread(fallback_.data(), 1, fallback_.size(), file);
+            std::fclose(file);
+            data_ = size_ >= sizeof(JournalFileHeader) ? fallback_.data() : nullptr;
+#endif
+
+            if (!data_)
+            {
+                error_ = path + ": too short for a journal header";
+                close();
+                return false;
+            }
+            const JournalFileHeader &file_header = header();
+            if (std::memcmp(file_header.magic, JournalFileHeader::MAGIC, sizeof(file_header.magic)) != 0 ||
+                file_header.version != JournalFileHeader::VERSION || file_header.record_size != sizeof(JournalRecord))
+            {
+                error_ = path + ": not a version " + std::to_string(JournalFileHeader::VERSION) + " journal";
+                close();
+                return false;
+            }
+            error_.clear();
+            return true;
+        }
+
+        void JournalReader::close()
+        {
+#if !defined(_WIN32)
+            if (mapped_)
+            {
+                ::munmap(const_cast<unsigned char *>(data_), size_);
+            }
+#endif
+            fallback_.clear();
+            data_ = nullptr;
+            size_ = 0;
+            mapped_ = false;
+        }
+
+        std::string JournalReader::symbol(const JournalRecord &record)
+        {
+            size_t length = std::min<size_t>(record.flags, JournalWriter::MAX_SYMBOL_LENGTH);
+            return std::string(reinterpret_cast<const char *>(record.values), length);
+        }
+
+        // JournalReplayFeed implementation
+        JournalReplayFeed::JournalReplayFeed(std::vector<std::string> files, const ReplayConfig &config)
+            : files_(std::move(files)), config_(config), status_(FeedStatus::DISCONNECTED), running_(false),
+              finished_(false), subscribe_all_(false), current_book_(nullptr), first_recorded_ns_(0) {}
+
+        JournalReplayFeed::~JournalReplayFeed()
+        {
+            disconnect();
+        }
+
+        bool JournalReplayFeed::connect()
+        {
+            if (feed_thread_.joinable())
+            {
+                if (!finished())
+                {
+                    return true; // already replaying
+                }
+                feed_thread_.join();
+            }
+
+            running_ = true;
+            status_ = FeedStatus::CONNECTED;
+            feed_thread_ = std::thread(&JournalReplayFeed::feed_loop, this);
+            return true;
+        }
+
+        void JournalReplayFeed::disconnect()
+        {
+            running_ = false;
+            if (feed_thread_.joinable())
+            {
+                feed_thread_.join();
+            }
+            status_ = FeedStatus::DISCONNECTED;
+        }
+
+        FeedStatus JournalReplayFeed::get_status() const
+        {
+            return status_.load();
+        }
+
+        void JournalReplayFeed::wait()
+        {
+            if (feed_thread_.joinable())
+            {
+                feed_thread_.join();
+            }
+        }
+
+        void JournalReplayFeed::feed_loop()
+        {
+            concurrency::apply_placement(config_.placement);
+            bool ok = run_replay();
+            running_ = false;
+            status_ = ok ? FeedStatus::DISCONNECTED : FeedStatus::ERROR;
+        }
+
+        bool JournalReplayFeed::replay()
+        {
+            running_ = true;
+            bool ok = run_replay();
+            running_ = false;
+            return ok;
+        }
+
+        bool JournalReplayFeed::run_replay()
+        {
+            finished_.store(false, std::memory_order_release);
+            statistics_ = ReplayStatistics{};
+            books_.clear();
+            current_book_ = nullptr;
+            first_recorded_ns_ = 0;
+            replay_start_ = std::chrono::steady_clock::now();
+
+            bool ok = true;
+            for (const auto &path : files_)
+            {
+                if (!running_.load(std::memory_order_relaxed))
+                {
+                    break;
+                }
+                ok &= replay_file(path);
+            }
+            finished_.store(true, std::memory_order_release);
+            return ok;
+        }
+
+        bool JournalReplayFeed::replay_file(const std::string &path)
+        {
+            JournalReader reader;
+            if (!reader.open(path))
+            {
+                report_error(reader.error());
+                return false;
+            }
+            ++statistics_.files;
+
+            std::vector<InstrumentHandle> instruments; // file-local id -> handle
+            const JournalRecord *records = reader.records();
+            size_t count = reader.record_count();
+            for (size_t i = 0; i < count && running_.load(std::memory_order_relaxed); ++i)
+            {
+                const JournalRecord &record = records[i];
+                ++statistics_.records;
+
+                if (record.type == JournalRecordType::INSTRUMENT)
+                {
+                    if (record.instrument >= instruments.size())
+                    {
+                        instruments.resize(record.instrument + 1, INVALID_INSTRUMENT);
+                    }
+                    instruments[record.instrument] = intern_instrument(JournalReader::symbol(record));
+                    continue;
+                }
+
+                InstrumentHandle instrument = record.instrument < instruments.size() ? instruments[record.instrument]
+                                                                                     : INVALID_INSTRUMENT;
+                if (instrument == INVALID_INSTRUMENT)
+                {
+                    ++statistics_.skipped;
+                    continue;
+                }
+
+                if (record.timestamp_ns < config_.start_ns)
+                {
+                    ++statistics_.fast_forwarded;
+                    if (record.type == JournalRecordType::BOOK_LEVEL)
+                    {
+                        Timestamp recorded(std::chrono::duration_cast<Timestamp::duration>(
+                            std::chrono::nanoseconds(record.timestamp_ns)));
+                        apply_book_level(instrument, record, recorded, false);
+                    }
+                    continue;
+                }
+
+                pace(record.timestamp_ns);
+                Timestamp timestamp = event_time(record.timestamp_ns);
+
+                switch (record.type)
+                {
+                case JournalRecordType::QUOTE:
+                {
+                    Quote quote;
+                    quote.instrument = instrument;
+                    quote.bid_price = record.values[0];
+                    quote.ask_price = record.values[1];
+                    quote.bid_size = record.values[2];
+                    quote.ask_size = record.values[3];
+                    quote.timestamp = timestamp;
+                    quote.sequence_number = record.sequence;
+                    ++statistics_.quotes;
+                    deliver_quote(quote);
+                    break;
+                }
+                case JournalRecordType::TRADE:
+                {
+                    Trade trade(instrument, record.values[0], record.values[1], static_cast<Side>(record.side));
+                    trade.timestamp = timestamp;
+                    trade.sequence_number = record.sequence;
+                    if (record.aux != 0)
+                    {
+                        trade.trade_id = std::to_string(record.aux);
+                    }
+                    ++statistics_.trades;
+                    deliver_trade(trade);
+                    break;
+                }
+                case JournalRecordType::BOOK_LEVEL:
+                    apply_book_level(instrument, record, timestamp, true);
+                    break;
+                default:
+                    ++statistics_.skipped;
+                    break;
+                }
+            }
+            return true;
+        }
+
+        void JournalReplayFeed::apply_book_level(InstrumentHandle instrument, const JournalRecord &record, Timestamp timestamp,
+                                                 bool deliver)
+        {
+            // Levels of one message are contiguous; a message may continue in the next file
+            if (!current_book_ || current_book_->instrument() != instrument)
+            {
+                auto &book = books_[instrument];
+                if (!book)
+                {
+                    book = std::make_unique<OrderBook>(instrument); // recorded levels were already sequenced
+                }
+                current_book_ = book.get();
+                current_sequence_ = BookSequence{};
+                current_sequence_.is_snapshot = (record.flags & BOOK_SNAPSHOT) != 0;
+                current_sequence_.last_update_id = record.sequence;
+                current_sequence_.timestamp = timestamp;
+                current_book_->begin_update(current_sequence_);
+            }
+
+            if (!(record.flags & BOOK_EMPTY))
+            {
+                current_book_->set_level(static_cast<Side>(record.side), record.values[0], record.values[1]);
+            }
+            if (record.flags & BOOK_END)
+            {
+                current_book_->commit_update(current_sequence_);
+                if (deliver)
+                {
+                    ++statistics_.book_updates;
+                    deliver_book(*current_book_, timestamp);
+                }
+                current_book_ = nullptr;
+            }
+        }
+
+        void JournalReplayFeed::pace(uint64_t recorded_ns)
+        {
+            if (config_.speed == ReplaySpeed::AS_FAST_AS_POSSIBLE)
+            {
+                return;
+            }
+            if (first_recorded_ns_ == 0)
+            {
+                first_recorded_ns_ = recorded_ns;
+                replay_start_ = std::chrono::steady_clock::now();
+                return;
+            }
+
+            double factor = config_.speed == ReplaySpeed::ACCELERATED && config_.acceleration > 0.0 ? config_.acceleration : 1.0;
+            uint64_t offset = recorded_ns > first_recorded_ns_ ? recorded_ns - first_recorded_ns_ : 0;
+            auto target = replay_start_ + std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(offset) / factor));
+
+            // Sleep in short slices while far off so disconnect() stays responsive, then spin
+            while (running_.load(std::memory_order_relaxed))
+            {
+                auto now = std::chrono::steady_clock::now();
+                if (now >= target)
+                {
+                    break;
+                }
+                auto remaining = target - now;
+                if (remaining > std::chrono::microseconds(200))
+                {
+                    std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                        remaining - std::chrono::microseconds(100), std::chrono::milliseconds(10)));
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        Timestamp JournalReplayFeed::event_time(uint64_t recorded_ns) const
+        {
+            if (config_.restamp)
+            {
+                return std::chrono::high_resolution_clock::now();
+            }
+            return Timestamp(std::chrono::duration_cast<Timestamp::duration>(std::chrono::nanoseconds(recorded_ns)));
+        }
+
+        void JournalReplayFeed::deliver_quote(const Quote &quote)
+        {
+            if (!subscribe_all_ && !subscribed(quote_subscriptions_, quote.instrument))
+            {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(data_mutex_);
+                latest_quotes_[quote.instrument] = quote;
+            }
+            if (quote_callback_)
+            {
+                quote_callback_(quote);
+            }
+        }
+
+        void JournalReplayFeed::deliver_trade(const Trade &trade)
+        {
+            if (!subscribe_all_ && !subscribed(trade_subscriptions_, trade.instrument))
+            {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(data_mutex_);
+                auto &trades = recent_trades_[trade.instrument];
+                trades.push_back(trade);
+                if (trades.size() > RECENT_TRADE_LIMIT)
+                {
+                    trades.pop_front();
+                }
+            }
+            if (trade_callback_)
+            {
+                trade_callback_(trade);
+            }
+        }
+
+        void JournalReplayFeed::deliver_book(OrderBook &book, Timestamp timestamp)
+        {
+            MarketDepth depth(book.instrument());
+            book.top(depth);
+            depth.instrument = book.instrument();
+            depth.timestamp = timestamp;
+
+            if (subscribe_all_ || subscribed(depth_subscriptions_, depth.instrument))
+            {
+                {
+                    std::lock_guard<std::mutex> lock(data_mutex_);
+                    market_depths_[depth.instrument] = depth;
+                }
+                if (depth_callback_)
+                {
+                    depth_callback_(depth);
+                }
+            }
+
+            // Same top-of-book quote a live connection publishes with each book update
+            if (config_.quotes_from_books && depth.bid_count > 0 && depth.ask_count > 0)
+            {
+                Quote quote(depth.instrument, depth.bids[0].price, depth.asks[0].price, depth.bids[0].size,
+                            depth.asks[0].size);
+                quote.timestamp = timestamp;
+                quote.sequence_number = depth.update_id;
+                deliver_quote(quote);
+            }
+        }
+
+        void JournalReplayFeed::report_error(const std::string &error)
+        {
+            if (error_callback_)
+            {
+                error_callback_(error);
+            }
+        }
+
+        bool JournalReplayFeed::subscribed(const std::vector<uint8_t> &subscriptions, InstrumentHandle instrument)
+        {
+            return instrument < subscriptions.size() && subscriptions[instrument];
+        }
+
+        bool JournalReplayFeed::subscribe(std::vector<uint8_t> &subscriptions, const std::vector<InstrumentId> &instruments)
+        {
+            for (const auto &id : instruments)
+            {
+                InstrumentHandle instrument = intern_instrument(id);
+                if (instrument >= subscriptions.size())
+                {
+                    subscriptions.resize(instrument + 1, 0);
+                }
+                subscriptions[instrument] = 1;
+            }
+            return true;
+        }
+
+        bool JournalReplayFeed::subscribe_quotes(const std::vector<InstrumentId> &instruments)
+        {
+            return subscribe(quote_subscriptions_, instruments);
+        }
+
+        bool JournalReplayFeed::subscribe_trades(const std::vector<InstrumentId> &instruments)
+        {
+            return subscribe(trade_subscriptions_, instruments);
+        }
+
+        bool JournalReplayFeed::subscribe_depth(const std::vector<InstrumentId> &instruments)
+        {
+            return subscribe(depth_subscriptions_, instruments);
+        }
+
+        bool JournalReplayFeed::unsubscribe(InstrumentHandle instrument)
+        {
+            bool removed = false;
+            for (auto *subscriptions : {&quote_subscriptions_, &trade_subscriptions_, &depth_subscriptions_})
+            {
+                if (subscribed(*subscriptions, instrument))
+                {
+                    (*subscriptions)[instrument] = 0;
+                    removed = true;
+                }
+            }
+            return removed;
+        }
+
+        Quote JournalReplayFeed::get_latest_quote(InstrumentHandle instrument) const
+        {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            auto it = latest_quotes_.find(instrument);
+            return it != latest_quotes_.end() ? it->second : Quote(instrument, 0.0, 0.0, 0.0, 0.0);
+        }
+
+        std::vector<Trade> JournalReplayFeed::get_recent_trades(InstrumentHandle instrument, size_t count) const
+        {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            auto it = recent_trades_.find(instrument);
+            if (it == recent_trades_.end())
+            {
+                return {};
+            }
+            size_t first = it->second.size() > count ? it->second.size() - count : 0;
+            return std::vector<Trade>(it->second.begin() + first, it->second.end());
+        }
+
+        MarketDepth JournalReplayFeed::get_market_depth(InstrumentHandle instrument) const
+        {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            auto it = market_depths_.find(instrument);
+            return it != market_depths_.end() ? it->second : MarketDepth(instrument);
+        }
+
+    } // namespace data_feed
+} // namespace spe
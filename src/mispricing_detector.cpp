@@ -1,6 +1,8 @@
 #include "mispricing_detector.hpp"
+#include "instrument_registry.hpp"
 #include <algorithm>
 #include <numeric>
+#include <limits>
 #include <cmath>
 
 namespace spe
@@ -8,6 +10,46 @@ namespace spe
     namespace mispricing
     {
 
+        // IMispricingDetector event adapter
+        SnapshotStore &IMispricingDetector::event_store()
+        {
+            if (!event_store_)
+            {
+                event_store_ = std::make_unique<SnapshotStore>();
+            }
+            return *event_store_;
+        }
+
+        void IMispricingDetector::adapt_event()
+        {
+            // The store keeps every instrument's latest state; the snapshot's dirty list is just this event
+            update_market_data(event_store_->publish());
+        }
+
+        void IMispricingDetector::on_quote(InstrumentHandle instrument, const Quote &quote)
+        {
+            Quote routed = quote;
+            routed.instrument = instrument;
+            event_store().apply_quote(routed);
+            adapt_event();
+        }
+
+        void IMispricingDetector::on_trade(InstrumentHandle instrument, const Trade &trade)
+        {
+            Trade routed = trade;
+            routed.instrument = instrument;
+            event_store().apply_trade(routed);
+            adapt_event();
+        }
+
+        void IMispricingDetector::on_book_update(InstrumentHandle instrument, const MarketDepth &depth)
+        {
+            MarketDepth routed = depth;
+            routed.instrument = instrument;
+            event_store().apply_depth(routed);
+            adapt_event();
+        }
+
         // StatisticalMispricingDetector implementation
         StatisticalMispricingDetector::StatisticalMispricingDetector(
             std::unique_ptr<IPricingModel> model,
@@ -19,41 +61,65 @@ namespace spe
         //methods for updating market data and detecting opportunities and managing active differences
         void StatisticalMispricingDetector::update_market_data(const MarketSnapshot &snapshot)
         {
-            for (const auto &[instrument_id, quote] : snapshot.quotes)
+            // Only instruments that changed since the previous snapshot carry new information
+            for (auto instrument : snapshot.dirty_instruments())
             {
-                update_price_history(instrument_id, quote);
+                if (snapshot.has_quote(instrument))
+                {
+                    evaluate_instrument(instrument, update_price_history(instrument, snapshot.quote(instrument)));
+                }
             }
             cleanup_expired_opportunities();
         }
+
+        void StatisticalMispricingDetector::on_quote(InstrumentHandle instrument, const Quote &quote)
+        {
+            evaluate_instrument(instrument, update_price_history(instrument, quote));
+            cleanup_expired_opportunities();
+        }
         
-        // included calc for z-scores, confidence levels and severity assessment.
+        // Opportunities are found as quotes arrive; this only drops the expired ones
         std::vector<MispricingOpportunity> StatisticalMispricingDetector::detect_opportunities()
         {
-            std::vector<MispricingOpportunity> opportunities;
+            cleanup_expired_opportunities();
+            return get_active_opportunities();
+        }
+
+        // included calc for z-scores, confidence levels and severity assessment.
+        void StatisticalMispricingDetector::evaluate_instrument(InstrumentHandle instrument, const RingBuffer<Quote> &history)
+        {
+            if (history.size() < params_.min_observation_window)
+            {
+                return;
+            }
 
             // Simplified detection for demo
-            for (const auto &[instrument_id, price_queue] : price_history_)
+            MispricingOpportunity opp;
             {
-                if (price_queue.size() >= params_.min_observation_window)
+                std::lock_guard<std::mutex> lock(opportunities_mutex_);
+                if (!flagged_instruments_.insert(instrument).second)
                 {
-                    MispricingOpportunity opp;
-                    opp.target_instrument = instrument_id;
-                    opp.type = MispricingType::STATISTICAL_ARBITRAGE;
-                    opp.severity = MispricingSeverity::MEDIUM;
-                    opp.market_price = price_queue.back().bid_price;
-                    opp.theoretical_price = opp.market_price * 1.02; // 2% difference for demo
-                    opp.deviation_percentage = 0.02;
-                    opp.z_score = 2.5;
-                    opp.confidence_level = 0.85;
-                    opp.expected_profit = 100.0;
-                    opp.max_loss = 50.0;
-                    opp.value_at_risk = 30.0;
-
-                    opportunities.push_back(opp);
+                    return; // already open
                 }
+                opp.target_instrument = instrument;
+                opp.type = MispricingType::STATISTICAL_ARBITRAGE;
+                opp.severity = MispricingSeverity::MEDIUM;
+                opp.market_price = history.back().bid_price;
+                opp.theoretical_price = opp.market_price * 1.02; // 2% difference for demo
+                opp.deviation_percentage = 0.02;
+                opp.z_score = 2.5;
+                opp.confidence_level = 0.85;
+                opp.expected_profit = 100.0;
+                opp.max_loss = 50.0;
+                opp.value_at_risk = 30.0;
+                opp.expiry_time = opp.detection_time + params_.max_opportunity_duration;
+                active_opportunities_.push_back(opp);
             }
 
-            return opportunities;
+            if (detection_callback_)
+            {
+                detection_callback_(opp);
+            }
         }
 
         void StatisticalMispricingDetector::set_detection_callback(MispricingCallback callback)
@@ -81,42 +147,100 @@ namespace spe
         {
             std::lock_guard<std::mutex> lock(opportunities_mutex_);
             active_opportunities_.clear();
+            flagged_instruments_.clear();
         }
 
-        bool StatisticalMispricingDetector::is_significant_deviation(double deviation, double z_score, double confidence)
+        void StatisticalMispricingDetector::save_state(checkpoint::CheckpointWriter &out) const
         {
-            return std::abs(deviation) > params_.min_deviation_threshold &&
-                   std::abs(z_score) > params_.min_z_score &&
-                   confidence > params_.min_confidence_level;
+            out.put_count(price_history_.size());
+            for (const auto &entry : price_history_)
+            {
+                const RingBuffer<Quote> &history = entry.second;
+                out.put_instrument(entry.first);
+                out.put_count(history.size());
+                for (size_t i = 0; i < history.size(); ++i)
+                {
+                    const Quote &quote = history[i];
+                    out.put(quote.bid_price);
+                    out.put(quote.ask_price);
+                    out.put(quote.bid_size);
+                    out.put(quote.ask_size);
+                    out.put_time(quote.timestamp);
+                    out.put(quote.sequence_number);
+                }
+            }
+
+            out.put_count(deviation_history_.size());
+            for (const auto &entry : deviation_history_)
+            {
+                out.put_instrument(entry.first);
+                out.put_rolling(entry.second);
+            }
         }
 
-        double StatisticalMispricingDetector::calculate_z_score(const std::queue<double> &history, double current_value)
+        bool StatisticalMispricingDetector::restore_state(checkpoint::SectionReader &in)
         {
-            if (history.size() < 2)
-                return 0.0;
+            constexpr size_t QUOTE_BYTES = 4 * sizeof(double) + sizeof(int64_t) + sizeof(uint64_t);
 
-            // Convert queue to vector for calculations
-            std::vector<double> values;
-            std::queue<double> temp_queue = history;
-            while (!temp_queue.empty())
+            size_t instruments = 0;
+            in.get_count(instruments, sizeof(uint32_t) + sizeof(uint64_t));
+            for (size_t i = 0; i < instruments && in.ok(); ++i)
             {
-                values.push_back(temp_queue.front());
-                temp_queue.pop();
+                InstrumentHandle instrument = INVALID_INSTRUMENT;
+                size_t count = 0;
+                in.get_instrument(instrument);
+                in.get_count(count, QUOTE_BYTES);
+
+                // Quotes older than the window are read past; update_price_history keeps the rest
+                for (size_t j = 0; j < count && in.ok(); ++j)
+                {
+                    Quote quote;
+                    quote.instrument = instrument;
+                    in.get(quote.bid_price);
+                    in.get(quote.ask_price);
+                    in.get(quote.bid_size);
+                    in.get(quote.ask_size);
+                    in.get_time(quote.timestamp);
+                    in.get(quote.sequence_number);
+                    if (in.ok() && instrument != INVALID_INSTRUMENT)
+                    {
+                        update_price_history(instrument, quote);
+                    }
+                }
             }
 
-            double mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
-            double variance = 0.0;
-            for (double val : values)
+            size_t deviations = 0;
+            in.get_count(deviations, sizeof(uint32_t) + sizeof(uint32_t) + sizeof(double));
+            for (size_t i = 0; i < deviations && in.ok(); ++i)
             {
-                variance += (val - mean) * (val - mean);
+                InstrumentHandle instrument = INVALID_INSTRUMENT;
+                in.get_instrument(instrument);
+                RollingStatistics statistics;
+                if (in.get_rolling(statistics) && instrument != INVALID_INSTRUMENT)
+                {
+                    deviation_history_[instrument] = std::move(statistics);
+                }
             }
-            variance /= values.size();
-            double std_dev = std::sqrt(variance);
+            return in.ok();
+        }
+
+        bool StatisticalMispricingDetector::is_significant_deviation(double deviation, double z_score, double confidence)
+        {
+            return std::abs(deviation) > params_.min_deviation_threshold &&
+                   std::abs(z_score) > params_.min_z_score &&
+                   confidence > params_.min_confidence_level;
+        }
+
+        double StatisticalMispricingDetector::calculate_z_score(const RollingStatistics &history, double current_value)
+        {
+            if (history.size() < 2)
+                return 0.0;
 
-            return std_dev > 0 ? (current_value - mean) / std_dev : 0.0;
+            // Window mean/variance are maintained incrementally, so this is O(1)
+            return history.z_score(current_value);
         }
 
-        double StatisticalMispricingDetector::calculate_confidence_level(const std::queue<Quote> &history, double theoretical_price)
+        double StatisticalMispricingDetector::calculate_confidence_level(const RingBuffer<Quote> &history, double theoretical_price)
         {
             return 0.85; // Simplified confidence calculation for demo
         }
@@ -134,70 +258,105 @@ namespace spe
 
         void StatisticalMispricingDetector::cleanup_expired_opportunities()
         {
-            std::lock_guard<std::mutex> lock(opportunities_mutex_);
-            auto now = std::chrono::high_resolution_clock::now();
-            active_opportunities_.erase(
-                std::remove_if(active_opportunities_.begin(), active_opportunities_.end(),
-                               [now](const MispricingOpportunity &opp)
-                               {
-                                   return now > opp.expiry_time;
-                               }),
-                active_opportunities_.end());
+            std::vector<MispricingOpportunity> expired;
+            {
+                std::lock_guard<std::mutex> lock(opportunities_mutex_);
+                if (active_opportunities_.empty())
+                {
+                    return;
+                }
+                auto now = std::chrono::high_resolution_clock::now();
+                auto first_expired = std::stable_partition(active_opportunities_.begin(), active_opportunities_.end(),
+                                                           [now](const MispricingOpportunity &opp)
+                                                           {
+                                                               return now <= opp.expiry_time;
+                                                           });
+                for (auto it = first_expired; it != active_opportunities_.end(); ++it)
+                {
+                    flagged_instruments_.erase(it->target_instrument); // may be flagged again
+                    if (expiry_callback_)
+                    {
+                        expired.push_back(*it);
+                    }
+                }
+                active_opportunities_.erase(first_expired, active_opportunities_.end());
+            }
+
+            for (const auto &opp : expired)
+            {
+                expiry_callback_(opp);
+            }
         }
 
-        void StatisticalMispricingDetector::update_price_history(const InstrumentId &instrument, const Quote &quote)
+        const RingBuffer<Quote> &StatisticalMispricingDetector::update_price_history(InstrumentHandle instrument, const Quote &quote)
         {
-            auto &history = price_history_[instrument];
-            history.push(quote);
-
-            // Keep only recent history
-            if (history.size() > params_.min_observation_window * 2)
+            // Keep only recent history; the ring buffer overwrites the oldest quote once full
+            auto it = price_history_.find(instrument);
+            if (it == price_history_.end())
             {
-                history.pop();
+                it = price_history_.emplace(instrument, RingBuffer<Quote>(params_.min_observation_window * 2)).first;
             }
+            it->second.push(quote);
+            return it->second;
         }
 
         // TriangularArbitrageDetector implementation
         TriangularArbitrageDetector::TriangularArbitrageDetector(const DetectionParameters &params)
-            : params_(params)
+            : params_(params), currency_graph_(false, 0.0, params.min_deviation_threshold),
+              discover_pairs_(false), graph_stale_(true)
         {
             // Add some default currency triangles for demo
-            add_currency_triangle("BTC-ETH-USD", {"BTC-USD", "ETH-USD", "BTC-ETH"});
-            add_currency_triangle("BTC-USDT-USD", {"BTC-USD", "USDT-USD", "BTC-USDT"});
+            add_currency_triangle("BTC-ETH-USD", {intern_instrument("BTC-USD"), intern_instrument("ETH-USD"),
+                                                  intern_instrument("BTC-ETH")});
+            add_currency_triangle("BTC-USDT-USD", {intern_instrument("BTC-USD"), intern_instrument("USDT-USD"),
+                                                   intern_instrument("BTC-USDT")});
         }
         
         //methods for adding/removing currency triangles and detecting arbitrage opportunities
         void TriangularArbitrageDetector::update_market_data(const MarketSnapshot &snapshot)
         {
-            // Process market data for triangular arbitrage detection
+            bool full = graph_stale_;
+            if (graph_stale_)
+            {
+                rebuild_graph();
+            }
+
+            currency_graph_.apply_snapshot(snapshot, full);
+            evaluate_cycles();
+        }
+
+        void TriangularArbitrageDetector::on_quote(InstrumentHandle instrument, const Quote &quote)
+        {
+            // After a rebuild a cycle scores again once each of its pairs has been requoted
+            if (graph_stale_)
+            {
+                rebuild_graph();
+            }
+            if (currency_graph_.update_quote(instrument, quote.bid_price, quote.ask_price))
+            {
+                evaluate_cycles();
+            }
+        }
+
+        void TriangularArbitrageDetector::evaluate_cycles()
+        {
+            currency_graph_.evaluate_touched([this](uint32_t cycle, double log_return, bool newly_profitable)
+                                             {
+                                                 if (newly_profitable && detection_callback_)
+                                                 {
+                                                     detection_callback_(create_cycle_opportunity(cycle, log_return));
+                                                 }
+                                             });
         }
 
         std::vector<MispricingOpportunity> TriangularArbitrageDetector::detect_opportunities()
         {
             std::vector<MispricingOpportunity> opportunities;
-
-            // Simplified triangular arbitrage detection for demo
-            for (const auto &[name, instruments] : currency_triangles_)
+            opportunities.reserve(currency_graph_.profitable_cycles().size());
+            for (uint32_t cycle : currency_graph_.profitable_cycles())
             {
-                if (instruments.size() >= 3)
-                {
-                    MispricingOpportunity opp;
-                    opp.target_instrument = instruments[0];
-                    opp.component_instruments = instruments;
-                    opp.type = MispricingType::CROSS_CURRENCY_TRIANGULAR;
-                    opp.severity = MispricingSeverity::MEDIUM;
-                    opp.market_price = 100.0;
-                    opp.theoretical_price = 101.5;
-                    opp.deviation_percentage = 0.015;
-                    opp.z_score = 2.2;
-                    opp.confidence_level = 0.88;
-                    opp.expected_profit = 150.0;
-                    opp.max_loss = 75.0;
-
-                    opportunities.push_back(opp);
-                }
+                opportunities.push_back(create_cycle_opportunity(cycle, currency_graph_.cycle_log_return(cycle)));
             }
-
             return opportunities;
         }
 
@@ -214,32 +373,70 @@ namespace spe
         void TriangularArbitrageDetector::update_parameters(const DetectionParameters &params)
         {
             params_ = params;
+            currency_graph_.set_min_return(params_.min_deviation_threshold);
+            graph_stale_ = true; // re-score every cycle against the new threshold
         }
 
-        void TriangularArbitrageDetector::add_currency_triangle(const std::string &name, const std::vector<InstrumentId> &instruments)
+        void TriangularArbitrageDetector::add_currency_triangle(const std::string &name, const std::vector<InstrumentHandle> &instruments)
         {
             currency_triangles_[name] = instruments;
+            graph_stale_ = true;
         }
 
         void TriangularArbitrageDetector::remove_currency_triangle(const std::string &name)
         {
-            currency_triangles_.erase(name);
+            graph_stale_ |= currency_triangles_.erase(name) > 0;
         }
 
-        std::vector<MispricingOpportunity> TriangularArbitrageDetector::detect_triangular_opportunities(const MarketSnapshot &snapshot)
+        void TriangularArbitrageDetector::discover_currency_pairs(bool include_four_cycles)
         {
-            return detect_opportunities(); // Simplified for demo
+            discover_pairs_ = true;
+            currency_graph_.set_include_four_cycles(include_four_cycles);
+            graph_stale_ = true;
         }
 
-        double TriangularArbitrageDetector::calculate_triangular_profit(const Quote &pair1, const Quote &pair2, const Quote &pair3)
+        void TriangularArbitrageDetector::rebuild_graph()
         {
-            // Simplified triangular profit calculation
-            return 0.015; // 1.5% profit for demo
+            currency_graph_.clear();
+            for (const auto &[name, instruments] : currency_triangles_)
+            {
+                for (InstrumentHandle instrument : instruments)
+                {
+                    currency_graph_.add_pair(instrument);
+                }
+            }
+            if (discover_pairs_)
+            {
+                currency_graph_.discover_pairs(InstrumentRegistry::instance());
+            }
+            currency_graph_.build();
+            graph_stale_ = false;
         }
 
-        bool TriangularArbitrageDetector::is_profitable_triangle(double profit_percentage)
+        MispricingOpportunity TriangularArbitrageDetector::create_cycle_opportunity(uint32_t cycle, double log_return) const
         {
-            return profit_percentage > params_.min_deviation_threshold;
+            const auto &path = currency_graph_.cycle(cycle);
+            double profit = std::expm1(log_return); // per unit of the starting currency
+
+            MispricingOpportunity opp;
+            opp.target_instrument = currency_graph_.edge(path.edges[0]).instrument;
+            for (uint32_t i = 0; i < path.length; ++i)
+            {
+                const auto &edge = currency_graph_.edge(path.edges[i]);
+                opp.component_instruments.push_back(edge.instrument);
+                opp.weights.push_back(edge.side == Side::BID ? 1.0 : -1.0);
+            }
+            opp.type = MispricingType::CROSS_CURRENCY_TRIANGULAR;
+            opp.severity = profit > 4.0 * params_.min_deviation_threshold   ? MispricingSeverity::HIGH
+                           : profit > 2.0 * params_.min_deviation_threshold ? MispricingSeverity::MEDIUM
+                                                                            : MispricingSeverity::LOW;
+            opp.market_price = 1.0;
+            opp.theoretical_price = 1.0 + profit;
+            opp.deviation_percentage = profit;
+            opp.confidence_level = 1.0; // executable at the quoted prices; size and latency are not modelled
+            opp.expected_profit = profit * params_.liquidity_threshold;
+            opp.expiry_time = opp.detection_time + params_.max_opportunity_duration;
+            return opp;
         }
 
         // VolatilityArbitrageDetector implementation
@@ -248,47 +445,105 @@ namespace spe
         // calculates realized volatility based on historical prices
         void VolatilityArbitrageDetector::update_market_data(const MarketSnapshot &snapshot)
         {
-            for (const auto &[instrument_id, quote] : snapshot.quotes)
+            for (auto instrument : snapshot.dirty_instruments())
             {
-                auto &history = volatility_history_[instrument_id];
-                double mid_price = (quote.bid_price + quote.ask_price) / 2.0;
-                history.push(mid_price);
-
-                // Keep only recent history
-                if (history.size() > 100)
+                if (snapshot.has_quote(instrument))
                 {
-                    history.pop();
+                    record_price(instrument, snapshot.mid_price(instrument));
                 }
             }
         }
-        // calculates realized volatility
-        std::vector<MispricingOpportunity> VolatilityArbitrageDetector::detect_opportunities()
+
+        void VolatilityArbitrageDetector::on_quote(InstrumentHandle instrument, const Quote &quote)
         {
-            std::vector<MispricingOpportunity> opportunities;
+            record_price(instrument, (quote.bid_price + quote.ask_price) / 2.0);
+        }
 
-            for (const auto &[instrument_id, price_history] : volatility_history_)
+        // An instrument is flagged once, when it has enough history for a realized volatility
+        void VolatilityArbitrageDetector::record_price(InstrumentHandle instrument, Price mid_price)
+        {
+            // Keep only the most recent 100 prices
+            auto it = volatility_history_.find(instrument);
+            if (it == volatility_history_.end())
             {
-                if (price_history.size() >= 20)
-                {
-                    double realized_vol = calculate_realized_volatility(price_history);
+                it = volatility_history_.emplace(instrument, RollingLogReturns(VOLATILITY_WINDOW)).first;
+            }
+            it->second.push(mid_price);
+            if (it->second.price_count() != MIN_PRICES)
+            {
+                return;
+            }
+
+            const MispricingOpportunity &opp = flag_instrument(instrument);
+            if (detection_callback_)
+            {
+                detection_callback_(opp);
+            }
+        }
+
+        const MispricingOpportunity &VolatilityArbitrageDetector::flag_instrument(InstrumentHandle instrument)
+        {
+            MispricingOpportunity opp;
+            opp.target_instrument = instrument;
+            opp.type = MispricingType::VOLATILITY_ARBITRAGE;
+            opp.severity = MispricingSeverity::LOW;
+            opp.market_price = 100.0;
+            opp.theoretical_price = 100.8;
+            opp.deviation_percentage = 0.008;
+            opp.z_score = 1.8;
+            opp.confidence_level = 0.75;
+            opp.expected_profit = 80.0;
+            opp.max_loss = 40.0;
+            active_opportunities_.push_back(opp);
+            return active_opportunities_.back();
+        }
+
+        void VolatilityArbitrageDetector::save_state(checkpoint::CheckpointWriter &out) const
+        {
+            out.put_count(volatility_history_.size());
+            for (const auto &entry : volatility_history_)
+            {
+                out.put_instrument(entry.first);
+                out.put(entry.second.last_price());
+                out.put_count(entry.second.price_count());
+                out.put_rolling(entry.second.returns());
+            }
+        }
 
-                    MispricingOpportunity opp;
-                    opp.target_instrument = instrument_id;
-                    opp.type = MispricingType::VOLATILITY_ARBITRAGE;
-                    opp.severity = MispricingSeverity::LOW;
-                    opp.market_price = 100.0;
-                    opp.theoretical_price = 100.8;
-                    opp.deviation_percentage = 0.008;
-                    opp.z_score = 1.8;
-                    opp.confidence_level = 0.75;
-                    opp.expected_profit = 80.0;
-                    opp.max_loss = 40.0;
+        bool VolatilityArbitrageDetector::restore_state(checkpoint::SectionReader &in)
+        {
+            size_t instruments = 0;
+            in.get_count(instruments, sizeof(uint32_t) + sizeof(double) + sizeof(uint64_t) + sizeof(uint32_t) + sizeof(double));
+            for (size_t i = 0; i < instruments && in.ok(); ++i)
+            {
+                InstrumentHandle instrument = INVALID_INSTRUMENT;
+                double last_price = 0.0;
+                size_t price_count = 0;
+                in.get_instrument(instrument);
+                in.get(last_price);
+                in.get_count(price_count, 0);
 
-                    opportunities.push_back(opp);
+                RollingLogReturns history(VOLATILITY_WINDOW);
+                RollingStatistics returns(history.returns().capacity());
+                if (!in.get_rolling(returns) || instrument == INVALID_INSTRUMENT)
+                {
+                    continue;
+                }
+                history.restore(std::move(returns), last_price, price_count);
+                bool was_flagged = history.price_count() >= MIN_PRICES;
+                bool known = volatility_history_.count(instrument) != 0;
+                volatility_history_[instrument] = std::move(history);
+                if (was_flagged && !known)
+                {
+                    flag_instrument(instrument);
                 }
             }
+            return in.ok();
+        }
 
-            return opportunities;
+        std::vector<MispricingOpportunity> VolatilityArbitrageDetector::detect_opportunities()
+        {
+            return active_opportunities_;
         }
 
         void VolatilityArbitrageDetector::set_detection_callback(MispricingCallback callback)
@@ -306,39 +561,13 @@ namespace spe
             params_ = params;
         }
 
-        double VolatilityArbitrageDetector::calculate_realized_volatility(const std::queue<Price> &prices)
+        double VolatilityArbitrageDetector::calculate_realized_volatility(const RollingLogReturns &prices)
         {
-            if (prices.size() < 2)
-                return 0.0;
-
-            std::vector<double> returns;
-            std::queue<Price> temp_queue = prices;
-            double prev_price = temp_queue.front();
-            temp_queue.pop();
-
-            while (!temp_queue.empty())
-            {
-                double current_price = temp_queue.front();
-                temp_queue.pop();
-                if (prev_price > 0)
-                {
-                    returns.push_back(std::log(current_price / prev_price));
-                }
-                prev_price = current_price;
-            }
-
+            const auto &returns = prices.returns();
             if (returns.empty())
                 return 0.0;
 
-            double mean_return = std::accumulate(returns.begin(), returns.end(), 0.0) / returns.size();
-            double variance = 0.0;
-            for (double ret : returns)
-            {
-                variance += (ret - mean_return) * (ret - mean_return);
-            }
-            variance /= returns.size();
-
-            return std::sqrt(variance * 252); // Annualized volatility
+            return std::sqrt(returns.variance() * 252); // Annualized volatility
         }
 
         double VolatilityArbitrageDetector::calculate_implied_volatility_proxy(const Quote &quote)
@@ -353,81 +582,1769 @@ namespace spe
             return detect_opportunities(); // Simplified for demo
         }
 
-        // CompositeMispricingDetector implementation
-        CompositeMispricingDetector::CompositeMispricingDetector(const DetectionParameters &params)
-            : params_(params) {}
-          // manages a collection of deifferent detector types
-        void CompositeMispricingDetector::add_detector(std::unique_ptr<IMispricingDetector> detector)
+        // SpotVsSyntheticDerivativeDetector implementation
+        SpotVsSyntheticDerivativeDetector::SpotVsSyntheticDerivativeDetector(
+            std::unique_ptr<IPricingModel> model,
+            const DetectionParameters &params)
+            : params_(params), derivative_pricing_model_(std::move(model)), options_model_(nullptr)
         {
-            detectors_.push_back(std::move(detector));
+            options_model_ = dynamic_cast<OptionsPricingModel *>(derivative_pricing_model_.get());
+            if (!options_model_)
+            {
+                default_options_model_ = std::make_unique<OptionsPricingModel>();
+                options_model_ = default_options_model_.get();
+            }
         }
 
-        void CompositeMispricingDetector::remove_detector(size_t index)
+        void SpotVsSyntheticDerivativeDetector::update_market_data(const MarketSnapshot &snapshot)
         {
-            if (index < detectors_.size())
+            auto discrepancies = detect_derivative_mispricings(snapshot);
+
+            // Keep discrepancies of underlyings this snapshot did not touch
+            std::lock_guard<std::mutex> lock(discrepancies_mutex_);
+            for (const auto &discrepancy : active_discrepancies_)
             {
-                detectors_.erase(detectors_.begin() + index);
+                if (!repriced_underlyings_.count(discrepancy.spot_instrument))
+                {
+                    discrepancies.push_back(discrepancy);
+                }
             }
+            active_discrepancies_.swap(discrepancies);
         }
 
-        void CompositeMispricingDetector::update_market_data(const MarketSnapshot &snapshot)
+        std::vector<MispricingOpportunity> SpotVsSyntheticDerivativeDetector::detect_opportunities()
         {
-            for (auto &detector : detectors_)
+            std::vector<MispricingOpportunity> opportunities;
+
+            std::lock_guard<std::mutex> lock(discrepancies_mutex_);
+            for (const auto &discrepancy : active_discrepancies_)
             {
-                detector->update_market_data(snapshot);
+                MispricingOpportunity opp;
+                opp.target_instrument = discrepancy.derivative_instrument;
+                opp.component_instruments = {discrepancy.spot_instrument};
+                opp.weights = {discrepancy.delta}; // delta hedge in the underlying
+                opp.type = MispricingType::SPOT_VS_SYNTHETIC_DERIVATIVE;
+                opp.market_price = discrepancy.derivative_market_price;
+                opp.theoretical_price = discrepancy.derivative_theoretical_price;
+                opp.deviation_percentage = discrepancy.fair_value_deviation;
+                opp.confidence_level = 0.80; // Simplified confidence for demo
+                opp.expected_profit = discrepancy.expected_profit;
+                opp.max_loss = discrepancy.required_margin;
+
+                double magnitude = std::abs(discrepancy.fair_value_deviation);
+                opp.severity = magnitude > 4 * params_.min_deviation_threshold   ? MispricingSeverity::CRITICAL
+                               : magnitude > 2 * params_.min_deviation_threshold ? MispricingSeverity::HIGH
+                                                                                 : MispricingSeverity::MEDIUM;
+                opportunities.push_back(opp);
             }
+
+            return opportunities;
         }
 
-        std::vector<MispricingOpportunity> CompositeMispricingDetector::detect_opportunities()
+        void SpotVsSyntheticDerivativeDetector::set_detection_callback(MispricingCallback callback)
         {
-            std::vector<MispricingOpportunity> all_opportunities;
+            detection_callback_ = callback;
+        }
 
-            for (auto &detector : detectors_)
+        void SpotVsSyntheticDerivativeDetector::set_expiry_callback(MispricingExpiredCallback callback)
+        {
+            expiry_callback_ = callback;
+        }
+
+        void SpotVsSyntheticDerivativeDetector::update_parameters(const DetectionParameters &params)
+        {
+            params_ = params;
+        }
+
+        std::vector<DerivativePricingDiscrepancy> SpotVsSyntheticDerivativeDetector::get_active_derivative_discrepancies() const
+        {
+            std::lock_guard<std::mutex> lock(discrepancies_mutex_);
+            return active_discrepancies_;
+        }
+
+        void SpotVsSyntheticDerivativeDetector::add_derivative_instrument(InstrumentHandle derivative_id,
+                                                                          InstrumentHandle underlying_id)
+        {
+            auto &derivatives = derivatives_by_underlying_[underlying_id];
+            if (std::find(derivatives.begin(), derivatives.end(), derivative_id) == derivatives.end())
             {
-                auto opportunities = detector->detect_opportunities();
-                all_opportunities.insert(all_opportunities.end(), opportunities.begin(), opportunities.end());
+                derivatives.push_back(derivative_id);
+                underlyings_by_derivative_[derivative_id].push_back(underlying_id);
             }
+        }
 
-            consolidate_opportunities(all_opportunities);
-            return all_opportunities;
+        void SpotVsSyntheticDerivativeDetector::add_option_instrument(InstrumentHandle option, const OptionContract &contract)
+        {
+            options_model_->register_option(option, contract);
         }
 
-        void CompositeMispricingDetector::set_detection_callback(MispricingCallback callback)
+        void SpotVsSyntheticDerivativeDetector::update_volatility_surface(InstrumentHandle underlying,
+                                                                          const VolatilitySurface &surface)
         {
-            detection_callback_ = callback;
-            for (auto &detector : detectors_)
+            options_model_->update_volatility_surface(underlying, surface);
+        }
+
+        std::vector<DerivativePricingDiscrepancy> SpotVsSyntheticDerivativeDetector::detect_derivative_mispricings(
+            const MarketSnapshot &snapshot)
+        {
+            std::vector<DerivativePricingDiscrepancy> discrepancies;
+
+            // Underlyings whose own quote or one of whose derivatives moved
+            auto &underlyings = repriced_underlyings_;
+            underlyings.clear();
+            for (auto instrument : snapshot.dirty_instruments())
+            {
+                if (auto contract = options_model_->get_option_contract(instrument))
+                {
+                    underlyings.insert(contract->underlying);
+                    continue;
+                }
+                underlyings.insert(instrument);
+                auto dependents = underlyings_by_derivative_.find(instrument);
+                if (dependents != underlyings_by_derivative_.end())
+                {
+                    underlyings.insert(dependents->second.begin(), dependents->second.end());
+                }
+            }
+
+            for (auto underlying : underlyings)
             {
-                detector->set_detection_callback(callback);
+                if (!snapshot.has_quote(underlying))
+                {
+                    continue;
+                }
+
+                // Every option mid on this underlying depends on spot, so the chain is priced in one batch
+                if (!options_model_->get_chain_options(underlying).empty())
+                {
+                    detect_option_mispricings(underlying, snapshot, discrepancies);
+                }
+
+                auto it = derivatives_by_underlying_.find(underlying);
+                if (it == derivatives_by_underlying_.end())
+                {
+                    continue;
+                }
+
+                Price spot = snapshot.mid_price(underlying);
+                for (auto derivative : it->second)
+                {
+                    if (!snapshot.has_quote(derivative))
+                    {
+                        continue;
+                    }
+
+                    double theoretical = calculate_theoretical_derivative_price(derivative, underlying, snapshot);
+                    double market = snapshot.mid_price(derivative);
+                    if (theoretical <= 0)
+                    {
+                        continue;
+                    }
+
+                    DerivativePricingDiscrepancy discrepancy;
+                    discrepancy.spot_instrument = underlying;
+                    discrepancy.derivative_instrument = derivative;
+                    discrepancy.spot_price = spot;
+                    discrepancy.derivative_market_price = market;
+                    discrepancy.derivative_theoretical_price = theoretical;
+                    discrepancy.fair_value_deviation = (market - theoretical) / theoretical;
+                    discrepancy.delta = 1.0;
+                    if (std::abs(discrepancy.fair_value_deviation) > params_.min_deviation_threshold)
+                    {
+                        discrepancy.expected_profit = std::abs(market - theoretical);
+                        discrepancy.required_margin = calculate_margin_requirement(discrepancy);
+                        discrepancy.profit_to_margin_ratio = discrepancy.expected_profit / discrepancy.required_margin;
+                        discrepancies.push_back(discrepancy);
+                    }
+                }
             }
+
+            return discrepancies;
         }
 
-        void CompositeMispricingDetector::set_expiry_callback(MispricingExpiredCallback callback)
+        void SpotVsSyntheticDerivativeDetector::detect_option_mispricings(
+            InstrumentHandle underlying, const MarketSnapshot &snapshot,
+            std::vector<DerivativePricingDiscrepancy> &discrepancies)
         {
-            expiry_callback_ = callback;
-            for (auto &detector : detectors_)
+            Quote spot_quote = snapshot.quote(underlying);
+            const auto &options = options_model_->get_chain_options(underlying);
+            const auto &greeks = options_model_->price_underlying_chain(underlying, spot_quote);
+
+            for (size_t i = 0; i < options.size(); ++i)
             {
-                detector->set_expiry_callback(callback);
+                InstrumentHandle option = options[i];
+                double theoretical = greeks.prices[i];
+                if (!snapshot.has_quote(option) || theoretical <= 0)
+                {
+                    continue;
+                }
+
+                double market = snapshot.mid_price(option);
+                double deviation = (market - theoretical) / theoretical;
+                if (std::abs(deviation) <= params_.min_deviation_threshold)
+                {
+                    continue;
+                }
+
+                DerivativePricingDiscrepancy discrepancy;
+                discrepancy.spot_instrument = underlying;
+                discrepancy.derivative_instrument = option;
+                discrepancy.spot_price = snapshot.mid_price(underlying);
+                discrepancy.derivative_market_price = market;
+                discrepancy.derivative_theoretical_price = theoretical;
+                discrepancy.fair_value_deviation = deviation;
+                discrepancy.delta = greeks.deltas[i];
+                discrepancy.gamma = greeks.gammas[i];
+                discrepancy.theta = greeks.thetas[i];
+                discrepancy.time_to_expiry = options_model_->get_option_contract(option)->time_to_expiry;
+                // Newton solve only for the few options that actually flag
+                discrepancy.implied_volatility = options_model_->get_implied_volatility(option, snapshot.quote(option), spot_quote);
+                discrepancy.expected_profit = std::abs(market - theoretical);
+                discrepancy.required_margin = calculate_margin_requirement(discrepancy);
+                discrepancy.profit_to_margin_ratio = discrepancy.expected_profit / discrepancy.required_margin;
+                discrepancies.push_back(discrepancy);
             }
         }
 
-        void CompositeMispricingDetector::update_parameters(const DetectionParameters &params)
+        double SpotVsSyntheticDerivativeDetector::calculate_theoretical_derivative_price(
+            InstrumentHandle derivative, InstrumentHandle underlying, const MarketSnapshot &snapshot)
         {
-            params_ = params;
-            for (auto &detector : detectors_)
+            PipelineRef compiled = compiled_derivatives_.find(derivative);
+            if (compiled.valid())
             {
-                detector->update_parameters(params);
+                double theoretical = 0.0;
+                compiled_derivatives_.evaluate(compiled, snapshot, [&](const auto &, const SyntheticQuote &quote)
+                                               { theoretical = quote.theoretical; });
+                return theoretical;
+            }
+            if (!derivative_pricing_model_)
+            {
+                return snapshot.mid_price(underlying);
             }
+            return derivative_pricing_model_->calculate_synthetic_price(derivative, {underlying}, snapshot).theoretical_price;
         }
 
-        void CompositeMispricingDetector::consolidate_opportunities(std::vector<MispricingOpportunity> &opportunities)
+        double SpotVsSyntheticDerivativeDetector::calculate_margin_requirement(const DerivativePricingDiscrepancy &discrepancy)
         {
-            // Remove duplicates and merge similar opportunities
-            // Simplified implementation for demo
-            std::sort(opportunities.begin(), opportunities.end(),
-                      [](const MispricingOpportunity &a, const MispricingOpportunity &b)
-                      {
-                          return a.expected_profit > b.expected_profit;
-                      });
+            // Premium plus a delta-scaled share of the underlying, floored to avoid zero margins
+            double margin = discrepancy.derivative_market_price + 0.1 * std::abs(discrepancy.delta) * discrepancy.spot_price;
+            return std::max(margin, 1e-9);
+        }
+
+        // CompositeMispricingDetector implementation
+        CompositeMispricingDetector::CompositeMispricingDetector(const DetectionParameters &params)
+            : params_(params), execution_mode_(concurrency::ExecutionMode::SEQUENTIAL),
+              detector_deadline_(std::chrono::nanoseconds::max()) {}
+          // manages a collection of deifferent detector types
+        void CompositeMispricingDetector::add_detector(std::unique_ptr<IMispricingDetector> detector)
+        {
+            detectors_.push_back(std::move(detector));
+            pending_.emplace_back();
+            results_.emplace_back();
+            wire_detector(detectors_.size() - 1);
+        }
+
+        void CompositeMispricingDetector::remove_detector(size_t index)
+        {
+            if (index < detectors_.size())
+            {
+                detectors_.erase(detectors_.begin() + index);
+                pending_.erase(pending_.begin() + index);
+                results_.erase(results_.begin() + index);
+                for (size_t i = index; i < detectors_.size(); ++i)
+                {
+                    wire_detector(i); // buffered callbacks are keyed by position
+                }
+            }
+        }
+
+        void CompositeMispricingDetector::set_execution_mode(concurrency::ExecutionMode mode,
+                                                             std::shared_ptr<concurrency::WorkStealingPool> pool,
+                                                             std::chrono::nanoseconds deadline)
+        {
+            execution_mode_ = mode;
+            pool_ = std::move(pool);
+            detector_deadline_ = deadline;
+        }
+
+        void CompositeMispricingDetector::update_market_data(const MarketSnapshot &snapshot)
+        {
+            concurrency::run_tasks(execution_mode_, pool_.get(), detectors_.size(),
+                                   [this, &snapshot](size_t index)
+                                   { detectors_[index]->update_market_data(snapshot); },
+                                   detector_deadline_, &run_status_);
+            flush_pending_callbacks();
+        }
+
+        void CompositeMispricingDetector::on_quote(InstrumentHandle instrument, const Quote &quote)
+        {
+            for (auto &detector : detectors_)
+            {
+                detector->on_quote(instrument, quote);
+            }
+            flush_pending_callbacks();
+        }
+
+        void CompositeMispricingDetector::on_trade(InstrumentHandle instrument, const Trade &trade)
+        {
+            for (auto &detector : detectors_)
+            {
+                detector->on_trade(instrument, trade);
+            }
+            flush_pending_callbacks();
+        }
+
+        void CompositeMispricingDetector::on_book_update(InstrumentHandle instrument, const MarketDepth &depth)
+        {
+            for (auto &detector : detectors_)
+            {
+                detector->on_book_update(instrument, depth);
+            }
+            flush_pending_callbacks();
+        }
+
+        std::vector<MispricingOpportunity> CompositeMispricingDetector::detect_opportunities()
+        {
+            concurrency::run_tasks(execution_mode_, pool_.get(), detectors_.size(),
+                                   [this](size_t index)
+                                   { results_[index] = detectors_[index]->detect_opportunities(); },
+                                   detector_deadline_, &run_status_);
+            flush_pending_callbacks();
+
+            // Merge in detector order so the outcome does not depend on scheduling
+            std::vector<MispricingOpportunity> all_opportunities;
+            for (auto &opportunities : results_)
+            {
+                all_opportunities.insert(all_opportunities.end(), opportunities.begin(), opportunities.end());
+                opportunities.clear();
+            }
+
+            consolidate_opportunities(all_opportunities);
+            return all_opportunities;
+        }
+
+        void CompositeMispricingDetector::set_detection_callback(MispricingCallback callback)
+        {
+            detection_callback_ = callback;
+            for (size_t i = 0; i < detectors_.size(); ++i)
+            {
+                wire_detector(i);
+            }
+        }
+
+        void CompositeMispricingDetector::set_expiry_callback(MispricingExpiredCallback callback)
+        {
+            expiry_callback_ = callback;
+            for (size_t i = 0; i < detectors_.size(); ++i)
+            {
+                wire_detector(i);
+            }
+        }
+
+        void CompositeMispricingDetector::update_parameters(const DetectionParameters &params)
+        {
+            params_ = params;
+            for (auto &detector : detectors_)
+            {
+                detector->update_parameters(params);
+            }
+        }
+
+        void CompositeMispricingDetector::wire_detector(size_t index)
+        {
+            // Each detector only ever appends to its own buffer, so parallel runs need no locking
+            IMispricingDetector &detector = *detectors_[index];
+            if (detection_callback_)
+            {
+                detector.set_detection_callback([this, index](const MispricingOpportunity &opportunity)
+                                                { pending_[index].detected.push_back(opportunity); });
+            }
+            else
+            {
+                detector.set_detection_callback(nullptr);
+            }
+            if (expiry_callback_)
+            {
+                detector.set_expiry_callback([this, index](const MispricingOpportunity &opportunity)
+                                             { pending_[index].expired.push_back(opportunity); });
+            }
+            else
+            {
+                detector.set_expiry_callback(nullptr);
+            }
+        }
+
+        void CompositeMispricingDetector::flush_pending_callbacks()
+        {
+            for (auto &pending : pending_)
+            {
+                if (detection_callback_)
+                {
+                    for (const auto &opportunity : pending.detected)
+                    {
+                        detection_callback_(opportunity);
+                    }
+                }
+                if (expiry_callback_)
+                {
+                    for (const auto &opportunity : pending.expired)
+                    {
+                        expiry_callback_(opportunity);
+                    }
+                }
+                pending.detected.clear();
+                pending.expired.clear();
+            }
+        }
+
+        void CompositeMispricingDetector::consolidate_opportunities(std::vector<MispricingOpportunity> &opportunities)
+        {
+            // Remove duplicates and merge similar opportunities
+            // Simplified implementation for demo; stable so ties keep detector order
+            std::stable_sort(opportunities.begin(), opportunities.end(),
+                      [](const MispricingOpportunity &a, const MispricingOpportunity &b)
+                      {
+                          return a.expected_profit > b.expected_profit;
+                      });
+        }
+
+        // BasisTermStructure implementation
+        double BasisTermStructure::interpolate_annualized(double time_to_expiry) const
+        {
+            if (points.empty())
+            {
+                return 0.0;
+            }
+            if (time_to_expiry <= points.front().time_to_expiry)
+            {
+                return points.front().annualized_basis;
+            }
+            if (time_to_expiry >= points.back().time_to_expiry)
+            {
+                return points.back().annualized_basis;
+            }
+            auto upper = std::lower_bound(points.begin(), points.end(), time_to_expiry,
+                                          [](const TermStructurePoint &point, double tenor)
+                                          { return point.time_to_expiry < tenor; });
+            auto lower = upper - 1;
+            double span = upper->time_to_expiry - lower->time_to_expiry;
+            if (span <= 0.0)
+            {
+                return upper->annualized_basis;
+            }
+            double weight = (time_to_expiry - lower->time_to_expiry) / span;
+            return lower->annualized_basis + weight * (upper->annualized_basis - lower->annualized_basis);
+        }
+
+        // RealTimeBasisCalculator implementation
+        RealTimeBasisCalculator::RealTimeBasisCalculator(const DetectionParameters &params,
+                                                         std::shared_ptr<const FuturesPricingModel> futures_model)
+            : params_(params), futures_model_(std::move(futures_model)), epoch_(0), active_changed_(false),
+              pairs_changed_(false) {}
+
+        void RealTimeBasisCalculator::update_market_data(const MarketSnapshot &snapshot)
+        {
+            if (!snapshot.store())
+            {
+                return;
+            }
+
+            // Only pairs with a dirty leg; each once even when both legs moved
+            ++epoch_;
+            for (InstrumentHandle instrument : snapshot.dirty_instruments())
+            {
+                if (instrument >= pairs_by_instrument_.size())
+                {
+                    continue;
+                }
+                for (uint32_t index : pairs_by_instrument_[instrument])
+                {
+                    if (pairs_[index].epoch != epoch_)
+                    {
+                        pairs_[index].epoch = epoch_;
+                        evaluate_pair(index, snapshot);
+                    }
+                }
+            }
+
+            if (!touched_.empty() || active_changed_ || pairs_changed_)
+            {
+                publish_view();
+            }
+
+            for (const auto &opportunity : detected_)
+            {
+                detection_callback_(opportunity);
+            }
+            for (const auto &opportunity : expired_)
+            {
+                expiry_callback_(opportunity);
+            }
+            detected_.clear();
+            expired_.clear();
+        }
+
+        std::vector<MispricingOpportunity> RealTimeBasisCalculator::detect_opportunities()
+        {
+            return view_.read([this](const BasisView &view)
+                              {
+                                  std::vector<MispricingOpportunity> opportunities;
+                                  opportunities.reserve(view.active.size());
+                                  for (const auto &basis : view.active)
+                                  {
+                                      opportunities.push_back(create_opportunity(basis));
+                                  }
+                                  return opportunities; });
+        }
+
+        void RealTimeBasisCalculator::set_detection_callback(MispricingCallback callback)
+        {
+            detection_callback_ = callback;
+        }
+
+        void RealTimeBasisCalculator::set_expiry_callback(MispricingExpiredCallback callback)
+        {
+            expiry_callback_ = callback;
+        }
+
+        void RealTimeBasisCalculator::update_parameters(const DetectionParameters &params)
+        {
+            params_ = params; // existing windows keep their size
+        }
+
+        void RealTimeBasisCalculator::add_instrument_pair(InstrumentHandle spot, InstrumentHandle derivative)
+        {
+            if (spot == INVALID_INSTRUMENT || derivative == INVALID_INSTRUMENT || spot == derivative ||
+                find_pair(spot, derivative))
+            {
+                return;
+            }
+            insert_pair(spot, derivative);
+        }
+
+        void RealTimeBasisCalculator::add_underlying(InstrumentHandle spot)
+        {
+            if (!futures_model_)
+            {
+                return;
+            }
+            for (InstrumentHandle futures : futures_model_->get_listed_futures(spot))
+            {
+                add_instrument_pair(spot, futures);
+            }
+        }
+
+        void RealTimeBasisCalculator::save_state(checkpoint::CheckpointWriter &out) const
+        {
+            out.put_count(pairs_.size());
+            for (const auto &state : pairs_)
+            {
+                out.put_instrument(state.current.spot_instrument);
+                out.put_instrument(state.current.derivative_instrument);
+                out.put(static_cast<uint8_t>(state.dated));
+                out.put_count(state.history.size());
+                for (size_t i = 0; i < state.history.size(); ++i)
+                {
+                    const BasisRecord &record = state.history[i];
+                    out.put_time(record.time);
+                    out.put(record.spot_price);
+                    out.put(record.derivative_price);
+                    out.put(record.theoretical_basis);
+                }
+                out.put_rolling(state.basis_stats);
+                out.put_rolling(state.annualized_stats);
+            }
+        }
+
+        bool RealTimeBasisCalculator::restore_state(checkpoint::SectionReader &in)
+        {
+            constexpr size_t RECORD_BYTES = sizeof(int64_t) + 3 * sizeof(double);
+
+            size_t count = 0;
+            in.get_count(count, 2 * sizeof(uint32_t) + 1 + sizeof(uint64_t));
+            RollingStatistics basis_stats;
+            RollingStatistics annualized_stats;
+            for (size_t i = 0; i < count && in.ok(); ++i)
+            {
+                InstrumentHandle spot = INVALID_INSTRUMENT;
+                InstrumentHandle derivative = INVALID_INSTRUMENT;
+                uint8_t dated = 0;
+                size_t records = 0;
+                in.get_instrument(spot);
+                in.get_instrument(derivative);
+                in.get(dated);
+                in.get_count(records, RECORD_BYTES);
+                if (!in.ok())
+                {
+                    break;
+                }
+
+                add_instrument_pair(spot, derivative);
+                auto it = pair_index_.find(pair_key(spot, derivative));
+                PairState *state = it == pair_index_.end() ? nullptr : &pairs_[it->second];
+                if (state)
+                {
+                    state->history.clear();
+                    basis_stats.reset(state->basis_stats.capacity());
+                    annualized_stats.reset(state->annualized_stats.capacity());
+                }
+                for (size_t j = 0; j < records && in.ok(); ++j)
+                {
+                    BasisRecord record;
+                    in.get_time(record.time);
+                    in.get(record.spot_price);
+                    in.get(record.derivative_price);
+                    in.get(record.theoretical_basis);
+                    if (state && in.ok())
+                    {
+                        state->history.push(record);
+                    }
+                }
+                in.get_rolling(basis_stats);
+                in.get_rolling(annualized_stats);
+                if (state && in.ok())
+                {
+                    state->basis_stats = basis_stats;
+                    if (state->dated == (dated != 0))
+                    {
+                        state->annualized_stats = annualized_stats;
+                    }
+                }
+            }
+            return in.ok();
+        }
+
+        std::vector<BasisCalculation> RealTimeBasisCalculator::get_active_basis_opportunities() const
+        {
+            return view_.read([](const BasisView &view)
+                              { return view.active; });
+        }
+
+        double RealTimeBasisCalculator::get_current_basis(InstrumentHandle spot, InstrumentHandle derivative) const
+        {
+            uint64_t key = pair_key(spot, derivative);
+            return view_.read([key](const BasisView &view)
+                              {
+                                  auto it = std::lower_bound(view.index.begin(), view.index.end(), std::make_pair(key, 0u));
+                                  if (it == view.index.end() || it->first != key)
+                                  {
+                                      return 0.0;
+                                  }
+                                  return view.current[it->second].basis_value; });
+        }
+
+        BasisTermStructure RealTimeBasisCalculator::get_term_structure(InstrumentHandle underlying) const
+        {
+            return view_.read([underlying](const BasisView &view)
+                              {
+                                  for (const auto &curve : view.curves)
+                                  {
+                                      if (curve.underlying == underlying)
+                                      {
+                                          return curve;
+                                      }
+                                  }
+                                  return BasisTermStructure(); });
+        }
+
+        std::vector<BasisTermStructure> RealTimeBasisCalculator::get_term_structures() const
+        {
+            return view_.read([](const BasisView &view)
+                              { return view.curves; });
+        }
+
+        std::vector<BasisCalculation> RealTimeBasisCalculator::get_basis_history(InstrumentHandle spot,
+                                                                                  InstrumentHandle derivative) const
+        {
+            std::vector<BasisCalculation> history;
+            const PairState *state = find_pair(spot, derivative);
+            if (!state)
+            {
+                return history;
+            }
+
+            // Statistics are not kept per record; z-scores are left at 0
+            history.reserve(state->history.size());
+            for (size_t i = 0; i < state->history.size(); ++i)
+            {
+                const BasisRecord &record = state->history[i];
+                BasisCalculation basis;
+                basis.spot_instrument = spot;
+                basis.derivative_instrument = derivative;
+                basis.spot_price = record.spot_price;
+                basis.derivative_price = record.derivative_price;
+                basis.basis_value = record.derivative_price - record.spot_price;
+                basis.basis_percentage = basis.basis_value / record.spot_price;
+                basis.theoretical_basis = record.theoretical_basis;
+                basis.basis_deviation = basis.basis_percentage - record.theoretical_basis;
+                basis.calculation_time = record.time;
+                basis.update_frequency = i == 0 ? std::chrono::milliseconds(0)
+                                                : std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                      record.time - state->history[i - 1].time);
+                history.push_back(basis);
+            }
+            return history;
+        }
+
+        std::map<std::string, double> RealTimeBasisCalculator::get_pair_statistics(InstrumentHandle spot,
+                                                                                   InstrumentHandle derivative) const
+        {
+            std::map<std::string, double> statistics;
+            const PairState *state = find_pair(spot, derivative);
+            if (!state)
+            {
+                return statistics;
+            }
+            statistics["basis_percentage"] = state->current.basis_percentage;
+            statistics["mean_basis_percentage"] = state->basis_stats.mean();
+            statistics["basis_percentage_std_dev"] = state->basis_stats.std_dev();
+            statistics["mean_annualized_basis"] = state->annualized_stats.mean();
+            statistics["annualized_basis_std_dev"] = state->annualized_stats.std_dev();
+            statistics["z_score"] = state->current.z_score;
+            statistics["observations"] = static_cast<double>(state->history.size());
+            statistics["dated"] = state->dated ? 1.0 : 0.0;
+            statistics["active"] = state->active_position != NOT_ACTIVE ? 1.0 : 0.0;
+            return statistics;
+        }
+
+        uint64_t RealTimeBasisCalculator::pair_key(InstrumentHandle spot, InstrumentHandle derivative)
+        {
+            return (static_cast<uint64_t>(spot) << 32) | derivative;
+        }
+
+        const RealTimeBasisCalculator::PairState *RealTimeBasisCalculator::find_pair(InstrumentHandle spot,
+                                                                                     InstrumentHandle derivative) const
+        {
+            auto it = pair_index_.find(pair_key(spot, derivative));
+            return it == pair_index_.end() ? nullptr : &pairs_[it->second];
+        }
+
+        void RealTimeBasisCalculator::insert_pair(InstrumentHandle spot, InstrumentHandle derivative)
+        {
+            uint32_t index = static_cast<uint32_t>(pairs_.size());
+            pairs_.emplace_back(spot, derivative, params_.min_observation_window * 2);
+            PairState &state = pairs_.back();
+            pair_index_.emplace(pair_key(spot, derivative), index);
+
+            for (InstrumentHandle instrument : {spot, derivative})
+            {
+                if (instrument >= pairs_by_instrument_.size())
+                {
+                    pairs_by_instrument_.resize(instrument + 1);
+                }
+                pairs_by_instrument_[instrument].push_back(index);
+            }
+
+            // Dated legs join their underlying's curve in expiry order
+            const FuturesContract *contract = futures_model_ ? futures_model_->get_futures_contract(derivative) : nullptr;
+            if (!contract)
+            {
+                pairs_changed_ = true;
+                return;
+            }
+            state.dated = true;
+            state.expiry = contract->expiry;
+
+            auto found = curve_index_.find(spot);
+            if (found == curve_index_.end())
+            {
+                found = curve_index_.emplace(spot, static_cast<uint32_t>(curves_.size())).first;
+                curves_.push_back(Curve{spot, {}, true});
+            }
+            state.curve = found->second;
+            Curve &curve = curves_[state.curve];
+            auto position = std::upper_bound(curve.pairs.begin(), curve.pairs.end(), state.expiry,
+                                             [this](Timestamp expiry, uint32_t other)
+                                             { return expiry < pairs_[other].expiry; });
+            curve.pairs.insert(position, index);
+            curve.dirty = true;
+            pairs_changed_ = true;
+        }
+
+        void RealTimeBasisCalculator::evaluate_pair(uint32_t index, const MarketSnapshot &snapshot)
+        {
+            PairState &state = pairs_[index];
+            BasisCalculation &basis = state.current;
+            if (!snapshot.has_quote(basis.spot_instrument) || !snapshot.has_quote(basis.derivative_instrument))
+            {
+                return;
+            }
+            Price spot = snapshot.mid_price(basis.spot_instrument);
+            Price derivative = snapshot.mid_price(basis.derivative_instrument);
+            if (!(spot > 0.0) || !(derivative > 0.0))
+            {
+                return;
+            }
+
+            double time_to_expiry = 0.0;
+            if (state.dated)
+            {
+                std::chrono::duration<double> remaining = state.expiry - snapshot.snapshot_time;
+                time_to_expiry = remaining.count() / (365.0 * 24 * 3600);
+                if (time_to_expiry <= 0.0)
+                {
+                    return; // expired; the leg stops updating and drops off its curve
+                }
+            }
+
+            double basis_percentage = (derivative - spot) / spot;
+            double annualized = state.dated ? std::log(derivative / spot) / std::max(time_to_expiry, MIN_TIME_TO_EXPIRY)
+                                            : basis_percentage;
+
+            // Score against the window before this observation joins it
+            basis.update_frequency = state.evaluated ? std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                           snapshot.snapshot_time - basis.calculation_time)
+                                                     : std::chrono::milliseconds(0);
+            basis.spot_price = spot;
+            basis.derivative_price = derivative;
+            basis.basis_value = derivative - spot;
+            basis.basis_percentage = basis_percentage;
+            basis.theoretical_basis = calculate_theoretical_basis(basis.derivative_instrument, time_to_expiry);
+            basis.basis_deviation = basis_percentage - basis.theoretical_basis;
+            basis.z_score = calculate_basis_z_score(annualized, state.annualized_stats);
+            basis.calculation_time = snapshot.snapshot_time;
+            bool warm = state.annualized_stats.size() >= params_.min_observation_window;
+
+            state.history.push(BasisRecord{snapshot.snapshot_time, spot, derivative, basis.theoretical_basis});
+            state.basis_stats.push(basis_percentage);
+            state.annualized_stats.push(annualized);
+            state.evaluated = true;
+            touched_.push_back(index);
+            if (state.curve != NOT_ACTIVE)
+            {
+                curves_[state.curve].dirty = true;
+            }
+            if (!warm)
+            {
+                return;
+            }
+
+            // Open on a significant deviation, stay open until |z| falls back to EXIT_Z_SCORE
+            if (state.active_position == NOT_ACTIVE)
+            {
+                if (is_significant_basis_deviation(basis))
+                {
+                    state.active_position = static_cast<uint32_t>(active_.size());
+                    active_.push_back(index);
+                    active_changed_ = true;
+                    if (detection_callback_)
+                    {
+                        detected_.push_back(create_opportunity(basis));
+                    }
+                }
+            }
+            else if (std::abs(basis.z_score) <= EXIT_Z_SCORE)
+            {
+                uint32_t moved = active_.back();
+                active_[state.active_position] = moved;
+                pairs_[moved].active_position = state.active_position;
+                active_.pop_back();
+                state.active_position = NOT_ACTIVE;
+                active_changed_ = true;
+                if (expiry_callback_)
+                {
+                    expired_.push_back(create_opportunity(basis));
+                }
+            }
+            else
+            {
+                active_changed_ = true; // open deviation moved
+            }
+        }
+
+        void RealTimeBasisCalculator::publish_view()
+        {
+            view_.update([this](BasisView &view)
+                         {
+                             // The spare copy starts from the published one; patch what changed
+                             if (pairs_changed_)
+                             {
+                                 view.index.clear();
+                                 for (const auto &entry : pair_index_)
+                                 {
+                                     view.index.push_back(entry);
+                                 }
+                                 std::sort(view.index.begin(), view.index.end());
+                                 view.current.resize(pairs_.size());
+                                 view.curves.resize(curves_.size());
+                             }
+                             for (uint32_t index : touched_)
+                             {
+                                 view.current[index] = pairs_[index].current;
+                             }
+                             if (active_changed_)
+                             {
+                                 view.active.clear();
+                                 for (uint32_t index : active_)
+                                 {
+                                     view.active.push_back(pairs_[index].current);
+                                 }
+                             }
+                             for (size_t i = 0; i < curves_.size(); ++i)
+                             {
+                                 if (curves_[i].dirty)
+                                 {
+                                     build_curve(curves_[i], view.curves[i]);
+                                 }
+                             } });
+
+            for (auto &curve : curves_)
+            {
+                curve.dirty = false;
+            }
+            touched_.clear();
+            active_changed_ = false;
+            pairs_changed_ = false;
+        }
+
+        void RealTimeBasisCalculator::build_curve(const Curve &curve, BasisTermStructure &out) const
+        {
+            out.underlying = curve.underlying;
+            out.points.clear();
+            for (uint32_t index : curve.pairs)
+            {
+                const PairState &state = pairs_[index];
+                std::chrono::duration<double> remaining = state.expiry - state.current.calculation_time;
+                double time_to_expiry = remaining.count() / (365.0 * 24 * 3600);
+                if (!state.evaluated || time_to_expiry <= 0.0)
+                {
+                    continue;
+                }
+                TermStructurePoint point;
+                point.derivative_instrument = state.current.derivative_instrument;
+                point.expiry = state.expiry;
+                point.time_to_expiry = time_to_expiry;
+                point.basis_percentage = state.current.basis_percentage;
+                point.annualized_basis = state.annualized_stats.last();
+                point.theoretical_annualized = futures_model_ ? futures_model_->get_carry_rate(point.derivative_instrument) : 0.0;
+                point.z_score = state.current.z_score;
+                out.points.push_back(point);
+                out.update_time = std::max(out.update_time, state.current.calculation_time);
+            }
+        }
+
+        MispricingOpportunity RealTimeBasisCalculator::create_opportunity(const BasisCalculation &basis) const
+        {
+            MispricingOpportunity opp;
+            opp.target_instrument = basis.derivative_instrument;
+            opp.component_instruments = {basis.derivative_instrument, basis.spot_instrument};
+            // Rich basis: sell the derivative and buy spot
+            bool rich = basis.basis_deviation > 0.0;
+            opp.weights = {rich ? -1.0 : 1.0, rich ? 1.0 : -1.0};
+            opp.type = MispricingType::SPOT_VS_SYNTHETIC_DERIVATIVE;
+
+            double z = std::abs(basis.z_score);
+            opp.severity = z >= 2.0 * params_.min_z_score   ? MispricingSeverity::HIGH
+                           : z >= 1.5 * params_.min_z_score ? MispricingSeverity::MEDIUM
+                                                            : MispricingSeverity::LOW;
+            opp.market_price = basis.derivative_price;
+            opp.theoretical_price = basis.spot_price * (1.0 + basis.theoretical_basis);
+            opp.deviation_percentage = basis.basis_deviation;
+            opp.z_score = basis.z_score;
+            opp.confidence_level = 1.0 - std::erfc(z / std::sqrt(2.0));
+            opp.expected_profit = std::abs(basis.basis_deviation) * params_.liquidity_threshold;
+            opp.detection_time = basis.calculation_time;
+            opp.expiry_time = opp.detection_time + params_.max_opportunity_duration;
+            return opp;
+        }
+
+        double RealTimeBasisCalculator::calculate_theoretical_basis(InstrumentHandle derivative, double time_to_expiry) const
+        {
+            // Cost of carry for dated legs; an undated leg should trade at spot
+            if (!futures_model_ || time_to_expiry <= 0.0)
+            {
+                return 0.0;
+            }
+            return std::expm1(futures_model_->get_carry_rate(derivative) * time_to_expiry);
+        }
+
+        double RealTimeBasisCalculator::calculate_basis_z_score(double scored_value, const RollingStatistics &history) const
+        {
+            return history.size() < 2 ? 0.0 : history.z_score(scored_value);
+        }
+
+        bool RealTimeBasisCalculator::is_significant_basis_deviation(const BasisCalculation &basis) const
+        {
+            return std::abs(basis.z_score) >= params_.min_z_score &&
+                   std::abs(basis.basis_deviation) >= params_.min_deviation_threshold &&
+                   1.0 - std::erfc(std::abs(basis.z_score) / std::sqrt(2.0)) >= params_.min_confidence_level;
+        }
+
+        // StatisticalArbitrageSignalGenerator implementation
+        StatisticalArbitrageSignalGenerator::StatisticalArbitrageSignalGenerator(const DetectionParameters &params)
+            : params_(params), entry_threshold_(params.min_z_score), exit_threshold_(0.5),
+              execution_mode_(concurrency::ExecutionMode::SEQUENTIAL)
+        {
+            shards_.push_back(std::make_unique<PairShard>());
+        }
+
+        void StatisticalArbitrageSignalGenerator::update_market_data(const MarketSnapshot &snapshot)
+        {
+            if (!snapshot.store())
+            {
+                return;
+            }
+
+            // Route the tick: each shard only sees instruments it has pairs on
+            for (InstrumentHandle instrument : snapshot.dirty_instruments())
+            {
+                if (instrument < shards_by_instrument_.size())
+                {
+                    for (uint16_t shard : shards_by_instrument_[instrument])
+                    {
+                        shards_[shard]->inbox.push_back(instrument);
+                    }
+                }
+            }
+
+            concurrency::run_tasks(execution_mode_, pool_.get(), shards_.size(),
+                                   [this, &snapshot](size_t index)
+                                   { evaluate_shard(*shards_[index], snapshot); });
+
+            bool changed = false;
+            for (auto &shard : shards_)
+            {
+                changed |= shard->changed;
+            }
+            if (changed)
+            {
+                publish_signals();
+            }
+
+            // Callbacks on this thread, in shard order
+            for (auto &shard : shards_)
+            {
+                for (const auto &opportunity : shard->detected)
+                {
+                    detection_callback_(opportunity);
+                }
+                for (const auto &opportunity : shard->expired)
+                {
+                    expiry_callback_(opportunity);
+                }
+                shard->detected.clear();
+                shard->expired.clear();
+            }
+        }
+
+        std::vector<MispricingOpportunity> StatisticalArbitrageSignalGenerator::detect_opportunities()
+        {
+            return active_signals_.read([this](const std::vector<StatArbitrageSignal> &signals)
+                                        {
+                                            std::vector<MispricingOpportunity> opportunities;
+                                            opportunities.reserve(signals.size());
+                                            for (const auto &signal : signals)
+                                            {
+                                                opportunities.push_back(create_opportunity(signal));
+                                            }
+                                            return opportunities; });
+        }
+
+        void StatisticalArbitrageSignalGenerator::set_detection_callback(MispricingCallback callback)
+        {
+            detection_callback_ = callback;
+        }
+
+        void StatisticalArbitrageSignalGenerator::set_expiry_callback(MispricingExpiredCallback callback)
+        {
+            expiry_callback_ = callback;
+        }
+
+        void StatisticalArbitrageSignalGenerator::update_parameters(const DetectionParameters &params)
+        {
+            params_ = params; // existing ratio windows keep their size
+        }
+
+        std::vector<StatArbitrageSignal> StatisticalArbitrageSignalGenerator::get_active_signals() const
+        {
+            return active_signals_.read([](const std::vector<StatArbitrageSignal> &signals)
+                                        { return signals; });
+        }
+
+        void StatisticalArbitrageSignalGenerator::add_instrument_pair(InstrumentHandle instrument1, InstrumentHandle instrument2)
+        {
+            if (instrument1 == INVALID_INSTRUMENT || instrument2 == INVALID_INSTRUMENT || instrument1 == instrument2 ||
+                find_pair(instrument1, instrument2) || find_pair(instrument2, instrument1))
+            {
+                return;
+            }
+            insert_pair(PairState(instrument1, instrument2, params_.min_observation_window * 2));
+        }
+
+        void StatisticalArbitrageSignalGenerator::save_state(checkpoint::CheckpointWriter &out) const
+        {
+            out.put_count(pair_count());
+            for (const auto &shard : shards_)
+            {
+                for (const auto &state : shard->pairs)
+                {
+                    out.put_instrument(state.signal.instrument_1);
+                    out.put_instrument(state.signal.instrument_2);
+                    out.put_rolling(state.ratio_history);
+                }
+            }
+        }
+
+        bool StatisticalArbitrageSignalGenerator::restore_state(checkpoint::SectionReader &in)
+        {
+            size_t count = 0;
+            in.get_count(count, 3 * sizeof(uint32_t) + sizeof(double));
+            for (size_t i = 0; i < count && in.ok(); ++i)
+            {
+                InstrumentHandle instrument1 = INVALID_INSTRUMENT;
+                InstrumentHandle instrument2 = INVALID_INSTRUMENT;
+                in.get_instrument(instrument1);
+                in.get_instrument(instrument2);
+                add_instrument_pair(instrument1, instrument2);
+
+                // Only into the pair as saved: the reversed pair scores the inverse ratio
+                uint64_t key = pair_key(instrument1, instrument2);
+                PairShard &shard = *shards_[shard_of(key)];
+                auto it = shard.pair_index.find(key);
+                RollingStatistics history;
+                if (it == shard.pair_index.end() || instrument1 == INVALID_INSTRUMENT)
+                {
+                    in.get_rolling(history); // read past it
+                    continue;
+                }
+                RollingStatistics &ratio_history = shard.pairs[it->second].ratio_history;
+                history.reset(ratio_history.capacity());
+                if (in.get_rolling(history))
+                {
+                    ratio_history = std::move(history);
+                }
+            }
+            return in.ok();
+        }
+
+        void StatisticalArbitrageSignalGenerator::set_signal_thresholds(double entry_threshold, double exit_threshold)
+        {
+            entry_threshold_ = entry_threshold;
+            exit_threshold_ = exit_threshold;
+        }
+
+        void StatisticalArbitrageSignalGenerator::set_sharding(size_t shard_count, concurrency::ExecutionMode mode,
+                                                               std::shared_ptr<concurrency::WorkStealingPool> pool)
+        {
+            shard_count = std::min<size_t>(std::max<size_t>(shard_count, 1), std::numeric_limits<uint16_t>::max());
+
+            std::vector<PairState> pairs;
+            for (auto &shard : shards_)
+            {
+                for (auto &state : shard->pairs)
+                {
+                    pairs.push_back(std::move(state));
+                }
+            }
+
+            shards_.clear();
+            for (size_t i = 0; i < shard_count; ++i)
+            {
+                shards_.push_back(std::make_unique<PairShard>());
+            }
+            shards_by_instrument_.clear();
+            for (auto &state : pairs)
+            {
+                insert_pair(std::move(state)); // keeps history and open signals
+            }
+
+            execution_mode_ = mode;
+            pool_ = std::move(pool);
+            publish_signals();
+        }
+
+        size_t StatisticalArbitrageSignalGenerator::pair_count() const
+        {
+            size_t count = 0;
+            for (const auto &shard : shards_)
+            {
+                count += shard->pairs.size();
+            }
+            return count;
+        }
+
+        double StatisticalArbitrageSignalGenerator::get_current_z_score(InstrumentHandle instrument1,
+                                                                        InstrumentHandle instrument2) const
+        {
+            const PairState *state = find_pair(instrument1, instrument2);
+            return state ? state->signal.z_score : 0.0;
+        }
+
+        std::map<std::string, double> StatisticalArbitrageSignalGenerator::get_pair_statistics(InstrumentHandle instrument1,
+                                                                                               InstrumentHandle instrument2) const
+        {
+            std::map<std::string, double> statistics;
+            const PairState *state = find_pair(instrument1, instrument2);
+            if (!state)
+            {
+                return statistics;
+            }
+            statistics["price_ratio"] = state->signal.price_ratio;
+            statistics["mean_ratio"] = state->signal.mean_ratio;
+            statistics["ratio_std_dev"] = state->signal.ratio_std_dev;
+            statistics["z_score"] = state->signal.z_score;
+            statistics["correlation"] = state->signal.correlation;
+            statistics["half_life"] = state->signal.half_life;
+            statistics["observations"] = static_cast<double>(state->ratio_history.size());
+            statistics["active"] = state->active_position != NOT_ACTIVE ? 1.0 : 0.0;
+            return statistics;
+        }
+
+        uint64_t StatisticalArbitrageSignalGenerator::pair_key(InstrumentHandle instrument1, InstrumentHandle instrument2)
+        {
+            return (static_cast<uint64_t>(instrument1) << 32) | instrument2;
+        }
+
+        size_t StatisticalArbitrageSignalGenerator::shard_of(uint64_t key) const
+        {
+            // Fibonacci hash so consecutive handles spread over the shards
+            return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) % shards_.size();
+        }
+
+        void StatisticalArbitrageSignalGenerator::insert_pair(PairState &&state)
+        {
+            InstrumentHandle instrument1 = state.signal.instrument_1;
+            InstrumentHandle instrument2 = state.signal.instrument_2;
+            uint64_t key = pair_key(instrument1, instrument2);
+            uint16_t shard_id = static_cast<uint16_t>(shard_of(key));
+            PairShard &shard = *shards_[shard_id];
+
+            uint32_t index = static_cast<uint32_t>(shard.pairs.size());
+            bool active = state.active_position != NOT_ACTIVE;
+            state.active_position = NOT_ACTIVE;
+            state.epoch = 0;
+            shard.pairs.push_back(std::move(state));
+            shard.pair_index.emplace(key, index);
+            if (active)
+            {
+                shard.pairs[index].active_position = static_cast<uint32_t>(shard.active.size());
+                shard.active.push_back(index);
+            }
+
+            for (InstrumentHandle instrument : {instrument1, instrument2})
+            {
+                shard.pairs_by_instrument[instrument].push_back(index);
+                if (instrument >= shards_by_instrument_.size())
+                {
+                    shards_by_instrument_.resize(instrument + 1);
+                }
+                auto &routes = shards_by_instrument_[instrument];
+                if (std::find(routes.begin(), routes.end(), shard_id) == routes.end())
+                {
+                    routes.push_back(shard_id);
+                }
+            }
+        }
+
+        const StatisticalArbitrageSignalGenerator::PairState *StatisticalArbitrageSignalGenerator::find_pair(
+            InstrumentHandle instrument1, InstrumentHandle instrument2) const
+        {
+            uint64_t key = pair_key(instrument1, instrument2);
+            const PairShard &shard = *shards_[shard_of(key)];
+            auto it = shard.pair_index.find(key);
+            return it == shard.pair_index.end() ? nullptr : &shard.pairs[it->second];
+        }
+
+        void StatisticalArbitrageSignalGenerator::evaluate_shard(PairShard &shard, const MarketSnapshot &snapshot)
+        {
+            // Runs on one worker per shard; touches nothing outside the shard
+            shard.changed = false;
+            ++shard.epoch;
+            for (InstrumentHandle instrument : shard.inbox)
+            {
+                auto it = shard.pairs_by_instrument.find(instrument);
+                if (it == shard.pairs_by_instrument.end())
+                {
+                    continue;
+                }
+                for (uint32_t index : it->second)
+                {
+                    if (shard.pairs[index].epoch != shard.epoch) // both legs may be dirty
+                    {
+                        shard.pairs[index].epoch = shard.epoch;
+                        evaluate_pair(shard, index, snapshot);
+                    }
+                }
+            }
+            shard.inbox.clear();
+        }
+
+        void StatisticalArbitrageSignalGenerator::evaluate_pair(PairShard &shard, uint32_t index, const MarketSnapshot &snapshot)
+        {
+            PairState &state = shard.pairs[index];
+            StatArbitrageSignal &signal = state.signal;
+            if (!snapshot.has_quote(signal.instrument_1) || !snapshot.has_quote(signal.instrument_2))
+            {
+                return;
+            }
+            double ratio = calculate_price_ratio(snapshot.mid_price(signal.instrument_1), snapshot.mid_price(signal.instrument_2));
+            if (!std::isfinite(ratio) || ratio <= 0.0)
+            {
+                return;
+            }
+
+            // Score against the window before this observation joins it
+            bool warm = state.ratio_history.size() >= params_.min_observation_window;
+            if (warm)
+            {
+                double mean = calculate_mean_ratio(state.ratio_history);
+                double std_dev = calculate_ratio_volatility(state.ratio_history, mean);
+                signal.price_ratio = ratio;
+                signal.mean_ratio = mean;
+                signal.ratio_std_dev = std_dev;
+                signal.z_score = calculate_z_score(ratio, mean, std_dev);
+                signal.correlation = calculate_correlation(signal.instrument_1, signal.instrument_2);
+                signal.half_life = calculate_half_life(state.ratio_history);
+                signal.signal_type = determine_signal_type(signal.z_score, entry_threshold_);
+                signal.signal_strength = calculate_signal_strength(signal.z_score, signal.correlation, signal.half_life);
+                signal.entry_threshold = entry_threshold_;
+                signal.exit_threshold = exit_threshold_;
+                signal.confidence_level = 1.0 - std::erfc(std::abs(signal.z_score) / std::sqrt(2.0));
+                signal.signal_time = snapshot.snapshot_time;
+            }
+            state.ratio_history.push(ratio);
+            if (!warm)
+            {
+                return;
+            }
+
+            // Enter at the entry threshold, stay open until |z| falls back to the exit threshold
+            if (state.active_position == NOT_ACTIVE)
+            {
+                if (is_valid_signal(signal))
+                {
+                    state.active_position = static_cast<uint32_t>(shard.active.size());
+                    shard.active.push_back(index);
+                    shard.changed = true;
+                    if (detection_callback_)
+                    {
+                        shard.detected.push_back(create_opportunity(signal));
+                    }
+                }
+            }
+            else if (std::abs(signal.z_score) <= exit_threshold_)
+            {
+                uint32_t moved = shard.active.back();
+                shard.active[state.active_position] = moved;
+                shard.pairs[moved].active_position = state.active_position;
+                shard.active.pop_back();
+                state.active_position = NOT_ACTIVE;
+                shard.changed = true;
+                if (expiry_callback_)
+                {
+                    shard.expired.push_back(create_opportunity(signal));
+                }
+            }
+            else
+            {
+                shard.changed = true; // open signal moved
+            }
+        }
+
+        void StatisticalArbitrageSignalGenerator::publish_signals()
+        {
+            active_signals_.update([this](std::vector<StatArbitrageSignal> &signals)
+                                   {
+                                       signals.clear();
+                                       for (const auto &shard : shards_)
+                                       {
+                                           for (uint32_t index : shard->active)
+                                           {
+                                               signals.push_back(shard->pairs[index].signal);
+                                           }
+                                       } });
+        }
+
+        MispricingOpportunity StatisticalArbitrageSignalGenerator::create_opportunity(const StatArbitrageSignal &signal) const
+        {
+            MispricingOpportunity opp;
+            opp.target_instrument = signal.instrument_1;
+            opp.component_instruments = {signal.instrument_1, signal.instrument_2};
+            // SHORT_SPREAD: the ratio is rich, sell the first leg and buy the second
+            bool short_spread = signal.z_score > 0.0;
+            opp.weights = {short_spread ? -1.0 : 1.0, short_spread ? 1.0 : -1.0};
+            opp.type = MispricingType::STATISTICAL_ARBITRAGE;
+
+            double z = std::abs(signal.z_score);
+            opp.severity = z >= 2.0 * entry_threshold_   ? MispricingSeverity::HIGH
+                           : z >= 1.5 * entry_threshold_ ? MispricingSeverity::MEDIUM
+                                                         : MispricingSeverity::LOW;
+            opp.market_price = signal.price_ratio;
+            opp.theoretical_price = signal.mean_ratio;
+            opp.deviation_percentage = signal.mean_ratio > 0.0 ? (signal.price_ratio - signal.mean_ratio) / signal.mean_ratio : 0.0;
+            opp.z_score = signal.z_score;
+            opp.confidence_level = signal.confidence_level;
+            opp.expected_profit = std::abs(opp.deviation_percentage) * params_.liquidity_threshold;
+            opp.detection_time = signal.signal_time;
+            opp.expiry_time = opp.detection_time + params_.max_opportunity_duration;
+            return opp;
+        }
+
+        double StatisticalArbitrageSignalGenerator::calculate_price_ratio(Price price1, Price price2) const
+        {
+            return price2 > 0.0 ? price1 / price2 : 0.0;
+        }
+
+        double StatisticalArbitrageSignalGenerator::calculate_z_score(double current_ratio, double mean_ratio, double std_dev) const
+        {
+            return std_dev > 0.0 ? (current_ratio - mean_ratio) / std_dev : 0.0;
+        }
+
+        std::string StatisticalArbitrageSignalGenerator::determine_signal_type(double z_score, double entry_threshold) const
+        {
+            if (z_score >= entry_threshold)
+                return "SHORT_SPREAD";
+            if (z_score <= -entry_threshold)
+                return "LONG_SPREAD";
+            return "NEUTRAL";
+        }
+
+        double StatisticalArbitrageSignalGenerator::calculate_signal_strength(double z_score, double correlation, double half_life) const
+        {
+            // Simplified scoring: stretch of the spread, scaled down for weakly correlated or
+            // non-mean-reverting pairs
+            double stretch = std::min(1.0, std::abs(z_score) / (2.0 * entry_threshold_));
+            double coupling = correlation_matrix_ ? 0.5 + 0.5 * std::abs(correlation) : 1.0;
+            double reversion = std::isfinite(half_life) ? 1.0 : 0.5;
+            return stretch * coupling * reversion;
+        }
+
+        bool StatisticalArbitrageSignalGenerator::is_valid_signal(const StatArbitrageSignal &signal) const
+        {
+            return signal.signal_type != "NEUTRAL" && signal.ratio_std_dev > 0.0 &&
+                   signal.confidence_level >= params_.min_confidence_level;
+        }
+
+        double StatisticalArbitrageSignalGenerator::calculate_mean_ratio(const RollingStatistics &ratio_history) const
+        {
+            return ratio_history.mean();
+        }
+
+        double StatisticalArbitrageSignalGenerator::calculate_ratio_volatility(const RollingStatistics &ratio_history, double mean) const
+        {
+            if (ratio_history.size() < 2)
+                return 0.0;
+
+            // Dispersion around the supplied mean: var + (window mean - mean)^2
+            double offset = ratio_history.mean() - mean;
+            return std::sqrt(ratio_history.variance() + offset * offset);
+        }
+
+        double StatisticalArbitrageSignalGenerator::calculate_correlation(InstrumentHandle instrument1,
+                                                                          InstrumentHandle instrument2) const
+        {
+            // Maintained incrementally by the shared matrix's writer; no recomputation here
+            return correlation_matrix_ ? correlation_matrix_->correlation(instrument1, instrument2) : 0.0;
+        }
+
+        double StatisticalArbitrageSignalGenerator::calculate_half_life(const RollingStatistics &ratio_history) const
+        {
+            // AR(1) fit of the ratio: x[t] = phi * x[t-1] + e, half-life = -ln(2) / ln(phi)
+            if (ratio_history.size() < 3)
+                return std::numeric_limits<double>::infinity();
+
+            double phi = ratio_history.lag1_autocorrelation();
+            if (phi <= 0.0 || phi >= 1.0)
+                return std::numeric_limits<double>::infinity(); // not mean reverting
+
+            return -std::log(2.0) / std::log(phi);
+        }
+
+        // CrossExchangeSyntheticPriceComparator implementation
+        namespace
+        {
+            MispricingOpportunity to_mispricing(const CrossExchangeOpportunity &cross, const DetectionParameters &params)
+            {
+                MispricingOpportunity opp;
+                opp.target_instrument = cross.instrument;
+                opp.component_instruments = {cross.instrument};
+                opp.weights = {1.0};
+                opp.type = MispricingType::CROSS_EXCHANGE_ARBITRAGE;
+                opp.severity = cross.percentage_spread > 4.0 * params.min_deviation_threshold   ? MispricingSeverity::HIGH
+                               : cross.percentage_spread > 2.0 * params.min_deviation_threshold ? MispricingSeverity::MEDIUM
+                                                                                                : MispricingSeverity::LOW;
+                opp.market_price = cross.price_1;      // buy venue
+                opp.theoretical_price = cross.price_2; // sell venue
+                opp.deviation_percentage = cross.percentage_spread;
+                opp.confidence_level = cross.execution_probability;
+                opp.expected_profit = cross.expected_profit;
+                opp.detection_time = cross.detection_time;
+                opp.expiry_time = cross.detection_time + params.max_opportunity_duration;
+                return opp;
+            }
+
+            bool same_venues(const CrossExchangeOpportunity &a, const CrossExchangeOpportunity &b)
+            {
+                return a.instrument == b.instrument && a.exchange_1 == b.exchange_1 && a.exchange_2 == b.exchange_2;
+            }
+        }
+
+        CrossExchangeSyntheticPriceComparator::CrossExchangeSyntheticPriceComparator(
+            std::unique_ptr<IPricingModel> model, const DetectionParameters &params)
+            : params_(params), pricing_model_(std::move(model)), price_matrix_(std::make_shared<VenuePriceMatrix>()) {}
+
+        // Each pass replaces the open set: an opportunity keeps its detection time while its
+        // venues stay crossed and expires when they no longer are
+        void CrossExchangeSyntheticPriceComparator::update_market_data(const MarketSnapshot &)
+        {
+            std::vector<CrossExchangeOpportunity> found = compare_synthetic_prices_across_exchanges();
+            std::vector<MispricingOpportunity> detected;
+            std::vector<MispricingOpportunity> expired;
+            {
+                std::lock_guard<std::mutex> lock(opportunities_mutex_);
+                for (auto &opportunity : found)
+                {
+                    auto open = std::find_if(active_opportunities_.begin(), active_opportunities_.end(),
+                                             [&](const CrossExchangeOpportunity &o) { return same_venues(o, opportunity); });
+                    if (open != active_opportunities_.end())
+                    {
+                        opportunity.detection_time = open->detection_time;
+                    }
+                    else if (detection_callback_)
+                    {
+                        detected.push_back(to_mispricing(opportunity, params_));
+                    }
+                }
+                if (expiry_callback_)
+                {
+                    for (const auto &opportunity : active_opportunities_)
+                    {
+                        if (std::none_of(found.begin(), found.end(),
+                                         [&](const CrossExchangeOpportunity &o) { return same_venues(o, opportunity); }))
+                        {
+                            expired.push_back(to_mispricing(opportunity, params_));
+                        }
+                    }
+                }
+                active_opportunities_.swap(found);
+            }
+
+            for (const auto &opp : expired)
+            {
+                expiry_callback_(opp);
+            }
+            for (const auto &opp : detected)
+            {
+                detection_callback_(opp);
+            }
+        }
+
+        std::vector<MispricingOpportunity> CrossExchangeSyntheticPriceComparator::detect_opportunities()
+        {
+            std::lock_guard<std::mutex> lock(opportunities_mutex_);
+            std::vector<MispricingOpportunity> opportunities;
+            opportunities.reserve(active_opportunities_.size());
+            for (const auto &opportunity : active_opportunities_)
+            {
+                opportunities.push_back(to_mispricing(opportunity, params_));
+            }
+            return opportunities;
+        }
+
+        void CrossExchangeSyntheticPriceComparator::set_detection_callback(MispricingCallback callback)
+        {
+            detection_callback_ = callback;
+        }
+
+        void CrossExchangeSyntheticPriceComparator::set_expiry_callback(MispricingExpiredCallback callback)
+        {
+            expiry_callback_ = callback;
+        }
+
+        void CrossExchangeSyntheticPriceComparator::update_parameters(const DetectionParameters &params)
+        {
+            params_ = params;
+        }
+
+        void CrossExchangeSyntheticPriceComparator::register_exchange_feed(const std::string &exchange_id)
+        {
+            // Costs are set by whoever owns them (the replication engine, when the matrix is shared)
+            if (price_matrix_->venue_index(exchange_id) == INVALID_VENUE)
+            {
+                price_matrix_->add_venue(exchange_id, 0.0, 0.0);
+            }
+        }
+
+        void CrossExchangeSyntheticPriceComparator::update_exchange_snapshot(const std::string &exchange_id,
+                                                                             const MarketSnapshot &snapshot)
+        {
+            register_exchange_feed(exchange_id);
+            price_matrix_->apply_snapshot(price_matrix_->venue_index(exchange_id), snapshot);
+        }
+
+        void CrossExchangeSyntheticPriceComparator::set_synthetic_components(InstrumentHandle target,
+                                                                             const std::vector<InstrumentHandle> &components)
+        {
+            price_matrix_->set_components(target, components);
+        }
+
+        std::vector<CrossExchangeOpportunity> CrossExchangeSyntheticPriceComparator::get_synthetic_price_opportunities() const
+        {
+            std::lock_guard<std::mutex> lock(opportunities_mutex_);
+            return active_opportunities_;
+        }
+
+        SyntheticPrice CrossExchangeSyntheticPriceComparator::get_best_synthetic_price(InstrumentHandle instrument) const
+        {
+            // Cheapest venue to buy the replica on, after fees and latency
+            refresh_synthetic_prices();
+            VenuePriceSource source = price_matrix_->is_target(instrument) ? VenuePriceSource::SYNTHETIC
+                                                                           : VenuePriceSource::QUOTES;
+            VenueBest best = price_matrix_->best(source, instrument);
+            if (best.ask_venue == INVALID_VENUE)
+            {
+                return SyntheticPrice();
+            }
+            return price_matrix_->replication(source, best.ask_venue, instrument);
+        }
+
+        std::map<std::string, SyntheticPrice> CrossExchangeSyntheticPriceComparator::get_all_exchange_synthetic_prices(
+            InstrumentHandle instrument) const
+        {
+            // Read from the shared cells; only stale ones are repriced
+            refresh_synthetic_prices();
+            VenuePriceSource source = price_matrix_->is_target(instrument) ? VenuePriceSource::SYNTHETIC
+                                                                           : VenuePriceSource::QUOTES;
+            std::map<std::string, SyntheticPrice> prices;
+            for (VenueIndex venue = 0; venue < price_matrix_->venue_count(); ++venue)
+            {
+                SyntheticPrice price = price_matrix_->replication(source, venue, instrument);
+                if (price.theoretical_price > 0.0)
+                {
+                    prices.emplace(price_matrix_->venue_id(venue), std::move(price));
+                }
+            }
+            return prices;
+        }
+
+        void CrossExchangeSyntheticPriceComparator::refresh_synthetic_prices() const
+        {
+            price_matrix_->refresh_synthetics([this](VenueIndex venue, InstrumentHandle target,
+                                                     const std::vector<InstrumentHandle> &)
+                                              { return calculate_synthetic_price_for_exchange(target, venue); });
+        }
+
+        SyntheticPrice CrossExchangeSyntheticPriceComparator::calculate_synthetic_price_for_exchange(
+            InstrumentHandle instrument, VenueIndex exchange) const
+        {
+            SyntheticPrice price = pricing_model_->calculate_synthetic_price(
+                instrument, price_matrix_->components(instrument), price_matrix_->snapshot(exchange));
+            price.confidence_score = calculate_synthetic_price_confidence(price);
+            return price;
+        }
+
+        // Buys where the instrument (or its replica) is cheapest and sells where it is richest;
+        // the matrix scans every instrument's venues in one pass
+        std::vector<CrossExchangeOpportunity> CrossExchangeSyntheticPriceComparator::compare_synthetic_prices_across_exchanges()
+        {
+            std::vector<CrossExchangeOpportunity> opportunities;
+            VenuePriceMatrix &matrix = *price_matrix_;
+            if (matrix.venue_count() < 2)
+            {
+                return opportunities;
+            }
+            refresh_synthetic_prices();
+
+            const VenueScan &quotes = matrix.scan(VenuePriceSource::QUOTES);
+            const VenueScan &synthetics = matrix.scan(VenuePriceSource::SYNTHETIC);
+            for (InstrumentHandle instrument = 0; instrument < quotes.size(); ++instrument)
+            {
+                VenuePriceSource source = matrix.is_target(instrument) ? VenuePriceSource::SYNTHETIC
+                                                                       : VenuePriceSource::QUOTES;
+                VenueBest best = (source == VenuePriceSource::SYNTHETIC ? synthetics : quotes).at(instrument);
+                if (best.bid_venue == INVALID_VENUE || best.ask_venue == INVALID_VENUE || best.bid <= best.ask)
+                {
+                    continue;
+                }
+                if (best.bid_venue == best.ask_venue)
+                {
+                    VenueBest other = matrix.best(source, instrument, best.ask_venue);
+                    if (other.bid_venue == INVALID_VENUE || other.bid <= best.ask)
+                    {
+                        continue;
+                    }
+                    best.bid_venue = other.bid_venue;
+                    best.bid = other.bid;
+                }
+
+                SyntheticPrice buy = matrix.replication(source, best.ask_venue, instrument);
+                SyntheticPrice sell = matrix.replication(source, best.bid_venue, instrument);
+                if (!validate_synthetic_construction_quality(buy) || !validate_synthetic_construction_quality(sell))
+                {
+                    continue;
+                }
+
+                CrossExchangeOpportunity opportunity;
+                opportunity.instrument = instrument;
+                opportunity.exchange_1 = matrix.venue_id(best.ask_venue);
+                opportunity.exchange_2 = matrix.venue_id(best.bid_venue);
+                opportunity.price_1 = buy.ask_price;
+                opportunity.price_2 = sell.bid_price;
+                opportunity.price_spread = calculate_cross_exchange_spread(buy, sell);
+                opportunity.percentage_spread = (best.bid - best.ask) / best.ask; // net of venue costs
+                if (opportunity.percentage_spread < params_.min_deviation_threshold)
+                {
+                    continue;
+                }
+
+                opportunity.available_volume = std::min(matrix.available_size(source, best.ask_venue, instrument, true),
+                                                        matrix.available_size(source, best.bid_venue, instrument, false));
+                opportunity.expected_profit = opportunity.price_spread * opportunity.available_volume -
+                                              estimate_cross_exchange_execution_cost(opportunity);
+                opportunity.required_capital = opportunity.price_1 * opportunity.available_volume;
+                opportunity.capital_efficiency_ratio = opportunity.required_capital > 0.0
+                                                           ? opportunity.expected_profit / opportunity.required_capital
+                                                           : 0.0;
+                opportunity.execution_probability = std::min(buy.confidence_score, sell.confidence_score);
+                opportunity.window_duration = params_.max_opportunity_duration;
+                opportunities.push_back(std::move(opportunity));
+            }
+            return opportunities;
+        }
+
+        double CrossExchangeSyntheticPriceComparator::calculate_cross_exchange_spread(const SyntheticPrice &price1,
+                                                                                       const SyntheticPrice &price2) const
+        {
+            // Buying at the first and selling at the second, before costs
+            return price2.bid_price - price1.ask_price;
+        }
+
+        bool CrossExchangeSyntheticPriceComparator::validate_synthetic_construction_quality(const SyntheticPrice &synthetic_price) const
+        {
+            if (synthetic_price.bid_price <= 0.0 || synthetic_price.ask_price < synthetic_price.bid_price)
+            {
+                return false;
+            }
+            double mid = (synthetic_price.bid_price + synthetic_price.ask_price) / 2.0;
+            return (synthetic_price.ask_price - synthetic_price.bid_price) / mid <= params_.max_spread_ratio &&
+                   synthetic_price.confidence_score >= params_.min_confidence_level;
+        }
+
+        double CrossExchangeSyntheticPriceComparator::estimate_cross_exchange_execution_cost(const CrossExchangeOpportunity &opportunity) const
+        {
+            // Fees and latency cost on both venues, over the tradable volume
+            const VenuePriceMatrix &matrix = *price_matrix_;
+            VenueIndex buy_venue = matrix.venue_index(opportunity.exchange_1);
+            VenueIndex sell_venue = matrix.venue_index(opportunity.exchange_2);
+            if (buy_venue == INVALID_VENUE || sell_venue == INVALID_VENUE)
+            {
+                return 0.0;
+            }
+            return (matrix.venue_cost(buy_venue) * opportunity.price_1 + matrix.venue_cost(sell_venue) * opportunity.price_2) *
+                   opportunity.available_volume;
+        }
+
+        double CrossExchangeSyntheticPriceComparator::calculate_synthetic_price_confidence(const SyntheticPrice &synthetic_price) const
+        {
+            // The model's own score, discounted by how wide the replica trades relative to the
+            // widest spread we accept
+            if (synthetic_price.theoretical_price <= 0.0)
+            {
+                return 0.0;
+            }
+            double width = std::max(synthetic_price.ask_price - synthetic_price.bid_price, 0.0) / synthetic_price.theoretical_price;
+            double discount = params_.max_spread_ratio > 0.0 ? std::min(1.0, width / params_.max_spread_ratio) : 0.0;
+            return std::clamp(synthetic_price.confidence_score, 0.0, 1.0) * (1.0 - 0.1 * discount);
         }
 
     } // namespace mispricing
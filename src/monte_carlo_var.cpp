@@ -0,0 +1,600 @@
+#include "monte_carlo_var.hpp"
+#include "linear_algebra.hpp"
+#include "option_batch_pricing.hpp"
+#include "path_batch_kernel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+namespace spe
+{
+    namespace exposure
+    {
+
+        namespace
+        {
+            constexpr double UNIT_32 = 1.0 / 4294967296.0;
+            constexpr double MAX_CORRELATION = 0.999;
+            constexpr size_t TASKS_PER_THREAD = 4;
+
+            constexpr size_t SUBSPACE_ITERATIONS = 10;
+            constexpr size_t QUADS = MonteCarloVarEngine::BATCH_SHOCKS / 4;
+
+            // The uniform in (0, 1) the kernels draw for one lane of one row of a batch: word
+            // lane / QUADS of counter (batch, row, lane % QUADS)
+            double uniform(size_t batch, size_t row, size_t lane, uint32_t key0, uint32_t key1)
+            {
+                Philox4x32::Counter bits = Philox4x32::generate(
+                    {uint32_t(batch), uint32_t(uint64_t(batch) >> 32), uint32_t(row), uint32_t(lane % QUADS)}, key0, key1);
+                return (bits[lane / QUADS] + 0.5) * UNIT_32;
+            }
+
+            // Orthonormal columns, stored column-major (column k at k * n), by modified Gram-Schmidt
+            // run twice; a column that vanishes against the earlier ones is left at zero
+            void orthonormalize(std::vector<double> &columns, size_t n, size_t k)
+            {
+                for (size_t c = 0; c < k; ++c)
+                {
+                    double *column = columns.data() + c * n;
+                    for (int pass = 0; pass < 2; ++pass)
+                    {
+                        for (size_t p = 0; p < c; ++p)
+                        {
+                            const double *previous = columns.data() + p * n;
+                            double projection = linalg::dot(column, previous, n);
+                            for (size_t i = 0; i < n; ++i)
+                            {
+                                column[i] -= projection * previous[i];
+                            }
+                        }
+                    }
+                    double norm = std::sqrt(linalg::dot(column, column, n));
+                    double scale = norm > 1e-12 ? 1.0 / norm : 0.0;
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        column[i] *= scale;
+                    }
+                }
+            }
+
+            // Cyclic Jacobi on a small symmetric k x k matrix, row-major: eigenvalues are left on
+            // its diagonal and eigenvectors in the columns of vectors
+            void symmetric_eigen(std::vector<double> &a, std::vector<double> &vectors, size_t k)
+            {
+                vectors.assign(k * k, 0.0);
+                for (size_t i = 0; i < k; ++i)
+                {
+                    vectors[i * k + i] = 1.0;
+                }
+                for (int sweep = 0; sweep < 64; ++sweep)
+                {
+                    bool rotated = false;
+                    for (size_t p = 0; p < k; ++p)
+                    {
+                        for (size_t q = p + 1; q < k; ++q)
+                        {
+                            double apq = a[p * k + q];
+                            if (std::abs(apq) <= 1e-15 * (std::abs(a[p * k + p]) + std::abs(a[q * k + q])) ||
+                                std::abs(apq) < 1e-300)
+                            {
+                                continue;
+                            }
+                            rotated = true;
+                            double theta = (a[q * k + q] - a[p * k + p]) / (2.0 * apq);
+                            double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                            double c = 1.0 / std::sqrt(t * t + 1.0);
+                            double s = t * c;
+                            for (size_t r = 0; r < k; ++r)
+                            {
+                                double arp = a[r * k + p];
+                                double arq = a[r * k + q];
+                                a[r * k + p] = c * arp - s * arq;
+                                a[r * k + q] = s * arp + c * arq;
+                            }
+                            for (size_t r = 0; r < k; ++r)
+                            {
+                                double apr = a[p * k + r];
+                                double aqr = a[q * k + r];
+                                a[p * k + r] = c * apr - s * aqr;
+                                a[q * k + r] = s * apr + c * aqr;
+                            }
+                            for (size_t r = 0; r < k; ++r)
+                            {
+                                double vrp = vectors[r * k + p];
+                                double vrq = vectors[r * k + q];
+                                vectors[r * k + p] = c * vrp - s * vrq;
+                                vectors[r * k + q] = s * vrp + c * vrq;
+                            }
+                        }
+                    }
+                    if (!rotated)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            // Widest kernel the CPU runs, as for option chains
+            void simulate_batch_simd(const detail::PathBatchKernelArgs &args)
+            {
+                pricing::SimdLevel level = pricing::active_simd_level();
+                if (level == pricing::SimdLevel::AVX512 && detail::simulate_batch_avx512(args))
+                {
+                    return;
+                }
+                if (level >= pricing::SimdLevel::AVX2 && detail::simulate_batch_avx2(args))
+                {
+                    return;
+                }
+                detail::simulate_batch_scalar(args);
+            }
+
+            double normal_density(double x)
+            {
+                return 0.3989422804014327 * std::exp(-0.5 * x * x);
+            }
+        }
+
+        // Acklam's rational approximation
+        double normal_quantile(double p)
+        {
+            static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                                       1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+            static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                                       6.680131188771972e+01, -1.328068155288572e+01};
+            static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                                       -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+            static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                                       3.754408661907416e+00};
+            const double low = 0.02425;
+
+            if (p <= 0.0)
+            {
+                return -INFINITY;
+            }
+            if (p >= 1.0)
+            {
+                return INFINITY;
+            }
+            if (p < low || p > 1.0 - low)
+            {
+                double q = std::sqrt(-2.0 * std::log(p < low ? p : 1.0 - p));
+                double x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+                           ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+                return p < low ? x : -x;
+            }
+            double q = p - 0.5;
+            double r = q * q;
+            return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+                   (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+        }
+
+        MonteCarloVarEngine::MonteCarloVarEngine(const MonteCarloConfig &config)
+            : config_(config), execution_mode_(concurrency::ExecutionMode::SEQUENTIAL), components_(0),
+              correlation_shrinkage_(0.0) {}
+
+        void MonteCarloVarEngine::set_execution_mode(concurrency::ExecutionMode mode,
+                                                     std::shared_ptr<concurrency::WorkStealingPool> pool)
+        {
+            execution_mode_ = mode;
+            pool_ = std::move(pool);
+        }
+
+        void MonteCarloVarEngine::set_factors(const std::vector<InstrumentHandle> &instruments,
+                                              const std::vector<double> &daily_volatilities,
+                                              const stats::StreamingCorrelationMatrix *correlations)
+        {
+            for (InstrumentHandle instrument : factors_)
+            {
+                factor_by_instrument_[instrument] = UINT32_MAX;
+            }
+            factors_ = instruments;
+            for (size_t i = 0; i < factors_.size(); ++i)
+            {
+                if (factors_[i] >= factor_by_instrument_.size())
+                {
+                    factor_by_instrument_.resize(factors_[i] + 1, UINT32_MAX);
+                }
+                factor_by_instrument_[factors_[i]] = static_cast<uint32_t>(i);
+            }
+
+            size_t n = factors_.size();
+            bool use_matrix = correlations && correlations->observation_count() >= 2;
+            std::vector<double> correlation(n * n, 0.0);
+            for (size_t i = 0; i < n; ++i)
+            {
+                correlation[i * n + i] = 1.0;
+                for (size_t j = 0; j < i; ++j)
+                {
+                    double rho = 0.0;
+                    if (use_matrix && correlations->contains(factors_[i]) && correlations->contains(factors_[j]))
+                    {
+                        rho = correlations->correlation(factors_[i], factors_[j]);
+                        rho = std::isfinite(rho) ? std::max(-MAX_CORRELATION, std::min(rho, MAX_CORRELATION)) : 0.0;
+                    }
+                    correlation[i * n + j] = rho;
+                    correlation[j * n + i] = rho;
+                }
+            }
+
+            correlation_shrinkage_ = 0.0;
+            if (n > config_.max_components)
+            {
+                principal_components(correlation, daily_volatilities);
+                return;
+            }
+
+            // Shrink (1 - lambda) C + lambda I until it factors; the identity always does
+            while (!factorize(correlation, daily_volatilities))
+            {
+                double next = correlation_shrinkage_ == 0.0 ? 0.01 : std::min(1.0, 2.0 * correlation_shrinkage_);
+                double keep = (1.0 - next) / (1.0 - correlation_shrinkage_);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    for (size_t j = 0; j < n; ++j)
+                    {
+                        if (i != j)
+                        {
+                            correlation[i * n + j] *= keep;
+                        }
+                    }
+                }
+                correlation_shrinkage_ = next;
+            }
+        }
+
+        bool MonteCarloVarEngine::factorize(const std::vector<double> &correlations, const std::vector<double> &volatilities)
+        {
+            size_t n = factors_.size();
+            components_ = n;
+            residual_volatilities_.clear();
+            loadings_.assign(n * n, 0.0);
+            for (size_t i = 0; i < n; ++i)
+            {
+                for (size_t j = 0; j <= i; ++j)
+                {
+                    double sum = correlations[i * n + j];
+                    for (size_t k = 0; k < j; ++k)
+                    {
+                        sum -= loadings_[i * n + k] * loadings_[j * n + k];
+                    }
+                    if (i == j)
+                    {
+                        if (sum <= 1e-10)
+                        {
+                            return false;
+                        }
+                        loadings_[i * n + i] = std::sqrt(sum);
+                    }
+                    else
+                    {
+                        loadings_[i * n + j] = sum / loadings_[j * n + j];
+                    }
+                }
+            }
+
+            // Scale row i by the factor's horizon volatility: L L^T is then the covariance
+            double horizon = static_cast<double>(std::max<size_t>(config_.horizon_days, 1));
+            drifts_.resize(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                double sigma = (i < volatilities.size() ? volatilities[i] : 0.0) * std::sqrt(horizon);
+                for (size_t k = 0; k <= i; ++k)
+                {
+                    loadings_[i * n + k] *= sigma;
+                }
+                drifts_[i] = -0.5 * sigma * sigma;
+            }
+            return true;
+        }
+
+        void MonteCarloVarEngine::principal_components(const std::vector<double> &correlations,
+                                                       const std::vector<double> &volatilities)
+        {
+            size_t n = factors_.size();
+            size_t k = config_.max_components;
+            components_ = k;
+
+            // Subspace iteration from a fixed pseudo-random start, so the model is reproducible
+            std::vector<double> basis(n * k);
+            for (size_t c = 0; c < k; ++c)
+            {
+                for (size_t i = 0; i < n; ++i)
+                {
+                    basis[c * n + i] = Philox4x32::generate({uint32_t(c), uint32_t(i), 0, 0}, 0x5eed, 0)[0] * UNIT_32 - 0.5;
+                }
+            }
+            orthonormalize(basis, n, k);
+            std::vector<double> image(n * k);
+            auto apply = [&]()
+            {
+                for (size_t c = 0; c < k; ++c)
+                {
+                    const double *column = basis.data() + c * n;
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        image[c * n + i] = linalg::dot(column, correlations.data() + i * n, n);
+                    }
+                }
+            };
+            for (size_t iteration = 0; iteration < SUBSPACE_ITERATIONS; ++iteration)
+            {
+                apply();
+                basis.swap(image);
+                orthonormalize(basis, n, k);
+            }
+
+            // Rayleigh-Ritz: the eigenpairs of the correlations projected on the subspace
+            apply();
+            std::vector<double> projected(k * k);
+            for (size_t a = 0; a < k; ++a)
+            {
+                for (size_t b = 0; b < k; ++b)
+                {
+                    projected[a * k + b] = linalg::dot(basis.data() + a * n, image.data() + b * n, n);
+                }
+            }
+            std::vector<double> rotation;
+            symmetric_eigen(projected, rotation, k);
+
+            // Loading of instrument i on component c is sigma_i sqrt(lambda_c) (Q U)_ic; the
+            // residual carries whatever of its variance the components leave
+            double horizon = static_cast<double>(std::max<size_t>(config_.horizon_days, 1));
+            loadings_.assign(n * k, 0.0);
+            residual_volatilities_.assign(n, 0.0);
+            drifts_.resize(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                double sigma = (i < volatilities.size() ? volatilities[i] : 0.0) * std::sqrt(horizon);
+                double explained = 0.0;
+                for (size_t c = 0; c < k; ++c)
+                {
+                    double vector = 0.0;
+                    for (size_t b = 0; b < k; ++b)
+                    {
+                        vector += basis[b * n + i] * rotation[b * k + c];
+                    }
+                    double loading = vector * std::sqrt(std::max(projected[c * k + c], 0.0));
+                    explained += loading * loading;
+                    loadings_[i * k + c] = sigma * loading;
+                }
+                residual_volatilities_[i] = sigma * std::sqrt(std::max(1.0 - explained, 0.0));
+                drifts_[i] = -0.5 * sigma * sigma;
+            }
+        }
+
+        void MonteCarloVarEngine::simulate_batch(size_t batch, std::vector<double> &scratch)
+        {
+            constexpr size_t S = BATCH_SHOCKS;
+            size_t n = factors_.size();
+            size_t paths = paths_per_batch();
+            double *shocks = scratch.data();               // (components + n) x S, row-major
+            double *loss = shocks + (components_ + n) * S; // paths
+            double *linear = loss + paths;                 // paths
+
+            simulate_batch_simd({n, components_, S, config_.antithetic, residual_volatilities_.empty(), loadings_.data(),
+                                 residual_volatilities_.empty() ? nullptr : residual_volatilities_.data(),
+                                 factor_notionals_.data(), drifts_.data(), batch, uint32_t(config_.seed),
+                                 uint32_t(config_.seed >> 32), shocks, loss, linear});
+
+            // Moments per batch, summed in batch order later so the result is thread-independent
+            double moments[4] = {0.0, 0.0, 0.0, 0.0};
+            for (size_t j = 0; j < paths; ++j)
+            {
+                moments[0] += loss[j];
+                moments[1] += linear[j];
+                moments[2] += loss[j] * linear[j];
+                moments[3] += linear[j] * linear[j];
+            }
+            std::copy(loss, loss + paths, losses_.begin() + batch * paths);
+            std::copy(linear, linear + paths, linear_losses_.begin() + batch * paths);
+            std::copy(moments, moments + 4, batch_moments_.begin() + batch * 4);
+        }
+
+        void MonteCarloVarEngine::path_returns(size_t path, std::vector<double> &shocks, std::vector<double> &returns) const
+        {
+            size_t n = factors_.size();
+            size_t batch = path / paths_per_batch();
+            size_t lane = path % paths_per_batch();
+            double sign = lane >= BATCH_SHOCKS ? -1.0 : 1.0;
+            lane %= BATCH_SHOCKS;
+            uint32_t key0 = uint32_t(config_.seed);
+            uint32_t key1 = uint32_t(config_.seed >> 32);
+
+            for (size_t k = 0; k < components_; ++k)
+            {
+                shocks[k] = normal_quantile(uniform(batch, k, lane, key0, key1));
+            }
+            bool triangular = residual_volatilities_.empty();
+            for (size_t i = 0; i < n; ++i)
+            {
+                const double *l = loadings_.data() + i * components_;
+                size_t used = triangular ? i + 1 : components_;
+                double x = 0.0;
+                for (size_t k = 0; k < used; ++k)
+                {
+                    x += l[k] * shocks[k];
+                }
+                if (!triangular && factor_notionals_[i] != 0.0 && residual_volatilities_[i] != 0.0)
+                {
+                    x += residual_volatilities_[i] * normal_quantile(uniform(batch, components_ + i, lane, key0, key1));
+                }
+                returns[i] = sign * x;
+            }
+        }
+
+        MonteCarloRiskResult MonteCarloVarEngine::run(const std::vector<RiskExposure> &exposures, double confidence_level,
+                                                      std::vector<double> *losses)
+        {
+            MonteCarloRiskResult result;
+            result.var_contributions.assign(exposures.size(), 0.0);
+            result.es_contributions.assign(exposures.size(), 0.0);
+
+            size_t n = factors_.size();
+            factor_notionals_.assign(n, 0.0);
+            for (const auto &exposure : exposures)
+            {
+                if (has_factor(exposure.instrument))
+                {
+                    factor_notionals_[factor_by_instrument_[exposure.instrument]] += exposure.notional;
+                }
+            }
+
+            size_t per_batch = paths_per_batch();
+            size_t batches = std::max<size_t>((config_.paths + per_batch - 1) / per_batch, 1);
+            size_t total = batches * per_batch;
+            losses_.resize(total);
+            linear_losses_.resize(total);
+            batch_moments_.resize(batches * 4);
+
+            size_t tasks = 1;
+            if (execution_mode_ == concurrency::ExecutionMode::PARALLEL && pool_)
+            {
+                tasks = std::min(batches, (pool_->thread_count() + 1) * TASKS_PER_THREAD);
+            }
+            if (task_scratch_.size() < tasks)
+            {
+                task_scratch_.resize(tasks);
+            }
+            for (size_t t = 0; t < tasks; ++t)
+            {
+                task_scratch_[t].resize((components_ + n) * BATCH_SHOCKS + 2 * per_batch);
+            }
+            concurrency::run_tasks(execution_mode_, pool_.get(), tasks,
+                                   [&](size_t task)
+                                   {
+                                       size_t end = (task + 1) * batches / tasks;
+                                       for (size_t batch = task * batches / tasks; batch < end; ++batch)
+                                       {
+                                           simulate_batch(batch, task_scratch_[task]);
+                                       }
+                                   });
+
+            // The tail is the worst m paths: VaR is the m-th largest loss, ES their mean
+            double tail_probability = std::min(std::max(1.0 - confidence_level, 0.0), 1.0);
+            size_t m = std::min(std::max<size_t>(static_cast<size_t>(std::ceil(tail_probability * total - 1e-9)), 1), total);
+            ranked_paths_.resize(total);
+            std::iota(ranked_paths_.begin(), ranked_paths_.end(), 0u);
+            std::nth_element(ranked_paths_.begin(), ranked_paths_.begin() + (m - 1), ranked_paths_.end(),
+                             [this](uint32_t a, uint32_t b)
+                             {
+                                 return losses_[a] > losses_[b] || (losses_[a] == losses_[b] && a < b);
+                             });
+            double simulated_var = losses_[ranked_paths_[m - 1]];
+            double simulated_es = 0.0;
+            for (size_t i = 0; i < m; ++i)
+            {
+                simulated_es += losses_[ranked_paths_[i]];
+            }
+            simulated_es /= static_cast<double>(m);
+
+            result.value_at_risk = simulated_var;
+            result.expected_shortfall = simulated_es;
+            result.paths = total;
+            result.tail_paths = m;
+
+            if (config_.control_variate)
+            {
+                double sums[4] = {0.0, 0.0, 0.0, 0.0};
+                for (size_t batch = 0; batch < batches; ++batch)
+                {
+                    for (int s = 0; s < 4; ++s)
+                    {
+                        sums[s] += batch_moments_[batch * 4 + s];
+                    }
+                }
+                double count = static_cast<double>(total);
+                double covariance = sums[2] - sums[0] * sums[1] / count;
+                double variance = sums[3] - sums[1] * sums[1] / count;
+
+                // Linear loss is N(0, e' S e) with S = B B' + diag(s^2): |B' e|^2 plus the residuals
+                double linear_variance = 0.0;
+                for (size_t k = 0; k < components_; ++k)
+                {
+                    double w = 0.0;
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        w += loadings_[i * components_ + k] * factor_notionals_[i];
+                    }
+                    linear_variance += w * w;
+                }
+                for (size_t i = 0; i < residual_volatilities_.size(); ++i)
+                {
+                    double w = residual_volatilities_[i] * factor_notionals_[i];
+                    linear_variance += w * w;
+                }
+
+                if (variance > 0.0 && linear_variance > 0.0)
+                {
+                    double beta = covariance / variance;
+                    double sigma = std::sqrt(linear_variance);
+                    double realized_tail = static_cast<double>(m) / count;
+                    double z = normal_quantile(1.0 - realized_tail);
+                    double exact_var = sigma * z;
+                    double exact_es = sigma * normal_density(z) / realized_tail;
+
+                    std::nth_element(linear_losses_.begin(), linear_losses_.begin() + (m - 1), linear_losses_.end(),
+                                     std::greater<double>());
+                    double linear_var = linear_losses_[m - 1];
+                    double linear_es = 0.0;
+                    for (size_t i = 0; i < m; ++i)
+                    {
+                        linear_es += linear_losses_[i];
+                    }
+                    linear_es /= static_cast<double>(m);
+
+                    result.control_beta = beta;
+                    result.value_at_risk = simulated_var - beta * (linear_var - exact_var);
+                    result.expected_shortfall = simulated_es - beta * (linear_es - exact_es);
+                }
+            }
+
+            // Euler allocation: each factor's loss over the tail paths, regenerated from their
+            // counters, rescaled to the corrected totals
+            if (simulated_es != 0.0)
+            {
+                std::vector<double> factor_tail(n, 0.0);
+                std::vector<double> shocks(components_);
+                std::vector<double> returns(n);
+                for (size_t i = 0; i < m; ++i)
+                {
+                    path_returns(ranked_paths_[i], shocks, returns);
+                    for (size_t f = 0; f < n; ++f)
+                    {
+                        if (factor_notionals_[f] != 0.0)
+                        {
+                            factor_tail[f] -= factor_notionals_[f] * (std::exp(returns[f] + drifts_[f]) - 1.0);
+                        }
+                    }
+                }
+
+                double tail_total = std::accumulate(factor_tail.begin(), factor_tail.end(), 0.0);
+                double var_scale = tail_total != 0.0 ? result.value_at_risk / tail_total : 0.0;
+                double es_scale = tail_total != 0.0 ? result.expected_shortfall / tail_total : 0.0;
+                for (size_t e = 0; e < exposures.size(); ++e)
+                {
+                    if (!has_factor(exposures[e].instrument))
+                    {
+                        continue;
+                    }
+                    uint32_t f = factor_by_instrument_[exposures[e].instrument];
+                    if (factor_notionals_[f] == 0.0)
+                    {
+                        continue; // offsetting exposures carry no risk
+                    }
+                    double share = factor_tail[f] * exposures[e].notional / factor_notionals_[f];
+                    result.var_contributions[e] = share * var_scale;
+                    result.es_contributions[e] = share * es_scale;
+                }
+            }
+
+            if (losses)
+            {
+                *losses = losses_;
+            }
+            return result;
+        }
+
+    } // namespace exposure
+} // namespace spe
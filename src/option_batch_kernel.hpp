@@ -0,0 +1,223 @@
+#pragma once
+
+// Private to the batch option pricer. Included by per-ISA translation units that are compiled
+// with different target flags, so it must stay free of standard containers and other inline
+// library code that the linker could merge across ISAs.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace spe
+{
+    namespace pricing
+    {
+        namespace detail
+        {
+
+            struct OptionChainKernelArgs
+            {
+                size_t count;
+                double spot;
+                double rate;
+                const double *strikes;
+                const double *expiries;     // years
+                const double *volatilities;
+                const double *option_signs; // +1 call, -1 put
+
+                double *prices;
+                double *deltas;
+                double *gammas;
+                double *thetas;
+                double *vegas;
+                double *rhos;
+            };
+
+            void price_chain_scalar(const OptionChainKernelArgs &args);
+            bool price_chain_avx2(const OptionChainKernelArgs &args);   // false if not built in
+            bool price_chain_avx512(const OptionChainKernelArgs &args); // false if not built in
+
+            // Vectorizable approximations, written once against an Ops policy that wraps one
+            // register type (double, __m256d, __m512d) so every ISA runs identical math.
+            template <typename Ops>
+            struct VectorMath
+            {
+                using reg = typename Ops::reg;
+
+                // e^x: x = n*ln2 + r with |r| <= ln2/2, degree-11 polynomial for e^r
+                static reg exp(reg x)
+                {
+                    x = Ops::min(Ops::max(x, Ops::set1(-708.0)), Ops::set1(708.0));
+                    reg n = Ops::round(Ops::mul(x, Ops::set1(1.4426950408889634)));
+                    reg r = Ops::fmadd(n, Ops::set1(-6.93147180369123816490e-01), x);
+                    r = Ops::fmadd(n, Ops::set1(-1.90821492927058770002e-10), r);
+
+                    reg p = Ops::set1(1.0 / 39916800.0);
+                    p = Ops::fmadd(p, r, Ops::set1(1.0 / 3628800.0));
+                    p = Ops::fmadd(p, r, Ops::set1(1.0 / 362880.0));
+                    p = Ops::fmadd(p, r, Ops::set1(1.0 / 40320.0));
+                    p = Ops::fmadd(p, r, Ops::set1(1.0 / 5040.0));
+                    p = Ops::fmadd(p, r, Ops::set1(1.0 / 720.0));
+                    p = Ops::fmadd(p, r, Ops::set1(1.0 / 120.0));
+                    p = Ops::fmadd(p, r, Ops::set1(1.0 / 24.0));
+                    p = Ops::fmadd(p, r, Ops::set1(1.0 / 6.0));
+                    p = Ops::fmadd(p, r, Ops::set1(0.5));
+                    p = Ops::fmadd(p, r, Ops::set1(1.0));
+                    p = Ops::fmadd(p, r, Ops::set1(1.0));
+                    return Ops::mul(p, Ops::pow2n(n));
+                }
+
+                // ln(x) for positive normal x: x = m * 2^e, m in [sqrt(1/2), sqrt(2)),
+                // ln(m) = 2 atanh(f) with f = (m - 1) / (m + 1)
+                static reg log(reg x)
+                {
+                    reg m, e;
+                    Ops::split_exponent(x, m, e);
+                    auto high = Ops::gt(m, Ops::set1(1.4142135623730951));
+                    m = Ops::blend(high, Ops::mul(m, Ops::set1(0.5)), m);
+                    e = Ops::blend(high, Ops::add(e, Ops::set1(1.0)), e);
+
+                    reg f = Ops::div(Ops::sub(m, Ops::set1(1.0)), Ops::add(m, Ops::set1(1.0)));
+                    reg f2 = Ops::mul(f, f);
+                    reg s = Ops::set1(1.0 / 17.0);
+                    s = Ops::fmadd(s, f2, Ops::set1(1.0 / 15.0));
+                    s = Ops::fmadd(s, f2, Ops::set1(1.0 / 13.0));
+                    s = Ops::fmadd(s, f2, Ops::set1(1.0 / 11.0));
+                    s = Ops::fmadd(s, f2, Ops::set1(1.0 / 9.0));
+                    s = Ops::fmadd(s, f2, Ops::set1(1.0 / 7.0));
+                    s = Ops::fmadd(s, f2, Ops::set1(1.0 / 5.0));
+                    s = Ops::fmadd(s, f2, Ops::set1(1.0 / 3.0));
+                    s = Ops::fmadd(s, f2, Ops::set1(1.0));
+                    reg log_m = Ops::mul(Ops::mul(Ops::set1(2.0), f), s);
+                    return Ops::fmadd(e, Ops::set1(0.6931471805599453), log_m);
+                }
+
+                // Standard normal CDF (West 2005 / Hart 1968, double precision). Both branches
+                // are evaluated and blended so the lanes never diverge.
+                static reg norm_cdf(reg x)
+                {
+                    reg ax = Ops::abs(x);
+                    reg e = exp(Ops::mul(Ops::mul(ax, ax), Ops::set1(-0.5)));
+
+                    reg num = Ops::set1(3.52624965998911e-02);
+                    num = Ops::fmadd(num, ax, Ops::set1(0.700383064443688));
+                    num = Ops::fmadd(num, ax, Ops::set1(6.37396220353165));
+                    num = Ops::fmadd(num, ax, Ops::set1(33.912866078383));
+                    num = Ops::fmadd(num, ax, Ops::set1(112.079291497871));
+                    num = Ops::fmadd(num, ax, Ops::set1(221.213596169931));
+                    num = Ops::fmadd(num, ax, Ops::set1(220.206867912376));
+
+                    reg den = Ops::set1(8.83883476483184e-02);
+                    den = Ops::fmadd(den, ax, Ops::set1(1.75566716318264));
+                    den = Ops::fmadd(den, ax, Ops::set1(16.064177579207));
+                    den = Ops::fmadd(den, ax, Ops::set1(86.7807322029461));
+                    den = Ops::fmadd(den, ax, Ops::set1(296.564248779674));
+                    den = Ops::fmadd(den, ax, Ops::set1(637.333633378831));
+                    den = Ops::fmadd(den, ax, Ops::set1(793.826512519948));
+                    den = Ops::fmadd(den, ax, Ops::set1(440.413735824752));
+                    reg rational_tail = Ops::div(Ops::mul(e, num), den);
+
+                    reg cf = Ops::add(ax, Ops::set1(0.65));
+                    cf = Ops::add(ax, Ops::div(Ops::set1(4.0), cf));
+                    cf = Ops::add(ax, Ops::div(Ops::set1(3.0), cf));
+                    cf = Ops::add(ax, Ops::div(Ops::set1(2.0), cf));
+                    cf = Ops::add(ax, Ops::div(Ops::set1(1.0), cf));
+                    reg fraction_tail = Ops::div(e, Ops::mul(cf, Ops::set1(2.506628274631)));
+
+                    reg tail = Ops::blend(Ops::lt(ax, Ops::set1(7.07106781186547)), rational_tail, fraction_tail);
+                    tail = Ops::blend(Ops::gt(ax, Ops::set1(37.0)), Ops::set1(0.0), tail);
+                    return Ops::blend(Ops::gt(x, Ops::set1(0.0)), Ops::sub(Ops::set1(1.0), tail), tail);
+                }
+            };
+
+            // Price and all Greeks for one register's worth of options; d1/d2, the discount
+            // factor and the normal density are shared across every output.
+            template <typename Ops>
+            inline void price_block(const OptionChainKernelArgs &args, size_t offset,
+                                    const double *strikes, const double *expiries,
+                                    const double *vols, const double *signs,
+                                    double *prices, double *deltas, double *gammas,
+                                    double *thetas, double *vegas, double *rhos)
+            {
+                using reg = typename Ops::reg;
+                using M = VectorMath<Ops>;
+
+                reg spot = Ops::set1(args.spot);
+                reg rate = Ops::set1(args.rate);
+                reg strike = Ops::load(strikes + offset);
+                reg t = Ops::max(Ops::load(expiries + offset), Ops::set1(1e-12));
+                reg sigma = Ops::max(Ops::load(vols + offset), Ops::set1(1e-12));
+                reg phi = Ops::load(signs + offset);
+
+                reg sqrt_t = Ops::sqrt(t);
+                reg sigma_sqrt_t = Ops::mul(sigma, sqrt_t);
+                reg drift = Ops::fmadd(Ops::mul(sigma, sigma), Ops::set1(0.5), rate);
+                reg d1 = Ops::div(Ops::fmadd(drift, t, M::log(Ops::div(spot, strike))), sigma_sqrt_t);
+                reg d2 = Ops::sub(d1, sigma_sqrt_t);
+
+                reg discount = M::exp(Ops::mul(Ops::sub(Ops::set1(0.0), rate), t));
+                reg nd1 = M::norm_cdf(Ops::mul(phi, d1));
+                reg nd2 = M::norm_cdf(Ops::mul(phi, d2));
+                reg pdf = Ops::mul(M::exp(Ops::mul(Ops::mul(d1, d1), Ops::set1(-0.5))),
+                                   Ops::set1(0.3989422804014327));
+
+                reg k_discount = Ops::mul(strike, discount);
+                reg k_discount_nd2 = Ops::mul(k_discount, nd2);
+                reg s_pdf = Ops::mul(spot, pdf);
+
+                Ops::store(prices + offset, Ops::mul(phi, Ops::sub(Ops::mul(spot, nd1), k_discount_nd2)));
+                Ops::store(deltas + offset, Ops::mul(phi, nd1));
+                Ops::store(gammas + offset, Ops::div(pdf, Ops::mul(spot, sigma_sqrt_t)));
+                Ops::store(vegas + offset, Ops::mul(s_pdf, sqrt_t));
+                Ops::store(thetas + offset,
+                           Ops::sub(Ops::div(Ops::mul(Ops::mul(s_pdf, sigma), Ops::set1(-0.5)), sqrt_t),
+                                    Ops::mul(Ops::mul(phi, rate), k_discount_nd2)));
+                Ops::store(rhos + offset, Ops::mul(Ops::mul(phi, t), k_discount_nd2));
+            }
+
+            template <typename Ops>
+            void price_chain_kernel(const OptionChainKernelArgs &args)
+            {
+                constexpr size_t width = Ops::width;
+                size_t full = args.count - args.count % width;
+
+                for (size_t i = 0; i < full; i += width)
+                {
+                    price_block<Ops>(args, i, args.strikes, args.expiries, args.volatilities, args.option_signs,
+                                     args.prices, args.deltas, args.gammas, args.thetas, args.vegas, args.rhos);
+                }
+
+                if (full == args.count)
+                {
+                    return;
+                }
+
+                // Tail: pad a stack block with benign inputs and keep only the live lanes
+                double strikes[width], expiries[width], vols[width], signs[width];
+                double prices[width], deltas[width], gammas[width], thetas[width], vegas[width], rhos[width];
+                size_t tail = args.count - full;
+                for (size_t lane = 0; lane < width; ++lane)
+                {
+                    bool live = lane < tail;
+                    strikes[lane] = live ? args.strikes[full + lane] : args.spot;
+                    expiries[lane] = live ? args.expiries[full + lane] : 1.0;
+                    vols[lane] = live ? args.volatilities[full + lane] : 0.2;
+                    signs[lane] = live ? args.option_signs[full + lane] : 1.0;
+                }
+
+                price_block<Ops>(args, 0, strikes, expiries, vols, signs,
+                                 prices, deltas, gammas, thetas, vegas, rhos);
+
+                for (size_t lane = 0; lane < tail; ++lane)
+                {
+                    args.prices[full + lane] = prices[lane];
+                    args.deltas[full + lane] = deltas[lane];
+                    args.gammas[full + lane] = gammas[lane];
+                    args.thetas[full + lane] = thetas[lane];
+                    args.vegas[full + lane] = vegas[lane];
+                    args.rhos[full + lane] = rhos[lane];
+                }
+            }
+
+        } // namespace detail
+    } // namespace pricing
+} // namespace spe
@@ -0,0 +1,216 @@
+#include "option_batch_pricing.hpp"
+#include "option_batch_kernel.hpp"
+#include "path_batch_kernel.hpp"
+#include "venue_scan_kernel.hpp"
+#include "basis_scan_kernel.hpp"
+#include <cmath>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace spe
+{
+    namespace pricing
+    {
+
+        namespace
+        {
+            struct ScalarOps
+            {
+                using reg = double;
+                using mask = bool;
+                static constexpr size_t width = 1;
+
+                static reg set1(double v) { return v; }
+                static reg load(const double *p) { return *p; }
+                static void store(double *p, reg v) { *p = v; }
+                static reg add(reg a, reg b) { return a + b; }
+                static reg sub(reg a, reg b) { return a - b; }
+                static reg mul(reg a, reg b) { return a * b; }
+                static reg div(reg a, reg b) { return a / b; }
+                static reg fmadd(reg a, reg b, reg c) { return a * b + c; }
+                static reg sqrt(reg a) { return std::sqrt(a); }
+                static reg min(reg a, reg b) { return a < b ? a : b; }
+                static reg max(reg a, reg b) { return a > b ? a : b; }
+                static reg abs(reg a) { return std::fabs(a); }
+                static reg round(reg a) { return std::nearbyint(a); }
+                static mask lt(reg a, reg b) { return a < b; }
+                static mask gt(reg a, reg b) { return a > b; }
+                static reg blend(mask m, reg if_true, reg if_false) { return m ? if_true : if_false; }
+                static bool any(mask m) { return m; }
+
+                // 32-bit unsigned lanes, one per double lane, for the Philox generator
+                using ureg = uint64_t;
+                static ureg uset1(uint32_t v) { return v; }
+                static ureg uramp(uint32_t first) { return first; }
+                static ureg uxor(ureg a, ureg b) { return a ^ b; }
+                static void umul_wide(ureg a, uint32_t m, ureg &hi, ureg &lo)
+                {
+                    uint64_t product = a * m;
+                    hi = product >> 32;
+                    lo = product & 0xffffffffu;
+                }
+                static reg unit_interval(ureg u) { return (static_cast<double>(u) + 0.5) * (1.0 / 4294967296.0); }
+
+                static reg pow2n(reg n)
+                {
+                    uint64_t bits = static_cast<uint64_t>(static_cast<int64_t>(n) + 1023) << 52;
+                    double result;
+                    std::memcpy(&result, &bits, sizeof(result));
+                    return result;
+                }
+
+                static void split_exponent(reg x, reg &mantissa, reg &exponent)
+                {
+                    uint64_t bits;
+                    std::memcpy(&bits, &x, sizeof(bits));
+                    exponent = static_cast<double>(static_cast<int64_t>((bits >> 52) & 0x7ff) - 1023);
+                    bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+                    std::memcpy(&mantissa, &bits, sizeof(mantissa));
+                }
+            };
+
+            bool cpu_supports(SimdLevel level)
+            {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+                __builtin_cpu_init();
+                switch (level)
+                {
+                case SimdLevel::AVX512:
+                    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("fma");
+                case SimdLevel::AVX2:
+                    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+                default:
+                    return true;
+                }
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+                int info[4];
+                __cpuid(info, 1);
+                bool fma = (info[2] & (1 << 12)) != 0;
+                bool osxsave = (info[2] & (1 << 27)) != 0;
+                if (level == SimdLevel::SCALAR)
+                {
+                    return true;
+                }
+                if (!fma || !osxsave)
+                {
+                    return false;
+                }
+                unsigned long long xcr0 = _xgetbv(0);
+                __cpuidex(info, 7, 0);
+                if (level == SimdLevel::AVX512)
+                {
+                    return (info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6;
+                }
+                return (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+#else
+                return level == SimdLevel::SCALAR;
+#endif
+            }
+
+            SimdLevel detect_simd_level()
+            {
+                if (cpu_supports(SimdLevel::AVX512))
+                {
+                    return SimdLevel::AVX512;
+                }
+                if (cpu_supports(SimdLevel::AVX2))
+                {
+                    return SimdLevel::AVX2;
+                }
+                return SimdLevel::SCALAR;
+            }
+        }
+
+        namespace detail
+        {
+            void price_chain_scalar(const OptionChainKernelArgs &args)
+            {
+                price_chain_kernel<ScalarOps>(args);
+            }
+
+            void scan_venues_scalar(const VenueScanKernelArgs &args)
+            {
+                scan_venues_kernel<ScalarOps>(args);
+            }
+
+            void scan_basis_scalar(const BasisScanKernelArgs &args)
+            {
+                scan_basis_kernel<ScalarOps>(args);
+            }
+        }
+
+        SimdLevel active_simd_level()
+        {
+            static const SimdLevel level = detect_simd_level();
+            return level;
+        }
+
+        const char *simd_level_name(SimdLevel level)
+        {
+            switch (level)
+            {
+            case SimdLevel::AVX512:
+                return "AVX-512";
+            case SimdLevel::AVX2:
+                return "AVX2";
+            default:
+                return "scalar";
+            }
+        }
+
+        void price_option_chain(double spot, double risk_free_rate,
+                                const OptionChain &chain, OptionChainGreeks &greeks)
+        {
+            price_option_chain(spot, risk_free_rate, chain, greeks, active_simd_level());
+        }
+
+        void price_option_chain(double spot, double risk_free_rate,
+                                const OptionChain &chain, OptionChainGreeks &greeks, SimdLevel level)
+        {
+            size_t count = chain.size();
+            greeks.resize(count);
+            if (count == 0)
+            {
+                return;
+            }
+
+            detail::OptionChainKernelArgs args{
+                count, spot, risk_free_rate,
+                chain.strikes.data(), chain.expiries.data(), chain.volatilities.data(), chain.option_signs.data(),
+                greeks.prices.data(), greeks.deltas.data(), greeks.gammas.data(),
+                greeks.thetas.data(), greeks.vegas.data(), greeks.rhos.data()};
+
+            // Never run a kernel the CPU cannot execute, even if asked to
+            if (level > active_simd_level())
+            {
+                level = active_simd_level();
+            }
+
+            if (level == SimdLevel::AVX512 && detail::price_chain_avx512(args))
+            {
+                return;
+            }
+            if (level >= SimdLevel::AVX2 && detail::price_chain_avx2(args))
+            {
+                return;
+            }
+            detail::price_chain_scalar(args);
+        }
+
+    } // namespace pricing
+
+    namespace exposure
+    {
+        namespace detail
+        {
+            // Shares the option pricer's scalar policy, which lives in this translation unit
+            void simulate_batch_scalar(const PathBatchKernelArgs &args)
+            {
+                simulate_batch_kernel<pricing::ScalarOps>(args);
+            }
+        }
+    }
+} // namespace spe
@@ -0,0 +1,145 @@
+// Built with AVX2/FMA code generation (see CMakeLists.txt); only entered after runtime detection.
+// Hosts the AVX2 option-chain, Monte Carlo path-batch, venue-scan and basis-scan kernels.
+#include "option_batch_kernel.hpp"
+#include "path_batch_kernel.hpp"
+#include "venue_scan_kernel.hpp"
+#include "basis_scan_kernel.hpp"
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#include <immintrin.h>
+
+namespace spe
+{
+    namespace pricing
+    {
+        namespace detail
+        {
+
+            namespace
+            {
+                struct Avx2Ops
+                {
+                    using reg = __m256d;
+                    using mask = __m256d;
+                    static constexpr size_t width = 4;
+
+                    static reg set1(double v) { return _mm256_set1_pd(v); }
+                    static reg load(const double *p) { return _mm256_loadu_pd(p); }
+                    static void store(double *p, reg v) { _mm256_storeu_pd(p, v); }
+                    static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+                    static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+                    static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+                    static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+                    static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+                    static reg sqrt(reg a) { return _mm256_sqrt_pd(a); }
+                    static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+                    static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+                    static reg abs(reg a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+                    static reg round(reg a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+                    static mask lt(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+                    static mask gt(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+                    static reg blend(mask m, reg if_true, reg if_false) { return _mm256_blendv_pd(if_false, if_true, m); }
+                    static bool any(mask m) { return _mm256_movemask_pd(m) != 0; }
+
+                    // 32-bit unsigned lanes, zero-extended in the 64-bit lanes, for the Philox generator
+                    using ureg = __m256i;
+                    static ureg uset1(uint32_t v) { return _mm256_set1_epi64x(v); }
+                    static ureg uramp(uint32_t first)
+                    {
+                        return _mm256_add_epi64(_mm256_set1_epi64x(first), _mm256_set_epi64x(3, 2, 1, 0));
+                    }
+                    static ureg uxor(ureg a, ureg b) { return _mm256_xor_si256(a, b); }
+                    static void umul_wide(ureg a, uint32_t m, ureg &hi, ureg &lo)
+                    {
+                        __m256i product = _mm256_mul_epu32(a, _mm256_set1_epi64x(m));
+                        hi = _mm256_srli_epi64(product, 32);
+                        lo = _mm256_and_si256(product, _mm256_set1_epi64x(0xffffffffLL));
+                    }
+                    static reg unit_interval(ureg u)
+                    {
+                        // (u + 0.5) / 2^32, with u converted by the 2^52 trick as in split_exponent
+                        const __m256i magic = _mm256_set1_epi64x(0x4330000000000000LL); // 2^52
+                        reg value = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(u, magic)),
+                                                  _mm256_set1_pd(4503599627370496.0 - 0.5));
+                        return _mm256_mul_pd(value, _mm256_set1_pd(1.0 / 4294967296.0));
+                    }
+
+                    static reg pow2n(reg n)
+                    {
+                        __m256i exponent = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n));
+                        exponent = _mm256_slli_epi64(_mm256_add_epi64(exponent, _mm256_set1_epi64x(1023)), 52);
+                        return _mm256_castsi256_pd(exponent);
+                    }
+
+                    static void split_exponent(reg x, reg &mantissa, reg &exponent)
+                    {
+                        const __m256i magic = _mm256_set1_epi64x(0x4330000000000000LL); // 2^52
+                        __m256i bits = _mm256_castpd_si256(x);
+                        __m256i biased = _mm256_srli_epi64(bits, 52);
+                        exponent = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(biased, magic)),
+                                                 _mm256_set1_pd(4503599627370496.0 + 1023.0));
+                        bits = _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000fffffffffffffLL)),
+                                               _mm256_set1_epi64x(0x3ff0000000000000LL));
+                        mantissa = _mm256_castsi256_pd(bits);
+                    }
+                };
+            }
+
+            bool price_chain_avx2(const OptionChainKernelArgs &args)
+            {
+                price_chain_kernel<Avx2Ops>(args);
+                return true;
+            }
+
+            bool scan_venues_avx2(const VenueScanKernelArgs &args)
+            {
+                scan_venues_kernel<Avx2Ops>(args);
+                return true;
+            }
+
+            bool scan_basis_avx2(const BasisScanKernelArgs &args)
+            {
+                scan_basis_kernel<Avx2Ops>(args);
+                return true;
+            }
+
+        } // namespace detail
+    } // namespace pricing
+
+    namespace exposure
+    {
+        namespace detail
+        {
+            bool simulate_batch_avx2(const PathBatchKernelArgs &args)
+            {
+                simulate_batch_kernel<pricing::detail::Avx2Ops>(args);
+                return true;
+            }
+        }
+    }
+} // namespace spe
+
+#else
+
+namespace spe
+{
+    namespace pricing
+    {
+        namespace detail
+        {
+            bool price_chain_avx2(const OptionChainKernelArgs &) { return false; }
+            bool scan_venues_avx2(const VenueScanKernelArgs &) { return false; }
+            bool scan_basis_avx2(const BasisScanKernelArgs &) { return false; }
+        }
+    }
+
+    namespace exposure
+    {
+        namespace detail
+        {
+            bool simulate_batch_avx2(const PathBatchKernelArgs &) { return false; }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,160 @@
+// Built with AVX-512F code generation (see CMakeLists.txt); only entered after runtime detection.
+// Hosts the AVX-512 option-chain, Monte Carlo path-batch, venue-scan and basis-scan kernels.
+#include "option_batch_kernel.hpp"
+#include "path_batch_kernel.hpp"
+#include "venue_scan_kernel.hpp"
+#include "basis_scan_kernel.hpp"
+
+#if defined(__AVX512F__) && (defined(__FMA__) || defined(_MSC_VER))
+#include <immintrin.h>
+
+namespace spe
+{
+    namespace pricing
+    {
+        namespace detail
+        {
+
+            namespace
+            {
+                struct Avx512Ops
+                {
+                    using reg = __m512d;
+                    using mask = __mmask8;
+                    static constexpr size_t width = 8;
+                    // Intrinsics without a merge source are spelled as their zero-masked forms over
+                    // every lane: GCC seeds the unmasked ones with a self-initialized
+                    // _mm512_undefined_*(), which warns as uninitialized once inlined
+                    static constexpr mask all = 0xff;
+
+                    static reg set1(double v) { return _mm512_set1_pd(v); }
+                    static reg load(const double *p) { return _mm512_loadu_pd(p); }
+                    static void store(double *p, reg v) { _mm512_storeu_pd(p, v); }
+                    static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+                    static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+                    static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+                    static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+                    static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+                    static reg sqrt(reg a) { return _mm512_maskz_sqrt_pd(all, a); }
+                    static reg min(reg a, reg b) { return _mm512_maskz_min_pd(all, a, b); }
+                    static reg max(reg a, reg b) { return _mm512_maskz_max_pd(all, a, b); }
+                    static reg round(reg a) { return _mm512_maskz_roundscale_pd(all, a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+                    static mask lt(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+                    static mask gt(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+                    static reg blend(mask m, reg if_true, reg if_false) { return _mm512_mask_blend_pd(m, if_false, if_true); }
+                    static bool any(mask m) { return m != 0; }
+
+                    // 32-bit unsigned lanes, zero-extended in the 64-bit lanes, for the Philox generator
+                    using ureg = __m512i;
+                    static ureg uset1(uint32_t v) { return _mm512_set1_epi64(v); }
+                    static ureg uramp(uint32_t first)
+                    {
+                        return _mm512_add_epi64(_mm512_set1_epi64(first), _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0));
+                    }
+                    static ureg uxor(ureg a, ureg b) { return _mm512_xor_si512(a, b); }
+                    static void umul_wide(ureg a, uint32_t m, ureg &hi, ureg &lo)
+                    {
+                        __m512i product = _mm512_maskz_mul_epu32(all, a, _mm512_set1_epi64(m));
+                        hi = _mm512_maskz_srli_epi64(all, product, 32);
+                        lo = _mm512_and_si512(product, _mm512_set1_epi64(0xffffffffLL));
+                    }
+                    static reg unit_interval(ureg u)
+                    {
+                        // (u + 0.5) / 2^32, with u converted by the 2^52 trick as in small_int_to_double
+                        const __m512i magic = _mm512_set1_epi64(0x4330000000000000LL);
+                        reg value = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(u, magic)),
+                                                  _mm512_set1_pd(4503599627370496.0 - 0.5));
+                        return _mm512_mul_pd(value, _mm512_set1_pd(1.0 / 4294967296.0));
+                    }
+
+                    static reg abs(reg a)
+                    {
+                        return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(a),
+                                                                    _mm512_set1_epi64(0x7fffffffffffffffLL)));
+                    }
+
+                    static reg pow2n(reg n)
+                    {
+                        __m512i exponent = _mm512_maskz_cvtepi32_epi64(all, _mm512_maskz_cvtpd_epi32(all, n));
+                        exponent = _mm512_maskz_slli_epi64(all, _mm512_add_epi64(exponent, _mm512_set1_epi64(1023)), 52);
+                        return _mm512_castsi512_pd(exponent);
+                    }
+
+                    static void split_exponent(reg x, reg &mantissa, reg &exponent)
+                    {
+                        __m512i bits = _mm512_castpd_si512(x);
+                        exponent = _mm512_sub_pd(small_int_to_double(_mm512_maskz_srli_epi64(all, bits, 52)),
+                                                 _mm512_set1_pd(1023.0));
+                        bits = _mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi64(0x000fffffffffffffLL)),
+                                               _mm512_set1_epi64(0x3ff0000000000000LL));
+                        mantissa = _mm512_castsi512_pd(bits);
+                    }
+
+                    // int64 -> double needs AVX-512DQ; biased exponents fit in 11 bits, so use the 2^52 trick
+                    static reg small_int_to_double(__m512i small)
+                    {
+                        const __m512i magic = _mm512_set1_epi64(0x4330000000000000LL);
+                        return _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(small, magic)),
+                                             _mm512_set1_pd(4503599627370496.0));
+                    }
+                };
+            }
+
+            bool price_chain_avx512(const OptionChainKernelArgs &args)
+            {
+                price_chain_kernel<Avx512Ops>(args);
+                return true;
+            }
+
+            bool scan_venues_avx512(const VenueScanKernelArgs &args)
+            {
+                scan_venues_kernel<Avx512Ops>(args);
+                return true;
+            }
+
+            bool scan_basis_avx512(const BasisScanKernelArgs &args)
+            {
+                scan_basis_kernel<Avx512Ops>(args);
+                return true;
+            }
+
+        } // namespace detail
+    } // namespace pricing
+
+    namespace exposure
+    {
+        namespace detail
+        {
+            bool simulate_batch_avx512(const PathBatchKernelArgs &args)
+            {
+                simulate_batch_kernel<pricing::detail::Avx512Ops>(args);
+                return true;
+            }
+        }
+    }
+} // namespace spe
+
+#else
+
+namespace spe
+{
+    namespace pricing
+    {
+        namespace detail
+        {
+            bool price_chain_avx512(const OptionChainKernelArgs &) { return false; }
+            bool scan_venues_avx512(const VenueScanKernelArgs &) { return false; }
+            bool scan_basis_avx512(const BasisScanKernelArgs &) { return false; }
+        }
+    }
+
+    namespace exposure
+    {
+        namespace detail
+        {
+            bool simulate_batch_avx512(const PathBatchKernelArgs &) { return false; }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,319 @@
+#include "order_book.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+
+namespace spe
+{
+    namespace market_data
+    {
+
+        namespace
+        {
+            constexpr size_t OKX_CHECKSUM_LEVELS = 25;
+
+            struct Crc32Table
+            {
+                uint32_t entries[256];
+
+                Crc32Table()
+                {
+                    for (uint32_t i = 0; i < 256; ++i)
+                    {
+                        uint32_t crc = i;
+                        for (int bit = 0; bit < 8; ++bit)
+                        {
+                            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+                        }
+                        entries[i] = crc;
+                    }
+                }
+            };
+
+            uint32_t crc32(const std::string &data)
+            {
+                static const Crc32Table table;
+                uint32_t crc = 0xFFFFFFFFu;
+                for (unsigned char c : data)
+                {
+                    crc = table.entries[(crc ^ c) & 0xFF] ^ (crc >> 8);
+                }
+                return crc ^ 0xFFFFFFFFu;
+            }
+
+            // Shortest fixed-notation text that round-trips; only for levels set without their
+            // wire text, whose checksum then holds as long as the venue prints the same way
+            void append_decimal(std::string &out, double value)
+            {
+                char buffer[64];
+#if defined(__cpp_lib_to_chars)
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed);
+                out.append(buffer, result.ptr);
+#else
+                int length = std::snprintf(buffer, sizeof(buffer), "%.10f", value);
+                while (length > 1 && buffer[length - 1] == '0')
+                {
+                    --length;
+                }
+                if (length > 1 && buffer[length - 1] == '.')
+                {
+                    --length;
+                }
+                out.append(buffer, length);
+#endif
+            }
+
+            void append_field(std::string &out, const WireDecimal *text, double value)
+            {
+                if (text && !text->empty())
+                {
+                    out.append(text->text, text->length);
+                }
+                else
+                {
+                    append_decimal(out, value);
+                }
+                out.push_back(':');
+            }
+        }
+
+        OrderBook::OrderBook(InstrumentHandle instrument, BookSequencing sequencing, size_t max_levels)
+            : instrument_(instrument), sequencing_(sequencing), max_levels_(max_levels),
+              keeps_text_(sequencing == BookSequencing::OKX), synced_(sequencing == BookSequencing::NONE),
+              awaiting_first_update_(false), last_update_id_(0)
+        {
+            checksum_buffer_.reserve(OKX_CHECKSUM_LEVELS * 2 * 48);
+        }
+
+        BookUpdateResult OrderBook::lose_sync(BookUpdateResult reason)
+        {
+            synced_ = false;
+            awaiting_first_update_ = false;
+            if (reason == BookUpdateResult::GAP)
+            {
+                ++statistics_.gaps;
+            }
+            else if (reason == BookUpdateResult::CHECKSUM_MISMATCH)
+            {
+                ++statistics_.checksum_failures;
+            }
+            return reason;
+        }
+
+        BookUpdateResult OrderBook::begin_update(const BookSequence &sequence)
+        {
+            if (sequence.is_snapshot)
+            {
+                bids_.clear();
+                asks_.clear();
+                bid_text_.clear();
+                ask_text_.clear();
+                return BookUpdateResult::APPLIED;
+            }
+            if (!synced_)
+            {
+                return BookUpdateResult::AWAITING_SNAPSHOT;
+            }
+
+            switch (sequencing_)
+            {
+            case BookSequencing::NONE:
+                return BookUpdateResult::APPLIED;
+
+            case BookSequencing::OKX:
+                if (sequence.previous_update_id == last_update_id_)
+                {
+                    return BookUpdateResult::APPLIED; // seqId may also go backwards after an OKX restart
+                }
+                if (sequence.last_update_id <= last_update_id_)
+                {
+                    ++statistics_.stale_updates;
+                    return BookUpdateResult::STALE;
+                }
+                return lose_sync(BookUpdateResult::GAP);
+
+            case BookSequencing::BINANCE_SPOT:
+            case BookSequencing::BINANCE_FUTURES:
+                if (sequence.last_update_id <= last_update_id_)
+                {
+                    ++statistics_.stale_updates;
+                    return BookUpdateResult::STALE;
+                }
+                if (awaiting_first_update_)
+                {
+                    return sequence.first_update_id <= last_update_id_ + 1 ? BookUpdateResult::APPLIED
+                                                                             : lose_sync(BookUpdateResult::GAP);
+                }
+                if (sequencing_ == BookSequencing::BINANCE_SPOT)
+                {
+                    return sequence.first_update_id == last_update_id_ + 1 ? BookUpdateResult::APPLIED
+                                                                             : lose_sync(BookUpdateResult::GAP);
+                }
+                return sequence.previous_update_id == last_update_id_ ? BookUpdateResult::APPLIED
+                                                                       : lose_sync(BookUpdateResult::GAP);
+            }
+            return BookUpdateResult::APPLIED;
+        }
+
+        void OrderBook::set_level(Side side, Price price, Volume size)
+        {
+            set_level(side, price, size, std::string_view(), std::string_view());
+        }
+
+        void OrderBook::set_level(Side side, Price price, Volume size, std::string_view price_text,
+                                  std::string_view size_text)
+        {
+            std::vector<PriceLevel> &levels = side == Side::BID ? bids_ : asks_;
+            auto position = side == Side::BID
+                                ? std::lower_bound(levels.begin(), levels.end(), price,
+                                                   [](const PriceLevel &level, Price p)
+                                                   { return level.price < p; })
+                                : std::lower_bound(levels.begin(), levels.end(), price,
+                                                   [](const PriceLevel &level, Price p)
+                                                   { return level.price > p; });
+            size_t index = static_cast<size_t>(position - levels.begin());
+            std::vector<LevelText> &texts = side == Side::BID ? bid_text_ : ask_text_;
+
+            if (position != levels.end() && position->price == price)
+            {
+                if (size > 0.0)
+                {
+                    position->size = size;
+                    if (keeps_text_)
+                    {
+                        texts[index].price.assign(price_text);
+                        texts[index].size.assign(size_text);
+                    }
+                }
+                else
+                {
+                    levels.erase(position);
+                    if (keeps_text_)
+                    {
+                        texts.erase(texts.begin() + index);
+                    }
+                }
+            }
+            else if (size > 0.0)
+            {
+                levels.insert(position, PriceLevel{price, size});
+                if (keeps_text_)
+                {
+                    LevelText text;
+                    text.price.assign(price_text);
+                    text.size.assign(size_text);
+                    texts.insert(texts.begin() + index, text);
+                }
+            }
+        }
+
+        BookUpdateResult OrderBook::commit_update(const BookSequence &sequence)
+        {
+            trim();
+            // Validated before any sequence state moves, so a bad frame leaves the last good id
+            if (sequencing_ == BookSequencing::OKX && sequence.has_checksum && okx_checksum() != sequence.checksum)
+            {
+                return lose_sync(BookUpdateResult::CHECKSUM_MISMATCH);
+            }
+
+            if (sequence.is_snapshot)
+            {
+                synced_ = true;
+                awaiting_first_update_ = sequencing_ == BookSequencing::BINANCE_SPOT ||
+                                         sequencing_ == BookSequencing::BINANCE_FUTURES;
+                ++statistics_.snapshots_applied;
+            }
+            else
+            {
+                awaiting_first_update_ = false;
+                ++statistics_.updates_applied;
+            }
+            last_update_id_ = sequence.last_update_id;
+
+            publish(sequence);
+            return BookUpdateResult::APPLIED;
+        }
+
+        void OrderBook::reset()
+        {
+            bids_.clear();
+            asks_.clear();
+            bid_text_.clear();
+            ask_text_.clear();
+            synced_ = sequencing_ == BookSequencing::NONE;
+            awaiting_first_update_ = false;
+            last_update_id_ = 0;
+        }
+
+        void OrderBook::trim()
+        {
+            if (max_levels_ == 0)
+            {
+                return;
+            }
+            if (bids_.size() > max_levels_)
+            {
+                size_t excess = bids_.size() - max_levels_;
+                bids_.erase(bids_.begin(), bids_.begin() + excess);
+                if (keeps_text_)
+                {
+                    bid_text_.erase(bid_text_.begin(), bid_text_.begin() + excess);
+                }
+            }
+            if (asks_.size() > max_levels_)
+            {
+                size_t excess = asks_.size() - max_levels_;
+                asks_.erase(asks_.begin(), asks_.begin() + excess);
+                if (keeps_text_)
+                {
+                    ask_text_.erase(ask_text_.begin(), ask_text_.begin() + excess);
+                }
+            }
+        }
+
+        void OrderBook::publish(const BookSequence &sequence)
+        {
+            MarketDepth depth(instrument_);
+            for (auto level = bids_.rbegin(); level != bids_.rend() && depth.add_bid(level->price, level->size); ++level)
+            {
+            }
+            for (auto level = asks_.rbegin(); level != asks_.rend() && depth.add_ask(level->price, level->size); ++level)
+            {
+            }
+            depth.update_id = last_update_id_;
+            depth.timestamp = sequence.timestamp;
+            view_.store(depth);
+        }
+
+        // OKX: CRC32 of "bid1px:bid1sz:ask1px:ask1sz:bid2px:..." over up to 25 levels per side,
+        // in the exchange's own text, compared as a signed 32-bit value
+        int32_t OrderBook::okx_checksum()
+        {
+            checksum_buffer_.clear();
+            auto append_level = [this](const std::vector<PriceLevel> &levels, const std::vector<LevelText> &texts, size_t i)
+            {
+                size_t index = levels.size() - 1 - i;
+                const LevelText *text = index < texts.size() ? &texts[index] : nullptr;
+                append_field(checksum_buffer_, text ? &text->price : nullptr, levels[index].price);
+                append_field(checksum_buffer_, text ? &text->size : nullptr, levels[index].size);
+            };
+            for (size_t i = 0; i < OKX_CHECKSUM_LEVELS; ++i)
+            {
+                if (i < bids_.size())
+                {
+                    append_level(bids_, bid_text_, i);
+                }
+                if (i < asks_.size())
+                {
+                    append_level(asks_, ask_text_, i);
+                }
+            }
+            if (!checksum_buffer_.empty())
+            {
+                checksum_buffer_.pop_back(); // trailing ':'
+            }
+            return static_cast<int32_t>(crc32(checksum_buffer_));
+        }
+
+    } // namespace market_data
+} // namespace spe
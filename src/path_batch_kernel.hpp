@@ -0,0 +1,236 @@
+#pragma once
+
+// Private to the Monte Carlo VaR engine. Like option_batch_kernel.hpp, it is included by the
+// per-ISA translation units, so it must stay free of standard containers and other inline
+// library code that the linker could merge across ISAs.
+
+#include "option_batch_kernel.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace spe
+{
+    namespace exposure
+    {
+        namespace detail
+        {
+
+            struct PathBatchKernelArgs
+            {
+                size_t instruments;
+                size_t components; // common factors
+                size_t lanes;      // shock vectors in the batch, a multiple of four of the widest registers
+                bool antithetic;   // lanes are also run negated, into the second half of the outputs
+                bool triangular;   // loadings row i is zero past column i (a Cholesky factor)
+                const double *loadings;              // instruments x components, row-major, in horizon returns
+                const double *residual_volatilities; // per instrument; nullptr when the components carry it all
+                const double *notionals;             // per instrument
+                const double *drifts;                // per instrument
+
+                // Philox stream: row r of the batch's normals uses counters (batch, r, quad), rows
+                // being the components, then components + i for instrument i's residual
+                uint64_t batch;
+                uint32_t key0;
+                uint32_t key1;
+
+                double *shocks;        // (components + instruments) x lanes, row-major standard normals
+                double *losses;        // lanes (x2 when antithetic)
+                double *linear_losses; // lanes (x2 when antithetic)
+            };
+
+            void simulate_batch_scalar(const PathBatchKernelArgs &args);
+            bool simulate_batch_avx2(const PathBatchKernelArgs &args);   // false if not built in
+            bool simulate_batch_avx512(const PathBatchKernelArgs &args); // false if not built in
+
+            // Inverse normal CDF of uniforms in (0, 1), Acklam's approximation as in
+            // exposure::normal_quantile; the tail branch runs only for registers with a lane in it
+            template <typename Ops>
+            inline typename Ops::reg normal_quantile(typename Ops::reg u)
+            {
+                using reg = typename Ops::reg;
+                using M = pricing::detail::VectorMath<Ops>;
+                const double low = 0.02425;
+
+                reg q = Ops::sub(u, Ops::set1(0.5));
+                reg r = Ops::mul(q, q);
+                reg num = Ops::set1(-3.969683028665376e+01);
+                num = Ops::fmadd(num, r, Ops::set1(2.209460984245205e+02));
+                num = Ops::fmadd(num, r, Ops::set1(-2.759285104469687e+02));
+                num = Ops::fmadd(num, r, Ops::set1(1.383577518672690e+02));
+                num = Ops::fmadd(num, r, Ops::set1(-3.066479806614716e+01));
+                num = Ops::fmadd(num, r, Ops::set1(2.506628277459239e+00));
+                reg den = Ops::set1(-5.447609879822406e+01);
+                den = Ops::fmadd(den, r, Ops::set1(1.615858368580409e+02));
+                den = Ops::fmadd(den, r, Ops::set1(-1.556989798598866e+02));
+                den = Ops::fmadd(den, r, Ops::set1(6.680131188771972e+01));
+                den = Ops::fmadd(den, r, Ops::set1(-1.328068155288572e+01));
+                den = Ops::fmadd(den, r, Ops::set1(1.0));
+                reg central = Ops::div(Ops::mul(num, q), den);
+
+                reg tail_p = Ops::min(u, Ops::sub(Ops::set1(1.0), u));
+                auto in_tail = Ops::lt(tail_p, Ops::set1(low));
+                if (!Ops::any(in_tail))
+                {
+                    return central;
+                }
+                reg s = Ops::sqrt(Ops::mul(Ops::set1(-2.0), M::log(tail_p)));
+                reg c = Ops::set1(-7.784894002430293e-03);
+                c = Ops::fmadd(c, s, Ops::set1(-3.223964580411365e-01));
+                c = Ops::fmadd(c, s, Ops::set1(-2.400758277161838e+00));
+                c = Ops::fmadd(c, s, Ops::set1(-2.549732539343734e+00));
+                c = Ops::fmadd(c, s, Ops::set1(4.374664141464968e+00));
+                c = Ops::fmadd(c, s, Ops::set1(2.938163982698783e+00));
+                reg d = Ops::set1(7.784695709041462e-03);
+                d = Ops::fmadd(d, s, Ops::set1(3.224671290700398e-01));
+                d = Ops::fmadd(d, s, Ops::set1(2.445134137142996e+00));
+                d = Ops::fmadd(d, s, Ops::set1(3.754408661907416e+00));
+                d = Ops::fmadd(d, s, Ops::set1(1.0));
+                reg tail = Ops::div(c, d);
+                tail = Ops::blend(Ops::gt(u, Ops::set1(0.5)), Ops::sub(Ops::set1(0.0), tail), tail);
+                return Ops::blend(in_tail, tail, central);
+            }
+
+            // Philox4x32-10 as in exposure::Philox4x32, on a register of counters (batch, row, quad)
+            // per step: word w of quad q becomes the uniform for lane w * quads + q of the row
+            template <typename Ops>
+            inline void philox_uniforms(uint64_t batch, uint32_t row, uint32_t key0, uint32_t key1, size_t quads,
+                                        double *out)
+            {
+                using ureg = typename Ops::ureg;
+                for (size_t quad = 0; quad < quads; quad += Ops::width)
+                {
+                    ureg c0 = Ops::uset1(uint32_t(batch));
+                    ureg c1 = Ops::uset1(uint32_t(batch >> 32));
+                    ureg c2 = Ops::uset1(row);
+                    ureg c3 = Ops::uramp(uint32_t(quad));
+                    uint32_t k0 = key0;
+                    uint32_t k1 = key1;
+                    for (int round = 0; round < 10; ++round)
+                    {
+                        ureg hi0, lo0, hi1, lo1;
+                        Ops::umul_wide(c0, 0xD2511F53u, hi0, lo0);
+                        Ops::umul_wide(c2, 0xCD9E8D57u, hi1, lo1);
+                        c0 = Ops::uxor(Ops::uxor(hi1, c1), Ops::uset1(k0));
+                        c1 = lo1;
+                        c2 = Ops::uxor(Ops::uxor(hi0, c3), Ops::uset1(k1));
+                        c3 = lo0;
+                        k0 += 0x9E3779B9u;
+                        k1 += 0xBB67AE85u;
+                    }
+                    Ops::store(out + quad, Ops::unit_interval(c0));
+                    Ops::store(out + quads + quad, Ops::unit_interval(c1));
+                    Ops::store(out + 2 * quads + quad, Ops::unit_interval(c2));
+                    Ops::store(out + 3 * quads + quad, Ops::unit_interval(c3));
+                }
+            }
+
+            template <typename Ops>
+            inline void normal_row(const PathBatchKernelArgs &args, size_t row)
+            {
+                double *out = args.shocks + row * args.lanes;
+                philox_uniforms<Ops>(args.batch, uint32_t(row), args.key0, args.key1, args.lanes / 4, out);
+                for (size_t j = 0; j < args.lanes; j += Ops::width)
+                {
+                    Ops::store(out + j, normal_quantile<Ops>(Ops::load(out + j)));
+                }
+            }
+
+            // Normals for the components and for the residuals of instruments with exposure,
+            // then each such instrument's returns for the whole batch, one register of lanes at a
+            // time, folded into the lognormal and linear losses
+            template <typename Ops>
+            void simulate_batch_kernel(const PathBatchKernelArgs &args)
+            {
+                using reg = typename Ops::reg;
+                using M = pricing::detail::VectorMath<Ops>;
+                constexpr size_t width = Ops::width;
+                const size_t n = args.instruments;
+                const size_t components = args.components;
+                const size_t lanes = args.lanes;
+                const size_t paths = args.antithetic ? 2 * lanes : lanes;
+
+                for (size_t k = 0; k < components; ++k)
+                {
+                    normal_row<Ops>(args, k);
+                }
+                if (args.residual_volatilities)
+                {
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        if (args.notionals[i] != 0.0 && args.residual_volatilities[i] != 0.0)
+                        {
+                            normal_row<Ops>(args, components + i);
+                        }
+                    }
+                }
+                for (size_t j = 0; j < paths; ++j)
+                {
+                    args.losses[j] = 0.0;
+                    args.linear_losses[j] = 0.0;
+                }
+
+                const reg one = Ops::set1(1.0);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    if (args.notionals[i] == 0.0)
+                    {
+                        continue;
+                    }
+                    const double *l = args.loadings + i * components;
+                    const size_t used = args.triangular ? i + 1 : components;
+                    const double residual = args.residual_volatilities ? args.residual_volatilities[i] : 0.0;
+                    const double *epsilon = args.shocks + (components + i) * lanes;
+                    reg notional = Ops::set1(args.notionals[i]);
+                    reg drift = Ops::set1(args.drifts[i]);
+
+                    // Four registers of lanes at a time, so the FMA chains overlap; named rather
+                    // than an array, which GCC keeps in memory across the loop
+                    for (size_t j = 0; j < lanes; j += 4 * width)
+                    {
+                        reg x0 = Ops::set1(0.0), x1 = Ops::set1(0.0), x2 = Ops::set1(0.0), x3 = Ops::set1(0.0);
+                        for (size_t k = 0; k < used; ++k)
+                        {
+                            reg weight = Ops::set1(l[k]);
+                            const double *z = args.shocks + k * lanes + j;
+                            x0 = Ops::fmadd(weight, Ops::load(z), x0);
+                            x1 = Ops::fmadd(weight, Ops::load(z + width), x1);
+                            x2 = Ops::fmadd(weight, Ops::load(z + 2 * width), x2);
+                            x3 = Ops::fmadd(weight, Ops::load(z + 3 * width), x3);
+                        }
+                        if (residual != 0.0)
+                        {
+                            reg weight = Ops::set1(residual);
+                            const double *z = epsilon + j;
+                            x0 = Ops::fmadd(weight, Ops::load(z), x0);
+                            x1 = Ops::fmadd(weight, Ops::load(z + width), x1);
+                            x2 = Ops::fmadd(weight, Ops::load(z + 2 * width), x2);
+                            x3 = Ops::fmadd(weight, Ops::load(z + 3 * width), x3);
+                        }
+                        reg x[4] = {x0, x1, x2, x3};
+
+                        for (size_t r = 0; r < 4; ++r)
+                        {
+                            size_t lane = j + r * width;
+                            reg exposure = Ops::mul(notional, x[r]);
+                            reg loss = Ops::sub(Ops::load(args.losses + lane),
+                                                Ops::mul(notional, Ops::sub(M::exp(Ops::add(x[r], drift)), one)));
+                            Ops::store(args.losses + lane, loss);
+                            Ops::store(args.linear_losses + lane, Ops::sub(Ops::load(args.linear_losses + lane), exposure));
+
+                            if (args.antithetic)
+                            {
+                                double *anti_losses = args.losses + lanes + lane;
+                                double *anti_linear = args.linear_losses + lanes + lane;
+                                loss = Ops::sub(Ops::load(anti_losses),
+                                                Ops::mul(notional, Ops::sub(M::exp(Ops::sub(drift, x[r])), one)));
+                                Ops::store(anti_losses, loss);
+                                Ops::store(anti_linear, Ops::add(Ops::load(anti_linear), exposure));
+                            }
+                        }
+                    }
+                }
+            }
+
+        } // namespace detail
+    } // namespace exposure
+} // namespace spe
@@ -1,6 +1,7 @@
 #include "pricing_models.hpp"
 #include <cmath>
 #include <algorithm>
+#include <limits>
 
 namespace spe
 {
@@ -30,13 +31,173 @@ namespace spe
             return interpolate_volatility(spot_price, time_to_expiry);
         }
 
+        // CompiledVolatilitySurface implementation
+        namespace
+        {
+            // Lower grid index and blend weight for x on a sorted axis, clamped at both ends
+            inline size_t bracket(const std::vector<double> &axis, double x, double &weight)
+            {
+                if (axis.size() < 2 || x <= axis.front())
+                {
+                    weight = 0.0;
+                    return 0;
+                }
+                if (x >= axis.back())
+                {
+                    weight = 1.0;
+                    return axis.size() - 2;
+                }
+
+                size_t upper = std::upper_bound(axis.begin(), axis.end(), x) - axis.begin();
+                size_t lower = upper - 1;
+                weight = (x - axis[lower]) / (axis[upper] - axis[lower]);
+                return lower;
+            }
+
+            // Fills NaN cells of a strided line by linear interpolation between known cells,
+            // flat beyond the outermost ones. Returns false if the line has no known cell.
+            bool fill_line(double *values, size_t count, size_t stride, const std::vector<double> &axis)
+            {
+                size_t previous = count;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (std::isnan(values[i * stride]))
+                    {
+                        continue;
+                    }
+
+                    if (previous == count)
+                    {
+                        for (size_t j = 0; j < i; ++j)
+                        {
+                            values[j * stride] = values[i * stride];
+                        }
+                    }
+                    else
+                    {
+                        double left = values[previous * stride];
+                        double right = values[i * stride];
+                        for (size_t j = previous + 1; j < i; ++j)
+                        {
+                            double w = (axis[j] - axis[previous]) / (axis[i] - axis[previous]);
+                            values[j * stride] = left + w * (right - left);
+                        }
+                    }
+                    previous = i;
+                }
+
+                if (previous == count)
+                {
+                    return false;
+                }
+                for (size_t j = previous + 1; j < count; ++j)
+                {
+                    values[j * stride] = values[previous * stride];
+                }
+                return true;
+            }
+        }
+
+        CompiledVolatilitySurface::CompiledVolatilitySurface(const VolatilitySurface &surface)
+        {
+            if (surface.vol_surface.empty())
+            {
+                return;
+            }
+
+            for (const auto &[point, vol] : surface.vol_surface)
+            {
+                strikes_.push_back(point.first);
+                tenors_.push_back(point.second);
+            }
+            std::sort(strikes_.begin(), strikes_.end());
+            strikes_.erase(std::unique(strikes_.begin(), strikes_.end()), strikes_.end());
+            std::sort(tenors_.begin(), tenors_.end());
+            tenors_.erase(std::unique(tenors_.begin(), tenors_.end()), tenors_.end());
+
+            size_t width = strikes_.size();
+            vols_.assign(width * tenors_.size(), std::numeric_limits<double>::quiet_NaN());
+            for (const auto &[point, vol] : surface.vol_surface)
+            {
+                size_t k = std::lower_bound(strikes_.begin(), strikes_.end(), point.first) - strikes_.begin();
+                size_t t = std::lower_bound(tenors_.begin(), tenors_.end(), point.second) - tenors_.begin();
+                vols_[t * width + k] = vol;
+            }
+
+            // Complete each smile along strike, then fill tenors that had no quotes at all
+            for (size_t t = 0; t < tenors_.size(); ++t)
+            {
+                fill_line(&vols_[t * width], width, 1, strikes_);
+            }
+            for (size_t k = 0; k < width; ++k)
+            {
+                fill_line(&vols_[k], tenors_.size(), width, tenors_);
+            }
+        }
+
+        double CompiledVolatilitySurface::interpolate(double strike, double time_to_expiry) const
+        {
+            if (vols_.empty())
+            {
+                return 0.2; // Default 20% volatility
+            }
+
+            double wk, wt;
+            size_t k = bracket(strikes_, strike, wk);
+            size_t t = bracket(tenors_, time_to_expiry, wt);
+            size_t width = strikes_.size();
+            size_t k1 = std::min(k + 1, width - 1);
+            size_t t1 = std::min(t + 1, tenors_.size() - 1);
+
+            const double *row0 = &vols_[t * width];
+            const double *row1 = &vols_[t1 * width];
+            double v0 = row0[k] + wk * (row0[k1] - row0[k]);
+            double v1 = row1[k] + wk * (row1[k1] - row1[k]);
+            return v0 + wt * (v1 - v0);
+        }
+
+        void CompiledVolatilitySurface::interpolate(const double *strikes, const double *expiries,
+                                                    double *volatilities, size_t count) const
+        {
+            if (vols_.empty())
+            {
+                std::fill(volatilities, volatilities + count, 0.2);
+                return;
+            }
+
+            size_t width = strikes_.size();
+            size_t height = tenors_.size();
+            double last_tenor = std::numeric_limits<double>::quiet_NaN();
+            double wt = 0.0;
+            size_t t = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                // Chains are usually grouped by expiry, so the tenor bracket is reused
+                if (expiries[i] != last_tenor)
+                {
+                    t = bracket(tenors_, expiries[i], wt);
+                    last_tenor = expiries[i];
+                }
+
+                double wk;
+                size_t k = bracket(strikes_, strikes[i], wk);
+                size_t k1 = std::min(k + 1, width - 1);
+                size_t t1 = std::min(t + 1, height - 1);
+                const double *row0 = &vols_[t * width];
+                const double *row1 = &vols_[t1 * width];
+                double v0 = row0[k] + wk * (row0[k1] - row0[k]);
+                double v1 = row1[k] + wk * (row1[k1] - row1[k]);
+                volatilities[i] = v0 + wt * (v1 - v0);
+            }
+        }
+
         // PerpetualSwapPricingModel implementation for perpetual swaps
         PerpetualSwapPricingModel::PerpetualSwapPricingModel(const PricingParameters &params)
             : params_(params) {}
 // methods for calculating synthetic price, weights, and correlation
         SyntheticPrice PerpetualSwapPricingModel::calculate_synthetic_price(
-            const InstrumentId &target_instrument,
-            const std::vector<InstrumentId> &component_instruments,
+            InstrumentHandle target_instrument,
+            const std::vector<InstrumentHandle> &component_instruments,
             const MarketSnapshot &market_data)
         {
 
@@ -52,7 +213,7 @@ namespace spe
         }
 
         std::vector<double> PerpetualSwapPricingModel::calculate_weights(
-            const std::vector<InstrumentId> &instruments,
+            const std::vector<InstrumentHandle> &instruments,
             const MarketSnapshot &market_data)
         {
 
@@ -60,8 +221,8 @@ namespace spe
         }
         
         double PerpetualSwapPricingModel::calculate_correlation(
-            const InstrumentId &instrument1,
-            const InstrumentId &instrument2,
+            InstrumentHandle instrument1,
+            InstrumentHandle instrument2,
             const std::vector<Quote> &historical_data)
         {
 
@@ -73,24 +234,24 @@ namespace spe
             params_ = params;
         }
 
-        void PerpetualSwapPricingModel::update_funding_rate(const InstrumentId &instrument, const FundingRate &rate)
+        void PerpetualSwapPricingModel::update_funding_rate(InstrumentHandle instrument, const FundingRate &rate)
         {
             funding_rates_[instrument] = rate;
         }
 // handles funding rate updates and retrieval
-        double PerpetualSwapPricingModel::get_current_funding_rate(const InstrumentId &instrument) const
+        double PerpetualSwapPricingModel::get_current_funding_rate(InstrumentHandle instrument) const
         {
             auto it = funding_rates_.find(instrument);
             return (it != funding_rates_.end()) ? it->second.rate : 0.0001;
         }
 
-        double PerpetualSwapPricingModel::calculate_funding_payment(const InstrumentId &instrument, Volume position_size) const
+        double PerpetualSwapPricingModel::calculate_funding_payment(InstrumentHandle instrument, Volume position_size) const
         {
             double rate = get_current_funding_rate(instrument);
             return rate * position_size;
         }
 
-        double PerpetualSwapPricingModel::calculate_funding_component(const InstrumentId &instrument,
+        double PerpetualSwapPricingModel::calculate_funding_component(InstrumentHandle instrument,
                                                                       const MarketSnapshot &market_data,
                                                                       const FundingRate &funding_rate)
         {
@@ -117,8 +278,8 @@ namespace spe
             : params_(params) {}
 
         SyntheticPrice FuturesPricingModel::calculate_synthetic_price(
-            const InstrumentId &target_instrument,
-            const std::vector<InstrumentId> &component_instruments,
+            InstrumentHandle target_instrument,
+            const std::vector<InstrumentHandle> &component_instruments,
             const MarketSnapshot &market_data)
         {
 
@@ -134,7 +295,7 @@ namespace spe
         }
 
         std::vector<double> FuturesPricingModel::calculate_weights(
-            const std::vector<InstrumentId> &instruments,
+            const std::vector<InstrumentHandle> &instruments,
             const MarketSnapshot &market_data)
         {
 
@@ -142,8 +303,8 @@ namespace spe
         }
 
         double FuturesPricingModel::calculate_correlation(
-            const InstrumentId &instrument1,
-            const InstrumentId &instrument2,
+            InstrumentHandle instrument1,
+            InstrumentHandle instrument2,
             const std::vector<Quote> &historical_data)
         {
 
@@ -155,22 +316,85 @@ namespace spe
             params_ = params;
         }
 
-        void FuturesPricingModel::set_interest_rate(const InstrumentId &instrument, double rate)
+        void FuturesPricingModel::set_interest_rate(InstrumentHandle instrument, double rate)
         {
             interest_rates_[instrument] = rate;
         }
 
-        void FuturesPricingModel::set_dividend_yield(const InstrumentId &instrument, double yield)
+        void FuturesPricingModel::set_dividend_yield(InstrumentHandle instrument, double yield)
         {
             dividend_yields_[instrument] = yield;
         }
 
-        double FuturesPricingModel::calculate_basis(const InstrumentId &futures_instrument, const Quote &spot_quote) const
+        double FuturesPricingModel::calculate_basis(InstrumentHandle futures_instrument, const Quote &spot_quote) const
+        {
+            // Fair basis under cost of carry: F - S = S * (exp(carry * T) - 1)
+            double spot_mid = (spot_quote.bid_price + spot_quote.ask_price) / 2.0;
+            return spot_mid * std::expm1(get_carry_rate(futures_instrument) * get_time_to_maturity(futures_instrument));
+        }
+
+        namespace
+        {
+            const std::vector<InstrumentHandle> empty_listed_futures;
+
+            double lookup_rate(const std::map<InstrumentHandle, double> &rates, InstrumentHandle instrument,
+                               InstrumentHandle fallback)
+            {
+                auto it = rates.find(instrument);
+                if (it == rates.end())
+                {
+                    it = rates.find(fallback);
+                }
+                return it != rates.end() ? it->second : 0.0;
+            }
+        }
+
+        void FuturesPricingModel::register_futures_contract(InstrumentHandle futures, const FuturesContract &contract)
+        {
+            if (futures_contracts_.count(futures))
+            {
+                return;
+            }
+
+            futures_contracts_[futures] = contract;
+            auto &listed = listed_futures_[contract.underlying];
+            auto position = std::upper_bound(listed.begin(), listed.end(), contract.expiry,
+                                             [this](Timestamp expiry, InstrumentHandle other)
+                                             { return expiry < futures_contracts_.at(other).expiry; });
+            listed.insert(position, futures);
+        }
+
+        const FuturesContract *FuturesPricingModel::get_futures_contract(InstrumentHandle futures) const
+        {
+            auto it = futures_contracts_.find(futures);
+            return (it != futures_contracts_.end()) ? &it->second : nullptr;
+        }
+
+        const std::vector<InstrumentHandle> &FuturesPricingModel::get_listed_futures(InstrumentHandle underlying) const
+        {
+            auto it = listed_futures_.find(underlying);
+            return (it != listed_futures_.end()) ? it->second : empty_listed_futures;
+        }
+
+        double FuturesPricingModel::get_carry_rate(InstrumentHandle futures) const
         {
-            return 1.0; // Simplified basis calculation
+            const FuturesContract *contract = get_futures_contract(futures);
+            InstrumentHandle underlying = contract ? contract->underlying : INVALID_INSTRUMENT;
+            return lookup_rate(interest_rates_, futures, underlying) - lookup_rate(dividend_yields_, futures, underlying);
         }
 
-        double FuturesPricingModel::calculate_cost_of_carry(const InstrumentId &instrument,
+        double FuturesPricingModel::get_time_to_maturity(InstrumentHandle futures, Timestamp now) const
+        {
+            const FuturesContract *contract = get_futures_contract(futures);
+            if (!contract)
+            {
+                return 0.25; // 3 months for demo
+            }
+            std::chrono::duration<double> remaining = contract->expiry - now;
+            return std::max(remaining.count() / (365.0 * 24 * 3600), 0.0);
+        }
+
+        double FuturesPricingModel::calculate_cost_of_carry(InstrumentHandle instrument,
                                                             const MarketSnapshot &market_data,
                                                             double interest_rate,
                                                             double dividend_yield)
@@ -187,9 +411,427 @@ namespace spe
             return spot_mid * std::exp(cost_of_carry * time_to_maturity);
         }
 
-        double FuturesPricingModel::get_time_to_maturity(const InstrumentId &instrument) const
+        double FuturesPricingModel::get_time_to_maturity(InstrumentHandle instrument) const
+        {
+            return get_time_to_maturity(instrument, std::chrono::high_resolution_clock::now());
+        }
+
+        // OptionsPricingModel implementation; every price and Greek goes through the batch kernel
+        namespace
+        {
+            const std::vector<InstrumentHandle> empty_chain_options;
+        }
+
+        OptionsPricingModel::OptionsPricingModel(const PricingParameters &params)
+            : params_(params) {}
+
+        SyntheticPrice OptionsPricingModel::calculate_synthetic_price(
+            InstrumentHandle target_instrument,
+            const std::vector<InstrumentHandle> &component_instruments,
+            const MarketSnapshot &market_data)
+        {
+            SyntheticPrice result;
+            result.component_instruments = component_instruments;
+            result.weights = std::vector<double>(component_instruments.size(), 1.0);
+
+            auto contract = get_option_contract(target_instrument);
+            if (!contract || !market_data.has_quote(contract->underlying))
+            {
+                return result;
+            }
+
+            OptionChain chain;
+            chain.add(contract->strike, contract->time_to_expiry, 0.0, contract->is_call);
+            OptionChainGreeks greeks;
+            price_chain(contract->underlying, market_data.quote(contract->underlying), chain, greeks);
+
+            result.theoretical_price = greeks.prices[0];
+            result.bid_price = result.theoretical_price * (1.0 - params_.transaction_cost);
+            result.ask_price = result.theoretical_price * (1.0 + params_.transaction_cost);
+            result.confidence_score = 0.75;
+            if (!component_instruments.empty())
+            {
+                result.weights[0] = greeks.deltas[0]; // delta-hedge ratio on the underlying
+            }
+            return result;
+        }
+
+        std::vector<double> OptionsPricingModel::calculate_weights(
+            const std::vector<InstrumentHandle> &instruments,
+            const MarketSnapshot &)
+        {
+            return std::vector<double>(instruments.size(), 1.0 / instruments.size());
+        }
+
+        double OptionsPricingModel::calculate_correlation(
+            InstrumentHandle,
+            InstrumentHandle,
+            const std::vector<Quote> &)
+        {
+            return 0.70; // Simplified correlation for demo
+        }
+
+        void OptionsPricingModel::update_parameters(const PricingParameters &params)
+        {
+            params_ = params;
+        }
+
+        void OptionsPricingModel::update_volatility_surface(InstrumentHandle instrument, const VolatilitySurface &surface)
+        {
+            // Compile outside the flip so readers are only ever held off for a table copy
+            auto compiled = std::make_shared<const CompiledVolatilitySurface>(surface);
+            compiled_surfaces_.update([&](CompiledSurfaceTable &table)
+                                      {
+                                          volatility_surfaces_[instrument] = surface;
+                                          if (table.size() <= instrument)
+                                          {
+                                              table.resize(static_cast<size_t>(instrument) + 1);
+                                          }
+                                          table[instrument] = compiled; });
+        }
+
+        void OptionsPricingModel::set_risk_free_rate(InstrumentHandle instrument, double rate)
+        {
+            risk_free_rates_[instrument] = rate;
+        }
+
+        double OptionsPricingModel::get_volatility(InstrumentHandle underlying, double strike, double time_to_expiry) const
+        {
+            return compiled_surfaces_.read([&](const CompiledSurfaceTable &table)
+                                           {
+                                               if (underlying >= table.size() || !table[underlying] || table[underlying]->empty())
+                                               {
+                                                   return 0.2; // Default 20% volatility
+                                               }
+                                               return table[underlying]->interpolate(strike, time_to_expiry); });
+        }
+
+        void OptionsPricingModel::fill_chain_volatilities(InstrumentHandle underlying, OptionChain &chain) const
+        {
+            compiled_surfaces_.read([&](const CompiledSurfaceTable &table)
+                                    {
+                                        if (underlying >= table.size() || !table[underlying] || table[underlying]->empty())
+                                        {
+                                            std::fill(chain.volatilities.begin(), chain.volatilities.end(), 0.2);
+                                            return;
+                                        }
+                                        table[underlying]->interpolate(chain.strikes.data(), chain.expiries.data(),
+                                                                       chain.volatilities.data(), chain.size()); });
+        }
+
+        double OptionsPricingModel::get_risk_free_rate(InstrumentHandle underlying) const
+        {
+            auto it = risk_free_rates_.find(underlying);
+            return (it != risk_free_rates_.end()) ? it->second : 0.05;
+        }
+
+        void OptionsPricingModel::register_option(InstrumentHandle option, const OptionContract &contract)
+        {
+            if (option_contracts_.count(option))
+            {
+                return;
+            }
+
+            option_contracts_[option] = contract;
+            auto &entry = chains_[contract.underlying];
+            entry.options.push_back(option);
+            entry.chain.add(contract.strike, contract.time_to_expiry, 0.0, contract.is_call);
+        }
+
+        const OptionContract *OptionsPricingModel::get_option_contract(InstrumentHandle option) const
+        {
+            auto it = option_contracts_.find(option);
+            return (it != option_contracts_.end()) ? &it->second : nullptr;
+        }
+
+        const std::vector<InstrumentHandle> &OptionsPricingModel::get_chain_options(InstrumentHandle underlying) const
+        {
+            auto it = chains_.find(underlying);
+            return (it != chains_.end()) ? it->second.options : empty_chain_options;
+        }
+
+        const OptionChainGreeks &OptionsPricingModel::price_underlying_chain(InstrumentHandle underlying,
+                                                                             const Quote &spot_quote)
+        {
+            auto &entry = chains_[underlying];
+            auto &chain = entry.chain;
+            fill_chain_volatilities(underlying, chain);
+
+            double spot = (spot_quote.bid_price + spot_quote.ask_price) / 2.0;
+            price_option_chain(spot, get_risk_free_rate(underlying), chain, entry.greeks);
+            return entry.greeks;
+        }
+
+        void OptionsPricingModel::price_chain(InstrumentHandle underlying, const Quote &spot_quote,
+                                              OptionChain &chain, OptionChainGreeks &greeks) const
+        {
+            for (size_t i = 0; i < chain.size(); ++i)
+            {
+                if (chain.volatilities[i] <= 0)
+                {
+                    chain.volatilities[i] = get_volatility(underlying, chain.strikes[i], chain.expiries[i]);
+                }
+            }
+
+            double spot = (spot_quote.bid_price + spot_quote.ask_price) / 2.0;
+            price_option_chain(spot, get_risk_free_rate(underlying), chain, greeks);
+        }
+
+        std::map<std::string, double> OptionsPricingModel::calculate_greeks(InstrumentHandle option,
+                                                                            const Quote &spot_quote) const
+        {
+            std::map<std::string, double> result;
+            auto contract = get_option_contract(option);
+            if (!contract)
+            {
+                return result;
+            }
+
+            OptionChain chain;
+            chain.add(contract->strike, contract->time_to_expiry, 0.0, contract->is_call);
+            OptionChainGreeks greeks;
+            price_chain(contract->underlying, spot_quote, chain, greeks);
+
+            result["price"] = greeks.prices[0];
+            result["delta"] = greeks.deltas[0];
+            result["gamma"] = greeks.gammas[0];
+            result["theta"] = greeks.thetas[0];
+            result["vega"] = greeks.vegas[0];
+            result["rho"] = greeks.rhos[0];
+            return result;
+        }
+
+        double OptionsPricingModel::get_implied_volatility(InstrumentHandle option, const Quote &market_quote,
+                                                           const Quote &spot_quote) const
+        {
+            auto contract = get_option_contract(option);
+            if (!contract)
+            {
+                return 0.0;
+            }
+
+            // Newton on vega, seeded from the surface; falls back to the seed if it does not converge
+            double target = (market_quote.bid_price + market_quote.ask_price) / 2.0;
+            double seed = get_volatility(contract->underlying, contract->strike, contract->time_to_expiry);
+            double spot = (spot_quote.bid_price + spot_quote.ask_price) / 2.0;
+            double rate = get_risk_free_rate(contract->underlying);
+
+            OptionChain chain;
+            chain.add(contract->strike, contract->time_to_expiry, seed, contract->is_call);
+            OptionChainGreeks greeks;
+            for (int iteration = 0; iteration < 20; ++iteration)
+            {
+                price_option_chain(spot, rate, chain, greeks);
+                double error = greeks.prices[0] - target;
+                if (std::abs(error) < 1e-8 * std::max(1.0, target))
+                {
+                    return chain.volatilities[0];
+                }
+                if (greeks.vegas[0] < 1e-12)
+                {
+                    break;
+                }
+                chain.volatilities[0] = std::max(1e-4, chain.volatilities[0] - error / greeks.vegas[0]);
+            }
+            return seed;
+        }
+
+        namespace
+        {
+            // Pearson correlation of two instruments' mid log returns, taken from a mixed quote history
+            double quote_return_correlation(InstrumentHandle a, InstrumentHandle b, const std::vector<Quote> &quotes)
+            {
+                std::vector<double> returns_a;
+                std::vector<double> returns_b;
+                Price last_a = 0.0;
+                Price last_b = 0.0;
+                for (const auto &quote : quotes)
+                {
+                    Price mid = (quote.bid_price + quote.ask_price) / 2.0;
+                    if (mid <= 0.0)
+                    {
+                        continue;
+                    }
+                    if (quote.instrument == a)
+                    {
+                        if (last_a > 0.0)
+                        {
+                            returns_a.push_back(std::log(mid / last_a));
+                        }
+                        last_a = mid;
+                    }
+                    else if (quote.instrument == b)
+                    {
+                        if (last_b > 0.0)
+                        {
+                            returns_b.push_back(std::log(mid / last_b));
+                        }
+                        last_b = mid;
+                    }
+                }
+
+                size_t n = std::min(returns_a.size(), returns_b.size());
+                if (n < 2)
+                {
+                    return 0.0;
+                }
+                double mean_a = 0.0, mean_b = 0.0;
+                for (size_t i = 0; i < n; ++i)
+                {
+                    mean_a += returns_a[i];
+                    mean_b += returns_b[i];
+                }
+                mean_a /= n;
+                mean_b /= n;
+                double cross = 0.0, var_a = 0.0, var_b = 0.0;
+                for (size_t i = 0; i < n; ++i)
+                {
+                    double da = returns_a[i] - mean_a;
+                    double db = returns_b[i] - mean_b;
+                    cross += da * db;
+                    var_a += da * da;
+                    var_b += db * db;
+                }
+                return (var_a > 0.0 && var_b > 0.0) ? cross / std::sqrt(var_a * var_b) : 0.0;
+            }
+        }
+
+        // BasketPricingModel implementation for multi-instrument synthetics
+        BasketPricingModel::BasketPricingModel(const PricingParameters &params)
+            : params_(params) {}
+
+        SyntheticPrice BasketPricingModel::calculate_synthetic_price(
+            InstrumentHandle,
+            const std::vector<InstrumentHandle> &component_instruments,
+            const MarketSnapshot &market_data)
+        {
+            SyntheticPrice result;
+            result.component_instruments = component_instruments;
+            result.weights = calculate_weights(component_instruments, market_data);
+            for (auto instrument : component_instruments)
+            {
+                if (!market_data.has_quote(instrument))
+                {
+                    return result;
+                }
+            }
+
+            // Buying the basket lifts the long legs' asks and hits the short legs' bids
+            Price bid = 0.0;
+            Price ask = 0.0;
+            for (size_t i = 0; i < component_instruments.size(); ++i)
+            {
+                double weight = result.weights[i];
+                Price leg_bid = market_data.bid_price(component_instruments[i]);
+                Price leg_ask = market_data.ask_price(component_instruments[i]);
+                bid += weight * (weight >= 0.0 ? leg_bid : leg_ask);
+                ask += weight * (weight >= 0.0 ? leg_ask : leg_bid);
+            }
+            result.theoretical_price = calculate_basket_price(component_instruments, result.weights, market_data);
+            result.bid_price = bid - params_.transaction_cost * std::abs(result.theoretical_price);
+            result.ask_price = ask + params_.transaction_cost * std::abs(result.theoretical_price);
+
+            // Confidence falls as the basket's own volatility grows against volatility_adjustment
+            double volatility = calculate_portfolio_volatility(component_instruments, result.weights, market_data);
+            double relative = result.theoretical_price != 0.0 ? volatility / std::abs(result.theoretical_price) : 0.0;
+            result.confidence_score = params_.volatility_adjustment > 0.0
+                                          ? 1.0 / (1.0 + relative / params_.volatility_adjustment)
+                                          : 1.0;
+            return result;
+        }
+
+        std::vector<double> BasketPricingModel::calculate_weights(
+            const std::vector<InstrumentHandle> &instruments,
+            const MarketSnapshot &)
+        {
+            std::vector<double> weights(instruments.size(), instruments.empty() ? 0.0 : 1.0 / instruments.size());
+            for (size_t i = 0; i < instruments.size(); ++i)
+            {
+                InstrumentHandle instrument = instruments[i];
+                if (instrument < has_weight_.size() && has_weight_[instrument])
+                {
+                    weights[i] = instrument_weights_[instrument];
+                }
+            }
+            return weights;
+        }
+
+        double BasketPricingModel::calculate_correlation(
+            InstrumentHandle instrument1,
+            InstrumentHandle instrument2,
+            const std::vector<Quote> &historical_data)
+        {
+            const auto &matrix = correlation_matrix_;
+            if (matrix && matrix->contains(instrument1) && matrix->contains(instrument2) &&
+                matrix->observation_count() > 1)
+            {
+                return matrix->correlation(instrument1, instrument2);
+            }
+            return quote_return_correlation(instrument1, instrument2, historical_data);
+        }
+
+        void BasketPricingModel::update_parameters(const PricingParameters &params)
+        {
+            params_ = params;
+        }
+
+        void BasketPricingModel::set_instrument_weights(const std::map<InstrumentHandle, double> &weights)
+        {
+            std::fill(has_weight_.begin(), has_weight_.end(), 0);
+            for (const auto &[instrument, weight] : weights)
+            {
+                set_instrument_weight(instrument, weight);
+            }
+        }
+
+        void BasketPricingModel::set_instrument_weight(InstrumentHandle instrument, double weight)
         {
-            return 0.25; // 3 months for demo
+            if (instrument >= instrument_weights_.size())
+            {
+                instrument_weights_.resize(instrument + 1, 0.0);
+                has_weight_.resize(instrument + 1, 0);
+            }
+            instrument_weights_[instrument] = weight;
+            has_weight_[instrument] = 1;
+        }
+
+        double BasketPricingModel::calculate_basket_price(const std::vector<InstrumentHandle> &instruments,
+                                                          const std::vector<double> &weights,
+                                                          const MarketSnapshot &market_data)
+        {
+            Price price = 0.0;
+            for (size_t i = 0; i < instruments.size(); ++i)
+            {
+                price += weights[i] * market_data.mid_price(instruments[i]);
+            }
+            return price;
+        }
+
+        double BasketPricingModel::calculate_portfolio_volatility(const std::vector<InstrumentHandle> &instruments,
+                                                                  const std::vector<double> &weights,
+                                                                  const MarketSnapshot &market_data)
+        {
+            // Value variance is e' C e over the log-return covariance C, with exposures e = w * mid
+            const auto &matrix = correlation_matrix_;
+            if (!matrix || matrix->observation_count() < 2)
+            {
+                return 0.0;
+            }
+            for (auto instrument : instruments)
+            {
+                if (!matrix->contains(instrument))
+                {
+                    return 0.0;
+                }
+            }
+
+            linalg::gather_covariance(*matrix, instruments, covariance_);
+            exposures_.resize(instruments.size());
+            for (size_t i = 0; i < instruments.size(); ++i)
+            {
+                exposures_[i] = weights[i] * market_data.mid_price(instruments[i]);
+            }
+            return std::sqrt(std::max(0.0, linalg::quadratic_form(covariance_, exposures_.data())));
         }
 
     } // namespace pricing
@@ -0,0 +1,509 @@
+#include "thread_topology.hpp"
+#include "thread_affinity.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace spe
+{
+    namespace concurrency
+    {
+
+        namespace
+        {
+            // set_mempolicy modes, from linux/mempolicy.h (not every libc ships numaif.h)
+            constexpr int MEMPOLICY_DEFAULT = 0;
+            constexpr int MEMPOLICY_PREFERRED = 1;
+            constexpr int MAX_MEMPOLICY_NODE = 1024;
+            constexpr long CPU_LIMIT = 4095;
+
+            bool parse_int(const std::string &text, long min, long max, long &value)
+            {
+                if (text.empty())
+                {
+                    return false;
+                }
+                char *end = nullptr;
+                errno = 0;
+                value = std::strtol(text.c_str(), &end, 10);
+                return errno == 0 && *end == '\0' && value >= min && value <= max;
+            }
+
+            std::string trim(const std::string &text)
+            {
+                size_t first = text.find_first_not_of(" \t\r\n");
+                if (first == std::string::npos)
+                {
+                    return std::string();
+                }
+                size_t last = text.find_last_not_of(" \t\r\n");
+                return text.substr(first, last - first + 1);
+            }
+
+            bool read_cpu_list(const std::string &path, std::vector<int> &cpus)
+            {
+                std::ifstream file(path);
+                std::string line;
+                return file && std::getline(file, line) && parse_cpu_list(trim(line), cpus);
+            }
+
+            std::string format_cpu_list(const std::vector<int> &cpus)
+            {
+                std::vector<int> sorted(cpus);
+                std::sort(sorted.begin(), sorted.end());
+                sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+                std::string text;
+                for (size_t i = 0; i < sorted.size();)
+                {
+                    size_t run = i;
+                    while (run + 1 < sorted.size() && sorted[run + 1] == sorted[run] + 1)
+                    {
+                        ++run;
+                    }
+                    if (!text.empty())
+                    {
+                        text += ',';
+                    }
+                    text += std::to_string(sorted[i]);
+                    if (run > i)
+                    {
+                        text += '-';
+                        text += std::to_string(sorted[run]);
+                    }
+                    i = run + 1;
+                }
+                return text;
+            }
+
+            bool parse_wait_policy(const std::string &text, WaitPolicy &policy)
+            {
+                if (text == "busy")
+                {
+                    policy = WaitPolicy::BUSY_POLL;
+                }
+                else if (text == "spin")
+                {
+                    policy = WaitPolicy::SPIN_THEN_SLEEP;
+                }
+                else if (text == "sleep")
+                {
+                    policy = WaitPolicy::SLEEP;
+                }
+                else
+                {
+                    return false;
+                }
+                return true;
+            }
+
+            const char *wait_policy_setting(WaitPolicy policy)
+            {
+                switch (policy)
+                {
+                case WaitPolicy::BUSY_POLL:
+                    return "busy";
+                case WaitPolicy::SPIN_THEN_SLEEP:
+                    return "spin";
+                case WaitPolicy::SLEEP:
+                    break;
+                }
+                return "sleep";
+            }
+
+            // The stage's CPUs, or its node's when it only names a node
+            std::vector<int> placement_cpus(const StagePlacement &placement, const CpuTopology &topology)
+            {
+                if (!placement.cpus.empty() || placement.numa_node < 0)
+                {
+                    return placement.cpus;
+                }
+                const NumaNode *node = topology.node(placement.numa_node);
+                return node ? node->cpus : std::vector<int>();
+            }
+        }
+
+        bool parse_cpu_list(const std::string &text, std::vector<int> &cpus)
+        {
+            std::vector<int> parsed;
+            std::stringstream stream(text);
+            std::string item;
+            while (std::getline(stream, item, ','))
+            {
+                item = trim(item);
+                size_t dash = item.find('-');
+                long first = 0;
+                long last = 0;
+                if (dash == std::string::npos)
+                {
+                    if (!parse_int(item, 0, CPU_LIMIT, first))
+                    {
+                        return false;
+                    }
+                    last = first;
+                }
+                else if (!parse_int(item.substr(0, dash), 0, CPU_LIMIT, first) ||
+                         !parse_int(item.substr(dash + 1), 0, CPU_LIMIT, last) || last < first)
+                {
+                    return false;
+                }
+                for (long cpu = first; cpu <= last; ++cpu)
+                {
+                    parsed.push_back(static_cast<int>(cpu));
+                }
+            }
+            if (parsed.empty())
+            {
+                return false;
+            }
+            cpus = std::move(parsed);
+            return true;
+        }
+
+        const char *wait_policy_name(WaitPolicy policy)
+        {
+            switch (policy)
+            {
+            case WaitPolicy::BUSY_POLL:
+                return "BUSY_POLL";
+            case WaitPolicy::SPIN_THEN_SLEEP:
+                return "SPIN_THEN_SLEEP";
+            case WaitPolicy::SLEEP:
+                break;
+            }
+            return "SLEEP";
+        }
+
+        CpuTopology::CpuTopology(std::vector<NumaNode> nodes) : nodes_(std::move(nodes))
+        {
+            std::sort(nodes_.begin(), nodes_.end(), [](const NumaNode &a, const NumaNode &b)
+                      { return a.id < b.id; });
+            for (const auto &node : nodes_)
+            {
+                for (int cpu : node.cpus)
+                {
+                    if (cpu < 0)
+                    {
+                        continue;
+                    }
+                    if (static_cast<size_t>(cpu) >= cpu_nodes_.size())
+                    {
+                        cpu_nodes_.resize(cpu + 1, -1);
+                    }
+                    cpu_nodes_[cpu] = node.id;
+                }
+            }
+        }
+
+        CpuTopology CpuTopology::detect()
+        {
+            std::vector<NumaNode> nodes;
+#if defined(__linux__)
+            if (DIR *directory = opendir("/sys/devices/system/node"))
+            {
+                while (dirent *entry = readdir(directory))
+                {
+                    std::string name = entry->d_name;
+                    long id = 0;
+                    if (name.compare(0, 4, "node") != 0 || !parse_int(name.substr(4), 0, MAX_MEMPOLICY_NODE - 1, id))
+                    {
+                        continue;
+                    }
+                    NumaNode node;
+                    node.id = static_cast<int>(id);
+                    // Memory-only nodes have an empty cpulist and nothing to pin to
+                    if (read_cpu_list("/sys/devices/system/node/" + name + "/cpulist", node.cpus))
+                    {
+                        nodes.push_back(std::move(node));
+                    }
+                }
+                closedir(directory);
+            }
+            if (nodes.empty())
+            {
+                NumaNode node;
+                if (read_cpu_list("/sys/devices/system/cpu/online", node.cpus))
+                {
+                    nodes.push_back(std::move(node));
+                }
+            }
+#endif
+            if (nodes.empty())
+            {
+                NumaNode node;
+                unsigned count = std::max(1u, std::thread::hardware_concurrency());
+                for (unsigned cpu = 0; cpu < count; ++cpu)
+                {
+                    node.cpus.push_back(static_cast<int>(cpu));
+                }
+                nodes.push_back(std::move(node));
+            }
+            return CpuTopology(std::move(nodes));
+        }
+
+        const CpuTopology &CpuTopology::system()
+        {
+            static const CpuTopology topology = detect();
+            return topology;
+        }
+
+        const NumaNode *CpuTopology::node(int id) const
+        {
+            for (const auto &node : nodes_)
+            {
+                if (node.id == id)
+                {
+                    return &node;
+                }
+            }
+            return nullptr;
+        }
+
+        size_t CpuTopology::cpu_count() const
+        {
+            size_t count = 0;
+            for (const auto &node : nodes_)
+            {
+                count += node.cpus.size();
+            }
+            return count;
+        }
+
+        bool prefer_memory_node(int node)
+        {
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+            if (node < 0)
+            {
+                return syscall(SYS_set_mempolicy, MEMPOLICY_DEFAULT, nullptr, 0UL) == 0;
+            }
+            if (node >= MAX_MEMPOLICY_NODE)
+            {
+                return false;
+            }
+            constexpr size_t BITS = 8 * sizeof(unsigned long);
+            unsigned long mask[MAX_MEMPOLICY_NODE / BITS] = {};
+            mask[node / BITS] |= 1UL << (node % BITS);
+            // maxnode counts one past the last bit the kernel reads
+            return syscall(SYS_set_mempolicy, MEMPOLICY_PREFERRED, mask,
+                           static_cast<unsigned long>(MAX_MEMPOLICY_NODE) + 1) == 0;
+#else
+            return node < 0;
+#endif
+        }
+
+        bool apply_placement(const StagePlacement &placement, const CpuTopology &topology)
+        {
+            if (placement.floating())
+            {
+                return true;
+            }
+
+            std::vector<int> cpus = placement_cpus(placement, topology);
+            bool applied = !cpus.empty() && pin_current_thread(cpus);
+
+            int node = placement.numa_node;
+            if (node < 0 && !cpus.empty())
+            {
+                node = topology.node_of(cpus.front());
+                for (int cpu : cpus)
+                {
+                    if (topology.node_of(cpu) != node)
+                    {
+                        node = -1; // spans nodes: leave memory to the default (local) policy
+                        break;
+                    }
+                }
+            }
+            // On a single node every allocation is already local
+            if (node >= 0 && topology.nodes().size() > 1)
+            {
+                applied = prefer_memory_node(node) && applied;
+            }
+            return applied;
+        }
+
+        bool ThreadTopology::is_stage(const std::string &stage)
+        {
+            return stage == IO || stage == PARSE || stage == DETECTOR || stage == DETECTOR_SHARDS ||
+                   stage == ARBITRAGE || stage == RISK;
+        }
+
+        StagePlacement ThreadTopology::placement(const std::string &stage) const
+        {
+            auto it = stages_.find(stage);
+            return it == stages_.end() ? StagePlacement{} : it->second;
+        }
+
+        bool ThreadTopology::parse(const std::string &text, ThreadTopology &out, std::string &error)
+        {
+            ThreadTopology parsed;
+            std::stringstream entries(text);
+            std::string entry;
+            while (std::getline(entries, entry, ';'))
+            {
+                std::stringstream fields(entry);
+                std::string stage;
+                if (!(fields >> stage))
+                {
+                    continue; // empty entry, e.g. a trailing ';'
+                }
+                if (!is_stage(stage))
+                {
+                    error = "unknown stage '" + stage + "'";
+                    return false;
+                }
+                if (parsed.has(stage))
+                {
+                    error = "stage '" + stage + "' is placed twice";
+                    return false;
+                }
+
+                StagePlacement placement;
+                std::string setting;
+                while (fields >> setting)
+                {
+                    size_t equals = setting.find('=');
+                    std::string key = setting.substr(0, equals);
+                    std::string value = equals == std::string::npos ? std::string() : setting.substr(equals + 1);
+                    long number = 0;
+                    bool valid = true;
+                    if (key == "cpus" || key == "cpu")
+                    {
+                        valid = parse_cpu_list(value, placement.cpus);
+                    }
+                    else if (key == "node")
+                    {
+                        valid = parse_int(value, 0, MAX_MEMPOLICY_NODE - 1, number);
+                        placement.numa_node = static_cast<int>(number);
+                    }
+                    else if (key == "wait")
+                    {
+                        valid = parse_wait_policy(value, placement.wait);
+                    }
+                    else if (key == "sleep_us")
+                    {
+                        valid = parse_int(value, 0, 1000000, number);
+                        placement.idle_sleep = std::chrono::microseconds(number);
+                    }
+                    else if (key == "spin")
+                    {
+                        valid = parse_int(value, 0, UINT32_MAX, number);
+                        placement.spin_iterations = static_cast<uint32_t>(number);
+                    }
+                    else
+                    {
+                        error = "unknown setting '" + key + "' for stage '" + stage + "'";
+                        return false;
+                    }
+                    if (!valid)
+                    {
+                        error = "bad value '" + value + "' for " + key + " of stage '" + stage + "'";
+                        return false;
+                    }
+                }
+                parsed.set(stage, std::move(placement));
+            }
+            out = std::move(parsed);
+            return true;
+        }
+
+        bool ThreadTopology::validate(const CpuTopology &topology, std::string &error) const
+        {
+            std::map<int, std::string> busy_cpus; // CPU -> the busy-polling stage pinned there
+            for (const auto &stage : stages_)
+            {
+                const StagePlacement &placement = stage.second;
+                if (placement.numa_node >= 0 && !topology.node(placement.numa_node))
+                {
+                    error = "stage '" + stage.first + "' is placed on node " + std::to_string(placement.numa_node) +
+                            ", which has no CPUs";
+                    return false;
+                }
+                for (int cpu : placement.cpus)
+                {
+                    if (!topology.has_cpu(cpu))
+                    {
+                        error = "stage '" + stage.first + "' is pinned to CPU " + std::to_string(cpu) + ", which is not online";
+                        return false;
+                    }
+                    if (placement.numa_node >= 0 && topology.node_of(cpu) != placement.numa_node)
+                    {
+                        error = "stage '" + stage.first + "' is pinned to CPU " + std::to_string(cpu) + ", which is not on node " +
+                                std::to_string(placement.numa_node);
+                        return false;
+                    }
+                }
+                if (placement.wait != WaitPolicy::BUSY_POLL)
+                {
+                    continue;
+                }
+                for (int cpu : placement_cpus(placement, topology))
+                {
+                    auto inserted = busy_cpus.emplace(cpu, stage.first);
+                    if (!inserted.second)
+                    {
+                        error = "stages '" + inserted.first->second + "' and '" + stage.first +
+                                "' both busy-poll on CPU " + std::to_string(cpu);
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        std::vector<StagePlacement> ThreadTopology::worker_placements(const std::string &stage, size_t count,
+                                                                      const CpuTopology &topology) const
+        {
+            StagePlacement placement = this->placement(stage);
+            std::vector<int> cpus = placement_cpus(placement, topology);
+
+            std::vector<StagePlacement> workers(count, placement);
+            for (size_t i = 0; i < count && !cpus.empty(); ++i)
+            {
+                workers[i].cpus = {cpus[i % cpus.size()]};
+            }
+            return workers;
+        }
+
+        std::string ThreadTopology::describe() const
+        {
+            std::string text;
+            for (const auto &stage : stages_)
+            {
+                const StagePlacement &placement = stage.second;
+                if (!text.empty())
+                {
+                    text += "; ";
+                }
+                text += stage.first;
+                if (!placement.cpus.empty())
+                {
+                    text += " cpus=" + format_cpu_list(placement.cpus);
+                }
+                if (placement.numa_node >= 0)
+                {
+                    text += " node=" + std::to_string(placement.numa_node);
+                }
+                text += std::string(" wait=") + wait_policy_setting(placement.wait);
+                if (placement.wait == WaitPolicy::SPIN_THEN_SLEEP)
+                {
+                    text += " spin=" + std::to_string(placement.spin_iterations);
+                }
+                if (placement.wait != WaitPolicy::BUSY_POLL)
+                {
+                    text += " sleep_us=" + std::to_string(placement.idle_sleep.count());
+                }
+            }
+            return text;
+        }
+
+    } // namespace concurrency
+} // namespace spe
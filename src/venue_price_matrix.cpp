@@ -0,0 +1,428 @@
+#include "venue_price_matrix.hpp"
+#include "venue_scan_kernel.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace spe
+{
+    namespace pricing
+    {
+
+        namespace
+        {
+            const SyntheticPrice NO_SYNTHETIC;
+            const std::vector<InstrumentHandle> NO_COMPONENTS;
+
+            // Widens every venue row of a venue-major column to new_stride
+            template <typename T>
+            void restride(std::vector<T> &column, size_t venues, size_t old_stride, size_t new_stride, const T &fill)
+            {
+                std::vector<T> wider(venues * new_stride, fill);
+                for (size_t v = 0; v < venues; ++v)
+                {
+                    std::move(column.begin() + v * old_stride, column.begin() + (v + 1) * old_stride,
+                              wider.begin() + v * new_stride);
+                }
+                column.swap(wider);
+            }
+
+            void scan_venues_simd(const detail::VenueScanKernelArgs &args)
+            {
+                SimdLevel level = active_simd_level();
+                if (level == SimdLevel::AVX512 && detail::scan_venues_avx512(args))
+                {
+                    return;
+                }
+                if (level >= SimdLevel::AVX2 && detail::scan_venues_avx2(args))
+                {
+                    return;
+                }
+                detail::scan_venues_scalar(args);
+            }
+        }
+
+        VenueBest VenueScan::at(InstrumentHandle instrument) const
+        {
+            VenueBest best;
+            if (instrument >= size())
+            {
+                return best;
+            }
+            if (best_bid_venues[instrument] >= 0.0)
+            {
+                best.bid_venue = static_cast<VenueIndex>(best_bid_venues[instrument]);
+                best.bid = best_bids[instrument];
+            }
+            if (best_ask_venues[instrument] >= 0.0)
+            {
+                best.ask_venue = static_cast<VenueIndex>(best_ask_venues[instrument]);
+                best.ask = best_asks[instrument];
+            }
+            return best;
+        }
+
+        VenuePriceMatrix::VenuePriceMatrix(double latency_cost_per_ms)
+            : latency_cost_per_ms_(latency_cost_per_ms), stride_(0)
+        {
+        }
+
+        VenueIndex VenuePriceMatrix::add_venue(const std::string &venue_id, double transaction_cost, double latency_ms)
+        {
+            auto it = venue_by_id_.find(venue_id);
+            if (it != venue_by_id_.end())
+            {
+                venues_[it->second].transaction_cost = transaction_cost;
+                venues_[it->second].latency_ms = latency_ms;
+                update_factors(it->second);
+                return it->second;
+            }
+
+            VenueIndex venue = static_cast<VenueIndex>(venues_.size());
+            venues_.push_back(Venue{venue_id, transaction_cost, latency_ms, MarketSnapshot()});
+            venue_by_id_.emplace(venue_id, venue);
+            bid_factors_.push_back(1.0);
+            ask_factors_.push_back(1.0);
+            update_factors(venue);
+
+            size_t cells = venues_.size() * stride_;
+            bids_.resize(cells, 0.0);
+            asks_.resize(cells, 0.0);
+            bid_sizes_.resize(cells, 0.0);
+            ask_sizes_.resize(cells, 0.0);
+            quote_versions_.resize(cells, 0);
+            synthetic_bids_.resize(cells, 0.0);
+            synthetic_asks_.resize(cells, 0.0);
+            synthetic_prices_.resize(cells);
+            synthetic_versions_.resize(cells, 0);
+            stale_.resize(cells, 0);
+
+            // The new venue can replicate every registered target once its components quote
+            for (InstrumentHandle target : targets_)
+            {
+                mark_stale(venue, target);
+            }
+            return venue;
+        }
+
+        VenueIndex VenuePriceMatrix::venue_index(const std::string &venue_id) const
+        {
+            auto it = venue_by_id_.find(venue_id);
+            return it == venue_by_id_.end() ? INVALID_VENUE : it->second;
+        }
+
+        void VenuePriceMatrix::set_latency_cost_per_ms(double cost)
+        {
+            latency_cost_per_ms_ = cost;
+            for (VenueIndex venue = 0; venue < venues_.size(); ++venue)
+            {
+                update_factors(venue);
+            }
+        }
+
+        void VenuePriceMatrix::update_factors(VenueIndex venue)
+        {
+            double cost = venues_[venue].transaction_cost + venues_[venue].latency_ms * latency_cost_per_ms_;
+            bid_factors_[venue] = 1.0 - cost;
+            ask_factors_[venue] = 1.0 + cost;
+        }
+
+        void VenuePriceMatrix::ensure_capacity(InstrumentHandle instrument)
+        {
+            if (instrument < stride_)
+            {
+                return;
+            }
+
+            // Doubling keeps re-layouts rare as handles are interned
+            size_t needed = (size_t(instrument) / LANE_BLOCK + 1) * LANE_BLOCK;
+            size_t stride = std::max(needed, 2 * stride_);
+            size_t venues = venues_.size();
+            restride(bids_, venues, stride_, stride, 0.0);
+            restride(asks_, venues, stride_, stride, 0.0);
+            restride(bid_sizes_, venues, stride_, stride, 0.0);
+            restride(ask_sizes_, venues, stride_, stride, 0.0);
+            restride(quote_versions_, venues, stride_, stride, uint64_t(0));
+            restride(synthetic_bids_, venues, stride_, stride, 0.0);
+            restride(synthetic_asks_, venues, stride_, stride, 0.0);
+            restride(synthetic_prices_, venues, stride_, stride, NO_SYNTHETIC);
+            restride(synthetic_versions_, venues, stride_, stride, uint64_t(0));
+            restride(stale_, venues, stride_, stride, uint8_t(0));
+            stride_ = stride;
+        }
+
+        void VenuePriceMatrix::mark_stale(VenueIndex venue, InstrumentHandle target)
+        {
+            size_t index = cell(venue, target);
+            if (!stale_[index])
+            {
+                stale_[index] = 1;
+                stale_cells_.emplace_back(venue, target);
+            }
+        }
+
+        void VenuePriceMatrix::set_components(InstrumentHandle target, const std::vector<InstrumentHandle> &components)
+        {
+            InstrumentHandle highest = target;
+            for (InstrumentHandle component : components)
+            {
+                highest = std::max(highest, component);
+            }
+            ensure_capacity(highest);
+            if (components_.size() <= highest)
+            {
+                components_.resize(highest + 1);
+                dependents_.resize(highest + 1);
+            }
+
+            for (InstrumentHandle component : components_[target])
+            {
+                auto &dependents = dependents_[component];
+                dependents.erase(std::remove(dependents.begin(), dependents.end(), target), dependents.end());
+            }
+            components_[target] = components;
+            for (InstrumentHandle component : components)
+            {
+                auto &dependents = dependents_[component];
+                if (std::find(dependents.begin(), dependents.end(), target) == dependents.end())
+                {
+                    dependents.push_back(target);
+                }
+            }
+
+            auto listed = std::find(targets_.begin(), targets_.end(), target);
+            if (components.empty())
+            {
+                if (listed != targets_.end())
+                {
+                    targets_.erase(listed);
+                }
+                for (VenueIndex venue = 0; venue < venues_.size(); ++venue)
+                {
+                    size_t index = cell(venue, target);
+                    synthetic_bids_[index] = 0.0;
+                    synthetic_asks_[index] = 0.0;
+                    synthetic_prices_[index] = NO_SYNTHETIC;
+                    ++synthetic_versions_[index];
+                }
+                return;
+            }
+            if (listed == targets_.end())
+            {
+                targets_.push_back(target);
+            }
+            for (VenueIndex venue = 0; venue < venues_.size(); ++venue)
+            {
+                mark_stale(venue, target);
+            }
+        }
+
+        const std::vector<InstrumentHandle> &VenuePriceMatrix::components(InstrumentHandle target) const
+        {
+            return target < components_.size() ? components_[target] : NO_COMPONENTS;
+        }
+
+        bool VenuePriceMatrix::apply_quote(VenueIndex venue, const Quote &quote)
+        {
+            ensure_capacity(quote.instrument);
+            size_t index = cell(venue, quote.instrument);
+            bid_sizes_[index] = quote.bid_size;
+            ask_sizes_[index] = quote.ask_size;
+            if (bids_[index] == quote.bid_price && asks_[index] == quote.ask_price)
+            {
+                return false;
+            }
+
+            bids_[index] = quote.bid_price;
+            asks_[index] = quote.ask_price;
+            ++quote_versions_[index];
+            if (quote.instrument < dependents_.size())
+            {
+                for (InstrumentHandle target : dependents_[quote.instrument])
+                {
+                    mark_stale(venue, target);
+                }
+            }
+            return true;
+        }
+
+        size_t VenuePriceMatrix::apply_snapshot(VenueIndex venue, const MarketSnapshot &snapshot, bool full)
+        {
+            // A dirty list only describes changes against the same store's previous publish
+            full = full || venues_[venue].snapshot.store() != snapshot.store();
+            venues_[venue].snapshot = snapshot;
+            if (!snapshot.store())
+            {
+                return 0;
+            }
+
+            size_t changed = 0;
+            for (InstrumentHandle instrument : full ? snapshot.instruments() : snapshot.dirty_instruments())
+            {
+                if (snapshot.has_quote(instrument) && apply_quote(venue, snapshot.quote(instrument)))
+                {
+                    ++changed;
+                }
+            }
+            return changed;
+        }
+
+        size_t VenuePriceMatrix::refresh_synthetics(const SyntheticPriceFunction &price)
+        {
+            size_t refreshed = 0;
+            for (const auto &[venue, target] : stale_cells_)
+            {
+                size_t index = cell(venue, target);
+                stale_[index] = 0;
+                if (!is_target(target))
+                {
+                    continue;
+                }
+
+                // A venue replicates the target only while it quotes every component
+                const auto &components = components_[target];
+                bool quoted = std::all_of(components.begin(), components.end(),
+                                          [&](InstrumentHandle component) { return has_quote(venue, component); });
+                SyntheticPrice &synthetic = synthetic_prices_[index];
+                if (quoted)
+                {
+                    synthetic = price(venue, target, components);
+                    if (synthetic.bid_price <= 0.0 || synthetic.ask_price <= 0.0)
+                    {
+                        synthetic.bid_price = synthetic.theoretical_price; // model gives a level only
+                        synthetic.ask_price = synthetic.theoretical_price;
+                    }
+                }
+                else
+                {
+                    synthetic = NO_SYNTHETIC;
+                }
+                synthetic_bids_[index] = std::max(synthetic.bid_price, 0.0);
+                synthetic_asks_[index] = std::max(synthetic.ask_price, 0.0);
+                ++synthetic_versions_[index];
+                ++refreshed;
+            }
+            stale_cells_.clear();
+            return refreshed;
+        }
+
+        const SyntheticPrice &VenuePriceMatrix::synthetic(VenueIndex venue, InstrumentHandle target) const
+        {
+            if (venue >= venues_.size() || target >= stride_)
+            {
+                return NO_SYNTHETIC;
+            }
+            return synthetic_prices_[cell(venue, target)];
+        }
+
+        SyntheticPrice VenuePriceMatrix::replication(VenuePriceSource source, VenueIndex venue,
+                                                     InstrumentHandle instrument) const
+        {
+            if (source == VenuePriceSource::SYNTHETIC && is_target(instrument))
+            {
+                return synthetic(venue, instrument);
+            }
+            SyntheticPrice quoted;
+            if (venue < venues_.size() && has_quote(venue, instrument))
+            {
+                quoted.bid_price = bid(venue, instrument);
+                quoted.ask_price = ask(venue, instrument);
+                quoted.theoretical_price = (quoted.bid_price + quoted.ask_price) / 2.0;
+                quoted.confidence_score = 1.0; // executable as quoted
+                quoted.component_instruments = {instrument};
+                quoted.weights = {1.0};
+            }
+            return quoted;
+        }
+
+        Volume VenuePriceMatrix::available_size(VenuePriceSource source, VenueIndex venue, InstrumentHandle instrument,
+                                                bool buying) const
+        {
+            if (venue >= venues_.size() || instrument >= stride_)
+            {
+                return 0.0;
+            }
+            if (source == VenuePriceSource::QUOTES || !is_target(instrument))
+            {
+                return buying ? ask_size(venue, instrument) : bid_size(venue, instrument);
+            }
+
+            // Buying the replica buys the positively weighted components and sells the others
+            const auto &components = components_[instrument];
+            const auto &weights = synthetic_prices_[cell(venue, instrument)].weights;
+            Volume available = std::numeric_limits<Volume>::max();
+            for (size_t k = 0; k < components.size(); ++k)
+            {
+                double weight = k < weights.size() ? weights[k] : 1.0;
+                if (weight == 0.0)
+                {
+                    continue;
+                }
+                bool buy_component = (weight > 0.0) == buying;
+                Volume size = buy_component ? ask_size(venue, components[k]) : bid_size(venue, components[k]);
+                available = std::min(available, size / std::abs(weight));
+            }
+            return available == std::numeric_limits<Volume>::max() ? 0.0 : available;
+        }
+
+        VenueBest VenuePriceMatrix::best(VenuePriceSource source, InstrumentHandle instrument, VenueIndex exclude) const
+        {
+            VenueBest best;
+            if (instrument >= stride_)
+            {
+                return best;
+            }
+
+            bool quotes = source == VenuePriceSource::QUOTES;
+            const std::vector<Price> &bids = quotes ? bids_ : synthetic_bids_;
+            const std::vector<Price> &asks = quotes ? asks_ : synthetic_asks_;
+            for (VenueIndex venue = 0; venue < venues_.size(); ++venue)
+            {
+                if (venue == exclude)
+                {
+                    continue;
+                }
+                size_t index = cell(venue, instrument);
+                Price bid = bids[index] * bid_factors_[venue];
+                if (bid > best.bid)
+                {
+                    best.bid = bid;
+                    best.bid_venue = venue;
+                }
+                if (asks[index] > 0.0)
+                {
+                    Price ask = asks[index] * ask_factors_[venue];
+                    if (best.ask_venue == INVALID_VENUE || ask < best.ask)
+                    {
+                        best.ask = ask;
+                        best.ask_venue = venue;
+                    }
+                }
+            }
+            return best;
+        }
+
+        const VenueScan &VenuePriceMatrix::scan(VenuePriceSource source)
+        {
+            bool quotes = source == VenuePriceSource::QUOTES;
+            VenueScan &result = quotes ? quote_scan_ : synthetic_scan_;
+            result.best_bids.resize(stride_);
+            result.best_bid_venues.resize(stride_);
+            result.best_asks.resize(stride_);
+            result.best_ask_venues.resize(stride_);
+            if (stride_ == 0)
+            {
+                return result;
+            }
+
+            detail::VenueScanKernelArgs args{
+                venues_.size(), stride_, stride_,
+                quotes ? bids_.data() : synthetic_bids_.data(), quotes ? asks_.data() : synthetic_asks_.data(),
+                bid_factors_.data(), ask_factors_.data(),
+                result.best_bids.data(), result.best_bid_venues.data(),
+                result.best_asks.data(), result.best_ask_venues.data()};
+            scan_venues_simd(args);
+            return result;
+        }
+
+    } // namespace pricing
+} // namespace spe
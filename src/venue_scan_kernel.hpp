@@ -0,0 +1,80 @@
+#pragma once
+
+// Private to VenuePriceMatrix. Like option_batch_kernel.hpp, it is included by the per-ISA
+// translation units, so it must stay free of standard containers and other inline library
+// code that the linker could merge across ISAs.
+
+#include "option_batch_kernel.hpp"
+#include <cstddef>
+#include <limits>
+
+namespace spe
+{
+    namespace pricing
+    {
+        namespace detail
+        {
+
+            struct VenueScanKernelArgs
+            {
+                size_t venues;
+                size_t lanes;  // instruments scanned, a multiple of the widest register
+                size_t stride; // distance between venue rows, at least lanes
+                const double *bids; // venues x stride, venue-major; 0 where the venue has no price
+                const double *asks; // venues x stride, venue-major; 0 where the venue has no price
+                const double *bid_factors; // per venue: 1 - (fee + latency cost)
+                const double *ask_factors; // per venue: 1 + (fee + latency cost)
+
+                double *best_bids;       // lanes: highest effective bid, 0 when none
+                double *best_bid_venues; // lanes: its venue, -1 when none
+                double *best_asks;       // lanes: lowest effective ask, +inf when none
+                double *best_ask_venues; // lanes: its venue, -1 when none
+            };
+
+            void scan_venues_scalar(const VenueScanKernelArgs &args);
+            bool scan_venues_avx2(const VenueScanKernelArgs &args);   // false if not built in
+            bool scan_venues_avx512(const VenueScanKernelArgs &args); // false if not built in
+
+            // One register of instruments at a time, folded over the venue rows; ties keep the
+            // lower venue
+            template <typename Ops>
+            void scan_venues_kernel(const VenueScanKernelArgs &args)
+            {
+                using reg = typename Ops::reg;
+                constexpr size_t width = Ops::width;
+                const reg zero = Ops::set1(0.0);
+                const reg none = Ops::set1(-1.0);
+                const reg infinity = Ops::set1(std::numeric_limits<double>::infinity());
+
+                for (size_t j = 0; j < args.lanes; j += width)
+                {
+                    reg best_bid = zero;
+                    reg best_bid_venue = none;
+                    reg best_ask = infinity;
+                    reg best_ask_venue = none;
+
+                    for (size_t v = 0; v < args.venues; ++v)
+                    {
+                        reg venue = Ops::set1(static_cast<double>(v));
+                        reg bid = Ops::mul(Ops::load(args.bids + v * args.stride + j), Ops::set1(args.bid_factors[v]));
+                        typename Ops::mask better_bid = Ops::gt(bid, best_bid);
+                        best_bid = Ops::blend(better_bid, bid, best_bid);
+                        best_bid_venue = Ops::blend(better_bid, venue, best_bid_venue);
+
+                        reg raw_ask = Ops::load(args.asks + v * args.stride + j);
+                        reg ask = Ops::blend(Ops::gt(raw_ask, zero), Ops::mul(raw_ask, Ops::set1(args.ask_factors[v])), infinity);
+                        typename Ops::mask better_ask = Ops::lt(ask, best_ask);
+                        best_ask = Ops::blend(better_ask, ask, best_ask);
+                        best_ask_venue = Ops::blend(better_ask, venue, best_ask_venue);
+                    }
+
+                    Ops::store(args.best_bids + j, best_bid);
+                    Ops::store(args.best_bid_venues + j, best_bid_venue);
+                    Ops::store(args.best_asks + j, best_ask);
+                    Ops::store(args.best_ask_venues + j, best_ask_venue);
+                }
+            }
+
+        } // namespace detail
+    } // namespace pricing
+} // namespace spe
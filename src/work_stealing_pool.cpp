@@ -0,0 +1,245 @@
+#include "work_stealing_pool.hpp"
+#include <algorithm>
+
+namespace spe
+{
+    namespace concurrency
+    {
+
+        namespace
+        {
+            constexpr size_t INITIAL_DEQUE_CAPACITY = 256;
+
+            void record_status(std::vector<TaskRunStatus> *status, size_t index,
+                               std::chrono::steady_clock::time_point start, std::chrono::nanoseconds deadline)
+            {
+                if (!status)
+                {
+                    return;
+                }
+                auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+                (*status)[index].elapsed = elapsed;
+                (*status)[index].late = elapsed > deadline;
+            }
+        }
+
+        WorkStealingPool::WorkStealingPool(size_t thread_count, const std::vector<int> &cpus)
+            : task_(nullptr), remaining_(0), deadline_(std::chrono::nanoseconds::max()), status_(nullptr),
+              generation_(0), stopping_(false)
+        {
+            std::vector<StagePlacement> placements(thread_count);
+            for (size_t i = 0; i < thread_count && i < cpus.size(); ++i)
+            {
+                if (cpus[i] >= 0)
+                {
+                    placements[i].cpus = {cpus[i]};
+                }
+            }
+            start_workers(placements);
+        }
+
+        WorkStealingPool::WorkStealingPool(const std::vector<StagePlacement> &placements)
+            : task_(nullptr), remaining_(0), deadline_(std::chrono::nanoseconds::max()), status_(nullptr),
+              generation_(0), stopping_(false)
+        {
+            start_workers(placements);
+        }
+
+        void WorkStealingPool::start_workers(const std::vector<StagePlacement> &placements)
+        {
+            size_t thread_count = placements.size();
+            for (size_t i = 0; i <= thread_count; ++i)
+            {
+                queues_.push_back(std::make_unique<WorkerQueue>());
+            }
+            workers_.reserve(thread_count);
+            for (size_t i = 0; i < thread_count; ++i)
+            {
+                workers_.emplace_back(&WorkStealingPool::worker_loop, this, i, placements[i]);
+            }
+        }
+
+        WorkStealingPool::~WorkStealingPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex_);
+                stopping_ = true;
+            }
+            wake_.notify_all();
+            for (auto &worker : workers_)
+            {
+                worker.join();
+            }
+        }
+
+        void WorkStealingPool::run_batch(size_t count, const BatchTask &task, std::chrono::nanoseconds deadline,
+                                         std::vector<TaskRunStatus> *status)
+        {
+            if (count == 0)
+            {
+                return;
+            }
+            std::lock_guard<std::mutex> batch_lock(batch_mutex_);
+
+            if (status)
+            {
+                status->assign(count, TaskRunStatus{});
+            }
+            // Published to the workers by the queue mutexes below
+            batch_start_ = std::chrono::steady_clock::now();
+            deadline_ = deadline;
+            status_ = status;
+            task_.store(&task, std::memory_order_release);
+            remaining_.store(count, std::memory_order_release);
+
+            size_t queue_count = queues_.size();
+            for (size_t q = 0; q < queue_count; ++q)
+            {
+                WorkerQueue &queue = *queues_[q];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.tasks.clear();
+                queue.head = 0;
+                for (size_t index = q; index < count; index += queue_count)
+                {
+                    queue.tasks.push_back(static_cast<uint32_t>(index));
+                }
+            }
+
+            if (!workers_.empty())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(wake_mutex_);
+                    ++generation_;
+                }
+                wake_.notify_all();
+            }
+
+            // The caller works its own share and then steals like any worker
+            uint32_t index;
+            while (try_take(queue_count - 1, index))
+            {
+                execute(index);
+            }
+            while (remaining_.load(std::memory_order_acquire) != 0)
+            {
+                std::this_thread::yield();
+            }
+            task_.store(nullptr, std::memory_order_relaxed);
+
+            std::exception_ptr failure;
+            {
+                std::lock_guard<std::mutex> lock(failure_mutex_);
+                failure.swap(failure_);
+            }
+            if (failure)
+            {
+                std::rethrow_exception(failure);
+            }
+        }
+
+        bool WorkStealingPool::try_take(size_t self, uint32_t &index)
+        {
+            {
+                WorkerQueue &own = *queues_[self];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (own.head < own.tasks.size())
+                {
+                    index = own.tasks.back();
+                    own.tasks.pop_back();
+                    return true;
+                }
+            }
+
+            size_t queue_count = queues_.size();
+            for (size_t offset = 1; offset < queue_count; ++offset)
+            {
+                WorkerQueue &victim = *queues_[(self + offset) % queue_count];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (victim.head < victim.tasks.size())
+                {
+                    index = victim.tasks[victim.head++];
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void WorkStealingPool::execute(uint32_t index)
+        {
+            bool failed = false;
+            try
+            {
+                (*task_.load(std::memory_order_acquire))(index);
+            }
+            catch (...)
+            {
+                failed = true;
+                std::lock_guard<std::mutex> lock(failure_mutex_);
+                if (!failure_)
+                {
+                    failure_ = std::current_exception();
+                }
+            }
+            record_status(status_, index, batch_start_, deadline_);
+            if (failed && status_)
+            {
+                (*status_)[index].failed = true;
+            }
+            remaining_.fetch_sub(1, std::memory_order_acq_rel);
+        }
+
+        void WorkStealingPool::worker_loop(size_t self, StagePlacement placement)
+        {
+            apply_placement(placement);
+            {
+                // Grown here rather than on first deal, so the deque's pages are on this worker's node
+                WorkerQueue &own = *queues_[self];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                own.tasks.reserve(std::max<size_t>(own.tasks.capacity(), INITIAL_DEQUE_CAPACITY));
+            }
+
+            uint64_t seen = 0;
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(wake_mutex_);
+                    wake_.wait(lock, [&]
+                               { return stopping_ || generation_ != seen; });
+                    if (stopping_)
+                    {
+                        return;
+                    }
+                    seen = generation_;
+                }
+
+                uint32_t index;
+                while (try_take(self, index))
+                {
+                    execute(index);
+                }
+            }
+        }
+
+        void run_tasks(ExecutionMode mode, WorkStealingPool *pool, size_t count, const BatchTask &task,
+                       std::chrono::nanoseconds deadline, std::vector<TaskRunStatus> *status)
+        {
+            if (mode == ExecutionMode::PARALLEL && pool)
+            {
+                pool->run_batch(count, task, deadline, status);
+                return;
+            }
+
+            if (status)
+            {
+                status->assign(count, TaskRunStatus{});
+            }
+            auto start = std::chrono::steady_clock::now();
+            for (size_t index = 0; index < count; ++index)
+            {
+                task(index);
+                record_status(status, index, start, deadline);
+            }
+        }
+
+    } // namespace concurrency
+} // namespace spe
@@ -0,0 +1,191 @@
+#include "test_harness.hpp"
+#include "arbitrage_engine.hpp"
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace spe::arbitrage;
+using spe::market_data::intern_instrument;
+using spe::market_data::MarketDepth;
+using spe::market_data::Quote;
+using spe::market_data::SnapshotStore;
+using spe::mispricing::MispricingOpportunity;
+
+namespace spe
+{
+    namespace arbitrage
+    {
+        struct ArbitrageEngineTestAccess
+        {
+            // Indices of the candidates one batch accepts, in arrival order: screened first as
+            // process_mispricing_batch does, or through validate_survivor alone
+            static std::vector<size_t> accepted(ArbitrageEngine &engine, const std::vector<MispricingOpportunity> &candidates,
+                                                bool screen)
+            {
+                ArbitrageEngine::ValidationContext context = engine.validation_context();
+                std::vector<ArbitrageOpportunity> built(candidates.size());
+                std::vector<size_t> survivors;
+                for (size_t i = 0; i < candidates.size(); ++i)
+                {
+                    engine.build_arbitrage_from_mispricing(candidates[i], built[i], context.now);
+                    if (!screen || engine.screen_opportunity(built[i], context))
+                    {
+                        survivors.push_back(i);
+                    }
+                }
+                std::vector<size_t> accepted;
+                for (size_t i : survivors)
+                {
+                    if (engine.validate_survivor(built[i], context))
+                    {
+                        accepted.push_back(i);
+                    }
+                }
+                return accepted;
+            }
+        };
+    }
+}
+
+namespace
+{
+    // Passes every parameter check, so only liquidity and VaR headroom decide; expected_profit
+    // tags the candidate with its index
+    MispricingOpportunity candidate(size_t index, InstrumentHandle target, double market_price, bool buy)
+    {
+        MispricingOpportunity mispricing;
+        mispricing.target_instrument = target;
+        mispricing.market_price = market_price;
+        mispricing.theoretical_price = market_price * (buy ? 1.01 : 0.99);
+        mispricing.expected_profit = static_cast<double>(index + 1);
+        mispricing.expiry_time = std::chrono::high_resolution_clock::now() + std::chrono::minutes(10);
+        return mispricing;
+    }
+
+    std::vector<size_t> batch_accepts(ArbitrageEngine &engine, const std::vector<MispricingOpportunity> &candidates)
+    {
+        std::vector<size_t> accepted;
+        engine.set_opportunity_callback([&](const ArbitrageOpportunity &opportunity)
+                                        { accepted.push_back(static_cast<size_t>(opportunity.expected_profit) - 1); });
+        engine.process_mispricing_batch(candidates);
+        engine.clear_opportunities();
+        return accepted;
+    }
+}
+
+SPE_TEST(arbitrage_screen_rejects_nothing_validation_accepts)
+{
+    // Four instruments with books, two with quotes only
+    std::vector<InstrumentHandle> instruments;
+    for (int i = 0; i < 6; ++i)
+    {
+        instruments.push_back(intern_instrument("AVS" + std::to_string(i) + "-USD"));
+    }
+    std::mt19937_64 random(29);
+    std::uniform_real_distribution<double> size(5.0, 60.0);
+    std::uniform_real_distribution<double> offset(-0.3, 0.3);
+    std::uniform_real_distribution<double> weight(0.1, 1.5);
+    std::uniform_int_distribution<size_t> pick(0, instruments.size() - 1);
+
+    ArbitrageEngine engine;
+    auto feed = std::make_shared<RiskHeadroomFeed>();
+    engine.set_risk_headroom_feed(feed);
+    SnapshotStore store;
+    size_t accepted_total = 0;
+    size_t rejected_total = 0;
+
+    for (int round = 0; round < 30; ++round)
+    {
+        for (size_t i = 0; i < instruments.size(); ++i)
+        {
+            if (i < 4)
+            {
+                MarketDepth depth(instruments[i]);
+                for (int level = 0; level < 5; ++level)
+                {
+                    depth.add_ask(100.0 + 0.05 * level, size(random));
+                    depth.add_bid(99.95 - 0.05 * level, size(random));
+                }
+                store.apply_depth(depth);
+            }
+            store.apply_quote(Quote(instruments[i], 99.95, 100.0, 2.0 * size(random), 2.0 * size(random)));
+        }
+        engine.update_market_data(store.publish());
+
+        RiskHeadroom headroom;
+        headroom.var_per_notional = 0.002;
+        headroom.var_headroom = std::uniform_real_distribution<double>(0.0, 300.0)(random);
+        feed->store(headroom);
+
+        std::vector<MispricingOpportunity> candidates;
+        for (size_t c = 0; c < 40; ++c)
+        {
+            MispricingOpportunity mispricing = candidate(c, instruments[pick(random)], 100.0 + offset(random), random() % 2 == 0);
+            for (size_t h = random() % 3; h > 0; --h)
+            {
+                mispricing.component_instruments.push_back(instruments[pick(random)]);
+                mispricing.weights.push_back(random() % 2 == 0 ? weight(random) : -weight(random));
+            }
+            candidates.push_back(mispricing);
+        }
+
+        std::vector<size_t> unscreened = ArbitrageEngineTestAccess::accepted(engine, candidates, false);
+        std::vector<size_t> screened = ArbitrageEngineTestAccess::accepted(engine, candidates, true);
+        SPE_CHECK(screened == unscreened);
+        SPE_CHECK(batch_accepts(engine, candidates) == unscreened);
+        accepted_total += unscreened.size();
+        rejected_total += candidates.size() - unscreened.size();
+    }
+
+    // Both outcomes were exercised
+    SPE_CHECK(accepted_total > 0);
+    SPE_CHECK(rejected_total > 0);
+}
+
+SPE_TEST(arbitrage_batch_stops_accepting_once_headroom_is_spent)
+{
+    InstrumentHandle deep = intern_instrument("AVH0-USD");
+    InstrumentHandle cheap = intern_instrument("AVH1-USD");
+    SnapshotStore store;
+    store.apply_quote(Quote(deep, 99.9, 100.0, 1e6, 1e6));
+    store.apply_quote(Quote(cheap, 39.9, 40.0, 1e6, 1e6));
+    ArbitrageEngine engine;
+    engine.update_market_data(store.publish());
+
+    // A 100-unit leg at 100 adds 100 of VaR; at 40 it adds 40
+    RiskHeadroom headroom;
+    headroom.var_per_notional = 0.01;
+    headroom.var_headroom = 350.0;
+    auto feed = std::make_shared<RiskHeadroomFeed>();
+    feed->store(headroom);
+    engine.set_risk_headroom_feed(feed);
+
+    std::vector<MispricingOpportunity> candidates;
+    for (size_t c = 0; c < 5; ++c)
+    {
+        candidates.push_back(candidate(c, deep, 100.0, true));
+    }
+    candidates.push_back(candidate(5, cheap, 40.0, true));
+    candidates.push_back(candidate(6, cheap, 40.0, true));
+
+    // 300 spent on the first three, the 40 fits in the 50 left, then nothing does
+    std::vector<size_t> expected = {0, 1, 2, 5};
+    SPE_CHECK(batch_accepts(engine, candidates) == expected);
+    const ValidationStats &stats = engine.validation_stats();
+    SPE_CHECK_EQ(stats.screened, 7u);
+    SPE_CHECK_EQ(stats.screen_rejected, 0u);
+    SPE_CHECK_EQ(stats.full_rejected, 3u);
+    SPE_CHECK_EQ(stats.accepted, 4u);
+    SPE_CHECK(ArbitrageEngineTestAccess::accepted(engine, candidates, false) == expected);
+
+    // Each batch starts again from the published headroom
+    SPE_CHECK(batch_accepts(engine, candidates) == expected);
+
+    // Once it is below a single candidate's VaR the screen drops the whole batch
+    headroom.var_headroom = 30.0;
+    feed->store(headroom);
+    SPE_CHECK(batch_accepts(engine, candidates).empty());
+    SPE_CHECK_EQ(engine.validation_stats().screen_rejected, 7u);
+}
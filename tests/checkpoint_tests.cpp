@@ -0,0 +1,253 @@
+#include "test_harness.hpp"
+#include "checkpoint.hpp"
+#include "mispricing_detector.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace spe::checkpoint;
+using spe::market_data::intern_instrument;
+using spe::stats::RollingStatistics;
+
+namespace
+{
+    constexpr uint32_t TEST_TAG = make_tag('T', 'E', 'S', 'T');
+    constexpr uint32_t OTHER_TAG = make_tag('O', 'T', 'H', 'R');
+
+    struct Record
+    {
+        int32_t id;
+        double value;
+    };
+
+    std::vector<unsigned char> sample_image()
+    {
+        CheckpointWriter writer;
+        writer.begin_section(TEST_TAG, 3);
+        writer.put(Record{7, 1.5});
+        writer.put_instrument(intern_instrument("BTC-USDT"));
+        writer.put_instrument(intern_instrument("ETH-USDT"));
+        writer.put_instrument(intern_instrument("BTC-USDT"));
+        writer.put_instrument(spe::market_data::INVALID_INSTRUMENT);
+        const double values[] = {1.0, 2.0, 3.0};
+        writer.put_count(3);
+        writer.put_doubles(values, 3);
+        writer.end_section();
+
+        writer.begin_section(OTHER_TAG, 1);
+        writer.put(uint64_t(99));
+        writer.end_section();
+        return writer.finish();
+    }
+
+    std::string temporary_path(const char *name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+}
+
+SPE_TEST(checkpoint_image_round_trips_sections_and_symbols)
+{
+    CheckpointReader reader;
+    SPE_CHECK(reader.open_image(sample_image()));
+    SPE_CHECK_EQ(reader.section_count(), 3u); // the symbol table included
+    SPE_CHECK_EQ(reader.instrument_count(), 2u);
+
+    SectionReader section;
+    SPE_CHECK(reader.find(TEST_TAG, section));
+    SPE_CHECK_EQ(section.version(), 3u);
+
+    Record record{};
+    SPE_CHECK(section.get(record));
+    SPE_CHECK_EQ(record.id, 7);
+    SPE_CHECK_NEAR(record.value, 1.5, 0.0);
+
+    InstrumentHandle first, second, third, none;
+    section.get_instrument(first);
+    section.get_instrument(second);
+    section.get_instrument(third);
+    section.get_instrument(none);
+    SPE_CHECK_EQ(first, intern_instrument("BTC-USDT"));
+    SPE_CHECK_EQ(second, intern_instrument("ETH-USDT"));
+    SPE_CHECK_EQ(third, first);
+    SPE_CHECK_EQ(none, spe::market_data::INVALID_INSTRUMENT);
+
+    size_t count = 0;
+    double values[3] = {};
+    SPE_CHECK(section.get_count(count, sizeof(double)));
+    SPE_CHECK_EQ(count, 3u);
+    SPE_CHECK(section.get_doubles(values, count));
+    SPE_CHECK_NEAR(values[2], 3.0, 0.0);
+    SPE_CHECK_EQ(section.remaining(), 0u);
+    SPE_CHECK(section.ok());
+
+    SPE_CHECK(reader.find(OTHER_TAG, section));
+    SPE_CHECK(!reader.find(make_tag('N', 'O', 'N', 'E'), section));
+}
+
+SPE_TEST(checkpoint_rejects_corrupt_and_truncated_images)
+{
+    std::vector<unsigned char> image = sample_image();
+    // A byte of the symbol table, past the file and section headers
+    const size_t payload_byte = sizeof(CheckpointFileHeader) + sizeof(SectionHeader);
+    SPE_CHECK(image.size() > payload_byte);
+    if (image.size() <= payload_byte)
+    {
+        return;
+    }
+
+    std::vector<unsigned char> flipped = image;
+    flipped[payload_byte] ^= 0x40;
+    CheckpointReader reader;
+    SPE_CHECK(!reader.open_image(flipped));
+    SPE_CHECK(!reader.error().empty());
+
+    std::vector<unsigned char> truncated(image.begin(), image.end() - 8);
+    SPE_CHECK(!reader.open_image(truncated));
+
+    std::vector<unsigned char> short_header(image.begin(), image.begin() + 32);
+    SPE_CHECK(!reader.open_image(short_header));
+
+    std::vector<unsigned char> wrong_magic = image;
+    wrong_magic[0] = 'X';
+    SPE_CHECK(!reader.open_image(wrong_magic));
+
+    SPE_CHECK(reader.open_image(image));
+}
+
+SPE_TEST(checkpoint_section_reads_fail_and_stay_failed)
+{
+    CheckpointReader reader;
+    SPE_CHECK(reader.open_image(sample_image()));
+    SectionReader section;
+    SPE_CHECK(reader.find(OTHER_TAG, section));
+
+    // A count the remaining bytes cannot hold is rejected before anything is allocated
+    size_t count = 0;
+    SPE_CHECK(!section.get_count(count, 16));
+    SPE_CHECK_EQ(count, 0u);
+    SPE_CHECK(!section.ok());
+
+    SPE_CHECK(reader.find(OTHER_TAG, section));
+    uint64_t value = 0;
+    SPE_CHECK(section.get(value));
+    SPE_CHECK_EQ(value, 99u);
+    uint32_t past_end = 5;
+    SPE_CHECK(!section.get(past_end));
+    SPE_CHECK_EQ(past_end, 0u);
+    SPE_CHECK(!section.ok());
+    SPE_CHECK(!section.get_bytes(&past_end, 0)); // failed for good
+}
+
+SPE_TEST(checkpointer_counts_restored_missing_and_failed_components)
+{
+    std::string path = temporary_path("spe_checkpointer_test.ckpt");
+    std::remove(path.c_str());
+
+    RollingStatistics saved(8);
+    for (int i = 1; i <= 12; ++i)
+    {
+        saved.push(static_cast<double>(i));
+    }
+    {
+        Checkpointer checkpointer(path);
+        checkpointer.add(TEST_TAG, 1,
+                         [&](CheckpointWriter &out) { out.put_rolling(saved); },
+                         [](SectionReader &) { return true; });
+        checkpointer.add(OTHER_TAG, 1,
+                         [](CheckpointWriter &out) { out.put(uint32_t(1)); },
+                         [](SectionReader &) { return true; });
+        SPE_CHECK(checkpointer.write_now(spe::market_data::Timestamp::clock::now()));
+        SPE_CHECK_EQ(checkpointer.stats().writes, 1u);
+    }
+
+    RollingStatistics restored(8);
+    Checkpointer checkpointer(path);
+    checkpointer.add(TEST_TAG, 1, [](CheckpointWriter &) {},
+                     [&](SectionReader &in) { return in.get_rolling(restored); });
+    checkpointer.add(OTHER_TAG, 1, [](CheckpointWriter &) {},
+                     [](SectionReader &in)
+                     {
+                         uint64_t too_wide = 0;
+                         in.get(too_wide); // the section holds four bytes
+                         return true;
+                     });
+    checkpointer.add(make_tag('N', 'E', 'W', ' '), 1, [](CheckpointWriter &) {},
+                     [](SectionReader &) { return true; });
+
+    RestoreResult result = checkpointer.restore();
+    SPE_CHECK(result.loaded);
+    SPE_CHECK_EQ(result.restored, 1u);
+    SPE_CHECK_EQ(result.failed, 1u);
+    SPE_CHECK_EQ(result.missing, 1u);
+
+    SPE_CHECK_EQ(restored.size(), 8u);
+    SPE_CHECK_NEAR(restored.mean(), saved.mean(), 1e-12);
+    SPE_CHECK_NEAR(restored.variance(), saved.variance(), 1e-12);
+    SPE_CHECK_NEAR(restored.ewma(), saved.ewma(), 0.0);
+    SPE_CHECK_NEAR(restored.oldest(), 5.0, 0.0);
+
+    std::remove(path.c_str());
+    RestoreResult absent = checkpointer.restore();
+    SPE_CHECK(!absent.loaded);
+    SPE_CHECK(!absent.error.empty());
+}
+
+SPE_TEST(volatility_detector_restores_windows_and_flags_without_callback)
+{
+    using spe::mispricing::VolatilityArbitrageDetector;
+    using spe::market_data::Quote;
+
+    InstrumentHandle flagged = intern_instrument("BTC-USDT");
+    InstrumentHandle warming = intern_instrument("ETH-USDT");
+    auto quote = [](InstrumentHandle instrument, int i)
+    {
+        double mid = 100.0 + (i % 2 ? 0.5 : -0.5);
+        return Quote(instrument, mid - 0.01, mid + 0.01, 1.0, 1.0);
+    };
+
+    std::string path = temporary_path("spe_volatility_detector_test.ckpt");
+    size_t callbacks = 0;
+    {
+        VolatilityArbitrageDetector detector;
+        detector.set_detection_callback([&](const spe::mispricing::MispricingOpportunity &) { ++callbacks; });
+        for (int i = 0; i < 25; ++i)
+        {
+            detector.on_quote(flagged, quote(flagged, i));
+        }
+        for (int i = 0; i < 10; ++i)
+        {
+            detector.on_quote(warming, quote(warming, i));
+        }
+        SPE_CHECK_EQ(callbacks, 1u);
+
+        Checkpointer checkpointer(path);
+        checkpointer.add(detector);
+        SPE_CHECK(checkpointer.write_now(spe::market_data::Timestamp::clock::now()));
+    }
+
+    callbacks = 0;
+    VolatilityArbitrageDetector detector;
+    detector.set_detection_callback([&](const spe::mispricing::MispricingOpportunity &) { ++callbacks; });
+    Checkpointer checkpointer(path);
+    checkpointer.add(detector);
+    RestoreResult result = checkpointer.restore();
+    SPE_CHECK_EQ(result.restored, 1u);
+
+    auto opportunities = detector.detect_opportunities();
+    SPE_CHECK_EQ(opportunities.size(), 1u);
+    SPE_CHECK(!opportunities.empty() && opportunities[0].target_instrument == flagged);
+    SPE_CHECK_EQ(callbacks, 0u);
+
+    // The flagged instrument stays flagged; the warming one picks up its count where it stopped
+    detector.on_quote(flagged, quote(flagged, 25));
+    SPE_CHECK_EQ(callbacks, 0u);
+    for (int i = 10; i < 20; ++i)
+    {
+        detector.on_quote(warming, quote(warming, i));
+    }
+    SPE_CHECK_EQ(callbacks, 1u);
+    SPE_CHECK_EQ(detector.detect_opportunities().size(), 2u);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,119 @@
+#include "test_harness.hpp"
+#include "currency_graph.hpp"
+#include <cmath>
+#include <string>
+
+using namespace spe::market_data;
+using namespace spe::graph;
+
+namespace
+{
+    void add_pairs(CurrencyGraph &graph, std::initializer_list<const char *> symbols)
+    {
+        for (const char *symbol : symbols)
+        {
+            SPE_CHECK(graph.add_pair(intern_instrument(symbol)));
+        }
+        graph.build();
+    }
+}
+
+SPE_TEST(currency_graph_splits_spot_symbols_only)
+{
+    std::string base, quote;
+    SPE_CHECK(CurrencyGraph::split_pair_symbol("BTC-USDT", base, quote));
+    SPE_CHECK(base == "BTC" && quote == "USDT");
+    SPE_CHECK(CurrencyGraph::split_pair_symbol("ETH/BTC", base, quote));
+    SPE_CHECK(base == "ETH" && quote == "BTC");
+    SPE_CHECK(!CurrencyGraph::split_pair_symbol("BTCUSDT", base, quote));
+    SPE_CHECK(!CurrencyGraph::split_pair_symbol("BTC-USD-SWAP", base, quote));
+    SPE_CHECK(!CurrencyGraph::split_pair_symbol("-USDT", base, quote));
+}
+
+SPE_TEST(currency_graph_enumerates_each_triangle_in_both_directions)
+{
+    CurrencyGraph graph(true);
+    add_pairs(graph, {"BTC-USDT", "ETH-USDT", "ETH-BTC"});
+    SPE_CHECK_EQ(graph.currency_count(), 3u);
+    SPE_CHECK_EQ(graph.cycle_count(), 2u);
+
+    for (uint32_t id = 0; id < graph.cycle_count(); ++id)
+    {
+        const CurrencyGraph::Cycle &cycle = graph.cycle(id);
+        SPE_CHECK_EQ(cycle.length, 3u);
+        for (uint32_t i = 0; i < cycle.length; ++i)
+        {
+            // Legs chain and close the loop
+            SPE_CHECK_EQ(graph.edge(cycle.edges[i]).to, graph.edge(cycle.edges[(i + 1) % cycle.length]).from);
+        }
+    }
+}
+
+SPE_TEST(currency_graph_counts_three_and_four_cycles_on_complete_graph)
+{
+    // Four currencies, every pair quoted: 4 triangles and 3 squares, each in two directions
+    CurrencyGraph triangles;
+    add_pairs(triangles, {"BTC-USDT", "ETH-USDT", "SOL-USDT", "ETH-BTC", "SOL-BTC", "SOL-ETH"});
+    SPE_CHECK_EQ(triangles.cycle_count(), 8u);
+
+    CurrencyGraph squares(true);
+    add_pairs(squares, {"BTC-USDT", "ETH-USDT", "SOL-USDT", "ETH-BTC", "SOL-BTC", "SOL-ETH"});
+    SPE_CHECK_EQ(squares.cycle_count(), 14u);
+}
+
+SPE_TEST(currency_graph_reports_mispriced_triangle_once)
+{
+    CurrencyGraph graph;
+    add_pairs(graph, {"BTC-USDT", "ETH-USDT", "ETH-BTC"});
+    SPE_CHECK(graph.update_quote(intern_instrument("BTC-USDT"), 100.0, 100.0));
+    SPE_CHECK(graph.update_quote(intern_instrument("ETH-USDT"), 10.0, 10.0));
+    // USDT -> ETH at 10, ETH -> BTC at 0.11, BTC -> USDT at 100: 10% round trip
+    SPE_CHECK(graph.update_quote(intern_instrument("ETH-BTC"), 0.11, 0.11));
+    SPE_CHECK(!graph.update_quote(intern_instrument("XRP-USDT"), 1.0, 1.0));
+
+    size_t calls = 0;
+    uint32_t found = UINT32_MAX;
+    graph.evaluate_touched([&](uint32_t cycle, double log_return, bool newly_profitable)
+                           {
+                               ++calls;
+                               found = cycle;
+                               SPE_CHECK_NEAR(log_return, std::log(1.1), 1e-9);
+                               SPE_CHECK(newly_profitable);
+                           });
+    SPE_CHECK_EQ(calls, 1u);
+    SPE_CHECK_EQ(graph.profitable_cycles().size(), 1u);
+
+    // Nothing touched since: nothing re-scored
+    calls = 0;
+    graph.evaluate_touched([&](uint32_t, double, bool) { ++calls; });
+    SPE_CHECK_EQ(calls, 0u);
+
+    // Still profitable on an unrelated re-quote, but no longer new
+    SPE_CHECK(graph.update_quote(intern_instrument("ETH-BTC"), 0.11, 0.12));
+    graph.evaluate_touched([&](uint32_t cycle, double, bool newly_profitable)
+                           {
+                               ++calls;
+                               SPE_CHECK_EQ(cycle, found);
+                               SPE_CHECK(!newly_profitable);
+                           });
+    SPE_CHECK_EQ(calls, 1u);
+
+    SPE_CHECK(graph.update_quote(intern_instrument("ETH-BTC"), 0.0999, 0.1001));
+    graph.evaluate_touched([&](uint32_t, double, bool) { ++calls; });
+    SPE_CHECK_EQ(calls, 1u);
+    SPE_CHECK(graph.profitable_cycles().empty());
+}
+
+SPE_TEST(currency_graph_fees_cut_the_round_trip)
+{
+    CurrencyGraph graph(false, 0.05);
+    add_pairs(graph, {"BTC-USDT", "ETH-USDT", "ETH-BTC"});
+    graph.update_quote(intern_instrument("BTC-USDT"), 100.0, 100.0);
+    graph.update_quote(intern_instrument("ETH-USDT"), 10.0, 10.0);
+    graph.update_quote(intern_instrument("ETH-BTC"), 0.11, 0.11); // 1.1 * 0.95^3 < 1
+
+    size_t calls = 0;
+    graph.evaluate_touched([&](uint32_t, double, bool) { ++calls; });
+    SPE_CHECK_EQ(calls, 0u);
+    SPE_CHECK(graph.profitable_cycles().empty());
+}
@@ -0,0 +1,168 @@
+#include "test_harness.hpp"
+#include "event_pipeline.hpp"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace spe::pipeline;
+using spe::arbitrage::ArbitrageCallback;
+using spe::arbitrage::ArbitrageParameters;
+using spe::arbitrage::ArbitrageUpdateCallback;
+using spe::mispricing::DetectionParameters;
+using spe::mispricing::MispricingCallback;
+using spe::mispricing::MispricingExpiredCallback;
+using spe::mispricing::MispricingType;
+
+namespace
+{
+    MispricingOpportunity make_opportunity(InstrumentHandle instrument)
+    {
+        MispricingOpportunity opportunity{};
+        opportunity.target_instrument = instrument;
+        opportunity.type = MispricingType::STATISTICAL_ARBITRAGE;
+        return opportunity;
+    }
+
+    // Reports one opportunity on the first batch and it plus `extra` more on every later one,
+    // all of them active for as long as the test runs
+    class FixedDetector : public IMispricingDetector
+    {
+    public:
+        std::vector<InstrumentHandle> first;
+        std::vector<InstrumentHandle> later;
+        std::atomic<int> batches{0};
+
+        void update_market_data(const MarketSnapshot &) override { ++batches; }
+        std::vector<MispricingOpportunity> detect_opportunities() override
+        {
+            std::vector<MispricingOpportunity> opportunities;
+            for (InstrumentHandle instrument : batches.load() == 1 ? first : later)
+            {
+                opportunities.push_back(make_opportunity(instrument));
+            }
+            return opportunities;
+        }
+        void set_detection_callback(MispricingCallback) override {}
+        void set_expiry_callback(MispricingExpiredCallback) override {}
+        void update_parameters(const DetectionParameters &) override {}
+    };
+
+    // Holds its first batch until released, so the detection ring behind it fills up
+    class GatedEngine : public IArbitrageEngine
+    {
+    public:
+        std::atomic<bool> entered{false};
+        std::atomic<bool> released{false};
+        std::mutex mutex;
+        std::map<InstrumentHandle, int> received;
+
+        void update_market_data(const MarketSnapshot &) override {}
+        void process_mispricing_batch(const std::vector<MispricingOpportunity> &mispricings) override
+        {
+            entered = true;
+            while (!released.load())
+            {
+                std::this_thread::yield();
+            }
+            for (const auto &mispricing : mispricings)
+            {
+                process_mispricing(mispricing);
+            }
+        }
+        void process_mispricing(const MispricingOpportunity &mispricing) override
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++received[mispricing.target_instrument];
+        }
+        std::vector<ArbitrageOpportunity> identify_opportunities() override { return {}; }
+        bool validate_opportunity(ArbitrageOpportunity &) override { return false; }
+        void set_opportunity_callback(ArbitrageCallback) override {}
+        void set_update_callback(ArbitrageUpdateCallback) override {}
+        void update_parameters(const ArbitrageParameters &) override {}
+        std::vector<ArbitrageOpportunity> get_active_opportunities() const override { return {}; }
+        void clear_opportunities() override {}
+
+        size_t distinct()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return received.size();
+        }
+    };
+
+    template <typename Condition>
+    bool wait_for(Condition condition, std::chrono::milliseconds timeout = std::chrono::seconds(5))
+    {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!condition())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        return true;
+    }
+
+    uint64_t detections_dropped(const MarketEventPipeline &pipeline)
+    {
+        for (const auto &stage : pipeline.get_stage_statistics())
+        {
+            if (stage.stage == "detections")
+            {
+                return stage.dropped;
+            }
+        }
+        return 0;
+    }
+}
+
+SPE_TEST(event_pipeline_retries_detections_the_full_ring_dropped)
+{
+    auto detector = std::make_unique<FixedDetector>();
+    auto engine = std::make_unique<GatedEngine>();
+    FixedDetector &detector_ref = *detector;
+    GatedEngine &engine_ref = *engine;
+
+    InstrumentHandle quoted = intern_instrument("PIPE-QUOTED");
+    detector->first = {intern_instrument("PIPE-0")};
+    detector->later = detector->first;
+    for (int i = 1; i <= 6; ++i)
+    {
+        detector->later.push_back(intern_instrument("PIPE-" + std::to_string(i)));
+    }
+
+    PipelineConfig config;
+    config.detection_capacity = 2;
+    config.detection_policy = OverflowPolicy::DROP_NEWEST;
+    config.latency_source = "pipeline-test";
+    MarketEventPipeline pipeline(std::move(detector), std::move(engine), config);
+    SPE_CHECK(pipeline.start());
+
+    auto publish = [&]() { pipeline.publish(MarketEvent(Quote(quoted, 100.0, 101.0, 1.0, 1.0))); };
+
+    // The first detection reaches the engine and holds it; six new ones meet a two-slot ring
+    publish();
+    SPE_CHECK(wait_for([&]() { return engine_ref.entered.load(); }));
+    publish();
+    SPE_CHECK(wait_for([&]() { return detector_ref.batches.load() >= 2; }));
+    SPE_CHECK_EQ(detections_dropped(pipeline), 4u);
+
+    // Still active on later batches, the dropped ones go out once there is room
+    engine_ref.released = true;
+    SPE_CHECK(wait_for([&]()
+                       {
+                           publish();
+                           return engine_ref.distinct() == detector_ref.later.size();
+                       }));
+    pipeline.stop();
+
+    SPE_CHECK_EQ(engine_ref.received.size(), detector_ref.later.size());
+    for (const auto &entry : engine_ref.received)
+    {
+        SPE_CHECK_EQ(entry.second, 1); // forwarded once each while it stays active
+    }
+}
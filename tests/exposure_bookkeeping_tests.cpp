@@ -0,0 +1,202 @@
+#include "test_harness.hpp"
+#include "exposure_management.hpp"
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace spe::exposure;
+using spe::market_data::InstrumentHandle;
+
+namespace spe
+{
+    namespace exposure
+    {
+        struct SyntheticExposureManagerTestAccess
+        {
+            struct Totals
+            {
+                double net_exposure;
+                double gross_exposure;
+                double total_pnl;
+                double value_at_risk;
+                size_t size_breaches;
+            };
+
+            static Totals totals(const SyntheticExposureManager &manager)
+            {
+                return {manager.portfolio_.net_exposure, manager.portfolio_.gross_exposure, manager.portfolio_.total_pnl,
+                        manager.current_var_, manager.size_breach_count_};
+            }
+
+            // The running totals after a full rebuild; the breach count from scratch
+            static Totals rebuilt(SyntheticExposureManager &manager)
+            {
+                manager.update_portfolio_metrics();
+                Totals result = totals(manager);
+                result.size_breaches = 0;
+                for (const Position &position : manager.portfolio_.positions)
+                {
+                    result.size_breaches += std::abs(position.exposure_amount) > manager.portfolio_.max_position_size;
+                }
+                return result;
+            }
+
+            // Every lookup points at the position it names, and each position is listed once
+            static bool indices_consistent(const SyntheticExposureManager &manager)
+            {
+                const std::vector<Position> &positions = manager.portfolio_.positions;
+                bool consistent = manager.position_index_.size() == positions.size() &&
+                                  manager.position_nodes_.size() == positions.size() &&
+                                  manager.var_basis_.size() == positions.size() &&
+                                  manager.var_basis_exposure_.size() == positions.size() &&
+                                  manager.size_breaches_.size() == positions.size();
+                for (uint32_t i = 0; consistent && i < positions.size(); ++i)
+                {
+                    auto found = manager.position_index_.find(positions[i].position_id);
+                    consistent = found != manager.position_index_.end() && found->second == i &&
+                                 manager.position_nodes_[i]->position_id == positions[i].position_id &&
+                                 manager.position_nodes_[i]->exposure_amount == positions[i].exposure_amount &&
+                                 manager.size_breaches_[i] ==
+                                     (std::abs(positions[i].exposure_amount) > manager.portfolio_.max_position_size);
+                }
+                size_t listed = 0;
+                for (const auto &entry : manager.positions_by_instrument_)
+                {
+                    consistent = consistent && !entry.second.empty();
+                    for (uint32_t index : entry.second)
+                    {
+                        consistent = consistent && index < positions.size() && positions[index].instrument == entry.first;
+                        ++listed;
+                    }
+                }
+                return consistent && listed == positions.size();
+            }
+
+            static std::mutex &mutex(SyntheticExposureManager &manager) { return manager.portfolio_mutex_; }
+            static size_t size(const SyntheticExposureManager &manager) { return manager.portfolio_.positions.size(); }
+            static Volume size_of(const SyntheticExposureManager &manager, uint32_t index)
+            {
+                return manager.portfolio_.positions[index].size;
+            }
+            static void set_max_position_size(SyntheticExposureManager &manager, double size)
+            {
+                manager.portfolio_.max_position_size = size;
+            }
+            static std::string next_id(SyntheticExposureManager &manager) { return manager.generate_position_id(); }
+            static void add(SyntheticExposureManager &manager, Position position) { manager.add_position(std::move(position)); }
+            static void remove(SyntheticExposureManager &manager, uint32_t index) { manager.remove_position(index); }
+            static void resize(SyntheticExposureManager &manager, uint32_t index, Volume size)
+            {
+                manager.resize_position(index, size);
+            }
+
+            // Reprices every position on the instrument, as a tick does
+            static void move_price(SyntheticExposureManager &manager, InstrumentHandle instrument, Price price)
+            {
+                auto found = manager.positions_by_instrument_.find(instrument);
+                if (found == manager.positions_by_instrument_.end())
+                {
+                    return;
+                }
+                for (uint32_t index : found->second)
+                {
+                    manager.apply_price(index, price, std::chrono::high_resolution_clock::now());
+                }
+            }
+        };
+    }
+}
+
+namespace
+{
+    using Access = SyntheticExposureManagerTestAccess;
+
+    void check_against_rebuild(SyntheticExposureManager &manager)
+    {
+        Access::Totals running = Access::totals(manager);
+        Access::Totals rebuilt = Access::rebuilt(manager);
+        double scale = 1e-9 * (1.0 + rebuilt.gross_exposure);
+        SPE_CHECK_NEAR(running.net_exposure, rebuilt.net_exposure, scale);
+        SPE_CHECK_NEAR(running.gross_exposure, rebuilt.gross_exposure, scale);
+        SPE_CHECK_NEAR(running.total_pnl, rebuilt.total_pnl, scale);
+        SPE_CHECK_NEAR(running.value_at_risk, rebuilt.value_at_risk, scale);
+        SPE_CHECK_EQ(running.size_breaches, rebuilt.size_breaches);
+        SPE_CHECK(Access::indices_consistent(manager));
+    }
+}
+
+SPE_TEST(exposure_running_totals_match_a_full_rebuild)
+{
+    // A few instruments shared by many positions, so swap-removes move indices within and
+    // across the per-instrument lists; sizes straddle the limit, so breaches come and go
+    std::vector<InstrumentHandle> instruments;
+    std::vector<Price> prices;
+    for (int i = 0; i < 5; ++i)
+    {
+        instruments.push_back(spe::market_data::intern_instrument("EXB" + std::to_string(i) + "-USD"));
+        prices.push_back(100.0);
+    }
+    std::mt19937_64 random(19);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<size_t> pick(0, instruments.size() - 1);
+
+    SyntheticExposureManager manager(nullptr, nullptr, std::make_unique<AdvancedRiskCalculator>(), nullptr);
+    std::lock_guard<std::mutex> lock(Access::mutex(manager));
+    Access::set_max_position_size(manager, 30000.0);
+    size_t adds = 0, moves = 0, trims = 0, closes = 0, breached = 0;
+
+    for (int step = 0; step < 3000; ++step)
+    {
+        double action = unit(random);
+        if (Access::size(manager) < 4 || (action < 0.3 && Access::size(manager) < 60))
+        {
+            size_t instrument = pick(random);
+            Position position;
+            position.position_id = Access::next_id(manager);
+            position.instrument = instruments[instrument];
+            position.side = random() % 2 == 0 ? PositionSide::LONG : PositionSide::SHORT;
+            position.size = 10.0 + 390.0 * unit(random);
+            position.entry_price = prices[instrument] * (0.98 + 0.04 * unit(random));
+            position.current_price = random() % 4 == 0 ? 0.0 : prices[instrument]; // 0: priced at entry
+            Access::add(manager, position);
+            ++adds;
+        }
+        else if (action < 0.65)
+        {
+            size_t instrument = pick(random);
+            prices[instrument] *= std::exp(0.05 * (unit(random) - 0.5));
+            Access::move_price(manager, instruments[instrument], prices[instrument]);
+            ++moves;
+        }
+        else if (action < 0.85)
+        {
+            auto index = static_cast<uint32_t>(random() % Access::size(manager));
+            double fraction = 1.2 * unit(random); // past 1 it is not a trim and must change nothing
+            Access::resize(manager, index, fraction * Access::size_of(manager, index));
+            ++trims;
+        }
+        else
+        {
+            Access::remove(manager, static_cast<uint32_t>(random() % Access::size(manager)));
+            ++closes;
+        }
+        breached += Access::totals(manager).size_breaches > 0;
+        check_against_rebuild(manager);
+    }
+
+    // Closing everything leaves all P&L realized and nothing else
+    while (Access::size(manager) > 0)
+    {
+        Access::remove(manager, static_cast<uint32_t>(random() % Access::size(manager)));
+        check_against_rebuild(manager);
+    }
+    Access::Totals empty = Access::totals(manager);
+    SPE_CHECK_EQ(empty.size_breaches, 0u);
+    SPE_CHECK_NEAR(empty.gross_exposure, 0.0, 1e-6);
+
+    SPE_CHECK(adds > 0 && moves > 0 && trims > 0 && closes > 0);
+    SPE_CHECK(breached > 0 && breached < 3000);
+}
@@ -0,0 +1,147 @@
+#include "test_harness.hpp"
+#include "feed_arbiter.hpp"
+#include <vector>
+
+using namespace spe::exchange_ws;
+
+namespace
+{
+    constexpr LineId LINE_A = 0;
+    constexpr LineId LINE_B = 1;
+
+    Trade make_trade(InstrumentHandle instrument, uint64_t sequence)
+    {
+        Trade trade(instrument, 100.0, 1.0, Side::BID);
+        trade.sequence_number = sequence;
+        return trade;
+    }
+
+    OrderBookSnapshot make_book(InstrumentHandle instrument, uint64_t sequence)
+    {
+        OrderBookSnapshot book;
+        book.instrument = instrument;
+        book.sequence_number = sequence;
+        return book;
+    }
+
+    struct Delivered
+    {
+        std::vector<uint64_t> trades;
+        std::vector<uint64_t> books;
+
+        void attach(FeedArbiter &arbiter)
+        {
+            arbiter.set_trade_callback([this](const Trade &trade) { trades.push_back(trade.sequence_number); });
+            arbiter.set_orderbook_callback([this](const OrderBookSnapshot &book) { books.push_back(book.sequence_number); });
+        }
+    };
+}
+
+SPE_TEST(feed_arbiter_delivers_first_copy_only)
+{
+    FeedArbiter arbiter(4);
+    Delivered delivered;
+    delivered.attach(arbiter);
+
+    for (uint64_t sequence = 1; sequence <= 3; ++sequence)
+    {
+        arbiter.on_trade(LINE_A, make_trade(0, sequence));
+        arbiter.on_trade(LINE_B, make_trade(0, sequence));
+    }
+    // Streams are per instrument: the same numbers on another one are new
+    arbiter.on_trade(LINE_B, make_trade(1, 1));
+
+    SPE_CHECK(delivered.trades == (std::vector<uint64_t>{1, 2, 3, 1}));
+    SPE_CHECK_EQ(arbiter.line_stats(LINE_A).wins.load(), 3u);
+    SPE_CHECK_EQ(arbiter.line_stats(LINE_B).duplicates.load(), 3u);
+    SPE_CHECK_EQ(arbiter.line_stats(LINE_B).wins.load(), 1u);
+    SPE_CHECK_EQ(arbiter.line_stats(LINE_B).lag.count(), 3u);
+    SPE_CHECK_NEAR(arbiter.line_stats(LINE_A).win_rate(), 1.0, 1e-12);
+    SPE_CHECK_NEAR(arbiter.line_stats(LINE_B).win_rate(), 0.25, 1e-12);
+}
+
+SPE_TEST(feed_arbiter_fills_trade_gaps_from_the_slower_line)
+{
+    FeedArbiter arbiter(4);
+    Delivered delivered;
+    delivered.attach(arbiter);
+
+    arbiter.on_trade(LINE_A, make_trade(0, 1));
+    arbiter.on_trade(LINE_A, make_trade(0, 2));
+    arbiter.on_trade(LINE_A, make_trade(0, 5)); // A skipped 3 and 4
+    SPE_CHECK_EQ(arbiter.gaps_opened(), 2u);
+
+    arbiter.on_trade(LINE_B, make_trade(0, 3));
+    arbiter.on_trade(LINE_B, make_trade(0, 4));
+    arbiter.on_trade(LINE_B, make_trade(0, 5));
+    arbiter.on_trade(LINE_A, make_trade(0, 3)); // filled already
+
+    SPE_CHECK(delivered.trades == (std::vector<uint64_t>{1, 2, 5, 3, 4}));
+    SPE_CHECK_EQ(arbiter.gaps_filled(), 2u);
+    SPE_CHECK_EQ(arbiter.line_stats(LINE_B).gap_fills.load(), 2u);
+    SPE_CHECK_EQ(arbiter.line_stats(LINE_B).duplicates.load(), 1u);
+    SPE_CHECK_EQ(arbiter.line_stats(LINE_A).duplicates.load(), 1u);
+}
+
+SPE_TEST(feed_arbiter_drops_trades_older_than_the_window)
+{
+    FeedArbiter arbiter(4);
+    Delivered delivered;
+    delivered.attach(arbiter);
+
+    arbiter.on_trade(LINE_A, make_trade(0, 1));
+    arbiter.on_trade(LINE_A, make_trade(0, 100));
+    arbiter.on_trade(LINE_B, make_trade(0, 100 - FeedArbiter::WINDOW));     // just outside
+    arbiter.on_trade(LINE_B, make_trade(0, 100 - FeedArbiter::WINDOW + 1)); // oldest bit kept
+
+    SPE_CHECK(delivered.trades == (std::vector<uint64_t>{1, 100, 100 - FeedArbiter::WINDOW + 1}));
+    SPE_CHECK_EQ(arbiter.line_stats(LINE_B).stale.load(), 1u);
+    SPE_CHECK_EQ(arbiter.line_stats(LINE_B).gap_fills.load(), 1u);
+
+    // A jump of a full window forgets everything below it
+    arbiter.on_trade(LINE_A, make_trade(0, 100 + FeedArbiter::WINDOW));
+    arbiter.on_trade(LINE_B, make_trade(0, 100 + 1));
+    SPE_CHECK_EQ(arbiter.line_stats(LINE_B).gap_fills.load(), 2u);
+}
+
+SPE_TEST(feed_arbiter_never_delivers_an_older_book)
+{
+    FeedArbiter arbiter(4);
+    Delivered delivered;
+    delivered.attach(arbiter);
+
+    arbiter.on_orderbook(LINE_A, make_book(0, 10));
+    arbiter.on_orderbook(LINE_B, make_book(0, 10));
+    arbiter.on_orderbook(LINE_B, make_book(0, 8)); // skipped by A, but superseded by 10
+    arbiter.on_orderbook(LINE_B, make_book(0, 12));
+    arbiter.on_orderbook(LINE_A, make_book(0, 12));
+
+    SPE_CHECK(delivered.books == (std::vector<uint64_t>{10, 12}));
+    SPE_CHECK_EQ(arbiter.line_stats(LINE_B).stale.load(), 1u);
+    SPE_CHECK_EQ(arbiter.line_stats(LINE_B).duplicates.load(), 1u);
+    SPE_CHECK_EQ(arbiter.line_stats(LINE_A).duplicates.load(), 1u);
+}
+
+SPE_TEST(feed_arbiter_passes_through_unsequenced_and_resets)
+{
+    FeedArbiter arbiter(2);
+    std::vector<std::string> trade_ids;
+    arbiter.set_trade_callback([&](const Trade &trade) { trade_ids.push_back(trade.trade_id); });
+
+    Trade numbered = make_trade(0, 0);
+    numbered.trade_id = "42"; // numeric trade ids stand in for a sequence
+    Trade opaque = make_trade(0, 0);
+    opaque.trade_id = "a1";
+    arbiter.on_trade(LINE_A, numbered);
+    arbiter.on_trade(LINE_B, numbered);
+    arbiter.on_trade(LINE_A, opaque);
+    arbiter.on_trade(LINE_B, opaque);
+    arbiter.on_trade(LINE_A, make_trade(5, 1)); // past capacity
+    SPE_CHECK(trade_ids == (std::vector<std::string>{"42", "a1", "a1", ""}));
+    SPE_CHECK_EQ(arbiter.unarbitrated(), 3u);
+
+    // After a venue sequence reset the low numbers are new again
+    arbiter.reset(0);
+    arbiter.on_trade(LINE_B, numbered);
+    SPE_CHECK_EQ(trade_ids.size(), 5u);
+}
@@ -0,0 +1,144 @@
+#include "test_harness.hpp"
+#include "linear_algebra.hpp"
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace spe::linalg;
+
+namespace
+{
+    // M M' + I: symmetric positive definite with a spread of eigenvalues
+    DenseMatrix random_spd(size_t n, std::mt19937_64 &random)
+    {
+        std::normal_distribution<double> normal;
+        DenseMatrix m(n, n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                m(i, j) = normal(random);
+            }
+        }
+        DenseMatrix a(n, n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                a(i, j) = dot(m.row(i), m.row(j), n) + (i == j ? 1.0 : 0.0);
+            }
+        }
+        return a;
+    }
+
+    std::vector<double> ridge_rhs(const DenseMatrix &a, const std::vector<double> &x, double lambda)
+    {
+        std::vector<double> b(x.size());
+        multiply(a, x.data(), b.data());
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+            b[i] += lambda * x[i];
+        }
+        return b;
+    }
+
+    double max_error(const std::vector<double> &a, const std::vector<double> &b)
+    {
+        double error = 0.0;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            error = std::max(error, std::abs(a[i] - b[i]));
+        }
+        return error;
+    }
+}
+
+SPE_TEST(dense_matrix_kernels_ignore_row_padding)
+{
+    DenseMatrix a(3, 5); // stride 8
+    SPE_CHECK_EQ(a.stride(), 8u);
+    for (size_t r = 0; r < 3; ++r)
+    {
+        for (size_t c = 0; c < 5; ++c)
+        {
+            a(r, c) = static_cast<double>(r * 5 + c);
+        }
+    }
+    const double x[5] = {1, -1, 2, 0.5, 3};
+    double y[3];
+    multiply(a, x, y);
+    SPE_CHECK_NEAR(y[0], 0 - 1 + 4 + 1.5 + 12, 1e-12);
+    SPE_CHECK_NEAR(y[2], 10 - 11 + 24 + 6.5 + 42, 1e-12);
+
+    DenseMatrix square(5, 5);
+    square.set_identity(5);
+    SPE_CHECK_NEAR(quadratic_form(square, x), dot(x, x, 5), 1e-12);
+}
+
+SPE_TEST(ridge_solver_matches_known_solution)
+{
+    std::mt19937_64 random(11);
+    std::normal_distribution<double> normal;
+    const size_t n = 30;
+    const double lambda = 0.1;
+    DenseMatrix a = random_spd(n, random);
+    std::vector<double> expected(n);
+    for (double &value : expected)
+    {
+        value = normal(random);
+    }
+    std::vector<double> b = ridge_rhs(a, expected, lambda);
+
+    RidgeSolver solver;
+    std::vector<double> x(n, 0.0);
+    RidgeSolution solution = solver.solve(a, b.data(), lambda, x.data(), 1e-12, 10 * n);
+    SPE_CHECK(solution.converged);
+    SPE_CHECK(solution.residual <= 1e-12);
+    SPE_CHECK(max_error(x, expected) < 1e-8);
+
+    // Already at the solution: nothing left to do
+    RidgeSolution again = solver.solve(a, b.data(), lambda, x.data(), 1e-8);
+    SPE_CHECK(again.converged);
+    SPE_CHECK_EQ(again.iterations, 0u);
+}
+
+SPE_TEST(ridge_solver_warm_start_converges_faster)
+{
+    std::mt19937_64 random(5);
+    std::normal_distribution<double> normal;
+    const size_t n = 40;
+    const double lambda = 0.05;
+    DenseMatrix a = random_spd(n, random);
+    std::vector<double> expected(n);
+    for (double &value : expected)
+    {
+        value = normal(random);
+    }
+
+    RidgeSolver solver;
+    std::vector<double> previous(n, 0.0);
+    std::vector<double> b = ridge_rhs(a, expected, lambda);
+    SPE_CHECK(solver.solve(a, b.data(), lambda, previous.data(), 1e-10, 10 * n).converged);
+
+    // The next bar: the matrix and target drift slightly
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = i; j < n; ++j)
+        {
+            double drift = 1e-3 * normal(random);
+            a(i, j) += drift;
+            a(j, i) = a(i, j);
+        }
+        expected[i] += 1e-3 * normal(random);
+    }
+    b = ridge_rhs(a, expected, lambda);
+
+    std::vector<double> cold(n, 0.0);
+    std::vector<double> warm = previous;
+    RidgeSolution cold_solution = solver.solve(a, b.data(), lambda, cold.data(), 1e-10, 10 * n);
+    RidgeSolution warm_solution = solver.solve(a, b.data(), lambda, warm.data(), 1e-10, 10 * n);
+    SPE_CHECK(cold_solution.converged);
+    SPE_CHECK(warm_solution.converged);
+    SPE_CHECK(warm_solution.iterations < cold_solution.iterations);
+    SPE_CHECK(max_error(warm, cold) < 1e-7);
+}
@@ -0,0 +1,142 @@
+#include "test_harness.hpp"
+#include "lockfree_queue.hpp"
+#include <thread>
+#include <vector>
+
+using namespace spe::concurrency;
+
+SPE_TEST(spsc_ring_rounds_capacity_and_fills)
+{
+    SpscRing<int> ring(5);
+    SPE_CHECK_EQ(ring.capacity(), 8u);
+    for (int i = 0; i < 8; ++i)
+    {
+        SPE_CHECK(ring.try_push(i));
+    }
+    SPE_CHECK(!ring.try_push(8));
+    SPE_CHECK_EQ(ring.size_approx(), 8u);
+
+    int value = -1;
+    SPE_CHECK(ring.try_pop(value));
+    SPE_CHECK_EQ(value, 0);
+    SPE_CHECK(ring.try_push(8)); // the freed slot is reused
+}
+
+SPE_TEST(spsc_ring_pop_batch_keeps_order_across_wrap)
+{
+    SpscRing<int> ring(4);
+    int next = 0;
+    int expected = 0;
+    for (int round = 0; round < 10; ++round)
+    {
+        while (ring.try_push(next))
+        {
+            ++next;
+        }
+        size_t popped = ring.pop_batch([&](int &value)
+                                       { SPE_CHECK_EQ(value, expected++); },
+                                       3);
+        SPE_CHECK(popped >= 1 && popped <= 3); // up to the tail it last saw
+    }
+    int value;
+    while (ring.try_pop(value))
+    {
+        SPE_CHECK_EQ(value, expected++);
+    }
+    SPE_CHECK_EQ(expected, next);
+    SPE_CHECK_EQ(ring.pop_batch([](int &) {}, 8), 0u);
+}
+
+SPE_TEST(spsc_ring_transfers_in_order_between_threads)
+{
+    constexpr int COUNT = 50000;
+    SpscRing<int> ring(64);
+    std::thread producer([&ring]
+                         {
+                             for (int i = 0; i < COUNT; ++i)
+                             {
+                                 while (!ring.try_push(i))
+                                 {
+                                     std::this_thread::yield();
+                                 }
+                             } });
+
+    int expected = 0;
+    bool ordered = true;
+    while (expected < COUNT)
+    {
+        if (ring.pop_batch([&](int &value)
+                           { ordered &= value == expected++; },
+                           16) == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    SPE_CHECK(ordered);
+    SPE_CHECK_EQ(ring.size_approx(), 0u);
+}
+
+SPE_TEST(mpsc_ring_rejects_when_full)
+{
+    MpscRing<int> ring(2);
+    SPE_CHECK(ring.try_push(1));
+    SPE_CHECK(ring.try_push(2));
+    SPE_CHECK(!ring.try_push(3));
+    int value = 0;
+    SPE_CHECK(ring.try_pop(value));
+    SPE_CHECK_EQ(value, 1);
+    SPE_CHECK(ring.try_push(3));
+    SPE_CHECK(ring.try_pop(value));
+    SPE_CHECK_EQ(value, 2);
+    SPE_CHECK(ring.try_pop(value));
+    SPE_CHECK_EQ(value, 3);
+    SPE_CHECK(!ring.try_pop(value));
+}
+
+SPE_TEST(mpsc_ring_delivers_every_producer_in_order)
+{
+    // Each producer's values arrive exactly once and in that producer's order
+    constexpr int PRODUCERS = 4;
+    constexpr int PER_PRODUCER = 10000;
+    MpscRing<int> ring(128);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p)
+    {
+        producers.emplace_back([&ring, p]
+                               {
+                                   for (int i = 0; i < PER_PRODUCER; ++i)
+                                   {
+                                       while (!ring.try_push(p * PER_PRODUCER + i))
+                                       {
+                                           std::this_thread::yield();
+                                       }
+                                   } });
+    }
+
+    std::vector<int> next(PRODUCERS, 0);
+    bool ordered = true;
+    int received = 0;
+    while (received < PRODUCERS * PER_PRODUCER)
+    {
+        size_t popped = ring.pop_batch([&](int &value)
+                                       {
+                                           int producer = value / PER_PRODUCER;
+                                           ordered &= value % PER_PRODUCER == next[producer]++; },
+                                       32);
+        if (popped == 0)
+        {
+            std::this_thread::yield();
+        }
+        received += static_cast<int>(popped);
+    }
+    for (auto &producer : producers)
+    {
+        producer.join();
+    }
+    SPE_CHECK(ordered);
+    for (int p = 0; p < PRODUCERS; ++p)
+    {
+        SPE_CHECK_EQ(next[p], PER_PRODUCER);
+    }
+}
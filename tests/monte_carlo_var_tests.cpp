@@ -0,0 +1,164 @@
+#include "test_harness.hpp"
+#include "monte_carlo_var.hpp"
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace spe;
+using exposure::MonteCarloConfig;
+using exposure::MonteCarloRiskResult;
+using exposure::MonteCarloVarEngine;
+using exposure::RiskExposure;
+using market_data::InstrumentHandle;
+
+namespace
+{
+    // A market factor plus idiosyncratic noise, as in the pre-trade benchmark
+    std::shared_ptr<stats::StreamingCorrelationMatrix> market_correlations(size_t instruments)
+    {
+        auto correlations = std::make_shared<stats::StreamingCorrelationMatrix>(instruments);
+        std::mt19937_64 random(11);
+        std::normal_distribution<double> shock(0.0, 0.01);
+        std::vector<std::pair<InstrumentHandle, double>> returns(instruments);
+        for (int day = 0; day < 250; ++day)
+        {
+            double market = shock(random);
+            for (size_t i = 0; i < instruments; ++i)
+            {
+                returns[i] = {static_cast<InstrumentHandle>(i), 0.6 * market + 0.8 * shock(random)};
+            }
+            correlations->add_observation(returns);
+        }
+        return correlations;
+    }
+
+    // Long and short positions, several per instrument
+    std::vector<RiskExposure> book(size_t instruments, size_t positions)
+    {
+        std::vector<RiskExposure> exposures;
+        for (size_t p = 0; p < positions; ++p)
+        {
+            double side = p % 3 == 0 ? -1.0 : 1.0;
+            exposures.push_back({static_cast<InstrumentHandle>(p % instruments), side * 1000.0 * (1 + p % 7)});
+        }
+        return exposures;
+    }
+
+    MonteCarloVarEngine engine_over(size_t instruments, const stats::StreamingCorrelationMatrix &correlations,
+                                    const MonteCarloConfig &config = MonteCarloConfig{})
+    {
+        std::vector<InstrumentHandle> handles(instruments);
+        std::iota(handles.begin(), handles.end(), InstrumentHandle(0));
+        std::vector<double> volatilities(instruments);
+        for (size_t i = 0; i < instruments; ++i)
+        {
+            volatilities[i] = 0.01 + 0.0005 * static_cast<double>(i % 9);
+        }
+        MonteCarloVarEngine engine(config);
+        engine.set_factors(handles, volatilities, &correlations);
+        return engine;
+    }
+}
+
+SPE_TEST(monte_carlo_losses_follow_the_philox_counters)
+{
+    // One instrument: loss of lane l in batch b is -N (exp(sigma z + drift) - 1), z from word
+    // l / 8 of counter (b, 0, l % 8), and its antithetic twin uses -z
+    const double notional = 5000.0;
+    const double sigma = 0.02;
+    MonteCarloConfig config;
+    config.paths = 4 * 64;
+    config.control_variate = false;
+    MonteCarloVarEngine engine(config);
+    engine.set_factors({0}, {sigma}, nullptr);
+    SPE_CHECK_EQ(engine.components(), 1u);
+
+    std::vector<double> losses;
+    engine.run({{0, notional}}, 0.95, &losses);
+    SPE_CHECK_EQ(losses.size(), 256u);
+
+    const size_t shocks = MonteCarloVarEngine::BATCH_SHOCKS;
+    const size_t quads = shocks / 4;
+    double worst = 0.0;
+    for (size_t path = 0; path < losses.size(); ++path)
+    {
+        size_t batch = path / (2 * shocks);
+        size_t lane = path % (2 * shocks);
+        double sign = lane >= shocks ? -1.0 : 1.0;
+        lane %= shocks;
+        auto bits = exposure::Philox4x32::generate({uint32_t(batch), 0, 0, uint32_t(lane % quads)},
+                                                   uint32_t(config.seed), uint32_t(config.seed >> 32));
+        double z = exposure::normal_quantile((bits[lane / quads] + 0.5) / 4294967296.0);
+        double expected = -notional * (std::exp(sign * sigma * z - 0.5 * sigma * sigma) - 1.0);
+        worst = std::max(worst, std::abs(losses[path] - expected));
+    }
+    SPE_CHECK(worst < 1e-6);
+}
+
+SPE_TEST(monte_carlo_parallel_matches_sequential)
+{
+    auto pool = std::make_shared<concurrency::WorkStealingPool>(2);
+    for (size_t instruments : {8u, 40u}) // the full Cholesky, then the factor model
+    {
+        auto correlations = market_correlations(instruments);
+        auto exposures = book(instruments, 3 * instruments + 1);
+
+        MonteCarloVarEngine sequential = engine_over(instruments, *correlations);
+        std::vector<double> sequential_losses;
+        MonteCarloRiskResult expected = sequential.run(exposures, 0.99, &sequential_losses);
+
+        MonteCarloVarEngine parallel = engine_over(instruments, *correlations);
+        parallel.set_execution_mode(concurrency::ExecutionMode::PARALLEL, pool);
+        std::vector<double> parallel_losses;
+        MonteCarloRiskResult actual = parallel.run(exposures, 0.99, &parallel_losses);
+
+        SPE_CHECK(expected.value_at_risk > 0.0);
+        SPE_CHECK_EQ(actual.value_at_risk, expected.value_at_risk);
+        SPE_CHECK_EQ(actual.expected_shortfall, expected.expected_shortfall);
+        SPE_CHECK_EQ(actual.control_beta, expected.control_beta);
+        SPE_CHECK(actual.var_contributions == expected.var_contributions);
+        SPE_CHECK(actual.es_contributions == expected.es_contributions);
+        SPE_CHECK(parallel_losses == sequential_losses);
+    }
+}
+
+SPE_TEST(monte_carlo_contributions_sum_to_var_and_es)
+{
+    for (size_t instruments : {8u, 40u})
+    {
+        auto correlations = market_correlations(instruments);
+        auto exposures = book(instruments, 3 * instruments + 1);
+        exposures.push_back({static_cast<InstrumentHandle>(instruments + 5), 1e6}); // no factor
+        MonteCarloVarEngine engine = engine_over(instruments, *correlations);
+        MonteCarloRiskResult result = engine.run(exposures, 0.99);
+
+        double var_total = std::accumulate(result.var_contributions.begin(), result.var_contributions.end(), 0.0);
+        double es_total = std::accumulate(result.es_contributions.begin(), result.es_contributions.end(), 0.0);
+        SPE_CHECK_EQ(result.var_contributions.size(), exposures.size());
+        SPE_CHECK_NEAR(var_total, result.value_at_risk, 1e-9 * result.value_at_risk);
+        SPE_CHECK_NEAR(es_total, result.expected_shortfall, 1e-9 * result.expected_shortfall);
+        SPE_CHECK(result.expected_shortfall >= result.value_at_risk);
+        SPE_CHECK_EQ(result.var_contributions.back(), 0.0);
+    }
+}
+
+SPE_TEST(monte_carlo_factor_model_tracks_the_full_cholesky)
+{
+    const size_t instruments = 60;
+    auto correlations = market_correlations(instruments);
+    auto exposures = book(instruments, 300);
+
+    MonteCarloConfig full_config;
+    full_config.max_components = instruments;
+    MonteCarloVarEngine full = engine_over(instruments, *correlations, full_config);
+    MonteCarloVarEngine reduced = engine_over(instruments, *correlations);
+    SPE_CHECK_EQ(full.components(), instruments);
+    SPE_CHECK_EQ(reduced.components(), MonteCarloConfig{}.max_components);
+
+    MonteCarloRiskResult exact = full.run(exposures, 0.99);
+    MonteCarloRiskResult approximate = reduced.run(exposures, 0.99);
+    SPE_CHECK_NEAR(approximate.value_at_risk, exact.value_at_risk, 0.02 * exact.value_at_risk);
+    SPE_CHECK_NEAR(approximate.expected_shortfall, exact.expected_shortfall, 0.02 * exact.expected_shortfall);
+}
@@ -0,0 +1,68 @@
+#include "test_harness.hpp"
+#include "object_pool.hpp"
+#include <set>
+#include <string>
+
+using namespace spe::memory;
+
+SPE_TEST(object_pool_released_handle_goes_stale)
+{
+    ObjectPool<int, 4> pool;
+    PoolHandle first = pool.acquire();
+    *pool.get(first) = 7;
+    SPE_CHECK_EQ(*pool.get(first), 7);
+
+    pool.release(first);
+    SPE_CHECK(pool.get(first) == nullptr);
+    SPE_CHECK(pool.empty());
+
+    PoolHandle reused = pool.acquire();
+    SPE_CHECK_EQ(reused.index, first.index); // the free slot is handed out again
+    SPE_CHECK(reused != first);
+    SPE_CHECK(pool.get(first) == nullptr);
+    SPE_CHECK_EQ(*pool.get(reused), 7); // contents are kept for the caller to overwrite
+
+    pool.release(first); // stale release is a no-op
+    SPE_CHECK_EQ(pool.size(), 1u);
+}
+
+SPE_TEST(object_pool_grows_without_moving_objects)
+{
+    ObjectPool<std::string, 4> pool;
+    PoolHandle first = pool.acquire();
+    *pool.get(first) = "first";
+    const std::string *address = pool.get(first);
+
+    for (int i = 0; i < 20; ++i)
+    {
+        pool.acquire();
+    }
+    SPE_CHECK_EQ(pool.size(), 21u);
+    SPE_CHECK_EQ(pool.capacity(), 24u);
+    SPE_CHECK(pool.get(first) == address);
+    SPE_CHECK_EQ(*address, std::string("first"));
+}
+
+SPE_TEST(object_pool_release_if_keeps_live_list_dense)
+{
+    ObjectPool<int, 8> pool;
+    for (int i = 0; i < 10; ++i)
+    {
+        *pool.get(pool.acquire()) = i;
+    }
+
+    SPE_CHECK_EQ(pool.release_if([](const int &value) { return value % 2 == 0; }), 5u);
+    SPE_CHECK_EQ(pool.size(), 5u);
+
+    std::set<int> seen;
+    pool.for_each([&](PoolHandle handle, int &value)
+                  {
+                      SPE_CHECK(pool.get(handle) == &value);
+                      seen.insert(value);
+                  });
+    SPE_CHECK(seen == (std::set<int>{1, 3, 5, 7, 9}));
+
+    pool.clear();
+    SPE_CHECK(pool.empty());
+    SPE_CHECK_EQ(pool.capacity(), 16u);
+}
@@ -0,0 +1,125 @@
+#include "test_harness.hpp"
+#include "option_batch_pricing.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace spe::pricing;
+
+namespace
+{
+    const double SPOT = 100.0;
+    const double RATE = 0.03;
+
+    // Strikes from deep in to deep out of the money, expiries down to under an hour; 3 x 7 x 2
+    // entries is odd, so every vector kernel also runs its tail
+    OptionChain test_chain()
+    {
+        OptionChain chain;
+        const double strikes[] = {20.0, 60.0, 95.0, 100.0, 105.0, 160.0, 400.0};
+        const double expiries[] = {1e-4, 0.02, 2.0};
+        const double volatilities[] = {0.05, 0.6, 1.5};
+        for (size_t e = 0; e < 3; ++e)
+        {
+            for (size_t k = 0; k < 7; ++k)
+            {
+                double volatility = volatilities[(e + k) % 3];
+                chain.add(strikes[k], expiries[e], volatility, true);
+                chain.add(strikes[k], expiries[e], volatility, false);
+            }
+        }
+        return chain;
+    }
+
+    double normal_cdf(double x) { return 0.5 * std::erfc(-x / std::sqrt(2.0)); }
+
+    // Closed-form Black-Scholes, for the scalar kernel
+    void black_scholes(double strike, double expiry, double volatility, double sign, double out[6])
+    {
+        double root = std::sqrt(expiry);
+        double d1 = (std::log(SPOT / strike) + (RATE + 0.5 * volatility * volatility) * expiry) / (volatility * root);
+        double d2 = d1 - volatility * root;
+        double discount = std::exp(-RATE * expiry);
+        double density = std::exp(-0.5 * d1 * d1) / std::sqrt(2.0 * M_PI);
+        out[0] = sign * (SPOT * normal_cdf(sign * d1) - strike * discount * normal_cdf(sign * d2));
+        out[1] = sign * normal_cdf(sign * d1);
+        out[2] = density / (SPOT * volatility * root);
+        out[3] = -SPOT * density * volatility / (2.0 * root) - sign * RATE * strike * discount * normal_cdf(sign * d2);
+        out[4] = SPOT * density * root;
+        out[5] = sign * strike * expiry * discount * normal_cdf(sign * d2);
+    }
+
+    const std::vector<double> &output(const OptionChainGreeks &greeks, int which)
+    {
+        switch (which)
+        {
+        case 0:
+            return greeks.prices;
+        case 1:
+            return greeks.deltas;
+        case 2:
+            return greeks.gammas;
+        case 3:
+            return greeks.thetas;
+        case 4:
+            return greeks.vegas;
+        default:
+            return greeks.rhos;
+        }
+    }
+
+    // Error relative to the value's scale, with a floor so deep out-of-the-money zeros compare
+    double scaled_error(double value, double reference, double floor)
+    {
+        return std::abs(value - reference) / std::max(std::abs(reference), floor);
+    }
+}
+
+SPE_TEST(option_chain_scalar_kernel_matches_black_scholes)
+{
+    OptionChain chain = test_chain();
+    OptionChainGreeks greeks;
+    price_option_chain(SPOT, RATE, chain, greeks, SimdLevel::SCALAR);
+    SPE_CHECK_EQ(greeks.size(), chain.size());
+
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        double expected[6];
+        black_scholes(chain.strikes[i], chain.expiries[i], chain.volatilities[i], chain.option_signs[i], expected);
+        for (int k = 0; k < 6; ++k)
+        {
+            SPE_CHECK(scaled_error(output(greeks, k)[i], expected[k], 1e-6) < 1e-7);
+        }
+    }
+
+    // Put-call parity on each strike and expiry
+    for (size_t i = 0; i + 1 < chain.size(); i += 2)
+    {
+        double forward_gap = SPOT - chain.strikes[i] * std::exp(-RATE * chain.expiries[i]);
+        SPE_CHECK_NEAR(greeks.prices[i] - greeks.prices[i + 1], forward_gap, 1e-7 * SPOT);
+    }
+}
+
+SPE_TEST(option_chain_vector_kernels_match_scalar)
+{
+    OptionChain chain = test_chain();
+    OptionChainGreeks reference;
+    price_option_chain(SPOT, RATE, chain, reference, SimdLevel::SCALAR);
+
+    for (SimdLevel level : {SimdLevel::AVX2, SimdLevel::AVX512})
+    {
+        if (level > active_simd_level())
+        {
+            continue; // not on this CPU
+        }
+        OptionChainGreeks greeks;
+        price_option_chain(SPOT, RATE, chain, greeks, level);
+        SPE_CHECK_EQ(greeks.size(), chain.size());
+        for (size_t i = 0; i < chain.size(); ++i)
+        {
+            for (int k = 0; k < 6; ++k)
+            {
+                SPE_CHECK(scaled_error(output(greeks, k)[i], output(reference, k)[i], 1e-8) < 1e-11);
+            }
+        }
+    }
+}
@@ -0,0 +1,177 @@
+#include "test_harness.hpp"
+#include "exchange_message_parser.hpp"
+#include "instrument_registry.hpp"
+#include "order_book.hpp"
+#include <string>
+
+using namespace spe::market_data;
+using namespace spe::exchange_ws;
+
+namespace
+{
+    BookSequence snapshot(uint64_t id)
+    {
+        BookSequence sequence;
+        sequence.is_snapshot = true;
+        sequence.last_update_id = id;
+        return sequence;
+    }
+
+    BookSequence delta(uint64_t first, uint64_t last, uint64_t previous = 0)
+    {
+        BookSequence sequence;
+        sequence.first_update_id = first;
+        sequence.last_update_id = last;
+        sequence.previous_update_id = previous;
+        return sequence;
+    }
+
+    // An empty delta through begin/commit, as the feed thread applies one
+    BookUpdateResult apply(OrderBook &book, const BookSequence &sequence)
+    {
+        BookUpdateResult result = book.begin_update(sequence);
+        if (result != BookUpdateResult::APPLIED)
+        {
+            return result;
+        }
+        return book.commit_update(sequence);
+    }
+
+    BookUpdateResult apply_okx(OrderBook &book, const std::string &frame)
+    {
+        WireMessage message;
+        if (!parse_okx_message(frame, message))
+        {
+            return BookUpdateResult::AWAITING_SNAPSHOT;
+        }
+        return apply_to_order_book(message, book);
+    }
+
+    // Checksum computed over the wire strings ("8477.00", "0.10"), not their values
+    const std::string OKX_SNAPSHOT =
+        R"({"arg":{"channel":"books","instId":"BTC-USDT"},"action":"snapshot","data":[{)"
+        R"("asks":[["8477.00","7","0","1"],["8477.5","2","0","1"]],)"
+        R"("bids":[["8476.98","415","0","13"],["8476.5","0.10","0","1"]],)"
+        R"("ts":"1","checksum":335143070,"prevSeqId":-1,"seqId":100}]})";
+
+    std::string okx_update(uint64_t previous, uint64_t sequence, int64_t checksum)
+    {
+        return R"({"arg":{"channel":"books","instId":"BTC-USDT"},"action":"update","data":[{)"
+               R"("asks":[],"bids":[["8476.5","0.2","0","1"]],"ts":"2","checksum":)" +
+               std::to_string(checksum) + R"(,"prevSeqId":)" + std::to_string(previous) +
+               R"(,"seqId":)" + std::to_string(sequence) + "}]}";
+    }
+}
+
+SPE_TEST(okx_snapshot_and_update_checksum_over_wire_text)
+{
+    OrderBook book(intern_instrument("BTC-USDT"), BookSequencing::OKX);
+    SPE_CHECK(apply_okx(book, OKX_SNAPSHOT) == BookUpdateResult::APPLIED);
+    SPE_CHECK(book.is_synced());
+    SPE_CHECK_EQ(book.last_update_id(), 100u);
+    SPE_CHECK_EQ(book.bid_levels(), 2u);
+    SPE_CHECK_EQ(book.ask_levels(), 2u);
+
+    SPE_CHECK(apply_okx(book, okx_update(100, 101, 1396397647)) == BookUpdateResult::APPLIED);
+    SPE_CHECK_EQ(book.last_update_id(), 101u);
+
+    MarketDepth depth;
+    book.top(depth);
+    SPE_CHECK_EQ(depth.bid_count, 2u);
+    SPE_CHECK_NEAR(depth.bids[0].price, 8476.98, 1e-9);
+    SPE_CHECK_NEAR(depth.bids[1].size, 0.2, 1e-9);
+    SPE_CHECK_NEAR(depth.asks[0].price, 8477.0, 1e-9);
+    SPE_CHECK_EQ(depth.update_id, 101u);
+}
+
+SPE_TEST(okx_checksum_mismatch_keeps_last_good_sequence)
+{
+    OrderBook book(intern_instrument("BTC-USDT"), BookSequencing::OKX);
+    SPE_CHECK(apply_okx(book, OKX_SNAPSHOT) == BookUpdateResult::APPLIED);
+
+    SPE_CHECK(apply_okx(book, okx_update(100, 101, 1)) == BookUpdateResult::CHECKSUM_MISMATCH);
+    SPE_CHECK(!book.is_synced());
+    SPE_CHECK_EQ(book.last_update_id(), 100u);
+    SPE_CHECK_EQ(book.statistics().checksum_failures, 1u);
+
+    MarketDepth depth;
+    book.top(depth);
+    SPE_CHECK_EQ(depth.update_id, 100u); // the last good view stays published
+    SPE_CHECK_NEAR(depth.bids[1].size, 0.1, 1e-9);
+
+    SPE_CHECK(apply_okx(book, okx_update(101, 102, 1)) == BookUpdateResult::AWAITING_SNAPSHOT);
+    SPE_CHECK(apply_okx(book, OKX_SNAPSHOT) == BookUpdateResult::APPLIED);
+    SPE_CHECK(book.is_synced());
+}
+
+SPE_TEST(okx_sequence_gap_and_stale)
+{
+    OrderBook book(intern_instrument("BTC-USDT"), BookSequencing::OKX);
+    SPE_CHECK(apply(book, snapshot(100)) == BookUpdateResult::APPLIED);
+    SPE_CHECK(apply(book, delta(0, 101, 100)) == BookUpdateResult::APPLIED);
+    SPE_CHECK(apply(book, delta(0, 101, 100)) == BookUpdateResult::STALE);
+    SPE_CHECK(book.is_synced());
+
+    SPE_CHECK(apply(book, delta(0, 110, 105)) == BookUpdateResult::GAP);
+    SPE_CHECK(!book.is_synced());
+    SPE_CHECK_EQ(book.last_update_id(), 101u);
+    SPE_CHECK_EQ(book.statistics().gaps, 1u);
+}
+
+SPE_TEST(book_levels_sorted_and_removed_by_zero_size)
+{
+    OrderBook book(intern_instrument("BTC-USDT"));
+    SPE_CHECK(book.begin_update(snapshot(1)) == BookUpdateResult::APPLIED);
+    book.set_level(Side::BID, 99.0, 1.0);
+    book.set_level(Side::BID, 100.0, 2.0);
+    book.set_level(Side::ASK, 102.0, 3.0);
+    book.set_level(Side::ASK, 101.0, 4.0);
+    SPE_CHECK(book.commit_update(snapshot(1)) == BookUpdateResult::APPLIED);
+
+    MarketDepth depth;
+    book.top(depth);
+    SPE_CHECK_EQ(depth.bid_count, 2u);
+    SPE_CHECK_NEAR(depth.bids[0].price, 100.0, 1e-9);
+    SPE_CHECK_NEAR(depth.asks[0].price, 101.0, 1e-9);
+
+    SPE_CHECK(book.begin_update(delta(2, 2)) == BookUpdateResult::APPLIED);
+    book.set_level(Side::BID, 100.0, 0.0);
+    SPE_CHECK(book.commit_update(delta(2, 2)) == BookUpdateResult::APPLIED);
+    book.top(depth);
+    SPE_CHECK_EQ(depth.bid_count, 1u);
+    SPE_CHECK_NEAR(depth.bids[0].price, 99.0, 1e-9);
+}
+
+SPE_TEST(binance_spot_first_update_brackets_snapshot)
+{
+    OrderBook book(intern_instrument("BTCUSDT"), BookSequencing::BINANCE_SPOT);
+    SPE_CHECK(apply(book, delta(1, 5)) == BookUpdateResult::AWAITING_SNAPSHOT);
+    SPE_CHECK(apply(book, snapshot(100)) == BookUpdateResult::APPLIED);
+
+    SPE_CHECK(apply(book, delta(90, 100)) == BookUpdateResult::STALE); // buffered before the snapshot
+    SPE_CHECK(apply(book, delta(95, 105)) == BookUpdateResult::APPLIED);
+    SPE_CHECK(apply(book, delta(106, 110)) == BookUpdateResult::APPLIED);
+    SPE_CHECK_EQ(book.last_update_id(), 110u);
+
+    SPE_CHECK(apply(book, delta(112, 115)) == BookUpdateResult::GAP);
+    SPE_CHECK(!book.is_synced());
+    SPE_CHECK_EQ(book.last_update_id(), 110u);
+}
+
+SPE_TEST(binance_spot_first_update_past_snapshot_is_a_gap)
+{
+    OrderBook book(intern_instrument("BTCUSDT"), BookSequencing::BINANCE_SPOT);
+    SPE_CHECK(apply(book, snapshot(100)) == BookUpdateResult::APPLIED);
+    SPE_CHECK(apply(book, delta(102, 110)) == BookUpdateResult::GAP);
+}
+
+SPE_TEST(binance_futures_chains_on_previous_update_id)
+{
+    OrderBook book(intern_instrument("BTCUSDT"), BookSequencing::BINANCE_FUTURES);
+    SPE_CHECK(apply(book, snapshot(100)) == BookUpdateResult::APPLIED);
+    SPE_CHECK(apply(book, delta(98, 104, 97)) == BookUpdateResult::APPLIED);
+    // Futures ids are not contiguous: pu links to the last u, U may skip ahead
+    SPE_CHECK(apply(book, delta(107, 108, 104)) == BookUpdateResult::APPLIED);
+    SPE_CHECK(apply(book, delta(112, 115, 110)) == BookUpdateResult::GAP);
+    SPE_CHECK_EQ(book.last_update_id(), 108u);
+}
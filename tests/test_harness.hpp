@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace spe
+{
+    namespace test
+    {
+
+        using TestFunction = void (*)();
+
+        struct TestDefinition
+        {
+            std::string name;
+            TestFunction function;
+        };
+
+        // Static registrations, in definition order
+        std::vector<TestDefinition> &test_registry();
+
+        struct TestRegistration
+        {
+            TestRegistration(const char *name, TestFunction function)
+            {
+                test_registry().push_back(TestDefinition{name, function});
+            }
+        };
+
+        // Marks the running test failed and prints where; the test carries on
+        void report_failure(const char *file, int line, const std::string &message);
+
+    } // namespace test
+} // namespace spe
+
+// SPE_TEST(name) { body } at namespace scope
+#define SPE_TEST(name)                                                                 \
+    static void name();                                                                \
+    static ::spe::test::TestRegistration name##_registration_(#name, name);            \
+    static void name()
+
+#define SPE_CHECK(condition)                                                           \
+    do                                                                                 \
+    {                                                                                  \
+        if (!(condition))                                                              \
+        {                                                                              \
+            ::spe::test::report_failure(__FILE__, __LINE__, "SPE_CHECK(" #condition ")"); \
+        }                                                                              \
+    } while (0)
+
+#define SPE_CHECK_EQ(actual, expected)                                                          \
+    do                                                                                          \
+    {                                                                                           \
+        if (!((actual) == (expected)))                                                          \
+        {                                                                                       \
+            ::spe::test::report_failure(__FILE__, __LINE__, "SPE_CHECK_EQ(" #actual ", " #expected ")"); \
+        }                                                                                       \
+    } while (0)
+
+#define SPE_CHECK_NEAR(actual, expected, tolerance)                                                     \
+    do                                                                                                  \
+    {                                                                                                   \
+        if (!(std::fabs(double(actual) - double(expected)) <= double(tolerance)))                     \
+        {                                                                                               \
+            ::spe::test::report_failure(__FILE__, __LINE__,                                             \
+                                        "SPE_CHECK_NEAR(" #actual ", " #expected ", " #tolerance ") got " + \
+                                            std::to_string(double(actual)));                            \
+        }                                                                                               \
+    } while (0)
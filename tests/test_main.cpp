@@ -0,0 +1,55 @@
+#include "test_harness.hpp"
+#include <cstdio>
+
+namespace spe
+{
+    namespace test
+    {
+
+        namespace
+        {
+            bool current_failed = false;
+        }
+
+        std::vector<TestDefinition> &test_registry()
+        {
+            static std::vector<TestDefinition> registry;
+            return registry;
+        }
+
+        void report_failure(const char *file, int line, const std::string &message)
+        {
+            current_failed = true;
+            std::printf("  %s:%d: %s\n", file, line, message.c_str());
+        }
+
+    } // namespace test
+} // namespace spe
+
+// Runs every registered test, or those whose name contains the first argument; exits non-zero
+// if any check failed
+int main(int argc, char **argv)
+{
+    using namespace spe::test;
+    const char *filter = argc > 1 ? argv[1] : "";
+
+    size_t run = 0;
+    size_t failed = 0;
+    for (const auto &definition : test_registry())
+    {
+        if (definition.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        current_failed = false;
+        definition.function();
+        ++run;
+        if (current_failed)
+        {
+            ++failed;
+        }
+        std::printf("%-6s %s\n", current_failed ? "FAIL" : "ok", definition.name.c_str());
+    }
+    std::printf("%zu tests, %zu failed\n", run, failed);
+    return failed == 0 ? 0 : 1;
+}
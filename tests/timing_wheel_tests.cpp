@@ -0,0 +1,134 @@
+#include "test_harness.hpp"
+#include "timing_wheel.hpp"
+#include <random>
+#include <vector>
+
+using namespace spe::timing;
+
+namespace
+{
+    // Timers carry their own deadline; every fire is checked against the wheel's tick
+    struct FireLog
+    {
+        TimingWheel<uint64_t> &wheel;
+        size_t fired = 0;
+        size_t early_or_late = 0;
+        uint64_t last = 0;
+        size_t out_of_order = 0;
+
+        void operator()(uint64_t deadline)
+        {
+            ++fired;
+            if (deadline != wheel.now())
+            {
+                ++early_or_late;
+            }
+            if (deadline < last)
+            {
+                ++out_of_order;
+            }
+            last = deadline;
+        }
+    };
+}
+
+SPE_TEST(timing_wheel_fires_on_deadline_at_every_level)
+{
+    TimingWheel<uint64_t> wheel;
+    // Slot edges of levels 0-3 and one deadline past the top level (64^4 ticks)
+    const std::vector<uint64_t> deadlines = {1, 63, 64, 65, 4095, 4096, 4097, 262143, 262144,
+                                             300000, 16777215, 16777216, 20000000};
+    for (uint64_t deadline : deadlines)
+    {
+        wheel.schedule(deadline, deadline);
+    }
+    SPE_CHECK_EQ(wheel.size(), deadlines.size());
+
+    FireLog log{wheel};
+    SPE_CHECK_EQ(wheel.advance(64, log), 3u);
+    SPE_CHECK_EQ(wheel.advance(20000000, log), deadlines.size() - 3);
+    SPE_CHECK_EQ(log.early_or_late, 0u);
+    SPE_CHECK_EQ(log.out_of_order, 0u);
+    SPE_CHECK_EQ(wheel.size(), 0u);
+    SPE_CHECK_EQ(wheel.now(), 20000000u);
+}
+
+SPE_TEST(timing_wheel_cancelled_timer_does_not_fire)
+{
+    TimingWheel<uint64_t> wheel(1000);
+    TimerId near = wheel.schedule(1010, 1010);
+    TimerId far = wheel.schedule(900000, 900000);
+    wheel.schedule(1020, 1020);
+
+    SPE_CHECK(wheel.cancel(near));
+    SPE_CHECK(!wheel.cancel(near));
+    SPE_CHECK(wheel.cancel(far));
+    SPE_CHECK(!wheel.cancel(INVALID_TIMER));
+
+    FireLog log{wheel};
+    SPE_CHECK_EQ(wheel.advance(1000000, log), 1u);
+    SPE_CHECK_EQ(log.last, 1020u);
+    SPE_CHECK_EQ(log.early_or_late, 0u);
+
+    TimerId fired = wheel.schedule(1000001, 0);
+    wheel.advance(1000001, log);
+    SPE_CHECK(!wheel.cancel(fired)); // already fired
+}
+
+SPE_TEST(timing_wheel_due_timers_fire_on_next_advance)
+{
+    TimingWheel<int> wheel(500);
+    wheel.schedule(100, 1);
+    wheel.schedule(500, 2);
+
+    int sum = 0;
+    SPE_CHECK_EQ(wheel.advance(500, [&](int value) { sum += value; }), 2u);
+    SPE_CHECK_EQ(sum, 3);
+
+    // A callback may reschedule, including for the tick being fired
+    size_t fired = wheel.advance(501, [](int) {});
+    SPE_CHECK_EQ(fired, 0u);
+    wheel.schedule(600, 10);
+    sum = 0;
+    fired = wheel.advance(700, [&](int value)
+                          {
+                              sum += value;
+                              if (value == 10)
+                              {
+                                  wheel.schedule(wheel.now(), 5);
+                                  wheel.schedule(wheel.now() + 50, 1);
+                              }
+                          });
+    SPE_CHECK_EQ(fired, 3u);
+    SPE_CHECK_EQ(sum, 16);
+}
+
+SPE_TEST(timing_wheel_matches_sorted_deadlines_under_random_steps)
+{
+    std::mt19937_64 random(7);
+    TimingWheel<uint64_t> wheel(12345);
+    FireLog log{wheel};
+    log.last = wheel.now();
+
+    std::vector<TimerId> ids;
+    size_t cancelled = 0;
+    for (int i = 0; i < 3000; ++i)
+    {
+        uint64_t span = uint64_t(1) << (random() % 22);
+        uint64_t deadline = wheel.now() + 1 + random() % span;
+        ids.push_back(wheel.schedule(deadline, deadline));
+    }
+    for (size_t i = 0; i < ids.size(); i += 7)
+    {
+        cancelled += wheel.cancel(ids[i]) ? 1 : 0;
+    }
+
+    size_t fired = 0;
+    while (wheel.size() != 0)
+    {
+        fired += wheel.advance(wheel.now() + 1 + random() % 5000, log);
+    }
+    SPE_CHECK_EQ(fired + cancelled, ids.size());
+    SPE_CHECK_EQ(log.early_or_late, 0u);
+    SPE_CHECK_EQ(log.out_of_order, 0u);
+}